@@ -196,6 +196,14 @@ void DebugAgent::OnReadMemory(const debug_ipc::ReadMemoryRequest& request,
     proc->OnReadMemory(request, reply);
 }
 
+void DebugAgent::OnReadMemoryRanges(
+    const debug_ipc::ReadMemoryRangesRequest& request,
+    debug_ipc::ReadMemoryRangesReply* reply) {
+  DebuggedProcess* proc = GetDebuggedProcess(request.process_koid);
+  if (proc)
+    proc->OnReadMemoryRanges(request, reply);
+}
+
 void DebugAgent::OnRegisters(const debug_ipc::RegistersRequest& request,
                              debug_ipc::RegistersReply* reply) {
   DebuggedThread* thread =
@@ -236,6 +244,13 @@ void DebugAgent::OnBacktrace(const debug_ipc::BacktraceRequest& request,
     thread->GetBacktrace(&reply->frames);
 }
 
+void DebugAgent::OnBacktraces(const debug_ipc::BacktracesRequest& request,
+                              debug_ipc::BacktracesReply* reply) {
+  DebuggedProcess* proc = GetDebuggedProcess(request.process_koid);
+  if (proc)
+    proc->OnBacktraces(request, reply);
+}
+
 zx_status_t DebugAgent::RegisterBreakpoint(Breakpoint* bp,
                                            zx_koid_t process_koid,
                                            uint64_t address) {
@@ -69,6 +69,10 @@ class DebugAgent : public RemoteAPI, public Breakpoint::ProcessDelegate {
                    debug_ipc::BacktraceReply* reply) override;
   void OnAddressSpace(const debug_ipc::AddressSpaceRequest& request,
                       debug_ipc::AddressSpaceReply* reply) override;
+  void OnReadMemoryRanges(const debug_ipc::ReadMemoryRangesRequest& request,
+                          debug_ipc::ReadMemoryRangesReply* reply) override;
+  void OnBacktraces(const debug_ipc::BacktracesRequest& request,
+                    debug_ipc::BacktracesReply* reply) override;
 
   // Breakpoint::ProcessDelegate implementation.
   zx_status_t RegisterBreakpoint(Breakpoint* bp, zx_koid_t process_koid,
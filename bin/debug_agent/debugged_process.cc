@@ -72,6 +72,39 @@ void DebuggedProcess::OnReadMemory(const debug_ipc::ReadMemoryRequest& request,
                           &reply->blocks);
 }
 
+void DebuggedProcess::OnReadMemoryRanges(
+    const debug_ipc::ReadMemoryRangesRequest& request,
+    debug_ipc::ReadMemoryRangesReply* reply) {
+  std::vector<debug_ipc::MemoryBlock> range_blocks;
+  for (const debug_ipc::MemoryRange& range : request.ranges) {
+    ReadProcessMemoryBlocks(process_, range.address, range.size,
+                            &range_blocks);
+    for (debug_ipc::MemoryBlock& block : range_blocks)
+      reply->blocks.push_back(std::move(block));
+  }
+}
+
+void DebuggedProcess::OnBacktraces(const debug_ipc::BacktracesRequest& request,
+                                   debug_ipc::BacktracesReply* reply) {
+  if (request.thread_koids.empty()) {
+    // Empty thread ID list means all threads.
+    for (const auto& pair : threads_) {
+      reply->backtraces.emplace_back();
+      reply->backtraces.back().thread_koid = pair.first;
+      pair.second->GetBacktrace(&reply->backtraces.back().frames);
+    }
+  } else {
+    for (uint64_t thread_koid : request.thread_koids) {
+      DebuggedThread* thread = GetThread(thread_koid);
+      if (!thread)
+        continue;  // Could have exited since the client sent the request.
+      reply->backtraces.emplace_back();
+      reply->backtraces.back().thread_koid = thread_koid;
+      thread->GetBacktrace(&reply->backtraces.back().frames);
+    }
+  }
+}
+
 void DebuggedProcess::OnKill(const debug_ipc::KillRequest& request,
                              debug_ipc::KillReply* reply) {
   reply->status = process_.kill();
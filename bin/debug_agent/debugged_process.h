@@ -47,6 +47,10 @@ class DebuggedProcess : public debug_ipc::ZirconExceptionWatcher,
   void OnResume(const debug_ipc::ResumeRequest& request);
   void OnReadMemory(const debug_ipc::ReadMemoryRequest& request,
                     debug_ipc::ReadMemoryReply* reply);
+  void OnReadMemoryRanges(const debug_ipc::ReadMemoryRangesRequest& request,
+                          debug_ipc::ReadMemoryRangesReply* reply);
+  void OnBacktraces(const debug_ipc::BacktracesRequest& request,
+                    debug_ipc::BacktracesReply* reply);
   void OnKill(const debug_ipc::KillRequest& request,
               debug_ipc::KillReply* reply);
   void OnAddressSpace(const debug_ipc::AddressSpaceRequest& request,
@@ -66,6 +66,13 @@ class RemoteAPI {
 
   virtual void OnAddressSpace(const debug_ipc::AddressSpaceRequest& request,
                               debug_ipc::AddressSpaceReply* reply) = 0;
+
+  virtual void OnReadMemoryRanges(
+      const debug_ipc::ReadMemoryRangesRequest& request,
+      debug_ipc::ReadMemoryRangesReply* reply) = 0;
+
+  virtual void OnBacktraces(const debug_ipc::BacktracesRequest& request,
+                            debug_ipc::BacktracesReply* reply) = 0;
 };
 
 }  // namespace debug_agent
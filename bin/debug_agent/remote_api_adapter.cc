@@ -95,6 +95,8 @@ void RemoteAPIAdapter::OnStreamReadable() {
       DISPATCH(RemoveBreakpoint);
       DISPATCH(Backtrace);
       DISPATCH(AddressSpace);
+      DISPATCH(ReadMemoryRanges);
+      DISPATCH(Backtraces);
 
       // Attach is special (see remote_api.h): forward the raw data instead of
       // a deserizlied version.
@@ -81,6 +81,12 @@ void AudioCoreImpl::PublishServices() {
   outgoing_.public_dir()->AddEntry(fuchsia::media::AudioDeviceEnumerator::Name_,
                                    std::move(audio_device_enumerator_service));
 
+  // Let tools such as iquery read each output's mix timing and underflows.
+  outgoing_.object_dir()->set_children_callback(
+      {"outputs"}, [this](component::Object::ObjectVector* out) {
+        device_manager_.CreateOutputStatsObjects(out);
+      });
+
   outgoing_.ServeFromStartupInfo();
 }
 
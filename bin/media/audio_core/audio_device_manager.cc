@@ -320,6 +320,27 @@ void AudioDeviceManager::GetDevices(GetDevicesCallback cbk) {
   cbk(fidl::VectorPtr<::fuchsia::media::AudioDeviceInfo>(std::move(ret)));
 }
 
+void AudioDeviceManager::CreateOutputStatsObjects(
+    component::Object::ObjectVector* out) {
+  for (auto& dev : devices_) {
+    if (!dev.is_output() || (dev.token() == ZX_KOID_INVALID)) {
+      continue;
+    }
+
+    auto output = static_cast<AudioOutput*>(&dev);
+    auto stats = output->CreateStatsObject(
+        fbl::String(("output-" + std::to_string(dev.token())).c_str()));
+    if (stats == nullptr) {
+      continue;
+    }
+
+    ::fuchsia::media::AudioDeviceInfo info;
+    dev.GetDeviceInfo(&info);
+    stats->SetProperty("name", component::Property(info.name.get()));
+    out->push_back(std::move(stats));
+  }
+}
+
 void AudioDeviceManager::GetDeviceGain(uint64_t device_token,
                                        GetDeviceGainCallback cbk) {
   auto dev = devices_.find(device_token);
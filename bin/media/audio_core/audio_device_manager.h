@@ -114,6 +114,11 @@ class AudioDeviceManager : public ::fuchsia::media::AudioDeviceEnumerator {
     return false;
   }
 
+  // Add an inspect object to |out| for each active output, reporting its mix
+  // statistics. Called on the main message loop's thread, when our inspect
+  // hierarchy is read.
+  void CreateOutputStatsObjects(component::Object::ObjectVector* out);
+
   // SetSystemGain/Mute has been called. 'changed' tells us whether System Gain
   // or Mute values actually changed. If not, only update devices that (because
   // of calls to SetDeviceGain) have diverged from System settings.
@@ -13,6 +13,7 @@
 #include "garnet/bin/media/audio_core/audio_device.h"
 #include "garnet/bin/media/audio_core/audio_driver.h"
 #include "garnet/bin/media/audio_core/fwd_decls.h"
+#include "lib/component/cpp/expose.h"
 #include "lib/fxl/synchronization/thread_annotations.h"
 
 namespace media {
@@ -25,6 +26,12 @@ class AudioOutput : public AudioDevice {
   // Minimum clock lead time (in nanoseconds) for this output
   int64_t min_clock_lead_time_nsec() const { return min_clock_lead_time_nsec_; }
 
+  // Returns an inspect object, named |name|, that reports this output's mix
+  // statistics as they stand now, or nullptr if this output keeps none.
+  virtual fbl::RefPtr<component::Object> CreateStatsObject(fbl::String name) {
+    return nullptr;
+  }
+
  protected:
   explicit AudioOutput(AudioDeviceManager* manager);
 
@@ -9,6 +9,7 @@
 #include <fbl/atomic.h>
 #include <fbl/limits.h>
 #include <lib/fit/defer.h>
+#include <trace/event.h>
 #include <zircon/process.h>
 #include <iomanip>
 
@@ -135,6 +136,10 @@ bool DriverOutput::StartMixJob(MixJob* job, fxl::TimePoint process_start) {
     int64_t rd_ptr_frames = cm2rd_pos.Apply(now);
     int64_t fifo_threshold = rd_ptr_frames + fifo_frames;
 
+    // Note how far ahead of the hardware's read position we start this cycle.
+    stats_.lead_time.Record(cm2frames.Inverse().Scale(
+        fbl::max<int64_t>(frames_sent_ - rd_ptr_frames, 0)));
+
     if (fifo_threshold >= frames_sent_) {
       if (!underflow_start_time_) {
         // If this was the first time we missed our limit, log a message, mark
@@ -152,7 +157,10 @@ bool DriverOutput::StartMixJob(MixJob* job, fxl::TimePoint process_start) {
             << cm2frames.Inverse().Scale(low_water_limit_miss) / 1000000.0
             << ") mSec.  Cooling down for at least "
             << kUnderflowCooldown / 1000000.0 << " mSec.";
+        TRACE_INSTANT("audio", "DriverOutput::Underflow", TRACE_SCOPE_PROCESS,
+                      "fifo_miss", cm2frames.Inverse().Scale(fifo_limit_miss));
 
+        ++stats_.underflows;
         underflow_start_time_ = now;
         output_producer_->FillWithSilence(rb.virt(), rb.frames());
         zx_cache_flush(rb.virt(), rb.size(), ZX_CACHE_FLUSH_DATA);
@@ -183,6 +191,11 @@ bool DriverOutput::StartMixJob(MixJob* job, fxl::TimePoint process_start) {
         FXL_LOG(INFO) << "UNDERFLOW: Recovered after " << std::fixed
                       << std::setprecision(3)
                       << (now - underflow_start_time_) / 1000000.0 << " mSec.";
+        TRACE_INSTANT("audio", "DriverOutput::UnderflowRecovered",
+                      TRACE_SCOPE_PROCESS, "duration",
+                      now - underflow_start_time_);
+
+        stats_.underflow_time += now - underflow_start_time_;
         underflow_start_time_ = 0;
         underflow_cooldown_deadline_ = 0;
       }
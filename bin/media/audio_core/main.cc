@@ -3,12 +3,14 @@
 // found in the LICENSE file.
 
 #include <lib/async-loop/cpp/loop.h>
+#include <trace-provider/provider.h>
 
 #include "garnet/bin/media/audio_core/audio_core_impl.h"
 #include "lib/component/cpp/startup_context.h"
 
 int main(int argc, const char** argv) {
   async::Loop loop(&kAsyncLoopConfigAttachToThread);
+  trace::TraceProvider trace_provider(loop.dispatcher());
   media::audio::AudioCoreImpl impl;
   loop.Run();
   return 0;
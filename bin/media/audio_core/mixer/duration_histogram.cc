@@ -0,0 +1,84 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/media/audio_core/mixer/duration_histogram.h"
+
+#include <zircon/syscalls.h>
+#include <algorithm>
+#include <cmath>
+
+#include "lib/fxl/logging.h"
+
+namespace media {
+namespace audio {
+namespace mixer {
+
+constexpr uint32_t DurationHistogram::kNumBuckets;
+
+zx_duration_t DurationHistogram::BucketLimit(uint32_t bucket) {
+  FXL_DCHECK(bucket < kNumBuckets);
+  if (bucket == kNumBuckets - 1) {
+    return ZX_TIME_INFINITE;
+  }
+  return ZX_USEC(1) << bucket;
+}
+
+uint32_t DurationHistogram::BucketFor(zx_duration_t duration) {
+  uint32_t bucket = 0;
+  for (zx_duration_t usec = duration / ZX_USEC(1); usec > 0; usec >>= 1) {
+    ++bucket;
+  }
+  return std::min(bucket, kNumBuckets - 1);
+}
+
+void DurationHistogram::Record(zx_duration_t duration) {
+  duration = std::max<zx_duration_t>(duration, 0);
+
+  buckets_[BucketFor(duration)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  total_.fetch_add(duration, std::memory_order_relaxed);
+
+  zx_duration_t max = max_.load(std::memory_order_relaxed);
+  while ((duration > max) &&
+         !max_.compare_exchange_weak(max, duration, std::memory_order_relaxed)) {
+  }
+}
+
+DurationHistogram::Snapshot DurationHistogram::GetSnapshot() const {
+  Snapshot snapshot;
+  snapshot.count = count_.load(std::memory_order_relaxed);
+  snapshot.total = total_.load(std::memory_order_relaxed);
+  snapshot.max = max_.load(std::memory_order_relaxed);
+  for (uint32_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+    snapshot.buckets[bucket] = buckets_[bucket].load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+zx_duration_t DurationHistogram::Snapshot::Percentile(double percent) const {
+  uint64_t in_buckets = 0;
+  for (uint32_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+    in_buckets += buckets[bucket];
+  }
+  if (in_buckets == 0) {
+    return 0;
+  }
+
+  // The rank of the sample we want, counting from 1.
+  uint64_t rank = static_cast<uint64_t>(std::ceil(in_buckets * percent / 100.0));
+  rank = std::max<uint64_t>(std::min(rank, in_buckets), 1u);
+
+  uint64_t seen = 0;
+  for (uint32_t bucket = 0; bucket < kNumBuckets; ++bucket) {
+    seen += buckets[bucket];
+    if (seen >= rank) {
+      return std::min(BucketLimit(bucket), max);
+    }
+  }
+  return max;
+}
+
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
@@ -0,0 +1,63 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_DURATION_HISTOGRAM_H_
+#define GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_DURATION_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <zircon/types.h>
+#include <atomic>
+
+namespace media {
+namespace audio {
+namespace mixer {
+
+// DurationHistogram counts durations (such as the time taken by each pass of a
+// mix stage) in power-of-two buckets, along with their total and maximum.
+//
+// Recording takes no locks, so it is cheap enough for the mix path and safe
+// from any number of threads at once. A snapshot taken while others record may
+// be very slightly inconsistent (its count might not match its buckets, for
+// example), which is fine for statistics.
+class DurationHistogram {
+ public:
+  // Bucket 0 counts durations under 1 usec. Bucket N, for 0 < N < kNumBuckets-1,
+  // counts [2^(N-1), 2^N) usec. The final bucket counts everything longer: at
+  // 262 msec and up, that is well past any mix lead time we expect to see.
+  static constexpr uint32_t kNumBuckets = 20;
+
+  struct Snapshot {
+    uint64_t count = 0;
+    zx_duration_t total = 0;
+    zx_duration_t max = 0;
+    uint64_t buckets[kNumBuckets] = {};
+
+    zx_duration_t mean() const { return count ? (total / count) : 0; }
+
+    // An upper bound on the given percentile (0-100) of recorded durations:
+    // the end of the bucket that contains it, or |max| if that is smaller.
+    zx_duration_t Percentile(double percent) const;
+  };
+
+  // The first duration that is too long for |bucket|.
+  static zx_duration_t BucketLimit(uint32_t bucket);
+  static uint32_t BucketFor(zx_duration_t duration);
+
+  // Negative durations are counted as zero.
+  void Record(zx_duration_t duration);
+
+  Snapshot GetSnapshot() const;
+
+ private:
+  std::atomic<uint64_t> count_{0};
+  std::atomic<zx_duration_t> total_{0};
+  std::atomic<zx_duration_t> max_{0};
+  std::atomic<uint64_t> buckets_[kNumBuckets] = {};
+};
+
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
+
+#endif  // GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_DURATION_HISTOGRAM_H_
@@ -9,6 +9,7 @@
 
 #include "garnet/bin/media/audio_core/mixer/constants.h"
 #include "garnet/bin/media/audio_core/mixer/mixer_utils.h"
+#include "garnet/bin/media/audio_core/mixer/simd_kernels.h"
 #include "lib/fxl/logging.h"
 
 namespace media {
@@ -173,6 +174,31 @@ inline bool LinearSamplerImpl<DestChanCount, SrcSampleType, SrcChanCount>::Mix(
     }
 
     // Now we are fully in the current buffer and need not rely on our cache.
+    // At unity rate or an integer rate ratio, every frame interpolates at the
+    // same fractional position, so let the vector kernels produce as many
+    // frames as they can; the loop below finishes any remainder.
+    if (!HasModulo && (step_size >= FRAC_ONE) &&
+        ((step_size & FRAC_MASK) == 0) && (dest_off < dest_frames) &&
+        (src_off >= 0) && (src_off < src_end)) {
+      uint32_t src_avail = (((src_end - src_off) + step_size - 1) / step_size);
+      uint32_t dest_avail = (dest_frames - dest_off);
+
+      VectorMixJob job;
+      job.dest = dest + (dest_off * DestChanCount);
+      job.src = src + (src_off >> kPtsFractionalBits) * SrcChanCount;
+      job.src_frames = (frac_src_frames >> kPtsFractionalBits) -
+                       (src_off >> kPtsFractionalBits);
+      job.frames = std::min(src_avail, dest_avail);
+      job.src_step = step_size >> kPtsFractionalBits;
+      job.frac = src_off & FRAC_MASK;
+      job.scale = amplitude_scale;
+      uint32_t mixed = VectorMix<ScaleType, DoAccumulate, true, SrcSampleType,
+                                 SrcChanCount, DestChanCount>(job);
+
+      dest_off += mixed;
+      src_off += mixed * step_size;
+    }
+
     while ((dest_off < dest_frames) && (src_off < src_end)) {
       uint32_t S = (src_off >> kPtsFractionalBits) * SrcChanCount;
       float* out = dest + (dest_off * DestChanCount);
@@ -0,0 +1,170 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/media/audio_core/mixer/mix_scheduler.h"
+
+#include <string.h>
+#include <zircon/syscalls.h>
+
+#include "lib/fxl/logging.h"
+
+namespace media {
+namespace audio {
+namespace mixer {
+
+MixScheduler::MixScheduler(uint32_t num_threads)
+    : num_threads_(num_threads),
+      workers_(num_threads),
+      partials_(num_threads) {
+  FXL_DCHECK(num_threads_ > 0);
+
+  // Worker 0 is the thread that calls Run; start the others.
+  for (uint32_t id = 1; id < num_threads_; ++id) {
+    threads_.emplace_back(&MixScheduler::WorkerThread, this, id);
+  }
+}
+
+MixScheduler::~MixScheduler() {
+  {
+    std::lock_guard<std::mutex> locker(lock_);
+    shutting_down_ = true;
+  }
+  start_cv_.notify_all();
+
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void MixScheduler::SetMaxSamples(uint32_t max_samples) {
+  std::lock_guard<std::mutex> locker(lock_);
+  FXL_DCHECK(busy_ == 0);
+
+  // Worker 0 mixes directly into the caller's buffer, so it needs none.
+  max_samples_ = max_samples;
+  for (uint32_t id = 1; id < num_threads_; ++id) {
+    workers_[id].buf = std::make_unique<float[]>(max_samples_);
+  }
+}
+
+void MixScheduler::Run(float* dest, uint32_t num_samples, uint32_t num_tasks,
+                       const Task& task) {
+  uint32_t num_partials =
+      RunUnreduced(dest, num_samples, num_tasks, task, partials_.data());
+
+  // Sum the other workers' buffers into the destination.
+  for (uint32_t partial = 1; partial < num_partials; ++partial) {
+    const float* src = partials_[partial];
+    for (uint32_t idx = 0; idx < num_samples; ++idx) {
+      dest[idx] += src[idx];
+    }
+  }
+}
+
+uint32_t MixScheduler::RunUnreduced(float* dest, uint32_t num_samples,
+                                    uint32_t num_tasks, const Task& task,
+                                    const float** partials) {
+  FXL_DCHECK(dest);
+  FXL_DCHECK(partials);
+  partials[0] = dest;
+
+  // With nothing to share, mix every stream here, just as a serial mix would.
+  if ((num_threads_ == 1) || (num_tasks <= 1)) {
+    for (uint32_t index = 0; index < num_tasks; ++index) {
+      task(index, dest);
+    }
+    return 1;
+  }
+
+  {
+    std::lock_guard<std::mutex> locker(lock_);
+    FXL_DCHECK(num_samples <= max_samples_);
+    FXL_DCHECK(busy_ == 0);
+
+    task_ = &task;
+    dest_ = dest;
+    num_tasks_ = num_tasks;
+    num_samples_ = num_samples;
+    for (auto& worker : workers_) {
+      worker.used = false;
+    }
+
+    busy_ = num_threads_ - 1;
+    ++generation_;
+  }
+  start_cv_.notify_all();
+
+  RunTasks(0);
+
+  {
+    std::unique_lock<std::mutex> locker(lock_);
+    done_cv_.wait(locker, [this]() { return busy_ == 0; });
+  }
+
+  // Every worker has finished (and released lock_ since), so their buffers are
+  // safe to read. Hand back the ones that were used.
+  uint32_t num_partials = 1;
+  for (uint32_t id = 1; id < num_threads_; ++id) {
+    if (workers_[id].used) {
+      partials[num_partials++] = workers_[id].buf.get();
+    }
+  }
+  return num_partials;
+}
+
+void MixScheduler::WorkerThread(uint32_t id) {
+  // Mix threads must keep up with the output just as the thread that calls Run
+  // does, so run at the same priority as the output's mix domain.
+  zx_thread_set_priority(24 /* HIGH_PRIORITY in LK */);
+
+  uint64_t last_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> locker(lock_);
+      start_cv_.wait(locker, [this, last_generation]() {
+        return shutting_down_ || (generation_ != last_generation);
+      });
+      if (shutting_down_) {
+        return;
+      }
+      last_generation = generation_;
+    }
+
+    RunTasks(id);
+
+    bool done;
+    {
+      std::lock_guard<std::mutex> locker(lock_);
+      done = (--busy_ == 0);
+    }
+    if (done) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+void MixScheduler::RunTasks(uint32_t id) {
+  // Each worker mixes a fixed, contiguous block of streams, in order, so that
+  // every job of the same shape sums its streams in the same order.
+  const uint32_t first = static_cast<uint64_t>(num_tasks_) * id / num_threads_;
+  const uint32_t last =
+      static_cast<uint64_t>(num_tasks_) * (id + 1) / num_threads_;
+  if (first == last) {
+    return;
+  }
+
+  float* accum = dest_;
+  if (id != 0) {
+    accum = workers_[id].buf.get();
+    ::memset(accum, 0, num_samples_ * sizeof(accum[0]));
+    workers_[id].used = true;
+  }
+  for (uint32_t index = first; index < last; ++index) {
+    (*task_)(index, accum);
+  }
+}
+
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
@@ -0,0 +1,96 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_MIX_SCHEDULER_H_
+#define GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_MIX_SCHEDULER_H_
+
+#include <stdint.h>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace media {
+namespace audio {
+namespace mixer {
+
+// MixScheduler spreads the per-stream work of a mix job (resampling each stream
+// and accumulating it into the intermediate mix buffer) across a small pool of
+// worker threads. Each worker accumulates its streams into a buffer of its own;
+// once every stream has been mixed, the caller's thread sums those buffers into
+// the destination (or, with RunUnreduced, leaves that to whatever consumes the
+// mix next).
+//
+// Streams are split into contiguous blocks, one per worker: worker N mixes
+// streams [N * num_tasks / num_threads, (N + 1) * num_tasks / num_threads) in
+// order, and the buffers are summed in worker order. Summation order depends
+// only on the number of streams and threads, never on timing, so repeating a
+// job gives bit-identical output. It may still differ from a serial mix in the
+// final bits. A slow stream is not rebalanced onto an idle worker.
+class MixScheduler {
+ public:
+  // Mixes stream |index| into |accum|. A worker's first stream of each job sees
+  // silence there (or, for the caller's worker, |dest| as passed to Run); later
+  // ones see the streams that the worker mixed before.
+  using Task = std::function<void(uint32_t index, float* accum)>;
+
+  // |num_threads| includes the thread that calls Run, which always takes part
+  // in the mix. With a single thread, Run simply runs every task in order.
+  explicit MixScheduler(uint32_t num_threads);
+  ~MixScheduler();
+
+  uint32_t num_threads() const { return num_threads_; }
+
+  // Size the workers' buffers for jobs of up to |max_samples| samples.
+  void SetMaxSamples(uint32_t max_samples);
+
+  // Run |task| for each of |num_tasks| streams, accumulating all of them into
+  // the |num_samples| samples of |dest|. Returns once every task has finished.
+  void Run(float* dest, uint32_t num_samples, uint32_t num_tasks,
+           const Task& task);
+
+  // As Run, but without summing the workers' buffers: fills |partials| (which
+  // must have room for num_threads() entries) with |dest| and then each other
+  // buffer that was used, in the order that Run would add them, and returns how
+  // many it filled. These remain valid until the next call to either method.
+  uint32_t RunUnreduced(float* dest, uint32_t num_samples, uint32_t num_tasks,
+                        const Task& task, const float** partials);
+
+ private:
+  struct Worker {
+    std::unique_ptr<float[]> buf;
+    bool used;
+  };
+
+  void WorkerThread(uint32_t id);
+  void RunTasks(uint32_t id);
+
+  const uint32_t num_threads_;
+  std::vector<std::thread> threads_;
+  std::vector<Worker> workers_;
+  std::vector<const float*> partials_;  // Used by Run, from RunUnreduced.
+  uint32_t max_samples_ = 0;
+
+  std::mutex lock_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  uint64_t generation_ = 0;  // Advanced by Run, once for each job.
+  uint32_t busy_ = 0;        // Worker threads still running the current job.
+  bool shutting_down_ = false;
+
+  // The current job. Run sets these while holding lock_, before it advances
+  // generation_; worker threads read them only after seeing that change.
+  const Task* task_ = nullptr;
+  float* dest_ = nullptr;
+  uint32_t num_tasks_ = 0;
+  uint32_t num_samples_ = 0;
+};
+
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
+
+#endif  // GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_MIX_SCHEDULER_H_
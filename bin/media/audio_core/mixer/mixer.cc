@@ -7,6 +7,7 @@
 #include "garnet/bin/media/audio_core/mixer/linear_sampler.h"
 #include "garnet/bin/media/audio_core/mixer/no_op.h"
 #include "garnet/bin/media/audio_core/mixer/point_sampler.h"
+#include "garnet/bin/media/audio_core/mixer/sinc_sampler.h"
 #include "lib/fxl/logging.h"
 #include "lib/media/timeline/timeline_rate.h"
 
@@ -39,6 +40,8 @@ MixerPtr Mixer::Select(const fuchsia::media::AudioStreamType& src_format,
       return mixer::PointSampler::Select(src_format, dest_format);
     case Resampler::LinearInterpolation:
       return mixer::LinearSampler::Select(src_format, dest_format);
+    case Resampler::WindowedSinc:
+      return mixer::SincSampler::Select(src_format, dest_format);
 
       // Otherwise (if Default), continue onward.
     case Resampler::Default:
@@ -9,6 +9,7 @@
 #include <memory>
 
 #include "garnet/bin/media/audio_core/mixer/constants.h"
+#include "garnet/bin/media/audio_core/mixer/duration_histogram.h"
 #include "garnet/bin/media/audio_core/mixer/gain.h"
 #include "lib/media/timeline/timeline_function.h"
 
@@ -32,10 +33,13 @@ class Mixer {
   // optionally use this enum to specify a resampler type. Default allows an
   // algorithm to select a resampler based on the ratio of incoming and outgoing
   // rates, using Linear for all except "Integer-to-One" resampling ratios.
+  // WindowedSinc is never chosen by default: it has far less aliasing than
+  // Linear, but costs considerably more CPU.
   enum class Resampler {
     Default = 0,
     SampleAndHold,
     LinearInterpolation,
+    WindowedSinc,
   };
 
   //
@@ -186,7 +190,7 @@ class Mixer {
 //
 // mixer
 // This is a pointer to the Mixer object that resamples the input. Currently the
-// resampler types include SampleAndHold and LinearInterpolation.
+// resampler types include SampleAndHold, LinearInterpolation and WindowedSinc.
 //
 // gain
 // This object maintains gain values contained in the mix path. This includes
@@ -237,6 +241,10 @@ class Mixer {
 // clock_mono_to_frac_source_frames may change over time; this value represents
 // the current generation (which version), so any change can be detected.
 //
+// mix_time
+// How long each mix job spent mixing this stream. Only the thread that mixes
+// the stream records into it, but any thread may read it.
+//
 struct Bookkeeping {
   Bookkeeping() = default;
   ~Bookkeeping() = default;
@@ -260,6 +268,8 @@ struct Bookkeeping {
   TimelineFunction clock_mono_to_frac_source_frames;
   uint32_t source_trans_gen_id = kInvalidGenerationId;
 
+  mixer::DurationHistogram mix_time;
+
   void Reset() {
     mixer->Reset();
     src_pos_modulo = 0;
@@ -6,10 +6,12 @@
 
 #include <fbl/algorithm.h>
 #include <math.h>
+#include <algorithm>
 #include <limits>
 #include <type_traits>
 
 #include "garnet/bin/media/audio_core/mixer/constants.h"
+#include "garnet/bin/media/audio_core/mixer/simd_kernels.h"
 #include "lib/fidl/cpp/clone.h"
 #include "lib/fxl/logging.h"
 
@@ -30,7 +32,10 @@ namespace audio {
 // Having said all this, the "practically clipping" value of +1.0 is rare in WAV
 // files, and other sources should easily be able to reduce their input levels.
 
-// Template to produce destination samples from normalized samples.
+// Template to produce destination samples from normalized samples. Integer
+// formats can also add |dither|, in output LSBs, before rounding; this is done
+// in a statement of its own so that it is never fused with the scaling, as the
+// vector kernels (which must match bit for bit) never fuse it either.
 template <typename DType, typename Enable = void>
 class DestConverter;
 
@@ -44,6 +49,15 @@ class DestConverter<
         std::numeric_limits<uint8_t>::min(),
         std::numeric_limits<uint8_t>::max());
   }
+
+  static constexpr float kDitherScale = mixer::kDitherScale;
+  static inline DType Convert(float sample, float dither) {
+    float scaled = sample * kFloatToInt8;
+    scaled += dither;
+    return fbl::clamp<int32_t>(round(scaled) + kOffsetInt8ToUint8,
+                               std::numeric_limits<uint8_t>::min(),
+                               std::numeric_limits<uint8_t>::max());
+  }
 };
 
 template <typename DType>
@@ -55,6 +69,15 @@ class DestConverter<
                                std::numeric_limits<int16_t>::min(),
                                std::numeric_limits<int16_t>::max());
   }
+
+  static constexpr float kDitherScale = mixer::kDitherScale;
+  static inline DType Convert(float sample, float dither) {
+    float scaled = sample * kFloatToInt16;
+    scaled += dither;
+    return fbl::clamp<int32_t>(round(scaled),
+                               std::numeric_limits<int16_t>::min(),
+                               std::numeric_limits<int16_t>::max());
+  }
 };
 
 template <typename DType>
@@ -65,6 +88,13 @@ class DestConverter<
     return fbl::clamp<int64_t>(round(sample * kFloatToInt24In32), kMinInt24In32,
                                kMaxInt24In32);
   }
+
+  static constexpr float kDitherScale = mixer::kDitherScaleInt24In32;
+  static inline DType Convert(float sample, float dither) {
+    float scaled = sample * kFloatToInt24In32;
+    scaled += dither;
+    return fbl::clamp<int64_t>(round(scaled), kMinInt24In32, kMaxInt24In32);
+  }
 };
 
 template <typename DType>
@@ -75,6 +105,12 @@ class DestConverter<
   static inline constexpr DType Convert(float sample) {
     return fbl::clamp(sample, -1.0f, 1.0f);
   }
+
+  // Float output is never dithered.
+  static constexpr float kDitherScale = 0.0f;
+  static inline constexpr DType Convert(float sample, float /* dither */) {
+    return Convert(sample);
+  }
 };
 
 // Template to fill samples with silence based on sample type.
@@ -108,23 +144,88 @@ template <typename DType>
 class OutputProducerImpl : public OutputProducer {
  public:
   explicit OutputProducerImpl(const fuchsia::media::AudioStreamTypePtr& format)
-      : OutputProducer(format, sizeof(DType)) {}
+      : OutputProducer(format, sizeof(DType)) {
+    // Any nonzero seeds will do; give each generator a different one.
+    for (uint32_t lane = 0; lane < mixer::kDitherLanes; ++lane) {
+      dither_state_[lane] = 0x9E3779B9u * (lane + 1);
+    }
+  }
 
   void ProduceOutput(const float* source, void* dest_void,
                      uint32_t frames) const override {
-    using DC = DestConverter<DType>;
-    DType* dest = static_cast<DType*>(dest_void);
+    ProduceSamples(source, static_cast<DType*>(dest_void), frames * channels_);
+  }
 
-    // Previously we clamped here; because of rounding, this is different for
-    // each output type, so it is now handled in Convert() specializations.
-    for (size_t i = 0; i < (static_cast<size_t>(frames) * channels_); ++i) {
-      dest[i] = DC::Convert(source[i]);
+  void ProduceOutput(const float* const* sources, uint32_t num_sources,
+                     void* dest_void, uint32_t frames) const override {
+    FXL_DCHECK(num_sources > 0);
+    if (num_sources == 1) {
+      ProduceOutput(sources[0], dest_void, frames);
+      return;
+    }
+
+    // Sum each chunk in the same order as MixScheduler::Run would, so that the
+    // output matches producing from its fully accumulated buffer.
+    DType* dest = static_cast<DType*>(dest_void);
+    const uint32_t samples = frames * channels_;
+    float sum[kSumChunkSamples];
+    for (uint32_t offset = 0; offset < samples; offset += kSumChunkSamples) {
+      const uint32_t count = std::min(samples - offset, kSumChunkSamples);
+      const float* first = sources[0] + offset;
+      const float* second = sources[1] + offset;
+      for (uint32_t idx = 0; idx < count; ++idx) {
+        sum[idx] = first[idx] + second[idx];
+      }
+      for (uint32_t source = 2; source < num_sources; ++source) {
+        const float* src = sources[source] + offset;
+        for (uint32_t idx = 0; idx < count; ++idx) {
+          sum[idx] += src[idx];
+        }
+      }
+      ProduceSamples(sum, dest + offset, count);
     }
   }
 
   void FillWithSilence(void* dest, uint32_t frames) const override {
     SilenceMaker<DType>::Fill(dest, frames * channels_);
   }
+
+ private:
+  // Small enough to stay in L1 alongside its sources; a whole number of dither
+  // blocks, so that each chunk starts on generator 0 as a full buffer would.
+  static constexpr uint32_t kSumChunkSamples = 256;
+  static_assert(kSumChunkSamples % mixer::kDitherLanes == 0,
+                "Sum chunks must hold whole dither blocks");
+
+  void ProduceSamples(const float* source, DType* dest,
+                      uint32_t samples) const {
+    using DC = DestConverter<DType>;
+    uint32_t* dither =
+        (dither_ && (DC::kDitherScale != 0.0f)) ? dither_state_ : nullptr;
+
+    // The vector kernels take whole blocks; the scalar loops finish the rest.
+    uint32_t idx = mixer::VectorProduce<DType>({source, dest, samples, dither});
+
+    // Previously we clamped here; because of rounding, this is different for
+    // each output type, so it is now handled in Convert() specializations.
+    if (dither) {
+      for (; idx < samples; ++idx) {
+        uint32_t& state = dither[idx % mixer::kDitherLanes];
+        state = mixer::NextDitherState(state);
+        float noise =
+            static_cast<float>(mixer::DitherNoise(state)) * DC::kDitherScale;
+        dest[idx] = DC::Convert(source[idx], noise);
+      }
+    } else {
+      for (; idx < samples; ++idx) {
+        dest[idx] = DC::Convert(source[idx]);
+      }
+    }
+  }
+
+  // Producing output advances the dither generators, so an OutputProducer
+  // that dithers must only be used by one thread at a time.
+  mutable uint32_t dither_state_[mixer::kDitherLanes];
 };
 
 // Constructor/destructor for the common OutputProducer base class.
@@ -40,6 +40,22 @@ class OutputProducer {
   virtual void ProduceOutput(const float* source, void* dest,
                              uint32_t frames) const = 0;
 
+  /**
+   * Sum several intermediate buffers and produce output from the result, as
+   * if they had first been accumulated into one. The sum is formed a cache-
+   * sized piece at a time and converted straight away, instead of in a
+   * separate pass over the whole of the first buffer.
+   *
+   * @param sources Pointers to |num_sources| buffers of normalized frames,
+   * which are summed in order.
+   *
+   * @param dest A pointer to the destination buffer.
+   *
+   * @param frames The number of frames to produce.
+   */
+  virtual void ProduceOutput(const float* const* sources, uint32_t num_sources,
+                             void* dest, uint32_t frames) const = 0;
+
   /**
    * Fill a destination buffer with silence.
    *
@@ -50,6 +66,14 @@ class OutputProducer {
    */
   virtual void FillWithSilence(void* dest, uint32_t frames) const = 0;
 
+  /**
+   * Add triangular (TPDF) dither of up to 1 LSB to integer output formats, to
+   * decorrelate quantization error from the signal. Off by default; float
+   * output is never dithered.
+   */
+  void set_dither(bool dither) { dither_ = dither; }
+  bool dither() const { return dither_; }
+
   const fuchsia::media::AudioStreamTypePtr& format() const { return format_; }
   uint32_t channels() const { return channels_; }
   uint32_t bytes_per_sample() const { return bytes_per_sample_; }
@@ -63,6 +87,7 @@ class OutputProducer {
   uint32_t channels_ = 0;
   uint32_t bytes_per_sample_ = 0;
   uint32_t bytes_per_frame_ = 0;
+  bool dither_ = false;
 };
 
 }  // namespace audio
@@ -9,6 +9,7 @@
 
 #include "garnet/bin/media/audio_core/mixer/constants.h"
 #include "garnet/bin/media/audio_core/mixer/mixer_utils.h"
+#include "garnet/bin/media/audio_core/mixer/simd_kernels.h"
 #include "lib/fxl/logging.h"
 
 namespace media {
@@ -112,6 +113,30 @@ inline bool PointSamplerImpl<DestChanCount, SrcSampleType, SrcChanCount>::Mix(
   if (ScaleType != ScalerType::MUTED) {
     Gain::AScale amplitude_scale = info->gain.GetGainScale();
 
+    // At unity rate or an integer rate ratio, let the vector kernels produce
+    // as many frames as they can; the loop below finishes any remainder.
+    if (!HasModulo && (step_size >= FRAC_ONE) &&
+        ((step_size & FRAC_MASK) == 0)) {
+      uint32_t src_avail =
+          ((frac_src_frames - src_off) + step_size - 1) / step_size;
+      uint32_t dest_avail = (dest_frames - dest_off);
+
+      VectorMixJob job;
+      job.dest = dest + (dest_off * DestChanCount);
+      job.src = src + (src_off >> kPtsFractionalBits) * SrcChanCount;
+      job.src_frames = (frac_src_frames >> kPtsFractionalBits) -
+                       (src_off >> kPtsFractionalBits);
+      job.frames = std::min(src_avail, dest_avail);
+      job.src_step = step_size >> kPtsFractionalBits;
+      job.frac = 0;
+      job.scale = amplitude_scale;
+      uint32_t mixed = VectorMix<ScaleType, DoAccumulate, false, SrcSampleType,
+                                 SrcChanCount, DestChanCount>(job);
+
+      dest_off += mixed;
+      src_off += mixed * step_size;
+    }
+
     while ((dest_off < dest_frames) &&
            (src_off < static_cast<int32_t>(frac_src_frames))) {
       uint32_t src_iter = (src_off >> kPtsFractionalBits) * SrcChanCount;
@@ -0,0 +1,316 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/media/audio_core/mixer/simd_kernels.h"
+
+#include <atomic>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "garnet/bin/media/audio_core/mixer/simd_kernels_impl.h"
+
+namespace media {
+namespace audio {
+namespace mixer {
+
+namespace {
+
+#if defined(__x86_64__)
+
+struct Sse2 {
+  using V = __m128;
+  static constexpr size_t kWidth = 4;
+
+  static inline V Splat(float val) { return _mm_set1_ps(val); }
+  static inline V Load(const float* src) { return _mm_loadu_ps(src); }
+  static inline V Load(const int16_t* src) {
+    // Sign-extend each sample by unpacking it into the top of a 32-bit lane.
+    __m128i samples = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+    __m128i wide = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+    return _mm_mul_ps(_mm_set1_ps(kInt16ToFloat), _mm_cvtepi32_ps(wide));
+  }
+  static inline void Store(float* dest, V val) { _mm_storeu_ps(dest, val); }
+
+  static inline V Add(V a, V b) { return _mm_add_ps(a, b); }
+  static inline V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+  static inline V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+
+  static inline V Evens(V a, V b) {
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+  }
+  static inline V Odds(V a, V b) {
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+  }
+  static inline V EvenPairs(V a, V b) { return _mm_movelh_ps(a, b); }
+  static inline V ZipLo(V val) { return _mm_unpacklo_ps(val, val); }
+  static inline V ZipHi(V val) { return _mm_unpackhi_ps(val, val); }
+
+  static inline float Sum(V val) {
+    V sum = _mm_add_ps(val, _mm_movehl_ps(val, val));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum);
+  }
+
+  using VI = __m128i;
+
+  static inline V Min(V a, V b) { return _mm_min_ps(a, b); }
+  static inline V Max(V a, V b) { return _mm_max_ps(a, b); }
+
+  // Truncate, then step away from zero if what was dropped was at least 0.5.
+  static inline VI RoundToInt(V val) {
+    VI whole = _mm_cvttps_epi32(val);
+    V dropped = _mm_sub_ps(val, _mm_cvtepi32_ps(whole));
+    V magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), dropped);
+    VI round_away =
+        _mm_castps_si128(_mm_cmpge_ps(magnitude, _mm_set1_ps(0.5f)));
+    // -1 for negative values, otherwise 1.
+    VI away = _mm_or_si128(_mm_srai_epi32(_mm_castps_si128(val), 31),
+                           _mm_set1_epi32(1));
+    return _mm_add_epi32(whole, _mm_and_si128(round_away, away));
+  }
+  static inline V ToFloat(VI val) { return _mm_cvtepi32_ps(val); }
+
+  static inline VI LoadInt(const uint32_t* src) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+  }
+  static inline void StoreInt(uint32_t* dest, VI val) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), val);
+  }
+  static inline void StoreInt16(int16_t* dest, VI val) {
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dest),
+                     _mm_packs_epi32(val, val));
+  }
+  static inline void StoreInt32(int32_t* dest, VI val) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), val);
+  }
+
+  static inline VI NextDitherState(VI state) {
+    state = _mm_xor_si128(state, _mm_slli_epi32(state, 13));
+    state = _mm_xor_si128(state, _mm_srli_epi32(state, 17));
+    return _mm_xor_si128(state, _mm_slli_epi32(state, 5));
+  }
+  static inline VI DitherNoise(VI state) {
+    return _mm_sub_epi32(_mm_and_si128(state, _mm_set1_epi32(0xFFFF)),
+                         _mm_srli_epi32(state, 16));
+  }
+};
+
+bool CpuHasAvx2() {
+  uint32_t eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) ||
+      !(ecx & bit_AVX)) {
+    return false;
+  }
+
+  // The OS must also save and restore the YMM registers (XCR0 bits 1 and 2).
+  uint32_t xcr0_lo, xcr0_hi;
+  __asm__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  if ((xcr0_lo & 0x6) != 0x6) {
+    return false;
+  }
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  return (ebx & bit_AVX2) != 0;
+}
+
+#elif defined(__aarch64__)
+
+struct Neon {
+  using V = float32x4_t;
+  static constexpr size_t kWidth = 4;
+
+  static inline V Splat(float val) { return vdupq_n_f32(val); }
+  static inline V Load(const float* src) { return vld1q_f32(src); }
+  static inline V Load(const int16_t* src) {
+    int32x4_t wide = vmovl_s16(vld1_s16(src));
+    return vmulq_f32(vdupq_n_f32(kInt16ToFloat), vcvtq_f32_s32(wide));
+  }
+  static inline void Store(float* dest, V val) { vst1q_f32(dest, val); }
+
+  static inline V Add(V a, V b) { return vaddq_f32(a, b); }
+  static inline V Sub(V a, V b) { return vsubq_f32(a, b); }
+  static inline V Mul(V a, V b) { return vmulq_f32(a, b); }
+
+  static inline V Evens(V a, V b) { return vuzpq_f32(a, b).val[0]; }
+  static inline V Odds(V a, V b) { return vuzpq_f32(a, b).val[1]; }
+  static inline V EvenPairs(V a, V b) {
+    return vcombine_f32(vget_low_f32(a), vget_low_f32(b));
+  }
+  static inline V ZipLo(V val) { return vzipq_f32(val, val).val[0]; }
+  static inline V ZipHi(V val) { return vzipq_f32(val, val).val[1]; }
+
+  static inline float Sum(V val) { return vaddvq_f32(val); }
+
+  using VI = int32x4_t;
+
+  static inline V Min(V a, V b) { return vminq_f32(a, b); }
+  static inline V Max(V a, V b) { return vmaxq_f32(a, b); }
+
+  static inline VI RoundToInt(V val) { return vcvtaq_s32_f32(val); }
+  static inline V ToFloat(VI val) { return vcvtq_f32_s32(val); }
+
+  static inline VI LoadInt(const uint32_t* src) {
+    return vreinterpretq_s32_u32(vld1q_u32(src));
+  }
+  static inline void StoreInt(uint32_t* dest, VI val) {
+    vst1q_u32(dest, vreinterpretq_u32_s32(val));
+  }
+  static inline void StoreInt16(int16_t* dest, VI val) {
+    vst1_s16(dest, vqmovn_s32(val));
+  }
+  static inline void StoreInt32(int32_t* dest, VI val) { vst1q_s32(dest, val); }
+
+  static inline VI NextDitherState(VI val) {
+    uint32x4_t state = vreinterpretq_u32_s32(val);
+    state = veorq_u32(state, vshlq_n_u32(state, 13));
+    state = veorq_u32(state, vshrq_n_u32(state, 17));
+    state = veorq_u32(state, vshlq_n_u32(state, 5));
+    return vreinterpretq_s32_u32(state);
+  }
+  static inline VI DitherNoise(VI val) {
+    uint32x4_t state = vreinterpretq_u32_s32(val);
+    return vsubq_s32(
+        vreinterpretq_s32_u32(vandq_u32(state, vdupq_n_u32(0xFFFF))),
+        vreinterpretq_s32_u32(vshrq_n_u32(state, 16)));
+  }
+};
+
+#endif
+
+std::atomic<SimdLevel>& CurrentLevel() {
+  static std::atomic<SimdLevel> level(DetectSimdLevel());
+  return level;
+}
+
+void ScalarFir(const VectorFirJob& job) {
+  for (size_t chan = 0; chan < job.chans; ++chan) {
+    const float* src = job.src[chan];
+    float sum = 0.0f;
+    for (size_t tap = 0; tap < job.taps; ++tap) {
+      float coef = job.coefs[tap];
+      coef += (job.next_coefs[tap] - coef) * job.frac;
+      sum += coef * src[tap];
+    }
+    job.out[chan] = sum;
+  }
+}
+
+bool IsSupported(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::None:
+      return true;
+#if defined(__x86_64__)
+    case SimdLevel::Sse2:
+      return true;
+    case SimdLevel::Avx2:
+      return CpuHasAvx2();
+#elif defined(__aarch64__)
+    case SimdLevel::Neon:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+SimdLevel DetectSimdLevel() {
+#if defined(__x86_64__)
+  return CpuHasAvx2() ? SimdLevel::Avx2 : SimdLevel::Sse2;
+#elif defined(__aarch64__)
+  return SimdLevel::Neon;
+#else
+  return SimdLevel::None;
+#endif
+}
+
+SimdLevel GetSimdLevel() {
+  return CurrentLevel().load(std::memory_order_relaxed);
+}
+
+bool SetSimdLevel(SimdLevel level) {
+  if (!IsSupported(level)) {
+    return false;
+  }
+  CurrentLevel().store(level, std::memory_order_relaxed);
+  return true;
+}
+
+const char* SimdLevelName(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::None:
+      return "None";
+    case SimdLevel::Sse2:
+      return "SSE2";
+    case SimdLevel::Avx2:
+      return "AVX2";
+    case SimdLevel::Neon:
+      return "NEON";
+  }
+  return "Unknown";
+}
+
+uint32_t VectorMix(const VectorMixFormat& format, const VectorMixJob& job) {
+  switch (GetSimdLevel()) {
+#if defined(__x86_64__)
+    case SimdLevel::Sse2:
+      return simd::Dispatch<Sse2>(format, job);
+    case SimdLevel::Avx2:
+      return simd::VectorMixAvx2(format, job);
+#elif defined(__aarch64__)
+    case SimdLevel::Neon:
+      return simd::Dispatch<Neon>(format, job);
+#endif
+    default:
+      return 0;
+  }
+}
+
+uint32_t VectorProduce(ProduceFormat format, const VectorProduceJob& job) {
+  switch (GetSimdLevel()) {
+#if defined(__x86_64__)
+    case SimdLevel::Sse2:
+      return simd::DispatchProduce<Sse2>(format, job);
+    case SimdLevel::Avx2:
+      return simd::VectorProduceAvx2(format, job);
+#elif defined(__aarch64__)
+    case SimdLevel::Neon:
+      return simd::DispatchProduce<Neon>(format, job);
+#endif
+    default:
+      return 0;
+  }
+}
+
+void VectorFir(const VectorFirJob& job) {
+  switch (GetSimdLevel()) {
+#if defined(__x86_64__)
+    case SimdLevel::Sse2:
+      simd::DispatchFir<Sse2>(job);
+      break;
+    case SimdLevel::Avx2:
+      simd::VectorFirAvx2(job);
+      break;
+#elif defined(__aarch64__)
+    case SimdLevel::Neon:
+      simd::DispatchFir<Neon>(job);
+      break;
+#endif
+    default:
+      ScalarFir(job);
+      break;
+  }
+}
+
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
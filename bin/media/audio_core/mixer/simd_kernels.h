@@ -0,0 +1,190 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SIMD_KERNELS_H_
+#define GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SIMD_KERNELS_H_
+
+#include <stdint.h>
+#include <type_traits>
+
+#include "garnet/bin/media/audio_core/mixer/gain.h"
+#include "garnet/bin/media/audio_core/mixer/mixer_utils.h"
+
+namespace media {
+namespace audio {
+namespace mixer {
+
+// simd_kernels.h exposes vectorized versions of the PointSampler and
+// LinearSampler inner loops, for the cases that dominate real use: int16 or
+// float sources, mono or stereo, at unity rate or a 2:1 rate ratio (such
+// as 96k->48k). The kernels perform exactly the same float operations, in the
+// same order, as the scalar loops in mixer_utils.h; their output is therefore
+// identical to the scalar mixers' output, and the bitwise tests verify this.
+// It also exposes the SincSampler's filter inner product (VectorFir), and the
+// OutputProducer's conversion from float to each output format (VectorProduce).
+//
+// The instruction set is chosen at runtime. SSE2 (x64) and NEON (arm64) are
+// part of the baseline ABI and are always available; AVX2 is used when the CPU
+// and OS both support it.
+
+enum class SimdLevel {
+  None,  // No vector kernels; mixers use only their scalar loops.
+  Sse2,
+  Avx2,
+  Neon,
+};
+
+// The most capable instruction set that this CPU supports.
+SimdLevel DetectSimdLevel();
+
+// The instruction set that the vector kernels currently use. This starts out as
+// DetectSimdLevel(); tests and profiling lower it to compare implementations.
+SimdLevel GetSimdLevel();
+
+// Returns false (leaving the level unchanged) if this CPU can't run |level|.
+bool SetSimdLevel(SimdLevel level);
+
+const char* SimdLevelName(SimdLevel level);
+
+// Which of the kernels to run; see VectorMix below.
+struct VectorMixFormat {
+  bool src_is_float;  // Otherwise int16.
+  uint32_t src_chan_count;
+  uint32_t dest_chan_count;
+  bool scale;  // Otherwise unity gain.
+  bool accumulate;
+  bool interpolate;  // LinearSampler (otherwise PointSampler).
+};
+
+// One run of output frames, each sampled from a whole number of source frames
+// after the previous one.
+struct VectorMixJob {
+  float* dest;
+  const void* src;      // Source frame that the first output frame samples.
+  uint32_t src_frames;  // Source frames that may be read, starting at |src|.
+  uint32_t frames;      // Output frames that may be produced.
+  uint32_t src_step;    // Source frames per output frame.
+  uint32_t frac;        // Interpolation position within each source frame.
+  Gain::AScale scale;
+};
+
+// Mixes as many of |job.frames| as the vector kernels handle efficiently, and
+// returns the number of frames it produced (a multiple of the vector width),
+// leaving the rest to the caller's scalar loop. Source steps of 1 and 2 are
+// vectorized; others produce nothing.
+uint32_t VectorMix(const VectorMixFormat& format, const VectorMixJob& job);
+
+// FIR filter lengths must be a multiple of this many taps.
+constexpr size_t kVectorFirTapAlignment = 8;
+
+// One output frame of the SincSampler: for each channel, the inner product of
+// |taps| planar source values with a row of filter coefficients that lies
+// |frac| of the way from |coefs| to |next_coefs|.
+struct VectorFirJob {
+  const float* coefs;
+  const float* next_coefs;
+  float frac;
+  const float* const* src;  // Per channel, the source value for the first tap.
+  size_t chans;
+  size_t taps;  // A multiple of kVectorFirTapAlignment.
+  float* out;   // One value per channel.
+};
+
+// Unlike VectorMix, this always produces its output; at SimdLevel::None it
+// falls back to a scalar loop. Levels sum their products in different orders,
+// so their results may differ in the least significant bits.
+void VectorFir(const VectorFirJob& job);
+
+// Output formats that VectorProduce converts to; each matches one of the
+// OutputProducer's DestConverter specializations.
+enum class ProduceFormat {
+  Int16,
+  Int24In32,
+  Float,
+};
+
+// Integer outputs may be dithered with triangular (TPDF) noise of up to 1 LSB
+// either way. The noise comes from kDitherLanes xorshift32 generators; sample
+// N of each call uses generator N % kDitherLanes, so every SIMD level (and the
+// caller's scalar loop) produces the same output from the same state.
+constexpr uint32_t kDitherLanes = 8;
+
+// DitherNoise is scaled by these to give 1 LSB of each format, in the units
+// that DestConverter rounds: whole int16 (or int8) samples, or whole 32-bit
+// containers of a 24-bit sample.
+constexpr float kDitherScale = 1.0f / 65536;
+constexpr float kDitherScaleInt24In32 = 256.0f / 65536;
+
+inline uint32_t NextDitherState(uint32_t state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+// The difference of the two 16-bit halves of a generator state: triangular
+// noise in (-65536, 65536).
+inline int32_t DitherNoise(uint32_t state) {
+  return static_cast<int32_t>(state & 0xFFFF) -
+         static_cast<int32_t>(state >> 16);
+}
+
+struct VectorProduceJob {
+  const float* src;
+  void* dest;
+  uint32_t samples;
+  uint32_t* dither;  // kDitherLanes generator states, or nullptr for none.
+};
+
+// Converts as many of |job.samples| as the vector kernels handle (a multiple of
+// kDitherLanes) and returns that count, leaving the rest to the caller's scalar
+// loop. Output is identical to DestConverter's; dithering advances each of the
+// generators that it uses. Float output is never dithered.
+uint32_t VectorProduce(ProduceFormat format, const VectorProduceJob& job);
+
+// Compile-time front end for OutputProducerImpl, like VectorMix's below.
+template <typename DestSampleType>
+inline uint32_t VectorProduce(const VectorProduceJob& job) {
+  if (std::is_same<DestSampleType, int16_t>::value) {
+    return VectorProduce(ProduceFormat::Int16, job);
+  }
+  if (std::is_same<DestSampleType, int32_t>::value) {
+    return VectorProduce(ProduceFormat::Int24In32, job);
+  }
+  if (std::is_same<DestSampleType, float>::value) {
+    return VectorProduce(ProduceFormat::Float, job);
+  }
+  return 0;
+}
+
+// Compile-time front end for the mixer templates: returns 0 without calling
+// into the kernels at all when the mixer's format is not one they support.
+template <ScalerType ScaleType, bool DoAccumulate, bool Interpolate,
+          typename SrcSampleType, size_t SrcChanCount, size_t DestChanCount>
+inline uint32_t VectorMix(const VectorMixJob& job) {
+  constexpr bool kSupported =
+      (std::is_same<SrcSampleType, int16_t>::value ||
+       std::is_same<SrcSampleType, float>::value) &&
+      (SrcChanCount == 1 || SrcChanCount == 2) &&
+      (DestChanCount == 1 || DestChanCount == 2) &&
+      (ScaleType != ScalerType::MUTED);
+  if (!kSupported) {
+    return 0;
+  }
+
+  VectorMixFormat format;
+  format.src_is_float = std::is_same<SrcSampleType, float>::value;
+  format.src_chan_count = SrcChanCount;
+  format.dest_chan_count = DestChanCount;
+  format.scale = (ScaleType == ScalerType::NE_UNITY);
+  format.accumulate = DoAccumulate;
+  format.interpolate = Interpolate;
+  return VectorMix(format, job);
+}
+
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
+
+#endif  // GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SIMD_KERNELS_H_
@@ -0,0 +1,137 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// This file is compiled with AVX2 enabled. Nothing in it may run until
+// DetectSimdLevel has confirmed that the CPU supports AVX2.
+
+#if defined(__x86_64__)
+
+#include <immintrin.h>
+
+#include "garnet/bin/media/audio_core/mixer/simd_kernels_impl.h"
+
+namespace media {
+namespace audio {
+namespace mixer {
+namespace simd {
+
+namespace {
+
+struct Avx2 {
+  using V = __m256;
+  static constexpr size_t kWidth = 8;
+
+  static inline V Splat(float val) { return _mm256_set1_ps(val); }
+  static inline V Load(const float* src) { return _mm256_loadu_ps(src); }
+  static inline V Load(const int16_t* src) {
+    __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m256i wide = _mm256_cvtepi16_epi32(samples);
+    return _mm256_mul_ps(_mm256_set1_ps(kInt16ToFloat),
+                         _mm256_cvtepi32_ps(wide));
+  }
+  static inline void Store(float* dest, V val) { _mm256_storeu_ps(dest, val); }
+
+  static inline V Add(V a, V b) { return _mm256_add_ps(a, b); }
+  static inline V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+  static inline V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+
+  // Shuffles stay within 128-bit lanes, so each of these picks its values
+  // from a and b one lane at a time, then puts the 64-bit halves in order.
+  static inline V Evens(V a, V b) {
+    return Halves(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+  }
+  static inline V Odds(V a, V b) {
+    return Halves(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+  static inline V EvenPairs(V a, V b) {
+    return Halves(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 1, 0)));
+  }
+  static inline V Halves(V val) {
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(val),
+                                                  _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+
+  static inline V ZipLo(V val) {
+    return _mm256_permute2f128_ps(_mm256_unpacklo_ps(val, val),
+                                  _mm256_unpackhi_ps(val, val), 0x20);
+  }
+  static inline V ZipHi(V val) {
+    return _mm256_permute2f128_ps(_mm256_unpacklo_ps(val, val),
+                                  _mm256_unpackhi_ps(val, val), 0x31);
+  }
+
+  static inline float Sum(V val) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(val),
+                            _mm256_extractf128_ps(val, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum);
+  }
+
+  using VI = __m256i;
+
+  static inline V Min(V a, V b) { return _mm256_min_ps(a, b); }
+  static inline V Max(V a, V b) { return _mm256_max_ps(a, b); }
+
+  // Truncate, then step away from zero if what was dropped was at least 0.5.
+  static inline VI RoundToInt(V val) {
+    VI whole = _mm256_cvttps_epi32(val);
+    V dropped = _mm256_sub_ps(val, _mm256_cvtepi32_ps(whole));
+    V magnitude = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), dropped);
+    VI round_away = _mm256_castps_si256(
+        _mm256_cmp_ps(magnitude, _mm256_set1_ps(0.5f), _CMP_GE_OQ));
+    // -1 for negative values, otherwise 1.
+    VI away = _mm256_or_si256(_mm256_srai_epi32(_mm256_castps_si256(val), 31),
+                              _mm256_set1_epi32(1));
+    return _mm256_add_epi32(whole, _mm256_and_si256(round_away, away));
+  }
+  static inline V ToFloat(VI val) { return _mm256_cvtepi32_ps(val); }
+
+  static inline VI LoadInt(const uint32_t* src) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+  }
+  static inline void StoreInt(uint32_t* dest, VI val) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), val);
+  }
+  // Packing works within 128-bit lanes; gather the two halves' results.
+  static inline void StoreInt16(int16_t* dest, VI val) {
+    VI packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(val, val),
+                                         _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest),
+                     _mm256_castsi256_si128(packed));
+  }
+  static inline void StoreInt32(int32_t* dest, VI val) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), val);
+  }
+
+  static inline VI NextDitherState(VI state) {
+    state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 13));
+    state = _mm256_xor_si256(state, _mm256_srli_epi32(state, 17));
+    return _mm256_xor_si256(state, _mm256_slli_epi32(state, 5));
+  }
+  static inline VI DitherNoise(VI state) {
+    return _mm256_sub_epi32(
+        _mm256_and_si256(state, _mm256_set1_epi32(0xFFFF)),
+        _mm256_srli_epi32(state, 16));
+  }
+};
+
+}  // namespace
+
+uint32_t VectorMixAvx2(const VectorMixFormat& format, const VectorMixJob& job) {
+  return Dispatch<Avx2>(format, job);
+}
+
+void VectorFirAvx2(const VectorFirJob& job) { DispatchFir<Avx2>(job); }
+
+uint32_t VectorProduceAvx2(ProduceFormat format, const VectorProduceJob& job) {
+  return DispatchProduce<Avx2>(format, job);
+}
+
+}  // namespace simd
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
+
+#endif  // defined(__x86_64__)
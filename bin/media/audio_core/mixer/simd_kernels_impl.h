@@ -0,0 +1,389 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SIMD_KERNELS_IMPL_H_
+#define GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SIMD_KERNELS_IMPL_H_
+
+#include <stdint.h>
+#include <limits>
+
+#include "garnet/bin/media/audio_core/mixer/constants.h"
+#include "garnet/bin/media/audio_core/mixer/simd_kernels.h"
+
+namespace media {
+namespace audio {
+namespace mixer {
+namespace simd {
+
+// simd_kernels_impl.h holds the vector mix kernels, written once against an
+// instruction-set traits class (Isa) that each simd_kernels*.cc file defines
+// in an anonymous namespace. Everything here is templated on that class, so
+// every instantiation has internal linkage: code compiled for AVX2 can never be
+// merged by the linker with code that runs before the CPU has been checked.
+//
+// An Isa provides:
+//   V                     a vector of kWidth floats
+//   Splat, Load, Store
+//   Load(const int16_t*)  kWidth samples, normalized as SampleNormalizer does
+//   Add, Sub, Mul
+//   Evens(a, b), Odds(a, b)  even or odd-indexed values of a:b, in order
+//   EvenPairs(a, b)       even-indexed pairs of values of a:b, in order
+//   ZipLo(v), ZipHi(v)    each value of v twice: v0 v0 v1 v1 ...
+//   Sum(v)                the sum of the values of v
+// and, for VectorProduce:
+//   VI                    a vector of kWidth 32-bit integers
+//   Min(a, b), Max(a, b)  NaN if b is NaN, so that clamping passes NaN through
+//   RoundToInt(v)         rounding halfway cases away from zero, as round()
+//   ToFloat(vi)
+//   LoadInt, StoreInt     kWidth uint32_t values (the dither generators)
+//   StoreInt16            kWidth int16_t values, saturating
+//   StoreInt32            kWidth int32_t values
+//   NextDitherState, DitherNoise  as in simd_kernels.h, for every lane
+
+#if defined(__x86_64__)
+// Built with AVX2 enabled; only called once DetectSimdLevel has found AVX2.
+uint32_t VectorMixAvx2(const VectorMixFormat& format, const VectorMixJob& job);
+void VectorFirAvx2(const VectorFirJob& job);
+uint32_t VectorProduceAvx2(ProduceFormat format, const VectorProduceJob& job);
+#endif
+
+// Must match the LinearSampler's own constant (alpha is in 19.13 format).
+constexpr float kFramesPerPtsSubframe = 1.0f / (1 << kPtsFractionalBits);
+
+// Each loop iteration fills one vector with "mapped" values: the values that
+// SrcReader produces. Each mapped value feeds one dest sample, or for
+// mono->stereo, two adjacent ones.
+template <class Isa, size_t SrcChanCount, size_t DestChanCount>
+struct Block {
+  static constexpr size_t kMappedChans =
+      (SrcChanCount == DestChanCount) ? SrcChanCount : 1;
+  static constexpr uint32_t kFrames = Isa::kWidth / kMappedChans;
+};
+
+// Reads kWidth source samples from every |Step|'th frame starting at |src|.
+// This touches |Step| * kWidth samples, whichever frames are used.
+template <class Isa, size_t SrcChanCount, size_t Step, typename SrcSampleType>
+inline typename Isa::V LoadFrames(const SrcSampleType* src) {
+  static_assert(Step == 1 || Step == 2, "Unsupported source step");
+  if (Step == 1) {
+    return Isa::Load(src);
+  }
+  typename Isa::V first = Isa::Load(src);
+  typename Isa::V second = Isa::Load(src + Isa::kWidth);
+  return (SrcChanCount == 1) ? Isa::Evens(first, second)
+                             : Isa::EvenPairs(first, second);
+}
+
+// Reads a vector of mapped values for the frames starting at |src|.
+template <class Isa, typename SrcSampleType, size_t SrcChanCount,
+          size_t DestChanCount, size_t Step>
+inline typename Isa::V Fetch(const SrcSampleType* src) {
+  if ((SrcChanCount == 2) && (DestChanCount == 1)) {
+    typename Isa::V left_right = LoadFrames<Isa, SrcChanCount, Step>(src);
+    typename Isa::V more = LoadFrames<Isa, SrcChanCount, Step>(
+        src + Step * Isa::kWidth);
+    typename Isa::V sums = Isa::Add(Isa::Evens(left_right, more),
+                                    Isa::Odds(left_right, more));
+    return Isa::Mul(Isa::Splat(0.5f), sums);
+  }
+  return LoadFrames<Isa, SrcChanCount, Step>(src);
+}
+
+template <class Isa, bool Accumulate>
+inline float* Emit(float* dest, typename Isa::V val) {
+  if (Accumulate) {
+    val = Isa::Add(val, Isa::Load(dest));
+  }
+  Isa::Store(dest, val);
+  return dest + Isa::kWidth;
+}
+
+// The kernel itself. Each step mirrors one of the scalar mixer's operations:
+// SrcReader, then Interpolate (LinearSampler only), then SampleScaler, then
+// DestMixer.
+template <class Isa, typename SrcSampleType, size_t SrcChanCount,
+          size_t DestChanCount, bool Scale, bool Accumulate, bool Interpolate,
+          size_t Step>
+inline uint32_t Mix(const VectorMixJob& job) {
+  using V = typename Isa::V;
+  using B = Block<Isa, SrcChanCount, DestChanCount>;
+
+  // Each block reads its source frames whole, including any that a step of 2
+  // skips over, plus the next frame when interpolating. Only run blocks that
+  // can do so without reading past the end of the source.
+  constexpr uint32_t kSrcFramesPerBlock = B::kFrames * Step;
+  constexpr uint32_t kSrcSpan = kSrcFramesPerBlock + (Interpolate ? 1 : 0);
+  if (job.src_frames < kSrcSpan) {
+    return 0;
+  }
+  const uint32_t dest_blocks = job.frames / B::kFrames;
+  const uint32_t src_blocks =
+      (job.src_frames - kSrcSpan) / kSrcFramesPerBlock + 1;
+  const uint32_t blocks = (dest_blocks < src_blocks) ? dest_blocks : src_blocks;
+
+  const SrcSampleType* src = static_cast<const SrcSampleType*>(job.src);
+  const V scale = Isa::Splat(job.scale);
+  const V frames_per_subframe = Isa::Splat(kFramesPerPtsSubframe);
+  const V alpha = Isa::Splat(static_cast<float>(job.frac));
+  float* dest = job.dest;
+
+  for (uint32_t block = 0; block < blocks; ++block) {
+    V val = Fetch<Isa, SrcSampleType, SrcChanCount, DestChanCount, Step>(src);
+    if (Interpolate) {
+      V next = Fetch<Isa, SrcSampleType, SrcChanCount, DestChanCount, Step>(
+          src + SrcChanCount);
+      val = Isa::Add(
+          Isa::Mul(Isa::Mul(Isa::Sub(next, val), frames_per_subframe), alpha),
+          val);
+    }
+    if (Scale) {
+      val = Isa::Mul(scale, val);
+    }
+    if ((SrcChanCount == 1) && (DestChanCount == 2)) {
+      dest = Emit<Isa, Accumulate>(dest, Isa::ZipLo(val));
+      dest = Emit<Isa, Accumulate>(dest, Isa::ZipHi(val));
+    } else {
+      dest = Emit<Isa, Accumulate>(dest, val);
+    }
+    src += kSrcFramesPerBlock * SrcChanCount;
+  }
+
+  return blocks * B::kFrames;
+}
+
+// Turn each runtime format parameter into a template parameter, in turn.
+// Other integer steps are rare enough to leave to the scalar loops.
+template <class Isa, typename SrcSampleType, size_t SrcChanCount,
+          size_t DestChanCount, bool Scale, bool Accumulate, bool Interpolate>
+inline uint32_t SelectStep(const VectorMixJob& job) {
+  switch (job.src_step) {
+    case 1:
+      return Mix<Isa, SrcSampleType, SrcChanCount, DestChanCount, Scale,
+                 Accumulate, Interpolate, 1>(job);
+    case 2:
+      return Mix<Isa, SrcSampleType, SrcChanCount, DestChanCount, Scale,
+                 Accumulate, Interpolate, 2>(job);
+    default:
+      return 0;
+  }
+}
+
+template <class Isa, typename SrcSampleType, size_t SrcChanCount,
+          size_t DestChanCount, bool Scale, bool Accumulate>
+inline uint32_t SelectInterpolate(const VectorMixFormat& format,
+                                  const VectorMixJob& job) {
+  return format.interpolate
+             ? SelectStep<Isa, SrcSampleType, SrcChanCount, DestChanCount,
+                            Scale, Accumulate, true>(job)
+             : SelectStep<Isa, SrcSampleType, SrcChanCount, DestChanCount,
+                            Scale, Accumulate, false>(job);
+}
+
+template <class Isa, typename SrcSampleType, size_t SrcChanCount,
+          size_t DestChanCount, bool Scale>
+inline uint32_t SelectAccumulate(const VectorMixFormat& format,
+                                 const VectorMixJob& job) {
+  return format.accumulate
+             ? SelectInterpolate<Isa, SrcSampleType, SrcChanCount,
+                                 DestChanCount, Scale, true>(format, job)
+             : SelectInterpolate<Isa, SrcSampleType, SrcChanCount,
+                                 DestChanCount, Scale, false>(format, job);
+}
+
+template <class Isa, typename SrcSampleType, size_t SrcChanCount,
+          size_t DestChanCount>
+inline uint32_t SelectScale(const VectorMixFormat& format,
+                            const VectorMixJob& job) {
+  return format.scale ? SelectAccumulate<Isa, SrcSampleType, SrcChanCount,
+                                         DestChanCount, true>(format, job)
+                      : SelectAccumulate<Isa, SrcSampleType, SrcChanCount,
+                                         DestChanCount, false>(format, job);
+}
+
+template <class Isa, typename SrcSampleType, size_t SrcChanCount>
+inline uint32_t SelectDestChans(const VectorMixFormat& format,
+                                const VectorMixJob& job) {
+  switch (format.dest_chan_count) {
+    case 1:
+      return SelectScale<Isa, SrcSampleType, SrcChanCount, 1>(format, job);
+    case 2:
+      return SelectScale<Isa, SrcSampleType, SrcChanCount, 2>(format, job);
+    default:
+      return 0;
+  }
+}
+
+template <class Isa, typename SrcSampleType>
+inline uint32_t SelectSrcChans(const VectorMixFormat& format,
+                               const VectorMixJob& job) {
+  switch (format.src_chan_count) {
+    case 1:
+      return SelectDestChans<Isa, SrcSampleType, 1>(format, job);
+    case 2:
+      return SelectDestChans<Isa, SrcSampleType, 2>(format, job);
+    default:
+      return 0;
+  }
+}
+
+template <class Isa>
+inline uint32_t Dispatch(const VectorMixFormat& format,
+                         const VectorMixJob& job) {
+  return format.src_is_float ? SelectSrcChans<Isa, float>(format, job)
+                             : SelectSrcChans<Isa, int16_t>(format, job);
+}
+
+// The SincSampler's inner product, for |Chans| channels at once, so that each
+// interpolated coefficient is computed once and used for every channel.
+template <class Isa, size_t Chans>
+inline void Fir(const VectorFirJob& job, const float* const* src, float* out) {
+  using V = typename Isa::V;
+  static_assert(kVectorFirTapAlignment % Isa::kWidth == 0,
+                "FIR length is not a whole number of vectors");
+
+  const V frac = Isa::Splat(job.frac);
+  V acc[Chans];
+  for (size_t chan = 0; chan < Chans; ++chan) {
+    acc[chan] = Isa::Splat(0.0f);
+  }
+
+  for (size_t tap = 0; tap < job.taps; tap += Isa::kWidth) {
+    V coef = Isa::Load(job.coefs + tap);
+    coef = Isa::Add(
+        Isa::Mul(Isa::Sub(Isa::Load(job.next_coefs + tap), coef), frac), coef);
+    for (size_t chan = 0; chan < Chans; ++chan) {
+      acc[chan] =
+          Isa::Add(acc[chan], Isa::Mul(coef, Isa::Load(src[chan] + tap)));
+    }
+  }
+
+  for (size_t chan = 0; chan < Chans; ++chan) {
+    out[chan] = Isa::Sum(acc[chan]);
+  }
+}
+
+template <class Isa>
+inline void DispatchFir(const VectorFirJob& job) {
+  switch (job.chans) {
+    case 1:
+      Fir<Isa, 1>(job, job.src, job.out);
+      break;
+    case 2:
+      Fir<Isa, 2>(job, job.src, job.out);
+      break;
+    default:
+      for (size_t chan = 0; chan < job.chans; ++chan) {
+        Fir<Isa, 1>(job, job.src + chan, job.out + chan);
+      }
+      break;
+  }
+}
+
+// How DestConverter maps normalized values into one output format.
+struct ProduceParams {
+  float scale;
+  float min;  // Clamp limits, in scaled units.
+  float max;
+  float dither_scale;
+};
+
+// Converts whole blocks of kDitherLanes samples, so that sample N always takes
+// its noise from generator N % kDitherLanes. Each step mirrors DestConverter:
+// scale, add dither, then clamp and round. Clamping before rounding gives the
+// same result, and keeps out-of-range values within reach of an int32.
+template <class Isa, ProduceFormat Format, bool Dither>
+inline uint32_t Produce(const VectorProduceJob& job,
+                        const ProduceParams& params) {
+  using V = typename Isa::V;
+  using VI = typename Isa::VI;
+  static_assert(kDitherLanes % Isa::kWidth == 0,
+                "Dither block is not a whole number of vectors");
+  constexpr size_t kParts = kDitherLanes / Isa::kWidth;
+
+  const V scale = Isa::Splat(params.scale);
+  const V min = Isa::Splat(params.min);
+  const V max = Isa::Splat(params.max);
+  const V dither_scale = Isa::Splat(params.dither_scale);
+
+  VI state[kParts];
+  if (Dither) {
+    for (size_t part = 0; part < kParts; ++part) {
+      state[part] = Isa::LoadInt(job.dither + part * Isa::kWidth);
+    }
+  }
+
+  const uint32_t blocks = job.samples / kDitherLanes;
+  for (uint32_t block = 0; block < blocks; ++block) {
+    for (size_t part = 0; part < kParts; ++part) {
+      const size_t idx = block * kDitherLanes + part * Isa::kWidth;
+      V val = Isa::Load(job.src + idx);
+      if (Format != ProduceFormat::Float) {
+        val = Isa::Mul(val, scale);
+      }
+      if (Dither) {
+        state[part] = Isa::NextDitherState(state[part]);
+        V noise = Isa::Mul(Isa::ToFloat(Isa::DitherNoise(state[part])),
+                           dither_scale);
+        val = Isa::Add(val, noise);
+      }
+      val = Isa::Min(max, Isa::Max(min, val));
+
+      switch (Format) {
+        case ProduceFormat::Int16:
+          Isa::StoreInt16(static_cast<int16_t*>(job.dest) + idx,
+                          Isa::RoundToInt(val));
+          break;
+        case ProduceFormat::Int24In32:
+          Isa::StoreInt32(static_cast<int32_t*>(job.dest) + idx,
+                          Isa::RoundToInt(val));
+          break;
+        case ProduceFormat::Float:
+          Isa::Store(static_cast<float*>(job.dest) + idx, val);
+          break;
+      }
+    }
+  }
+
+  if (Dither) {
+    for (size_t part = 0; part < kParts; ++part) {
+      Isa::StoreInt(job.dither + part * Isa::kWidth, state[part]);
+    }
+  }
+  return blocks * kDitherLanes;
+}
+
+template <class Isa, ProduceFormat Format>
+inline uint32_t SelectDither(const VectorProduceJob& job,
+                             const ProduceParams& params) {
+  return job.dither ? Produce<Isa, Format, true>(job, params)
+                    : Produce<Isa, Format, false>(job, params);
+}
+
+template <class Isa>
+inline uint32_t DispatchProduce(ProduceFormat format,
+                                const VectorProduceJob& job) {
+  switch (format) {
+    case ProduceFormat::Int16:
+      return SelectDither<Isa, ProduceFormat::Int16>(
+          job, {static_cast<float>(kFloatToInt16),
+                std::numeric_limits<int16_t>::min(),
+                std::numeric_limits<int16_t>::max(), kDitherScale});
+    case ProduceFormat::Int24In32:
+      return SelectDither<Isa, ProduceFormat::Int24In32>(
+          job, {static_cast<float>(kFloatToInt24In32),
+                static_cast<float>(kMinInt24In32),
+                static_cast<float>(kMaxInt24In32), kDitherScaleInt24In32});
+    case ProduceFormat::Float:
+      return Produce<Isa, ProduceFormat::Float, false>(
+          job, {1.0f, -1.0f, 1.0f, 0.0f});
+  }
+  return 0;
+}
+
+}  // namespace simd
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
+
+#endif  // GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SIMD_KERNELS_IMPL_H_
@@ -0,0 +1,557 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/media/audio_core/mixer/sinc_sampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "garnet/bin/media/audio_core/mixer/constants.h"
+#include "garnet/bin/media/audio_core/mixer/mixer_utils.h"
+#include "garnet/bin/media/audio_core/mixer/simd_kernels.h"
+#include "lib/fxl/logging.h"
+#include "lib/media/timeline/timeline_rate.h"
+
+namespace media {
+namespace audio {
+namespace mixer {
+
+namespace {
+
+// The filter reaches this many source frames to either side of each sampling
+// position, when upsampling or at unity rate. When downsampling it widens in
+// proportion, so that its cutoff and transition band (relative to the
+// destination rate) stay the same -- up to kMaxHalfWidth.
+constexpr uint32_t kHalfWidth = 32;
+constexpr uint32_t kMaxHalfWidth = 256;
+
+// The Kaiser window is designed for this much stopband attenuation. The
+// transition band is then as narrow as the filter length allows, and ends at
+// the Nyquist frequency of the lower of the two rates.
+constexpr double kStopbandAttenuationDb = 100.0;
+
+// The coefficient table holds this many rows per source frame. Positions
+// between rows (our positions have kPtsFractionalBits of precision) use
+// coefficients interpolated from the two rows on either side.
+constexpr uint32_t kPhaseBits = 9;
+constexpr uint32_t kPhases = 1u << kPhaseBits;
+constexpr uint32_t kPhaseShift = kPtsFractionalBits - kPhaseBits;
+constexpr uint32_t kPhaseFracMask = (1u << kPhaseShift) - 1;
+constexpr float kPhasesPerPhaseFrac = 1.0f / (1u << kPhaseShift);
+
+// Source frames are converted into planar float buffers before filtering, in
+// runs of up to this many frames beyond the length of the filter itself.
+constexpr uint32_t kStageFrames = 256;
+
+static_assert(kPhaseBits <= kPtsFractionalBits,
+              "Filter has more phases than sampling positions");
+
+// Modified Bessel function of the first kind, order zero (for the window).
+double BesselI0(double x) {
+  double sum = 1.0, term = 1.0;
+  for (int k = 1; term > sum * 1e-12; ++k) {
+    term *= (x * x) / (4.0 * k * k);
+    sum += term;
+  }
+  return sum;
+}
+
+// The position (in source frames) of a 19.13 source position, rounded down.
+inline int32_t FloorFrame(int32_t frac_pos) {
+  return (frac_pos >= 0)
+             ? (frac_pos >> kPtsFractionalBits)
+             : -static_cast<int32_t>(
+                   (-static_cast<int64_t>(frac_pos) + Mixer::FRAC_MASK) >>
+                   kPtsFractionalBits);
+}
+
+//
+// SincFilter
+//
+// A coefficient table for one source:destination rate ratio. Row p holds the
+// filter's taps for sampling position (S + p/kPhases), where S is an integer
+// source frame; tap k applies to source frame (S - half_width + 1 + k). The
+// table has kPhases + 1 rows so that every position lies between two of them.
+class SincFilter {
+ public:
+  // Returns the table for this ratio, sharing it with any other mixers that
+  // are currently using the same one.
+  static std::shared_ptr<const SincFilter> Get(uint32_t src_rate,
+                                               uint32_t dest_rate);
+
+  uint32_t half_width() const { return half_width_; }
+  uint32_t taps() const { return 2 * half_width_; }
+  const float* row(uint32_t phase) const {
+    return coefs_.data() + (phase * taps());
+  }
+
+ private:
+  SincFilter(uint32_t src_rate, uint32_t dest_rate);
+
+  uint32_t half_width_;
+  std::vector<float> coefs_;
+};
+
+SincFilter::SincFilter(uint32_t src_rate, uint32_t dest_rate) {
+  // When downsampling, the cutoff (relative to the source rate) falls with the
+  // rate ratio, and the filter lengthens to keep the same transition band.
+  double ratio = std::min(1.0, static_cast<double>(dest_rate) / src_rate);
+  double half_width = std::min<double>(std::ceil(kHalfWidth / ratio),
+                                       kMaxHalfWidth);
+  // Keep the number of taps a multiple of the vector kernels' alignment.
+  constexpr uint32_t kAlign = kVectorFirTapAlignment / 2;
+  half_width_ = ((static_cast<uint32_t>(half_width) + kAlign - 1) / kAlign) *
+                kAlign;
+
+  // Kaiser's estimates of the window shape and transition bandwidth (in cycles
+  // per source frame) that achieve the requested stopband attenuation.
+  double beta = 0.1102 * (kStopbandAttenuationDb - 8.7);
+  double transition =
+      (kStopbandAttenuationDb - 7.95) / (14.36 * 2.0 * half_width_);
+  double cutoff = std::max(0.5 * ratio - 0.5 * transition, 0.5 * ratio * 0.5);
+  double window_scale = 1.0 / BesselI0(beta);
+
+  uint32_t taps = 2 * half_width_;
+  coefs_.resize((kPhases + 1) * taps);
+  std::vector<double> row(taps);
+  for (uint32_t phase = 0; phase <= kPhases; ++phase) {
+    double sum = 0.0;
+    for (uint32_t tap = 0; tap < taps; ++tap) {
+      // Distance (in source frames) from the sampling position to this tap.
+      double dist = static_cast<double>(tap) - (half_width_ - 1) -
+                    static_cast<double>(phase) / kPhases;
+      double x = dist / half_width_;
+      if (x <= -1.0 || x >= 1.0) {
+        row[tap] = 0.0;
+        continue;
+      }
+      double arg = 2.0 * cutoff * dist;
+      double sinc = (arg == 0.0) ? 1.0 : std::sin(M_PI * arg) / (M_PI * arg);
+      double window = BesselI0(beta * std::sqrt(1.0 - x * x)) * window_scale;
+      row[tap] = 2.0 * cutoff * sinc * window;
+      sum += row[tap];
+    }
+
+    // Normalize each row to unity gain at DC, so that every sampling position
+    // passes low frequencies at exactly the same level.
+    float* dest = coefs_.data() + (phase * taps);
+    for (uint32_t tap = 0; tap < taps; ++tap) {
+      dest[tap] = static_cast<float>(row[tap] / sum);
+    }
+  }
+}
+
+std::shared_ptr<const SincFilter> SincFilter::Get(uint32_t src_rate,
+                                                  uint32_t dest_rate) {
+  static std::mutex lock;
+  static std::map<std::pair<uint32_t, uint32_t>,
+                  std::weak_ptr<const SincFilter>>
+      filters;
+
+  TimelineRate::Reduce(&src_rate, &dest_rate);
+  auto key = std::make_pair(src_rate, dest_rate);
+
+  std::lock_guard<std::mutex> guard(lock);
+  std::shared_ptr<const SincFilter> filter = filters[key].lock();
+  if (!filter) {
+    // Drop any tables that are no longer in use, then build this one.
+    for (auto iter = filters.begin(); iter != filters.end();) {
+      iter = iter->second.expired() ? filters.erase(iter) : std::next(iter);
+    }
+    filter.reset(new SincFilter(src_rate, dest_rate));
+    filters[key] = filter;
+  }
+  return filter;
+}
+
+}  // namespace
+
+// Unlike the point and linear samplers, channel configuration is a runtime
+// parameter here: the cost of this mixer lies in its inner products, which run
+// over planar copies of the source in any case.
+template <typename SrcSampleType>
+class SincSamplerImpl : public SincSampler {
+ public:
+  SincSamplerImpl(std::shared_ptr<const SincFilter> filter, size_t src_chans,
+                  size_t dest_chans)
+      : SincSampler(filter->half_width() * FRAC_ONE - 1,
+                    filter->half_width() * FRAC_ONE - 1),
+        filter_(std::move(filter)),
+        half_width_(filter_->half_width()),
+        taps_(filter_->taps()),
+        src_chans_(src_chans),
+        dest_chans_(dest_chans),
+        mapped_chans_((src_chans == dest_chans) ? src_chans : 1),
+        history_frames_(2 * half_width_),
+        stage_frames_(taps_ + kStageFrames) {
+    history_ = std::make_unique<float[]>(mapped_chans_ * history_frames_);
+    stage_ = std::make_unique<float[]>(mapped_chans_ * stage_frames_);
+    Reset();
+  }
+
+  bool Mix(float* dest, uint32_t dest_frames, uint32_t* dest_offset,
+           const void* src, uint32_t frac_src_frames, int32_t* frac_src_offset,
+           bool accumulate, Bookkeeping* info) override;
+
+  // If/when Bookkeeping is included in this class, clear src_pos_modulo here.
+  void Reset() override {
+    ::memset(history_.get(), 0,
+             mapped_chans_ * history_frames_ * sizeof(history_[0]));
+  }
+
+ private:
+  template <ScalerType ScaleType, bool DoAccumulate, bool HasModulo>
+  inline bool Mix(float* dest, uint32_t dest_frames, uint32_t* dest_offset,
+                  const void* src, uint32_t frac_src_frames,
+                  int32_t* frac_src_offset, Bookkeeping* info);
+
+  // Reads one source frame's contribution to each filtered ("mapped") channel.
+  // Like SrcReader, this averages stereo into mono.
+  inline void ReadMapped(const SrcSampleType* frame, float* stage,
+                         size_t stride) const;
+
+  // Fills the stage with source frames [first, first + count), relative to the
+  // start of this source buffer: earlier frames come from the history, and
+  // frames beyond the end of the buffer are zero.
+  void Stage(const SrcSampleType* src, uint32_t src_frames, int32_t first,
+             uint32_t count);
+
+  // Keeps the final frames of a fully consumed source buffer (or silence, if
+  // muted) for use by sampling positions just after it.
+  void UpdateHistory(const SrcSampleType* src, uint32_t src_frames, bool muted);
+
+  std::shared_ptr<const SincFilter> filter_;
+  const uint32_t half_width_;
+  const uint32_t taps_;
+  const size_t src_chans_;
+  const size_t dest_chans_;
+  const size_t mapped_chans_;
+  const uint32_t history_frames_;
+  const uint32_t stage_frames_;
+
+  // Both are planar: each mapped channel's frames are contiguous.
+  std::unique_ptr<float[]> history_;
+  std::unique_ptr<float[]> stage_;
+};
+
+template <typename SrcSampleType>
+inline void SincSamplerImpl<SrcSampleType>::ReadMapped(
+    const SrcSampleType* frame, float* stage, size_t stride) const {
+  using SN = SampleNormalizer<SrcSampleType>;
+  if (src_chans_ == 2 && dest_chans_ == 1) {
+    *stage = 0.5f * (SN::Read(frame) + SN::Read(frame + 1));
+    return;
+  }
+  for (size_t chan = 0; chan < mapped_chans_; ++chan) {
+    stage[chan * stride] = SN::Read(frame + chan);
+  }
+}
+
+template <typename SrcSampleType>
+void SincSamplerImpl<SrcSampleType>::Stage(const SrcSampleType* src,
+                                           uint32_t src_frames, int32_t first,
+                                           uint32_t count) {
+  FXL_DCHECK(first >= -static_cast<int32_t>(history_frames_));
+  FXL_DCHECK(count <= stage_frames_);
+
+  int32_t end = first + static_cast<int32_t>(count);
+  int32_t frame = first;
+  for (; frame < std::min(end, 0); ++frame) {
+    for (size_t chan = 0; chan < mapped_chans_; ++chan) {
+      stage_[chan * stage_frames_ + (frame - first)] =
+          history_[chan * history_frames_ + (history_frames_ + frame)];
+    }
+  }
+  for (; frame < std::min(end, static_cast<int32_t>(src_frames)); ++frame) {
+    ReadMapped(src + frame * src_chans_, &stage_[frame - first],
+               stage_frames_);
+  }
+  for (; frame < end; ++frame) {
+    for (size_t chan = 0; chan < mapped_chans_; ++chan) {
+      stage_[chan * stage_frames_ + (frame - first)] = 0.0f;
+    }
+  }
+}
+
+template <typename SrcSampleType>
+void SincSamplerImpl<SrcSampleType>::UpdateHistory(const SrcSampleType* src,
+                                                   uint32_t src_frames,
+                                                   bool muted) {
+  // A buffer shorter than the history only displaces part of it.
+  uint32_t kept = (src_frames < history_frames_)
+                      ? (history_frames_ - src_frames)
+                      : 0;
+  for (size_t chan = 0; chan < mapped_chans_; ++chan) {
+    float* history = &history_[chan * history_frames_];
+    ::memmove(history, history + (history_frames_ - kept),
+              kept * sizeof(history[0]));
+    if (muted) {
+      std::fill(history + kept, history + history_frames_, 0.0f);
+    }
+  }
+  if (muted) {
+    return;
+  }
+
+  const SrcSampleType* frame =
+      src + (src_frames - (history_frames_ - kept)) * src_chans_;
+  for (uint32_t idx = kept; idx < history_frames_; ++idx) {
+    ReadMapped(frame, &history_[idx], history_frames_);
+    frame += src_chans_;
+  }
+}
+
+// If upper layers call with ScaleType MUTED, they must set DoAccumulate=TRUE.
+// They guarantee new buffers are cleared before usage; we optimize accordingly.
+template <typename SrcSampleType>
+template <ScalerType ScaleType, bool DoAccumulate, bool HasModulo>
+inline bool SincSamplerImpl<SrcSampleType>::Mix(
+    float* dest, uint32_t dest_frames, uint32_t* dest_offset,
+    const void* src_void, uint32_t frac_src_frames, int32_t* frac_src_offset,
+    Bookkeeping* info) {
+  static_assert(
+      ScaleType != ScalerType::MUTED || DoAccumulate == true,
+      "Mixing muted streams without accumulation is explicitly unsupported");
+
+  // Although the number of source frames is expressed in fixed-point 19.13
+  // format, the actual number of frames must always be an integer.
+  FXL_DCHECK((frac_src_frames & kPtsFractionalMask) == 0);
+  FXL_DCHECK(frac_src_frames >= FRAC_ONE);
+  // Interpolation offset is int32, so even though frac_src_frames is a uint32,
+  // callers should not exceed int32_t::max().
+  FXL_DCHECK(frac_src_frames <=
+             static_cast<uint32_t>(std::numeric_limits<int32_t>::max()));
+
+  using DM = DestMixer<ScaleType, DoAccumulate>;
+  const SrcSampleType* src = static_cast<const SrcSampleType*>(src_void);
+  const uint32_t src_frames = frac_src_frames >> kPtsFractionalBits;
+  uint32_t dest_off = *dest_offset;
+  int32_t src_off = *frac_src_offset;
+
+  // Cache these locally, in the template specialization that uses them.
+  // Only src_pos_modulo needs to be written back before returning.
+  uint32_t step_size = info->step_size;
+  uint32_t rate_modulo, denominator, src_pos_modulo;
+  if (HasModulo) {
+    rate_modulo = info->rate_modulo;
+    denominator = info->denominator;
+    src_pos_modulo = info->src_pos_modulo;
+
+    FXL_DCHECK(denominator > 0);
+    FXL_DCHECK(denominator > rate_modulo);
+    FXL_DCHECK(denominator > src_pos_modulo);
+  }
+
+  // "Source end" is the last sub-frame that can be sampled without more data.
+  // With a filter this wide, it is negative if the buffer is short enough.
+  int32_t src_end =
+      static_cast<int32_t>(frac_src_frames - pos_filter_width() - 1);
+
+  FXL_DCHECK(dest_off < dest_frames);
+  // "Source offset" can be negative, but within the bounds of pos_filter_width.
+  // Otherwise, all these samples are in the future and irrelevant here. Callers
+  // explicitly avoid calling Mix in this case, so we have detected an error.
+  FXL_DCHECK(src_off + static_cast<int32_t>(pos_filter_width()) >= 0);
+  // Source offset must also be within neg_filter_width of our last sample.
+  // Otherwise, all these samples are in the past and irrelevant here. Callers
+  // explicitly avoid calling Mix in this case, so we have detected an error.
+  FXL_DCHECK(static_cast<int64_t>(src_off) + FRAC_ONE <=
+             static_cast<int64_t>(frac_src_frames) + neg_filter_width());
+
+  Gain::AScale amplitude_scale = info->gain.GetGainScale();
+
+  // If we are not attenuated to the point of being muted, go ahead and perform
+  // the mix.  Otherwise, just update the source and dest offsets and hold onto
+  // any relevant filter data from the end of the source.
+  if (ScaleType != ScalerType::MUTED) {
+    const size_t dest_per_mapped = dest_chans_ / mapped_chans_;
+    const float* tap_src[fuchsia::media::MAX_PCM_CHANNEL_COUNT];
+    float filtered[fuchsia::media::MAX_PCM_CHANNEL_COUNT];
+
+    VectorFirJob job;
+    job.src = tap_src;
+    job.chans = mapped_chans_;
+    job.taps = taps_;
+    job.out = filtered;
+
+    while ((dest_off < dest_frames) && (src_off <= src_end)) {
+      // Stage the source frames that the coming output frames will need,
+      // starting with the first tap of the next one. We produce at most one
+      // output frame per step_size (plus one, with a rate modulo).
+      int32_t first = FloorFrame(src_off) - half_width_ + 1;
+      int64_t last_pos =
+          src_off + static_cast<int64_t>(dest_frames - dest_off - 1) *
+                        (step_size + (HasModulo ? 1 : 0));
+      int64_t last = FloorFrame(std::min<int64_t>(last_pos, src_end)) +
+                     half_width_;
+      uint32_t count = std::min<int64_t>(stage_frames_, last - first + 1);
+      Stage(src, src_frames, first, count);
+      int32_t stage_end = first + static_cast<int32_t>(count);
+
+      while ((dest_off < dest_frames) && (src_off <= src_end)) {
+        int32_t first_tap = FloorFrame(src_off) - half_width_ + 1;
+        if (first_tap + static_cast<int32_t>(taps_) > stage_end) {
+          break;
+        }
+
+        uint32_t frac = src_off & FRAC_MASK;
+        job.coefs = filter_->row(frac >> kPhaseShift);
+        job.next_coefs = job.coefs + taps_;
+        job.frac = (frac & kPhaseFracMask) * kPhasesPerPhaseFrac;
+        for (size_t chan = 0; chan < mapped_chans_; ++chan) {
+          tap_src[chan] = &stage_[chan * stage_frames_ + (first_tap - first)];
+        }
+        VectorFir(job);
+
+        float* out = dest + (dest_off * dest_chans_);
+        for (size_t D = 0; D < dest_chans_; ++D) {
+          out[D] = DM::Mix(out[D], filtered[D / dest_per_mapped],
+                           amplitude_scale);
+        }
+
+        dest_off += 1;
+        src_off += step_size;
+
+        if (HasModulo) {
+          src_pos_modulo += rate_modulo;
+          if (src_pos_modulo >= denominator) {
+            ++src_off;
+            src_pos_modulo -= denominator;
+          }
+        }
+      }
+    }
+  } else {
+    // We are muted. Don't mix, but figure out how many samples we WOULD have
+    // produced and update the src_off and dest_off values appropriately.
+    if ((dest_off < dest_frames) && (src_off <= src_end)) {
+      uint32_t src_avail = ((src_end - src_off) / step_size) + 1;
+      uint32_t dest_avail = (dest_frames - dest_off);
+      uint32_t avail = std::min(src_avail, dest_avail);
+
+      dest_off += avail;
+      src_off += avail * step_size;
+
+      if (HasModulo) {
+        src_pos_modulo += (rate_modulo * avail);
+        src_off += (src_pos_modulo / denominator);
+        src_pos_modulo %= denominator;
+      }
+    }
+  }
+
+  // Update all our returned in-out parameters
+  *dest_offset = dest_off;
+  *frac_src_offset = src_off;
+  if (HasModulo) {
+    info->src_pos_modulo = src_pos_modulo;
+  }
+
+  // If next source position to consume is beyond our last sampleable position,
+  // the filter has what it needs from this buffer: keep its final frames for
+  // the positions that straddle it and the next buffer, and return TRUE.
+  if (src_off > src_end) {
+    UpdateHistory(src, src_frames, ScaleType == ScalerType::MUTED);
+    return true;
+  }
+
+  // We have not exhausted this source buffer -- return FALSE.
+  return false;
+}
+
+template <typename SrcSampleType>
+bool SincSamplerImpl<SrcSampleType>::Mix(
+    float* dest, uint32_t dest_frames, uint32_t* dest_offset, const void* src,
+    uint32_t frac_src_frames, int32_t* frac_src_offset, bool accumulate,
+    Bookkeeping* info) {
+  FXL_DCHECK(info != nullptr);
+
+  bool hasModulo = (info->denominator > 0 && info->rate_modulo > 0);
+
+  if (info->gain.IsUnity()) {
+    return accumulate
+               ? (hasModulo ? Mix<ScalerType::EQ_UNITY, true, true>(
+                                  dest, dest_frames, dest_offset, src,
+                                  frac_src_frames, frac_src_offset, info)
+                            : Mix<ScalerType::EQ_UNITY, true, false>(
+                                  dest, dest_frames, dest_offset, src,
+                                  frac_src_frames, frac_src_offset, info))
+               : (hasModulo ? Mix<ScalerType::EQ_UNITY, false, true>(
+                                  dest, dest_frames, dest_offset, src,
+                                  frac_src_frames, frac_src_offset, info)
+                            : Mix<ScalerType::EQ_UNITY, false, false>(
+                                  dest, dest_frames, dest_offset, src,
+                                  frac_src_frames, frac_src_offset, info));
+  } else if (info->gain.IsSilent()) {
+    return (hasModulo ? Mix<ScalerType::MUTED, true, true>(
+                            dest, dest_frames, dest_offset, src,
+                            frac_src_frames, frac_src_offset, info)
+                      : Mix<ScalerType::MUTED, true, false>(
+                            dest, dest_frames, dest_offset, src,
+                            frac_src_frames, frac_src_offset, info));
+  } else {
+    return accumulate
+               ? (hasModulo ? Mix<ScalerType::NE_UNITY, true, true>(
+                                  dest, dest_frames, dest_offset, src,
+                                  frac_src_frames, frac_src_offset, info)
+                            : Mix<ScalerType::NE_UNITY, true, false>(
+                                  dest, dest_frames, dest_offset, src,
+                                  frac_src_frames, frac_src_offset, info))
+               : (hasModulo ? Mix<ScalerType::NE_UNITY, false, true>(
+                                  dest, dest_frames, dest_offset, src,
+                                  frac_src_frames, frac_src_offset, info)
+                            : Mix<ScalerType::NE_UNITY, false, false>(
+                                  dest, dest_frames, dest_offset, src,
+                                  frac_src_frames, frac_src_offset, info));
+  }
+}
+
+MixerPtr SincSampler::Select(
+    const fuchsia::media::AudioStreamType& src_format,
+    const fuchsia::media::AudioStreamType& dest_format) {
+  uint32_t src_chans = src_format.channels;
+  uint32_t dest_chans = dest_format.channels;
+  if ((src_chans == 0) || (dest_chans == 0) ||
+      (src_chans > fuchsia::media::MAX_PCM_CHANNEL_COUNT) ||
+      (dest_chans > fuchsia::media::MAX_PCM_CHANNEL_COUNT)) {
+    return nullptr;
+  }
+  if ((src_chans != dest_chans) && !(src_chans == 1 && dest_chans == 2) &&
+      !(src_chans == 2 && dest_chans == 1)) {
+    return nullptr;
+  }
+  if ((src_format.frames_per_second == 0) ||
+      (dest_format.frames_per_second == 0)) {
+    return nullptr;
+  }
+
+  auto filter = SincFilter::Get(src_format.frames_per_second,
+                                dest_format.frames_per_second);
+
+  switch (src_format.sample_format) {
+    case fuchsia::media::AudioSampleFormat::UNSIGNED_8:
+      return MixerPtr(
+          new SincSamplerImpl<uint8_t>(filter, src_chans, dest_chans));
+    case fuchsia::media::AudioSampleFormat::SIGNED_16:
+      return MixerPtr(
+          new SincSamplerImpl<int16_t>(filter, src_chans, dest_chans));
+    case fuchsia::media::AudioSampleFormat::SIGNED_24_IN_32:
+      return MixerPtr(
+          new SincSamplerImpl<int32_t>(filter, src_chans, dest_chans));
+    case fuchsia::media::AudioSampleFormat::FLOAT:
+      return MixerPtr(
+          new SincSamplerImpl<float>(filter, src_chans, dest_chans));
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
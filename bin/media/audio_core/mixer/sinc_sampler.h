@@ -0,0 +1,34 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SINC_SAMPLER_H_
+#define GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SINC_SAMPLER_H_
+
+#include <fuchsia/media/cpp/fidl.h>
+
+#include "garnet/bin/media/audio_core/mixer/mixer.h"
+
+namespace media {
+namespace audio {
+namespace mixer {
+
+// SincSampler resamples with a Kaiser-windowed sinc (polyphase FIR) filter,
+// which removes the aliasing and imaging that LinearSampler lets through, at a
+// higher CPU cost. Its filter spans many source frames on either side of each
+// sampling position, so its pos_filter_width and neg_filter_width are large.
+class SincSampler : public Mixer {
+ public:
+  static MixerPtr Select(const fuchsia::media::AudioStreamType& src_format,
+                         const fuchsia::media::AudioStreamType& dest_format);
+
+ protected:
+  SincSampler(uint32_t pos_filter_width, uint32_t neg_filter_width)
+      : Mixer(pos_filter_width, neg_filter_width) {}
+};
+
+}  // namespace mixer
+}  // namespace audio
+}  // namespace media
+
+#endif  // GARNET_BIN_MEDIA_AUDIO_CORE_MIXER_SINC_SAMPLER_H_
@@ -2,8 +2,14 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <functional>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "garnet/bin/media/audio_core/mixer/duration_histogram.h"
+#include "garnet/bin/media/audio_core/mixer/mix_scheduler.h"
+#include "garnet/bin/media/audio_core/mixer/simd_kernels.h"
 #include "garnet/bin/media/audio_core/mixer/test/audio_performance.h"
 #include "garnet/bin/media/audio_core/mixer/test/frequency_set.h"
 #include "garnet/bin/media/audio_core/mixer/test/mixer_tests_shared.h"
@@ -20,7 +26,11 @@ void AudioPerformance::Profile() {
   printf("\n\n Performance Profiling");
 
   AudioPerformance::ProfileMixers();
+  AudioPerformance::ProfileVectorKernels();
+  AudioPerformance::ProfileMixScheduler();
   AudioPerformance::ProfileOutputProducers();
+  AudioPerformance::ProfileOutputKernels();
+  AudioPerformance::ProfileOutputSources();
 }
 
 void AudioPerformance::ProfileMixers() {
@@ -130,6 +140,162 @@ void AudioPerformance::ProfileSamplerChansRateScaleMix(
                       source_rate, gain_db, accumulate);
 }
 
+// Profile the configurations that the samplers hand to vector kernels, with
+// each instruction set this CPU supports. SimdLevel None is the scalar loops.
+void AudioPerformance::ProfileVectorKernels() {
+  using mixer::SimdLevel;
+  zx_time_t start_time = zx_clock_get(ZX_CLOCK_MONOTONIC);
+
+  DisplayMixerConfigLegend();
+
+  for (SimdLevel level : {SimdLevel::None, SimdLevel::Sse2, SimdLevel::Avx2,
+                          SimdLevel::Neon}) {
+    if (!mixer::SetSimdLevel(level)) {
+      continue;
+    }
+    printf("\n   Vector kernels: %s\n", mixer::SimdLevelName(level));
+    DisplayMixerColumnHeader();
+
+    for (Resampler sampler_type :
+         {Resampler::SampleAndHold, Resampler::LinearInterpolation}) {
+      for (uint32_t num_input_chans : {1, 2}) {
+        for (uint32_t num_output_chans : {1, 2}) {
+          for (uint32_t source_rate : {48000, 96000}) {
+            for (float gain_db : {0.0f, -42.68f}) {
+              ProfileMixer<int16_t>(num_input_chans, num_output_chans,
+                                    sampler_type, source_rate, gain_db, true);
+              ProfileMixer<float>(num_input_chans, num_output_chans,
+                                  sampler_type, source_rate, gain_db, true);
+            }
+          }
+        }
+      }
+    }
+  }
+  mixer::SetSimdLevel(mixer::DetectSimdLevel());
+
+  printf("\n   Total time to profile vector kernels: %lu ms\n   --------\n\n",
+         (zx_clock_get(ZX_CLOCK_MONOTONIC) - start_time) / 1000000);
+}
+
+// Mix many renderers into one output, one mix period at a time, spreading the
+// renderers across different numbers of mix threads.
+void AudioPerformance::ProfileMixScheduler() {
+  zx_time_t start_time = zx_clock_get(ZX_CLOCK_MONOTONIC);
+
+  printf(
+      "\n   Elapsed time in microsec to mix 64 renderers into a 10-msec, 48k "
+      "stereo mix period\n\n");
+  printf("Threads\t    Mean\t   First\t    Best\t   Worst\t     P50\t     P99"
+         "\tRend P99\n");
+
+  for (uint32_t num_threads : {1, 2, 3, 4}) {
+    ProfileMixSchedulerThreads(num_threads);
+  }
+
+  printf(
+      "\n   P50 and P99 are upper bounds from the mix-time histogram, which an "
+      "output keeps\n   for each mix job. Rend P99 is the worst of the "
+      "histograms kept for each renderer.\n");
+  printf("\n   Total time to profile MixScheduler: %lu ms\n   --------\n\n",
+         (zx_clock_get(ZX_CLOCK_MONOTONIC) - start_time) / 1000000);
+}
+
+void AudioPerformance::ProfileMixSchedulerThreads(uint32_t num_threads) {
+  constexpr uint32_t kNumRenderers = 64;
+  constexpr uint32_t kDestRate = 48000;
+  constexpr uint32_t kDestChans = 2;
+  constexpr uint32_t kMixFrames = kDestRate / 100;
+
+  // A spread of the formats and rates that renderers commonly use.
+  struct Renderer {
+    MixerPtr mixer;
+    Bookkeeping info;
+    std::vector<float> source;
+    uint32_t frac_src_frames;
+  };
+  std::vector<Renderer> renderers(kNumRenderers);
+  for (uint32_t idx = 0; idx < kNumRenderers; ++idx) {
+    Renderer& renderer = renderers[idx];
+    uint32_t source_rate = (idx % 4 == 1) ? 44100 : (idx % 4 == 3) ? 96000
+                                                                   : 48000;
+    uint32_t source_chans = (idx % 4 == 2) ? 1 : 2;
+    renderer.mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT,
+                                 source_chans, source_rate, kDestChans,
+                                 kDestRate, Resampler::Default);
+
+    uint32_t source_frames = (kMixFrames * source_rate / kDestRate) + 1;
+    renderer.source.resize(source_frames * source_chans);
+    OverwriteCosine(renderer.source.data(), renderer.source.size(),
+                    static_cast<double>(idx + 1));
+    renderer.frac_src_frames = source_frames * Mixer::FRAC_ONE;
+
+    Bookkeeping& info = renderer.info;
+    info.step_size = (source_rate * Mixer::FRAC_ONE) / kDestRate;
+    info.denominator = kDestRate;
+    info.rate_modulo =
+        (source_rate * Mixer::FRAC_ONE) - (info.step_size * kDestRate);
+    info.gain.SetSourceGain(-12.0f);
+  }
+
+  mixer::MixScheduler scheduler(num_threads);
+  scheduler.SetMaxSamples(kMixFrames * kDestChans);
+  std::unique_ptr<float[]> accum =
+      std::make_unique<float[]>(kMixFrames * kDestChans);
+
+  auto mix_renderer = [&renderers](uint32_t index, float* dest) {
+    Renderer& renderer = renderers[index];
+    zx_time_t start_time = zx_clock_get(ZX_CLOCK_MONOTONIC);
+
+    uint32_t dest_offset = 0;
+    int32_t frac_src_offset = 0;
+    renderer.info.src_pos_modulo = 0;
+    renderer.mixer->Mix(dest, kMixFrames, &dest_offset,
+                        renderer.source.data(), renderer.frac_src_frames,
+                        &frac_src_offset, true, &renderer.info);
+
+    renderer.info.mix_time.Record(zx_clock_get(ZX_CLOCK_MONOTONIC) -
+                                  start_time);
+  };
+
+  mixer::DurationHistogram job_times;
+  zx_duration_t first, worst, best, total_elapsed = 0;
+  for (uint32_t i = 0; i < kNumSchedulerProfilerRuns; ++i) {
+    zx_duration_t elapsed;
+    zx_time_t start_time = zx_clock_get(ZX_CLOCK_MONOTONIC);
+
+    ::memset(accum.get(), 0, kMixFrames * kDestChans * sizeof(accum[0]));
+    scheduler.Run(accum.get(), kMixFrames * kDestChans, kNumRenderers,
+                  mix_renderer);
+
+    elapsed = zx_clock_get(ZX_CLOCK_MONOTONIC) - start_time;
+    job_times.Record(elapsed);
+
+    if (i > 0) {
+      worst = std::max(worst, elapsed);
+      best = std::min(best, elapsed);
+    } else {
+      first = elapsed;
+      worst = elapsed;
+      best = elapsed;
+    }
+    total_elapsed += elapsed;
+  }
+
+  zx_duration_t renderer_p99 = 0;
+  for (const auto& renderer : renderers) {
+    renderer_p99 = std::max(
+        renderer_p99, renderer.info.mix_time.GetSnapshot().Percentile(99.0));
+  }
+  auto jobs = job_times.GetSnapshot();
+
+  double mean = total_elapsed / kNumSchedulerProfilerRuns;
+  printf("%u:\t%9.3lf\t%9.3lf\t%9.3lf\t%9.3lf\t%8.0lf\t%8.0lf\t%8.0lf\n",
+         num_threads, mean / 1000.0, first / 1000.0, best / 1000.0,
+         worst / 1000.0, jobs.Percentile(50.0) / 1000.0,
+         jobs.Percentile(99.0) / 1000.0, renderer_p99 / 1000.0);
+}
+
 template <typename SampleType>
 void AudioPerformance::ProfileMixer(uint32_t num_input_chans,
                                     uint32_t num_output_chans,
@@ -232,10 +398,11 @@ void AudioPerformance::DisplayOutputConfigLegend() {
   printf("\n   Elapsed time in microsec to ProduceOutput() %u frames\n",
          kFreqTestBufSize);
   printf(
-      "\n   For output configuration FFF-Rn, where:\n"
+      "\n   For output configuration FFF-Rn[D], where:\n"
       "\t   FFF: Format of source data - Un8, I16, I24, F32,\n"
       "\t     R: Range of source data - [S]ilence, [O]ut-of-range, [N]ormal,\n"
-      "\t     n: Number of output channels (one-digit number)\n\n");
+      "\t     n: Number of output channels (one-digit number),\n"
+      "\t     D: Dithered (integer formats only)\n\n");
 }
 
 void AudioPerformance::ProfileOutputProducers() {
@@ -271,9 +438,114 @@ void AudioPerformance::ProfileOutputRange(uint32_t num_chans,
   ProfileOutputType<float>(num_chans, data_range);
 }
 
+// Profile the conversions that OutputProducers hand to vector kernels, with
+// each instruction set this CPU supports, with and without dither.
+void AudioPerformance::ProfileOutputKernels() {
+  using mixer::SimdLevel;
+  zx_time_t start_time = zx_clock_get(ZX_CLOCK_MONOTONIC);
+
+  DisplayOutputConfigLegend();
+
+  for (SimdLevel level : {SimdLevel::None, SimdLevel::Sse2, SimdLevel::Avx2,
+                          SimdLevel::Neon}) {
+    if (!mixer::SetSimdLevel(level)) {
+      continue;
+    }
+    printf("\n   Output kernels: %s\n", mixer::SimdLevelName(level));
+    DisplayOutputColumnHeader();
+
+    for (OutputDataRange data_range :
+         {OutputDataRange::OutOfRange, OutputDataRange::Normal}) {
+      for (bool dither : {false, true}) {
+        ProfileOutputType<int16_t>(2, data_range, dither);
+        ProfileOutputType<int32_t>(2, data_range, dither);
+      }
+      ProfileOutputType<float>(2, data_range);
+    }
+  }
+  mixer::SetSimdLevel(mixer::DetectSimdLevel());
+
+  printf("\n   Total time to profile output kernels: %lu ms\n   --------\n\n",
+         (zx_clock_get(ZX_CLOCK_MONOTONIC) - start_time) / 1000000);
+}
+
+// Produce one mix period from the buffers of several mix threads: either by
+// first summing them into one (as MixScheduler::Run does), or by letting the
+// OutputProducer sum them as it converts.
+void AudioPerformance::ProfileOutputSources() {
+  zx_time_t start_time = zx_clock_get(ZX_CLOCK_MONOTONIC);
+
+  printf(
+      "\n   Elapsed time in microsec to produce a 10-msec, 48k stereo int16 "
+      "mix period\n   from the buffers of several mix threads\n\n");
+  printf("Sources\tSeparate\t    Best\t   Fused\t    Best\n");
+
+  for (uint32_t num_sources : {1, 2, 3, 4}) {
+    ProfileOutputSourcesCount(num_sources);
+  }
+
+  printf("\n   Total time to profile output sources: %lu ms\n   --------\n\n",
+         (zx_clock_get(ZX_CLOCK_MONOTONIC) - start_time) / 1000000);
+}
+
+void AudioPerformance::ProfileOutputSourcesCount(uint32_t num_sources) {
+  constexpr uint32_t kChans = 2;
+  constexpr uint32_t kFrames = 480;
+  constexpr uint32_t kSamples = kFrames * kChans;
+
+  audio::OutputProducerPtr output_producer = SelectOutputProducer(
+      fuchsia::media::AudioSampleFormat::SIGNED_16, kChans);
+
+  std::vector<std::vector<float>> sources(num_sources,
+                                          std::vector<float>(kSamples));
+  std::vector<const float*> source_ptrs;
+  for (uint32_t source = 0; source < num_sources; ++source) {
+    OverwriteCosine(sources[source].data(), kSamples,
+                    static_cast<double>(source + 1), 0.25);
+    source_ptrs.push_back(sources[source].data());
+  }
+  std::vector<int16_t> dest(kSamples);
+
+  // Returns the mean and best times of |produce|, in microseconds.
+  auto time = [](const std::function<void()>& produce) {
+    zx_duration_t best = 0, total_elapsed = 0;
+    for (uint32_t i = 0; i < kNumSourcesProfilerRuns; ++i) {
+      zx_time_t start_time = zx_clock_get(ZX_CLOCK_MONOTONIC);
+      produce();
+      zx_duration_t elapsed = zx_clock_get(ZX_CLOCK_MONOTONIC) - start_time;
+
+      best = (i > 0) ? std::min(best, elapsed) : elapsed;
+      total_elapsed += elapsed;
+    }
+    return std::make_pair(total_elapsed / 1000.0 / kNumSourcesProfilerRuns,
+                          best / 1000.0);
+  };
+
+  // Summing in place changes the first source each time, but not how long it
+  // takes to convert.
+  auto separate = time([&]() {
+    float* accum = sources[0].data();
+    for (uint32_t source = 1; source < num_sources; ++source) {
+      const float* src = source_ptrs[source];
+      for (uint32_t idx = 0; idx < kSamples; ++idx) {
+        accum[idx] += src[idx];
+      }
+    }
+    output_producer->ProduceOutput(accum, dest.data(), kFrames);
+  });
+  auto fused = time([&]() {
+    output_producer->ProduceOutput(source_ptrs.data(), num_sources,
+                                   dest.data(), kFrames);
+  });
+
+  printf("%u:\t%8.3lf\t%8.3lf\t%8.3lf\t%8.3lf\n", num_sources, separate.first,
+         separate.second, fused.first, fused.second);
+}
+
 template <typename SampleType>
 void AudioPerformance::ProfileOutputType(uint32_t num_chans,
-                                         OutputDataRange data_range) {
+                                         OutputDataRange data_range,
+                                         bool dither) {
   fuchsia::media::AudioSampleFormat sample_format;
   std::string format;
   char range;
@@ -297,6 +569,7 @@ void AudioPerformance::ProfileOutputType(uint32_t num_chans,
 
   audio::OutputProducerPtr output_producer =
       SelectOutputProducer(sample_format, num_chans);
+  output_producer->set_dither(dither);
 
   uint32_t num_samples = kFreqTestBufSize * num_chans;
 
@@ -365,9 +638,9 @@ void AudioPerformance::ProfileOutputType(uint32_t num_chans,
   }
 
   double mean = total_elapsed / kNumOutputProfilerRuns;
-  printf("%s-%c%u:\t%9.3lf\t%9.3lf\t%9.3lf\t%9.3lf\n", format.c_str(), range,
-         num_chans, mean / 1000.0, first / 1000.0, best / 1000.0,
-         worst / 1000.0);
+  printf("%s-%c%u%s:\t%9.3lf\t%9.3lf\t%9.3lf\t%9.3lf\n", format.c_str(),
+         range, num_chans, (dither ? "D" : ""), mean / 1000.0, first / 1000.0,
+         best / 1000.0, worst / 1000.0);
 }
 
 }  // namespace test
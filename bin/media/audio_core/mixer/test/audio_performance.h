@@ -27,6 +27,8 @@ class AudioPerformance {
   // under 180 seconds each, on both a standard VIM2 and a standard NUC.
   static constexpr uint32_t kNumMixerProfilerRuns = 140;
   static constexpr uint32_t kNumOutputProfilerRuns = 1200;
+  static constexpr uint32_t kNumSchedulerProfilerRuns = 1000;
+  static constexpr uint32_t kNumSourcesProfilerRuns = 5000;
 
   // class is static only - prevent attempts to instantiate it
   AudioPerformance() = delete;
@@ -65,7 +67,15 @@ class AudioPerformance {
                            Mixer::Resampler sampler_type, uint32_t source_rate,
                            float gain_db, bool accumulate);
 
+  static void ProfileVectorKernels();
+
+  static void ProfileMixScheduler();
+  static void ProfileMixSchedulerThreads(uint32_t num_threads);
+
   static void ProfileOutputProducers();
+  static void ProfileOutputKernels();
+  static void ProfileOutputSources();
+  static void ProfileOutputSourcesCount(uint32_t num_sources);
 
   static void DisplayOutputColumnHeader();
   static void DisplayOutputConfigLegend();
@@ -74,7 +84,8 @@ class AudioPerformance {
   static void ProfileOutputRange(uint32_t num_chans,
                                  OutputDataRange data_range);
   template <typename SampleType>
-  static void ProfileOutputType(uint32_t num_chans, OutputDataRange data_range);
+  static void ProfileOutputType(uint32_t num_chans, OutputDataRange data_range,
+                                bool dither = false);
 };
 
 }  // namespace test
@@ -97,10 +97,25 @@ std::array<double, FrequencySet::kNumReferenceFreqs>
 std::array<double, FrequencySet::kNumReferenceFreqs>
     AudioResult::FreqRespLinearMicro = {NAN};
 
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::FreqRespSincUnity = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::FreqRespSincDown1 = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::FreqRespSincDown2 = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::FreqRespSincUp1 = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::FreqRespSincUp2 = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::FreqRespSincMicro = {NAN};
+
 std::array<double, FrequencySet::kNumReferenceFreqs>
     AudioResult::FreqRespPointNxN = {NAN};
 std::array<double, FrequencySet::kNumReferenceFreqs>
     AudioResult::FreqRespLinearNxN = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::FreqRespSincNxN = {NAN};
 
 // We test our interpolation fidelity across these six rate-conversion ratios:
 // - 1:1 (referred to in these variables and constants as Unity)
@@ -246,6 +261,72 @@ const std::array<double, FrequencySet::kNumReferenceFreqs>
         -1.2580628e+00, -1.8235695e+00, -3.2986619e+00, -5.0020980e+00, -5.2801039e+00, -5.5663757e+00,
         -5.8628714e+00, -6.5135504e+00, -7.4187285e+00, -INFINITY,      -INFINITY,      -INFINITY,
         -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY        };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevFreqRespSincUnity = {
+         0.0000000e+00, -1.1805923e-06, -1.1503518e-06, -1.1259525e-06, -1.0672891e-06, -9.9659305e-07,
+        -8.4809448e-07, -6.2675351e-07, -2.7230839e-07,  3.3022974e-07,  1.2184417e-06,  2.4532131e-06,
+         4.9652260e-06,  7.9068061e-06,  1.2748742e-05,  1.9901110e-05,  2.9354921e-05,  4.1051380e-05,
+         5.1835942e-05,  5.5347664e-05,  4.2657096e-05,  1.4474420e-05,  3.8094021e-07,  3.9622523e-05,
+         4.4173887e-05,  1.7585387e-06,  4.5994615e-05,  3.7659038e-05,  1.1072334e-05,  3.5958648e-05,
+         5.6432609e-05, -1.7299116e-05,  6.1010677e-05, -6.8850833e-03, -1.1561010e-01, -6.4457739e-01,
+        -2.1467575e+00, -1.1260256e+01, -4.6504013e+01, -INFINITY,      -INFINITY,      -INFINITY,     
+        -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY        };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevFreqRespSincDown1 = {
+         0.0000000e+00, -1.1676940e-06, -1.1708496e-06, -1.1665699e-06, -1.1726800e-06, -1.1637046e-06,
+        -1.1308130e-06, -1.0909642e-06, -1.0289142e-06, -8.9575664e-07, -7.3806980e-07, -5.1790201e-07,
+        -5.9686150e-08,  4.7701813e-07,  1.3882101e-06,  2.7303971e-06,  4.4976526e-06,  6.7425480e-06,
+         9.0092099e-06,  1.0111278e-05,  8.2846624e-06,  2.9249100e-06, -1.5660606e-06,  5.2580561e-06,
+         9.8839105e-06, -2.5913501e-06,  1.1693508e-05,  2.5689961e-06, -5.2624350e-06, -5.0800058e-08,
+         2.2278330e-05, -1.3302541e-05,  3.2556205e-05, -6.8853115e-03, -1.1567177e-01, -6.4457326e-01,
+        -2.1467766e+00, -1.1260136e+01, -4.6511034e+01, -INFINITY,      -INFINITY,      -INFINITY,     
+        -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY        };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevFreqRespSincDown2 = {
+        -1.0924261e-06, -1.0107901e-06, -1.0305361e-06, -1.0490949e-06, -1.0676560e-06, -1.1195097e-06,
+        -1.1784683e-06, -1.2897343e-06, -1.4575424e-06, -1.7631211e-06, -2.1978903e-06, -2.8094059e-06,
+        -4.0459567e-06, -5.4820001e-06, -7.8590983e-06, -1.1356976e-05, -1.5911661e-05, -2.1483864e-05,
+        -2.6394734e-05, -2.7440172e-05, -2.0540700e-05, -6.9440226e-06, -2.5939449e-06, -2.2611062e-05,
+        -1.9537518e-05, -4.9775343e-06, -1.8544145e-05, -2.6089843e-05, -1.6911178e-05, -3.1455798e-05,
+        -9.7379133e-06, -5.0358677e-06,  2.5475561e-05, -3.1344465e-03, -8.0992836e-02, -5.2425066e-01,
+        -1.8900283e+00, -1.0712867e+01, -4.5962863e+01, -INFINITY,      -INFINITY,      -INFINITY,     
+        -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY        };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevFreqRespSincUp1 = {
+        -1.0783834e-06, -1.0021523e-06, -1.0124872e-06, -1.0234131e-06, -1.0360755e-06, -1.0654328e-06,
+        -1.1080952e-06, -1.1829244e-06, -1.2941913e-06, -1.4879059e-06, -1.7779071e-06, -2.1760785e-06,
+        -2.9828665e-06, -3.9077938e-06, -5.4126320e-06, -7.5763272e-06, -1.0266003e-05, -1.3242756e-05,
+        -1.5216483e-05, -1.3950239e-05, -8.1580088e-06, -1.5328108e-06, -6.1267089e-06, -1.5724983e-05,
+        -3.0289735e-06, -1.3915900e-05, -9.6936651e-07, -9.0966254e-06, -1.1251357e-05, -4.7668287e-07,
+        -2.8104582e-05,  2.7119601e-06, -1.9076301e-05, -3.2957908e+00, -7.8043183e+00, -1.5420150e+01,
+        -2.7450332e+01, -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,     
+        -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY        };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevFreqRespSincUp2 = {
+        -1.7843449e-06, -1.1174524e-06, -1.0913532e-06, -1.0724852e-06, -1.0378888e-06, -9.7951607e-07,
+        -8.7594591e-07, -7.1986937e-07, -4.6658280e-07, -5.3992313e-08,  5.4672927e-07,  1.3595798e-06,
+         2.8965159e-06,  4.5145189e-06,  6.7548654e-06,  9.0412878e-06,  1.0154135e-05,  8.2737792e-06,
+         2.7133094e-06, -1.4770161e-06,  5.2688409e-06,  9.9985287e-06, -2.3431313e-06,  1.1719313e-05,
+         2.5904707e-06, -5.2584808e-06, -2.4417568e-08,  2.2227161e-05,  1.0956973e-05,  3.2298180e-05,
+        -1.1390005e-01, -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,     
+        -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,     
+        -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY        };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevFreqRespSincMicro = {
+        -1.0783834e-06, -1.0118490e-06, -9.9887263e-07, -1.0037986e-06, -1.0143288e-06, -1.0445109e-06,
+        -1.0841408e-06, -1.1532834e-06, -1.2378016e-06, -1.4177787e-06, -1.6592094e-06, -1.9966890e-06,
+        -2.6721007e-06, -3.4832960e-06, -4.7918623e-06, -6.7197121e-06, -9.1969719e-06, -1.2183939e-05,
+        -1.4718259e-05, -1.4952423e-05, -1.0834494e-05, -3.5464149e-06, -2.5066975e-06, -1.3695103e-05,
+        -9.5091282e-06, -5.1789435e-06, -8.2735126e-06, -1.7342987e-05, -1.5449506e-05, -2.1640227e-05,
+        -2.0879934e-06, -1.9923950e-05,  1.9298188e-07, -6.9190987e-03, -1.1585752e-01, -6.4518436e-01,
+        -2.1482015e+00, -1.1264908e+01, -4.6529744e+01, -INFINITY,      -INFINITY,      -INFINITY,     
+        -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY,      -INFINITY        };
 // clang-format on
 
 std::array<double, FrequencySet::kNumReferenceFreqs>
@@ -274,10 +355,46 @@ std::array<double, FrequencySet::kNumReferenceFreqs>
 std::array<double, FrequencySet::kNumReferenceFreqs>
     AudioResult::SinadLinearMicro = {NAN};
 
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::SinadSincUnity = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::SinadSincDown1 = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::SinadSincDown2 = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::SinadSincUp1 = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::SinadSincUp2 = {NAN};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::SinadSincMicro = {NAN};
+
 std::array<double, FrequencySet::kNumReferenceFreqs>
     AudioResult::SinadPointNxN = {-INFINITY};
 std::array<double, FrequencySet::kNumReferenceFreqs>
     AudioResult::SinadLinearNxN = {-INFINITY};
+std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::SinadSincNxN = {-INFINITY};
+
+double AudioResult::CostPointUnity = NAN;
+double AudioResult::CostPointDown1 = NAN;
+double AudioResult::CostPointDown2 = NAN;
+double AudioResult::CostPointUp1 = NAN;
+double AudioResult::CostPointUp2 = NAN;
+double AudioResult::CostPointMicro = NAN;
+
+double AudioResult::CostLinearUnity = NAN;
+double AudioResult::CostLinearDown1 = NAN;
+double AudioResult::CostLinearDown2 = NAN;
+double AudioResult::CostLinearUp1 = NAN;
+double AudioResult::CostLinearUp2 = NAN;
+double AudioResult::CostLinearMicro = NAN;
+
+double AudioResult::CostSincUnity = NAN;
+double AudioResult::CostSincDown1 = NAN;
+double AudioResult::CostSincDown2 = NAN;
+double AudioResult::CostSincUp1 = NAN;
+double AudioResult::CostSincUp2 = NAN;
+double AudioResult::CostSincMicro = NAN;
 
 // We test our interpolation fidelity across these six rate-conversion ratios:
 // - 1:1 (referred to in these variables and constants as Unity)
@@ -423,6 +540,72 @@ const std::array<double, FrequencySet::kNumReferenceFreqs>
          22.207908,   18.336999,   11.618540,     6.3382417,   5.6081329,   4.8842446,
           4.1617533,   2.6594494,   0.72947217,  -INFINITY,   -INFINITY,   -INFINITY,
          -INFINITY,   -INFINITY,   -INFINITY,    -INFINITY,   -INFINITY,    };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevSinadSincUnity = {
+         160.00000,  137.41849,  137.46117,  137.43215,  137.37965,  137.45976,
+         137.41176,  137.47197,  137.41511,  137.44389,  137.42802,  137.38148,
+         137.40404,  137.39821,  137.45091,  137.55948,  137.50391,  137.47717,
+         137.47557,  137.40955,  137.54237,  137.54701,  137.50816,  137.50772,
+         137.54073,  137.47014,  137.54320,  137.51782,  137.49769,  137.53011,
+         137.53754,  137.46476,  137.43413,  137.38252,  137.77813,  137.43872,
+         136.26564,  131.31310,   96.58605,  160.00000,  -INFINITY,  -INFINITY,
+         -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY  };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevSinadSincDown1 = {
+         160.00000,  134.75521,  134.71785,  134.57971,  134.59567,  134.62335,
+         134.64740,  134.65930,  134.65716,  134.65205,  134.65951,  134.63272,
+         134.63589,  134.53403,  134.59684,  134.58268,  134.60805,  134.66539,
+         134.71672,  134.74517,  134.71912,  134.72883,  134.74136,  134.69856,
+         134.68681,  134.75564,  134.69145,  134.67925,  134.71635,  134.70700,
+         134.74658,  134.64449,  134.63354,  134.60581,  135.00973,  134.57800,
+         133.45752,  130.35243,   99.02108,  126.04230,  -INFINITY,  -INFINITY,
+         -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY  };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevSinadSincDown2 = {
+         130.08001,  134.18292,  133.85988,  133.53560,  132.89065,  132.32097,
+         131.16707,  129.87266,  128.40717,  126.69695,  125.03621,  123.45725,
+         121.46733,  120.02590,  118.53078,  117.25159,  116.34564,  115.83080,
+         115.29063,  113.54147,  111.13969,  109.52176,  107.61758,  105.64281,
+         103.70326,  101.76771,   99.69192,   97.79291,   95.77764,   93.72264,
+          91.77942,   90.19911,   87.70336,   85.98273,   85.76348,   85.55018,
+          85.33765,   84.91743,   78.65828,   29.81385,  -INFINITY,  -INFINITY,
+         -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY  };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevSinadSincUp1 = {
+         132.56035,  135.57216,  134.76835,  134.12398,  133.04872,  131.99550,
+         130.34569,  128.64849,  126.83545,  124.83467,  122.95153,  121.18927,
+         118.92665,  117.20172,  115.26670,  113.31269,  111.47355,  109.68031,
+         108.04929,  106.53316,  105.18442,  103.60237,  101.41241,   99.36017,
+          97.56637,   95.54338,   93.51001,   91.54746,   89.54513,   87.49047,
+          85.55037,   83.96879,   81.47053,   79.73087,   79.49677,   79.22200,
+          78.67134,    0.95824,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,
+         -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY  };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevSinadSincUp2 = {
+         140.47257,  137.34519,  137.24554,  137.17925,  136.81903,  136.08199,
+         134.26478,  131.62744,  128.17843,  124.25764,  120.54024,  117.18777,
+         113.10310,  110.25184,  107.49791,  105.53013,  105.05954,  107.51241,
+         117.62853,  131.65573,  107.52370,  107.38577,  120.75703,  107.43561,
+         107.30900,  113.99812,  107.03711,  107.56577,  104.65961,  109.09033,
+         102.55152,    3.35178,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,
+         -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,
+         -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY  };
+
+const std::array<double, FrequencySet::kNumReferenceFreqs>
+    AudioResult::kPrevSinadSincMicro = {
+         132.56035,  135.75812,  135.06644,  134.43638,  133.45632,  132.45065,
+         130.89574,  129.24703,  127.46765,  125.51570,  123.63610,  121.89124,
+         119.64397,  117.91975,  115.97721,  114.01452,  112.15174,  110.31492,
+         108.62906,  107.05183,  105.70868,  104.25019,  102.19563,  100.11926,
+          98.22967,   96.31242,   94.20833,   92.28359,   90.29313,   88.21787,
+          86.28400,   84.70588,   82.20685,   80.48803,   80.25846,   80.04858,
+          79.84244,   79.30526,   63.85317,  -INFINITY,  -INFINITY,  -INFINITY,
+         -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY,  -INFINITY  };
 // clang-format on
 
 //
@@ -544,8 +727,16 @@ void AudioResult::DumpThresholdValues() {
   DumpFreqRespValues(AudioResult::FreqRespLinearUp2.data(), "FR-LinearUp2");
   DumpFreqRespValues(AudioResult::FreqRespLinearMicro.data(), "FR-LinearMicro");
 
+  DumpFreqRespValues(AudioResult::FreqRespSincUnity.data(), "FR-SincUnity");
+  DumpFreqRespValues(AudioResult::FreqRespSincDown1.data(), "FR-SincDown1");
+  DumpFreqRespValues(AudioResult::FreqRespSincDown2.data(), "FR-SincDown2");
+  DumpFreqRespValues(AudioResult::FreqRespSincUp1.data(), "FR-SincUp1");
+  DumpFreqRespValues(AudioResult::FreqRespSincUp2.data(), "FR-SincUp2");
+  DumpFreqRespValues(AudioResult::FreqRespSincMicro.data(), "FR-SincMicro");
+
   DumpFreqRespValues(AudioResult::FreqRespPointNxN.data(), "FR-PointNxN");
   DumpFreqRespValues(AudioResult::FreqRespLinearNxN.data(), "FR-LinearNxN");
+  DumpFreqRespValues(AudioResult::FreqRespSincNxN.data(), "FR-SincNxN");
 
   DumpSinadValues(AudioResult::SinadPointUnity.data(), "SinadPointUnity");
   DumpSinadValues(AudioResult::SinadPointDown1.data(), "SinadPointDown1");
@@ -561,8 +752,16 @@ void AudioResult::DumpThresholdValues() {
   DumpSinadValues(AudioResult::SinadLinearUp2.data(), "SinadLinearUp2");
   DumpSinadValues(AudioResult::SinadLinearMicro.data(), "SinadLinearMicro");
 
+  DumpSinadValues(AudioResult::SinadSincUnity.data(), "SinadSincUnity");
+  DumpSinadValues(AudioResult::SinadSincDown1.data(), "SinadSincDown1");
+  DumpSinadValues(AudioResult::SinadSincDown2.data(), "SinadSincDown2");
+  DumpSinadValues(AudioResult::SinadSincUp1.data(), "SinadSincUp1");
+  DumpSinadValues(AudioResult::SinadSincUp2.data(), "SinadSincUp2");
+  DumpSinadValues(AudioResult::SinadSincMicro.data(), "SinadSincMicro");
+
   DumpSinadValues(AudioResult::SinadPointNxN.data(), "SinadPointNxN");
   DumpSinadValues(AudioResult::SinadLinearNxN.data(), "SinadLinearNxN");
+  DumpSinadValues(AudioResult::SinadSincNxN.data(), "SinadSincNxN");
 
   DumpLevelValues();
   DumpLevelToleranceValues();
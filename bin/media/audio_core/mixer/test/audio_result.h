@@ -199,6 +199,14 @@ class AudioResult {
   static std::array<double, FrequencySet::kNumReferenceFreqs>
       FreqRespLinearMicro;
 
+  // Same as the above section, but for SincSampler
+  static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespSincUnity;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespSincDown1;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespSincDown2;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespSincUp1;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespSincUp2;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespSincMicro;
+
   //
   // Val-being-checked (in dBFS) must be greater than or equal to this value.
   // It also cannot be more than kPrevLevelToleranceInterpolation above 0.0db.
@@ -238,8 +246,26 @@ class AudioResult {
   static const std::array<double, FrequencySet::kNumReferenceFreqs>
       kPrevFreqRespLinearMicro;
 
+  // Same as the above section, but for SincSampler. Its vector kernels sum
+  // their products in a different order at each SimdLevel, so these are the
+  // lowest results measured across levels, less a small margin. Frequencies in
+  // its stopband are not evaluated.
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevFreqRespSincUnity;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevFreqRespSincDown1;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevFreqRespSincDown2;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevFreqRespSincUp1;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevFreqRespSincUp2;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevFreqRespSincMicro;
+
   static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespPointNxN;
   static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespLinearNxN;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> FreqRespSincNxN;
 
   // Signal-to-Noise-And-Distortion (SINAD)
   //
@@ -271,6 +297,14 @@ class AudioResult {
   static std::array<double, FrequencySet::kNumReferenceFreqs> SinadLinearUp2;
   static std::array<double, FrequencySet::kNumReferenceFreqs> SinadLinearMicro;
 
+  // Same as the above section, but for SincSampler
+  static std::array<double, FrequencySet::kNumReferenceFreqs> SinadSincUnity;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> SinadSincDown1;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> SinadSincDown2;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> SinadSincUp1;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> SinadSincUp2;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> SinadSincMicro;
+
   // These are the previous-cached results for SINAD, for this sampler and this
   // rate conversion, represented in dBr. If any current result magnitude is
   // LESS than this value, then the test case fails.
@@ -301,9 +335,53 @@ class AudioResult {
   static const std::array<double, FrequencySet::kNumReferenceFreqs>
       kPrevSinadLinearMicro;
 
+  // Same as the above section, but for SincSampler (again, the lowest results
+  // measured across SimdLevels, less 0.5 dB).
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevSinadSincUnity;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevSinadSincDown1;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevSinadSincDown2;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevSinadSincUp1;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevSinadSincUp2;
+  static const std::array<double, FrequencySet::kNumReferenceFreqs>
+      kPrevSinadSincMicro;
+
   // SINAD results measured for a few frequencies during the NxN tests.
   static std::array<double, FrequencySet::kNumReferenceFreqs> SinadPointNxN;
   static std::array<double, FrequencySet::kNumReferenceFreqs> SinadLinearNxN;
+  static std::array<double, FrequencySet::kNumReferenceFreqs> SinadSincNxN;
+
+  // CPU Cost
+  //
+  // For the specified resampler and rate conversion, the CPU time (in
+  // microseconds) that Mix takes to produce one second of mono 48 kHz output,
+  // as measured during the frequency response and SINAD tests above. This
+  // depends on the machine running the tests, so unlike the other results it
+  // is only displayed, never compared to previously-saved values.
+  static double CostPointUnity;
+  static double CostPointDown1;
+  static double CostPointDown2;
+  static double CostPointUp1;
+  static double CostPointUp2;
+  static double CostPointMicro;
+
+  static double CostLinearUnity;
+  static double CostLinearDown1;
+  static double CostLinearDown2;
+  static double CostLinearUp1;
+  static double CostLinearUp2;
+  static double CostLinearMicro;
+
+  static double CostSincUnity;
+  static double CostSincDown1;
+  static double CostSincDown2;
+  static double CostSincUp1;
+  static double CostSincUp2;
+  static double CostSincMicro;
 
   //
   //
@@ -0,0 +1,112 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <thread>
+#include <vector>
+
+#include "garnet/bin/media/audio_core/mixer/duration_histogram.h"
+#include "gtest/gtest.h"
+
+namespace media {
+namespace audio {
+namespace test {
+
+using mixer::DurationHistogram;
+
+// Durations land in power-of-two buckets of microseconds.
+TEST(DurationHistogram, Buckets) {
+  EXPECT_EQ(0u, DurationHistogram::BucketFor(-1));
+  EXPECT_EQ(0u, DurationHistogram::BucketFor(0));
+  EXPECT_EQ(0u, DurationHistogram::BucketFor(ZX_USEC(1) - 1));
+  EXPECT_EQ(1u, DurationHistogram::BucketFor(ZX_USEC(1)));
+  EXPECT_EQ(2u, DurationHistogram::BucketFor(ZX_USEC(2)));
+  EXPECT_EQ(2u, DurationHistogram::BucketFor(ZX_USEC(4) - 1));
+  EXPECT_EQ(10u, DurationHistogram::BucketFor(ZX_MSEC(1)));
+  EXPECT_EQ(DurationHistogram::kNumBuckets - 1,
+            DurationHistogram::BucketFor(ZX_SEC(10)));
+
+  for (uint32_t bucket = 0; bucket < DurationHistogram::kNumBuckets - 1;
+       ++bucket) {
+    zx_duration_t limit = DurationHistogram::BucketLimit(bucket);
+    EXPECT_EQ(bucket, DurationHistogram::BucketFor(limit - 1));
+    EXPECT_EQ(bucket + 1, DurationHistogram::BucketFor(limit));
+  }
+}
+
+// A snapshot reports what was recorded, and bounds its percentiles.
+TEST(DurationHistogram, Snapshot) {
+  DurationHistogram histogram;
+  auto empty = histogram.GetSnapshot();
+  EXPECT_EQ(0u, empty.count);
+  EXPECT_EQ(0, empty.mean());
+  EXPECT_EQ(0, empty.Percentile(50.0));
+
+  for (uint32_t idx = 0; idx < 98; ++idx) {
+    histogram.Record(ZX_USEC(3));
+  }
+  histogram.Record(ZX_USEC(100));
+  histogram.Record(ZX_MSEC(5));
+
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(100u, snapshot.count);
+  EXPECT_EQ(ZX_USEC(98 * 3 + 100 + 5000), snapshot.total);
+  EXPECT_EQ(ZX_MSEC(5), snapshot.max);
+  EXPECT_EQ(98u, snapshot.buckets[DurationHistogram::BucketFor(ZX_USEC(3))]);
+
+  EXPECT_EQ(ZX_USEC(4), snapshot.Percentile(0.0));
+  EXPECT_EQ(ZX_USEC(4), snapshot.Percentile(50.0));
+  EXPECT_EQ(ZX_USEC(4), snapshot.Percentile(98.0));
+  EXPECT_EQ(ZX_USEC(128), snapshot.Percentile(99.0));
+  EXPECT_EQ(ZX_MSEC(5), snapshot.Percentile(100.0));
+}
+
+// Lead times (tens of msec) land in finite buckets, so their percentiles stay
+// bounded even when a single stall sets the maximum.
+TEST(DurationHistogram, LeadTimeRange) {
+  EXPECT_GE(DurationHistogram::BucketLimit(DurationHistogram::kNumBuckets - 2),
+            ZX_MSEC(100));
+
+  DurationHistogram histogram;
+  for (uint32_t idx = 0; idx < 99; ++idx) {
+    histogram.Record(ZX_MSEC(20) + ZX_USEC(idx * 100));
+  }
+  histogram.Record(ZX_MSEC(200));
+
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(0u, snapshot.buckets[DurationHistogram::kNumBuckets - 1]);
+  EXPECT_EQ(99u, snapshot.buckets[DurationHistogram::BucketFor(ZX_MSEC(20))]);
+  EXPECT_EQ(ZX_MSEC(200), snapshot.max);
+
+  EXPECT_EQ(ZX_USEC(32768), snapshot.Percentile(50.0));
+  EXPECT_EQ(ZX_USEC(32768), snapshot.Percentile(99.0));
+  EXPECT_EQ(ZX_MSEC(200), snapshot.Percentile(100.0));
+}
+
+// Any number of threads may record at once without losing counts.
+TEST(DurationHistogram, ConcurrentRecord) {
+  constexpr uint32_t kNumThreads = 4;
+  constexpr uint32_t kPerThread = 10000;
+
+  DurationHistogram histogram;
+  std::vector<std::thread> threads;
+  for (uint32_t id = 0; id < kNumThreads; ++id) {
+    threads.emplace_back([&histogram, id]() {
+      for (uint32_t idx = 0; idx < kPerThread; ++idx) {
+        histogram.Record(ZX_USEC(id + 1));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(kNumThreads * kPerThread, snapshot.count);
+  EXPECT_EQ(ZX_USEC(kPerThread * (1 + 2 + 3 + 4)), snapshot.total);
+  EXPECT_EQ(ZX_USEC(kNumThreads), snapshot.max);
+}
+
+}  // namespace test
+}  // namespace audio
+}  // namespace media
@@ -0,0 +1,186 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "garnet/bin/media/audio_core/mixer/mix_scheduler.h"
+#include "gtest/gtest.h"
+
+namespace media {
+namespace audio {
+namespace test {
+
+// Each task adds a distinct, exactly-representable value to every sample, so
+// the sum is the same in any order.
+void RunAndCheck(mixer::MixScheduler* scheduler, uint32_t num_samples,
+                 uint32_t num_tasks) {
+  std::vector<float> dest(num_samples, 0.5f);
+  std::vector<std::atomic<uint32_t>> runs(num_tasks);
+
+  scheduler->Run(dest.data(), num_samples, num_tasks,
+                 [&runs, num_samples](uint32_t index, float* accum) {
+                   ++runs[index];
+                   for (uint32_t idx = 0; idx < num_samples; ++idx) {
+                     accum[idx] += static_cast<float>(index + 1);
+                   }
+                 });
+
+  for (uint32_t index = 0; index < num_tasks; ++index) {
+    EXPECT_EQ(1u, runs[index].load()) << "task " << index;
+  }
+
+  float expect = 0.5f + (num_tasks * (num_tasks + 1) / 2);
+  for (uint32_t idx = 0; idx < num_samples; ++idx) {
+    ASSERT_EQ(expect, dest[idx]) << "[" << idx << "]";
+  }
+}
+
+// With a single thread, every task runs in order, directly into the caller's
+// buffer.
+TEST(MixScheduler, SingleThread) {
+  mixer::MixScheduler scheduler(1);
+  scheduler.SetMaxSamples(64);
+
+  std::vector<uint32_t> order;
+  float dest[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+  scheduler.Run(dest, 4, 3, [&order, &dest](uint32_t index, float* accum) {
+    EXPECT_EQ(dest, accum);
+    order.push_back(index);
+  });
+
+  EXPECT_EQ((std::vector<uint32_t>{0, 1, 2}), order);
+  RunAndCheck(&scheduler, 64, 9);
+}
+
+// Every task runs exactly once, whether there are fewer tasks than threads or
+// many more, and every worker's contribution reaches the destination.
+TEST(MixScheduler, MultipleThreads) {
+  mixer::MixScheduler scheduler(4);
+  scheduler.SetMaxSamples(960);
+
+  RunAndCheck(&scheduler, 960, 0);
+  RunAndCheck(&scheduler, 960, 1);
+  RunAndCheck(&scheduler, 960, 3);
+  RunAndCheck(&scheduler, 960, 64);
+
+  // Jobs may be shorter than the buffers, and the buffers may be resized.
+  RunAndCheck(&scheduler, 17, 64);
+  scheduler.SetMaxSamples(4096);
+  RunAndCheck(&scheduler, 4096, 64);
+}
+
+// Back-to-back jobs must not see each other's results.
+TEST(MixScheduler, RepeatedJobs) {
+  mixer::MixScheduler scheduler(3);
+  scheduler.SetMaxSamples(480);
+
+  for (uint32_t job = 0; job < 1000; ++job) {
+    RunAndCheck(&scheduler, 480, 1 + (job % 20));
+  }
+}
+
+// Each worker mixes a contiguous block of streams in order, starting with the
+// caller's, and the result does not depend on which thread finishes first.
+// Task values here are not exactly representable, so any change in summation
+// order would show up in the final bits.
+TEST(MixScheduler, DeterministicOrder) {
+  constexpr uint32_t kNumSamples = 480;
+  constexpr uint32_t kNumTasks = 10;
+  constexpr uint32_t kNumThreads = 4;
+  mixer::MixScheduler scheduler(kNumThreads);
+  scheduler.SetMaxSamples(kNumSamples);
+
+  auto add_stream = [](uint32_t index, float* accum) {
+    for (uint32_t idx = 0; idx < kNumSamples; ++idx) {
+      accum[idx] += 1.0f / static_cast<float>(3 + index * 7 + idx);
+    }
+  };
+
+  // Sum block by block, as the scheduler should, to get the expected bits.
+  std::vector<float> expect(kNumSamples, 0.1f);
+  for (uint32_t id = 0; id < kNumThreads; ++id) {
+    uint32_t first = kNumTasks * id / kNumThreads;
+    uint32_t last = kNumTasks * (id + 1) / kNumThreads;
+    std::vector<float> partial(kNumSamples, 0.0f);
+    float* accum = (id == 0) ? expect.data() : partial.data();
+    for (uint32_t index = first; index < last; ++index) {
+      add_stream(index, accum);
+    }
+    if (id != 0) {
+      for (uint32_t idx = 0; idx < kNumSamples; ++idx) {
+        expect[idx] += partial[idx];
+      }
+    }
+  }
+
+  for (uint32_t job = 0; job < 200; ++job) {
+    std::vector<float> dest(kNumSamples, 0.1f);
+    std::vector<float*> accums(kNumTasks, nullptr);
+    scheduler.Run(dest.data(), kNumSamples, kNumTasks,
+                  [&accums, &add_stream](uint32_t index, float* accum) {
+                    accums[index] = accum;
+                    add_stream(index, accum);
+                  });
+
+    // Streams 0-1 go to the caller; 2-4, 5-6 and 7-9 share a buffer each.
+    EXPECT_EQ(dest.data(), accums[0]);
+    EXPECT_EQ(dest.data(), accums[1]);
+    EXPECT_NE(dest.data(), accums[2]);
+    EXPECT_EQ(accums[2], accums[4]);
+    EXPECT_NE(accums[4], accums[5]);
+    EXPECT_EQ(accums[5], accums[6]);
+    EXPECT_NE(accums[6], accums[7]);
+    EXPECT_EQ(accums[7], accums[9]);
+
+    for (uint32_t idx = 0; idx < kNumSamples; ++idx) {
+      ASSERT_EQ(expect[idx], dest[idx]) << "job " << job << " [" << idx << "]";
+    }
+  }
+}
+
+// RunUnreduced leaves each worker's contribution in its own buffer, starting
+// with the caller's; together they hold every task's.
+TEST(MixScheduler, Unreduced) {
+  constexpr uint32_t kNumSamples = 256;
+  constexpr uint32_t kNumTasks = 16;
+  mixer::MixScheduler scheduler(4);
+  scheduler.SetMaxSamples(kNumSamples);
+
+  std::vector<float> dest(kNumSamples, 0.5f);
+  std::vector<const float*> partials(scheduler.num_threads());
+  uint32_t num_partials = scheduler.RunUnreduced(
+      dest.data(), kNumSamples, kNumTasks,
+      [](uint32_t index, float* accum) {
+        for (uint32_t idx = 0; idx < kNumSamples; ++idx) {
+          accum[idx] += static_cast<float>(index + 1);
+        }
+      },
+      partials.data());
+
+  ASSERT_GE(num_partials, 1u);
+  ASSERT_LE(num_partials, scheduler.num_threads());
+  EXPECT_EQ(dest.data(), partials[0]);
+
+  float expect = 0.5f + (kNumTasks * (kNumTasks + 1) / 2);
+  for (uint32_t idx = 0; idx < kNumSamples; ++idx) {
+    float sum = 0.0f;
+    for (uint32_t partial = 0; partial < num_partials; ++partial) {
+      sum += partials[partial][idx];
+    }
+    ASSERT_EQ(expect, sum) << "[" << idx << "]";
+  }
+
+  // With one task, there is nothing to share.
+  std::fill(dest.begin(), dest.end(), 0.5f);
+  EXPECT_EQ(1u, scheduler.RunUnreduced(dest.data(), kNumSamples, 1,
+                                       [](uint32_t, float*) {},
+                                       partials.data()));
+  EXPECT_EQ(dest.data(), partials[0]);
+}
+
+}  // namespace test
+}  // namespace audio
+}  // namespace media
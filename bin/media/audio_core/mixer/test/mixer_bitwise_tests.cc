@@ -3,8 +3,13 @@
 // found in the LICENSE file.
 
 #include <fbl/algorithm.h>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
 
 #include "garnet/bin/media/audio_core/mixer/no_op.h"
+#include "garnet/bin/media/audio_core/mixer/simd_kernels.h"
 #include "garnet/bin/media/audio_core/mixer/test/mixer_tests_shared.h"
 #include "lib/fxl/logging.h"
 
@@ -85,6 +90,41 @@ TEST(DataFormats, LinearSampler_Float) {
                                  48000, 2, 44100));
 }
 
+// The SincSampler is only used when explicitly requested, at any rates, for
+// N->N, mono->stereo and stereo->mono channel configurations.
+//
+// Create SincSampler objects for incoming buffers of type uint8
+TEST(DataFormats, SincSampler_8) {
+  EXPECT_NE(nullptr, SelectMixer(fuchsia::media::AudioSampleFormat::UNSIGNED_8,
+                                 1, 22050, 2, 44100, Resampler::WindowedSinc));
+  EXPECT_NE(nullptr, SelectMixer(fuchsia::media::AudioSampleFormat::UNSIGNED_8,
+                                 2, 48000, 1, 48000, Resampler::WindowedSinc));
+}
+
+// Create SincSampler objects for incoming buffers of type int16
+TEST(DataFormats, SincSampler_16) {
+  EXPECT_NE(nullptr, SelectMixer(fuchsia::media::AudioSampleFormat::SIGNED_16,
+                                 2, 44100, 2, 48000, Resampler::WindowedSinc));
+  EXPECT_NE(nullptr, SelectMixer(fuchsia::media::AudioSampleFormat::SIGNED_16,
+                                 8, 192000, 8, 8000, Resampler::WindowedSinc));
+}
+
+// Create SincSampler objects for incoming buffers of type int24-in-32
+TEST(DataFormats, SincSampler_24) {
+  EXPECT_NE(nullptr,
+            SelectMixer(fuchsia::media::AudioSampleFormat::SIGNED_24_IN_32, 2,
+                        16000, 2, 48000, Resampler::WindowedSinc));
+}
+
+// Create SincSampler objects for incoming buffers of type float, and reject
+// the channel configurations that it does not support
+TEST(DataFormats, SincSampler_Float) {
+  EXPECT_NE(nullptr, SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 2,
+                                 96000, 2, 48000, Resampler::WindowedSinc));
+  EXPECT_EQ(nullptr, SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 4,
+                                 48000, 2, 44100, Resampler::WindowedSinc));
+}
+
 // Create OutputProducer objects for outgoing buffers of type uint8
 TEST(DataFormats, OutputProducer_8) {
   EXPECT_NE(nullptr, SelectOutputProducer(
@@ -458,6 +498,324 @@ TEST(PassThru, Output_Float_Silence) {
   EXPECT_EQ(dest[fbl::count_of(dest) - 1], 7.8f);  // this val survives
 }
 
+//
+// VectorKernels tests - at unity rate and integer rate ratios, PointSampler and
+// LinearSampler hand int16 and float, mono and stereo mixes to vector kernels.
+// Whichever instruction sets this CPU supports, the kernels should produce
+// exactly what the scalar loops produce. SincSampler always filters with the
+// vector kernels, which may differ from its scalar loop in the final bits.
+//
+void FillRandom(std::minstd_rand* rng, std::vector<int16_t>* buf) {
+  std::uniform_int_distribution<int32_t> dist(
+      std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max());
+  for (auto& val : *buf) {
+    val = dist(*rng);
+  }
+}
+
+void FillRandom(std::minstd_rand* rng, std::vector<float>* buf) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  for (auto& val : *buf) {
+    val = dist(*rng);
+  }
+}
+
+// Mix the same source with the scalar loops and then with each available
+// instruction set, at unity and non-unity gain, with and without accumulation.
+template <typename SampleType>
+void CompareVectorToScalar(fuchsia::media::AudioSampleFormat format,
+                           uint32_t src_chans, uint32_t dest_chans,
+                           uint32_t src_rate, uint32_t src_frames,
+                           Resampler resampler) {
+  using mixer::SimdLevel;
+
+#if defined(__aarch64__)
+  // The compiler may fuse the multiply and add in the scalar Interpolate,
+  // skipping one rounding that the vector kernels perform.
+  float tolerance =
+      (resampler == Resampler::LinearInterpolation) ? 1e-6f : 0.0f;
+#else
+  float tolerance = 0.0f;
+#endif
+  // Each level sums the SincSampler's products in a different order.
+  if (resampler == Resampler::WindowedSinc) {
+    tolerance = 1e-5f;
+  }
+
+  // The source runs out before the dest fills up, so the kernels must stop
+  // short of reading past its end, and the scalar loop finishes each mix.
+  constexpr uint32_t kDestFrames = 1024;
+  const uint32_t step = src_rate / 48000;
+
+  std::minstd_rand rng(src_chans * 10 + dest_chans);
+  std::vector<SampleType> source(src_frames * src_chans);
+  FillRandom(&rng, &source);
+  std::vector<float> initial(kDestFrames * dest_chans);
+  FillRandom(&rng, &initial);
+
+  for (float gain_db : {Gain::kUnityGainDb, -6.0f}) {
+    for (bool accumulate : {false, true}) {
+      std::vector<float> expect;
+      uint32_t expect_dest_offset;
+      int32_t expect_frac_src_offset;
+
+      for (SimdLevel level : {SimdLevel::None, SimdLevel::Sse2,
+                              SimdLevel::Avx2, SimdLevel::Neon}) {
+        if (!mixer::SetSimdLevel(level)) {
+          continue;
+        }
+        SCOPED_TRACE(testing::Message()
+                     << mixer::SimdLevelName(level) << ", " << src_chans
+                     << "->" << dest_chans << " chans, " << src_frames
+                     << " frames at " << src_rate << " Hz, " << gain_db
+                     << " dB"
+                     << (accumulate ? ", accumulating" : ""));
+
+        MixerPtr mixer = SelectMixer(format, src_chans, src_rate, dest_chans,
+                                     48000, resampler);
+        ASSERT_NE(nullptr, mixer);
+
+        std::vector<float> dest(initial);
+        uint32_t dest_offset = 0;
+        // Start partway into the first frame, so that LinearSampler
+        // interpolates every output frame.
+        int32_t frac_src_offset = 0x0A3C;
+        Bookkeeping info;
+        info.step_size = step << kPtsFractionalBits;
+        info.gain.SetSourceGain(gain_db);
+
+        mixer->Mix(dest.data(), kDestFrames, &dest_offset, source.data(),
+                   src_frames << kPtsFractionalBits, &frac_src_offset,
+                   accumulate, &info);
+
+        if (level == SimdLevel::None) {
+          expect = dest;
+          expect_dest_offset = dest_offset;
+          expect_frac_src_offset = frac_src_offset;
+          continue;
+        }
+        EXPECT_EQ(expect_dest_offset, dest_offset);
+        EXPECT_EQ(expect_frac_src_offset, frac_src_offset);
+        for (uint32_t idx = 0; idx < dest.size(); ++idx) {
+          ASSERT_NEAR(expect[idx], dest[idx], tolerance) << "[" << idx << "]";
+        }
+      }
+    }
+  }
+
+  mixer::SetSimdLevel(mixer::DetectSimdLevel());
+}
+
+template <typename SampleType>
+void CompareVectorToScalar(fuchsia::media::AudioSampleFormat format,
+                           Resampler resampler) {
+  for (uint32_t src_chans : {1, 2}) {
+    for (uint32_t dest_chans : {1, 2}) {
+      for (uint32_t src_rate : {48000, 96000}) {
+        // Every length of source that a vector block could overrun. The
+        // SincSampler's kernels read whole filters, so one length suffices.
+        uint32_t num_extra = (resampler == Resampler::WindowedSinc) ? 1 : 16;
+        for (uint32_t extra = 0; extra < num_extra; ++extra) {
+          uint32_t src_frames = (1000 * src_rate / 48000) + extra;
+          CompareVectorToScalar<SampleType>(format, src_chans, dest_chans,
+                                            src_rate, src_frames, resampler);
+        }
+      }
+    }
+  }
+}
+
+TEST(VectorKernels, PointSampler_16) {
+  CompareVectorToScalar<int16_t>(fuchsia::media::AudioSampleFormat::SIGNED_16,
+                                 Resampler::SampleAndHold);
+}
+
+TEST(VectorKernels, PointSampler_Float) {
+  CompareVectorToScalar<float>(fuchsia::media::AudioSampleFormat::FLOAT,
+                               Resampler::SampleAndHold);
+}
+
+TEST(VectorKernels, LinearSampler_16) {
+  CompareVectorToScalar<int16_t>(fuchsia::media::AudioSampleFormat::SIGNED_16,
+                                 Resampler::LinearInterpolation);
+}
+
+TEST(VectorKernels, LinearSampler_Float) {
+  CompareVectorToScalar<float>(fuchsia::media::AudioSampleFormat::FLOAT,
+                               Resampler::LinearInterpolation);
+}
+
+TEST(VectorKernels, SincSampler_16) {
+  CompareVectorToScalar<int16_t>(fuchsia::media::AudioSampleFormat::SIGNED_16,
+                                 Resampler::WindowedSinc);
+}
+
+TEST(VectorKernels, SincSampler_Float) {
+  CompareVectorToScalar<float>(fuchsia::media::AudioSampleFormat::FLOAT,
+                               Resampler::WindowedSinc);
+}
+
+// Produce the same source with the scalar loops and then with each available
+// instruction set. Every source length up to two dither blocks past a whole
+// number leaves a different scalar tail; producing twice checks that the
+// dither generators carry on from one call to the next in the same way.
+template <typename SampleType>
+void CompareVectorProduceToScalar(fuchsia::media::AudioSampleFormat format,
+                                  bool dither) {
+  using mixer::SimdLevel;
+
+  // Range limits, and values exactly halfway between two int16 or int24
+  // outputs, which must round away from zero.
+  const float edges[] = {1.0f,
+                         -1.0f,
+                         0.0f,
+                         -0.0f,
+                         4.0f,
+                         -4.0f,
+                         0.99999994f,
+                         0.5f / kFloatToInt16,
+                         -0.5f / kFloatToInt16,
+                         -2.5f / kFloatToInt16,
+                         32766.5f / kFloatToInt16,
+                         128.5f / kFloatToInt24In32,
+                         -383.5f / kFloatToInt24In32,
+                         -32767.5f / kFloatToInt16};
+
+  for (uint32_t samples = 1000; samples < 1016; ++samples) {
+    std::minstd_rand rng(samples);
+    std::uniform_real_distribution<float> dist(-1.5f, 1.5f);
+    std::vector<float> source(samples);
+    for (auto& val : source) {
+      val = dist(rng);
+    }
+    std::copy(std::begin(edges), std::end(edges), source.begin());
+
+    std::vector<SampleType> expect;
+    for (SimdLevel level : {SimdLevel::None, SimdLevel::Sse2, SimdLevel::Avx2,
+                            SimdLevel::Neon}) {
+      if (!mixer::SetSimdLevel(level)) {
+        continue;
+      }
+      SCOPED_TRACE(testing::Message() << mixer::SimdLevelName(level) << ", "
+                                      << samples << " samples"
+                                      << (dither ? ", dithered" : ""));
+
+      OutputProducerPtr output_producer = SelectOutputProducer(format, 1);
+      ASSERT_NE(nullptr, output_producer);
+      output_producer->set_dither(dither);
+
+      std::vector<SampleType> dest(samples * 2);
+      output_producer->ProduceOutput(source.data(), dest.data(), samples);
+      output_producer->ProduceOutput(source.data(), dest.data() + samples,
+                                     samples);
+
+      if (level == SimdLevel::None) {
+        expect = dest;
+        continue;
+      }
+      for (uint32_t idx = 0; idx < dest.size(); ++idx) {
+        ASSERT_EQ(expect[idx], dest[idx]) << "[" << idx << "]";
+      }
+    }
+  }
+
+  mixer::SetSimdLevel(mixer::DetectSimdLevel());
+}
+
+TEST(VectorKernels, OutputProducer_16) {
+  CompareVectorProduceToScalar<int16_t>(
+      fuchsia::media::AudioSampleFormat::SIGNED_16, false);
+  CompareVectorProduceToScalar<int16_t>(
+      fuchsia::media::AudioSampleFormat::SIGNED_16, true);
+}
+
+TEST(VectorKernels, OutputProducer_24) {
+  CompareVectorProduceToScalar<int32_t>(
+      fuchsia::media::AudioSampleFormat::SIGNED_24_IN_32, false);
+  CompareVectorProduceToScalar<int32_t>(
+      fuchsia::media::AudioSampleFormat::SIGNED_24_IN_32, true);
+}
+
+TEST(VectorKernels, OutputProducer_Float) {
+  CompareVectorProduceToScalar<float>(fuchsia::media::AudioSampleFormat::FLOAT,
+                                      false);
+  // Float output ignores the dither setting.
+  CompareVectorProduceToScalar<float>(fuchsia::media::AudioSampleFormat::FLOAT,
+                                      true);
+}
+
+// Dither moves each output sample by at most one LSB, and on average not at
+// all: a value a quarter of the way between two outputs averages out there.
+TEST(VectorKernels, OutputProducer_Dither) {
+  constexpr uint32_t kSamples = 48000;
+  std::vector<float> source(kSamples, 100.25f / kFloatToInt16);
+  std::vector<int16_t> dest(kSamples);
+
+  OutputProducerPtr output_producer =
+      SelectOutputProducer(fuchsia::media::AudioSampleFormat::SIGNED_16, 2);
+  ASSERT_NE(nullptr, output_producer);
+  EXPECT_FALSE(output_producer->dither());
+
+  output_producer->ProduceOutput(source.data(), dest.data(), kSamples / 2);
+  EXPECT_TRUE(CompareBufferToVal(dest.data(), static_cast<int16_t>(100),
+                                 kSamples));
+
+  output_producer->set_dither(true);
+  output_producer->ProduceOutput(source.data(), dest.data(), kSamples / 2);
+  double sum = 0.0;
+  for (auto val : dest) {
+    ASSERT_GE(val, 99);
+    ASSERT_LE(val, 101);
+    sum += val;
+  }
+  EXPECT_NEAR(100.25, sum / kSamples, 0.02);
+}
+
+// Producing from several buffers gives what producing from their sum would,
+// whether or not it dithers.
+TEST(VectorKernels, OutputProducer_Sources) {
+  constexpr uint32_t kFrames = 1001;
+  constexpr uint32_t kChans = 2;
+  constexpr uint32_t kNumSources = 3;
+
+  std::minstd_rand rng(kFrames);
+  std::vector<std::vector<float>> sources(
+      kNumSources, std::vector<float>(kFrames * kChans));
+  const float* source_ptrs[kNumSources];
+  for (uint32_t source = 0; source < kNumSources; ++source) {
+    FillRandom(&rng, &sources[source]);
+    source_ptrs[source] = sources[source].data();
+  }
+
+  std::vector<float> sum(sources[0]);
+  for (uint32_t source = 1; source < kNumSources; ++source) {
+    for (uint32_t idx = 0; idx < sum.size(); ++idx) {
+      sum[idx] += sources[source][idx];
+    }
+  }
+
+  for (bool dither : {false, true}) {
+    SCOPED_TRACE(dither ? "dithered" : "undithered");
+    OutputProducerPtr summed = SelectOutputProducer(
+        fuchsia::media::AudioSampleFormat::SIGNED_16, kChans);
+    OutputProducerPtr fused = SelectOutputProducer(
+        fuchsia::media::AudioSampleFormat::SIGNED_16, kChans);
+    summed->set_dither(dither);
+    fused->set_dither(dither);
+
+    std::vector<int16_t> expect(kFrames * kChans);
+    std::vector<int16_t> dest(kFrames * kChans);
+    summed->ProduceOutput(sum.data(), expect.data(), kFrames);
+    fused->ProduceOutput(source_ptrs, kNumSources, dest.data(), kFrames);
+    EXPECT_TRUE(CompareBuffers(dest.data(), expect.data(), dest.size()));
+
+    // A single source is simply produced.
+    summed->ProduceOutput(source_ptrs[0], expect.data(), kFrames);
+    fused->ProduceOutput(source_ptrs, 1, dest.data(), kFrames);
+    EXPECT_TRUE(CompareBuffers(dest.data(), expect.data(), dest.size()));
+  }
+}
+
 }  // namespace test
 }  // namespace audio
 }  // namespace media
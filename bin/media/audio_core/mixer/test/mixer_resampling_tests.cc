@@ -3,6 +3,8 @@
 // found in the LICENSE file.
 
 #include <fbl/algorithm.h>
+#include <random>
+#include <vector>
 
 #include "garnet/bin/media/audio_core/mixer/no_op.h"
 #include "garnet/bin/media/audio_core/mixer/test/mixer_tests_shared.h"
@@ -664,6 +666,90 @@ TEST(Resampling, FilterWidth_Linear) {
   EXPECT_EQ(mixer->neg_filter_width(), Mixer::FRAC_ONE - 1);
 }
 
+// Verify SincSampler filter widths, which grow as the filter's cutoff is
+// lowered for downsampling.
+TEST(Resampling, FilterWidth_Sinc) {
+  MixerPtr mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 1,
+                               44100, 1, 48000, Resampler::WindowedSinc);
+
+  EXPECT_EQ(mixer->pos_filter_width(), 32 * Mixer::FRAC_ONE - 1);
+  EXPECT_EQ(mixer->neg_filter_width(), 32 * Mixer::FRAC_ONE - 1);
+
+  mixer->Reset();
+
+  EXPECT_EQ(mixer->pos_filter_width(), 32 * Mixer::FRAC_ONE - 1);
+  EXPECT_EQ(mixer->neg_filter_width(), 32 * Mixer::FRAC_ONE - 1);
+
+  mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 1, 96000, 1,
+                      48000, Resampler::WindowedSinc);
+
+  EXPECT_EQ(mixer->pos_filter_width(), 64 * Mixer::FRAC_ONE - 1);
+  EXPECT_EQ(mixer->neg_filter_width(), 64 * Mixer::FRAC_ONE - 1);
+}
+
+// Mix |source| into |dest| as the output pipeline would, delivering it in
+// packets of the given lengths (in frames) and stepping from each packet to
+// the next once the mixer has consumed it. Returns the dest frames produced.
+uint32_t MixSincPackets(const std::vector<float>& source, uint32_t num_chans,
+                        const std::vector<uint32_t>& packet_frames,
+                        float* dest, uint32_t dest_frames) {
+  Bookkeeping info;
+  info.mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, num_chans,
+                           44100, num_chans, 48000, Resampler::WindowedSinc);
+  info.step_size = 7526;  // 44100/48000, with 19200/48000 more per frame.
+  info.rate_modulo = 19200;
+  info.denominator = 48000;
+
+  uint32_t dest_offset = 0;
+  int32_t frac_src_offset = 0;
+  const float* packet = source.data();
+  for (uint32_t frames : packet_frames) {
+    uint32_t frac_src_frames = frames << kPtsFractionalBits;
+    if (!info.mixer->Mix(dest, dest_frames, &dest_offset, packet,
+                         frac_src_frames, &frac_src_offset, false, &info)) {
+      break;
+    }
+    frac_src_offset -= frac_src_frames;
+    packet += frames * num_chans;
+  }
+  return dest_offset;
+}
+
+// Verify that SincSampler produces the same output whether its source arrives
+// in one buffer or spread across packets, including packets shorter than its
+// filter: it must carry over the frames that the next packet still needs.
+TEST(Resampling, Packets_Sinc) {
+  constexpr uint32_t kNumChans = 2;
+  const std::vector<uint32_t> kPacketFrames = {300, 7, 1,  63, 64,
+                                               65,  2, 500, 17, 981};
+  uint32_t src_frames = 0;
+  for (uint32_t frames : kPacketFrames) {
+    src_frames += frames;
+  }
+  const uint32_t dest_frames = src_frames * 48000 / 44100;
+
+  std::minstd_rand rng(kNumChans);
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> source(src_frames * kNumChans);
+  for (auto& val : source) {
+    val = dist(rng);
+  }
+
+  std::vector<float> expect(dest_frames * kNumChans);
+  uint32_t expect_frames = MixSincPackets(source, kNumChans, {src_frames},
+                                          expect.data(), dest_frames);
+  std::vector<float> dest(dest_frames * kNumChans);
+  EXPECT_EQ(expect_frames, MixSincPackets(source, kNumChans, kPacketFrames,
+                                          dest.data(), dest_frames));
+
+  // The final packet ends on the same frame in either case, so both mixes stop
+  // short of dest_frames in the same place.
+  EXPECT_GT(expect_frames, dest_frames / 2);
+  EXPECT_LT(expect_frames, dest_frames);
+  EXPECT_TRUE(CompareBuffers(dest.data(), expect.data(),
+                             expect_frames * kNumChans));
+}
+
 // Verify LinearSampler::Reset clears out any cached "previous edge" values.
 // Earlier test (Position_Fractional_Linear) already validates
 // that LinearSampler correctly caches edge values, so just validate Reset.
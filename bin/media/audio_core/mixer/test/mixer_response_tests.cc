@@ -2,6 +2,7 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <zircon/syscalls.h>
 #include <iomanip>
 
 #include "garnet/bin/media/audio_core/mixer/test/audio_result.h"
@@ -261,11 +262,22 @@ TEST(NoiseFloor, Output_Float) {
       << std::setprecision(10) << AudioResult::FloorOutputFloat;
 }
 
+// CPU time that the calling thread has used so far. Unlike the monotonic clock,
+// this does not advance while the thread is preempted or descheduled.
+zx_duration_t ThreadRuntime() {
+  zx_info_thread_stats_t info;
+  zx_status_t status =
+      zx_object_get_info(zx_thread_self(), ZX_INFO_THREAD_STATS, &info,
+                         sizeof(info), nullptr, nullptr);
+  FXL_DCHECK(status == ZX_OK);
+  return info.total_runtime;
+}
+
 // Ideal frequency response measurement is 0.00 dB across the audible spectrum
 // Ideal SINAD is at least 6 dB per signal-bit (>96 dB, if 16-bit resolution).
 // If UseFullFrequencySet is false, we test at only three summary frequencies.
 void MeasureFreqRespSinad(MixerPtr mixer, uint32_t src_buf_size,
-                          double* level_db, double* sinad_db) {
+                          double* level_db, double* sinad_db, double* cost_us) {
   if (!std::isnan(level_db[0])) {
     // This run already has frequency response and SINAD test results for this
     // sampler and resampling ratio; don't waste time and cycles rerunning it.
@@ -275,11 +287,14 @@ void MeasureFreqRespSinad(MixerPtr mixer, uint32_t src_buf_size,
   // test does not later rerun this combination of sampler and resample ratio.
   level_db[0] = -INFINITY;
 
-  // Vector source[] has an additional element because depending on resampling
-  // ratio, some resamplers need it in order to produce the final dest value.
   // All FFT inputs are considered periodic, so to generate a periodic output
-  // from the resampler, this extra source element should equal source[0].
-  std::vector<float> source(src_buf_size + 1);
+  // from the resampler, source[] holds a periodic signal, with as many extra
+  // frames on either side as the filter needs to produce every dest value. For
+  // the point and linear samplers, this is a single extra element at the end,
+  // equal to source[0]; wider filters also need frames before source[0].
+  uint32_t pre_frames = mixer->neg_filter_width() >> kPtsFractionalBits;
+  uint32_t post_frames = (mixer->pos_filter_width() >> kPtsFractionalBits) + 1;
+  std::vector<float> source(pre_frames + src_buf_size + post_frames);
   std::vector<float> accum(kFreqTestBufSize);
 
   Bookkeeping info;
@@ -295,6 +310,10 @@ void MeasureFreqRespSinad(MixerPtr mixer, uint32_t src_buf_size,
                            ? FrequencySet::kReferenceFreqs.size()
                            : FrequencySet::kSummaryIdxs.size();
 
+  // Total thread CPU time spent in Mix, across all frequencies.
+  zx_duration_t mix_time = 0;
+  uint32_t num_mixes = 0;
+
   // Measure level response for each frequency.
   for (uint32_t idx = 0; idx < num_freqs; ++idx) {
     // If full-spectrum testing, test at every frequency in kReferenceFreqs[];
@@ -310,10 +329,17 @@ void MeasureFreqRespSinad(MixerPtr mixer, uint32_t src_buf_size,
       continue;
     }
 
-    // Populate the source buffer with a sinusoid at each reference frequency.
-    OverwriteCosine(source.data(), src_buf_size,
+    // Populate the source buffer with a sinusoid at each reference frequency,
+    // then extend it periodically on either side.
+    float* period = source.data() + pre_frames;
+    OverwriteCosine(period, src_buf_size,
                     FrequencySet::kReferenceFreqs[freq_idx]);
-    source[src_buf_size] = source[0];
+    for (uint32_t idx = 0; idx < pre_frames; ++idx) {
+      source[idx] = period[src_buf_size - pre_frames + idx];
+    }
+    for (uint32_t idx = 0; idx < post_frames; ++idx) {
+      period[src_buf_size + idx] = period[idx % src_buf_size];
+    }
 
     // Resample the source into the accumulation buffer, in pieces. (Why in
     // pieces? See description of kResamplerTestNumPackets in frequency_set.h.)
@@ -325,18 +351,22 @@ void MeasureFreqRespSinad(MixerPtr mixer, uint32_t src_buf_size,
     // then reset it each time we start testing a new input signal frequency.
     info.src_pos_modulo = 0;
 
+    zx_duration_t start_time = ThreadRuntime();
     for (uint32_t packet = 0; packet < kResamplerTestNumPackets; ++packet) {
       dest_frames = kFreqTestBufSize * (packet + 1) / kResamplerTestNumPackets;
       dest_offset = kFreqTestBufSize * packet / kResamplerTestNumPackets;
       frac_src_offset =
-          (static_cast<int64_t>(src_buf_size) * Mixer::FRAC_ONE * packet) /
-          kResamplerTestNumPackets;
+          ((static_cast<int64_t>(src_buf_size) * Mixer::FRAC_ONE * packet) /
+           kResamplerTestNumPackets) +
+          (pre_frames * Mixer::FRAC_ONE);
 
       mixer->Mix(accum.data(), dest_frames, &dest_offset, source.data(),
                  frac_src_frames, &frac_src_offset, false, &info);
 
       EXPECT_EQ(dest_frames, dest_offset);
     }
+    mix_time += ThreadRuntime() - start_time;
+    ++num_mixes;
 
     // Copy results to double[], for high-resolution frequency analysis (FFT).
     double magn_signal = -INFINITY, magn_other = INFINITY;
@@ -348,6 +378,12 @@ void MeasureFreqRespSinad(MixerPtr mixer, uint32_t src_buf_size,
     level_db[freq_idx] = ValToDb(magn_signal);
     sinad_db[freq_idx] = ValToDb(magn_signal / magn_other);
   }
+
+  // Each run mixed kFreqTestBufSize frames, which we treat as 48 kHz output.
+  if (num_mixes > 0) {
+    *cost_us = (static_cast<double>(mix_time) / ZX_USEC(1)) / num_mixes *
+               (48000.0 / kFreqTestBufSize);
+  }
 }
 
 // Given result and limit arrays, compare them as frequency response results.
@@ -397,78 +433,79 @@ void EvaluateSinadResults(double* sinad_results, const double* sinad_limits,
 // For the given resampler, measure frequency response and sinad at unity (no
 // SRC). We articulate this with source buffer length equal to dest length.
 void TestUnitySampleRatio(Resampler sampler_type, double* freq_resp_results,
-                          double* sinad_results) {
+                          double* sinad_results, double* cost_us) {
   MixerPtr mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 1,
                                48000, 1, 48000, sampler_type);
 
   MeasureFreqRespSinad(std::move(mixer), kFreqTestBufSize, freq_resp_results,
-                       sinad_results);
+                       sinad_results, cost_us);
 }
 
 // For the given resampler, target a 2:1 downsampling ratio. We articulate this
 // by specifying a source buffer twice the length of the destination buffer.
 void TestDownSampleRatio1(Resampler sampler_type, double* freq_resp_results,
-                          double* sinad_results) {
+                          double* sinad_results, double* cost_us) {
   MixerPtr mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 1,
                                96000, 1, 48000, sampler_type);
 
   MeasureFreqRespSinad(std::move(mixer),
                        round(kFreqTestBufSize * 96000.0 / 48000.0),
-                       freq_resp_results, sinad_results);
+                       freq_resp_results, sinad_results, cost_us);
 }
 
 // For the given resampler, target 88200->48000 downsampling. We articulate this
 // by specifying a source buffer longer than destination buffer by that ratio.
 void TestDownSampleRatio2(Resampler sampler_type, double* freq_resp_results,
-                          double* sinad_results) {
+                          double* sinad_results, double* cost_us) {
   MixerPtr mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 1,
                                88200, 1, 48000, sampler_type);
 
   MeasureFreqRespSinad(std::move(mixer),
                        round(kFreqTestBufSize * 88200.0 / 48000.0),
-                       freq_resp_results, sinad_results);
+                       freq_resp_results, sinad_results, cost_us);
 }
 
 // For the given resampler, target 44100->48000 upsampling. We articulate this
 // by specifying a source buffer shorter than destination buffer by that ratio.
 void TestUpSampleRatio1(Resampler sampler_type, double* freq_resp_results,
-                        double* sinad_results) {
+                        double* sinad_results, double* cost_us) {
   MixerPtr mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 1,
                                44100, 1, 48000, sampler_type);
 
   MeasureFreqRespSinad(std::move(mixer),
                        round(kFreqTestBufSize * 44100.0 / 48000.0),
-                       freq_resp_results, sinad_results);
+                       freq_resp_results, sinad_results, cost_us);
 }
 
 // For the given resampler, target the 1:2 upsampling ratio. We articulate this
 // by specifying a source buffer at half the length of the destination buffer.
 void TestUpSampleRatio2(Resampler sampler_type, double* freq_resp_results,
-                        double* sinad_results) {
+                        double* sinad_results, double* cost_us) {
   MixerPtr mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 1,
                                24000, 1, 48000, sampler_type);
 
   MeasureFreqRespSinad(std::move(mixer),
                        round(kFreqTestBufSize * 24000.0 / 48000.0),
-                       freq_resp_results, sinad_results);
+                       freq_resp_results, sinad_results, cost_us);
 }
 
 // For the given resampler, target micro-sampling -- with a 47999:48000 ratio.
 void TestMicroSampleRatio(Resampler sampler_type, double* freq_resp_results,
-                          double* sinad_results) {
+                          double* sinad_results, double* cost_us) {
   MixerPtr mixer = SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, 1,
                                47999, 1, 48000, sampler_type);
 
   MeasureFreqRespSinad(std::move(mixer),
                        round(kFreqTestBufSize * 47999.0 / 48000.0),
-                       freq_resp_results, sinad_results);
+                       freq_resp_results, sinad_results, cost_us);
 }
 
 // Measure Freq Response for Point sampler, no rate conversion.
 TEST(FrequencyResponse, Point_Unity) {
   TestUnitySampleRatio(Resampler::SampleAndHold,
                        AudioResult::FreqRespPointUnity.data(),
-                       AudioResult::SinadPointUnity.data());
+                       AudioResult::SinadPointUnity.data(),
+                       &AudioResult::CostPointUnity);
 
   EvaluateFreqRespResults(AudioResult::FreqRespPointUnity.data(),
                           AudioResult::kPrevFreqRespPointUnity.data());
@@ -478,7 +515,8 @@ TEST(FrequencyResponse, Point_Unity) {
 TEST(Sinad, Point_Unity) {
   TestUnitySampleRatio(Resampler::SampleAndHold,
                        AudioResult::FreqRespPointUnity.data(),
-                       AudioResult::SinadPointUnity.data());
+                       AudioResult::SinadPointUnity.data(),
+                       &AudioResult::CostPointUnity);
 
   EvaluateSinadResults(AudioResult::SinadPointUnity.data(),
                        AudioResult::kPrevSinadPointUnity.data());
@@ -488,7 +526,8 @@ TEST(Sinad, Point_Unity) {
 TEST(FrequencyResponse, Point_DownSamp1) {
   TestDownSampleRatio1(Resampler::SampleAndHold,
                        AudioResult::FreqRespPointDown1.data(),
-                       AudioResult::SinadPointDown1.data());
+                       AudioResult::SinadPointDown1.data(),
+                       &AudioResult::CostPointDown1);
 
   EvaluateFreqRespResults(AudioResult::FreqRespPointDown1.data(),
                           AudioResult::kPrevFreqRespPointDown1.data());
@@ -498,7 +537,8 @@ TEST(FrequencyResponse, Point_DownSamp1) {
 TEST(Sinad, Point_DownSamp1) {
   TestDownSampleRatio1(Resampler::SampleAndHold,
                        AudioResult::FreqRespPointDown1.data(),
-                       AudioResult::SinadPointDown1.data());
+                       AudioResult::SinadPointDown1.data(),
+                       &AudioResult::CostPointDown1);
 
   EvaluateSinadResults(AudioResult::SinadPointDown1.data(),
                        AudioResult::kPrevSinadPointDown1.data());
@@ -508,7 +548,8 @@ TEST(Sinad, Point_DownSamp1) {
 TEST(FrequencyResponse, Point_DownSamp2) {
   TestDownSampleRatio2(Resampler::SampleAndHold,
                        AudioResult::FreqRespPointDown2.data(),
-                       AudioResult::SinadPointDown2.data());
+                       AudioResult::SinadPointDown2.data(),
+                       &AudioResult::CostPointDown2);
 
   EvaluateFreqRespResults(AudioResult::FreqRespPointDown2.data(),
                           AudioResult::kPrevFreqRespPointDown2.data());
@@ -518,7 +559,8 @@ TEST(FrequencyResponse, Point_DownSamp2) {
 TEST(Sinad, Point_DownSamp2) {
   TestDownSampleRatio2(Resampler::SampleAndHold,
                        AudioResult::FreqRespPointDown2.data(),
-                       AudioResult::SinadPointDown2.data());
+                       AudioResult::SinadPointDown2.data(),
+                       &AudioResult::CostPointDown2);
 
   EvaluateSinadResults(AudioResult::SinadPointDown2.data(),
                        AudioResult::kPrevSinadPointDown2.data());
@@ -528,7 +570,8 @@ TEST(Sinad, Point_DownSamp2) {
 TEST(FrequencyResponse, Point_UpSamp1) {
   TestUpSampleRatio1(Resampler::SampleAndHold,
                      AudioResult::FreqRespPointUp1.data(),
-                     AudioResult::SinadPointUp1.data());
+                     AudioResult::SinadPointUp1.data(),
+                     &AudioResult::CostPointUp1);
 
   EvaluateFreqRespResults(AudioResult::FreqRespPointUp1.data(),
                           AudioResult::kPrevFreqRespPointUp1.data());
@@ -538,7 +581,8 @@ TEST(FrequencyResponse, Point_UpSamp1) {
 TEST(Sinad, Point_UpSamp1) {
   TestUpSampleRatio1(Resampler::SampleAndHold,
                      AudioResult::FreqRespPointUp1.data(),
-                     AudioResult::SinadPointUp1.data());
+                     AudioResult::SinadPointUp1.data(),
+                     &AudioResult::CostPointUp1);
 
   EvaluateSinadResults(AudioResult::SinadPointUp1.data(),
                        AudioResult::kPrevSinadPointUp1.data());
@@ -548,7 +592,8 @@ TEST(Sinad, Point_UpSamp1) {
 TEST(FrequencyResponse, Point_UpSamp2) {
   TestUpSampleRatio2(Resampler::SampleAndHold,
                      AudioResult::FreqRespPointUp2.data(),
-                     AudioResult::SinadPointUp2.data());
+                     AudioResult::SinadPointUp2.data(),
+                     &AudioResult::CostPointUp2);
 
   EvaluateFreqRespResults(AudioResult::FreqRespPointUp2.data(),
                           AudioResult::kPrevFreqRespPointUp2.data());
@@ -558,7 +603,8 @@ TEST(FrequencyResponse, Point_UpSamp2) {
 TEST(Sinad, Point_UpSamp2) {
   TestUpSampleRatio2(Resampler::SampleAndHold,
                      AudioResult::FreqRespPointUp2.data(),
-                     AudioResult::SinadPointUp2.data());
+                     AudioResult::SinadPointUp2.data(),
+                     &AudioResult::CostPointUp2);
 
   EvaluateSinadResults(AudioResult::SinadPointUp2.data(),
                        AudioResult::kPrevSinadPointUp2.data());
@@ -568,7 +614,8 @@ TEST(Sinad, Point_UpSamp2) {
 TEST(FrequencyResponse, Point_MicroSRC) {
   TestMicroSampleRatio(Resampler::SampleAndHold,
                        AudioResult::FreqRespPointMicro.data(),
-                       AudioResult::SinadPointMicro.data());
+                       AudioResult::SinadPointMicro.data(),
+                       &AudioResult::CostPointMicro);
 
   EvaluateFreqRespResults(AudioResult::FreqRespPointMicro.data(),
                           AudioResult::kPrevFreqRespPointMicro.data());
@@ -578,7 +625,8 @@ TEST(FrequencyResponse, Point_MicroSRC) {
 TEST(Sinad, Point_MicroSRC) {
   TestMicroSampleRatio(Resampler::SampleAndHold,
                        AudioResult::FreqRespPointMicro.data(),
-                       AudioResult::SinadPointMicro.data());
+                       AudioResult::SinadPointMicro.data(),
+                       &AudioResult::CostPointMicro);
 
   EvaluateSinadResults(AudioResult::SinadPointMicro.data(),
                        AudioResult::kPrevSinadPointMicro.data());
@@ -588,7 +636,8 @@ TEST(Sinad, Point_MicroSRC) {
 TEST(FrequencyResponse, Linear_Unity) {
   TestUnitySampleRatio(Resampler::LinearInterpolation,
                        AudioResult::FreqRespLinearUnity.data(),
-                       AudioResult::SinadLinearUnity.data());
+                       AudioResult::SinadLinearUnity.data(),
+                       &AudioResult::CostLinearUnity);
 
   EvaluateFreqRespResults(AudioResult::FreqRespLinearUnity.data(),
                           AudioResult::kPrevFreqRespLinearUnity.data());
@@ -598,7 +647,8 @@ TEST(FrequencyResponse, Linear_Unity) {
 TEST(Sinad, Linear_Unity) {
   TestUnitySampleRatio(Resampler::LinearInterpolation,
                        AudioResult::FreqRespLinearUnity.data(),
-                       AudioResult::SinadLinearUnity.data());
+                       AudioResult::SinadLinearUnity.data(),
+                       &AudioResult::CostLinearUnity);
 
   EvaluateSinadResults(AudioResult::SinadLinearUnity.data(),
                        AudioResult::kPrevSinadLinearUnity.data());
@@ -608,7 +658,8 @@ TEST(Sinad, Linear_Unity) {
 TEST(FrequencyResponse, Linear_DownSamp1) {
   TestDownSampleRatio1(Resampler::LinearInterpolation,
                        AudioResult::FreqRespLinearDown1.data(),
-                       AudioResult::SinadLinearDown1.data());
+                       AudioResult::SinadLinearDown1.data(),
+                       &AudioResult::CostLinearDown1);
 
   EvaluateFreqRespResults(AudioResult::FreqRespLinearDown1.data(),
                           AudioResult::kPrevFreqRespLinearDown1.data());
@@ -618,7 +669,8 @@ TEST(FrequencyResponse, Linear_DownSamp1) {
 TEST(Sinad, Linear_DownSamp1) {
   TestDownSampleRatio1(Resampler::LinearInterpolation,
                        AudioResult::FreqRespLinearDown1.data(),
-                       AudioResult::SinadLinearDown1.data());
+                       AudioResult::SinadLinearDown1.data(),
+                       &AudioResult::CostLinearDown1);
 
   EvaluateSinadResults(AudioResult::SinadLinearDown1.data(),
                        AudioResult::kPrevSinadLinearDown1.data());
@@ -628,7 +680,8 @@ TEST(Sinad, Linear_DownSamp1) {
 TEST(FrequencyResponse, Linear_DownSamp2) {
   TestDownSampleRatio2(Resampler::LinearInterpolation,
                        AudioResult::FreqRespLinearDown2.data(),
-                       AudioResult::SinadLinearDown2.data());
+                       AudioResult::SinadLinearDown2.data(),
+                       &AudioResult::CostLinearDown2);
 
   EvaluateFreqRespResults(AudioResult::FreqRespLinearDown2.data(),
                           AudioResult::kPrevFreqRespLinearDown2.data());
@@ -638,7 +691,8 @@ TEST(FrequencyResponse, Linear_DownSamp2) {
 TEST(Sinad, Linear_DownSamp2) {
   TestDownSampleRatio2(Resampler::LinearInterpolation,
                        AudioResult::FreqRespLinearDown2.data(),
-                       AudioResult::SinadLinearDown2.data());
+                       AudioResult::SinadLinearDown2.data(),
+                       &AudioResult::CostLinearDown2);
 
   EvaluateSinadResults(AudioResult::SinadLinearDown2.data(),
                        AudioResult::kPrevSinadLinearDown2.data());
@@ -648,7 +702,8 @@ TEST(Sinad, Linear_DownSamp2) {
 TEST(FrequencyResponse, Linear_UpSamp1) {
   TestUpSampleRatio1(Resampler::LinearInterpolation,
                      AudioResult::FreqRespLinearUp1.data(),
-                     AudioResult::SinadLinearUp1.data());
+                     AudioResult::SinadLinearUp1.data(),
+                     &AudioResult::CostLinearUp1);
 
   EvaluateFreqRespResults(AudioResult::FreqRespLinearUp1.data(),
                           AudioResult::kPrevFreqRespLinearUp1.data());
@@ -658,7 +713,8 @@ TEST(FrequencyResponse, Linear_UpSamp1) {
 TEST(Sinad, Linear_UpSamp1) {
   TestUpSampleRatio1(Resampler::LinearInterpolation,
                      AudioResult::FreqRespLinearUp1.data(),
-                     AudioResult::SinadLinearUp1.data());
+                     AudioResult::SinadLinearUp1.data(),
+                     &AudioResult::CostLinearUp1);
 
   EvaluateSinadResults(AudioResult::SinadLinearUp1.data(),
                        AudioResult::kPrevSinadLinearUp1.data());
@@ -668,7 +724,8 @@ TEST(Sinad, Linear_UpSamp1) {
 TEST(FrequencyResponse, Linear_UpSamp2) {
   TestUpSampleRatio2(Resampler::LinearInterpolation,
                      AudioResult::FreqRespLinearUp2.data(),
-                     AudioResult::SinadLinearUp2.data());
+                     AudioResult::SinadLinearUp2.data(),
+                     &AudioResult::CostLinearUp2);
 
   EvaluateFreqRespResults(AudioResult::FreqRespLinearUp2.data(),
                           AudioResult::kPrevFreqRespLinearUp2.data());
@@ -678,7 +735,8 @@ TEST(FrequencyResponse, Linear_UpSamp2) {
 TEST(Sinad, Linear_UpSamp2) {
   TestUpSampleRatio2(Resampler::LinearInterpolation,
                      AudioResult::FreqRespLinearUp2.data(),
-                     AudioResult::SinadLinearUp2.data());
+                     AudioResult::SinadLinearUp2.data(),
+                     &AudioResult::CostLinearUp2);
 
   EvaluateSinadResults(AudioResult::SinadLinearUp2.data(),
                        AudioResult::kPrevSinadLinearUp2.data());
@@ -688,7 +746,8 @@ TEST(Sinad, Linear_UpSamp2) {
 TEST(FrequencyResponse, Linear_MicroSRC) {
   TestMicroSampleRatio(Resampler::LinearInterpolation,
                        AudioResult::FreqRespLinearMicro.data(),
-                       AudioResult::SinadLinearMicro.data());
+                       AudioResult::SinadLinearMicro.data(),
+                       &AudioResult::CostLinearMicro);
 
   EvaluateFreqRespResults(AudioResult::FreqRespLinearMicro.data(),
                           AudioResult::kPrevFreqRespLinearMicro.data());
@@ -698,16 +757,151 @@ TEST(FrequencyResponse, Linear_MicroSRC) {
 TEST(Sinad, Linear_MicroSRC) {
   TestMicroSampleRatio(Resampler::LinearInterpolation,
                        AudioResult::FreqRespLinearMicro.data(),
-                       AudioResult::SinadLinearMicro.data());
+                       AudioResult::SinadLinearMicro.data(),
+                       &AudioResult::CostLinearMicro);
 
   EvaluateSinadResults(AudioResult::SinadLinearMicro.data(),
                        AudioResult::kPrevSinadLinearMicro.data());
 }
 
+// Measure Freq Response for Sinc sampler, no rate conversion.
+TEST(FrequencyResponse, Sinc_Unity) {
+  TestUnitySampleRatio(Resampler::WindowedSinc,
+                       AudioResult::FreqRespSincUnity.data(),
+                       AudioResult::SinadSincUnity.data(),
+                       &AudioResult::CostSincUnity);
+
+  EvaluateFreqRespResults(AudioResult::FreqRespSincUnity.data(),
+                          AudioResult::kPrevFreqRespSincUnity.data());
+}
+
+// Measure SINAD for Sinc sampler, no rate conversion.
+TEST(Sinad, Sinc_Unity) {
+  TestUnitySampleRatio(Resampler::WindowedSinc,
+                       AudioResult::FreqRespSincUnity.data(),
+                       AudioResult::SinadSincUnity.data(),
+                       &AudioResult::CostSincUnity);
+
+  EvaluateSinadResults(AudioResult::SinadSincUnity.data(),
+                       AudioResult::kPrevSinadSincUnity.data());
+}
+
+// Measure Freq Response for Sinc sampler, first down-sampling ratio.
+TEST(FrequencyResponse, Sinc_DownSamp1) {
+  TestDownSampleRatio1(Resampler::WindowedSinc,
+                       AudioResult::FreqRespSincDown1.data(),
+                       AudioResult::SinadSincDown1.data(),
+                       &AudioResult::CostSincDown1);
+
+  EvaluateFreqRespResults(AudioResult::FreqRespSincDown1.data(),
+                          AudioResult::kPrevFreqRespSincDown1.data());
+}
+
+// Measure SINAD for Sinc sampler, first down-sampling ratio.
+TEST(Sinad, Sinc_DownSamp1) {
+  TestDownSampleRatio1(Resampler::WindowedSinc,
+                       AudioResult::FreqRespSincDown1.data(),
+                       AudioResult::SinadSincDown1.data(),
+                       &AudioResult::CostSincDown1);
+
+  EvaluateSinadResults(AudioResult::SinadSincDown1.data(),
+                       AudioResult::kPrevSinadSincDown1.data());
+}
+
+// Measure Freq Response for Sinc sampler, second down-sampling ratio.
+TEST(FrequencyResponse, Sinc_DownSamp2) {
+  TestDownSampleRatio2(Resampler::WindowedSinc,
+                       AudioResult::FreqRespSincDown2.data(),
+                       AudioResult::SinadSincDown2.data(),
+                       &AudioResult::CostSincDown2);
+
+  EvaluateFreqRespResults(AudioResult::FreqRespSincDown2.data(),
+                          AudioResult::kPrevFreqRespSincDown2.data());
+}
+
+// Measure SINAD for Sinc sampler, second down-sampling ratio.
+TEST(Sinad, Sinc_DownSamp2) {
+  TestDownSampleRatio2(Resampler::WindowedSinc,
+                       AudioResult::FreqRespSincDown2.data(),
+                       AudioResult::SinadSincDown2.data(),
+                       &AudioResult::CostSincDown2);
+
+  EvaluateSinadResults(AudioResult::SinadSincDown2.data(),
+                       AudioResult::kPrevSinadSincDown2.data());
+}
+
+// Measure Freq Response for Sinc sampler, first up-sampling ratio.
+TEST(FrequencyResponse, Sinc_UpSamp1) {
+  TestUpSampleRatio1(Resampler::WindowedSinc,
+                     AudioResult::FreqRespSincUp1.data(),
+                     AudioResult::SinadSincUp1.data(),
+                     &AudioResult::CostSincUp1);
+
+  EvaluateFreqRespResults(AudioResult::FreqRespSincUp1.data(),
+                          AudioResult::kPrevFreqRespSincUp1.data());
+}
+
+// Measure SINAD for Sinc sampler, first up-sampling ratio.
+TEST(Sinad, Sinc_UpSamp1) {
+  TestUpSampleRatio1(Resampler::WindowedSinc,
+                     AudioResult::FreqRespSincUp1.data(),
+                     AudioResult::SinadSincUp1.data(),
+                     &AudioResult::CostSincUp1);
+
+  EvaluateSinadResults(AudioResult::SinadSincUp1.data(),
+                       AudioResult::kPrevSinadSincUp1.data());
+}
+
+// Measure Freq Response for Sinc sampler, second up-sampling ratio.
+TEST(FrequencyResponse, Sinc_UpSamp2) {
+  TestUpSampleRatio2(Resampler::WindowedSinc,
+                     AudioResult::FreqRespSincUp2.data(),
+                     AudioResult::SinadSincUp2.data(),
+                     &AudioResult::CostSincUp2);
+
+  EvaluateFreqRespResults(AudioResult::FreqRespSincUp2.data(),
+                          AudioResult::kPrevFreqRespSincUp2.data());
+}
+
+// Measure SINAD for Sinc sampler, second up-sampling ratio.
+TEST(Sinad, Sinc_UpSamp2) {
+  TestUpSampleRatio2(Resampler::WindowedSinc,
+                     AudioResult::FreqRespSincUp2.data(),
+                     AudioResult::SinadSincUp2.data(),
+                     &AudioResult::CostSincUp2);
+
+  EvaluateSinadResults(AudioResult::SinadSincUp2.data(),
+                       AudioResult::kPrevSinadSincUp2.data());
+}
+
+// Measure Freq Response for Sinc sampler with minimum rate change.
+TEST(FrequencyResponse, Sinc_MicroSRC) {
+  TestMicroSampleRatio(Resampler::WindowedSinc,
+                       AudioResult::FreqRespSincMicro.data(),
+                       AudioResult::SinadSincMicro.data(),
+                       &AudioResult::CostSincMicro);
+
+  EvaluateFreqRespResults(AudioResult::FreqRespSincMicro.data(),
+                          AudioResult::kPrevFreqRespSincMicro.data());
+}
+
+// Measure SINAD for Sinc sampler with minimum rate change.
+TEST(Sinad, Sinc_MicroSRC) {
+  TestMicroSampleRatio(Resampler::WindowedSinc,
+                       AudioResult::FreqRespSincMicro.data(),
+                       AudioResult::SinadSincMicro.data(),
+                       &AudioResult::CostSincMicro);
+
+  EvaluateSinadResults(AudioResult::SinadSincMicro.data(),
+                       AudioResult::kPrevSinadSincMicro.data());
+}
+
 // For each summary frequency, populate a sinusoid into a mono buffer, and copy-
-// interleave mono[] into one of the channels of the N-channel source.
+// interleave mono[] into one of the channels of the N-channel source, extending
+// it periodically by pre_frames before and post_frames after.
 void PopulateNxNSourceBuffer(float* source, uint32_t num_frames,
-                             uint32_t num_chans) {
+                             uint32_t num_chans, uint32_t pre_frames,
+                             uint32_t post_frames) {
   std::unique_ptr<float[]> mono = std::make_unique<float[]>(num_frames);
 
   // For each summary frequency, populate a sinusoid into mono, and copy-
@@ -724,12 +918,13 @@ void PopulateNxNSourceBuffer(float* source, uint32_t num_frames,
     OverwriteCosine(mono.get(), num_frames,
                     FrequencySet::kReferenceFreqs[freq_idx]);
 
-    // Copy-interleave mono into the N-channel source[].
-    for (uint32_t frame_num = 0; frame_num < num_frames; ++frame_num) {
-      source[frame_num * num_chans + idx] = mono[frame_num];
+    // Copy-interleave mono into the N-channel source[]. Provide extra frames:
+    // interpolators need them to produce enough output.
+    uint32_t total_frames = pre_frames + num_frames + post_frames;
+    for (uint32_t frame_num = 0; frame_num < total_frames; ++frame_num) {
+      source[frame_num * num_chans + idx] =
+          mono[(frame_num + num_frames - pre_frames) % num_frames];
     }
-    // Provide 1 extra: some interpolators need it to produce enough output.
-    source[num_frames * num_chans + idx] = mono[0];
   }
 }
 
@@ -760,19 +955,26 @@ void TestNxNEquivalence(Resampler sampler_type, double* freq_resp_results,
       round(kFreqTestBufSize * source_rate / dest_rate);
   uint32_t num_dest_frames = kFreqTestBufSize;
 
-  // Populate different frequencies into each channel of N-channel source[].
-  // source[] has an additional element because depending on resampling ratio,
-  // some resamplers need it in order to produce the final dest value.
-  std::unique_ptr<float[]> source =
-      std::make_unique<float[]>(num_chans * (num_source_frames + 1));
-  PopulateNxNSourceBuffer(source.get(), num_source_frames, num_chans);
-
-  // Mix the N-channel source[] into the N-channel accum[].
   MixerPtr mixer =
       SelectMixer(fuchsia::media::AudioSampleFormat::FLOAT, num_chans,
                   source_rate, num_chans, dest_rate, sampler_type);
-  uint32_t frac_src_frames =
-      num_chans * (num_source_frames + 1) * Mixer::FRAC_ONE;
+
+  // Populate different frequencies into each channel of N-channel source[].
+  // source[] has additional frames because depending on resampling ratio,
+  // some resamplers need them in order to produce every dest value (see
+  // MeasureFreqRespSinad).
+  uint32_t pre_frames = mixer->neg_filter_width() >> kPtsFractionalBits;
+  uint32_t post_frames = (mixer->pos_filter_width() >> kPtsFractionalBits) + 1;
+  uint32_t total_source_frames = pre_frames + num_source_frames + post_frames;
+  std::unique_ptr<float[]> source =
+      std::make_unique<float[]>(num_chans * total_source_frames);
+  PopulateNxNSourceBuffer(source.get(), num_source_frames, num_chans,
+                          pre_frames, post_frames);
+
+  // Mix the N-channel source[] into the N-channel accum[]. Mix() takes the
+  // source length in frames, not samples, so this is not scaled by num_chans;
+  // it covers the padding frames too, since frac_src_offset starts past them.
+  uint32_t frac_src_frames = total_source_frames * Mixer::FRAC_ONE;
 
   // Use this to keep ongoing src_pos_modulo across multiple Mix() calls.
   Bookkeeping info;
@@ -791,8 +993,9 @@ void TestNxNEquivalence(Resampler sampler_type, double* freq_resp_results,
         num_dest_frames * (packet + 1) / kResamplerTestNumPackets;
     uint32_t dest_offset = num_dest_frames * packet / kResamplerTestNumPackets;
     int32_t frac_src_offset =
-        (static_cast<int64_t>(num_source_frames) * Mixer::FRAC_ONE * packet) /
-        kResamplerTestNumPackets;
+        ((static_cast<int64_t>(num_source_frames) * Mixer::FRAC_ONE * packet) /
+         kResamplerTestNumPackets) +
+        (pre_frames * Mixer::FRAC_ONE);
 
     mixer->Mix(accum.get(), dest_frames, &dest_offset, source.get(),
                frac_src_frames, &frac_src_offset, false, &info);
@@ -867,6 +1070,28 @@ TEST(Sinad, Linear_NxN) {
                        AudioResult::kPrevSinadLinearMicro.data(), true);
 }
 
+// Measure Freq Response for NxN Sinc sampler, with minimum rate change.
+TEST(FrequencyResponse, Sinc_NxN) {
+  TestNxNEquivalence(Resampler::WindowedSinc,
+                     AudioResult::FreqRespSincNxN.data(),
+                     AudioResult::SinadSincNxN.data());
+
+  // Final param signals to evaluate only at summary frequencies.
+  EvaluateFreqRespResults(AudioResult::FreqRespSincNxN.data(),
+                          AudioResult::kPrevFreqRespSincMicro.data(), true);
+}
+
+// Measure SINAD for NxN Sinc sampler, with minimum rate change.
+TEST(Sinad, Sinc_NxN) {
+  TestNxNEquivalence(Resampler::WindowedSinc,
+                     AudioResult::FreqRespSincNxN.data(),
+                     AudioResult::SinadSincNxN.data());
+
+  // Final param signals to evaluate only at summary frequencies.
+  EvaluateSinadResults(AudioResult::SinadSincNxN.data(),
+                       AudioResult::kPrevSinadSincMicro.data(), true);
+}
+
 }  // namespace test
 }  // namespace audio
 }  // namespace media
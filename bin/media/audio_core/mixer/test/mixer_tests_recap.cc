@@ -2,6 +2,8 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <cmath>
+
 #include "garnet/bin/media/audio_core/mixer/test/audio_result.h"
 #include "garnet/bin/media/audio_core/mixer/test/mixer_tests_shared.h"
 #include "gtest/gtest.h"
@@ -144,6 +146,71 @@ TEST(Recap, FreqResp) {
     }
   }
 
+
+  printf("\n\n   Sinc resampler\n    ");
+  if (FrequencySet::UseFullFrequencySet) {
+    printf("                  No SRC                  96k->48k");
+  }
+  printf("                88.2k->48k               44.1k->48k");
+  if (FrequencySet::UseFullFrequencySet) {
+    printf("                24k->48k                 Micro-SRC");
+  }
+  for (uint32_t idx = 0; idx < num_freqs; ++idx) {
+    uint32_t freq = FrequencySet::UseFullFrequencySet
+                        ? idx
+                        : FrequencySet::kSummaryIdxs[idx];
+    printf("\n   %6u Hz", FrequencySet::kRefFreqsTranslated[freq]);
+
+    if (FrequencySet::UseFullFrequencySet) {
+      if (AudioResult::kPrevFreqRespSincUnity[freq] !=
+          -std::numeric_limits<double>::infinity()) {
+        printf("   %9.6lf  (%9.6lf)", AudioResult::FreqRespSincUnity[freq],
+               AudioResult::kPrevFreqRespSincUnity[freq]);
+      } else {
+        printf("                         ");
+      }
+      if (AudioResult::kPrevFreqRespSincDown1[freq] !=
+          -std::numeric_limits<double>::infinity()) {
+        printf("   %9.6lf  (%9.6lf)", AudioResult::FreqRespSincDown1[freq],
+               AudioResult::kPrevFreqRespSincDown1[freq]);
+      } else {
+        printf("                         ");
+      }
+    }
+
+    if (AudioResult::kPrevFreqRespSincDown2[freq] !=
+        -std::numeric_limits<double>::infinity()) {
+      printf("   %9.6lf  (%9.6lf)", AudioResult::FreqRespSincDown2[freq],
+             AudioResult::kPrevFreqRespSincDown2[freq]);
+    } else {
+      printf("                         ");
+    }
+    if (AudioResult::kPrevFreqRespSincUp1[freq] !=
+        -std::numeric_limits<double>::infinity()) {
+      printf("   %9.6lf  (%9.6lf)", AudioResult::FreqRespSincUp1[freq],
+             AudioResult::kPrevFreqRespSincUp1[freq]);
+    } else {
+      printf("                         ");
+    }
+
+    if (FrequencySet::UseFullFrequencySet) {
+      if (AudioResult::kPrevFreqRespSincUp2[freq] !=
+          -std::numeric_limits<double>::infinity()) {
+        printf("   %9.6lf  (%9.6lf)", AudioResult::FreqRespSincUp2[freq],
+               AudioResult::kPrevFreqRespSincUp2[freq]);
+      } else {
+        printf("                         ");
+      }
+      if (AudioResult::kPrevFreqRespSincMicro[freq] !=
+          -std::numeric_limits<double>::infinity()) {
+        printf("   %9.6lf  (%9.6lf)", AudioResult::FreqRespSincMicro[freq],
+               AudioResult::kPrevFreqRespSincMicro[freq]);
+      } else {
+        printf("                         ");
+      }
+    }
+  }
+
   printf("\n\n");
 }
 
@@ -277,6 +344,117 @@ TEST(Recap, SINAD) {
     }
   }
 
+
+  printf("\n\n   Sinc resampler\n           ");
+  if (FrequencySet::UseFullFrequencySet) {
+    printf("            No SRC             96k->48k ");
+  }
+  printf("          88.2k->48k          44.1k->48k");
+  if (FrequencySet::UseFullFrequencySet) {
+    printf("           24k->48k            Micro-SRC");
+  }
+  for (uint32_t idx = 0; idx < num_freqs; ++idx) {
+    uint32_t freq = FrequencySet::UseFullFrequencySet
+                        ? idx
+                        : FrequencySet::kSummaryIdxs[idx];
+    printf("\n   %8u Hz ", FrequencySet::kRefFreqsTranslated[freq]);
+
+    if (FrequencySet::UseFullFrequencySet) {
+      if (AudioResult::kPrevSinadSincUnity[freq] !=
+          -std::numeric_limits<double>::infinity()) {
+        printf("    %6.2lf  (%6.2lf)", AudioResult::SinadSincUnity[freq],
+               AudioResult::kPrevSinadSincUnity[freq]);
+      } else {
+        printf("                    ");
+      }
+      if (AudioResult::kPrevSinadSincDown1[freq] !=
+          -std::numeric_limits<double>::infinity()) {
+        printf("    %6.2lf  (%6.2lf)", AudioResult::SinadSincDown1[freq],
+               AudioResult::kPrevSinadSincDown1[freq]);
+      } else {
+        printf("                    ");
+      }
+    }
+
+    if (AudioResult::kPrevSinadSincDown2[freq] !=
+        -std::numeric_limits<double>::infinity()) {
+      printf("    %6.2lf  (%6.2lf)", AudioResult::SinadSincDown2[freq],
+             AudioResult::kPrevSinadSincDown2[freq]);
+    } else {
+      printf("                    ");
+    }
+    if (AudioResult::kPrevSinadSincUp1[freq] !=
+        -std::numeric_limits<double>::infinity()) {
+      printf("    %6.2lf  (%6.2lf)", AudioResult::SinadSincUp1[freq],
+             AudioResult::kPrevSinadSincUp1[freq]);
+    } else {
+      printf("                    ");
+    }
+
+    if (FrequencySet::UseFullFrequencySet) {
+      if (AudioResult::kPrevSinadSincUp2[freq] !=
+          -std::numeric_limits<double>::infinity()) {
+        printf("    %6.2lf  (%6.2lf)", AudioResult::SinadSincUp2[freq],
+               AudioResult::kPrevSinadSincUp2[freq]);
+      } else {
+        printf("                    ");
+      }
+
+      if (AudioResult::kPrevSinadSincMicro[freq] !=
+          -std::numeric_limits<double>::infinity()) {
+        printf("    %6.2lf  (%6.2lf)", AudioResult::SinadSincMicro[freq],
+               AudioResult::kPrevSinadSincMicro[freq]);
+      }
+    }
+  }
+
+  printf("\n\n");
+}
+
+//
+// Display the thread CPU time that each resampler took to mix, in microseconds
+// per second of mono 48 kHz output. These depend on the machine running the
+// tests, so there are no prior results to compare against.
+//
+void PrintCost(double cost_us) {
+  if (std::isnan(cost_us)) {
+    printf("           ");
+  } else {
+    printf("   %8.1lf", cost_us);
+  }
+}
+
+TEST(Recap, CpuCost) {
+  printf("\n CPU cost");
+  printf("\n   (in usec per second of output)");
+
+  printf("\n\n                 No SRC   96k->48k 88.2k->48k 44.1k->48k");
+  printf("   24k->48k  Micro-SRC");
+
+  printf("\n   Point  ");
+  PrintCost(AudioResult::CostPointUnity);
+  PrintCost(AudioResult::CostPointDown1);
+  PrintCost(AudioResult::CostPointDown2);
+  PrintCost(AudioResult::CostPointUp1);
+  PrintCost(AudioResult::CostPointUp2);
+  PrintCost(AudioResult::CostPointMicro);
+
+  printf("\n   Linear ");
+  PrintCost(AudioResult::CostLinearUnity);
+  PrintCost(AudioResult::CostLinearDown1);
+  PrintCost(AudioResult::CostLinearDown2);
+  PrintCost(AudioResult::CostLinearUp1);
+  PrintCost(AudioResult::CostLinearUp2);
+  PrintCost(AudioResult::CostLinearMicro);
+
+  printf("\n   Sinc   ");
+  PrintCost(AudioResult::CostSincUnity);
+  PrintCost(AudioResult::CostSincDown1);
+  PrintCost(AudioResult::CostSincDown2);
+  PrintCost(AudioResult::CostSincUp1);
+  PrintCost(AudioResult::CostSincUp2);
+  PrintCost(AudioResult::CostSincMicro);
+
   printf("\n\n");
 }
 
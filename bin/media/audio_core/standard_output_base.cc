@@ -6,7 +6,11 @@
 
 #include <fbl/auto_lock.h>
 #include <lib/fit/defer.h>
+#include <trace/event.h>
+#include <zircon/syscalls.h>
+#include <algorithm>
 #include <limits>
+#include <string>
 
 #include "garnet/bin/media/audio_core/audio_link.h"
 #include "garnet/bin/media/audio_core/audio_renderer_format_info.h"
@@ -22,6 +26,33 @@ namespace audio {
 static constexpr fxl::TimeDelta kMaxTrimPeriod =
     fxl::TimeDelta::FromMilliseconds(10);
 
+// The most threads (including the mix domain's own) that one output will use to
+// mix its renderers. Beyond this, outputs would mostly compete with each other.
+static constexpr uint32_t kMaxMixThreads = 4;
+
+// Reports |histogram| as a child of |parent|, named |name|. Durations are in
+// nanoseconds; "buckets" lists the count in each of the histogram's buckets.
+static void AddHistogram(const component::ObjectDir& parent, std::string name,
+                         const mixer::DurationHistogram& histogram) {
+  auto snapshot = histogram.GetSnapshot();
+  auto dir = component::ObjectDir::Make(std::move(name));
+
+  dir.set_metric("count", component::UIntMetric(snapshot.count));
+  dir.set_metric("mean", component::IntMetric(snapshot.mean()));
+  dir.set_metric("max", component::IntMetric(snapshot.max));
+  dir.set_metric("p50", component::IntMetric(snapshot.Percentile(50.0)));
+  dir.set_metric("p99", component::IntMetric(snapshot.Percentile(99.0)));
+
+  std::string buckets;
+  for (uint32_t bucket = 0; bucket < mixer::DurationHistogram::kNumBuckets;
+       ++bucket) {
+    buckets += (bucket ? " " : "") + std::to_string(snapshot.buckets[bucket]);
+  }
+  dir.set_prop("buckets", buckets);
+
+  parent.set_child(dir.object());
+}
+
 StandardOutputBase::StandardOutputBase(AudioDeviceManager* manager)
     : AudioOutput(manager) {
   next_sched_time_ = fxl::TimePoint::Now();
@@ -59,6 +90,7 @@ zx_status_t StandardOutputBase::Init() {
 }
 
 void StandardOutputBase::Process() {
+  TRACE_DURATION("audio", "StandardOutputBase::Process");
   bool mixed = false;
   fxl::TimePoint now = fxl::TimePoint::Now();
 
@@ -99,12 +131,30 @@ void StandardOutputBase::Process() {
         size_t bytes_to_zero = sizeof(mix_buf_[0]) * cur_mix_job_.buf_frames *
                                output_producer_->channels();
         ::memset(mix_buf_.get(), 0, bytes_to_zero);
+        cur_mix_job_.accum_buf = mix_buf_.get();
+        mix_partials_[0] = mix_buf_.get();
+        num_mix_partials_ = 1;
+
+        // Mix each renderer into the intermediate accumulator buffer(s), then
+        // sum, reformat (and clip) them into the final output buffer.
+        fxl::TimePoint mix_start = fxl::TimePoint::Now();
+        {
+          TRACE_DURATION("audio", "StandardOutputBase::Mix", "frames",
+                         cur_mix_job_.buf_frames);
+          ForeachLink(TaskType::Mix);
+        }
+        fxl::TimePoint produce_start = fxl::TimePoint::Now();
+        {
+          TRACE_DURATION("audio", "StandardOutputBase::ProduceOutput");
+          output_producer_->ProduceOutput(mix_partials_.data(),
+                                          num_mix_partials_, cur_mix_job_.buf,
+                                          cur_mix_job_.buf_frames);
+        }
+        fxl::TimePoint mix_end = fxl::TimePoint::Now();
 
-        // Mix each renderer into the intermediate accumulator buffer, then
-        // reformat (and clip) into the final output buffer.
-        ForeachLink(TaskType::Mix);
-        output_producer_->ProduceOutput(mix_buf_.get(), cur_mix_job_.buf,
-                                        cur_mix_job_.buf_frames);
+        stats_.mix_time.Record((produce_start - mix_start).ToNanoseconds());
+        stats_.produce_time.Record((mix_end - produce_start).ToNanoseconds());
+        UpdateMixDeadlineStats(mix_end - mix_start, cur_mix_job_.buf_frames);
         mixed = true;
       } else {
         output_producer_->FillWithSilence(cur_mix_job_.buf,
@@ -199,6 +249,80 @@ void StandardOutputBase::SetupMixBuffer(uint32_t max_mix_frames) {
 
   mix_buf_frames_ = max_mix_frames;
   mix_buf_.reset(new float[mix_buf_frames_ * output_producer_->channels()]);
+
+  if (mix_scheduler_ == nullptr) {
+    uint32_t num_threads = std::min(zx_system_get_num_cpus(), kMaxMixThreads);
+    mix_scheduler_ =
+        std::make_unique<mixer::MixScheduler>(std::max(num_threads, 1u));
+    mix_partials_.resize(mix_scheduler_->num_threads());
+  }
+  mix_scheduler_->SetMaxSamples(mix_buf_frames_ * output_producer_->channels());
+}
+
+StandardOutputBase::MixDeadlineStats
+StandardOutputBase::SnapshotMixDeadlineStats() const {
+  fbl::AutoLock stats_lock(&stats_lock_);
+  return mix_deadline_stats_;
+}
+
+void StandardOutputBase::UpdateMixDeadlineStats(fxl::TimeDelta mix_time,
+                                                uint32_t frames) {
+  // A job's deadline is the time that it takes to play what it produced.
+  zx_duration_t budget =
+      ZX_SEC(1) * frames / output_producer_->format()->frames_per_second;
+  zx_duration_t elapsed = mix_time.ToNanoseconds();
+
+  fbl::AutoLock stats_lock(&stats_lock_);
+  auto& stats = mix_deadline_stats_;
+  ++stats.jobs;
+  if (elapsed > budget) {
+    ++stats.missed;
+  }
+  stats.total_mix_time += elapsed;
+  stats.max_mix_time = std::max(stats.max_mix_time, elapsed);
+  if (budget > 0) {
+    stats.max_budget_used = std::max(
+        stats.max_budget_used, static_cast<double>(elapsed) / budget);
+  }
+}
+
+fbl::RefPtr<component::Object> StandardOutputBase::CreateStatsObject(
+    fbl::String name) {
+  auto dir = component::ObjectDir::Make(name.c_str());
+
+  AddHistogram(dir, "mix_time", stats_.mix_time);
+  AddHistogram(dir, "produce_time", stats_.produce_time);
+  AddHistogram(dir, "lead_time", stats_.lead_time);
+  dir.set_metric("underflows", component::UIntMetric(stats_.underflows.load()));
+  dir.set_metric("underflow_time",
+                 component::IntMetric(stats_.underflow_time.load()));
+
+  auto deadline_stats = SnapshotMixDeadlineStats();
+  dir.set_metric("mix_jobs", component::UIntMetric(deadline_stats.jobs));
+  dir.set_metric("missed_deadlines",
+                 component::UIntMetric(deadline_stats.missed));
+  dir.set_metric("max_budget_used",
+                 component::DoubleMetric(deadline_stats.max_budget_used));
+
+  // Each renderer mixed into this output, with the time spent mixing it.
+  fbl::AutoLock links_lock(&links_lock_);
+  uint32_t index = 0;
+  for (const auto& link : source_links_) {
+    if (link->source_type() != AudioLink::SourceType::Packet) {
+      continue;
+    }
+    auto packet_link = static_cast<AudioLinkPacketSource*>(link.get());
+    if (packet_link->bookkeeping() == nullptr) {
+      continue;
+    }
+
+    auto renderer = component::ObjectDir::Make(
+        "renderer-" + std::to_string(index++));
+    AddHistogram(renderer, "mix_time", packet_link->bookkeeping()->mix_time);
+    dir.set_child(renderer.object());
+  }
+
+  return dir.object();
 }
 
 void StandardOutputBase::ForeachLink(TaskType task_type) {
@@ -221,112 +345,153 @@ void StandardOutputBase::ForeachLink(TaskType task_type) {
   auto cleanup = fit::defer(
       [this]() FXL_NO_THREAD_SAFETY_ANALYSIS { source_link_refs_.clear(); });
 
+  // Renderers are independent of each other until they reach the accumulation
+  // buffer, so when there are several to mix, spread them across our threads.
+  // Each thread mixes into a buffer of its own; rather than summing these into
+  // mix_buf_ here, the output producer sums them as it converts.
+  if ((task_type == TaskType::Mix) && (source_link_refs_.size() > 1) &&
+      (mix_scheduler_->num_threads() > 1)) {
+    num_mix_partials_ = mix_scheduler_->RunUnreduced(
+        cur_mix_job_.accum_buf,
+        cur_mix_job_.buf_frames * output_producer_->channels(),
+        static_cast<uint32_t>(source_link_refs_.size()),
+        [this](uint32_t index, float* accum) FXL_NO_THREAD_SAFETY_ANALYSIS {
+          // Quit early if we should be shutting down.
+          if (is_shutting_down()) {
+            return;
+          }
+
+          // Each renderer has its own progress through the job, and always
+          // accumulates, as its thread's buffer may already hold others.
+          MixJob job = cur_mix_job_;
+          job.accum_buf = accum;
+          job.accumulate = true;
+          ProcessLink(TaskType::Mix, source_link_refs_[index], &job);
+        },
+        mix_partials_.data());
+    return;
+  }
+
   for (const auto& link : source_link_refs_) {
     // Quit early if we should be shutting down.
     if (is_shutting_down()) {
       return;
     }
 
-    // Is the link still valid?  If so, process it.
-    if (!link->valid()) {
-      continue;
-    }
+    ProcessLink(task_type, link, &cur_mix_job_);
 
-    FXL_DCHECK(link->source_type() == AudioLink::SourceType::Packet);
-    FXL_DCHECK(link->GetSource()->type() == AudioObject::Type::AudioRenderer);
-    auto packet_link = static_cast<AudioLinkPacketSource*>(link.get());
-    auto audio_renderer =
-        fbl::RefPtr<AudioRendererImpl>::Downcast(link->GetSource());
-
-    // It would be nice to be able to use a dynamic cast for this, but currently
-    // we are building with no-rtti
-    Bookkeeping* info =
-        static_cast<Bookkeeping*>(packet_link->bookkeeping().get());
-    FXL_DCHECK(info);
-
-    // Ensure the mapping from source-frame to local-time is up-to-date.
-    UpdateSourceTrans(audio_renderer, info);
-
-    bool setup_done = false;
-    fbl::RefPtr<AudioPacketRef> pkt_ref;
-
-    bool release_audio_renderer_packet;
-    while (true) {
-      release_audio_renderer_packet = false;
-      // Try to grab the packet queue's front. If it has been flushed since the
-      // last time we grabbed it, reset our mixer's internal filter state.
-      bool was_flushed;
-      pkt_ref = packet_link->LockPendingQueueFront(&was_flushed);
-      if (was_flushed) {
-        info->mixer->Reset();
-      }
+    // Note: there is no point in doing this for Trim tasks, but it doesn't hurt
+    // anything, and its easier than adding another function to ForeachLink to
+    // run after each renderer is processed, just to set this flag.
+    cur_mix_job_.accumulate = true;
+  }
+}
 
-      // If the queue is empty, then we are done.
-      if (!pkt_ref) {
-        break;
-      }
+void StandardOutputBase::ProcessLink(TaskType task_type,
+                                     const std::shared_ptr<AudioLink>& link,
+                                     MixJob* job) {
+  // Is the link still valid?  If so, process it.
+  if (!link->valid()) {
+    return;
+  }
 
-      // If we have not set up for this renderer yet, do so. If the setup
-      // fails for any reason, stop processing packets for this renderer.
-      if (!setup_done) {
-        setup_done = (task_type == TaskType::Mix)
-                         ? SetupMix(audio_renderer, info)
-                         : SetupTrim(audio_renderer, info);
-        if (!setup_done) {
-          // Clear our ramps, if we exit with error?
-          break;
-        }
-      }
+  FXL_DCHECK(link->source_type() == AudioLink::SourceType::Packet);
+  FXL_DCHECK(link->GetSource()->type() == AudioObject::Type::AudioRenderer);
+  auto packet_link = static_cast<AudioLinkPacketSource*>(link.get());
+  auto audio_renderer =
+      fbl::RefPtr<AudioRendererImpl>::Downcast(link->GetSource());
 
-      // Now process the packet which is at the front of the renderer's queue.
-      // If the packet has been entirely consumed, pop it off the front and
-      // proceed to the next one. Otherwise, we are finished.
-      release_audio_renderer_packet =
-          (task_type == TaskType::Mix)
-              ? ProcessMix(audio_renderer, info, pkt_ref)
-              : ProcessTrim(audio_renderer, info, pkt_ref);
-
-      // If we have mixed enough output frames, we are done with this mix,
-      // regardless of what we should now do with the renderer packet.
-      if ((task_type == TaskType::Mix) &&
-          (cur_mix_job_.frames_produced == cur_mix_job_.buf_frames)) {
-        break;
-      }
-      // If we still need more output, but could not complete this renderer
-      // packet (we're paused, or packet is in the future), then we are done.
-      if (!release_audio_renderer_packet) {
+  // It would be nice to be able to use a dynamic cast for this, but currently
+  // we are building with no-rtti
+  Bookkeeping* info =
+      static_cast<Bookkeeping*>(packet_link->bookkeeping().get());
+  FXL_DCHECK(info);
+
+  TRACE_DURATION("audio", "StandardOutputBase::ProcessLink");
+  fxl::TimePoint start = fxl::TimePoint::Now();
+
+  // Ensure the mapping from source-frame to local-time is up-to-date.
+  UpdateSourceTrans(audio_renderer, info);
+
+  bool setup_done = false;
+  fbl::RefPtr<AudioPacketRef> pkt_ref;
+
+  bool release_audio_renderer_packet;
+  while (true) {
+    release_audio_renderer_packet = false;
+    // Try to grab the packet queue's front. If it has been flushed since the
+    // last time we grabbed it, reset our mixer's internal filter state.
+    bool was_flushed;
+    pkt_ref = packet_link->LockPendingQueueFront(&was_flushed);
+    if (was_flushed) {
+      info->mixer->Reset();
+    }
+
+    // If the queue is empty, then we are done.
+    if (!pkt_ref) {
+      break;
+    }
+
+    // If we have not set up for this renderer yet, do so. If the setup
+    // fails for any reason, stop processing packets for this renderer.
+    if (!setup_done) {
+      setup_done = (task_type == TaskType::Mix)
+                       ? SetupMix(audio_renderer, info, job)
+                       : SetupTrim(audio_renderer, info);
+      if (!setup_done) {
+        // Clear our ramps, if we exit with error?
         break;
       }
-      // We did consume this entire renderer packet, and we should keep mixing.
-      pkt_ref.reset();
-      packet_link->UnlockPendingQueueFront(release_audio_renderer_packet);
     }
 
-    // Unlock queue (completing packet if needed) and proceed to next renderer.
+    // Now process the packet which is at the front of the renderer's queue.
+    // If the packet has been entirely consumed, pop it off the front and
+    // proceed to the next one. Otherwise, we are finished.
+    release_audio_renderer_packet =
+        (task_type == TaskType::Mix)
+            ? ProcessMix(audio_renderer, info, pkt_ref, job)
+            : ProcessTrim(audio_renderer, info, pkt_ref);
+
+    // If we have mixed enough output frames, we are done with this mix,
+    // regardless of what we should now do with the renderer packet.
+    if ((task_type == TaskType::Mix) &&
+        (job->frames_produced == job->buf_frames)) {
+      break;
+    }
+    // If we still need more output, but could not complete this renderer
+    // packet (we're paused, or packet is in the future), then we are done.
+    if (!release_audio_renderer_packet) {
+      break;
+    }
+    // We did consume this entire renderer packet, and we should keep mixing.
     pkt_ref.reset();
     packet_link->UnlockPendingQueueFront(release_audio_renderer_packet);
+  }
 
-    // Note: there is no point in doing this for Trim tasks, but it doesn't hurt
-    // anything, and its easier than adding another function to ForeachLink to
-    // run after each renderer is processed, just to set this flag.
-    cur_mix_job_.accumulate = true;
+  // Unlock queue (completing packet if needed) and proceed to next renderer.
+  pkt_ref.reset();
+  packet_link->UnlockPendingQueueFront(release_audio_renderer_packet);
+
+  if (task_type == TaskType::Mix) {
+    info->mix_time.Record((fxl::TimePoint::Now() - start).ToNanoseconds());
   }
 }
 
 bool StandardOutputBase::SetupMix(
-    const fbl::RefPtr<AudioRendererImpl>& audio_renderer, Bookkeeping* info) {
+    const fbl::RefPtr<AudioRendererImpl>& audio_renderer, Bookkeeping* info,
+    MixJob* job) {
   // If we need to recompose our transformation from output frame space to input
   // fractional frames, do so now.
   FXL_DCHECK(info);
-  UpdateDestTrans(cur_mix_job_, info);
-  cur_mix_job_.frames_produced = 0;
+  UpdateDestTrans(*job, info);
+  job->frames_produced = 0;
 
   return true;
 }
 
 bool StandardOutputBase::ProcessMix(
     const fbl::RefPtr<AudioRendererImpl>& audio_renderer, Bookkeeping* info,
-    const fbl::RefPtr<AudioPacketRef>& packet) {
+    const fbl::RefPtr<AudioPacketRef>& packet, MixJob* job) {
   // Bookkeeping should contain: the rechannel matrix (eventually).
 
   // Sanity check our parameters.
@@ -334,8 +499,8 @@ bool StandardOutputBase::ProcessMix(
   FXL_DCHECK(packet);
 
   // We had better have a valid job, or why are we here?
-  FXL_DCHECK(cur_mix_job_.buf_frames);
-  FXL_DCHECK(cur_mix_job_.frames_produced <= cur_mix_job_.buf_frames);
+  FXL_DCHECK(job->buf_frames);
+  FXL_DCHECK(job->frames_produced <= job->buf_frames);
 
   // We also must have selected a mixer, or we are in trouble.
   FXL_DCHECK(info->mixer);
@@ -349,17 +514,17 @@ bool StandardOutputBase::ProcessMix(
   }
 
   // Have we produced enough? If so, hold this packet and move to next renderer.
-  if (cur_mix_job_.frames_produced >= cur_mix_job_.buf_frames) {
+  if (job->frames_produced >= job->buf_frames) {
     return false;
   }
 
-  uint32_t frames_left = cur_mix_job_.buf_frames - cur_mix_job_.frames_produced;
-  float* buf = mix_buf_.get() +
-               (cur_mix_job_.frames_produced * output_producer_->channels());
+  uint32_t frames_left = job->buf_frames - job->frames_produced;
+  float* buf =
+      job->accum_buf + (job->frames_produced * output_producer_->channels());
 
   // Calculate this job's first and last sampling points, in source sub-frames.
   int64_t first_sample_ftf = info->dest_frames_to_frac_source_frames(
-      cur_mix_job_.start_pts_of + cur_mix_job_.frames_produced);
+      job->start_pts_of + job->frames_produced);
 
   // Without the "-1", this would be the first output frame of the NEXT job.
   int64_t final_sample_ftf =
@@ -420,8 +585,13 @@ bool StandardOutputBase::ProcessMix(
   FXL_DCHECK(packet->frac_frame_len() <=
              static_cast<uint32_t>(std::numeric_limits<int32_t>::max()));
 
+  // A packet may lie entirely before our first sampling point and still be
+  // within our filter's negative window (for wide filters such as the sinc
+  // resampler's). Mix it anyway, so the mixer can keep the frames it needs.
   bool consumed_source = false;
-  if (frac_input_offset < static_cast<int32_t>(packet->frac_frame_len())) {
+  if (static_cast<int64_t>(frac_input_offset) + Mixer::FRAC_ONE <=
+      static_cast<int64_t>(packet->frac_frame_len()) +
+          mixer.neg_filter_width()) {
     // When calling Mix(), we communicate the resampling rate with three
     // parameters. We augment step_size with rate_modulo and denominator
     // arguments that capture the remaining rate component that cannot be
@@ -449,7 +619,7 @@ bool StandardOutputBase::ProcessMix(
     consumed_source =
         info->mixer->Mix(buf, frames_left, &output_offset, packet->payload(),
                          packet->frac_frame_len(), &frac_input_offset,
-                         cur_mix_job_.accumulate, info);
+                         job->accumulate, info);
     FXL_DCHECK(output_offset <= frames_left);
   }
 
@@ -458,9 +628,9 @@ bool StandardOutputBase::ProcessMix(
                packet->frac_frame_len());
   }
 
-  cur_mix_job_.frames_produced += output_offset;
+  job->frames_produced += output_offset;
 
-  FXL_DCHECK(cur_mix_job_.frames_produced <= cur_mix_job_.buf_frames);
+  FXL_DCHECK(job->frames_produced <= job->buf_frames);
   return consumed_source;
 }
 
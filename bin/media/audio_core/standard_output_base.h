@@ -6,13 +6,18 @@
 #define GARNET_BIN_MEDIA_AUDIO_CORE_STANDARD_OUTPUT_BASE_H_
 
 #include <dispatcher-pool/dispatcher-timer.h>
+#include <fbl/mutex.h>
 #include <fuchsia/media/cpp/fidl.h>
+#include <zircon/types.h>
+#include <atomic>
 
 #include "garnet/bin/media/audio_core/audio_link.h"
 #include "garnet/bin/media/audio_core/audio_link_packet_source.h"
 #include "garnet/bin/media/audio_core/audio_output.h"
 #include "garnet/bin/media/audio_core/mixer/constants.h"
+#include "garnet/bin/media/audio_core/mixer/duration_histogram.h"
 #include "garnet/bin/media/audio_core/mixer/gain.h"
+#include "garnet/bin/media/audio_core/mixer/mix_scheduler.h"
 #include "garnet/bin/media/audio_core/mixer/mixer.h"
 #include "garnet/bin/media/audio_core/mixer/output_producer.h"
 #include "lib/fxl/time/time_delta.h"
@@ -26,9 +31,45 @@ class AudioPacketRef;
 
 class StandardOutputBase : public AudioOutput {
  public:
+  // Deadline accounting for this output's mix jobs. A job's budget is the time
+  // that the audio it produces takes to play; a job that takes longer than this
+  // to mix has missed its deadline, and the output is falling behind.
+  struct MixDeadlineStats {
+    uint64_t jobs = 0;
+    uint64_t missed = 0;
+    zx_duration_t total_mix_time = 0;
+    zx_duration_t max_mix_time = 0;
+    // The largest fraction of its budget that any one job has used.
+    double max_budget_used = 0.0;
+  };
+
   ~StandardOutputBase() override;
 
+  MixDeadlineStats SnapshotMixDeadlineStats() const
+      FXL_LOCKS_EXCLUDED(stats_lock_);
+
+  // AudioOutput implementation
+  fbl::RefPtr<component::Object> CreateStatsObject(fbl::String name) override
+      FXL_LOCKS_EXCLUDED(links_lock_);
+
  protected:
+  // Where the time goes in this output's mix jobs, and how often it falls
+  // behind. Any thread may read these. Each renderer's own mix time is kept in
+  // its link's Bookkeeping.
+  struct OutputStats {
+    // Mixing every renderer into the intermediate buffer.
+    mixer::DurationHistogram mix_time;
+    // Summing the mix threads' buffers, converting the result into the
+    // output's format.
+    mixer::DurationHistogram produce_time;
+    // How far ahead of the hardware's read position each wakeup starts to
+    // write, for outputs that have one. Underflows count as zero here.
+    mixer::DurationHistogram lead_time;
+    // Underflow events, and the time spent recovering from them.
+    std::atomic<uint64_t> underflows{0};
+    std::atomic<zx_duration_t> underflow_time{0};
+  };
+
   struct MixJob {
     // Job state set up once by an output implementation, used by all AudioOuts.
     void* buf;
@@ -41,8 +82,10 @@ class StandardOutputBase : public AudioOutput {
     float sw_output_gain_db;
     bool sw_output_muted;
 
-    // Per-stream job state, set up for each AudioOut during SetupMix.
+    // Per-stream job state, set up for each AudioOut during SetupMix. Streams
+    // may be mixed in parallel, each into its own thread's accumulation buffer.
     uint32_t frames_produced;
+    float* accum_buf;
   };
 
   // TODO(mpuryear): per MTWN-129, integrate it into the Mixer class itself.
@@ -50,6 +93,8 @@ class StandardOutputBase : public AudioOutput {
   void UpdateSourceTrans(const fbl::RefPtr<AudioRendererImpl>& audio_renderer,
                          Bookkeeping* bk);
   void UpdateDestTrans(const MixJob& job, Bookkeeping* bk);
+  void UpdateMixDeadlineStats(fxl::TimeDelta mix_time, uint32_t frames)
+      FXL_LOCKS_EXCLUDED(stats_lock_);
 
   explicit StandardOutputBase(AudioDeviceManager* manager);
 
@@ -81,17 +126,23 @@ class StandardOutputBase : public AudioOutput {
   // Timer used to schedule periodic mixing.
   fbl::RefPtr<::dispatcher::Timer> mix_timer_;
 
+  OutputStats stats_;
+
  private:
   enum class TaskType { Mix, Trim };
 
   void ForeachLink(TaskType task_type)
       FXL_EXCLUSIVE_LOCKS_REQUIRED(mix_domain_->token());
+  void ProcessLink(TaskType task_type, const std::shared_ptr<AudioLink>& link,
+                   MixJob* job)
+      FXL_EXCLUSIVE_LOCKS_REQUIRED(mix_domain_->token());
 
   bool SetupMix(const fbl::RefPtr<AudioRendererImpl>& audio_renderer,
-                Bookkeeping* info)
+                Bookkeeping* info, MixJob* job)
       FXL_EXCLUSIVE_LOCKS_REQUIRED(mix_domain_->token());
   bool ProcessMix(const fbl::RefPtr<AudioRendererImpl>& audio_renderer,
-                  Bookkeeping* info, const fbl::RefPtr<AudioPacketRef>& pkt_ref)
+                  Bookkeeping* info, const fbl::RefPtr<AudioPacketRef>& pkt_ref,
+                  MixJob* job)
       FXL_EXCLUSIVE_LOCKS_REQUIRED(mix_domain_->token());
 
   bool SetupTrim(const fbl::RefPtr<AudioRendererImpl>& audio_renderer,
@@ -114,6 +165,18 @@ class StandardOutputBase : public AudioOutput {
   std::unique_ptr<float[]> mix_buf_ FXL_GUARDED_BY(mix_domain_->token());
   uint32_t mix_buf_frames_ FXL_GUARDED_BY(mix_domain_->token()) = 0;
 
+  // Spreads the renderers of each mix job across our mix threads.
+  std::unique_ptr<mixer::MixScheduler> mix_scheduler_
+      FXL_GUARDED_BY(mix_domain_->token());
+
+  // The buffers that the current mix job's renderers were mixed into: mix_buf_,
+  // then any of the scheduler's own. The output producer sums them.
+  std::vector<const float*> mix_partials_ FXL_GUARDED_BY(mix_domain_->token());
+  uint32_t num_mix_partials_ FXL_GUARDED_BY(mix_domain_->token()) = 0;
+
+  mutable fbl::Mutex stats_lock_;
+  MixDeadlineStats mix_deadline_stats_ FXL_GUARDED_BY(stats_lock_);
+
   // State used by the mix task.
   MixJob cur_mix_job_;
 
@@ -0,0 +1,168 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/overnet/overnethost/epoll_loop.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <new>
+#include <sstream>
+
+namespace overnethost {
+
+namespace {
+
+overnet::Status StatusFromErrno(const char* why) {
+  int err = errno;
+  std::ostringstream msg;
+  msg << why << ", errno=" << err;
+  return overnet::Status(overnet::StatusCode::UNKNOWN, msg.str());
+}
+
+}  // namespace
+
+EpollLoop::EpollLoop() = default;
+
+EpollLoop::~EpollLoop() {
+  shutting_down_ = true;
+  while (!pending_timeouts_.empty()) {
+    auto it = pending_timeouts_.begin();
+    overnet::Timeout* timeout = it->second;
+    TimeoutStorage<TimeoutState>(timeout)->pending = false;
+    pending_timeouts_.erase(it);
+    FireTimeout(timeout, overnet::Status::Cancelled());
+  }
+  if (epoll_fd_ != -1)
+    close(epoll_fd_);
+}
+
+overnet::Status EpollLoop::Init() {
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ == -1)
+    return StatusFromErrno("epoll_create1");
+  return overnet::Status::Ok();
+}
+
+overnet::TimeStamp EpollLoop::Now() {
+  if (shutting_down_)
+    return overnet::TimeStamp::AfterEpoch(overnet::TimeDelta::PositiveInf());
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return overnet::TimeStamp::AfterEpoch(overnet::TimeDelta::FromMicroseconds(
+      static_cast<int64_t>(ts.tv_sec) * overnet::kUsPerSec +
+      ts.tv_nsec / 1000));
+}
+
+overnet::Status EpollLoop::WatchReadable(int fd, std::function<void()> ready) {
+  epoll_event event;
+  event.events = EPOLLIN | EPOLLET;
+  event.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == -1)
+    return StatusFromErrno("epoll_ctl(EPOLL_CTL_ADD)");
+  watches_[fd] = std::move(ready);
+  return overnet::Status::Ok();
+}
+
+void EpollLoop::Unwatch(int fd) {
+  if (watches_.erase(fd))
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void EpollLoop::WatchBeforeWait(const void* owner,
+                                std::function<void()> before_wait) {
+  before_wait_.emplace_back(owner, std::move(before_wait));
+}
+
+void EpollLoop::UnwatchBeforeWait(const void* owner) {
+  before_wait_.erase(std::remove_if(before_wait_.begin(), before_wait_.end(),
+                                    [owner](const auto& entry) {
+                                      return entry.first == owner;
+                                    }),
+                     before_wait_.end());
+}
+
+void EpollLoop::Run() {
+  static constexpr int kMaxEvents = 64;
+  epoll_event events[kMaxEvents];
+
+  quit_ = false;
+  while (!quit_) {
+    FireExpiredTimeouts();
+    RunBeforeWait();
+    if (quit_)
+      break;
+
+    int n = epoll_wait(epoll_fd_, events, kMaxEvents, WaitMilliseconds());
+    for (int i = 0; i < n; i++) {
+      auto it = watches_.find(events[i].data.fd);
+      if (it == watches_.end())
+        continue;
+      // The callback may unwatch its own descriptor.
+      std::function<void()> ready = it->second;
+      ready();
+    }
+  }
+}
+
+void EpollLoop::FireExpiredTimeouts() {
+  const int64_t now = Now().after_epoch().as_us();
+  while (!pending_timeouts_.empty() && !quit_) {
+    auto it = pending_timeouts_.begin();
+    if (it->first > now)
+      return;
+    overnet::Timeout* timeout = it->second;
+    TimeoutStorage<TimeoutState>(timeout)->pending = false;
+    pending_timeouts_.erase(it);
+    FireTimeout(timeout, overnet::Status::Ok());
+  }
+}
+
+void EpollLoop::RunBeforeWait() {
+  // Indexed: callbacks may watch more, but must not unwatch anything.
+  for (size_t i = 0; i < before_wait_.size(); i++)
+    before_wait_[i].second();
+}
+
+int EpollLoop::WaitMilliseconds() {
+  if (pending_timeouts_.empty())
+    return -1;
+  const int64_t wait_us =
+      pending_timeouts_.begin()->first - Now().after_epoch().as_us();
+  if (wait_us <= 0)
+    return 0;
+  // epoll only has millisecond resolution: round up so timers never fire
+  // early.
+  return static_cast<int>((wait_us + 999) / 1000);
+}
+
+void EpollLoop::InitTimeout(overnet::Timeout* timeout,
+                            overnet::TimeStamp when) {
+  auto* state = new (TimeoutStorage<TimeoutState>(timeout)) TimeoutState;
+  state->pending = false;
+  if (shutting_down_) {
+    FireTimeout(timeout, overnet::Status::Cancelled());
+    return;
+  }
+  // Timeouts that have already expired still go through the loop so that
+  // callbacks are never run from inside the code that created them.
+  state->it = pending_timeouts_.emplace(when.after_epoch().as_us(), timeout);
+  state->pending = true;
+}
+
+void EpollLoop::CancelTimeout(overnet::Timeout* timeout,
+                              overnet::Status status) {
+  assert(!status.is_ok());
+  auto* state = TimeoutStorage<TimeoutState>(timeout);
+  if (state->pending) {
+    state->pending = false;
+    pending_timeouts_.erase(state->it);
+  }
+  FireTimeout(timeout, status);
+}
+
+}  // namespace overnethost
@@ -0,0 +1,76 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "garnet/lib/overnet/status.h"
+#include "garnet/lib/overnet/timer.h"
+
+namespace overnethost {
+
+// A single threaded event loop for Linux hosts: waits for file descriptors to
+// become readable with epoll, and doubles as the overnet::Timer for everything
+// running on the loop.
+class EpollLoop final : public overnet::Timer {
+ public:
+  EpollLoop();
+  ~EpollLoop();
+
+  EpollLoop(const EpollLoop&) = delete;
+  EpollLoop& operator=(const EpollLoop&) = delete;
+
+  overnet::Status Init();
+
+  overnet::TimeStamp Now() override;
+
+  // Calls ready() every time fd becomes readable until Unwatch(fd) is called.
+  // The descriptor is watched edge triggered, so ready() should consume all
+  // pending input (until EAGAIN).
+  overnet::Status WatchReadable(int fd, std::function<void()> ready);
+  void Unwatch(int fd);
+
+  // Calls before_wait() each time the loop is about to block waiting for
+  // events, until UnwatchBeforeWait(owner) is called (which must not happen
+  // from inside a before_wait() callback). Lets transports flush work they
+  // batched up over one turn of the loop.
+  void WatchBeforeWait(const void* owner, std::function<void()> before_wait);
+  void UnwatchBeforeWait(const void* owner);
+
+  // Runs the loop until Quit() is called.
+  void Run();
+  void Quit() { quit_ = true; }
+
+ private:
+  void InitTimeout(overnet::Timeout* timeout,
+                   overnet::TimeStamp when) override;
+  void CancelTimeout(overnet::Timeout* timeout,
+                     overnet::Status status) override;
+
+  using PendingTimeouts = std::multimap<int64_t, overnet::Timeout*>;
+
+  // Kept in the storage of each overnet::Timeout.
+  struct TimeoutState {
+    PendingTimeouts::iterator it;
+    bool pending;
+  };
+
+  void FireExpiredTimeouts();
+  void RunBeforeWait();
+  // How long epoll_wait may block for before the next timeout is due: -1 if
+  // there are none.
+  int WaitMilliseconds();
+
+  int epoll_fd_ = -1;
+  bool quit_ = false;
+  bool shutting_down_ = false;
+  PendingTimeouts pending_timeouts_;
+  std::unordered_map<int, std::function<void()>> watches_;
+  std::vector<std::pair<const void*, std::function<void()>>> before_wait_;
+};
+
+}  // namespace overnethost
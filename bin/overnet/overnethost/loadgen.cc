@@ -0,0 +1,455 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Load generator for overnet on Linux hosts.
+//
+// Builds a mesh of nodes on localhost, each with its own RouterEndpoint and
+// UDP socket, all serviced by one epoll loop. Opens many reliable datagram
+// streams between random pairs of nodes, pushes messages through them with a
+// fixed window of unacknowledged messages per stream, and reports message
+// throughput, end to end latency, CPU time per message and packets handled
+// per CPU second.
+
+#include <sys/resource.h>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "garnet/bin/overnet/overnethost/epoll_loop.h"
+#include "garnet/bin/overnet/overnethost/udp_nub.h"
+#include "garnet/lib/overnet/router_endpoint.h"
+#include "lib/fxl/command_line.h"
+#include "lib/fxl/strings/string_number_conversions.h"
+
+namespace overnethost {
+namespace {
+
+const char kUsage[] = R"(overnet_loadgen [options]
+
+  --nodes=<n>     Number of nodes in the mesh (default 4).
+  --streams=<n>   Number of streams, between random pairs of nodes
+                  (default 64).
+  --messages=<n>  Messages sent on each stream (default 1000).
+  --size=<bytes>  Size of each message, at least 8 (default 64).
+  --window=<n>    Unacknowledged messages allowed per stream (default 8).
+  --batch=<n>     Packets per sendmmsg/recvmmsg call; 1 sends and receives
+                  each packet with its own system call (default 32).
+  --seed=<n>      Seed for picking the stream endpoints (default 1).
+
+The routers only know about their direct links, so every pair of nodes is
+linked: the mesh is fully connected.
+)";
+
+struct Options {
+  size_t nodes = 4;
+  size_t streams = 64;
+  size_t messages = 1000;
+  size_t size = 64;
+  size_t window = 8;
+  size_t batch = kUdpNubDefaultBatchSize;
+  uint64_t seed = 1;
+};
+
+bool ParseOption(const fxl::CommandLine& cmdline, fxl::StringView name,
+                 size_t* value) {
+  std::string str;
+  if (!cmdline.GetOptionValue(name, &str))
+    return true;
+  return fxl::StringToNumberWithError(str, value);
+}
+
+bool ParseOptions(const fxl::CommandLine& cmdline, Options* options) {
+  size_t seed = options->seed;
+  if (!ParseOption(cmdline, "nodes", &options->nodes) ||
+      !ParseOption(cmdline, "streams", &options->streams) ||
+      !ParseOption(cmdline, "messages", &options->messages) ||
+      !ParseOption(cmdline, "size", &options->size) ||
+      !ParseOption(cmdline, "window", &options->window) ||
+      !ParseOption(cmdline, "batch", &options->batch) ||
+      !ParseOption(cmdline, "seed", &seed))
+    return false;
+  options->seed = seed;
+  return options->nodes >= 2 && options->size >= sizeof(int64_t) &&
+         options->window >= 1 && options->batch >= 1;
+}
+
+int64_t CpuMicroseconds() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * overnet::kUsPerSec +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+struct Node {
+  std::unique_ptr<overnet::RouterEndpoint> endpoint;
+  std::unique_ptr<UdpNub> nub;
+};
+
+class LoadGenerator {
+ public:
+  LoadGenerator(const Options& options) : options_(options) {}
+
+  int Run();
+
+ private:
+  // Sending side of one stream.
+  struct Sender {
+    LoadGenerator* generator;
+    overnet::ClosedPtr<overnet::RouterEndpoint::Stream> stream;
+    size_t sent = 0;
+    size_t outstanding = 0;
+  };
+
+  struct OutgoingMessage {
+    OutgoingMessage(Sender* sender, size_t size)
+        : sender(sender), op(sender->stream.get(), size) {}
+    Sender* const sender;
+    overnet::RouterEndpoint::SendOp op;
+  };
+
+  // Receiving side of one stream.
+  struct Receiver {
+    overnet::ClosedPtr<overnet::RouterEndpoint::Stream> stream;
+    overnet::RouterEndpoint::ReceiveOp* pending = nullptr;
+  };
+
+  overnet::Status StartNodes();
+  void WaitForMesh();
+  bool MeshConnected();
+  void StartStreams();
+  void AcceptStreams(Node* node);
+  void SendMore(Sender* sender);
+  void ReceiveNext(Receiver* receiver);
+  void MessageReceived(const std::vector<overnet::Slice>& message);
+  void MaybeQuit();
+  uint64_t PacketsHandled();
+  void Report();
+  void CloseStreams();
+  void CloseEndpoints();
+  void Shutdown();
+
+  const Options options_;
+  EpollLoop loop_;
+  std::vector<Node> nodes_;
+  std::vector<std::unique_ptr<Sender>> senders_;
+  std::vector<std::unique_ptr<Receiver>> receivers_;
+
+  size_t received_ = 0;
+  size_t finished_senders_ = 0;
+  std::vector<int64_t> latencies_us_;
+  overnet::TimeStamp start_time_ = overnet::TimeStamp::Epoch();
+  overnet::TimeStamp end_time_ = overnet::TimeStamp::Epoch();
+  int64_t start_cpu_us_ = 0;
+  int64_t end_cpu_us_ = 0;
+  uint64_t start_packets_ = 0;
+  uint64_t end_packets_ = 0;
+  overnet::Slice::AllocationStats start_slices_;
+  overnet::Slice::AllocationStats end_slices_;
+};
+
+int LoadGenerator::Run() {
+  auto status = loop_.Init().Then([this]() { return StartNodes(); });
+  if (status.is_error()) {
+    std::cerr << "Failed to start: " << status << "\n";
+    return 1;
+  }
+
+  WaitForMesh();
+  loop_.Run();
+  Report();
+  Shutdown();
+  return 0;
+}
+
+overnet::Status LoadGenerator::StartNodes() {
+  nodes_.resize(options_.nodes);
+  for (size_t i = 0; i < nodes_.size(); i++) {
+    nodes_[i].endpoint = std::make_unique<overnet::RouterEndpoint>(
+        &loop_, overnet::TraceSink(), overnet::NodeId(i + 1), true);
+    nodes_[i].nub = std::make_unique<UdpNub>(
+        &loop_, nodes_[i].endpoint.get(), overnet::TraceSink(),
+        options_.batch);
+    auto status = nodes_[i].nub->Start(in6addr_loopback);
+    if (status.is_error())
+      return status;
+  }
+  for (size_t i = 0; i < nodes_.size(); i++) {
+    for (size_t j = i + 1; j < nodes_.size(); j++) {
+      nodes_[i].nub->Initiate(nodes_[j].nub->local_address(),
+                              nodes_[j].nub->node_id());
+    }
+  }
+  return overnet::Status::Ok();
+}
+
+bool LoadGenerator::MeshConnected() {
+  for (const auto& from : nodes_) {
+    for (const auto& to : nodes_) {
+      if (!from.endpoint->router()->HasRouteTo(to.endpoint->node_id()))
+        return false;
+    }
+  }
+  return true;
+}
+
+void LoadGenerator::WaitForMesh() {
+  if (MeshConnected()) {
+    StartStreams();
+    return;
+  }
+  loop_.At(loop_.Now() + overnet::TimeDelta::FromMilliseconds(10),
+           [this]() { WaitForMesh(); });
+}
+
+void LoadGenerator::StartStreams() {
+  std::cout << "Mesh of " << nodes_.size() << " nodes connected" << std::endl;
+
+  for (auto& node : nodes_)
+    AcceptStreams(&node);
+
+  start_time_ = loop_.Now();
+  start_cpu_us_ = CpuMicroseconds();
+  start_packets_ = PacketsHandled();
+  start_slices_ = overnet::Slice::ThreadAllocationStats();
+  latencies_us_.reserve(options_.streams * options_.messages);
+  if (options_.streams == 0 || options_.messages == 0) {
+    loop_.Quit();
+    return;
+  }
+
+  std::mt19937_64 rng(options_.seed);
+  std::uniform_int_distribution<size_t> pick(0, nodes_.size() - 1);
+  for (size_t i = 0; i < options_.streams; i++) {
+    size_t from = pick(rng);
+    size_t to = pick(rng);
+    while (to == from)
+      to = pick(rng);
+
+    auto new_stream = nodes_[from].endpoint->SendIntro(
+        nodes_[to].endpoint->node_id(),
+        overnet::ReliabilityAndOrdering::ReliableOrdered,
+        overnet::Slice::FromStaticString("loadgen"));
+    if (new_stream.is_error()) {
+      std::cerr << "Failed to open stream: " << new_stream.AsStatus() << "\n";
+      loop_.Quit();
+      return;
+    }
+    auto sender = std::make_unique<Sender>();
+    sender->generator = this;
+    sender->stream = overnet::MakeClosedPtr<overnet::RouterEndpoint::Stream>(
+        std::move(*new_stream.get()), overnet::TraceSink());
+    SendMore(sender.get());
+    senders_.emplace_back(std::move(sender));
+  }
+}
+
+void LoadGenerator::AcceptStreams(Node* node) {
+  node->endpoint->RecvIntro(
+      overnet::StatusOrCallback<overnet::RouterEndpoint::ReceivedIntroduction>(
+          overnet::ALLOCATED_CALLBACK,
+          [this, node](
+              overnet::StatusOr<overnet::RouterEndpoint::ReceivedIntroduction>&&
+                  status) {
+            if (status.is_error())
+              return;
+            auto receiver = std::make_unique<Receiver>();
+            receiver->stream =
+                overnet::MakeClosedPtr<overnet::RouterEndpoint::Stream>(
+                    std::move(status->new_stream), overnet::TraceSink());
+            ReceiveNext(receiver.get());
+            receivers_.emplace_back(std::move(receiver));
+            // Re-arm from the loop rather than from inside the callback that
+            // is being run.
+            loop_.At(loop_.Now(), [this, node]() { AcceptStreams(node); });
+          }));
+}
+
+void LoadGenerator::SendMore(Sender* sender) {
+  while (sender->sent < options_.messages &&
+         sender->outstanding < options_.window) {
+    // Each message carries the time it was sent.
+    const int64_t now = loop_.Now().after_epoch().as_us();
+    auto* message = new OutgoingMessage(sender, options_.size);
+    message->op.Push(overnet::Slice::WithInitializer(
+        options_.size, [now, size = options_.size](uint8_t* p) {
+          memset(p, 0, size);
+          memcpy(p, &now, sizeof(now));
+        }));
+    sender->sent++;
+    sender->outstanding++;
+    // The op can only be deleted from its quiesced callback if that callback
+    // keeps no state besides the pointer.
+    message->op.Close(overnet::Status::Ok(), [message]() {
+      Sender* sender = message->sender;
+      delete message;
+      sender->outstanding--;
+      sender->generator->SendMore(sender);
+    });
+  }
+  // Streams can only be torn down once all of their sends have completed.
+  if (sender->sent == options_.messages && sender->outstanding == 0) {
+    finished_senders_++;
+    MaybeQuit();
+  }
+}
+
+void LoadGenerator::ReceiveNext(Receiver* receiver) {
+  auto* op = new overnet::RouterEndpoint::ReceiveOp(receiver->stream.get());
+  receiver->pending = op;
+  op->PullAll(overnet::StatusOrCallback<std::vector<overnet::Slice>>(
+      overnet::ALLOCATED_CALLBACK,
+      [this, op,
+       receiver](const overnet::StatusOr<std::vector<overnet::Slice>>& status) {
+        receiver->pending = nullptr;
+        delete op;
+        if (status.is_error())
+          return;
+        MessageReceived(*status);
+        ReceiveNext(receiver);
+      }));
+}
+
+void LoadGenerator::MessageReceived(
+    const std::vector<overnet::Slice>& message) {
+  const int64_t now = loop_.Now().after_epoch().as_us();
+  auto payload = overnet::Slice::Join(message.begin(), message.end());
+  if (payload.length() < sizeof(int64_t))
+    return;
+  int64_t sent;
+  memcpy(&sent, payload.begin(), sizeof(sent));
+  latencies_us_.push_back(now - sent);
+
+  if (++received_ == options_.streams * options_.messages) {
+    end_time_ = loop_.Now();
+    end_cpu_us_ = CpuMicroseconds();
+    end_packets_ = PacketsHandled();
+    end_slices_ = overnet::Slice::ThreadAllocationStats();
+    MaybeQuit();
+  }
+}
+
+void LoadGenerator::MaybeQuit() {
+  if (received_ == options_.streams * options_.messages &&
+      finished_senders_ == options_.streams)
+    loop_.Quit();
+}
+
+uint64_t LoadGenerator::PacketsHandled() {
+  uint64_t packets = 0;
+  for (const auto& node : nodes_)
+    packets += node.nub->packets_sent() + node.nub->packets_received();
+  return packets;
+}
+
+void LoadGenerator::Report() {
+  if (received_ == 0)
+    return;
+
+  const double seconds = (end_time_ - start_time_).as_us() / 1e6;
+  std::sort(latencies_us_.begin(), latencies_us_.end());
+  auto percentile = [this](double p) {
+    size_t index = static_cast<size_t>(p * (latencies_us_.size() - 1));
+    return latencies_us_[index];
+  };
+  const double cpu_seconds = (end_cpu_us_ - start_cpu_us_) / 1e6;
+  uint64_t packets_sent = 0;
+  uint64_t send_failures = 0;
+  uint64_t system_calls = 0;
+  for (const auto& node : nodes_) {
+    packets_sent += node.nub->packets_sent();
+    send_failures += node.nub->send_failures();
+    system_calls += node.nub->send_calls() + node.nub->receive_calls();
+  }
+
+  std::cout << "messages:        " << received_ << " of " << options_.size
+            << " bytes on " << options_.streams << " streams\n";
+  std::cout << "elapsed:         " << seconds << "s\n";
+  std::cout << "messages/s:      " << received_ / seconds << "\n";
+  std::cout << "latency p50:     " << percentile(0.5) << "us\n";
+  std::cout << "latency p99:     " << percentile(0.99) << "us\n";
+  std::cout << "cpu/message:     "
+            << static_cast<double>(end_cpu_us_ - start_cpu_us_) / received_
+            << "us\n";
+  std::cout << "packets sent:    " << packets_sent << " (" << send_failures
+            << " dropped by the socket)\n";
+  std::cout << "packets/cpu-s:   "
+            << (end_packets_ - start_packets_) / cpu_seconds
+            << " (sent and received)\n";
+  std::cout << "system calls:    " << system_calls << " (batch size "
+            << options_.batch << ")\n";
+  std::cout << "slice storage:   "
+            << end_slices_.pooled_allocations - start_slices_.pooled_allocations
+            << " pooled, "
+            << end_slices_.heap_allocations - start_slices_.heap_allocations
+            << " from the heap" << std::endl;
+}
+
+void LoadGenerator::CloseStreams() {
+  // Streams must finish closing before the endpoints that carry them do.
+  std::vector<overnet::RouterEndpoint::Stream*> streams;
+  for (auto& sender : senders_)
+    streams.push_back(sender->stream.release());
+  for (auto& receiver : receivers_) {
+    if (receiver->pending != nullptr)
+      receiver->pending->Close(overnet::Status::Cancelled());
+    streams.push_back(receiver->stream.release());
+  }
+  senders_.clear();
+  receivers_.clear();
+
+  size_t open_streams = streams.size();
+  for (auto* stream : streams) {
+    stream->Close(overnet::Status::Ok(),
+                  overnet::Callback<void>(
+                      overnet::ALLOCATED_CALLBACK,
+                      [this, stream, &open_streams]() {
+                        delete stream;
+                        if (--open_streams == 0)
+                          loop_.Quit();
+                      }));
+  }
+  if (open_streams != 0)
+    loop_.Run();
+}
+
+void LoadGenerator::CloseEndpoints() {
+  // Close the endpoints one after the other, then stop.
+  auto close_next = std::make_shared<std::function<void(size_t)>>();
+  *close_next = [this, close_next](size_t i) {
+    if (i == nodes_.size()) {
+      loop_.Quit();
+      return;
+    }
+    nodes_[i].endpoint->Close(
+        overnet::Callback<void>(overnet::ALLOCATED_CALLBACK,
+                                [close_next, i]() { (*close_next)(i + 1); }));
+  };
+  (*close_next)(0);
+  loop_.Run();
+  *close_next = nullptr;
+}
+
+void LoadGenerator::Shutdown() {
+  CloseStreams();
+  CloseEndpoints();
+  for (auto& node : nodes_) {
+    node.nub.reset();
+    node.endpoint.reset();
+  }
+}
+
+}  // namespace
+}  // namespace overnethost
+
+int main(int argc, const char** argv) {
+  fxl::CommandLine cmdline = fxl::CommandLineFromArgcArgv(argc, argv);
+  overnethost::Options options;
+  if (cmdline.HasOption("help") || !cmdline.positional_args().empty() ||
+      !overnethost::ParseOptions(cmdline, &options)) {
+    std::cerr << overnethost::kUsage;
+    return 1;
+  }
+  return overnethost::LoadGenerator(options).Run();
+}
@@ -0,0 +1,197 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/overnet/overnethost/udp_nub.h"
+
+#include <arpa/inet.h>
+#include <assert.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+
+namespace overnethost {
+
+namespace {
+
+overnet::Status StatusFromErrno(const std::string& why) {
+  int err = errno;
+  std::ostringstream msg;
+  msg << why << ", errno=" << err;
+  return overnet::Status(overnet::StatusCode::UNKNOWN, msg.str());
+}
+
+overnet::Slice NewReceiveBuffer() {
+  return overnet::Slice::WithInitializer(kUdpNubMSS, [](uint8_t*) {});
+}
+
+}  // namespace
+
+std::ostream& operator<<(std::ostream& out, const UdpAddr& addr) {
+  char dst[INET6_ADDRSTRLEN];
+  inet_ntop(AF_INET6, &addr.ipv6.sin6_addr, dst, sizeof(dst));
+  return out << "[" << dst << "]:" << ntohs(addr.ipv6.sin6_port);
+}
+
+UdpNub::UdpNub(EpollLoop* loop, overnet::RouterEndpoint* endpoint,
+               overnet::TraceSink trace_sink, size_t batch_size)
+    : UdpNubBase(loop, trace_sink, endpoint->node_id()),
+      loop_(loop),
+      endpoint_(endpoint),
+      batch_size_(std::max(batch_size, size_t(1))) {
+  memset(&local_address_, 0, sizeof(local_address_));
+  if (batch_size_ > 1) {
+    headers_.resize(batch_size_);
+    iovecs_.resize(batch_size_);
+    addresses_.resize(batch_size_);
+    for (size_t i = 0; i < batch_size_; i++)
+      receive_buffers_.push_back(NewReceiveBuffer());
+    set_batching(true);
+  }
+}
+
+UdpNub::~UdpNub() {
+  if (socket_fd_ != -1) {
+    loop_->UnwatchBeforeWait(this);
+    loop_->Unwatch(socket_fd_);
+    close(socket_fd_);
+  }
+}
+
+overnet::Status UdpNub::Start(const in6_addr& bind_address) {
+  socket_fd_ =
+      socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (socket_fd_ == -1)
+    return StatusFromErrno("Failed to create socket");
+
+  sockaddr_in6 addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin6_family = AF_INET6;
+  addr.sin6_addr = bind_address;
+  if (bind(socket_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+    return StatusFromErrno("Failed to bind()");
+
+  socklen_t len = sizeof(addr);
+  if (getsockname(socket_fd_, reinterpret_cast<sockaddr*>(&addr), &len) < 0)
+    return StatusFromErrno("Failed to getsockname() for new socket");
+  local_address_.ipv6 = addr;
+
+  if (batch_size_ == 1)
+    return loop_->WatchReadable(socket_fd_, [this]() { InboundReady(); });
+  loop_->WatchBeforeWait(this, [this]() { FlushBatch(); });
+  return loop_->WatchReadable(socket_fd_,
+                              [this]() { InboundReadyBatched(); });
+}
+
+void UdpNub::SendTo(UdpAddr addr, overnet::Slice slice) {
+  send_calls_++;
+  ssize_t r = sendto(socket_fd_, slice.begin(), slice.length(), 0,
+                     reinterpret_cast<const sockaddr*>(&addr.ipv6),
+                     sizeof(addr.ipv6));
+  if (r < 0) {
+    // Datagrams may be dropped: the packet protocol retransmits what matters.
+    send_failures_++;
+    return;
+  }
+  packets_sent_++;
+}
+
+void UdpNub::SendBatch(std::vector<Datagram>* packets) {
+  if (batch_size_ == 1) {
+    UdpNubBase::SendBatch(packets);
+    return;
+  }
+  size_t first = 0;
+  while (first < packets->size()) {
+    const size_t count = std::min(packets->size() - first, batch_size_);
+    for (size_t i = 0; i < count; i++) {
+      Datagram& packet = (*packets)[first + i];
+      addresses_[i] = packet.address;
+      iovecs_[i].iov_base = const_cast<uint8_t*>(packet.slice.begin());
+      iovecs_[i].iov_len = packet.slice.length();
+      memset(&headers_[i], 0, sizeof(headers_[i]));
+      headers_[i].msg_hdr.msg_name = &addresses_[i].ipv6;
+      headers_[i].msg_hdr.msg_namelen = sizeof(addresses_[i].ipv6);
+      headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+      headers_[i].msg_hdr.msg_iovlen = 1;
+    }
+    send_calls_++;
+    int r = sendmmsg(socket_fd_, headers_.data(), count, 0);
+    if (r <= 0) {
+      // As with SendTo: drop the packets and let the packet protocol recover.
+      send_failures_ += count;
+      first += count;
+      continue;
+    }
+    packets_sent_ += r;
+    first += r;
+    if (static_cast<size_t>(r) < count) {
+      // The packet after the last one sent could not be: drop it.
+      send_failures_++;
+      first++;
+    }
+  }
+}
+
+void UdpNub::Publish(overnet::LinkPtr<> link) {
+  overnet::NodeId node = link->GetLinkMetrics().to();
+  endpoint_->RegisterPeer(node);
+  endpoint_->router()->RegisterLink(std::move(link));
+}
+
+void UdpNub::InboundReady() {
+  for (;;) {
+    UdpAddr source_address;
+    socklen_t source_address_length = sizeof(source_address.ipv6);
+    auto inbound = NewReceiveBuffer();
+    receive_calls_++;
+    ssize_t result =
+        recvfrom(socket_fd_, const_cast<uint8_t*>(inbound.begin()),
+                 inbound.length(), 0,
+                 reinterpret_cast<sockaddr*>(&source_address.ipv6),
+                 &source_address_length);
+    if (result < 0) {
+      // EAGAIN: drained. Anything else is reported by the next readiness
+      // notification, if any.
+      return;
+    }
+    packets_received_++;
+    inbound.TrimEnd(inbound.length() - result);
+    Process(loop_->Now(), source_address, std::move(inbound));
+  }
+}
+
+void UdpNub::InboundReadyBatched() {
+  for (;;) {
+    for (size_t i = 0; i < batch_size_; i++) {
+      iovecs_[i].iov_base = const_cast<uint8_t*>(receive_buffers_[i].begin());
+      iovecs_[i].iov_len = receive_buffers_[i].length();
+      memset(&headers_[i], 0, sizeof(headers_[i]));
+      headers_[i].msg_hdr.msg_name = &addresses_[i].ipv6;
+      headers_[i].msg_hdr.msg_namelen = sizeof(addresses_[i].ipv6);
+      headers_[i].msg_hdr.msg_iov = &iovecs_[i];
+      headers_[i].msg_hdr.msg_iovlen = 1;
+    }
+    receive_calls_++;
+    int result =
+        recvmmsg(socket_fd_, headers_.data(), batch_size_, 0, nullptr);
+    if (result <= 0) {
+      // EAGAIN: drained.
+      return;
+    }
+    packets_received_ += result;
+    assert(received_.empty());
+    for (int i = 0; i < result; i++) {
+      overnet::Slice inbound = std::move(receive_buffers_[i]);
+      receive_buffers_[i] = NewReceiveBuffer();
+      inbound.TrimEnd(inbound.length() - headers_[i].msg_len);
+      received_.emplace_back(Datagram{addresses_[i], std::move(inbound)});
+    }
+    ProcessBatch(loop_->Now(), &received_);
+    received_.clear();
+  }
+}
+
+}  // namespace overnethost
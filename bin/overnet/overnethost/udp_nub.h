@@ -0,0 +1,112 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <ostream>
+#include <vector>
+#include "garnet/bin/overnet/overnethost/epoll_loop.h"
+#include "garnet/lib/overnet/packet_nub.h"
+#include "garnet/lib/overnet/router_endpoint.h"
+
+namespace overnethost {
+
+// An IPv6 UDP address (IPv4 peers are reached through mapped addresses).
+struct UdpAddr {
+  sockaddr_in6 ipv6;
+};
+
+std::ostream& operator<<(std::ostream& out, const UdpAddr& addr);
+
+class HashUdpAddr {
+ public:
+  size_t operator()(const UdpAddr& addr) const {
+    size_t out = ntohs(addr.ipv6.sin6_port);
+    const uint8_t* p = addr.ipv6.sin6_addr.s6_addr;
+    for (size_t i = 0; i < sizeof(addr.ipv6.sin6_addr); i++)
+      out = 257 * out + p[i];
+    return out;
+  }
+};
+
+class EqUdpAddr {
+ public:
+  bool operator()(const UdpAddr& a, const UdpAddr& b) const {
+    return a.ipv6.sin6_port == b.ipv6.sin6_port &&
+           0 == memcmp(&a.ipv6.sin6_addr, &b.ipv6.sin6_addr,
+                       sizeof(a.ipv6.sin6_addr));
+  }
+};
+
+static constexpr uint32_t kUdpNubMSS = 1500;
+// Datagrams handed to each sendmmsg/recvmmsg call by default.
+static constexpr size_t kUdpNubDefaultBatchSize = 32;
+
+using UdpNubBase =
+    overnet::PacketNub<UdpAddr, kUdpNubMSS, HashUdpAddr, EqUdpAddr>;
+
+// Carries overnet links over a non-blocking UDP socket serviced by an
+// EpollLoop.
+//
+// With a batch size above one, packets sent during a turn of the loop are
+// queued and sent with sendmmsg just before the loop blocks again, and input
+// is read with recvmmsg. A batch size of one uses sendto/recvfrom per packet.
+class UdpNub final : public UdpNubBase {
+ public:
+  UdpNub(EpollLoop* loop, overnet::RouterEndpoint* endpoint,
+         overnet::TraceSink trace_sink,
+         size_t batch_size = kUdpNubDefaultBatchSize);
+  ~UdpNub();
+
+  // Binds to an ephemeral port on the given address (in6addr_any by default)
+  // and starts servicing the socket.
+  overnet::Status Start(const in6_addr& bind_address = in6addr_any);
+
+  // The bound address, with the port filled in. Valid after Start().
+  UdpAddr local_address() const { return local_address_; }
+  overnet::NodeId node_id() const { return endpoint_->node_id(); }
+
+  // Counters for load measurement.
+  uint64_t packets_sent() const { return packets_sent_; }
+  uint64_t packets_received() const { return packets_received_; }
+  uint64_t send_failures() const { return send_failures_; }
+  // System calls made to send and receive packets.
+  uint64_t send_calls() const { return send_calls_; }
+  uint64_t receive_calls() const { return receive_calls_; }
+
+  void SendTo(UdpAddr addr, overnet::Slice slice) override;
+  void SendBatch(std::vector<Datagram>* packets) override;
+  overnet::Router* GetRouter() override { return endpoint_->router(); }
+  void Publish(overnet::LinkPtr<> link) override;
+
+ private:
+  // Reads until the socket is drained (the socket is watched edge triggered).
+  void InboundReady();
+  void InboundReadyBatched();
+
+  EpollLoop* const loop_;
+  overnet::RouterEndpoint* const endpoint_;
+  const size_t batch_size_;
+  int socket_fd_ = -1;
+  UdpAddr local_address_;
+
+  // Scratch space for sendmmsg/recvmmsg, batch_size_ entries each.
+  std::vector<mmsghdr> headers_;
+  std::vector<iovec> iovecs_;
+  std::vector<UdpAddr> addresses_;
+  // Receive buffers are only replaced once a packet has been read into them.
+  std::vector<overnet::Slice> receive_buffers_;
+  std::vector<Datagram> received_;
+
+  uint64_t packets_sent_ = 0;
+  uint64_t packets_received_ = 0;
+  uint64_t send_failures_ = 0;
+  uint64_t send_calls_ = 0;
+  uint64_t receive_calls_ = 0;
+};
+
+}  // namespace overnethost
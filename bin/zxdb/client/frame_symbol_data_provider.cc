@@ -18,6 +18,14 @@
 
 namespace zxdb {
 
+namespace {
+
+// Mistakes may make extremely large memory requests which can OOM the
+// system. Reads larger than this will be rejected.
+constexpr uint32_t kMaxMemoryRequestSize = 1024 * 1024;
+
+}  // namespace
+
 FrameSymbolDataProvider::FrameSymbolDataProvider(Frame* frame)
     : frame_(frame) {}
 
@@ -95,9 +103,7 @@ void FrameSymbolDataProvider::GetMemoryAsync(uint64_t address, uint32_t size,
     return;
   }
 
-  // Mistakes may make extremely large memory requests which can OOM the
-  // system. Prevent those.
-  if (size > 1024 * 1024) {
+  if (size > kMaxMemoryRequestSize) {
     debug_ipc::MessageLoop::Current()->PostTask(
         [ address, size, cb = std::move(callback) ]() {
           cb(Err(fxl::StringPrintf("Memory request for %u bytes at 0x%" PRIx64
@@ -143,6 +149,23 @@ void FrameSymbolDataProvider::GetMemoryAsync(uint64_t address, uint32_t size,
       });
 }
 
+void FrameSymbolDataProvider::PrefetchMemory(
+    const std::vector<AddressRange>& ranges) {
+  if (!frame_)
+    return;
+
+  std::vector<debug_ipc::MemoryRange> memory_ranges;
+  for (const AddressRange& range : ranges) {
+    if (range.empty() || range.size() > kMaxMemoryRequestSize)
+      continue;
+    memory_ranges.emplace_back();
+    memory_ranges.back().address = range.begin();
+    memory_ranges.back().size = static_cast<uint32_t>(range.size());
+  }
+  if (!memory_ranges.empty())
+    frame_->GetThread()->GetProcess()->PrefetchMemory(memory_ranges);
+}
+
 bool FrameSymbolDataProvider::IsTopFrame() const {
   if (!frame_)
     return false;
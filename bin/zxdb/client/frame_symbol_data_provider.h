@@ -28,6 +28,7 @@ class FrameSymbolDataProvider : public SymbolDataProvider {
                         GetRegisterCallback callback) override;
   void GetMemoryAsync(uint64_t address, uint32_t size,
                       GetMemoryCallback callback) override;
+  void PrefetchMemory(const std::vector<AddressRange>& ranges) override;
 
  private:
   FRIEND_MAKE_REF_COUNTED(FrameSymbolDataProvider);
@@ -0,0 +1,299 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/client/memory_cache.h"
+
+#include <algorithm>
+#include <set>
+
+#include "garnet/lib/debug_ipc/helper/message_loop.h"
+#include "garnet/public/lib/fxl/logging.h"
+
+namespace zxdb {
+
+namespace {
+
+// Ranges sent to the agent are limited to this size so the agent doesn't have
+// to allocate huge blocks for requests that coalesced many pages.
+constexpr uint64_t kMaxFetchRangeSize = 1024 * 1024;
+
+uint64_t PageBegin(uint64_t address) {
+  return address & ~(MemoryCache::kPageSize - 1);
+}
+
+}  // namespace
+
+struct MemoryCache::Page {
+  // When valid, data will contain kPageSize bytes. Otherwise it is empty.
+  bool valid = false;
+  std::vector<uint8_t> data;
+};
+
+struct MemoryCache::Read {
+  uint64_t address = 0;
+  uint32_t size = 0;
+  ReadCallback callback;
+
+  // Pages collected so far, indexed by page address.
+  std::map<uint64_t, std::shared_ptr<const Page>> pages;
+
+  // Number of fetches that must complete before the read can be completed.
+  int pending_fetches = 0;
+
+  // Set when any of the fetches failed.
+  Err err;
+};
+
+struct MemoryCache::Fetch {
+  uint64_t generation = 0;
+
+  // Sorted page addresses requested.
+  std::vector<uint64_t> pages;
+
+  std::vector<std::shared_ptr<Read>> reads;
+};
+
+constexpr uint64_t MemoryCache::kPageSize;
+constexpr size_t MemoryCache::kMaxCachedPages;
+
+MemoryCache::MemoryCache(FetchFunction fetch)
+    : fetch_(std::move(fetch)), weak_factory_(this) {}
+
+MemoryCache::~MemoryCache() = default;
+
+void MemoryCache::ReadMemory(uint64_t address, uint32_t size,
+                             ReadCallback callback) {
+  if (size == 0) {
+    debug_ipc::MessageLoop::Current()->PostTask(
+        [cb = std::move(callback)]() { cb(Err(), MemoryDump()); });
+    return;
+  }
+  uint64_t last = address + (size - 1);
+  if (last < address) {
+    debug_ipc::MessageLoop::Current()->PostTask([cb = std::move(callback)]() {
+      cb(Err("Memory range wraps around the address space."), MemoryDump());
+    });
+    return;
+  }
+
+  auto read = std::make_shared<Read>();
+  read->address = address;
+  read->size = size;
+  read->callback = std::move(callback);
+
+  std::vector<uint64_t> missing;
+  std::set<Fetch*> waiting_on;
+  for (uint64_t page = PageBegin(address);; page += kPageSize) {
+    auto found_page = pages_.find(page);
+    if (found_page != pages_.end()) {
+      read->pages[page] = found_page->second;
+    } else {
+      auto found_pending = pending_.find(page);
+      if (found_pending != pending_.end()) {
+        // Already being fetched, wait for that fetch.
+        Fetch* fetch = found_pending->second.get();
+        if (waiting_on.insert(fetch).second) {
+          fetch->reads.push_back(read);
+          read->pending_fetches++;
+        }
+      } else {
+        missing.push_back(page);
+      }
+    }
+
+    if (page == PageBegin(last))
+      break;
+  }
+
+  if (!missing.empty())
+    StartFetch(missing, read);
+
+  if (read->pending_fetches == 0) {
+    // Everything was cached.
+    debug_ipc::MessageLoop::Current()->PostTask(
+        [read]() { CompleteRead(*read); });
+  }
+}
+
+void MemoryCache::Prefetch(const std::vector<debug_ipc::MemoryRange>& ranges) {
+  std::set<uint64_t> missing;
+  for (const auto& range : ranges) {
+    if (range.size == 0)
+      continue;
+    uint64_t last = range.address + (range.size - 1);
+    if (last < range.address)
+      continue;  // Wraps around, ignore.
+
+    for (uint64_t page = PageBegin(range.address);; page += kPageSize) {
+      if (pages_.find(page) == pages_.end() &&
+          pending_.find(page) == pending_.end())
+        missing.insert(page);
+      if (page == PageBegin(last))
+        break;
+    }
+  }
+
+  if (!missing.empty())
+    StartFetch(std::vector<uint64_t>(missing.begin(), missing.end()), nullptr);
+}
+
+void MemoryCache::Invalidate() {
+  pages_.clear();
+  pending_.clear();
+  generation_++;
+}
+
+void MemoryCache::StartFetch(const std::vector<uint64_t>& pages,
+                             std::shared_ptr<Read> read) {
+  FXL_DCHECK(!pages.empty());
+
+  auto fetch = std::make_shared<Fetch>();
+  fetch->generation = generation_;
+  fetch->pages = pages;
+  for (uint64_t page : pages)
+    pending_[page] = fetch;
+  if (read) {
+    fetch->reads.push_back(std::move(read));
+    fetch->reads.back()->pending_fetches++;
+  }
+
+  // Coalesce adjacent pages into ranges.
+  std::vector<debug_ipc::MemoryRange> ranges;
+  for (uint64_t page : pages) {
+    if (!ranges.empty() &&
+        ranges.back().address + ranges.back().size == page &&
+        ranges.back().size + kPageSize <= kMaxFetchRangeSize) {
+      ranges.back().size += kPageSize;
+    } else {
+      ranges.emplace_back();
+      ranges.back().address = page;
+      ranges.back().size = kPageSize;
+    }
+  }
+
+  fetch_(std::move(ranges),
+         [cache = weak_factory_.GetWeakPtr(), fetch](
+             const Err& err, std::vector<debug_ipc::MemoryBlock> blocks) {
+           if (cache) {
+             cache->OnFetchComplete(std::move(fetch), err, blocks);
+           } else {
+             // The cache is gone but the reads still need their callbacks.
+             DeliverFetch(*fetch, Err("Process destroyed."), {});
+           }
+         });
+}
+
+void MemoryCache::OnFetchComplete(
+    std::shared_ptr<Fetch> fetch, const Err& err,
+    const std::vector<debug_ipc::MemoryBlock>& blocks) {
+  bool is_current = fetch->generation == generation_;
+  if (is_current) {
+    for (uint64_t page : fetch->pages) {
+      auto found = pending_.find(page);
+      if (found != pending_.end() && found->second == fetch)
+        pending_.erase(found);
+    }
+  }
+
+  if (err.has_error()) {
+    DeliverFetch(*fetch, err, {});
+    return;
+  }
+
+  // Split the returned blocks into pages. Process mappings are page-aligned
+  // so each page should be covered by exactly one block. Anything not covered
+  // that way is treated as unmapped.
+  std::vector<std::shared_ptr<const Page>> pages;
+  pages.reserve(fetch->pages.size());
+  size_t block_index = 0;
+  for (uint64_t page_addr : fetch->pages) {
+    while (block_index < blocks.size() &&
+           blocks[block_index].address + blocks[block_index].size <= page_addr)
+      block_index++;
+
+    auto page = std::make_shared<Page>();
+    if (block_index < blocks.size()) {
+      const debug_ipc::MemoryBlock& block = blocks[block_index];
+      if (block.valid && block.address <= page_addr &&
+          block.address + block.size >= page_addr + kPageSize &&
+          block.data.size() == block.size) {
+        page->valid = true;
+        auto begin = block.data.begin() + (page_addr - block.address);
+        page->data.assign(begin, begin + kPageSize);
+      }
+    }
+    pages.push_back(std::move(page));
+  }
+
+  if (is_current) {
+    if (pages_.size() + pages.size() > kMaxCachedPages)
+      pages_.clear();
+    for (size_t i = 0; i < pages.size(); i++)
+      pages_[fetch->pages[i]] = pages[i];
+  }
+
+  DeliverFetch(*fetch, Err(), pages);
+}
+
+// static
+void MemoryCache::DeliverFetch(
+    const Fetch& fetch, const Err& err,
+    const std::vector<std::shared_ptr<const Page>>& pages) {
+  for (const auto& read : fetch.reads) {
+    if (err.has_error()) {
+      read->err = err;
+    } else {
+      uint64_t first_page = PageBegin(read->address);
+      uint64_t last_page = PageBegin(read->address + (read->size - 1));
+      for (size_t i = 0; i < pages.size(); i++) {
+        uint64_t page_addr = fetch.pages[i];
+        if (page_addr >= first_page && page_addr <= last_page)
+          read->pages[page_addr] = pages[i];
+      }
+    }
+
+    read->pending_fetches--;
+    if (read->pending_fetches == 0)
+      CompleteRead(*read);
+  }
+}
+
+// static
+void MemoryCache::CompleteRead(const Read& read) {
+  if (read.err.has_error()) {
+    read.callback(read.err, MemoryDump());
+    return;
+  }
+
+  // Use inclusive ends, the range could extend to the top of the address
+  // space.
+  uint64_t last = read.address + (read.size - 1);
+  std::vector<debug_ipc::MemoryBlock> blocks;
+  for (const auto& pair : read.pages) {
+    uint64_t page_addr = pair.first;
+    const Page& page = *pair.second;
+
+    uint64_t begin = std::max(page_addr, read.address);
+    uint64_t page_last = page_addr + (kPageSize - 1);
+    uint32_t size =
+        static_cast<uint32_t>(std::min(page_last, last) - begin + 1);
+
+    // Merge with the previous block when possible.
+    if (blocks.empty() || blocks.back().valid != page.valid) {
+      blocks.emplace_back();
+      blocks.back().address = begin;
+      blocks.back().valid = page.valid;
+    }
+    debug_ipc::MemoryBlock& block = blocks.back();
+    block.size += size;
+    if (page.valid) {
+      auto data_begin = page.data.begin() + (begin - page_addr);
+      block.data.insert(block.data.end(), data_begin, data_begin + size);
+    }
+  }
+
+  read.callback(Err(), MemoryDump(std::move(blocks)));
+}
+
+}  // namespace zxdb
@@ -0,0 +1,110 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "garnet/bin/zxdb/client/memory_dump.h"
+#include "garnet/bin/zxdb/common/err.h"
+#include "garnet/lib/debug_ipc/records.h"
+#include "garnet/public/lib/fxl/macros.h"
+#include "garnet/public/lib/fxl/memory/weak_ptr.h"
+
+namespace zxdb {
+
+// A page-granularity cache of the memory of a stopped process.
+//
+// Formatting a variable can touch many small pieces of memory (structure
+// members, references, strings). Each read that misses the cache issues one
+// request for all the pages it needs, and reads of pages that are already
+// being fetched wait for that request rather than issuing their own. Prefetch
+// allows callers that know what they will read next to get all of the memory
+// in one round-trip.
+//
+// Memory is only valid while the process is stopped. The owner must call
+// Invalidate() whenever any thread in the process may have run. Reads that
+// were issued before the invalidation still complete with the memory that was
+// requested at that time.
+class MemoryCache {
+ public:
+  static constexpr uint64_t kPageSize = 4096;
+
+  // Discards everything when more than this many pages are cached.
+  static constexpr size_t kMaxCachedPages = 1024;
+
+  using ReadCallback = std::function<void(const Err&, MemoryDump)>;
+
+  // The function that actually reads memory from the process. The reply
+  // blocks must cover the requested ranges exactly, in order (see
+  // debug_ipc::ReadMemoryRangesReply).
+  using FetchReplyCallback =
+      std::function<void(const Err&, std::vector<debug_ipc::MemoryBlock>)>;
+  using FetchFunction = std::function<void(
+      std::vector<debug_ipc::MemoryRange> ranges, FetchReplyCallback cb)>;
+
+  explicit MemoryCache(FetchFunction fetch);
+  ~MemoryCache();
+
+  // Reads the given range. The callback will always be issued
+  // asynchronously, even when the memory is already cached.
+  void ReadMemory(uint64_t address, uint32_t size, ReadCallback callback);
+
+  // Starts fetching all pages in the given ranges that aren't already cached
+  // or being fetched, in one request.
+  void Prefetch(const std::vector<debug_ipc::MemoryRange>& ranges);
+
+  // Forgets all cached memory.
+  void Invalidate();
+
+  size_t cached_page_count() const { return pages_.size(); }
+
+ private:
+  struct Page;
+  struct Read;
+  struct Fetch;
+
+  // Requests the given pages (which must be sorted and not already cached or
+  // pending) in one batch. The read, if non-null, will be notified when the
+  // pages arrive.
+  void StartFetch(const std::vector<uint64_t>& pages,
+                  std::shared_ptr<Read> read);
+
+  void OnFetchComplete(std::shared_ptr<Fetch> fetch, const Err& err,
+                       const std::vector<debug_ipc::MemoryBlock>& blocks);
+
+  // Gives the result of the fetch to the reads waiting on it, completing the
+  // ones that have everything they need. This doesn't touch the cache so it
+  // can be called after the cache is destroyed.
+  static void DeliverFetch(
+      const Fetch& fetch, const Err& err,
+      const std::vector<std::shared_ptr<const Page>>& pages);
+
+  // Issues the callback for a read whose pages are all available.
+  static void CompleteRead(const Read& read);
+
+  FetchFunction fetch_;
+
+  // Incremented for each Invalidate() so the results of fetches that were
+  // issued before can be excluded from the cache.
+  uint64_t generation_ = 0;
+
+  // Indexed by page address.
+  std::map<uint64_t, std::shared_ptr<const Page>> pages_;
+
+  // Pages currently being fetched for the current generation, indexed by page
+  // address.
+  std::map<uint64_t, std::shared_ptr<Fetch>> pending_;
+
+  fxl::WeakPtrFactory<MemoryCache> weak_factory_;
+
+  FXL_DISALLOW_COPY_AND_ASSIGN(MemoryCache);
+};
+
+}  // namespace zxdb
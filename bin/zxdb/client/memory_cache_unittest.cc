@@ -0,0 +1,203 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/client/memory_cache.h"
+
+#include <algorithm>
+
+#include "garnet/bin/zxdb/common/test_with_loop.h"
+#include "gtest/gtest.h"
+
+namespace zxdb {
+
+namespace {
+
+constexpr uint64_t kPageSize = MemoryCache::kPageSize;
+
+// Memory is valid in [kValidBegin, kValidEnd). Each byte's value is the low
+// byte of its address.
+constexpr uint64_t kValidBegin = 0x10000;
+constexpr uint64_t kValidEnd = 0x14000;
+
+class MemoryCacheTest : public TestWithLoop {
+ public:
+  MemoryCacheTest()
+      : cache_([this](std::vector<debug_ipc::MemoryRange> ranges,
+                      MemoryCache::FetchReplyCallback cb) {
+          fetches_.push_back(ranges);
+          replies_.push_back(std::move(cb));
+        }) {}
+
+  MemoryCache& cache() { return cache_; }
+  const std::vector<std::vector<debug_ipc::MemoryRange>>& fetches() const {
+    return fetches_;
+  }
+
+  // Replies to all outstanding fetches with the memory described above.
+  void ReplyToFetches() {
+    for (size_t i = 0; i < replies_.size(); i++) {
+      std::vector<debug_ipc::MemoryBlock> blocks;
+      for (const auto& range : fetches_[fetches_.size() - replies_.size() + i])
+        AppendBlocks(range, &blocks);
+      replies_[i](Err(), std::move(blocks));
+    }
+    replies_.clear();
+  }
+
+  // Does a read and runs the loop until it completes.
+  MemoryDump SyncRead(uint64_t address, uint32_t size) {
+    bool called = false;
+    MemoryDump result;
+    cache_.ReadMemory(address, size, [&called, &result](const Err& err,
+                                                        MemoryDump dump) {
+      EXPECT_FALSE(err.has_error());
+      called = true;
+      result = std::move(dump);
+      debug_ipc::MessageLoop::Current()->QuitNow();
+    });
+    ReplyToFetches();
+    if (!called)
+      loop().Run();
+    EXPECT_TRUE(called);
+    return result;
+  }
+
+ private:
+  // Generates the blocks the agent would reply with for the given range.
+  static void AppendBlocks(const debug_ipc::MemoryRange& range,
+                           std::vector<debug_ipc::MemoryBlock>* blocks) {
+    uint64_t end = range.address + range.size;
+    uint64_t cur = range.address;
+    while (cur < end) {
+      debug_ipc::MemoryBlock block;
+      block.address = cur;
+      block.valid = cur >= kValidBegin && cur < kValidEnd;
+      uint64_t block_end;
+      if (block.valid)
+        block_end = std::min(end, kValidEnd);
+      else if (cur < kValidBegin)
+        block_end = std::min(end, kValidBegin);
+      else
+        block_end = end;
+      block.size = static_cast<uint32_t>(block_end - cur);
+      if (block.valid) {
+        for (uint64_t i = cur; i < block_end; i++)
+          block.data.push_back(static_cast<uint8_t>(i));
+      }
+      blocks->push_back(std::move(block));
+      cur = block_end;
+    }
+  }
+
+  MemoryCache cache_;
+  std::vector<std::vector<debug_ipc::MemoryRange>> fetches_;
+  std::vector<MemoryCache::FetchReplyCallback> replies_;
+};
+
+}  // namespace
+
+TEST_F(MemoryCacheTest, ReadAndCache) {
+  // Unaligned read crossing a page boundary should fetch both pages.
+  MemoryDump dump = SyncRead(kValidBegin + kPageSize - 2, 4);
+  ASSERT_EQ(1u, fetches().size());
+  ASSERT_EQ(1u, fetches()[0].size());
+  EXPECT_EQ(kValidBegin, fetches()[0][0].address);
+  EXPECT_EQ(kPageSize * 2, fetches()[0][0].size);
+
+  EXPECT_EQ(kValidBegin + kPageSize - 2, dump.address());
+  EXPECT_EQ(4u, dump.size());
+  ASSERT_EQ(1u, dump.blocks().size());
+  EXPECT_TRUE(dump.AllValid());
+  EXPECT_EQ(std::vector<uint8_t>({0xfe, 0xff, 0x00, 0x01}),
+            dump.blocks()[0].data);
+
+  // A read inside those pages shouldn't make a new request.
+  dump = SyncRead(kValidBegin + 16, 2);
+  EXPECT_EQ(1u, fetches().size());
+  ASSERT_EQ(1u, dump.blocks().size());
+  EXPECT_EQ(std::vector<uint8_t>({0x10, 0x11}), dump.blocks()[0].data);
+
+  // After invalidation the memory should be fetched again.
+  cache().Invalidate();
+  EXPECT_EQ(0u, cache().cached_page_count());
+  SyncRead(kValidBegin + 16, 2);
+  EXPECT_EQ(2u, fetches().size());
+}
+
+TEST_F(MemoryCacheTest, InvalidMemory) {
+  // Read straddling the end of valid memory.
+  MemoryDump dump = SyncRead(kValidEnd - 4, 8);
+  EXPECT_EQ(kValidEnd - 4, dump.address());
+  EXPECT_EQ(8u, dump.size());
+  ASSERT_EQ(2u, dump.blocks().size());
+  EXPECT_TRUE(dump.blocks()[0].valid);
+  EXPECT_EQ(4u, dump.blocks()[0].size);
+  EXPECT_EQ(std::vector<uint8_t>({0xfc, 0xfd, 0xfe, 0xff}),
+            dump.blocks()[0].data);
+  EXPECT_FALSE(dump.blocks()[1].valid);
+  EXPECT_EQ(kValidEnd, dump.blocks()[1].address);
+  EXPECT_EQ(4u, dump.blocks()[1].size);
+  EXPECT_TRUE(dump.blocks()[1].data.empty());
+}
+
+TEST_F(MemoryCacheTest, PrefetchAndPending) {
+  // Prefetch two separate areas. This should make one request with two
+  // ranges.
+  std::vector<debug_ipc::MemoryRange> ranges(2);
+  ranges[0].address = kValidBegin + 8;
+  ranges[0].size = 8;
+  ranges[1].address = kValidBegin + kPageSize * 2 + 8;
+  ranges[1].size = 8;
+  cache().Prefetch(ranges);
+  ASSERT_EQ(1u, fetches().size());
+  ASSERT_EQ(2u, fetches()[0].size());
+  EXPECT_EQ(kValidBegin, fetches()[0][0].address);
+  EXPECT_EQ(kValidBegin + kPageSize * 2, fetches()[0][1].address);
+
+  // Reading before the reply should wait for the prefetch rather than making
+  // a new request.
+  int completed = 0;
+  for (const auto& range : ranges) {
+    cache().ReadMemory(range.address, range.size,
+                       [&completed, range](const Err& err, MemoryDump dump) {
+                         EXPECT_FALSE(err.has_error());
+                         EXPECT_EQ(range.address, dump.address());
+                         EXPECT_EQ(range.size, dump.size());
+                         completed++;
+                       });
+  }
+  EXPECT_EQ(1u, fetches().size());
+  EXPECT_EQ(0, completed);
+
+  // Invalidating while the fetch is pending shouldn't prevent the pending
+  // reads from completing, but the results shouldn't be cached.
+  cache().Invalidate();
+  ReplyToFetches();
+  EXPECT_EQ(2, completed);
+  EXPECT_EQ(0u, cache().cached_page_count());
+}
+
+TEST_F(MemoryCacheTest, Error) {
+  MemoryCache::FetchReplyCallback reply;
+  MemoryCache error_cache(
+      [&reply](std::vector<debug_ipc::MemoryRange> ranges,
+               MemoryCache::FetchReplyCallback cb) { reply = std::move(cb); });
+
+  bool called = false;
+  auto read_cb = [&called](const Err& err, MemoryDump) {
+    EXPECT_TRUE(err.has_error());
+    called = true;
+  };
+  error_cache.ReadMemory(kValidBegin, 4, read_cb);
+  ASSERT_TRUE(reply);
+  reply(Err("Disconnected."), std::vector<debug_ipc::MemoryBlock>());
+  EXPECT_TRUE(called);
+
+  // Failures aren't cached, another read should make a new request.
+  reply = MemoryCache::FetchReplyCallback();
+  error_cache.ReadMemory(kValidBegin, 4, read_cb);
+  EXPECT_TRUE(reply);
+}
+
+}  // namespace zxdb
@@ -0,0 +1,475 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/client/minidump_file.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "garnet/public/lib/fxl/strings/string_printf.h"
+#include "garnet/public/lib/fxl/strings/utf_codecs.h"
+
+namespace zxdb {
+
+namespace {
+
+constexpr uint32_t kMinidumpSignature = 0x504d444d;  // "MDMP"
+constexpr uint16_t kMinidumpVersion = 0xa793;
+
+// Stream types.
+constexpr uint32_t kThreadListStream = 3;
+constexpr uint32_t kModuleListStream = 4;
+constexpr uint32_t kMemoryListStream = 5;
+constexpr uint32_t kSystemInfoStream = 7;
+constexpr uint32_t kMemory64ListStream = 9;
+constexpr uint32_t kMiscInfoStream = 15;
+
+// Flag in MinidumpMiscInfo.flags1 indicating process_id is valid.
+constexpr uint32_t kMiscInfoProcessID = 1;
+
+// CodeView record signatures.
+constexpr uint32_t kCodeViewPDB70 = 0x53445352;    // "RSDS"
+constexpr uint32_t kCodeViewBuildID = 0x4c457042;  // "BpEL"
+
+// The on-disk structures, see the MINIDUMP_* definitions in Windows'
+// minidumpapiset.h.
+#pragma pack(push, 1)
+
+struct MinidumpHeader {
+  uint32_t signature;
+  uint32_t version;
+  uint32_t stream_count;
+  uint32_t stream_directory_rva;
+  uint32_t checksum;
+  uint32_t time_date_stamp;
+  uint64_t flags;
+};
+
+struct MinidumpDirectory {
+  uint32_t stream_type;
+  uint32_t data_size;
+  uint32_t rva;
+};
+
+struct MinidumpLocation {
+  uint32_t data_size;
+  uint32_t rva;
+};
+
+struct MinidumpMemoryDescriptor {
+  uint64_t start_of_memory_range;
+  MinidumpLocation memory;
+};
+
+struct MinidumpMemoryDescriptor64 {
+  uint64_t start_of_memory_range;
+  uint64_t data_size;
+};
+
+struct MinidumpThread {
+  uint32_t thread_id;
+  uint32_t suspend_count;
+  uint32_t priority_class;
+  uint32_t priority;
+  uint64_t teb;
+  MinidumpMemoryDescriptor stack;
+  MinidumpLocation thread_context;
+};
+
+struct MinidumpModule {
+  uint64_t base_of_image;
+  uint32_t size_of_image;
+  uint32_t checksum;
+  uint32_t time_date_stamp;
+  uint32_t module_name_rva;
+  uint32_t version_info[13];  // VS_FIXEDFILEINFO.
+  MinidumpLocation cv_record;
+  MinidumpLocation misc_record;
+  uint64_t reserved0;
+  uint64_t reserved1;
+};
+
+struct MinidumpSystemInfo {
+  uint16_t processor_architecture;
+};
+
+struct MinidumpMiscInfo {
+  uint32_t size_of_info;
+  uint32_t flags1;
+  uint32_t process_id;
+};
+
+#pragma pack(pop)
+
+// Formats bytes as lowercase hex, the way the debug agent reports build IDs.
+std::string BytesToHex(const uint8_t* data, size_t size) {
+  std::string result;
+  for (size_t i = 0; i < size; i++)
+    result.append(fxl::StringPrintf("%02x", data[i]));
+  return result;
+}
+
+}  // namespace
+
+constexpr uint16_t MinidumpFile::kArchitectureAMD64;
+constexpr uint16_t MinidumpFile::kArchitectureARM64;
+constexpr uint16_t MinidumpFile::kArchitectureUnknown;
+
+MinidumpFile::MinidumpFile() = default;
+
+MinidumpFile::~MinidumpFile() {
+  if (data_)
+    munmap(data_, size_);
+}
+
+Err MinidumpFile::Open(const std::string& path) {
+  if (data_)
+    return Err("Dump already open");
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    return Err(fxl::StringPrintf("Could not open %s", path.c_str()));
+
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+    close(fd);
+    return Err(fxl::StringPrintf("Could not open %s", path.c_str()));
+  }
+
+  size_t size = static_cast<size_t>(file_stat.st_size);
+  void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  // The mapping stays valid after the descriptor is closed.
+  if (mapped == MAP_FAILED)
+    return Err(fxl::StringPrintf("Could not map %s", path.c_str()));
+  data_ = mapped;
+  size_ = size;
+
+  // Only the header and the stream directory are read up-front.
+  Err invalid(fxl::StringPrintf("Minidump %s not valid", path.c_str()));
+  MinidumpHeader header;
+  if (!ReadStruct(0, &header) || header.signature != kMinidumpSignature ||
+      (header.version & 0xffff) != kMinidumpVersion)
+    return invalid;
+
+  for (uint32_t i = 0; i < header.stream_count; i++) {
+    MinidumpDirectory dir;
+    if (!ReadStruct(header.stream_directory_rva +
+                        static_cast<uint64_t>(i) * sizeof(MinidumpDirectory),
+                    &dir))
+      return invalid;
+    if (!GetData(dir.rva, dir.data_size))
+      return invalid;
+
+    // Keep the first of any duplicated streams.
+    Stream stream;
+    stream.offset = dir.rva;
+    stream.size = dir.data_size;
+    streams_.emplace(dir.stream_type, stream);
+  }
+
+  return Err();
+}
+
+uint64_t MinidumpFile::GetProcessID() const {
+  const Stream* stream = FindStream(kMiscInfoStream);
+  MinidumpMiscInfo info;
+  if (!stream || stream->size < sizeof(info) ||
+      !ReadStruct(stream->offset, &info))
+    return 0;
+  if (!(info.flags1 & kMiscInfoProcessID))
+    return 0;
+  return info.process_id;
+}
+
+uint16_t MinidumpFile::GetProcessorArchitecture() const {
+  const Stream* stream = FindStream(kSystemInfoStream);
+  MinidumpSystemInfo info;
+  if (!stream || stream->size < sizeof(info) ||
+      !ReadStruct(stream->offset, &info))
+    return kArchitectureUnknown;
+  return info.processor_architecture;
+}
+
+std::vector<debug_ipc::ThreadRecord> MinidumpFile::GetThreads() const {
+  std::vector<debug_ipc::ThreadRecord> result;
+
+  const Stream* stream = FindStream(kThreadListStream);
+  uint32_t count = 0;
+  if (!stream || !ReadStruct(stream->offset, &count))
+    return result;
+
+  uint64_t offset = stream->offset + sizeof(uint32_t);
+  for (uint32_t i = 0; i < count; i++, offset += sizeof(MinidumpThread)) {
+    MinidumpThread thread;
+    if (!ReadStruct(offset, &thread))
+      break;
+
+    result.emplace_back();
+    result.back().koid = thread.thread_id;
+    // Everything in a dump is stopped at the point it was written.
+    result.back().state = debug_ipc::ThreadRecord::State::kSuspended;
+  }
+  return result;
+}
+
+std::vector<debug_ipc::Module> MinidumpFile::GetModules() const {
+  std::vector<debug_ipc::Module> result;
+
+  const Stream* stream = FindStream(kModuleListStream);
+  uint32_t count = 0;
+  if (!stream || !ReadStruct(stream->offset, &count))
+    return result;
+
+  uint64_t offset = stream->offset + sizeof(uint32_t);
+  for (uint32_t i = 0; i < count; i++, offset += sizeof(MinidumpModule)) {
+    MinidumpModule module;
+    if (!ReadStruct(offset, &module))
+      break;
+
+    result.emplace_back();
+    debug_ipc::Module& out = result.back();
+    out.name = ReadString(module.module_name_rva);
+    out.base = module.base_of_image;
+
+    // The build ID is stored in the CodeView record.
+    uint32_t signature = 0;
+    if (module.cv_record.data_size < sizeof(signature) ||
+        !ReadStruct(module.cv_record.rva, &signature))
+      continue;
+    if (signature == kCodeViewBuildID) {
+      // The whole build ID follows the signature.
+      uint32_t size = module.cv_record.data_size - sizeof(signature);
+      if (const uint8_t* id =
+              GetData(module.cv_record.rva + sizeof(signature), size))
+        out.build_id = BytesToHex(id, size);
+    } else if (signature == kCodeViewPDB70 &&
+               module.cv_record.data_size >= sizeof(signature) + 16) {
+      // Older writers put the first 16 bytes of the build ID in the GUID,
+      // whose first three fields were byte-swapped as little-endian integers.
+      const uint8_t* guid =
+          GetData(module.cv_record.rva + sizeof(signature), 16);
+      if (!guid)
+        continue;
+      uint8_t id[16];
+      memcpy(id, guid, sizeof(id));
+      std::reverse(&id[0], &id[4]);
+      std::reverse(&id[4], &id[6]);
+      std::reverse(&id[6], &id[8]);
+      out.build_id = BytesToHex(id, sizeof(id));
+    }
+  }
+  return result;
+}
+
+bool MinidumpFile::GetThreadContext(uint64_t thread_koid, const uint8_t** data,
+                                    uint32_t* size) const {
+  const Stream* stream = FindStream(kThreadListStream);
+  uint32_t count = 0;
+  if (!stream || !ReadStruct(stream->offset, &count))
+    return false;
+
+  uint64_t offset = stream->offset + sizeof(uint32_t);
+  for (uint32_t i = 0; i < count; i++, offset += sizeof(MinidumpThread)) {
+    MinidumpThread thread;
+    if (!ReadStruct(offset, &thread))
+      return false;
+    if (thread.thread_id != thread_koid)
+      continue;
+
+    *data = GetData(thread.thread_context.rva, thread.thread_context.data_size);
+    *size = thread.thread_context.data_size;
+    return !!*data;
+  }
+  return false;
+}
+
+std::vector<debug_ipc::MemoryBlock> MinidumpFile::ReadMemory(uint64_t address,
+                                                             uint32_t size) {
+  if (!memory_indexed_)
+    IndexMemory();
+
+  std::vector<debug_ipc::MemoryBlock> result;
+  if (size == 0)
+    return result;
+
+  // Use inclusive ends, the range could extend to the top of the address
+  // space.
+  uint64_t last = address + (size - 1);
+  if (last < address)
+    last = UINT64_MAX;
+
+  // Find the first region that could contain the address.
+  auto region = std::upper_bound(
+      memory_.begin(), memory_.end(), address,
+      [](uint64_t addr, const MemoryRegion& r) { return addr < r.address; });
+  if (region != memory_.begin() &&
+      std::prev(region)->address + (std::prev(region)->size - 1) >= address)
+    --region;
+
+  uint64_t cur = address;
+  while (true) {
+    debug_ipc::MemoryBlock block;
+    block.address = cur;
+
+    uint64_t block_last;
+    if (region != memory_.end() && region->address <= cur) {
+      // Inside a saved region.
+      block_last = std::min(last, region->address + (region->size - 1));
+      block.valid = true;
+      block.size = static_cast<uint32_t>(block_last - cur + 1);
+      const uint8_t* src =
+          static_cast<const uint8_t*>(data_) + region->file_offset +
+          (cur - region->address);
+      block.data.assign(src, src + block.size);
+      ++region;
+    } else {
+      // A gap before the next region.
+      if (region == memory_.end() || region->address > last)
+        block_last = last;
+      else
+        block_last = region->address - 1;
+      block.size = static_cast<uint32_t>(block_last - cur + 1);
+    }
+
+    // Merge with adjacent regions.
+    if (!result.empty() && result.back().valid == block.valid) {
+      debug_ipc::MemoryBlock& prev = result.back();
+      prev.size += block.size;
+      prev.data.insert(prev.data.end(), block.data.begin(), block.data.end());
+    } else {
+      result.push_back(std::move(block));
+    }
+
+    if (block_last == last)
+      break;
+    cur = block_last + 1;
+  }
+  return result;
+}
+
+const uint8_t* MinidumpFile::GetData(uint64_t offset, uint64_t size) const {
+  if (offset > size_ || size > size_ - offset)
+    return nullptr;
+  return static_cast<const uint8_t*>(data_) + offset;
+}
+
+template <typename T>
+bool MinidumpFile::ReadStruct(uint64_t offset, T* out) const {
+  const uint8_t* src = GetData(offset, sizeof(T));
+  if (!src)
+    return false;
+  memcpy(out, src, sizeof(T));
+  return true;
+}
+
+const MinidumpFile::Stream* MinidumpFile::FindStream(uint32_t type) const {
+  auto found = streams_.find(type);
+  if (found == streams_.end())
+    return nullptr;
+  return &found->second;
+}
+
+std::string MinidumpFile::ReadString(uint32_t offset) const {
+  std::string result;
+
+  // The string is a byte length followed by that many bytes of UTF-16.
+  uint32_t byte_len = 0;
+  if (!ReadStruct(offset, &byte_len))
+    return result;
+  const uint8_t* src = GetData(offset + sizeof(uint32_t), byte_len);
+  if (!src)
+    return result;
+
+  size_t count = byte_len / sizeof(uint16_t);
+  for (size_t i = 0; i < count; i++) {
+    uint16_t unit;
+    memcpy(&unit, &src[i * sizeof(uint16_t)], sizeof(uint16_t));
+    uint32_t code_point = unit;
+    if (unit >= 0xd800 && unit < 0xdc00 && i + 1 < count) {
+      // Surrogate pair.
+      uint16_t low;
+      memcpy(&low, &src[(i + 1) * sizeof(uint16_t)], sizeof(uint16_t));
+      if (low >= 0xdc00 && low < 0xe000) {
+        code_point = 0x10000 + ((unit - 0xd800) << 10) + (low - 0xdc00);
+        i++;
+      }
+    }
+    fxl::WriteUnicodeCharacter(code_point, &result);
+  }
+  return result;
+}
+
+void MinidumpFile::IndexMemory() {
+  memory_indexed_ = true;
+
+  std::vector<MemoryRegion> regions;
+  if (const Stream* stream = FindStream(kMemoryListStream)) {
+    uint32_t count = 0;
+    if (ReadStruct(stream->offset, &count)) {
+      uint64_t offset = stream->offset + sizeof(uint32_t);
+      for (uint32_t i = 0; i < count;
+           i++, offset += sizeof(MinidumpMemoryDescriptor)) {
+        MinidumpMemoryDescriptor desc;
+        if (!ReadStruct(offset, &desc))
+          break;
+        if (desc.memory.data_size == 0 ||
+            !GetData(desc.memory.rva, desc.memory.data_size))
+          continue;
+        regions.emplace_back();
+        regions.back().address = desc.start_of_memory_range;
+        regions.back().size = desc.memory.data_size;
+        regions.back().file_offset = desc.memory.rva;
+      }
+    }
+  }
+
+  // Full-memory dumps store the data for all ranges contiguously starting at
+  // a base offset.
+  if (const Stream* stream = FindStream(kMemory64ListStream)) {
+    uint64_t count = 0;
+    uint64_t data_offset = 0;
+    if (ReadStruct(stream->offset, &count) &&
+        ReadStruct(stream->offset + sizeof(uint64_t), &data_offset)) {
+      uint64_t offset = stream->offset + sizeof(uint64_t) * 2;
+      for (uint64_t i = 0; i < count;
+           i++, offset += sizeof(MinidumpMemoryDescriptor64)) {
+        MinidumpMemoryDescriptor64 desc;
+        if (!ReadStruct(offset, &desc) ||
+            !GetData(data_offset, desc.data_size))
+          break;
+        if (desc.data_size > 0) {
+          regions.emplace_back();
+          regions.back().address = desc.start_of_memory_range;
+          regions.back().size = desc.data_size;
+          regions.back().file_offset = data_offset;
+        }
+        data_offset += desc.data_size;
+      }
+    }
+  }
+
+  // Sort and drop anything that overlaps a previous region or wraps around
+  // the address space.
+  std::sort(regions.begin(), regions.end(),
+            [](const MemoryRegion& a, const MemoryRegion& b) {
+              return a.address < b.address;
+            });
+  memory_.clear();
+  for (const MemoryRegion& region : regions) {
+    uint64_t region_last = region.address + (region.size - 1);
+    if (region_last < region.address)
+      continue;
+    if (!memory_.empty() &&
+        memory_.back().address + (memory_.back().size - 1) >= region.address)
+      continue;
+    memory_.push_back(region);
+  }
+}
+
+}  // namespace zxdb
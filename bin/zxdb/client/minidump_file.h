@@ -0,0 +1,105 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "garnet/bin/zxdb/common/err.h"
+#include "garnet/lib/debug_ipc/records.h"
+#include "garnet/public/lib/fxl/macros.h"
+
+namespace zxdb {
+
+// Read-only access to a minidump file.
+//
+// The file is mapped into memory and opening it only validates the header
+// and the stream directory. Streams are decoded from the mapping when they
+// are queried, so opening a dump takes the same time regardless of its size
+// and only the parts of the file that are actually used get paged in.
+class MinidumpFile {
+ public:
+  // Values of the processor architecture in the system info stream.
+  static constexpr uint16_t kArchitectureAMD64 = 9;
+  static constexpr uint16_t kArchitectureARM64 = 12;
+  static constexpr uint16_t kArchitectureUnknown = 0xffff;
+
+  MinidumpFile();
+  ~MinidumpFile();
+
+  Err Open(const std::string& path);
+
+  // Returns 0 if the dump doesn't record the process ID.
+  uint64_t GetProcessID() const;
+
+  // Returns kArchitectureUnknown if the dump has no system info.
+  uint16_t GetProcessorArchitecture() const;
+
+  std::vector<debug_ipc::ThreadRecord> GetThreads() const;
+  std::vector<debug_ipc::Module> GetModules() const;
+
+  // Finds the CPU context record (a MINIDUMP_CONTEXT_* structure for the
+  // dump's architecture) of the given thread. The data points into the
+  // mapping and is valid for the lifetime of this object. Returns false if
+  // the thread or its context isn't in the dump.
+  bool GetThreadContext(uint64_t thread_koid, const uint8_t** data,
+                        uint32_t* size) const;
+
+  // Reads process memory saved in the dump. The blocks cover the requested
+  // range exactly, with memory not present in the dump reported as invalid.
+  // The first call builds an index of the memory streams.
+  std::vector<debug_ipc::MemoryBlock> ReadMemory(uint64_t address,
+                                                 uint32_t size);
+
+ private:
+  struct Stream {
+    uint32_t offset = 0;
+    uint32_t size = 0;
+  };
+
+  // A contiguous range of process memory stored in the file.
+  struct MemoryRegion {
+    uint64_t address = 0;
+    uint64_t size = 0;
+    uint64_t file_offset = 0;
+  };
+
+  // Returns a pointer to |size| bytes at the given file offset, or null if
+  // that extends past the end of the file.
+  const uint8_t* GetData(uint64_t offset, uint64_t size) const;
+
+  // Copies a structure from the given file offset, returning false if it's
+  // out of range.
+  template <typename T>
+  bool ReadStruct(uint64_t offset, T* out) const;
+
+  // Returns a pointer to the given stream (which is null if the dump doesn't
+  // have one) and its size.
+  const Stream* FindStream(uint32_t type) const;
+
+  // Decodes the UTF-16 MINIDUMP_STRING at the given offset.
+  std::string ReadString(uint32_t offset) const;
+
+  // Builds memory_ from the memory list streams.
+  void IndexMemory();
+
+  // The mapped file.
+  void* data_ = nullptr;
+  size_t size_ = 0;
+
+  // Indexed by stream type.
+  std::map<uint32_t, Stream> streams_;
+
+  // Sorted by address and non-overlapping. Valid when memory_indexed_ is set.
+  bool memory_indexed_ = false;
+  std::vector<MemoryRegion> memory_;
+
+  FXL_DISALLOW_COPY_AND_ASSIGN(MinidumpFile);
+};
+
+}  // namespace zxdb
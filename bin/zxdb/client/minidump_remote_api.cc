@@ -4,16 +4,223 @@
 
 #include "garnet/bin/zxdb/client/minidump_remote_api.h"
 
+#include <string.h>
+
+#include <algorithm>
+
+#include "garnet/bin/zxdb/client/minidump_file.h"
 #include "garnet/bin/zxdb/common/err.h"
 #include "garnet/lib/debug_ipc/client_protocol.h"
 #include "garnet/lib/debug_ipc/helper/message_loop.h"
+#include "garnet/lib/debug_ipc/register_desc.h"
 #include "garnet/public/lib/fxl/strings/string_printf.h"
-#include "third_party/crashpad/snapshot/minidump/process_snapshot_minidump.h"
 
 namespace zxdb {
 
 namespace {
 
+using debug_ipc::RegisterCategory;
+using debug_ipc::RegisterID;
+
+// Frame-pointer unwinding stops after this many frames.
+constexpr size_t kMaxBacktraceDepth = 256;
+
+// Offsets of the registers in the x64 thread context (MINIDUMP_CONTEXT_AMD64,
+// which is the Windows CONTEXT structure).
+constexpr uint32_t kX64ContextSize = 1232;
+constexpr uint32_t kX64ContextMxcsr = 52;
+constexpr uint32_t kX64ContextEflags = 68;
+constexpr uint32_t kX64ContextDr0 = 72;
+constexpr uint32_t kX64ContextRax = 120;
+constexpr uint32_t kX64ContextRip = 248;
+constexpr uint32_t kX64ContextFltSave = 256;
+
+// Offsets within the FXSAVE area at kX64ContextFltSave.
+constexpr uint32_t kFxsaveFcw = 0;
+constexpr uint32_t kFxsaveFsw = 2;
+constexpr uint32_t kFxsaveFtw = 4;
+constexpr uint32_t kFxsaveFop = 6;
+constexpr uint32_t kFxsaveFip = 8;
+constexpr uint32_t kFxsaveFdp = 16;
+constexpr uint32_t kFxsaveSt0 = 32;
+constexpr uint32_t kFxsaveXmm0 = 160;
+
+// Offsets of the registers in the ARM64 thread context
+// (MINIDUMP_CONTEXT_ARM64, which is the Windows ARM64_NT_CONTEXT structure).
+// X0-X28 are followed by the frame pointer (X29) so X0-X29 are contiguous.
+constexpr uint32_t kArm64ContextSize = 912;
+constexpr uint32_t kArm64ContextCpsr = 4;
+constexpr uint32_t kArm64ContextX0 = 8;
+constexpr uint32_t kArm64ContextFp = 240;
+constexpr uint32_t kArm64ContextLr = 248;
+constexpr uint32_t kArm64ContextSp = 256;
+constexpr uint32_t kArm64ContextPc = 264;
+constexpr uint32_t kArm64ContextV0 = 272;
+constexpr uint32_t kArm64ContextFpcr = 784;
+constexpr uint32_t kArm64ContextFpsr = 788;
+
+// General registers in the order they're stored in the context starting at
+// kX64ContextRax.
+constexpr RegisterID kX64ContextGeneralRegs[] = {
+    RegisterID::kX64_rax, RegisterID::kX64_rcx, RegisterID::kX64_rdx,
+    RegisterID::kX64_rbx, RegisterID::kX64_rsp, RegisterID::kX64_rbp,
+    RegisterID::kX64_rsi, RegisterID::kX64_rdi, RegisterID::kX64_r8,
+    RegisterID::kX64_r9,  RegisterID::kX64_r10, RegisterID::kX64_r11,
+    RegisterID::kX64_r12, RegisterID::kX64_r13, RegisterID::kX64_r14,
+    RegisterID::kX64_r15};
+
+// Debug registers in the order they're stored starting at kX64ContextDr0.
+constexpr RegisterID kX64ContextDebugRegs[] = {
+    RegisterID::kX64_dr0, RegisterID::kX64_dr1, RegisterID::kX64_dr2,
+    RegisterID::kX64_dr3, RegisterID::kX64_dr6, RegisterID::kX64_dr7};
+
+// Copies |length| bytes at |offset| in the context into a register,
+// zero-extending it to |reg_length| (which defaults to |length|).
+debug_ipc::Register ContextRegister(const uint8_t* context, RegisterID id,
+                                    uint32_t offset, uint32_t length,
+                                    uint32_t reg_length = 0) {
+  debug_ipc::Register reg;
+  reg.id = id;
+  reg.data.resize(std::max(length, reg_length));
+  memcpy(&reg.data[0], &context[offset], length);
+  return reg;
+}
+
+// Decodes the requested categories of registers from an x64 thread context,
+// which must be at least kX64ContextSize bytes. The registers match the ones
+// the debug agent reports, except that the vector registers are only the SSE
+// ones since the context doesn't include the AVX state.
+std::vector<RegisterCategory> DecodeX64Registers(
+    const uint8_t* context, const std::vector<RegisterCategory::Type>& types) {
+  std::vector<RegisterCategory> result;
+  for (RegisterCategory::Type type : types) {
+    RegisterCategory cat;
+    cat.type = type;
+    std::vector<debug_ipc::Register>& regs = cat.registers;
+    switch (type) {
+      case RegisterCategory::Type::kGeneral: {
+        uint32_t offset = kX64ContextRax;
+        for (RegisterID id : kX64ContextGeneralRegs) {
+          regs.push_back(ContextRegister(context, id, offset, 8));
+          offset += 8;
+        }
+        regs.push_back(ContextRegister(context, RegisterID::kX64_rip,
+                                       kX64ContextRip, 8));
+        regs.push_back(ContextRegister(context, RegisterID::kX64_rflags,
+                                       kX64ContextEflags, 4, 8));
+        break;
+      }
+      case RegisterCategory::Type::kFloatingPoint: {
+        const uint8_t* fp = &context[kX64ContextFltSave];
+        regs.push_back(
+            ContextRegister(fp, RegisterID::kX64_fcw, kFxsaveFcw, 2));
+        regs.push_back(
+            ContextRegister(fp, RegisterID::kX64_fsw, kFxsaveFsw, 2));
+        regs.push_back(
+            ContextRegister(fp, RegisterID::kX64_ftw, kFxsaveFtw, 1, 2));
+        regs.push_back(
+            ContextRegister(fp, RegisterID::kX64_fop, kFxsaveFop, 2));
+        regs.push_back(
+            ContextRegister(fp, RegisterID::kX64_fip, kFxsaveFip, 8));
+        regs.push_back(
+            ContextRegister(fp, RegisterID::kX64_fdp, kFxsaveFdp, 8));
+        for (uint32_t i = 0; i < 8; i++) {
+          auto id = static_cast<RegisterID>(
+              static_cast<uint32_t>(RegisterID::kX64_st0) + i);
+          regs.push_back(ContextRegister(fp, id, kFxsaveSt0 + i * 16, 16));
+        }
+        break;
+      }
+      case RegisterCategory::Type::kVector: {
+        regs.push_back(ContextRegister(context, RegisterID::kX64_mxcsr,
+                                       kX64ContextMxcsr, 4));
+        const uint8_t* fp = &context[kX64ContextFltSave];
+        for (uint32_t i = 0; i < 16; i++) {
+          auto id = static_cast<RegisterID>(
+              static_cast<uint32_t>(RegisterID::kX64_xmm0) + i);
+          regs.push_back(ContextRegister(fp, id, kFxsaveXmm0 + i * 16, 16));
+        }
+        break;
+      }
+      case RegisterCategory::Type::kDebug: {
+        uint32_t offset = kX64ContextDr0;
+        for (RegisterID id : kX64ContextDebugRegs) {
+          regs.push_back(ContextRegister(context, id, offset, 8));
+          offset += 8;
+        }
+        break;
+      }
+      case RegisterCategory::Type::kNone:
+        continue;
+    }
+    result.push_back(std::move(cat));
+  }
+  return result;
+}
+
+// Decodes the requested categories of registers from an ARM64 thread context,
+// which must be at least kArm64ContextSize bytes. As with the debug agent,
+// the floating point category is empty (ARMv8 keeps those in the vector
+// registers) and the debug category isn't supported.
+std::vector<RegisterCategory> DecodeArm64Registers(
+    const uint8_t* context, const std::vector<RegisterCategory::Type>& types) {
+  std::vector<RegisterCategory> result;
+  for (RegisterCategory::Type type : types) {
+    RegisterCategory cat;
+    cat.type = type;
+    std::vector<debug_ipc::Register>& regs = cat.registers;
+    switch (type) {
+      case RegisterCategory::Type::kGeneral: {
+        for (uint32_t i = 0; i < 30; i++) {
+          auto id = static_cast<RegisterID>(
+              static_cast<uint32_t>(RegisterID::kARMv8_x0) + i);
+          regs.push_back(ContextRegister(context, id, kArm64ContextX0 + i * 8,
+                                         8));
+        }
+        regs.push_back(ContextRegister(context, RegisterID::kARMv8_lr,
+                                       kArm64ContextLr, 8));
+        regs.push_back(ContextRegister(context, RegisterID::kARMv8_sp,
+                                       kArm64ContextSp, 8));
+        regs.push_back(ContextRegister(context, RegisterID::kARMv8_pc,
+                                       kArm64ContextPc, 8));
+        regs.push_back(ContextRegister(context, RegisterID::kARMv8_cpsr,
+                                       kArm64ContextCpsr, 4, 8));
+        break;
+      }
+      case RegisterCategory::Type::kFloatingPoint:
+        break;
+      case RegisterCategory::Type::kVector: {
+        regs.push_back(ContextRegister(context, RegisterID::kARMv8_fpcr,
+                                       kArm64ContextFpcr, 4));
+        regs.push_back(ContextRegister(context, RegisterID::kARMv8_fpsr,
+                                       kArm64ContextFpsr, 4));
+        for (uint32_t i = 0; i < 32; i++) {
+          auto id = static_cast<RegisterID>(
+              static_cast<uint32_t>(RegisterID::kARMv8_v0) + i);
+          regs.push_back(
+              ContextRegister(context, id, kArm64ContextV0 + i * 16, 16));
+        }
+        break;
+      }
+      case RegisterCategory::Type::kDebug:
+      case RegisterCategory::Type::kNone:
+        continue;
+    }
+    result.push_back(std::move(cat));
+  }
+  return result;
+}
+
+// Reads a 64-bit value from the dump's memory.
+bool ReadUint64(MinidumpFile* minidump, uint64_t address, uint64_t* value) {
+  std::vector<debug_ipc::MemoryBlock> blocks =
+      minidump->ReadMemory(address, sizeof(uint64_t));
+  if (blocks.size() != 1 || !blocks[0].valid)
+    return false;
+  memcpy(value, &blocks[0].data[0], sizeof(uint64_t));
+  return true;
+}
+
 Err ErrNoLive() {
   return Err(ErrType::kNoConnection, "System is no longer live");
 }
@@ -22,6 +229,12 @@ Err ErrNoImpl() { return Err("Feature not implemented for minidump"); }
 
 Err ErrNoDump() { return Err("Core dump failed to open"); }
 
+Err ErrNoArch() {
+  return Err("Core dump doesn't say which processor architecture it's for");
+}
+
+Err ErrBadContext() { return Err("Thread context in core dump is truncated"); }
+
 template <typename ReplyType>
 void ErrNoLive(std::function<void(const Err&, ReplyType)> cb) {
   debug_ipc::MessageLoop::Current()->PostTask(
@@ -40,10 +253,16 @@ void ErrNoDump(std::function<void(const Err&, ReplyType)> cb) {
     [cb]() { cb(ErrNoDump(), ReplyType()); });
 }
 
+template <typename ReplyType>
+void Fail(std::function<void(const Err&, ReplyType)> cb, const Err& err) {
+  debug_ipc::MessageLoop::Current()->PostTask(
+    [cb, err]() { cb(err, ReplyType()); });
+}
+
 template <typename ReplyType>
 void Succeed(std::function<void(const Err&, ReplyType)> cb, ReplyType r) {
   debug_ipc::MessageLoop::Current()->PostTask(
-    [cb, r]() { cb(Err(), r); });
+    [cb, r = std::move(r)]() { cb(Err(), r); });
 }
 
 }  // namespace
@@ -52,25 +271,27 @@ MinidumpRemoteAPI::MinidumpRemoteAPI() = default;
 MinidumpRemoteAPI::~MinidumpRemoteAPI() = default;
 
 Err MinidumpRemoteAPI::Open(const std::string& path) {
-  crashpad::FileReader reader;
-
   if (minidump_) {
     return Err("Dump already open");
   }
 
-  if (!reader.Open(base::FilePath(path))) {
-    return Err(fxl::StringPrintf("Could not open %s", path.c_str()));
-  }
-
-  minidump_ = std::make_unique<crashpad::ProcessSnapshotMinidump>();
-  bool success = minidump_->Initialize(&reader);
-  reader.Close();
-
-  if (!success) {
-    minidump_.release();
-    return Err(fxl::StringPrintf("Minidump %s not valid", path.c_str()));
+  auto minidump = std::make_unique<MinidumpFile>();
+  Err err = minidump->Open(path);
+  if (err.has_error())
+    return err;
+
+  // Registers and backtraces can only be decoded for these. Dumps without
+  // system information are still useful for their modules and memory.
+  uint16_t arch = minidump->GetProcessorArchitecture();
+  if (arch != MinidumpFile::kArchitectureAMD64 &&
+      arch != MinidumpFile::kArchitectureARM64 &&
+      arch != MinidumpFile::kArchitectureUnknown) {
+    return Err(fxl::StringPrintf(
+        "Core dump %s is for an unsupported processor architecture (%u).",
+        path.c_str(), static_cast<unsigned>(arch)));
   }
 
+  minidump_ = std::move(minidump);
   return Err();
 }
 
@@ -118,8 +339,15 @@ void MinidumpRemoteAPI::Detach(
 void MinidumpRemoteAPI::Modules(
     const debug_ipc::ModulesRequest& request,
     std::function<void(const Err&, debug_ipc::ModulesReply)> cb) {
-  // TODO
-  ErrNoImpl(cb);
+  if (!minidump_) {
+    ErrNoDump(cb);
+    return;
+  }
+
+  debug_ipc::ModulesReply reply;
+  if (request.process_koid == minidump_->GetProcessID())
+    reply.modules = minidump_->GetModules();
+  Succeed(cb, std::move(reply));
 }
 
 void MinidumpRemoteAPI::Pause(
@@ -146,7 +374,7 @@ void MinidumpRemoteAPI::ProcessTree(
 
   record.type = debug_ipc::ProcessTreeRecord::Type::kProcess;
   record.name = "<core dump>";
-  record.koid = minidump_->ProcessID();
+  record.koid = minidump_->GetProcessID();
 
   debug_ipc::ProcessTreeReply reply {
     .root = record,
@@ -158,22 +386,66 @@ void MinidumpRemoteAPI::ProcessTree(
 void MinidumpRemoteAPI::Threads(
     const debug_ipc::ThreadsRequest& request,
     std::function<void(const Err&, debug_ipc::ThreadsReply)> cb) {
-  // TODO
-  ErrNoImpl(cb);
+  if (!minidump_) {
+    ErrNoDump(cb);
+    return;
+  }
+
+  debug_ipc::ThreadsReply reply;
+  if (request.process_koid == minidump_->GetProcessID())
+    reply.threads = minidump_->GetThreads();
+  Succeed(cb, std::move(reply));
 }
 
 void MinidumpRemoteAPI::ReadMemory(
     const debug_ipc::ReadMemoryRequest& request,
     std::function<void(const Err&, debug_ipc::ReadMemoryReply)> cb) {
-  // TODO
-  ErrNoImpl(cb);
+  if (!minidump_) {
+    ErrNoDump(cb);
+    return;
+  }
+
+  debug_ipc::ReadMemoryReply reply;
+  if (request.process_koid == minidump_->GetProcessID())
+    reply.blocks = minidump_->ReadMemory(request.address, request.size);
+  Succeed(cb, std::move(reply));
 }
 
 void MinidumpRemoteAPI::Registers(
     const debug_ipc::RegistersRequest& request,
     std::function<void(const Err&, debug_ipc::RegistersReply)> cb) {
-  // TODO
-  ErrNoImpl(cb);
+  if (!minidump_) {
+    ErrNoDump(cb);
+    return;
+  }
+
+  debug_ipc::RegistersReply reply;
+  const uint8_t* context = nullptr;
+  uint32_t context_size = 0;
+  if (request.process_koid == minidump_->GetProcessID() &&
+      minidump_->GetThreadContext(request.thread_koid, &context,
+                                  &context_size)) {
+    switch (minidump_->GetProcessorArchitecture()) {
+      case MinidumpFile::kArchitectureAMD64:
+        if (context_size < kX64ContextSize) {
+          Fail(cb, ErrBadContext());
+          return;
+        }
+        reply.categories = DecodeX64Registers(context, request.categories);
+        break;
+      case MinidumpFile::kArchitectureARM64:
+        if (context_size < kArm64ContextSize) {
+          Fail(cb, ErrBadContext());
+          return;
+        }
+        reply.categories = DecodeArm64Registers(context, request.categories);
+        break;
+      default:
+        Fail(cb, ErrNoArch());
+        return;
+    }
+  }
+  Succeed(cb, std::move(reply));
 }
 
 void MinidumpRemoteAPI::AddOrChangeBreakpoint(
@@ -188,11 +460,110 @@ void MinidumpRemoteAPI::RemoveBreakpoint(
   ErrNoLive(cb);
 }
 
+Err MinidumpRemoteAPI::GetBacktrace(
+    uint64_t thread_koid, std::vector<debug_ipc::StackFrame>* frames) {
+  const uint8_t* context = nullptr;
+  uint32_t context_size = 0;
+  if (!minidump_->GetThreadContext(thread_koid, &context, &context_size))
+    return Err();
+
+  debug_ipc::StackFrame frame;
+  switch (minidump_->GetProcessorArchitecture()) {
+    case MinidumpFile::kArchitectureAMD64:
+      if (context_size < kX64ContextSize)
+        return ErrBadContext();
+      memcpy(&frame.ip, &context[kX64ContextRip], sizeof(uint64_t));
+      memcpy(&frame.sp, &context[kX64ContextRax + 4 * sizeof(uint64_t)],
+             sizeof(uint64_t));
+      memcpy(&frame.bp, &context[kX64ContextRax + 5 * sizeof(uint64_t)],
+             sizeof(uint64_t));
+      break;
+    case MinidumpFile::kArchitectureARM64:
+      if (context_size < kArm64ContextSize)
+        return ErrBadContext();
+      memcpy(&frame.ip, &context[kArm64ContextPc], sizeof(uint64_t));
+      memcpy(&frame.sp, &context[kArm64ContextSp], sizeof(uint64_t));
+      memcpy(&frame.bp, &context[kArm64ContextFp], sizeof(uint64_t));
+      break;
+    default:
+      return ErrNoArch();
+  }
+
+  // There's no unwinder on the client side so this follows the frame
+  // pointers through the stack memory saved in the dump.
+  frames->push_back(frame);
+  while (frames->size() < kMaxBacktraceDepth) {
+    // The frame pointer points to the saved caller frame pointer, followed by
+    // the return address. This frame record layout is the same on x64 and
+    // ARM64.
+    uint64_t bp = frame.bp;
+    uint64_t next_bp = 0;
+    uint64_t return_address = 0;
+    if (!ReadUint64(minidump_.get(), bp, &next_bp) ||
+        !ReadUint64(minidump_.get(), bp + sizeof(uint64_t), &return_address))
+      break;
+
+    frame.ip = return_address;
+    frame.sp = bp + 2 * sizeof(uint64_t);
+    frame.bp = next_bp;
+    frames->push_back(frame);
+
+    // The stack grows down so callers' frames must be at higher addresses.
+    if (return_address == 0 || next_bp <= bp)
+      break;
+  }
+  return Err();
+}
+
 void MinidumpRemoteAPI::Backtrace(
     const debug_ipc::BacktraceRequest& request,
     std::function<void(const Err&, debug_ipc::BacktraceReply)> cb) {
-  // TODO
-  ErrNoImpl(cb);
+  if (!minidump_) {
+    ErrNoDump(cb);
+    return;
+  }
+
+  debug_ipc::BacktraceReply reply;
+  if (request.process_koid == minidump_->GetProcessID()) {
+    Err err = GetBacktrace(request.thread_koid, &reply.frames);
+    if (err.has_error()) {
+      Fail(cb, err);
+      return;
+    }
+  }
+  Succeed(cb, std::move(reply));
+}
+
+void MinidumpRemoteAPI::Backtraces(
+    const debug_ipc::BacktracesRequest& request,
+    std::function<void(const Err&, debug_ipc::BacktracesReply)> cb) {
+  if (!minidump_) {
+    ErrNoDump(cb);
+    return;
+  }
+
+  debug_ipc::BacktracesReply reply;
+  if (request.process_koid == minidump_->GetProcessID()) {
+    std::vector<uint64_t> koids = request.thread_koids;
+    if (koids.empty()) {
+      for (const auto& thread : minidump_->GetThreads())
+        koids.push_back(thread.koid);
+    }
+
+    for (uint64_t koid : koids) {
+      debug_ipc::ThreadBacktrace backtrace;
+      backtrace.thread_koid = koid;
+      Err err = GetBacktrace(koid, &backtrace.frames);
+      if (err.has_error()) {
+        Fail(cb, err);
+        return;
+      }
+      // Threads not in the dump are omitted, as with a live agent.
+      if (!backtrace.frames.empty())
+        reply.backtraces.push_back(std::move(backtrace));
+    }
+  }
+  Succeed(cb, std::move(reply));
 }
 
 void MinidumpRemoteAPI::AddressSpace(
@@ -202,4 +573,24 @@ void MinidumpRemoteAPI::AddressSpace(
   ErrNoImpl(cb);
 }
 
+void MinidumpRemoteAPI::ReadMemoryRanges(
+    const debug_ipc::ReadMemoryRangesRequest& request,
+    std::function<void(const Err&, debug_ipc::ReadMemoryRangesReply)> cb) {
+  if (!minidump_) {
+    ErrNoDump(cb);
+    return;
+  }
+
+  debug_ipc::ReadMemoryRangesReply reply;
+  if (request.process_koid == minidump_->GetProcessID()) {
+    for (const auto& range : request.ranges) {
+      std::vector<debug_ipc::MemoryBlock> blocks =
+          minidump_->ReadMemory(range.address, range.size);
+      for (auto& block : blocks)
+        reply.blocks.push_back(std::move(block));
+    }
+  }
+  Succeed(cb, std::move(reply));
+}
+
 }  // namespace zxdb
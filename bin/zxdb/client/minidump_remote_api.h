@@ -6,19 +6,18 @@
 
 #include "garnet/bin/zxdb/client/remote_api.h"
 
+#include <memory>
 #include <string>
 
-namespace crashpad {
-
-class ProcessSnapshotMinidump;
-
-}  // namespace crashpad
-
 namespace zxdb {
 
+class MinidumpFile;
 class Session;
 
 // An implementation of RemoteAPI for Session that accesses a minidump file.
+//
+// Requests are answered directly from the memory-mapped file (see
+// MinidumpFile) so large dumps can be opened without reading them.
 class MinidumpRemoteAPI : public RemoteAPI {
  public:
   MinidumpRemoteAPI();
@@ -78,9 +77,21 @@ class MinidumpRemoteAPI : public RemoteAPI {
       const debug_ipc::AddressSpaceRequest& request,
       std::function<void(const Err&, debug_ipc::AddressSpaceReply)> cb)
       override;
+  void ReadMemoryRanges(
+      const debug_ipc::ReadMemoryRangesRequest& request,
+      std::function<void(const Err&, debug_ipc::ReadMemoryRangesReply)> cb)
+      override;
+  void Backtraces(
+      const debug_ipc::BacktracesRequest& request,
+      std::function<void(const Err&, debug_ipc::BacktracesReply)> cb) override;
 
  private:
-  std::unique_ptr<crashpad::ProcessSnapshotMinidump> minidump_;
+  // Computes the backtrace of the given thread in the dump. Returns an error
+  // if the dump's architecture isn't supported.
+  Err GetBacktrace(uint64_t thread_koid,
+                   std::vector<debug_ipc::StackFrame>* frames);
+
+  std::unique_ptr<MinidumpFile> minidump_;
   FXL_DISALLOW_COPY_AND_ASSIGN(MinidumpRemoteAPI);
 };
 
@@ -2,16 +2,96 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <inttypes.h>
+#include <string.h>
+
 #include <filesystem>
 
+#include "garnet/bin/zxdb/client/minidump_file.h"
 #include "garnet/bin/zxdb/client/remote_api.h"
 #include "garnet/bin/zxdb/client/session.h"
 #include "garnet/bin/zxdb/common/host_util.h"
 #include "garnet/lib/debug_ipc/helper/platform_message_loop.h"
+#include "garnet/lib/debug_ipc/register_desc.h"
+#include "garnet/public/lib/fxl/files/scoped_temp_dir.h"
 #include "gtest/gtest.h"
 
 namespace zxdb {
 
+namespace {
+
+constexpr uint64_t kTestExampleMinidumpKOID = 656254;
+constexpr uint64_t kTestExampleMinidumpThreadKOID = 671806;
+constexpr uint64_t kTestExampleMinidumpStackAddress = 0x37f880947000;
+constexpr uint32_t kTestExampleMinidumpStackSize = 0x40000;
+
+template <typename T>
+void Append(std::string* out, T value) {
+  out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Returns a minimal minidump for the given processor architecture with one
+// process and thread. The thread has the given context, and the dump has one
+// region of memory.
+std::string MakeMinidump(uint16_t arch, uint32_t process_id,
+                         uint32_t thread_id, const std::string& context,
+                         uint64_t memory_address, const std::string& memory) {
+  // Stream offsets. The header and the stream directory come first.
+  constexpr uint32_t kStreamCount = 4;
+  constexpr uint32_t kSystemInfo = 32 + kStreamCount * 12;
+  constexpr uint32_t kSystemInfoSize = 56;
+  constexpr uint32_t kMiscInfo = kSystemInfo + kSystemInfoSize;
+  constexpr uint32_t kMiscInfoSize = 24;
+  constexpr uint32_t kThreadList = kMiscInfo + kMiscInfoSize;
+  constexpr uint32_t kThreadListSize = 4 + 48;
+  constexpr uint32_t kMemoryList = kThreadList + kThreadListSize;
+  constexpr uint32_t kMemoryListSize = 4 + 16;
+  constexpr uint32_t kContext = kMemoryList + kMemoryListSize;
+  const uint32_t memory_offset = kContext + context.size();
+
+  std::string dump;
+  Append<uint32_t>(&dump, 0x504d444d);  // "MDMP"
+  Append<uint32_t>(&dump, 0xa793);
+  Append<uint32_t>(&dump, kStreamCount);
+  Append<uint32_t>(&dump, 32);  // Directory offset.
+  Append<uint32_t>(&dump, 0);
+  Append<uint32_t>(&dump, 0);
+  Append<uint64_t>(&dump, 0);
+
+  // Stream type, size, and offset.
+  const uint32_t directory[] = {7,  kSystemInfoSize, kSystemInfo,
+                                15, kMiscInfoSize,   kMiscInfo,
+                                3,  kThreadListSize, kThreadList,
+                                5,  kMemoryListSize, kMemoryList};
+  for (uint32_t value : directory)
+    Append<uint32_t>(&dump, value);
+
+  Append<uint16_t>(&dump, arch);
+  dump.resize(kMiscInfo);
+
+  Append<uint32_t>(&dump, kMiscInfoSize);
+  Append<uint32_t>(&dump, 1);  // Process ID valid.
+  Append<uint32_t>(&dump, process_id);
+  dump.resize(kThreadList);
+
+  Append<uint32_t>(&dump, 1);
+  Append<uint32_t>(&dump, thread_id);
+  dump.resize(kThreadList + 4 + 40);  // Skip to the context location.
+  Append<uint32_t>(&dump, context.size());
+  Append<uint32_t>(&dump, kContext);
+
+  Append<uint32_t>(&dump, 1);
+  Append<uint64_t>(&dump, memory_address);
+  Append<uint32_t>(&dump, memory.size());
+  Append<uint32_t>(&dump, memory_offset);
+
+  dump.append(context);
+  dump.append(memory);
+  return dump;
+}
+
+}  // namespace
+
 class MinidumpTest : public testing::Test {
  public:
   MinidumpTest();
@@ -21,6 +101,14 @@ class MinidumpTest : public testing::Test {
   Session& session() { return *session_; }
 
   Err TryOpen(const std::string& filename);
+  Err TryOpenPath(const std::string& path);
+
+  // Issues a request to the minidump's RemoteAPI and waits for the reply.
+  template <typename RequestType, typename ReplyType>
+  void DoRequest(RequestType request, ReplyType& reply, Err& err,
+                 void (RemoteAPI::*handler)(
+                     const RequestType&,
+                     std::function<void(const Err&, ReplyType)>));
 
  private:
   debug_ipc::PlatformMessageLoop loop_;
@@ -38,9 +126,11 @@ Err MinidumpTest::TryOpen(const std::string& filename) {
   static auto data_dir = std::filesystem::path(GetSelfPath())
     .parent_path().parent_path() / "test_data" / "zxdb";
 
-  Err err;
-  auto path = (data_dir / filename).string();
+  return TryOpenPath((data_dir / filename).string());
+}
 
+Err MinidumpTest::TryOpenPath(const std::string& path) {
+  Err err;
   session().OpenMinidump(path,
                          [&err](const Err& got) {
                            err = got;
@@ -52,6 +142,20 @@ Err MinidumpTest::TryOpen(const std::string& filename) {
   return err;
 }
 
+template <typename RequestType, typename ReplyType>
+void MinidumpTest::DoRequest(
+    RequestType request, ReplyType& reply, Err& err,
+    void (RemoteAPI::*handler)(const RequestType&,
+                               std::function<void(const Err&, ReplyType)>)) {
+  (session().remote_api()->*handler)(
+      request, [&reply, &err](const Err& e, ReplyType r) {
+        err = e;
+        reply = r;
+        debug_ipc::MessageLoop::Current()->QuitNow();
+      });
+  loop().Run();
+}
+
 TEST_F(MinidumpTest, Load) {
   Err err = TryOpen("test_example_minidump.dmp");
   EXPECT_FALSE(err.has_error()) << err.msg();
@@ -78,4 +182,309 @@ TEST_F(MinidumpTest, ProcessTreeRecord) {
   EXPECT_EQ(656254UL, record.koid);
 }
 
+TEST_F(MinidumpTest, Threads) {
+  Err err = TryOpen("test_example_minidump.dmp");
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  debug_ipc::ThreadsRequest request;
+  request.process_koid = kTestExampleMinidumpKOID;
+  debug_ipc::ThreadsReply reply;
+  DoRequest(request, reply, err, &RemoteAPI::Threads);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  ASSERT_EQ(1u, reply.threads.size());
+  EXPECT_EQ(kTestExampleMinidumpThreadKOID, reply.threads[0].koid);
+  EXPECT_EQ(debug_ipc::ThreadRecord::State::kSuspended,
+            reply.threads[0].state);
+
+  // Other processes have no threads.
+  request.process_koid = 1;
+  DoRequest(request, reply, err, &RemoteAPI::Threads);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+  EXPECT_TRUE(reply.threads.empty());
+}
+
+TEST_F(MinidumpTest, Modules) {
+  Err err = TryOpen("test_example_minidump.dmp");
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  debug_ipc::ModulesRequest request;
+  request.process_koid = kTestExampleMinidumpKOID;
+  debug_ipc::ModulesReply reply;
+  DoRequest(request, reply, err, &RemoteAPI::Modules);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  ASSERT_EQ(17u, reply.modules.size());
+  EXPECT_EQ("scenic", reply.modules[0].name);
+  EXPECT_EQ(0x5283b9a60000u, reply.modules[0].base);
+  EXPECT_EQ(32u, reply.modules[0].build_id.size());
+  EXPECT_EQ("libframebuffer.so", reply.modules[16].name);
+  EXPECT_EQ(0x5fa025a5b000u, reply.modules[16].base);
+}
+
+TEST_F(MinidumpTest, ReadMemory) {
+  Err err = TryOpen("test_example_minidump.dmp");
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  // Read straddling the end of the stack, the only memory in the dump.
+  constexpr uint64_t kStackEnd =
+      kTestExampleMinidumpStackAddress + kTestExampleMinidumpStackSize;
+  debug_ipc::ReadMemoryRequest request;
+  request.process_koid = kTestExampleMinidumpKOID;
+  request.address = kStackEnd - 16;
+  request.size = 32;
+  debug_ipc::ReadMemoryReply reply;
+  DoRequest(request, reply, err, &RemoteAPI::ReadMemory);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  ASSERT_EQ(2u, reply.blocks.size());
+  EXPECT_EQ(kStackEnd - 16, reply.blocks[0].address);
+  EXPECT_TRUE(reply.blocks[0].valid);
+  EXPECT_EQ(16u, reply.blocks[0].size);
+  EXPECT_EQ(16u, reply.blocks[0].data.size());
+  EXPECT_EQ(kStackEnd, reply.blocks[1].address);
+  EXPECT_FALSE(reply.blocks[1].valid);
+  EXPECT_EQ(16u, reply.blocks[1].size);
+  EXPECT_TRUE(reply.blocks[1].data.empty());
+}
+
+TEST_F(MinidumpTest, Registers) {
+  Err err = TryOpen("test_example_minidump.dmp");
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  debug_ipc::RegistersRequest request;
+  request.process_koid = kTestExampleMinidumpKOID;
+  request.thread_koid = kTestExampleMinidumpThreadKOID;
+  request.categories.push_back(debug_ipc::RegisterCategory::Type::kGeneral);
+  request.categories.push_back(debug_ipc::RegisterCategory::Type::kVector);
+  debug_ipc::RegistersReply reply;
+  DoRequest(request, reply, err, &RemoteAPI::Registers);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  ASSERT_EQ(2u, reply.categories.size());
+  EXPECT_EQ(debug_ipc::RegisterCategory::Type::kGeneral,
+            reply.categories[0].type);
+  EXPECT_EQ(18u, reply.categories[0].registers.size());
+  EXPECT_EQ(debug_ipc::RegisterCategory::Type::kVector,
+            reply.categories[1].type);
+  EXPECT_EQ(17u, reply.categories[1].registers.size());
+
+  uint64_t rip = 0;
+  uint64_t rsp = 0;
+  for (const auto& reg : reply.categories[0].registers) {
+    ASSERT_EQ(8u, reg.data.size());
+    if (reg.id == debug_ipc::RegisterID::kX64_rip)
+      memcpy(&rip, &reg.data[0], sizeof(rip));
+    else if (reg.id == debug_ipc::RegisterID::kX64_rsp)
+      memcpy(&rsp, &reg.data[0], sizeof(rsp));
+  }
+  EXPECT_EQ(0x4dc6479a5b1eu, rip);
+  EXPECT_EQ(0x37f880986d48u, rsp);
+}
+
+TEST_F(MinidumpTest, Backtrace) {
+  Err err = TryOpen("test_example_minidump.dmp");
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  debug_ipc::BacktraceRequest request;
+  request.process_koid = kTestExampleMinidumpKOID;
+  request.thread_koid = kTestExampleMinidumpThreadKOID;
+  debug_ipc::BacktraceReply reply;
+  DoRequest(request, reply, err, &RemoteAPI::Backtrace);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  // The first frame is from the registers, the rest from following the frame
+  // pointers through the stack.
+  ASSERT_EQ(9u, reply.frames.size());
+  EXPECT_EQ(0x4dc6479a5b1eu, reply.frames[0].ip);
+  EXPECT_EQ(0x37f880986d48u, reply.frames[0].sp);
+  EXPECT_EQ(0x37f880986d70u, reply.frames[0].bp);
+  EXPECT_EQ(0x5283b9b937abu, reply.frames[1].ip);
+  EXPECT_EQ(0x37f880986d80u, reply.frames[1].sp);
+  EXPECT_EQ(0x37f880986d90u, reply.frames[1].bp);
+}
+
+TEST_F(MinidumpTest, Backtraces) {
+  Err err = TryOpen("test_example_minidump.dmp");
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  // An empty thread list requests all threads.
+  debug_ipc::BacktracesRequest request;
+  request.process_koid = kTestExampleMinidumpKOID;
+  debug_ipc::BacktracesReply reply;
+  DoRequest(request, reply, err, &RemoteAPI::Backtraces);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  ASSERT_EQ(1u, reply.backtraces.size());
+  EXPECT_EQ(kTestExampleMinidumpThreadKOID, reply.backtraces[0].thread_koid);
+  ASSERT_EQ(9u, reply.backtraces[0].frames.size());
+  EXPECT_EQ(0x4dc6479a5b1eu, reply.backtraces[0].frames[0].ip);
+
+  // Threads that aren't in the dump are omitted.
+  request.thread_koids.push_back(kTestExampleMinidumpThreadKOID + 1);
+  DoRequest(request, reply, err, &RemoteAPI::Backtraces);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+  EXPECT_TRUE(reply.backtraces.empty());
+}
+
+TEST_F(MinidumpTest, Arm64) {
+  constexpr uint32_t kProcessID = 1234;
+  constexpr uint32_t kThreadID = 5678;
+  constexpr uint64_t kStack = 0x7000;
+  constexpr uint64_t kPC = 0x1234;
+
+  // MINIDUMP_CONTEXT_ARM64. Each general register holds its number.
+  std::string context(912, '\0');
+  auto set_u64 = [&context](uint32_t offset, uint64_t value) {
+    memcpy(&context[offset], &value, sizeof(value));
+  };
+  for (uint32_t i = 0; i < 29; i++)
+    set_u64(8 + i * 8, i);
+  set_u64(240, kStack + 0x10);  // FP.
+  set_u64(248, 0x2000);         // LR.
+  set_u64(256, kStack);         // SP.
+  set_u64(264, kPC);
+  uint32_t cpsr = 0x60000000;
+  memcpy(&context[4], &cpsr, sizeof(cpsr));
+  context[272 + 16 + 15] = 0x55;  // Last byte of V1.
+  uint32_t fpcr = 0x3000000;
+  memcpy(&context[784], &fpcr, sizeof(fpcr));
+
+  // Two frame records on the stack: (fp, return address) pairs.
+  std::string stack(0x40, '\0');
+  uint64_t records[] = {kStack + 0x20, 0x2000, 0, 0x3000};
+  memcpy(&stack[0x10], records, sizeof(records));
+
+  files::ScopedTempDir temp_dir;
+  std::string path;
+  ASSERT_TRUE(temp_dir.NewTempFileWithData(
+      MakeMinidump(MinidumpFile::kArchitectureARM64, kProcessID, kThreadID,
+                   context, kStack, stack),
+      &path));
+  Err err = TryOpenPath(path);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  debug_ipc::RegistersRequest request;
+  request.process_koid = kProcessID;
+  request.thread_koid = kThreadID;
+  request.categories.push_back(debug_ipc::RegisterCategory::Type::kGeneral);
+  request.categories.push_back(
+      debug_ipc::RegisterCategory::Type::kFloatingPoint);
+  request.categories.push_back(debug_ipc::RegisterCategory::Type::kVector);
+  request.categories.push_back(debug_ipc::RegisterCategory::Type::kDebug);
+  debug_ipc::RegistersReply reply;
+  DoRequest(request, reply, err, &RemoteAPI::Registers);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+
+  // The same registers the debug agent reports for ARM64.
+  ASSERT_EQ(3u, reply.categories.size());
+  const auto& general = reply.categories[0].registers;
+  ASSERT_EQ(34u, general.size());
+  for (const auto& reg : general) {
+    ASSERT_EQ(8u, reg.data.size());
+    uint64_t value = 0;
+    memcpy(&value, &reg.data[0], sizeof(value));
+    auto index = static_cast<uint32_t>(reg.id) -
+                 static_cast<uint32_t>(debug_ipc::RegisterID::kARMv8_x0);
+    if (index < 29) {
+      EXPECT_EQ(index, value);
+    } else if (reg.id == debug_ipc::RegisterID::kARMv8_x29) {
+      EXPECT_EQ(kStack + 0x10, value);
+    } else if (reg.id == debug_ipc::RegisterID::kARMv8_pc) {
+      EXPECT_EQ(kPC, value);
+    } else if (reg.id == debug_ipc::RegisterID::kARMv8_cpsr) {
+      EXPECT_EQ(cpsr, value);
+    }
+  }
+  EXPECT_EQ(debug_ipc::RegisterCategory::Type::kFloatingPoint,
+            reply.categories[1].type);
+  EXPECT_TRUE(reply.categories[1].registers.empty());
+  const auto& vector = reply.categories[2].registers;
+  ASSERT_EQ(34u, vector.size());
+  EXPECT_EQ(debug_ipc::RegisterID::kARMv8_fpcr, vector[0].id);
+  EXPECT_EQ(fpcr, *reinterpret_cast<const uint32_t*>(&vector[0].data[0]));
+  EXPECT_EQ(debug_ipc::RegisterID::kARMv8_v1, vector[3].id);
+  ASSERT_EQ(16u, vector[3].data.size());
+  EXPECT_EQ(0x55, vector[3].data[15]);
+
+  // The backtrace follows the frame records.
+  debug_ipc::BacktraceRequest backtrace_request;
+  backtrace_request.process_koid = kProcessID;
+  backtrace_request.thread_koid = kThreadID;
+  debug_ipc::BacktraceReply backtrace_reply;
+  DoRequest(backtrace_request, backtrace_reply, err, &RemoteAPI::Backtrace);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+  ASSERT_EQ(3u, backtrace_reply.frames.size());
+  EXPECT_EQ(kPC, backtrace_reply.frames[0].ip);
+  EXPECT_EQ(kStack, backtrace_reply.frames[0].sp);
+  EXPECT_EQ(0x2000u, backtrace_reply.frames[1].ip);
+  EXPECT_EQ(kStack + 0x20, backtrace_reply.frames[1].sp);
+  EXPECT_EQ(0x3000u, backtrace_reply.frames[2].ip);
+}
+
+TEST_F(MinidumpTest, UnsupportedArchitecture) {
+  constexpr uint16_t kArchitectureX86 = 0;
+
+  files::ScopedTempDir temp_dir;
+  std::string path;
+  ASSERT_TRUE(temp_dir.NewTempFileWithData(
+      MakeMinidump(kArchitectureX86, 1, 2, std::string(716, '\0'), 0x1000,
+                   std::string(16, '\0')),
+      &path));
+  Err err = TryOpenPath(path);
+  ASSERT_TRUE(err.has_error());
+  EXPECT_NE(std::string::npos, err.msg().find("unsupported processor"))
+      << err.msg();
+}
+
+// Enable and substitute the path to a large dump (and one of its threads) to
+// measure the time from opening the dump to getting the first backtrace.
+#if 0
+static int64_t GetTickMicroseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  constexpr int64_t kMicrosecondsPerSecond = 1000000;
+  constexpr int64_t kNanosecondsPerMicrosecond = 1000;
+
+  int64_t result = ts.tv_sec * kMicrosecondsPerSecond;
+  result += (ts.tv_nsec / kNanosecondsPerMicrosecond);
+  return result;
+}
+
+TEST_F(MinidumpTest, BenchmarkOpenToBacktrace) {
+  const char kFilename[] = "/tmp/large.dmp";
+
+  int64_t begin_us = GetTickMicroseconds();
+  Err err;
+  session().OpenMinidump(kFilename, [&err](const Err& got) {
+    err = got;
+    debug_ipc::MessageLoop::Current()->QuitNow();
+  });
+  loop().Run();
+  ASSERT_FALSE(err.has_error()) << err.msg();
+  int64_t open_us = GetTickMicroseconds();
+
+  debug_ipc::ProcessTreeReply tree;
+  DoRequest(debug_ipc::ProcessTreeRequest(), tree, err,
+            &RemoteAPI::ProcessTree);
+  debug_ipc::ThreadsRequest threads_request;
+  threads_request.process_koid = tree.root.koid;
+  debug_ipc::ThreadsReply threads;
+  DoRequest(threads_request, threads, err, &RemoteAPI::Threads);
+  ASSERT_FALSE(threads.threads.empty());
+
+  debug_ipc::BacktraceRequest backtrace_request;
+  backtrace_request.process_koid = tree.root.koid;
+  backtrace_request.thread_koid = threads.threads[0].koid;
+  debug_ipc::BacktraceReply backtrace;
+  DoRequest(backtrace_request, backtrace, err, &RemoteAPI::Backtrace);
+  ASSERT_FALSE(err.has_error()) << err.msg();
+  int64_t backtrace_us = GetTickMicroseconds();
+
+  printf("Open: %" PRId64 "us, first backtrace (%zu frames): %" PRId64 "us\n",
+         open_us - begin_us, backtrace.frames.size(), backtrace_us - begin_us);
+}
+#endif
+
 }  // namespace zxdb
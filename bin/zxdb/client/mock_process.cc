@@ -51,6 +51,12 @@ void MockProcess::SyncThreads(std::function<void()> cb) {
   MessageLoop::Current()->PostTask([cb]() { cb(); });
 }
 
+void MockProcess::SyncAllThreadFrames(
+    std::function<void(Thread*)> thread_callback,
+    std::function<void(const Err&)> done) {
+  MessageLoop::Current()->PostTask([done]() { done(Err()); });
+}
+
 void MockProcess::Pause() {}
 
 void MockProcess::Continue() {}
@@ -65,4 +71,7 @@ void MockProcess::ReadMemory(uint64_t address, uint32_t size,
   MessageLoop::Current()->PostTask([cb]() { cb(Err(), MemoryDump()); });
 }
 
+void MockProcess::PrefetchMemory(
+    const std::vector<debug_ipc::MemoryRange>& ranges) {}
+
 }  // namespace zxdb
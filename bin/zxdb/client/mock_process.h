@@ -29,6 +29,8 @@ class MockProcess : public Process {
   std::vector<Thread*> GetThreads() const override;
   Thread* GetThreadFromKoid(uint64_t koid) override;
   void SyncThreads(std::function<void()> callback) override;
+  void SyncAllThreadFrames(std::function<void(Thread*)> thread_callback,
+                           std::function<void(const Err&)> done) override;
   void Pause() override;
   void Continue() override;
   void ContinueUntil(const InputLocation& location,
@@ -36,6 +38,8 @@ class MockProcess : public Process {
   void ReadMemory(
       uint64_t address, uint32_t size,
       std::function<void(const Err&, MemoryDump)> callback) override;
+  void PrefetchMemory(
+      const std::vector<debug_ipc::MemoryRange>& ranges) override;
 
  private:
   FXL_DISALLOW_COPY_AND_ASSIGN(MockProcess);
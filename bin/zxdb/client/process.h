@@ -17,6 +17,7 @@
 
 namespace debug_ipc {
 struct MemoryBlock;
+struct MemoryRange;
 struct Module;
 struct ThreadRecord;
 struct AddressRegion;
@@ -93,6 +94,23 @@ class Process : public ClientObject {
   // To get the computed threads, call GetThreads() once the callback runs.
   virtual void SyncThreads(std::function<void()> callback) = 0;
 
+  // Asynchronously retrieves the complete backtraces of all threads in the
+  // process in one request and symbolizes them. This is much faster than
+  // calling Thread::SyncFrames() for each thread when there are many.
+  //
+  // The frames are symbolized in batches of threads, returning to the
+  // message loop in between. The thread callback is issued for each thread
+  // as its frames become available so results can be shown progressively,
+  // and the done callback is issued after the last one. If the request
+  // fails, the done callback is issued with the error and no thread
+  // callbacks are issued.
+  //
+  // As with SyncThreads(), if the Process is destroyed before the call
+  // completes, the remaining callbacks will not be issued.
+  virtual void SyncAllThreadFrames(
+      std::function<void(Thread*)> thread_callback,
+      std::function<void(const Err&)> done) = 0;
+
   // Applies to all threads in the process.
   virtual void Pause() = 0;
   virtual void Continue() = 0;
@@ -103,11 +121,18 @@ class Process : public ClientObject {
   virtual void ContinueUntil(const InputLocation& location,
                              std::function<void(const Err&)> cb) = 0;
 
-  // Reads memory from the debugged process.
+  // Reads memory from the debugged process. While the process is stopped,
+  // memory is cached so repeated reads of the same area are cheap.
   virtual void ReadMemory(
       uint64_t address, uint32_t size,
       std::function<void(const Err&, MemoryDump)> callback) = 0;
 
+  // Hints that the given ranges are about to be read. When the process is
+  // stopped, they will be fetched in one request and subsequent ReadMemory()
+  // calls for them will be satisfied from the result.
+  virtual void PrefetchMemory(
+      const std::vector<debug_ipc::MemoryRange>& ranges) = 0;
+
  protected:
   fxl::ObserverList<ProcessObserver>& observers() { return observers_; }
 
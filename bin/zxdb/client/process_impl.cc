@@ -4,6 +4,7 @@
 
 #include "garnet/bin/zxdb/client/process_impl.h"
 
+#include <algorithm>
 #include <set>
 
 #include "garnet/bin/zxdb/client/memory_dump.h"
@@ -12,10 +13,34 @@
 #include "garnet/bin/zxdb/client/target_impl.h"
 #include "garnet/bin/zxdb/client/thread_impl.h"
 #include "garnet/bin/zxdb/symbols/input_location.h"
+#include "garnet/lib/debug_ipc/helper/message_loop.h"
 #include "garnet/public/lib/fxl/logging.h"
 
 namespace zxdb {
 
+namespace {
+
+// Number of threads whose frames SyncAllThreadFrames() symbolizes before
+// returning to the message loop.
+constexpr size_t kThreadFramesBatchSize = 16;
+
+}  // namespace
+
+struct ProcessImpl::ThreadFramesState {
+  std::vector<debug_ipc::ThreadBacktrace> backtraces;
+
+  // Index into backtraces of the next thread to save.
+  size_t next_index = 0;
+
+  // Locations of all addresses symbolized so far. Threads often share many
+  // frames (for example, worker threads waiting in the same place), and these
+  // only need to be symbolized once.
+  std::map<uint64_t, Location> locations;
+
+  std::function<void(Thread*)> thread_callback;
+  std::function<void(const Err&)> done;
+};
+
 ProcessImpl::ProcessImpl(TargetImpl* target, uint64_t koid,
                          const std::string& name)
     : Process(target->session()),
@@ -23,6 +48,18 @@ ProcessImpl::ProcessImpl(TargetImpl* target, uint64_t koid,
       koid_(koid),
       name_(name),
       symbols_(this, target->symbols()),
+      memory_cache_([this](std::vector<debug_ipc::MemoryRange> ranges,
+                           MemoryCache::FetchReplyCallback cb) {
+        debug_ipc::ReadMemoryRangesRequest request;
+        request.process_koid = koid_;
+        request.ranges = std::move(ranges);
+        session()->remote_api()->ReadMemoryRanges(
+            request, [cb = std::move(cb)](
+                         const Err& err,
+                         debug_ipc::ReadMemoryRangesReply reply) {
+              cb(err, std::move(reply.blocks));
+            });
+      }),
       weak_factory_(this) {}
 
 ProcessImpl::~ProcessImpl() {
@@ -102,6 +139,29 @@ void ProcessImpl::SyncThreads(std::function<void()> callback) {
       });
 }
 
+void ProcessImpl::SyncAllThreadFrames(
+    std::function<void(Thread*)> thread_callback,
+    std::function<void(const Err&)> done) {
+  debug_ipc::BacktracesRequest request;
+  request.process_koid = koid_;
+  session()->remote_api()->Backtraces(
+      request, [ thread_callback, done, process = weak_factory_.GetWeakPtr() ](
+                   const Err& err, debug_ipc::BacktracesReply reply) {
+        if (!process)
+          return;
+        if (err.has_error()) {
+          if (done)
+            done(err);
+          return;
+        }
+        auto state = std::make_shared<ThreadFramesState>();
+        state->backtraces = std::move(reply.backtraces);
+        state->thread_callback = std::move(thread_callback);
+        state->done = std::move(done);
+        process->SaveNextThreadFrames(std::move(state));
+      });
+}
+
 void ProcessImpl::Pause() {
   debug_ipc::PauseRequest request;
   request.process_koid = koid_;
@@ -110,6 +170,8 @@ void ProcessImpl::Pause() {
 }
 
 void ProcessImpl::Continue() {
+  WillResumeThreads({});
+
   debug_ipc::ResumeRequest request;
   request.process_koid = koid_;
   request.how = debug_ipc::ResumeRequest::How::kContinue;
@@ -127,6 +189,14 @@ void ProcessImpl::ContinueUntil(const InputLocation& location,
 void ProcessImpl::ReadMemory(
     uint64_t address, uint32_t size,
     std::function<void(const Err&, MemoryDump)> callback) {
+  if (CanCacheMemory()) {
+    memory_cache_.ReadMemory(address, size, std::move(callback));
+    return;
+  }
+
+  // Some threads may be running so anything cached may be out-of-date.
+  memory_cache_.Invalidate();
+
   debug_ipc::ReadMemoryRequest request;
   request.process_koid = koid_;
   request.address = address;
@@ -137,6 +207,33 @@ void ProcessImpl::ReadMemory(
       });
 }
 
+void ProcessImpl::PrefetchMemory(
+    const std::vector<debug_ipc::MemoryRange>& ranges) {
+  if (CanCacheMemory())
+    memory_cache_.Prefetch(ranges);
+}
+
+void ProcessImpl::WillResumeThreads(const std::vector<uint64_t>& thread_koids) {
+  memory_cache_.Invalidate();
+  if (thread_koids.empty()) {
+    for (const auto& pair : threads_)
+      resumed_thread_koids_.insert(pair.first);
+    exception_thread_koids_.clear();
+  } else {
+    resumed_thread_koids_.insert(thread_koids.begin(), thread_koids.end());
+    for (uint64_t koid : thread_koids)
+      exception_thread_koids_.erase(koid);
+  }
+}
+
+void ProcessImpl::DidStopThreadInException(uint64_t thread_koid) {
+  // Even if the client didn't resume this thread, it may have run since the
+  // memory was cached.
+  resumed_thread_koids_.erase(thread_koid);
+  exception_thread_koids_.insert(thread_koid);
+  memory_cache_.Invalidate();
+}
+
 void ProcessImpl::OnThreadStarting(const debug_ipc::ThreadRecord& record) {
   if (threads_.find(record.koid) != threads_.end()) {
     // Duplicate new thread notification. Some legitimate cases could cause
@@ -145,6 +242,9 @@ void ProcessImpl::OnThreadStarting(const debug_ipc::ThreadRecord& record) {
     return;
   }
 
+  // Threads only come and go while the process is running.
+  memory_cache_.Invalidate();
+
   auto thread = std::make_unique<ThreadImpl>(this, record);
   Thread* thread_ptr = thread.get();
   threads_[record.koid] = std::move(thread);
@@ -165,6 +265,9 @@ void ProcessImpl::OnThreadExiting(const debug_ipc::ThreadRecord& record) {
     observer.WillDestroyThread(this, found->second.get());
 
   threads_.erase(found);
+  resumed_thread_koids_.erase(record.koid);
+  exception_thread_koids_.erase(record.koid);
+  memory_cache_.Invalidate();
 }
 
 void ProcessImpl::OnModules(const std::vector<debug_ipc::Module>& modules,
@@ -179,11 +282,60 @@ void ProcessImpl::OnModules(const std::vector<debug_ipc::Module>& modules,
     request.process_koid = koid_;
     request.how = debug_ipc::ResumeRequest::How::kContinue;
     request.thread_koids = stopped_thread_koids;
+    WillResumeThreads(stopped_thread_koids);
     session()->remote_api()->Resume(
         request, [](const Err& err, debug_ipc::ResumeReply) {});
   }
 }
 
+void ProcessImpl::SaveNextThreadFrames(
+    std::shared_ptr<ThreadFramesState> state) {
+  size_t end = std::min(state->next_index + kThreadFramesBatchSize,
+                        state->backtraces.size());
+
+  // Symbolize the new addresses of the whole batch together so addresses in
+  // the same module and compilation unit can share work.
+  std::vector<uint64_t> addresses;
+  for (size_t i = state->next_index; i < end; i++) {
+    for (const auto& frame : state->backtraces[i].frames) {
+      if (state->locations.emplace(frame.ip, Location()).second)
+        addresses.push_back(frame.ip);
+    }
+  }
+  std::vector<Location> resolved = symbols_.ResolveAddresses(addresses);
+  for (size_t i = 0; i < addresses.size(); i++)
+    state->locations[addresses[i]] = std::move(resolved[i]);
+
+  for (size_t i = state->next_index; i < end; i++) {
+    const debug_ipc::ThreadBacktrace& backtrace = state->backtraces[i];
+    ThreadImpl* thread = GetThreadImplFromKoid(backtrace.thread_koid);
+    if (!thread)
+      continue;  // Thread not known to the client (yet).
+
+    std::vector<Location> locations;
+    locations.reserve(backtrace.frames.size());
+    for (const auto& frame : backtrace.frames)
+      locations.push_back(state->locations[frame.ip]);
+    thread->SetAllFrames(backtrace.frames, std::move(locations));
+
+    if (state->thread_callback)
+      state->thread_callback(thread);
+  }
+  state->next_index = end;
+
+  if (state->next_index == state->backtraces.size()) {
+    if (state->done)
+      state->done(Err());
+    return;
+  }
+
+  debug_ipc::MessageLoop::Current()->PostTask(
+      [ state, process = weak_factory_.GetWeakPtr() ]() {
+        if (process)
+          process->SaveNextThreadFrames(state);
+      });
+}
+
 void ProcessImpl::UpdateThreads(
     const std::vector<debug_ipc::ThreadRecord>& new_threads) {
   // Go through all new threads, checking to added ones and updating existing.
@@ -196,7 +348,21 @@ void ProcessImpl::UpdateThreads(
       OnThreadStarting(record);
     } else {
       // Existing one, update everything.
+      debug_ipc::ThreadRecord::State old_state =
+          found_existing->second->GetState();
       found_existing->second->SetMetadata(record);
+
+      if (record.state == debug_ipc::ThreadRecord::State::kSuspended) {
+        // A resumed thread that is now suspended may have run since the
+        // memory was cached.
+        if (resumed_thread_koids_.erase(record.koid))
+          memory_cache_.Invalidate();
+      } else if (record.state != old_state) {
+        // Any other change means the thread isn't being held by the debugger
+        // (anymore) and may have written to memory.
+        exception_thread_koids_.erase(record.koid);
+        memory_cache_.Invalidate();
+      }
     }
   }
 
@@ -214,6 +380,24 @@ void ProcessImpl::UpdateThreads(
   }
 }
 
+bool ProcessImpl::CanCacheMemory() const {
+  if (threads_.empty() || !resumed_thread_koids_.empty())
+    return false;
+  for (const auto& pair : threads_) {
+    // Threads blocked for any reason other than an exception the debugger is
+    // handling (say, waiting in a syscall) can wake up and write to memory at
+    // any time.
+    debug_ipc::ThreadRecord::State state = pair.second->GetState();
+    if (state == debug_ipc::ThreadRecord::State::kSuspended)
+      continue;
+    if (state == debug_ipc::ThreadRecord::State::kBlocked &&
+        exception_thread_koids_.count(pair.first))
+      continue;
+    return false;
+  }
+  return true;
+}
+
 void ProcessImpl::DidLoadModuleSymbols(LoadedModuleSymbols* module) {
   for (auto& observer : observers())
     observer.DidLoadModuleSymbols(this, module);
@@ -8,7 +8,9 @@
 
 #include <map>
 #include <memory>
+#include <set>
 
+#include "garnet/bin/zxdb/client/memory_cache.h"
 #include "garnet/bin/zxdb/symbols/process_symbols_impl.h"
 #include "garnet/public/lib/fxl/macros.h"
 #include "garnet/public/lib/fxl/memory/weak_ptr.h"
@@ -41,6 +43,8 @@ class ProcessImpl : public Process, public ProcessSymbolsImpl::Notifications {
   std::vector<Thread*> GetThreads() const override;
   Thread* GetThreadFromKoid(uint64_t koid) override;
   void SyncThreads(std::function<void()> callback) override;
+  void SyncAllThreadFrames(std::function<void(Thread*)> thread_callback,
+                           std::function<void(const Err&)> done) override;
   void Pause() override;
   void Continue() override;
   void ContinueUntil(const InputLocation& location,
@@ -48,6 +52,17 @@ class ProcessImpl : public Process, public ProcessSymbolsImpl::Notifications {
   void ReadMemory(
       uint64_t address, uint32_t size,
       std::function<void(const Err&, MemoryDump)> callback) override;
+  void PrefetchMemory(
+      const std::vector<debug_ipc::MemoryRange>& ranges) override;
+
+  // Called before a request to resume the given threads is sent (an empty
+  // list means all threads). Any cached memory is discarded and the cache
+  // won't be used again until the threads are known to be stopped.
+  void WillResumeThreads(const std::vector<uint64_t>& thread_koids);
+
+  // Called when the given thread has stopped in an exception. It will be
+  // held there until it is resumed.
+  void DidStopThreadInException(uint64_t thread_koid);
 
   // Notifications from the agent that a thread has started or exited.
   void OnThreadStarting(const debug_ipc::ThreadRecord& record);
@@ -58,9 +73,20 @@ class ProcessImpl : public Process, public ProcessSymbolsImpl::Notifications {
                  const std::vector<uint64_t>& stopped_thread_koids);
 
  private:
+  // State for an in-progress SyncAllThreadFrames() call.
+  struct ThreadFramesState;
+
+  // Symbolizes and saves the frames of the next batch of threads for
+  // SyncAllThreadFrames(), then schedules the next batch.
+  void SaveNextThreadFrames(std::shared_ptr<ThreadFramesState> state);
+
   // Syncs the threads_ list to the new list of threads passed in .
   void UpdateThreads(const std::vector<debug_ipc::ThreadRecord>& new_threads);
 
+  // Returns true if the memory cache can be used. This requires that all
+  // threads be suspended by the debugger or stopped in an exception.
+  bool CanCacheMemory() const;
+
   // ProcessSymbolsImpl::Notifications implementation:
   void DidLoadModuleSymbols(LoadedModuleSymbols* module) override;
   void WillUnloadModuleSymbols(LoadedModuleSymbols* module) override;
@@ -75,6 +101,18 @@ class ProcessImpl : public Process, public ProcessSymbolsImpl::Notifications {
 
   ProcessSymbolsImpl symbols_;
 
+  MemoryCache memory_cache_;
+
+  // Threads that the client has asked to resume and that haven't been
+  // reported as stopped since. The thread states in threads_ aren't updated
+  // when a resume is requested so they can't be used for this.
+  std::set<uint64_t> resumed_thread_koids_;
+
+  // Threads that stopped in an exception and haven't been resumed since. The
+  // thread state for these is "blocked" which doesn't distinguish them from
+  // threads blocked in a syscall.
+  std::set<uint64_t> exception_thread_koids_;
+
   fxl::WeakPtrFactory<ProcessImpl> weak_factory_;
 
   FXL_DISALLOW_COPY_AND_ASSIGN(ProcessImpl);
@@ -3,8 +3,11 @@
 // found in the LICENSE file.
 
 #include "garnet/bin/zxdb/client/process_impl.h"
+#include "garnet/bin/zxdb/client/frame.h"
+#include "garnet/bin/zxdb/client/memory_dump.h"
 #include "garnet/bin/zxdb/client/remote_api_test.h"
 #include "garnet/bin/zxdb/client/session.h"
+#include "garnet/bin/zxdb/client/thread.h"
 #include "gtest/gtest.h"
 
 namespace zxdb {
@@ -21,6 +24,21 @@ class ProcessSink : public RemoteAPI {
   }
   int resume_count() const { return resume_count_; }
 
+  void set_backtraces_reply(debug_ipc::BacktracesReply reply) {
+    backtraces_reply_ = std::move(reply);
+  }
+  void set_backtraces_err(Err err) { backtraces_err_ = std::move(err); }
+  int backtraces_count() const { return backtraces_count_; }
+
+  void set_threads_reply(debug_ipc::ThreadsReply reply) {
+    threads_reply_ = std::move(reply);
+  }
+
+  // All memory reads return this value for every byte.
+  void set_memory_value(uint8_t value) { memory_value_ = value; }
+  int read_memory_count() const { return read_memory_count_; }
+  int read_memory_ranges_count() const { return read_memory_ranges_count_; }
+
   void Resume(
       const debug_ipc::ResumeRequest& request,
       std::function<void(const Err&, debug_ipc::ResumeReply)> cb) override {
@@ -30,9 +48,67 @@ class ProcessSink : public RemoteAPI {
         [cb]() { cb(Err(), debug_ipc::ResumeReply()); });
   }
 
+  void Backtraces(
+      const debug_ipc::BacktracesRequest& request,
+      std::function<void(const Err&, debug_ipc::BacktracesReply)> cb) override {
+    backtraces_count_++;
+    debug_ipc::MessageLoop::Current()->PostTask(
+        [ cb, err = backtraces_err_, reply = backtraces_reply_ ]() {
+          cb(err, reply);
+        });
+  }
+
+  void Threads(
+      const debug_ipc::ThreadsRequest& request,
+      std::function<void(const Err&, debug_ipc::ThreadsReply)> cb) override {
+    debug_ipc::MessageLoop::Current()->PostTask(
+        [ cb, reply = threads_reply_ ]() { cb(Err(), reply); });
+  }
+
+  void ReadMemory(
+      const debug_ipc::ReadMemoryRequest& request,
+      std::function<void(const Err&, debug_ipc::ReadMemoryReply)> cb) override {
+    read_memory_count_++;
+    debug_ipc::ReadMemoryReply reply;
+    reply.blocks.push_back(MakeBlock(request.address, request.size));
+    debug_ipc::MessageLoop::Current()->PostTask(
+        [ cb, reply = std::move(reply) ]() { cb(Err(), reply); });
+  }
+
+  void ReadMemoryRanges(
+      const debug_ipc::ReadMemoryRangesRequest& request,
+      std::function<void(const Err&, debug_ipc::ReadMemoryRangesReply)> cb)
+      override {
+    read_memory_ranges_count_++;
+    debug_ipc::ReadMemoryRangesReply reply;
+    for (const auto& range : request.ranges)
+      reply.blocks.push_back(MakeBlock(range.address, range.size));
+    debug_ipc::MessageLoop::Current()->PostTask(
+        [ cb, reply = std::move(reply) ]() { cb(Err(), reply); });
+  }
+
  private:
+  debug_ipc::MemoryBlock MakeBlock(uint64_t address, uint32_t size) const {
+    debug_ipc::MemoryBlock block;
+    block.address = address;
+    block.valid = true;
+    block.size = size;
+    block.data.assign(size, memory_value_);
+    return block;
+  }
+
   debug_ipc::ResumeRequest resume_request_;
   int resume_count_ = 0;
+
+  debug_ipc::BacktracesReply backtraces_reply_;
+  Err backtraces_err_;
+  int backtraces_count_ = 0;
+
+  debug_ipc::ThreadsReply threads_reply_;
+
+  uint8_t memory_value_ = 0;
+  int read_memory_count_ = 0;
+  int read_memory_ranges_count_ = 0;
 };
 
 class ProcessImplTest : public RemoteAPITest {
@@ -42,6 +118,37 @@ class ProcessImplTest : public RemoteAPITest {
 
   ProcessSink* sink() { return sink_; }
 
+  // Reads one byte from the process, running the loop until it completes.
+  uint8_t ReadByte(Process* process, uint64_t address) {
+    uint8_t result = 0;
+    process->ReadMemory(address, 1, [address, &result](const Err& err,
+                                                       MemoryDump dump) {
+      EXPECT_FALSE(err.has_error());
+      EXPECT_TRUE(dump.GetByte(address, &result));
+      debug_ipc::MessageLoop::Current()->QuitNow();
+    });
+    loop().Run();
+    return result;
+  }
+
+  // Replaces the process' thread list with the given threads and states.
+  void SyncThreadStates(
+      Process* process,
+      const std::vector<std::pair<uint64_t, debug_ipc::ThreadRecord::State>>&
+          states) {
+    debug_ipc::ThreadsReply reply;
+    for (const auto& pair : states) {
+      debug_ipc::ThreadRecord record;
+      record.koid = pair.first;
+      record.state = pair.second;
+      reply.threads.push_back(record);
+    }
+    sink()->set_threads_reply(std::move(reply));
+    process->SyncThreads(
+        []() { debug_ipc::MessageLoop::Current()->QuitNow(); });
+    loop().Run();
+  }
+
  private:
   std::unique_ptr<RemoteAPI> GetRemoteAPIImpl() override {
     auto sink = std::make_unique<ProcessSink>();
@@ -82,4 +189,152 @@ TEST_F(ProcessImplTest, OnModules) {
   EXPECT_EQ(notify.stopped_thread_koids, resume.thread_koids);
 }
 
+// Tests that the frames of all threads are fetched in one request and saved
+// to every thread, across more than one batch of threads.
+TEST_F(ProcessImplTest, SyncAllThreadFrames) {
+  constexpr uint64_t kProcessKoid = 1234;
+  Process* process = InjectProcess(kProcessKoid);
+  ASSERT_TRUE(process);
+
+  constexpr uint64_t kFirstThreadKoid = 5000;
+  constexpr size_t kThreadCount = 40;
+  constexpr uint64_t kSharedAddress = 0x1000;
+  debug_ipc::BacktracesReply reply;
+  for (size_t i = 0; i < kThreadCount; i++) {
+    InjectThread(kProcessKoid, kFirstThreadKoid + i);
+
+    // Each thread has its own top frame and one frame in common.
+    debug_ipc::ThreadBacktrace backtrace;
+    backtrace.thread_koid = kFirstThreadKoid + i;
+    backtrace.frames.resize(2);
+    backtrace.frames[0].ip = 0x2000 + i;
+    backtrace.frames[0].sp = 0x8000;
+    backtrace.frames[1].ip = kSharedAddress;
+    backtrace.frames[1].sp = 0x8010;
+    reply.backtraces.push_back(std::move(backtrace));
+  }
+
+  // A thread the client doesn't know about should be ignored.
+  debug_ipc::ThreadBacktrace unknown;
+  unknown.thread_koid = 99;
+  unknown.frames.resize(1);
+  reply.backtraces.push_back(unknown);
+  sink()->set_backtraces_reply(std::move(reply));
+
+  std::vector<uint64_t> reported;
+  bool done = false;
+  process->SyncAllThreadFrames(
+      [&reported, &done](Thread* thread) {
+        EXPECT_FALSE(done);
+        reported.push_back(thread->GetKoid());
+      },
+      [&done](const Err& err) {
+        EXPECT_FALSE(err.has_error());
+        done = true;
+        debug_ipc::MessageLoop::Current()->QuitNow();
+      });
+  loop().Run();
+
+  EXPECT_TRUE(done);
+  EXPECT_EQ(1, sink()->backtraces_count());
+  ASSERT_EQ(kThreadCount, reported.size());
+  for (size_t i = 0; i < kThreadCount; i++) {
+    EXPECT_EQ(kFirstThreadKoid + i, reported[i]);
+
+    Thread* thread = process->GetThreadFromKoid(kFirstThreadKoid + i);
+    ASSERT_TRUE(thread);
+    EXPECT_TRUE(thread->HasAllFrames());
+    auto frames = thread->GetFrames();
+    ASSERT_EQ(2u, frames.size());
+    EXPECT_EQ(0x2000 + i, frames[0]->GetAddress());
+    EXPECT_EQ(kSharedAddress, frames[1]->GetAddress());
+    EXPECT_EQ(0x8010u, frames[1]->GetStackPointer());
+  }
+}
+
+// Tests that a failed backtraces request is reported to the done callback
+// without any thread callbacks.
+TEST_F(ProcessImplTest, SyncAllThreadFramesError) {
+  constexpr uint64_t kProcessKoid = 1234;
+  Process* process = InjectProcess(kProcessKoid);
+  ASSERT_TRUE(process);
+  InjectThread(kProcessKoid, 5000);
+
+  debug_ipc::BacktracesReply reply;
+  reply.backtraces.resize(1);
+  reply.backtraces[0].thread_koid = 5000;
+  sink()->set_backtraces_reply(std::move(reply));
+  sink()->set_backtraces_err(Err("Connection lost."));
+
+  int thread_callbacks = 0;
+  Err done_err;
+  process->SyncAllThreadFrames(
+      [&thread_callbacks](Thread*) { thread_callbacks++; },
+      [&done_err](const Err& err) {
+        done_err = err;
+        debug_ipc::MessageLoop::Current()->QuitNow();
+      });
+  loop().Run();
+
+  EXPECT_TRUE(done_err.has_error());
+  EXPECT_EQ("Connection lost.", done_err.msg());
+  EXPECT_EQ(0, thread_callbacks);
+  EXPECT_FALSE(process->GetThreadFromKoid(5000)->HasAllFrames());
+}
+
+// Tests that memory is only cached while every thread is held by the
+// debugger. A thread that is blocked (say, in a syscall) can wake up and write
+// to memory at any time.
+TEST_F(ProcessImplTest, MemoryCacheWithBlockedThread) {
+  constexpr uint64_t kProcessKoid = 1234;
+  constexpr uint64_t kThread1Koid = 5678;
+  constexpr uint64_t kThread2Koid = 5679;
+  constexpr uint64_t kAddress = 0x10000;
+  constexpr auto kBlocked = debug_ipc::ThreadRecord::State::kBlocked;
+  constexpr auto kSuspended = debug_ipc::ThreadRecord::State::kSuspended;
+
+  Process* process = InjectProcess(kProcessKoid);
+  ASSERT_TRUE(process);
+  InjectThread(kProcessKoid, kThread1Koid);
+  InjectThread(kProcessKoid, kThread2Koid);
+
+  // Thread 1 stops in an exception and thread 2 blocks on its own.
+  debug_ipc::NotifyException exception;
+  exception.process_koid = kProcessKoid;
+  exception.type = debug_ipc::NotifyException::Type::kSoftware;
+  exception.thread.koid = kThread1Koid;
+  exception.thread.state = kBlocked;
+  exception.frames.resize(1);
+  exception.frames[0].ip = 0x1000;
+  exception.frames[0].sp = 0x5000;
+  InjectException(exception);
+  SyncThreadStates(process,
+                   {{kThread1Koid, kBlocked}, {kThread2Koid, kBlocked}});
+
+  // The memory changes between the reads. Both should go to the agent.
+  sink()->set_memory_value(1);
+  EXPECT_EQ(1, ReadByte(process, kAddress));
+  sink()->set_memory_value(2);
+  EXPECT_EQ(2, ReadByte(process, kAddress));
+  EXPECT_EQ(2, sink()->read_memory_count());
+  EXPECT_EQ(0, sink()->read_memory_ranges_count());
+
+  // Once the debugger suspends thread 2, the memory can be cached.
+  SyncThreadStates(process,
+                   {{kThread1Koid, kBlocked}, {kThread2Koid, kSuspended}});
+  sink()->set_memory_value(3);
+  EXPECT_EQ(3, ReadByte(process, kAddress));
+  EXPECT_EQ(1, sink()->read_memory_ranges_count());
+  sink()->set_memory_value(4);
+  EXPECT_EQ(3, ReadByte(process, kAddress));
+  EXPECT_EQ(1, sink()->read_memory_ranges_count());
+
+  // Thread 2 changing state on its own discards the cache.
+  SyncThreadStates(process,
+                   {{kThread1Koid, kBlocked}, {kThread2Koid, kBlocked}});
+  EXPECT_EQ(4, ReadByte(process, kAddress));
+  EXPECT_EQ(3, sink()->read_memory_count());
+  EXPECT_EQ(1, sink()->read_memory_ranges_count());
+}
+
 }  // namespace zxdb
@@ -104,4 +104,16 @@ void RemoteAPI::AddressSpace(
   FXL_NOTREACHED();
 }
 
+void RemoteAPI::ReadMemoryRanges(
+    const debug_ipc::ReadMemoryRangesRequest& request,
+    std::function<void(const Err&, debug_ipc::ReadMemoryRangesReply)> cb) {
+  FXL_NOTREACHED();
+}
+
+void RemoteAPI::Backtraces(
+    const debug_ipc::BacktracesRequest& request,
+    std::function<void(const Err&, debug_ipc::BacktracesReply)> cb) {
+  FXL_NOTREACHED();
+}
+
 }  // namespace zxdb
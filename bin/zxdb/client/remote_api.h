@@ -71,6 +71,12 @@ class RemoteAPI {
   virtual void AddressSpace(
       const debug_ipc::AddressSpaceRequest& request,
       std::function<void(const Err&, debug_ipc::AddressSpaceReply)> cb);
+  virtual void ReadMemoryRanges(
+      const debug_ipc::ReadMemoryRangesRequest& request,
+      std::function<void(const Err&, debug_ipc::ReadMemoryRangesReply)> cb);
+  virtual void Backtraces(
+      const debug_ipc::BacktracesRequest& request,
+      std::function<void(const Err&, debug_ipc::BacktracesReply)> cb);
 
  private:
   FXL_DISALLOW_COPY_AND_ASSIGN(RemoteAPI);
@@ -115,6 +115,18 @@ void RemoteAPIImpl::AddressSpace(
   Send(request, std::move(cb));
 }
 
+void RemoteAPIImpl::ReadMemoryRanges(
+    const debug_ipc::ReadMemoryRangesRequest& request,
+    std::function<void(const Err&, debug_ipc::ReadMemoryRangesReply)> cb) {
+  Send(request, std::move(cb));
+}
+
+void RemoteAPIImpl::Backtraces(
+    const debug_ipc::BacktracesRequest& request,
+    std::function<void(const Err&, debug_ipc::BacktracesReply)> cb) {
+  Send(request, std::move(cb));
+}
+
 template <typename SendMsgType, typename RecvMsgType>
 void RemoteAPIImpl::Send(
     const SendMsgType& send_msg,
@@ -69,6 +69,13 @@ class RemoteAPIImpl : public RemoteAPI {
       const debug_ipc::AddressSpaceRequest& request,
       std::function<void(const Err&, debug_ipc::AddressSpaceReply)> cb)
       override;
+  void ReadMemoryRanges(
+      const debug_ipc::ReadMemoryRangesRequest& request,
+      std::function<void(const Err&, debug_ipc::ReadMemoryRangesReply)> cb)
+      override;
+  void Backtraces(
+      const debug_ipc::BacktracesRequest& request,
+      std::function<void(const Err&, debug_ipc::BacktracesReply)> cb) override;
 
  private:
   // Sends a message with an asynchronous reply.
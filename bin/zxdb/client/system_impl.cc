@@ -172,6 +172,11 @@ void SystemImpl::Pause() {
 }
 
 void SystemImpl::Continue() {
+  for (const auto& target : targets_) {
+    if (target->process())
+      target->process()->WillResumeThreads({});
+  }
+
   debug_ipc::ResumeRequest request;
   request.process_koid = 0;  // 0 means all processes.
   request.how = debug_ipc::ResumeRequest::How::kContinue;
@@ -47,6 +47,8 @@ void ThreadImpl::Pause() {
 }
 
 void ThreadImpl::Continue() {
+  process_->WillResumeThreads({koid_});
+
   debug_ipc::ResumeRequest request;
   request.process_koid = process_->GetKoid();
   request.thread_koids.push_back(koid_);
@@ -124,6 +126,8 @@ void ThreadImpl::NotifyControllerDone(ThreadController* controller) {
 }
 
 void ThreadImpl::StepInstruction() {
+  process_->WillResumeThreads({koid_});
+
   debug_ipc::ResumeRequest request;
   request.process_koid = process_->GetKoid();
   request.thread_koids.push_back(koid_);
@@ -224,6 +228,7 @@ void ThreadImpl::SetMetadataFromException(
 
   // After an exception the thread should be blocked.
   FXL_DCHECK(state_ == debug_ipc::ThreadRecord::State::kBlocked);
+  process_->DidStopThreadInException(koid_);
 
   FXL_DCHECK(!notify.frames.empty());
   SaveFrames(notify.frames, false);
@@ -304,8 +309,15 @@ void ThreadImpl::OnException(
   }
 }
 
+void ThreadImpl::SetAllFrames(const std::vector<debug_ipc::StackFrame>& frames,
+                              std::vector<Location> locations) {
+  SaveFrames(frames, true, std::move(locations));
+}
+
 void ThreadImpl::SaveFrames(const std::vector<debug_ipc::StackFrame>& frames,
-                            bool have_all) {
+                            bool have_all, std::vector<Location> locations) {
+  FXL_DCHECK(locations.empty() || locations.size() == frames.size());
+
   // The goal is to preserve pointer identity for frames. If a frame is the
   // same, weak pointers to it should remain valid.
   using IpSp = std::pair<uint64_t, uint64_t>;
@@ -321,8 +333,12 @@ void ThreadImpl::SaveFrames(const std::vector<debug_ipc::StackFrame>& frames,
     auto found = existing.find(key);
     if (found == existing.end()) {
       // New frame we haven't seen.
-      frames_.push_back(std::make_unique<FrameImpl>(
-          this, frames[i], Location(Location::State::kAddress, frames[i].ip)));
+      Location location =
+          locations.empty()
+              ? Location(Location::State::kAddress, frames[i].ip)
+              : std::move(locations[i]);
+      frames_.push_back(
+          std::make_unique<FrameImpl>(this, frames[i], std::move(location)));
     } else {
       // Can re-use existing pointer.
       frames_.push_back(std::move(found->second));
@@ -6,6 +6,7 @@
 
 #include "garnet/bin/zxdb/client/register.h"
 #include "garnet/bin/zxdb/client/thread.h"
+#include "garnet/bin/zxdb/symbols/location.h"
 #include "garnet/public/lib/fxl/memory/weak_ptr.h"
 
 namespace zxdb {
@@ -50,6 +51,12 @@ class ThreadImpl : public Thread {
   void SetMetadata(const debug_ipc::ThreadRecord& record);
   void SetMetadataFromException(const debug_ipc::NotifyException& notify);
 
+  // Replaces the frames with a complete backtrace that was retrieved by the
+  // process (see ProcessImpl::SyncAllThreadFrames()). The locations are the
+  // already-symbolized locations of each frame.
+  void SetAllFrames(const std::vector<debug_ipc::StackFrame>& frames,
+                    std::vector<Location> locations);
+
   // Notification of an exception. Call after SetMetadataFromException() in
   // cases where a stop may be required. This function will check controllers
   // and will either stop (dispatching notifications) or transparently
@@ -62,9 +69,12 @@ class ThreadImpl : public Thread {
       const std::vector<fxl::WeakPtr<Breakpoint>>& hit_breakpoints);
 
  private:
-  // Saves the new frames for this thread.
+  // Saves the new frames for this thread. If non-empty, the locations are
+  // the symbolized locations of each frame. Otherwise the frames will be
+  // symbolized on demand.
   void SaveFrames(const std::vector<debug_ipc::StackFrame>& frames,
-                  bool have_all);
+                  bool have_all,
+                  std::vector<Location> locations = std::vector<Location>());
 
   // Invlidates the cached frames.
   void ClearFrames();
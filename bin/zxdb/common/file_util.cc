@@ -4,6 +4,8 @@
 
 #include "garnet/bin/zxdb/common/file_util.h"
 
+#include <sys/stat.h>
+
 namespace zxdb {
 
 fxl::StringView ExtractLastFileComponent(fxl::StringView path) {
@@ -33,4 +35,23 @@ std::string CatPathComponents(const std::string& first,
   return result;
 }
 
+bool GetFileSizeAndModificationTime(const std::string& path, uint64_t* size,
+                                    int64_t* mtime_ns) {
+  struct stat file_stat;
+  if (stat(path.c_str(), &file_stat) != 0)
+    return false;
+
+  constexpr int64_t kNanosecondsPerSecond = 1000000000;
+#if defined(__APPLE__)
+  const struct timespec& mtime = file_stat.st_mtimespec;
+#else
+  const struct timespec& mtime = file_stat.st_mtim;
+#endif
+
+  *size = static_cast<uint64_t>(file_stat.st_size);
+  *mtime_ns = static_cast<int64_t>(mtime.tv_sec) * kNanosecondsPerSecond +
+              mtime.tv_nsec;
+  return true;
+}
+
 }  // namespace zxdb
@@ -4,6 +4,10 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include <string>
+
 #include "garnet/public/lib/fxl/strings/string_view.h"
 
 namespace zxdb {
@@ -25,4 +29,11 @@ bool IsPathAbsolute(const std::string& path);
 std::string CatPathComponents(const std::string& first,
                               const std::string& second);
 
+// Retrieves the size and last modification time of the given file. The time
+// is in nanoseconds since the epoch. These are used to tell when cached
+// information derived from a file is out-of-date. Returns false if the file
+// can't be accessed.
+bool GetFileSizeAndModificationTime(const std::string& path, uint64_t* size,
+                                    int64_t* mtime_ns);
+
 }  // namespace zxdb
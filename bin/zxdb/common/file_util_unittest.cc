@@ -4,6 +4,7 @@
 
 #include "garnet/bin/zxdb/common/file_util.h"
 #include "gtest/gtest.h"
+#include "lib/fxl/files/scoped_temp_dir.h"
 
 namespace zxdb {
 
@@ -32,4 +33,19 @@ TEST(FileUtil, CatPathComponents) {
   EXPECT_EQ("a/b/", CatPathComponents("a/", "b/"));
 }
 
+TEST(FileUtil, GetFileSizeAndModificationTime) {
+  files::ScopedTempDir temp_dir;
+  std::string path;
+  ASSERT_TRUE(temp_dir.NewTempFileWithData("hello", &path));
+
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+  ASSERT_TRUE(GetFileSizeAndModificationTime(path, &size, &mtime_ns));
+  EXPECT_EQ(5u, size);
+  EXPECT_NE(0, mtime_ns);
+
+  EXPECT_FALSE(GetFileSizeAndModificationTime(path + ".nonexistant", &size,
+                                              &mtime_ns));
+}
+
 }  // namespace zxdb
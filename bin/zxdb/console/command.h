@@ -80,6 +80,7 @@ enum class Verb {
   kStepi,
   kSymInfo,
   kSymNear,
+  kSymSearch,
   kSymStat,
   kUntil,
 
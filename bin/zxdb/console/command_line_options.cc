@@ -47,6 +47,13 @@ const char kSymbolPathHelp[] = R"(  --symbol-path=<path>
       as a mapping database from build ID to file path. Otherwise, the path
       will be loaded as an ELF file (if possible).)";
 
+const char kSymbolCacheHelp[] = R"(  --symbol-cache=<dir>
+      Caches the symbol index for each loaded module, and the build IDs of
+      the files in the symbol directories, in the given directory. These are
+      reused by later sessions as long as the files are unchanged, which
+      makes startup and attaching to processes with many large modules much
+      faster.)";
+
 }  // namespace
 
 Err ParseCommandLine(int argc, const char* argv[], CommandLineOptions* options,
@@ -59,6 +66,8 @@ Err ParseCommandLine(int argc, const char* argv[], CommandLineOptions* options,
                    &CommandLineOptions::script_file);
   parser.AddSwitch("symbol-path", 's', kSymbolPathHelp,
                    &CommandLineOptions::symbol_paths);
+  parser.AddSwitch("symbol-cache", 0, kSymbolCacheHelp,
+                   &CommandLineOptions::symbol_cache);
 
   // Special --help switch which doesn't exist in the options structure.
   bool requested_help = false;
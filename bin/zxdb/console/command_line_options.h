@@ -19,6 +19,7 @@ struct CommandLineOptions {
   std::optional<std::string> script_file;
 
   std::vector<std::string> symbol_paths;
+  std::optional<std::string> symbol_cache;
 };
 
 // Parses the given command line into options and params.
@@ -112,6 +112,11 @@ int ConsoleMain(int argc, const char* argv[]) {
         session.system().GetSymbols()->build_id_index().AddSymbolSource(path);
       }
     }
+    if (options.symbol_cache)
+      session.system().GetSymbols()->SetIndexCacheDir(*options.symbol_cache);
+
+    // Get the symbol directories scanning while the user is connecting.
+    session.system().GetSymbols()->build_id_index().StartBackgroundScan();
 
     if (!actions.empty()) {
       ScheduleActions(session, console, std::move(actions));
@@ -7,7 +7,9 @@
 #include <inttypes.h>
 
 #include "garnet/bin/zxdb/client/frame.h"
+#include "garnet/bin/zxdb/client/process.h"
 #include "garnet/bin/zxdb/client/thread.h"
+#include "garnet/bin/zxdb/common/err.h"
 #include "garnet/bin/zxdb/console/command_utils.h"
 #include "garnet/bin/zxdb/console/console.h"
 #include "garnet/bin/zxdb/console/format_value.h"
@@ -23,11 +25,16 @@ namespace zxdb {
 
 namespace {
 
-void ListCompletedFrames(Thread* thread, bool long_format) {
+// The heading, if nonempty, is output on its own line before the frames.
+void ListCompletedFrames(Thread* thread, bool long_format,
+                         const std::string& heading = std::string()) {
   Console* console = Console::get();
   int active_frame_id = console->context().GetActiveFrameIdForThread(thread);
 
   auto helper = fxl::MakeRefCounted<FormatValue>();
+  if (!heading.empty())
+    helper->Append(
+        OutputBuffer::WithContents(Syntax::kHeading, heading + "\n"));
 
   // This doesn't use table output since the format of the stack frames is
   // usually so unpredictable.
@@ -78,6 +85,19 @@ void OutputFrameList(Thread* thread, bool long_format) {
   }
 }
 
+void OutputAllThreadFrames(Process* process, bool long_format) {
+  process->SyncAllThreadFrames(
+      [long_format](Thread* thread) {
+        ListCompletedFrames(
+            thread, long_format,
+            DescribeThread(&Console::get()->context(), thread));
+      },
+      [](const Err& err) {
+        if (err.has_error())
+          Console::get()->Output(err);
+      });
+}
+
 void FormatFrame(const Frame* frame, OutputBuffer* out, int id) {
   if (id >= 0)
     out->Append(fxl::StringPrintf("Frame %d ", id));
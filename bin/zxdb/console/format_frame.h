@@ -10,12 +10,18 @@ class FormatValue;
 struct FormatValueOptions;
 class Frame;
 class OutputBuffer;
+class Process;
 class Thread;
 
 // Outputs the list of frames to the console. This will complete asynchronously
 // if the frames are not currently available.
 void OutputFrameList(Thread* thread, bool long_format);
 
+// Outputs the frames of every thread in the process, each preceded by a
+// description of the thread. The threads are output as their frames become
+// available. An error fetching the frames is output instead.
+void OutputAllThreadFrames(Process* process, bool long_format);
+
 // Formats one frame using the short format to the output buffer. The frame ID
 // will be printed if supplied. If the ID is -1, it will be omitted.
 //
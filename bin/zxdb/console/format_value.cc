@@ -7,6 +7,7 @@
 #include <ctype.h>
 #include <string.h>
 
+#include "garnet/bin/zxdb/common/address_range.h"
 #include "garnet/bin/zxdb/expr/expr_value.h"
 #include "garnet/bin/zxdb/expr/resolve_array.h"
 #include "garnet/bin/zxdb/expr/resolve_member.h"
@@ -99,6 +100,56 @@ void AppendEscapedChar(uint8_t ch, std::string* dest) {
   }
 }
 
+// Computes the memory that formatting the given value will read from the
+// debugged process. This is the target of references and the string data of
+// character pointers. Returns false if the value doesn't need any memory.
+bool GetIndirectMemory(const ExprValue& value,
+                       const FormatValueOptions& options,
+                       AddressRange* range) {
+  if (!value.type() || value.data().size() != sizeof(uint64_t))
+    return false;
+  const ModifiedType* modified =
+      value.type()->GetConcreteType()->AsModifiedType();
+  if (!modified)
+    return false;
+
+  uint64_t address = value.GetAs<uint64_t>();
+  if (!address)
+    return false;
+
+  uint32_t size = 0;
+  if (modified->tag() == Symbol::kTagReferenceType) {
+    const Type* underlying = modified->modified().Get()->AsType();
+    if (underlying)
+      size = underlying->GetConcreteType()->byte_size();
+  } else if (modified->tag() == Symbol::kTagPointerType &&
+             IsCharacterType(modified->modified())) {
+    size = options.max_array_size;
+  }
+  if (size == 0)
+    return false;
+
+  *range = AddressRange(address, address + size);
+  return true;
+}
+
+// Asks the data provider to fetch all memory that formatting the given values
+// will need in one batch. Otherwise each value would make its own request.
+void PrefetchIndirectMemory(SymbolDataProvider* data_provider,
+                            const std::vector<ExprValue>& values,
+                            const FormatValueOptions& options) {
+  std::vector<AddressRange> ranges;
+  AddressRange range;
+  for (const ExprValue& value : values) {
+    if (GetIndirectMemory(value, options, &range))
+      ranges.push_back(range);
+  }
+
+  // A single read will be just as fast without prefetching.
+  if (ranges.size() > 1)
+    data_provider->PrefetchMemory(ranges);
+}
+
 }  // namespace
 
 FormatValue::FormatValue() : weak_factory_(this) {}
@@ -316,17 +367,29 @@ void FormatValue::FormatCollection(
     OutputKey output_key) {
   AppendToOutputKey(output_key, OutputBuffer("{"));
 
-  for (size_t i = 0; i < coll->data_members().size(); i++) {
-    const DataMember* member = coll->data_members()[i].Get()->AsDataMember();
+  // Resolve all members up-front so any memory they refer to can be fetched
+  // at once.
+  std::vector<const DataMember*> members;
+  std::vector<Err> member_errs;
+  std::vector<ExprValue> member_values;
+  for (const auto& lazy_member : coll->data_members()) {
+    const DataMember* member = lazy_member.Get()->AsDataMember();
     if (!member)
       continue;
+    members.push_back(member);
+    member_values.emplace_back();
+    member_errs.push_back(ResolveMember(value, member, &member_values.back()));
+  }
+  PrefetchIndirectMemory(data_provider.get(), member_values, options);
+
+  for (size_t i = 0; i < members.size(); i++) {
+    const DataMember* member = members[i];
+    const Err& err = member_errs[i];
+    const ExprValue& member_value = member_values[i];
 
     if (i > 0)
       AppendToOutputKey(output_key, OutputBuffer(", "));
 
-    ExprValue member_value;
-    Err err = ResolveMember(value, member, &member_value);
-
     // Type info if requested.
     if (options.always_show_types && member_value.type()) {
       AppendToOutputKey(
@@ -487,6 +550,8 @@ void FormatValue::FormatArray(fxl::RefPtr<SymbolDataProvider> data_provider,
     return;
   }
 
+  PrefetchIndirectMemory(data_provider.get(), items, options);
+
   AppendToOutputKey(output_key, OutputBuffer("{"));
 
   for (size_t i = 0; i < items.size(); i++) {
@@ -440,6 +440,35 @@ TEST_F(FormatValueTest, Structs) {
       SyncFormatValue(pair_value, opts));
 }
 
+// The memory for all references in a struct should be requested at once.
+TEST_F(FormatValueTest, PrefetchMembers) {
+  FormatValueOptions opts;
+
+  auto int32_type = MakeInt32Type();
+  auto int_ref = fxl::MakeRefCounted<ModifiedType>(Symbol::kTagReferenceType,
+                                                   LazySymbol(int32_type));
+
+  constexpr uint64_t kAddress1 = 0x1100;
+  constexpr uint64_t kAddress2 = 0x2200;
+  provider()->AddMemory(kAddress1, {1, 0, 0, 0});
+  provider()->AddMemory(kAddress2, {2, 0, 0, 0});
+
+  auto refs = MakeStruct2Members("Refs", int_ref, "a", int_ref, "b");
+  ExprValue refs_value(
+      refs, {0x00, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,    // (int32&) a
+             0x00, 0x22, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00});  // (int32&) b
+
+  EXPECT_EQ("{a = (int32_t&) 0x1100 = 1, b = (int32_t&) 0x2200 = 2}",
+            SyncFormatValue(refs_value, opts));
+
+  const auto& ranges = provider()->prefetched_ranges();
+  ASSERT_EQ(2u, ranges.size());
+  EXPECT_EQ(kAddress1, ranges[0].begin());
+  EXPECT_EQ(kAddress1 + 4, ranges[0].end());
+  EXPECT_EQ(kAddress2, ranges[1].begin());
+  EXPECT_EQ(kAddress2 + 4, ranges[1].end());
+}
+
 // GDB and LLDB both print all members of a union and accept the possibility
 // that sometimes one of them might be garbage, we do the same.
 TEST_F(FormatValueTest, Union) {
@@ -10,10 +10,38 @@
 #include "garnet/bin/zxdb/console/string_util.h"
 #include "garnet/bin/zxdb/symbols/location.h"
 #include "garnet/bin/zxdb/symbols/process_symbols.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
 #include "lib/fxl/strings/string_printf.h"
 
 namespace zxdb {
 
+namespace {
+
+// Maximum number of alternatives listed in error messages.
+constexpr size_t kMaxSuggestions = 10u;
+
+// Returns an error message suffix listing the functions with names similar to
+// the given one, or the empty string if there are none.
+std::string GetSymbolSuggestions(const ProcessSymbols* process_symbols,
+                                 const std::string& symbol) {
+  SymbolSearchQuery query(symbol, SymbolSearchQuery::Mode::kSubstring);
+  query.case_insensitive = true;
+  query.max_results = kMaxSuggestions + 1;  // One extra to know if truncated.
+  std::vector<std::string> names = process_symbols->SearchFunctionNames(query);
+  if (names.empty())
+    return std::string();
+
+  std::string result = " Did you mean:\n";
+  for (size_t i = 0; i < names.size() && i < kMaxSuggestions; i++)
+    result += fxl::StringPrintf(" %s %s\n", GetBullet().c_str(),
+                                names[i].c_str());
+  if (names.size() > kMaxSuggestions)
+    result += "...more omitted. Use \"sym-search\" to list all matches.\n";
+  return result;
+}
+
+}  // namespace
+
 Err ParseInputLocation(const Frame* frame, const std::string& input,
                        InputLocation* location) {
   if (input.empty())
@@ -93,8 +121,12 @@ Err ResolveInputLocations(const ProcessSymbols* process_symbols,
   *locations = process_symbols->ResolveInputLocation(input_location, options);
 
   if (locations->empty()) {
-    return Err("Nothing matching this %s was found.",
-               InputLocation::TypeToString(input_location.type));
+    std::string err_str =
+        fxl::StringPrintf("Nothing matching this %s was found.",
+                          InputLocation::TypeToString(input_location.type));
+    if (input_location.type == InputLocation::Type::kSymbol)
+      err_str += GetSymbolSuggestions(process_symbols, input_location.symbol);
+    return Err(err_str);
   }
   return Err();
 }
@@ -130,7 +162,6 @@ Err ResolveUniqueInputLocation(const ProcessSymbols* process_symbols,
   // When there is more than one, generate an error that lists the
   // possibilities for disambiguation.
   std::string err_str = "This resolves to more than one location. Could be:\n";
-  constexpr size_t kMaxSuggestions = 10u;
 
   if (!symbolize) {
     // The original call did not request symbolization which will produce very
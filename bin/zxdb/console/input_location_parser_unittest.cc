@@ -96,6 +96,18 @@ TEST(InputLocation, ResolveInputLocation) {
   EXPECT_TRUE(err.has_error());
   EXPECT_EQ("Nothing matching this symbol was found.", err.msg());
 
+  // No exact match but there are similar names which should be suggested.
+  process_symbols.AddSymbol("ns::FooBar", {});
+  process_symbols.AddSymbol("ns::foo", {});
+  err = ResolveUniqueInputLocation(&process_symbols, nullptr, "Foo", false,
+                                   &output);
+  EXPECT_TRUE(err.has_error());
+  EXPECT_EQ(R"(Nothing matching this symbol was found. Did you mean:
+ • ns::FooBar
+ • ns::foo
+)",
+            err.msg());
+
   SymbolContext symbol_context = SymbolContext::ForRelativeAddresses();
   Location expected(0x12345678, FileLine("file.cc", 12), 0, symbol_context);
 
@@ -28,6 +28,7 @@
 #include "garnet/bin/zxdb/symbols/module_symbol_status.h"
 #include "garnet/bin/zxdb/symbols/process_symbols.h"
 #include "garnet/bin/zxdb/symbols/resolve_options.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
 #include "garnet/bin/zxdb/symbols/system_symbols.h"
 #include "garnet/bin/zxdb/symbols/target_symbols.h"
 #include "garnet/bin/zxdb/symbols/type.h"
@@ -41,6 +42,9 @@ namespace {
 
 constexpr int kListAllSwitch = 1;
 constexpr int kListContextSwitch = 2;
+constexpr int kSymSearchPrefixSwitch = 3;
+constexpr int kSymSearchIgnoreCaseSwitch = 4;
+constexpr int kSymSearchMaxSwitch = 5;
 
 void DumpVariableLocation(const SymbolContext& symbol_context,
                           const VariableLocation& loc, OutputBuffer* out) {
@@ -393,6 +397,8 @@ void SummarizeProcessSymbolStatus(ConsoleContext* context, Process* process,
       out->Append(module.functions_indexed ? Syntax::kNormal : Syntax::kError,
                   fxl::StringPrintf("\n    Symbols indexed: %zu",
                                     module.functions_indexed));
+      out->Append(fxl::StringPrintf("\n    Index memory: %zuKB",
+                                    module.index_bytes / 1024));
     } else {
       out->Append(Syntax::kError, "    Symbols loaded: No");
     }
@@ -421,9 +427,21 @@ Err DoSymStat(ConsoleContext* context, const Command& cmd) {
 
   SystemSymbols* system_symbols = context->session()->system().GetSymbols();
 
+  // Both of these fold in the results of a scan that has finished. Check the
+  // progress first so a scan that completes in between still reports its
+  // final status below.
+  BuildIDIndex::ScanProgress progress =
+      system_symbols->build_id_index().GetScanProgress();
+  if (progress.in_progress) {
+    out.Append(Syntax::kWarning,
+               fxl::StringPrintf("  Scanning symbol locations: %zu of %zu "
+                                 "files checked.\n\n",
+                                 progress.files_scanned, progress.files_total));
+  }
+
   std::vector<std::vector<OutputBuffer>> table;
   auto index_status = system_symbols->build_id_index().GetStatus();
-  if (index_status.empty()) {
+  if (index_status.empty() && !progress.in_progress) {
     out.Append(Syntax::kError, "  No symbol locations are indexed.");
     out.Append("\n\n  Use the command-line switch \"zxdb -s <path>\" to "
                "specify the location of\n  your symbols.\n\n");
@@ -493,6 +511,86 @@ Err DoSymNear(ConsoleContext* context, const Command& cmd) {
   return Err();
 }
 
+// sym-search ------------------------------------------------------------------
+
+const char kSymSearchShortHelp[] =
+    "sym-search: Search for functions by name.";
+const char kSymSearchHelp[] =
+    R"(sym-search [--prefix] [--ignore-case] [--max=<count>] <text>
+
+  Lists the functions in the process' loaded modules whose fully-qualified
+  names contain the given text. Any of the listed names can be passed to
+  commands that take a location like "break".
+
+Arguments
+
+  --ignore-case | -i
+      Ignore the case of letters when matching.
+
+  --max=<count> | -m <count>
+      Show at most this many results. Defaults to 50.
+
+  --prefix | -p
+      Only match names starting with the text instead of anywhere in the name.
+
+Examples
+
+  sym-search MyClass::
+  sym-search -p -i std::vector<int>::
+  process 2 sym-search --max=500 Init
+)";
+
+Err DoSymSearch(ConsoleContext* context, const Command& cmd) {
+  Err err = cmd.ValidateNouns({Noun::kProcess});
+  if (err.has_error())
+    return err;
+  err = AssertRunningTarget(context, "sym-search", cmd.target());
+  if (err.has_error())
+    return err;
+
+  if (cmd.args().size() != 1u) {
+    return Err(ErrType::kInput,
+               "\"sym-search\" needs exactly one arg that's the text to "
+               "search for.");
+  }
+
+  uint64_t max_results = 50;
+  if (cmd.HasSwitch(kSymSearchMaxSwitch)) {
+    err = StringToUint64(cmd.GetSwitchValue(kSymSearchMaxSwitch),
+                         &max_results);
+    if (err.has_error())
+      return err;
+    if (max_results == 0)
+      return Err(ErrType::kInput, "--max must be greater than 0.");
+  }
+
+  SymbolSearchQuery query(cmd.args()[0],
+                          cmd.HasSwitch(kSymSearchPrefixSwitch)
+                              ? SymbolSearchQuery::Mode::kPrefix
+                              : SymbolSearchQuery::Mode::kSubstring);
+  query.case_insensitive = cmd.HasSwitch(kSymSearchIgnoreCaseSwitch);
+  query.max_results = max_results + 1;  // One extra to know if truncated.
+
+  std::vector<std::string> names =
+      cmd.target()->GetProcess()->GetSymbols()->SearchFunctionNames(query);
+
+  OutputBuffer out;
+  if (names.empty()) {
+    out.Append(Syntax::kError, "No matching functions found.\n");
+  } else {
+    for (size_t i = 0; i < names.size() && i < max_results; i++)
+      out.Append(names[i] + "\n");
+    if (names.size() > max_results) {
+      out.Append(Syntax::kComment,
+                 fxl::StringPrintf("...more than %" PRIu64
+                                   " matches, use --max to see more.\n",
+                                   max_results));
+    }
+  }
+  Console::get()->Output(std::move(out));
+  return Err();
+}
+
 }  // namespace
 
 void AppendSymbolVerbs(std::map<Verb, VerbRecord>* verbs) {
@@ -511,6 +609,15 @@ void AppendSymbolVerbs(std::map<Verb, VerbRecord>* verbs) {
   (*verbs)[Verb::kSymNear] =
       VerbRecord(&DoSymNear, {"sym-near", "sn"}, kSymNearShortHelp,
                  kSymNearHelp, CommandGroup::kQuery);
+
+  VerbRecord sym_search(&DoSymSearch, {"sym-search"}, kSymSearchShortHelp,
+                        kSymSearchHelp, CommandGroup::kQuery);
+  sym_search.switches.emplace_back(kSymSearchPrefixSwitch, false, "prefix",
+                                   'p');
+  sym_search.switches.emplace_back(kSymSearchIgnoreCaseSwitch, false,
+                                   "ignore-case", 'i');
+  sym_search.switches.emplace_back(kSymSearchMaxSwitch, true, "max", 'm');
+  (*verbs)[Verb::kSymSearch] = std::move(sym_search);
 }
 
 }  // namespace zxdb
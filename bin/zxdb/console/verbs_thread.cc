@@ -39,6 +39,7 @@ namespace {
 
 constexpr int kStepIntoUnsymbolized = 1;
 constexpr int kForceTypes = 2;
+constexpr int kAllThreads = 3;
 
 // If the system has at least one running process, returns true. If not,
 // returns false and sets the err.
@@ -72,16 +73,37 @@ const char kBacktraceHelp[] =
 
   To see less information, use "frame" or just "f".
 
+Arguments
+
+  -a
+  --all
+      Prints the backtraces of all threads in the process. The backtraces are
+      fetched in one request and each thread is printed as soon as its frames
+      are symbolized, which is much faster than querying each thread in turn.
+
 Examples
 
   t 2 bt
   thread 2 backtrace
+
+  bt -a
+  process 3 backtrace --all
 )";
 Err DoBacktrace(ConsoleContext* context, const Command& cmd) {
   Err err = cmd.ValidateNouns({Noun::kProcess, Noun::kThread});
   if (err.has_error())
     return err;
 
+  if (cmd.HasSwitch(kAllThreads)) {
+    if (cmd.HasNoun(Noun::kThread))
+      return Err("\"--all\" can't be used with a thread.");
+    Process* process = cmd.target()->GetProcess();
+    if (!process)
+      return Err("There is no process to have threads.");
+    OutputAllThreadFrames(process, true);
+    return Err();
+  }
+
   if (!cmd.thread())
     return Err("There is no thread to have frames.");
 
@@ -932,9 +954,13 @@ void AppendThreadVerbs(std::map<Verb, VerbRecord>* verbs) {
   // Shared by several verbs.
   SwitchRecord force_types(kForceTypes, false, "types", 't');
 
-  (*verbs)[Verb::kBacktrace] =
-      VerbRecord(&DoBacktrace, {"backtrace", "bt"}, kBacktraceShortHelp,
-                 kBacktraceHelp, CommandGroup::kQuery);
+  // backtrace
+  SwitchRecord all_threads(kAllThreads, false, "all", 'a');
+  VerbRecord backtrace(&DoBacktrace, {"backtrace", "bt"}, kBacktraceShortHelp,
+                       kBacktraceHelp, CommandGroup::kQuery);
+  backtrace.switches.push_back(all_threads);
+  (*verbs)[Verb::kBacktrace] = std::move(backtrace);
+
   (*verbs)[Verb::kContinue] =
       VerbRecord(&DoContinue, {"continue", "c"}, kContinueShortHelp,
                  kContinueHelp, CommandGroup::kStep, SourceAffinity::kSource);
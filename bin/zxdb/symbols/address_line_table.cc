@@ -0,0 +1,122 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/symbols/address_line_table.h"
+
+#include <algorithm>
+
+#include "garnet/public/lib/fxl/logging.h"
+
+namespace zxdb {
+
+namespace {
+
+bool SameInfo(const AddressLineTable::Entry& a,
+              const AddressLineTable::Entry& b) {
+  return a.file == b.file && a.line == b.line && a.column == b.column &&
+         a.function_die_offset == b.function_die_offset;
+}
+
+}  // namespace
+
+// AddressLineTable ------------------------------------------------------------
+
+AddressLineTable::AddressLineTable() = default;
+
+AddressLineTable::AddressLineTable(std::vector<Entry> entries,
+                                   std::vector<std::string> files)
+    : files_(std::move(files)) {
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const Entry& a, const Entry& b) {
+                     return a.begin < b.begin;
+                   });
+
+  entries_.reserve(entries.size());
+  for (Entry& entry : entries) {
+    FXL_DCHECK(entry.file < files_.size());
+    if (!entries_.empty()) {
+      Entry& prev = entries_.back();
+
+      // Overlapping ranges can happen when the linker discards functions but
+      // leaves their line table sequences (they will normally appear at
+      // address 0). Prefer the earlier one.
+      if (entry.begin < prev.end)
+        entry.begin = prev.end;
+      if (entry.begin >= entry.end)
+        continue;
+
+      if (entry.begin == prev.end && SameInfo(entry, prev)) {
+        prev.end = entry.end;
+        continue;
+      }
+    } else if (entry.begin >= entry.end) {
+      continue;
+    }
+    entries_.push_back(entry);
+  }
+  entries_.shrink_to_fit();
+}
+
+AddressLineTable::~AddressLineTable() = default;
+
+AddressLineTable::AddressLineTable(AddressLineTable&&) = default;
+AddressLineTable& AddressLineTable::operator=(AddressLineTable&&) = default;
+
+const AddressLineTable::Entry* AddressLineTable::Find(
+    uint64_t relative_address) const {
+  // Find the first entry starting after the address, the one before it is
+  // the only one that could contain it.
+  auto found = std::upper_bound(
+      entries_.begin(), entries_.end(), relative_address,
+      [](uint64_t address, const Entry& e) { return address < e.begin; });
+  if (found == entries_.begin())
+    return nullptr;
+  --found;
+  if (relative_address >= found->end)
+    return nullptr;
+  return &*found;
+}
+
+size_t AddressLineTable::MemoryUsage() const {
+  size_t result =
+      sizeof(AddressLineTable) + entries_.capacity() * sizeof(Entry);
+  for (const auto& file : files_)
+    result += sizeof(std::string) + file.capacity();
+  return result;
+}
+
+// AddressLineTableCache -------------------------------------------------------
+
+AddressLineTableCache::AddressLineTableCache(size_t max_tables)
+    : max_tables_(max_tables) {
+  FXL_DCHECK(max_tables_ > 0);
+}
+
+AddressLineTableCache::~AddressLineTableCache() = default;
+
+const AddressLineTable* AddressLineTableCache::Get(uint32_t unit_offset,
+                                                   const CreateCallback& cb) {
+  auto found = tables_.find(unit_offset);
+  if (found != tables_.end()) {
+    // Move to the front.
+    lru_.splice(lru_.begin(), lru_, found->second);
+    return &found->second->second;
+  }
+
+  if (lru_.size() >= max_tables_) {
+    tables_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+
+  lru_.emplace_front(unit_offset, cb());
+  tables_[unit_offset] = lru_.begin();
+  return &lru_.front().second;
+}
+
+void AddressLineTableCache::Clear() {
+  tables_.clear();
+  lru_.clear();
+}
+
+}  // namespace zxdb
@@ -0,0 +1,108 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "garnet/public/lib/fxl/macros.h"
+
+namespace zxdb {
+
+// A compact, sorted table mapping module-relative address ranges to source
+// locations and functions for one compilation unit.
+//
+// LLVM's line table lookup has to find the right sequence and then search its
+// rows each time, and then resolving the file name and the function
+// containing the address are separate searches. Symbolizing a backtrace does
+// this for every frame. This table is precomputed once from the line table
+// so each lookup is a single binary search.
+class AddressLineTable {
+ public:
+  struct Entry {
+    // Module-relative address range, end is non-inclusive.
+    uint64_t begin = 0;
+    uint64_t end = 0;
+
+    // Index into files().
+    uint32_t file = 0;
+
+    uint32_t line = 0;
+    uint32_t column = 0;
+
+    // Absolute offset of the DIE of the innermost function containing this
+    // range, or 0 if there is none.
+    uint32_t function_die_offset = 0;
+  };
+
+  AddressLineTable();
+
+  // The entries need not be sorted. Overlapping ranges are trimmed so the
+  // earliest-starting one wins, and adjacent entries with identical
+  // information are merged.
+  AddressLineTable(std::vector<Entry> entries, std::vector<std::string> files);
+
+  ~AddressLineTable();
+
+  AddressLineTable(AddressLineTable&&);
+  AddressLineTable& operator=(AddressLineTable&&);
+
+  const std::vector<Entry>& entries() const { return entries_; }
+  const std::vector<std::string>& files() const { return files_; }
+
+  // Returns the entry covering the given module-relative address, or null if
+  // there is none.
+  const Entry* Find(uint64_t relative_address) const;
+
+  // Returns the approximate number of bytes of memory used by the table.
+  size_t MemoryUsage() const;
+
+ private:
+  std::vector<Entry> entries_;  // Sorted by address, non-overlapping.
+  std::vector<std::string> files_;
+
+  FXL_DISALLOW_COPY_AND_ASSIGN(AddressLineTable);
+};
+
+// Holds the AddressLineTables for the most recently used compilation units.
+//
+// Building a table requires a pass over the unit's whole line table. A
+// backtrace normally hits the same few units many times so those stay cached,
+// while limiting the number of tables bounds the memory use.
+class AddressLineTableCache {
+ public:
+  using CreateCallback = std::function<AddressLineTable()>;
+
+  explicit AddressLineTableCache(size_t max_tables);
+  ~AddressLineTableCache();
+
+  size_t size() const { return lru_.size(); }
+
+  // Returns the table for the unit with the given offset, calling the
+  // callback to create it if it is not cached. The returned pointer is only
+  // valid until the next call to Get().
+  const AddressLineTable* Get(uint32_t unit_offset, const CreateCallback& cb);
+
+  void Clear();
+
+ private:
+  using LruList = std::list<std::pair<uint32_t, AddressLineTable>>;
+
+  const size_t max_tables_;
+
+  // Most recently used first.
+  LruList lru_;
+  std::map<uint32_t, LruList::iterator> tables_;
+
+  FXL_DISALLOW_COPY_AND_ASSIGN(AddressLineTableCache);
+};
+
+}  // namespace zxdb
@@ -0,0 +1,118 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/symbols/address_line_table.h"
+
+#include "gtest/gtest.h"
+
+namespace zxdb {
+
+namespace {
+
+using Entry = AddressLineTable::Entry;
+
+Entry MakeEntry(uint64_t begin, uint64_t end, uint32_t line,
+                uint32_t function_die_offset = 0) {
+  Entry entry;
+  entry.begin = begin;
+  entry.end = end;
+  entry.line = line;
+  entry.function_die_offset = function_die_offset;
+  return entry;
+}
+
+}  // namespace
+
+TEST(AddressLineTable, Empty) {
+  AddressLineTable table;
+  EXPECT_TRUE(table.entries().empty());
+  EXPECT_FALSE(table.Find(0));
+  EXPECT_FALSE(table.Find(0x1000));
+}
+
+TEST(AddressLineTable, Find) {
+  // Unsorted input with a gap between 0x20 and 0x30.
+  AddressLineTable table({MakeEntry(0x30, 0x40, 3), MakeEntry(0x10, 0x18, 1),
+                          MakeEntry(0x18, 0x20, 2)},
+                         {"file.cc"});
+  ASSERT_EQ(3u, table.entries().size());
+
+  EXPECT_FALSE(table.Find(0));
+  EXPECT_FALSE(table.Find(0xf));
+  EXPECT_EQ(1u, table.Find(0x10)->line);
+  EXPECT_EQ(1u, table.Find(0x17)->line);
+  EXPECT_EQ(2u, table.Find(0x18)->line);
+  EXPECT_EQ(2u, table.Find(0x1f)->line);
+  EXPECT_FALSE(table.Find(0x20));
+  EXPECT_FALSE(table.Find(0x2f));
+  EXPECT_EQ(3u, table.Find(0x30)->line);
+  EXPECT_EQ(3u, table.Find(0x3f)->line);
+  EXPECT_FALSE(table.Find(0x40));
+}
+
+TEST(AddressLineTable, MergeAndTrim) {
+  AddressLineTable table(
+      {
+          // These two are identical and adjacent so should be merged.
+          MakeEntry(0x10, 0x18, 1), MakeEntry(0x18, 0x20, 1),
+          // Same line but a different function, not merged.
+          MakeEntry(0x20, 0x28, 1, 0x100),
+          // Empty range, dropped.
+          MakeEntry(0x28, 0x28, 2),
+          // Overlaps the previous one, gets trimmed to start at 0x28.
+          MakeEntry(0x24, 0x30, 3),
+          // Completely covered by the previous one, dropped.
+          MakeEntry(0x29, 0x2a, 4),
+      },
+      {"file.cc"});
+  ASSERT_EQ(3u, table.entries().size());
+
+  EXPECT_EQ(0x10u, table.entries()[0].begin);
+  EXPECT_EQ(0x20u, table.entries()[0].end);
+  EXPECT_EQ(0x20u, table.entries()[1].begin);
+  EXPECT_EQ(0x28u, table.entries()[1].end);
+  EXPECT_EQ(0x100u, table.entries()[1].function_die_offset);
+  EXPECT_EQ(0x28u, table.entries()[2].begin);
+  EXPECT_EQ(0x30u, table.entries()[2].end);
+  EXPECT_EQ(3u, table.entries()[2].line);
+
+  EXPECT_EQ(3u, table.Find(0x29)->line);
+}
+
+TEST(AddressLineTableCache, Lru) {
+  AddressLineTableCache cache(2);
+
+  // Creates a table with one entry whose line is the given value, and counts
+  // how many have been created.
+  int create_count = 0;
+  auto creator = [&create_count](uint32_t line) {
+    return [&create_count, line]() {
+      create_count++;
+      return AddressLineTable({MakeEntry(0, 1, line)}, {"file.cc"});
+    };
+  };
+
+  EXPECT_EQ(1u, cache.Get(1, creator(1))->entries()[0].line);
+  EXPECT_EQ(2u, cache.Get(2, creator(2))->entries()[0].line);
+  EXPECT_EQ(2, create_count);
+  EXPECT_EQ(2u, cache.size());
+
+  // Cached, 1 becomes the most recently used.
+  EXPECT_EQ(1u, cache.Get(1, creator(100))->entries()[0].line);
+  EXPECT_EQ(2, create_count);
+
+  // Adding a third should evict 2.
+  EXPECT_EQ(3u, cache.Get(3, creator(3))->entries()[0].line);
+  EXPECT_EQ(3, create_count);
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(1u, cache.Get(1, creator(100))->entries()[0].line);
+  EXPECT_EQ(3, create_count);
+  EXPECT_EQ(22u, cache.Get(2, creator(22))->entries()[0].line);
+  EXPECT_EQ(4, create_count);
+
+  cache.Clear();
+  EXPECT_EQ(0u, cache.size());
+}
+
+}  // namespace zxdb
@@ -4,17 +4,272 @@
 
 #include "garnet/bin/zxdb/symbols/build_id_index.h"
 
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
 #include <filesystem>
+#include <mutex>
+#include <unordered_map>
 
+#include "garnet/bin/zxdb/common/file_util.h"
 #include "garnet/lib/debug_ipc/helper/elf.h"
+#include "lib/fxl/files/file.h"
 #include "lib/fxl/strings/string_printf.h"
 #include "lib/fxl/strings/string_view.h"
 #include "lib/fxl/strings/trim.h"
 
 namespace zxdb {
 
+namespace {
+
+// Placeholder written to the cache file for files that have no build ID so
+// they aren't re-read every time.
+const char kNoBuildID[] = "-";
+
+// Information about one file found in a symbol source directory. This is
+// also what's saved in the cache file.
+struct FileInfo {
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+
+  // Empty if the file isn't an ELF file with a build ID.
+  std::string build_id;
+};
+
+using FileInfoMap = std::unordered_map<std::string, FileInfo>;
+
+// The cache file has one line per file:
+//   <size> <mtime_ns> <build_id or "-"> <path>
+// The path is last since it may contain spaces.
+void LoadFileInfoCache(const std::string& cache_file, FileInfoMap* output) {
+  std::string contents;
+  if (cache_file.empty() || !files::ReadFileToString(cache_file, &contents))
+    return;
+
+  size_t line_begin = 0;
+  while (line_begin < contents.size()) {
+    size_t newline = contents.find('\n', line_begin);
+    if (newline == std::string::npos)
+      newline = contents.size();
+    std::string line = contents.substr(line_begin, newline - line_begin);
+    line_begin = newline + 1;
+
+    FileInfo info;
+    char build_id[128];
+    int path_offset = 0;
+    if (sscanf(line.c_str(), "%" SCNu64 " %" SCNd64 " %127s %n", &info.size,
+               &info.mtime_ns, build_id, &path_offset) != 3 ||
+        path_offset == 0 || static_cast<size_t>(path_offset) >= line.size())
+      continue;  // Corrupt line, ignore.
+
+    if (strcmp(build_id, kNoBuildID) != 0)
+      info.build_id = build_id;
+    (*output)[line.substr(path_offset)] = std::move(info);
+  }
+}
+
+void SaveFileInfoCache(const std::string& cache_file,
+                       const std::vector<std::string>& paths,
+                       const std::vector<FileInfo>& infos) {
+  std::string contents;
+  for (size_t i = 0; i < paths.size(); i++) {
+    // Files that could not be accessed have no timestamp to validate against.
+    if (infos[i].mtime_ns == 0)
+      continue;
+    contents.append(fxl::StringPrintf(
+        "%" PRIu64 " %" PRId64 " %s %s\n", infos[i].size, infos[i].mtime_ns,
+        infos[i].build_id.empty() ? kNoBuildID : infos[i].build_id.c_str(),
+        paths[i].c_str()));
+  }
+
+  // Write to a temporary file and move into place so other debugger instances
+  // never see a partial file.
+  std::error_code ec;
+  std::filesystem::create_directories(
+      std::filesystem::path(cache_file).parent_path(), ec);
+  std::string temp_file = fxl::StringPrintf("%s.%d.tmp", cache_file.c_str(),
+                                            static_cast<int>(getpid()));
+  if (files::WriteFile(temp_file, contents.data(), contents.size())) {
+    if (rename(temp_file.c_str(), cache_file.c_str()) != 0)
+      unlink(temp_file.c_str());
+  }
+}
+
+// Reads the build ID for the given file, using the cached value if the file
+// is unchanged.
+FileInfo GetFileInfo(const std::string& path, const FileInfoMap& cache) {
+  FileInfo info;
+  if (!GetFileSizeAndModificationTime(path, &info.size, &info.mtime_ns))
+    return FileInfo();
+
+  auto found = cache.find(path);
+  if (found != cache.end() && found->second.size == info.size &&
+      found->second.mtime_ns == info.mtime_ns)
+    return found->second;
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file) {
+    info.build_id = debug_ipc::ExtractBuildID(file);
+    fclose(file);
+  }
+  return info;
+}
+
+}  // namespace
+
+struct BuildIDIndex::ScanState {
+  // Inputs. These are not modified once the scan has started.
+  std::vector<std::string> build_id_files;
+  std::vector<std::string> sources;
+  std::string cache_file;
+
+  std::atomic<bool> cancelled{false};
+  std::atomic<size_t> files_scanned{0};
+  std::atomic<size_t> files_total{0};
+
+  // Set when Run() returns so the main thread can tell a finished scan from a
+  // running one without blocking.
+  std::atomic<bool> done{false};
+
+  // Protects the variables below which are written by the scanning thread.
+  std::mutex mutex;
+
+  // Status of the sources processed so far. This is appended to as sources
+  // complete so it can be reported while the scan is in progress.
+  StatusList status;
+
+  // Messages to report on the main thread.
+  std::vector<std::string> messages;
+
+  // Build IDs found. Valid once the scan is complete.
+  IDMap build_id_to_file;
+
+  void AddStatus(const std::string& source, int count) {
+    std::lock_guard<std::mutex> guard(mutex);
+    status.emplace_back(source, count);
+  }
+  void AddMessage(std::string msg) {
+    std::lock_guard<std::mutex> guard(mutex);
+    messages.push_back(std::move(msg));
+  }
+
+  // Performs the scan and sets |done|. This can be called on any thread.
+  void Run();
+
+  // Implementation of Run(). Returns early if cancelled.
+  void RunScan();
+  void LoadOneBuildIDFile(const std::string& file_name);
+};
+
+void BuildIDIndex::ScanState::Run() {
+  RunScan();
+  done = true;
+}
+
+void BuildIDIndex::ScanState::RunScan() {
+  for (const auto& build_id_file : build_id_files)
+    LoadOneBuildIDFile(build_id_file);
+
+  // Enumerate all files in the sources. Directories are not recursed into.
+  // Each source's files are contiguous in the list.
+  std::vector<std::string> paths;
+  std::vector<size_t> source_end;  // Index in paths after each source's files.
+  std::vector<bool> source_is_dir;
+  for (const auto& source : sources) {
+    bool is_dir = std::filesystem::is_directory(source);
+    source_is_dir.push_back(is_dir);
+    if (is_dir) {
+      std::error_code ec;
+      for (const auto& child :
+           std::filesystem::directory_iterator(source, ec))
+        paths.push_back(child.path());
+    } else {
+      paths.push_back(source);
+    }
+    source_end.push_back(paths.size());
+  }
+  files_total = paths.size();
+
+  FileInfoMap cache;
+  LoadFileInfoCache(cache_file, &cache);
+
+  // Read the files in parallel. Most of the time goes to waiting on I/O so
+  // this scales well even past the number of cores, but keep it simple.
+  std::vector<FileInfo> infos(paths.size());
+  std::atomic<size_t> next_path(0);
+  auto worker = [this, &paths, &infos, &next_path, &cache]() {
+    for (size_t i = next_path++; i < paths.size() && !cancelled;
+         i = next_path++) {
+      infos[i] = GetFileInfo(paths[i], cache);
+      files_scanned++;
+    }
+  };
+  int thread_count = std::max(
+      1, std::min(static_cast<int>(std::thread::hardware_concurrency()),
+                  static_cast<int>(paths.size())));
+  std::vector<std::thread> threads;
+  for (int i = 1; i < thread_count; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+
+  if (cancelled)
+    return;
+
+  // Collect the results in order so later files override earlier ones the
+  // same way regardless of scheduling.
+  IDMap found;
+  size_t path_index = 0;
+  for (size_t source_i = 0; source_i < sources.size(); source_i++) {
+    int indexed = 0;
+    for (; path_index < source_end[source_i]; path_index++) {
+      if (!infos[path_index].build_id.empty()) {
+        found[infos[path_index].build_id] = paths[path_index];
+        indexed++;
+      }
+    }
+    AddStatus(sources[source_i], indexed);
+    if (!source_is_dir[source_i] && !indexed) {
+      AddMessage(fxl::StringPrintf("Symbol file could not be loaded: %s",
+                                   sources[source_i].c_str()));
+    }
+  }
+
+  if (!cache_file.empty())
+    SaveFileInfoCache(cache_file, paths, infos);
+
+  std::lock_guard<std::mutex> guard(mutex);
+  for (auto& pair : found)
+    build_id_to_file[pair.first] = std::move(pair.second);
+}
+
+void BuildIDIndex::ScanState::LoadOneBuildIDFile(const std::string& file_name) {
+  std::string contents;
+  if (!files::ReadFileToString(file_name, &contents)) {
+    AddStatus(file_name, 0);
+    AddMessage("Can't read build ID file: " + file_name);
+    return;
+  }
+
+  IDMap ids;
+  int added = ParseIDs(contents, &ids);
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    build_id_to_file.insert(ids.begin(), ids.end());
+  }
+  AddStatus(file_name, added);
+  if (!added)
+    AddMessage("No mappings found in build ID file: " + file_name);
+}
+
 BuildIDIndex::BuildIDIndex() = default;
-BuildIDIndex::~BuildIDIndex() = default;
+
+BuildIDIndex::~BuildIDIndex() { CancelBackgroundScan(); }
 
 std::string BuildIDIndex::FileForBuildID(const std::string& build_id) {
   EnsureCacheClean();
@@ -44,12 +299,44 @@ void BuildIDIndex::AddSymbolSource(const std::string& path) {
   ClearCache();
 }
 
+void BuildIDIndex::SetCacheFile(const std::string& path) { cache_file_ = path; }
+
+void BuildIDIndex::StartBackgroundScan() {
+  if (!cache_dirty_ || scan_)
+    return;
+
+  scan_ = MakeScanState();
+  scan_thread_ = std::make_unique<std::thread>(
+      [state = scan_]() { state->Run(); });
+}
+
 BuildIDIndex::StatusList BuildIDIndex::GetStatus() {
+  if (scan_ && scan_->done)
+    FinishBackgroundScan();  // Won't block since the thread is exiting.
+  if (scan_) {
+    std::lock_guard<std::mutex> guard(scan_->mutex);
+    return scan_->status;
+  }
+
   EnsureCacheClean();
   return status_;
 }
 
+BuildIDIndex::ScanProgress BuildIDIndex::GetScanProgress() {
+  if (scan_ && scan_->done)
+    FinishBackgroundScan();  // Won't block since the thread is exiting.
+
+  ScanProgress progress;
+  if (scan_) {
+    progress.in_progress = true;
+    progress.files_scanned = scan_->files_scanned;
+    progress.files_total = scan_->files_total;
+  }
+  return progress;
+}
+
 void BuildIDIndex::ClearCache() {
+  CancelBackgroundScan();
   build_id_to_file_.clear();
   status_.clear();
   cache_dirty_ = true;
@@ -94,89 +381,59 @@ void BuildIDIndex::LogMessage(const std::string& msg) const {
     information_callback_(msg);
 }
 
-void BuildIDIndex::LoadOneBuildIDFile(const std::string& file_name) {
-  FILE* id_file = fopen(file_name.c_str(), "r");
-  if (!id_file) {
-  status_.emplace_back(file_name, 0);
-    LogMessage("Can't open build ID file: " + file_name);
-    return;
-  }
+std::shared_ptr<BuildIDIndex::ScanState> BuildIDIndex::MakeScanState() const {
+  auto state = std::make_shared<ScanState>();
+  state->build_id_files = build_id_files_;
+  state->sources = sources_;
+  state->cache_file = cache_file_;
+  return state;
+}
 
-  fseek(id_file, 0, SEEK_END);
-  long length = ftell(id_file);
-  if (length <= 0) {
-    status_.emplace_back(file_name, 0);
-    LogMessage("Can't load build ID file: " + file_name);
+void BuildIDIndex::FinishBackgroundScan() {
+  if (!scan_)
     return;
-  }
 
-  std::string contents;
-  contents.resize(length);
+  scan_thread_->join();
+  scan_thread_.reset();
 
-  fseek(id_file, 0, SEEK_SET);
-  if (fread(&contents[0], 1, contents.size(), id_file) !=
-      static_cast<size_t>(length)) {
-    status_.emplace_back(file_name, 0);
-    LogMessage("Can't read build ID file: " + file_name);
-    return;
-  }
+  std::shared_ptr<ScanState> state = std::move(scan_);
+  UseScanResults(state.get());
+}
 
-  fclose(id_file);
+void BuildIDIndex::CancelBackgroundScan() {
+  if (!scan_)
+    return;
 
-  int added = ParseIDs(contents, &build_id_to_file_);
-  status_.emplace_back(file_name, added);
-  if (!added)
-    LogMessage("No mappings found in build ID file: " + file_name);
+  scan_->cancelled = true;
+  scan_thread_->join();
+  scan_thread_.reset();
+  scan_.reset();
 }
 
-void BuildIDIndex::IndexOneSourcePath(const std::string& path) {
-  if (std::filesystem::is_directory(path)) {
-    // Iterate through all files in this directory, but don't recurse.
-    int indexed = 0;
-    for (const auto& child : std::filesystem::directory_iterator(path)) {
-      if (IndexOneSourceFile(child.path()))
-        indexed++;
-    }
-    status_.emplace_back(path, indexed);
-  } else {
-    if (IndexOneSourceFile(path)) {
-      status_.emplace_back(path, 1);
-    } else {
-      status_.emplace_back(path, 0);
-      LogMessage(fxl::StringPrintf("Symbol file could not be loaded: %s",
-                                   path.c_str()));
-    }
-  }
-}
+void BuildIDIndex::UseScanResults(ScanState* state) {
+  // The scanning thread is done so no locking is required.
+  build_id_to_file_ = std::move(state->build_id_to_file);
+  status_ = std::move(state->status);
+  for (const auto& msg : state->messages)
+    LogMessage(msg);
 
-bool BuildIDIndex::IndexOneSourceFile(const std::string& file_path) {
-  FILE* file = fopen(file_path.c_str(), "rb");
-  if (!file)
-    return false;
-  std::string build_id = debug_ipc::ExtractBuildID(file);
-  fclose(file);
+  for (const auto& mapping : manual_mappings_)
+    build_id_to_file_.insert(mapping);
 
-  if (!build_id.empty()) {
-    build_id_to_file_[build_id] = file_path;
-    return true;
-  }
-  return false;
+  cache_dirty_ = false;
 }
 
 void BuildIDIndex::EnsureCacheClean() {
+  if (scan_) {
+    FinishBackgroundScan();
+    return;
+  }
   if (!cache_dirty_)
     return;
 
-  for (const auto& build_id_file : build_id_files_)
-    LoadOneBuildIDFile(build_id_file);
-
-  for (const auto& source : sources_)
-    IndexOneSourcePath(source);
-
-  for (const auto& mapping : manual_mappings_)
-    build_id_to_file_.insert(mapping);
-
-  cache_dirty_ = false;
+  std::shared_ptr<ScanState> state = MakeScanState();
+  state->Run();
+  UseScanResults(state.get());
 }
 
 }  // namespace zxdb
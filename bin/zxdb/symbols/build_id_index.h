@@ -4,9 +4,13 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace zxdb {
@@ -17,6 +21,12 @@ namespace zxdb {
 // It can get files from different sources: an explicit ID mapping file, an
 // explicitly given elf file path, or a directory which it will scan for ELF
 // files and index.
+//
+// Scanning directories can be slow since every file must be opened to read
+// its ELF headers. To help, the scan can be started on a background thread
+// with StartBackgroundScan() (files are read in parallel), and the results
+// for each file can be saved to a cache file so that later sessions only need
+// to read files that have changed.
 class BuildIDIndex {
  public:
   using IDMap = std::map<std::string, std::string>;
@@ -24,14 +34,33 @@ class BuildIDIndex {
   // Lists symbol sources and the number of ELF files indexed at that location.
   using StatusList = std::vector<std::pair<std::string, int>>;
 
+  struct ScanProgress {
+    // Set when a background scan has been started and its results have not
+    // yet been used.
+    bool in_progress = false;
+
+    // Number of files in the symbol sources that have been checked, and the
+    // total number that need to be. The total is 0 until the directories have
+    // been enumerated.
+    size_t files_scanned = 0;
+    size_t files_total = 0;
+  };
+
   BuildIDIndex();
   ~BuildIDIndex();
 
   // Sets the callback for informational messages. Null callbacks are legal.
+  // The callback is always issued on the thread calling into this class.
   void set_information_callback(std::function<void(const std::string&)> fn) {
     information_callback_ = std::move(fn);
   }
 
+  // Sets the file used to save the build IDs of scanned files between
+  // sessions. Entries are keyed by path, size, and modification time so only
+  // files that have changed need to be read again. An empty string disables
+  // the cache (the default).
+  void SetCacheFile(const std::string& path);
+
   // Returns the local file name for the given build ID, or the empty string
   // if there is no match.
   std::string FileForBuildID(const std::string& build_id);
@@ -50,11 +79,26 @@ class BuildIDIndex {
   // If the path is a directory, all files in that directory will be indexed.
   void AddSymbolSource(const std::string& path);
 
+  // Starts scanning the symbol sources on a background thread if the cache
+  // needs updating and no scan is already in progress. The results will be
+  // used by the next query, which will wait for the scan to complete if
+  // necessary. Without this call, scanning happens synchronously on the first
+  // query.
+  void StartBackgroundScan();
+
   // Returns the status of the symbols. This will force the cache to be fresh
-  // so may cause I/O.
+  // so may cause I/O, unless a background scan is in progress. In that case,
+  // this will return the status of what has been loaded so far without
+  // blocking. Use GetScanProgress() to see how far along it is. A background
+  // scan that has finished will have its results used.
   StatusList GetStatus();
 
-  // Clears all cachehed build IDs. They will be reloaded when required.
+  // Returns the progress of any background scan. A scan that has finished
+  // will have its results used and be reported as not in progress.
+  ScanProgress GetScanProgress();
+
+  // Clears all cachehed build IDs. They will be reloaded when required. This
+  // will cancel any background scan.
   void ClearCache();
 
   // Parses a build ID maping file (ids.txt). This is a separate static
@@ -63,25 +107,40 @@ class BuildIDIndex {
   static int ParseIDs(const std::string& input, IDMap* output);
 
  private:
+  // The inputs and outputs of one scan. This is shared between the main
+  // thread and the background scanning thread. See build_id_index.cc.
+  struct ScanState;
+
   // Updates the build_id_to_file_ cache if necessary.
   void EnsureCacheClean();
 
-  // Logs an informational message.
-  void LogMessage(const std::string& msg) const;
+  // Creates a ScanState for the current sources.
+  std::shared_ptr<ScanState> MakeScanState() const;
 
-  // Adds all the mappings from the given build ID file to the index.
-  void LoadOneBuildIDFile(const std::string& file_name);
+  // Waits for any background scan and moves its results into the index. The
+  // cache will be clean after this call if there was a scan.
+  void FinishBackgroundScan();
 
-  // Adds all the mappings from the given file or directory to the index.
-  void IndexOneSourcePath(const std::string& path);
+  // Stops any background scan without using its results.
+  void CancelBackgroundScan();
 
-  // Indexes one ELF file and adds it to the index. Returns true if it was an
-  // ELF file and it was added to the index.
-  bool IndexOneSourceFile(const std::string& file_path);
+  // Moves the results of a completed scan into the index.
+  void UseScanResults(ScanState* state);
+
+  // Logs an informational message.
+  void LogMessage(const std::string& msg) const;
 
   // Function to output informational messages. May be null. Use LogMessage().
   std::function<void(const std::string&)> information_callback_;
 
+  // See SetCacheFile().
+  std::string cache_file_;
+
+  // Non-null when a background scan has been started and the results not
+  // yet consumed. The thread will be non-null if scan_ is.
+  std::shared_ptr<ScanState> scan_;
+  std::unique_ptr<std::thread> scan_thread_;
+
   std::vector<std::string> build_id_files_;
 
   // Either files or directories to index.
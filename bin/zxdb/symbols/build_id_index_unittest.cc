@@ -2,11 +2,19 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <inttypes.h>
+
+#include <chrono>
 #include <filesystem>
+#include <thread>
 
+#include "garnet/bin/zxdb/common/file_util.h"
 #include "garnet/bin/zxdb/common/host_util.h"
 #include "garnet/bin/zxdb/symbols/build_id_index.h"
 #include "gtest/gtest.h"
+#include "lib/fxl/files/file.h"
+#include "lib/fxl/files/scoped_temp_dir.h"
+#include "lib/fxl/strings/string_printf.h"
 
 namespace zxdb {
 
@@ -49,6 +57,77 @@ TEST(BuildIDIndex, IndexDir) {
   EXPECT_EQ(GetSmallTestFile(), index.FileForBuildID(kSmallTestBuildID));
 }
 
+// Index a directory on the background thread.
+TEST(BuildIDIndex, BackgroundScan) {
+  BuildIDIndex index;
+  index.AddSymbolSource(GetTestDataDir());
+  index.StartBackgroundScan();
+
+  // A finished scan should be reported as complete without any query having
+  // used its results.
+  while (index.GetScanProgress().in_progress)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  BuildIDIndex::StatusList status = index.GetStatus();
+  ASSERT_EQ(1u, status.size());
+  EXPECT_EQ(std::string(GetTestDataDir()), status[0].first);
+  EXPECT_LE(1, status[0].second);
+  EXPECT_EQ(GetSmallTestFile(), index.FileForBuildID(kSmallTestBuildID));
+
+  // Adding a new source should cancel any scan and make a new one possible.
+  index.StartBackgroundScan();
+  index.AddSymbolSource(GetSmallTestFile());
+  EXPECT_FALSE(index.GetScanProgress().in_progress);
+  index.StartBackgroundScan();
+  EXPECT_EQ(GetSmallTestFile(), index.FileForBuildID(kSmallTestBuildID));
+  EXPECT_EQ(2u, index.GetStatus().size());
+}
+
+// Tests that the build ID cache file is written and that its entries are used
+// for files that are unchanged.
+TEST(BuildIDIndex, CacheFile) {
+  files::ScopedTempDir temp_dir;
+  std::string symbol_dir = temp_dir.path() + "/symbols";
+  std::string cache_file = temp_dir.path() + "/cache/build_ids.txt";
+  std::filesystem::create_directory(symbol_dir);
+
+  std::string elf_file = symbol_dir + "/small_test_file.elf";
+  std::filesystem::copy_file(GetSmallTestFile(), elf_file);
+
+  // A file with no build ID.
+  std::string text_file = symbol_dir + "/file.txt";
+  ASSERT_TRUE(files::WriteFile(text_file, "hello", 5));
+
+  {
+    BuildIDIndex index;
+    index.SetCacheFile(cache_file);
+    index.AddSymbolSource(symbol_dir);
+    EXPECT_EQ(elf_file, index.FileForBuildID(kSmallTestBuildID));
+  }
+
+  std::string cache_contents;
+  ASSERT_TRUE(files::ReadFileToString(cache_file, &cache_contents));
+  EXPECT_NE(std::string::npos, cache_contents.find(kSmallTestBuildID));
+  EXPECT_NE(std::string::npos, cache_contents.find(" - " + text_file));
+
+  // Rewrite the entry for the text file to claim it has a build ID. Since
+  // the file is unchanged, the cached value should be trusted.
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+  ASSERT_TRUE(GetFileSizeAndModificationTime(text_file, &size, &mtime_ns));
+  std::string fake_cache =
+      fxl::StringPrintf("%" PRIu64 " %" PRId64 " fakebuildid %s\n", size,
+                        mtime_ns, text_file.c_str());
+  ASSERT_TRUE(
+      files::WriteFile(cache_file, fake_cache.data(), fake_cache.size()));
+
+  BuildIDIndex index;
+  index.SetCacheFile(cache_file);
+  index.AddSymbolSource(symbol_dir);
+  EXPECT_EQ(text_file, index.FileForBuildID("fakebuildid"));
+  EXPECT_EQ(elf_file, index.FileForBuildID(kSmallTestBuildID));
+}
+
 TEST(BuildIDIndex, ParseIDFile) {
   // Malformed line (no space) and empty line should be ignored. First one also
   // has two spaces separating which should be handled.
@@ -0,0 +1,346 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/symbols/compact_symbol_tree.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+#include "garnet/public/lib/fxl/logging.h"
+
+namespace zxdb {
+
+namespace {
+
+// Header for the serialized form. The arrays follow in order. The names are
+// padded with zeros to a multiple of 4 bytes so the DIE offsets are aligned.
+struct SerializedHeader {
+  uint32_t node_count = 0;
+  uint32_t names_size = 0;
+  uint32_t die_count = 0;
+};
+
+uint64_t PaddedNamesSize(uint32_t names_size) {
+  return (static_cast<uint64_t>(names_size) + 3) & ~static_cast<uint64_t>(3);
+}
+
+// Reads the header from the beginning of the serialized data. Returns the
+// size of the serialized tree, or 0 if the data is too short or has no root.
+uint64_t ReadSerializedHeader(const char* data, size_t size,
+                              size_t node_record_size,
+                              SerializedHeader* header) {
+  if (size < sizeof(SerializedHeader))
+    return 0;
+  memcpy(header, data, sizeof(SerializedHeader));
+
+  uint64_t needed =
+      sizeof(SerializedHeader) +
+      static_cast<uint64_t>(header->node_count) * node_record_size +
+      PaddedNamesSize(header->names_size) +
+      static_cast<uint64_t>(header->die_count) * sizeof(uint32_t);
+  if (header->node_count == 0 || needed > size)
+    return 0;
+  return needed;
+}
+
+}  // namespace
+
+// The DIE array of a serialized tree is used in place as DieRefs.
+static_assert(sizeof(CompactSymbolTree::DieRef) == sizeof(uint32_t),
+              "DieRef must be a bare offset");
+
+struct CompactSymbolTree::Arrays {
+  std::vector<NodeRecord> nodes;
+  std::string names;
+  std::vector<DieRef> dies;
+};
+
+// CompactSymbolTree::Node -----------------------------------------------------
+
+fxl::StringView CompactSymbolTree::Node::name() const {
+  const NodeRecord& record = tree_->RecordAt(index_);
+  return fxl::StringView(tree_->names_ + record.name_offset, record.name_size);
+}
+
+size_t CompactSymbolTree::Node::child_count() const {
+  return tree_->RecordAt(index_).child_count;
+}
+
+CompactSymbolTree::Node CompactSymbolTree::Node::child(size_t i) const {
+  const NodeRecord& record = tree_->RecordAt(index_);
+  FXL_DCHECK(i < record.child_count);
+  return Node(tree_, record.first_child + static_cast<uint32_t>(i));
+}
+
+CompactSymbolTree::Node CompactSymbolTree::Node::FindChild(
+    fxl::StringView name) const {
+  const NodeRecord& record = tree_->RecordAt(index_);
+  const CompactSymbolTree* tree = tree_;
+  auto record_name = [tree](uint32_t i) {
+    const NodeRecord& r = tree->RecordAt(i);
+    return fxl::StringView(tree->names_ + r.name_offset, r.name_size);
+  };
+
+  // Binary search of the children. Only the records visited are read.
+  uint32_t begin = record.first_child;
+  const uint32_t end = record.first_child + record.child_count;
+  uint32_t count = record.child_count;
+  while (count > 0) {
+    uint32_t step = count / 2;
+    if (record_name(begin + step) < name) {
+      begin += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+  if (begin == end || record_name(begin) != name)
+    return Node();
+  return Node(tree_, begin);
+}
+
+size_t CompactSymbolTree::Node::function_die_count() const {
+  return tree_->RecordAt(index_).die_count;
+}
+
+const CompactSymbolTree::DieRef* CompactSymbolTree::Node::function_dies()
+    const {
+  return tree_->dies_ + tree_->RecordAt(index_).first_die;
+}
+
+void CompactSymbolTree::Node::Dump(std::ostream& out, int indent_level) const {
+  // When printing the root node, only do the children.
+  for (size_t i = 0; i < child_count(); i++)
+    child(i).DumpWithName(out, indent_level);
+}
+
+std::string CompactSymbolTree::Node::AsString(int indent_level) const {
+  std::ostringstream out;
+  Dump(out, indent_level);
+  return out.str();
+}
+
+void CompactSymbolTree::Node::DumpWithName(std::ostream& out,
+                                           int indent_level) const {
+  out << std::string(indent_level * 2, ' ') << name();
+  if (function_die_count())
+    out << " (" << function_die_count() << ")";
+  out << std::endl;
+  for (size_t i = 0; i < child_count(); i++)
+    child(i).DumpWithName(out, indent_level + 1);
+}
+
+// CompactSymbolTree -----------------------------------------------------------
+
+CompactSymbolTree::CompactSymbolTree() {
+  auto arrays = std::make_shared<Arrays>();
+  arrays->nodes.emplace_back();
+  SetArrays(std::move(arrays));
+}
+
+CompactSymbolTree::CompactSymbolTree(const ModuleSymbolIndexNode& root) {
+  auto arrays = std::make_shared<Arrays>();
+  std::vector<NodeRecord>& nodes = arrays->nodes;
+  std::string& names = arrays->names;
+  std::vector<DieRef>& dies = arrays->dies;
+
+  // Maps names to their offset in names so each is stored once.
+  std::unordered_map<std::string, uint32_t> interned;
+
+  // Breadth-first traversal so the children of each node can be allocated
+  // contiguously. Each entry is the source node and the index of its record.
+  std::deque<std::pair<const ModuleSymbolIndexNode*, uint32_t>> queue;
+  nodes.emplace_back();
+  queue.emplace_back(&root, 0);
+
+  while (!queue.empty()) {
+    const ModuleSymbolIndexNode* src = queue.front().first;
+    uint32_t index = queue.front().second;
+    queue.pop_front();
+
+    // The records can move as the array grows so don't keep references.
+    nodes[index].first_die = static_cast<uint32_t>(dies.size());
+    nodes[index].die_count = static_cast<uint32_t>(src->function_dies().size());
+    dies.insert(dies.end(), src->function_dies().begin(),
+                src->function_dies().end());
+
+    nodes[index].first_child = static_cast<uint32_t>(nodes.size());
+    nodes[index].child_count = static_cast<uint32_t>(src->sub().size());
+
+    // The source map is already sorted by name.
+    for (const auto& pair : src->sub()) {
+      NodeRecord child;
+      auto inserted = interned.emplace(pair.first, names.size());
+      if (inserted.second)
+        names.append(pair.first);
+      child.name_offset = inserted.first->second;
+      child.name_size = static_cast<uint32_t>(pair.first.size());
+
+      queue.emplace_back(&pair.second, static_cast<uint32_t>(nodes.size()));
+      nodes.push_back(child);
+    }
+  }
+
+  nodes.shrink_to_fit();
+  names.shrink_to_fit();
+  dies.shrink_to_fit();
+  SetArrays(std::move(arrays));
+}
+
+CompactSymbolTree::~CompactSymbolTree() = default;
+
+CompactSymbolTree::CompactSymbolTree(CompactSymbolTree&&) = default;
+CompactSymbolTree& CompactSymbolTree::operator=(CompactSymbolTree&&) = default;
+
+size_t CompactSymbolTree::MemoryUsage() const {
+  return sizeof(CompactSymbolTree) + heap_bytes_;
+}
+
+void CompactSymbolTree::Serialize(std::string* output) const {
+  SerializedHeader header;
+  header.node_count = node_count_;
+  header.names_size = names_size_;
+  header.die_count = die_count_;
+
+  output->append(reinterpret_cast<const char*>(&header), sizeof(header));
+  output->append(reinterpret_cast<const char*>(nodes_),
+                 node_count_ * sizeof(NodeRecord));
+  output->append(names_, names_size_);
+  output->append(PaddedNamesSize(names_size_) - names_size_, '\0');
+  for (uint32_t i = 0; i < die_count_; i++) {
+    uint32_t offset = dies_[i].offset();
+    output->append(reinterpret_cast<const char*>(&offset), sizeof(offset));
+  }
+}
+
+bool CompactSymbolTree::Deserialize(const char* data, size_t size,
+                                    size_t* consumed) {
+  *this = CompactSymbolTree();
+
+  SerializedHeader header;
+  uint64_t needed =
+      ReadSerializedHeader(data, size, sizeof(NodeRecord), &header);
+  if (!needed)
+    return false;
+
+  auto arrays = std::make_shared<Arrays>();
+  const char* cur = data + sizeof(header);
+  arrays->nodes.resize(header.node_count);
+  memcpy(arrays->nodes.data(), cur, header.node_count * sizeof(NodeRecord));
+  cur += header.node_count * sizeof(NodeRecord);
+
+  arrays->names.assign(cur, header.names_size);
+  cur += PaddedNamesSize(header.names_size);
+
+  arrays->dies.reserve(header.die_count);
+  for (uint32_t i = 0; i < header.die_count; i++) {
+    uint32_t offset;
+    memcpy(&offset, cur, sizeof(offset));
+    cur += sizeof(offset);
+    arrays->dies.emplace_back(offset);
+  }
+  SetArrays(std::move(arrays));
+
+  if (!Validate()) {
+    *this = CompactSymbolTree();
+    return false;
+  }
+
+  *consumed = static_cast<size_t>(needed);
+  return true;
+}
+
+bool CompactSymbolTree::DeserializeInPlace(std::shared_ptr<const void> storage,
+                                           const char* data, size_t size,
+                                           size_t* consumed) {
+  *this = CompactSymbolTree();
+
+  if (reinterpret_cast<uintptr_t>(data) % alignof(NodeRecord) != 0)
+    return false;
+
+  SerializedHeader header;
+  uint64_t needed =
+      ReadSerializedHeader(data, size, sizeof(NodeRecord), &header);
+  if (!needed)
+    return false;
+
+  const char* cur = data + sizeof(header);
+  nodes_ = reinterpret_cast<const NodeRecord*>(cur);
+  node_count_ = header.node_count;
+  cur += header.node_count * sizeof(NodeRecord);
+
+  names_ = cur;
+  names_size_ = header.names_size;
+  cur += PaddedNamesSize(header.names_size);
+
+  dies_ = reinterpret_cast<const DieRef*>(cur);
+  die_count_ = header.die_count;
+
+  storage_ = std::move(storage);
+  heap_bytes_ = 0;
+
+  *consumed = static_cast<size_t>(needed);
+  return true;
+}
+
+void CompactSymbolTree::SetArrays(std::shared_ptr<Arrays> arrays) {
+  nodes_ = arrays->nodes.data();
+  node_count_ = static_cast<uint32_t>(arrays->nodes.size());
+  names_ = arrays->names.data();
+  names_size_ = static_cast<uint32_t>(arrays->names.size());
+  dies_ = arrays->dies.data();
+  die_count_ = static_cast<uint32_t>(arrays->dies.size());
+
+  heap_bytes_ = sizeof(Arrays) +
+                arrays->nodes.capacity() * sizeof(NodeRecord) +
+                arrays->names.capacity() +
+                arrays->dies.capacity() * sizeof(DieRef);
+  storage_ = std::move(arrays);
+}
+
+const CompactSymbolTree::NodeRecord& CompactSymbolTree::RecordAt(
+    uint32_t index) const {
+  static const NodeRecord kEmptyRecord;
+  if (!IsValidRecord(index))
+    return kEmptyRecord;
+  return nodes_[index];
+}
+
+bool CompactSymbolTree::IsValidRecord(uint32_t index) const {
+  if (index >= node_count_)
+    return false;
+
+  const NodeRecord& record = nodes_[index];
+  if (static_cast<uint64_t>(record.name_offset) + record.name_size >
+      names_size_)
+    return false;
+  if (static_cast<uint64_t>(record.first_die) + record.die_count > die_count_)
+    return false;
+
+  // Requiring children to follow their parent guarantees the tree has no
+  // cycles.
+  if (record.child_count &&
+      (record.first_child <= index ||
+       static_cast<uint64_t>(record.first_child) + record.child_count >
+           node_count_))
+    return false;
+  return true;
+}
+
+bool CompactSymbolTree::Validate() const {
+  if (node_count_ == 0)
+    return false;
+  for (uint32_t i = 0; i < node_count_; i++) {
+    if (!IsValidRecord(i))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace zxdb
@@ -0,0 +1,170 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "garnet/bin/zxdb/symbols/module_symbol_index_node.h"
+#include "garnet/public/lib/fxl/strings/string_view.h"
+
+namespace zxdb {
+
+// An immutable, flattened version of a ModuleSymbolIndexNode tree.
+//
+// ModuleSymbolIndexNode is convenient for building the index but it does one
+// heap allocation per node, per name, and per function list. For large
+// programs that's many millions of small allocations. Once indexing is
+// complete, the tree is converted to this form which uses three contiguous
+// arrays:
+//
+//   - All nodes. The children of each node are stored contiguously and sorted
+//     by name so lookup is a binary search.
+//   - A pool of node names. Identical names (common for things like "std" and
+//     method names like "Init") are stored once.
+//   - All function DieRefs. The DIEs for each node are stored contiguously.
+//
+// Since the arrays contain no pointers, they can also be written to and read
+// from disk directly (see ModuleSymbolIndex::Serialize()). A tree can refer to
+// serialized data in place, such as a memory-mapped cache file, so that only
+// the parts that are used are ever read (see DeserializeInPlace()).
+class CompactSymbolTree {
+ public:
+  using DieRef = ModuleSymbolIndexNode::DieRef;
+
+  // A lightweight reference to one node in the tree. It is only valid as long
+  // as the tree it came from is unmodified.
+  class Node {
+   public:
+    Node() = default;
+
+    bool is_valid() const { return !!tree_; }
+
+    // The root node has an empty name.
+    fxl::StringView name() const;
+
+    size_t child_count() const;
+    Node child(size_t i) const;
+
+    // Returns the child with the given name. The returned node will be
+    // invalid if there is no match.
+    Node FindChild(fxl::StringView name) const;
+
+    // The DIEs implementing functions with this node's name.
+    size_t function_die_count() const;
+    const DieRef* function_dies() const;
+
+    // Dump functions for debugging. These produce the same output as the
+    // ModuleSymbolIndexNode versions. When printing the root node, only the
+    // children are output.
+    void Dump(std::ostream& out, int indent_level = 0) const;
+
+    // AsString is useful only in small unit tests since even a small module
+    // can have many megabytes of dump.
+    std::string AsString(int indent_level = 0) const;
+
+   private:
+    friend CompactSymbolTree;
+
+    Node(const CompactSymbolTree* tree, uint32_t index)
+        : tree_(tree), index_(index) {}
+
+    void DumpWithName(std::ostream& out, int indent_level) const;
+
+    const CompactSymbolTree* tree_ = nullptr;
+    uint32_t index_ = 0;
+  };
+
+  // Creates an empty tree (containing only a root node).
+  CompactSymbolTree();
+
+  // Creates a tree with the contents of the given node and its children.
+  explicit CompactSymbolTree(const ModuleSymbolIndexNode& root);
+
+  ~CompactSymbolTree();
+
+  CompactSymbolTree(CompactSymbolTree&&);
+  CompactSymbolTree& operator=(CompactSymbolTree&&);
+
+  Node root() const { return Node(this, 0); }
+
+  size_t node_count() const { return node_count_; }
+  size_t function_die_count() const { return die_count_; }
+
+  // Returns the approximate number of bytes of heap memory used by the tree.
+  // This doesn't count data referenced in place.
+  size_t MemoryUsage() const;
+
+  // Appends the raw arrays to the given output. See Deserialize().
+  void Serialize(std::string* output) const;
+
+  // Replaces the contents with a copy of the output from a previous call to
+  // Serialize(). On success, returns true and sets |*consumed| to the number
+  // of bytes read. If the data is invalid, returns false and the tree will be
+  // empty.
+  bool Deserialize(const char* data, size_t size, size_t* consumed);
+
+  // Like Deserialize() but the tree refers to the data where it is rather than
+  // copying it. |storage| owns the data and is kept alive by the tree. The
+  // data must be aligned to 4 bytes.
+  //
+  // Only the sizes are checked up front so none of the arrays are read here.
+  // Each node is instead checked as it's used, and a node whose record is
+  // inconsistent appears empty.
+  bool DeserializeInPlace(std::shared_ptr<const void> storage,
+                          const char* data, size_t size, size_t* consumed);
+
+ private:
+  // Heap storage for trees that aren't referring to serialized data.
+  struct Arrays;
+
+  struct NodeRecord {
+    // Location of the name in names_.
+    uint32_t name_offset = 0;
+    uint32_t name_size = 0;
+
+    // Range of children in nodes_. Children always come after the parent in
+    // the array.
+    uint32_t first_child = 0;
+    uint32_t child_count = 0;
+
+    // Range of function DIEs in dies_.
+    uint32_t first_die = 0;
+    uint32_t die_count = 0;
+  };
+
+  // Points the arrays at the given storage.
+  void SetArrays(std::shared_ptr<Arrays> arrays);
+
+  // Returns the record for the given node. If the record refers outside of
+  // the arrays, returns an empty record.
+  const NodeRecord& RecordAt(uint32_t index) const;
+
+  // Returns true if the given record is consistent with the arrays.
+  bool IsValidRecord(uint32_t index) const;
+
+  // Returns true if the arrays are internally consistent. This is used to
+  // validate untrusted data from Deserialize().
+  bool Validate() const;
+
+  // Keeps the arrays below alive. This is either an Arrays or the storage
+  // passed to DeserializeInPlace().
+  std::shared_ptr<const void> storage_;
+  size_t heap_bytes_ = 0;
+
+  // nodes_[0] is always the root.
+  const NodeRecord* nodes_ = nullptr;
+  uint32_t node_count_ = 0;
+  const char* names_ = nullptr;
+  uint32_t names_size_ = 0;
+  const DieRef* dies_ = nullptr;
+  uint32_t die_count_ = 0;
+};
+
+}  // namespace zxdb
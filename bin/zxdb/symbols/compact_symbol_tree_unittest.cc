@@ -0,0 +1,179 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/symbols/compact_symbol_tree.h"
+
+#include <string.h>
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+namespace zxdb {
+
+namespace {
+
+using DieRef = ModuleSymbolIndexNode::DieRef;
+
+// Builds the tree:
+//   [root]
+//     foo
+//       bar [1 function = #10]
+//       Init [1 function = #20]
+//     Init [2 functions = #30, #40]
+//     zzz
+//       foo [1 function = #50]
+ModuleSymbolIndexNode MakeTestTree() {
+  ModuleSymbolIndexNode root;
+  ModuleSymbolIndexNode* foo = root.AddChild("foo");
+  foo->AddChild("bar")->AddFunctionDie(DieRef(10));
+  foo->AddChild("Init")->AddFunctionDie(DieRef(20));
+
+  ModuleSymbolIndexNode* init = root.AddChild("Init");
+  init->AddFunctionDie(DieRef(30));
+  init->AddFunctionDie(DieRef(40));
+
+  root.AddChild("zzz")->AddChild("foo")->AddFunctionDie(DieRef(50));
+  return root;
+}
+
+}  // namespace
+
+TEST(CompactSymbolTree, Empty) {
+  CompactSymbolTree tree;
+  EXPECT_EQ(1u, tree.node_count());
+  EXPECT_EQ(0u, tree.function_die_count());
+  EXPECT_EQ(0u, tree.root().child_count());
+  EXPECT_FALSE(tree.root().FindChild("foo").is_valid());
+}
+
+TEST(CompactSymbolTree, Build) {
+  ModuleSymbolIndexNode source = MakeTestTree();
+  CompactSymbolTree tree(source);
+
+  EXPECT_EQ(7u, tree.node_count());
+  EXPECT_EQ(5u, tree.function_die_count());
+
+  // Dumps should be identical.
+  EXPECT_EQ(source.AsString(), tree.root().AsString());
+
+  // Children are sorted.
+  CompactSymbolTree::Node root = tree.root();
+  ASSERT_EQ(3u, root.child_count());
+  EXPECT_EQ("Init", root.child(0).name());
+  EXPECT_EQ("foo", root.child(1).name());
+  EXPECT_EQ("zzz", root.child(2).name());
+
+  CompactSymbolTree::Node init = root.FindChild("Init");
+  ASSERT_TRUE(init.is_valid());
+  ASSERT_EQ(2u, init.function_die_count());
+  EXPECT_EQ(30u, init.function_dies()[0].offset());
+  EXPECT_EQ(40u, init.function_dies()[1].offset());
+
+  CompactSymbolTree::Node foo_init = root.FindChild("foo").FindChild("Init");
+  ASSERT_TRUE(foo_init.is_valid());
+  ASSERT_EQ(1u, foo_init.function_die_count());
+  EXPECT_EQ(20u, foo_init.function_dies()[0].offset());
+
+  CompactSymbolTree::Node zzz_foo = root.FindChild("zzz").FindChild("foo");
+  ASSERT_TRUE(zzz_foo.is_valid());
+  ASSERT_EQ(1u, zzz_foo.function_die_count());
+  EXPECT_EQ(50u, zzz_foo.function_dies()[0].offset());
+
+  EXPECT_FALSE(root.FindChild("bar").is_valid());
+  EXPECT_FALSE(root.FindChild("").is_valid());
+  EXPECT_FALSE(root.FindChild("zzzz").is_valid());
+}
+
+TEST(CompactSymbolTree, Serialize) {
+  CompactSymbolTree tree(MakeTestTree());
+
+  std::string serialized;
+  tree.Serialize(&serialized);
+
+  // Extra data at the end should not be consumed.
+  serialized.append("extra");
+
+  CompactSymbolTree loaded;
+  size_t consumed = 0;
+  ASSERT_TRUE(
+      loaded.Deserialize(serialized.data(), serialized.size(), &consumed));
+  EXPECT_EQ(serialized.size() - 5, consumed);
+  EXPECT_EQ(tree.root().AsString(), loaded.root().AsString());
+
+  // Truncated data should fail.
+  EXPECT_FALSE(loaded.Deserialize(serialized.data(), consumed - 1, &consumed));
+  EXPECT_EQ(1u, loaded.node_count());
+}
+
+TEST(CompactSymbolTree, DeserializeInPlace) {
+  CompactSymbolTree tree(MakeTestTree());
+
+  auto serialized = std::make_shared<std::string>();
+  tree.Serialize(serialized.get());
+  const size_t serialized_size = serialized->size();
+  serialized->append("extra");
+
+  CompactSymbolTree loaded;
+  size_t consumed = 0;
+  ASSERT_TRUE(loaded.DeserializeInPlace(serialized, serialized->data(),
+                                        serialized->size(), &consumed));
+  EXPECT_EQ(serialized_size, consumed);
+  EXPECT_EQ(tree.root().AsString(), loaded.root().AsString());
+  EXPECT_EQ(20u, loaded.root().FindChild("foo").FindChild("Init")
+                     .function_dies()[0].offset());
+
+  // The arrays are used where they are rather than copied.
+  EXPECT_LT(loaded.MemoryUsage(), tree.MemoryUsage());
+
+  // The tree keeps the data alive, and can be serialized again.
+  const char* data = serialized->data();
+  std::weak_ptr<std::string> weak_serialized = serialized;
+  serialized.reset();
+  EXPECT_FALSE(weak_serialized.expired());
+  std::string reserialized;
+  loaded.Serialize(&reserialized);
+  EXPECT_EQ(std::string(data, serialized_size), reserialized);
+
+  // Truncated and misaligned data should fail.
+  auto copy = std::make_shared<std::string>(reserialized);
+  EXPECT_FALSE(loaded.DeserializeInPlace(copy, copy->data(), consumed - 1,
+                                         &consumed));
+  EXPECT_EQ(1u, loaded.node_count());
+  copy->insert(0, 1, '\0');
+  EXPECT_FALSE(loaded.DeserializeInPlace(copy, &(*copy)[1], copy->size() - 1,
+                                         &consumed));
+}
+
+// Records are only checked when they're used in place, so a corrupt record
+// should make that node appear empty without affecting the others.
+TEST(CompactSymbolTree, DeserializeInPlaceCorrupt) {
+  auto serialized = std::make_shared<std::string>();
+  CompactSymbolTree(MakeTestTree()).Serialize(serialized.get());
+
+  // Point the name of the first child ("Init") outside of the name pool. The
+  // header is 3 words and each node record is 6.
+  uint32_t bad_offset = 0xffffffff;
+  memcpy(&(*serialized)[(3 + 6) * sizeof(uint32_t)], &bad_offset,
+         sizeof(bad_offset));
+
+  CompactSymbolTree loaded;
+  size_t consumed = 0;
+  ASSERT_TRUE(loaded.DeserializeInPlace(serialized, serialized->data(),
+                                        serialized->size(), &consumed));
+
+  CompactSymbolTree::Node root = loaded.root();
+  ASSERT_EQ(3u, root.child_count());
+  EXPECT_EQ("", root.child(0).name());
+  EXPECT_EQ(0u, root.child(0).function_die_count());
+  EXPECT_FALSE(root.FindChild("Init").is_valid());
+  EXPECT_TRUE(root.FindChild("foo").FindChild("bar").is_valid());
+  EXPECT_TRUE(root.FindChild("zzz").is_valid());
+
+  // Copying validates everything up front.
+  EXPECT_FALSE(
+      loaded.Deserialize(serialized->data(), serialized->size(), &consumed));
+}
+
+}  // namespace zxdb
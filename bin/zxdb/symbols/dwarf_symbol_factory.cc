@@ -222,8 +222,12 @@ fxl::RefPtr<Symbol> DwarfSymbolFactory::DecodeSymbol(
 }
 
 LazySymbol DwarfSymbolFactory::MakeLazy(const llvm::DWARFDie& die) {
-  return LazySymbol(fxl::RefPtr<SymbolFactory>(this), die.getDwarfUnit(),
-                    die.getOffset());
+  return MakeLazy(die.getDwarfUnit(), die.getOffset());
+}
+
+LazySymbol DwarfSymbolFactory::MakeLazy(llvm::DWARFUnit* unit,
+                                        uint32_t die_offset) {
+  return LazySymbol(fxl::RefPtr<SymbolFactory>(this), unit, die_offset);
 }
 
 fxl::RefPtr<Symbol> DwarfSymbolFactory::DecodeFunction(
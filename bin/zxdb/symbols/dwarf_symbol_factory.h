@@ -7,6 +7,7 @@
 
 namespace llvm {
 class DWARFDie;
+class DWARFUnit;
 }  // namespace llvm
 
 namespace zxdb {
@@ -28,6 +29,11 @@ class DwarfSymbolFactory : public SymbolFactory {
   // Returns a LazySymbol referencing the given DIE.
   LazySymbol MakeLazy(const llvm::DWARFDie& die);
 
+  // Returns a LazySymbol referencing the DIE at the given absolute offset in
+  // the given unit. This avoids looking up the DIE when only the offset is
+  // known.
+  LazySymbol MakeLazy(llvm::DWARFUnit* unit, uint32_t die_offset);
+
  private:
   // Internal version that creates a symbol from a Die.
   fxl::RefPtr<Symbol> DecodeSymbol(const llvm::DWARFDie& die);
@@ -7,6 +7,7 @@
 #include "garnet/bin/zxdb/symbols/input_location.h"
 #include "garnet/bin/zxdb/symbols/line_details.h"
 #include "garnet/bin/zxdb/symbols/location.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
 
 namespace zxdb {
 
@@ -70,4 +71,16 @@ std::vector<std::string> MockModuleSymbols::FindFileMatches(
   return std::vector<std::string>();
 }
 
+std::vector<std::string> MockModuleSymbols::SearchFunctionNames(
+    const SymbolSearchQuery& query) const {
+  std::vector<std::string> result;
+  for (const auto& pair : symbols_) {
+    if (query.max_results && result.size() == query.max_results)
+      break;
+    if (query.Matches(pair.first))
+      result.push_back(pair.first);
+  }
+  return result;
+}
+
 }  // namespace zxdb
@@ -32,6 +32,8 @@ class MockModuleSymbols : public ModuleSymbols {
                                     uint64_t address) const override;
   std::vector<std::string> FindFileMatches(
       const std::string& name) const override;
+  std::vector<std::string> SearchFunctionNames(
+      const SymbolSearchQuery& query) const override;
 
  private:
   std::string local_file_name_;
@@ -8,6 +8,7 @@
 #include "garnet/bin/zxdb/symbols/line_details.h"
 #include "garnet/bin/zxdb/symbols/location.h"
 #include "garnet/bin/zxdb/symbols/module_symbol_status.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
 
 namespace zxdb {
 
@@ -52,6 +53,18 @@ LineDetails MockProcessSymbols::LineDetailsForAddress(uint64_t address) const {
   return LineDetails();
 }
 
+std::vector<std::string> MockProcessSymbols::SearchFunctionNames(
+    const SymbolSearchQuery& query) const {
+  std::vector<std::string> result;
+  for (const auto& pair : symbols_) {
+    if (query.max_results && result.size() == query.max_results)
+      break;
+    if (query.Matches(pair.first))
+      result.push_back(pair.first);
+  }
+  return result;
+}
+
 bool MockProcessSymbols::HaveSymbolsLoadedForModuleAt(uint64_t address) const {
   return false;
 }
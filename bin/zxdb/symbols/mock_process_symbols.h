@@ -28,6 +28,8 @@ class MockProcessSymbols : public ProcessSymbols {
       const InputLocation& input_location,
       const ResolveOptions& options) const override;
   LineDetails LineDetailsForAddress(uint64_t address) const override;
+  std::vector<std::string> SearchFunctionNames(
+      const SymbolSearchQuery& query) const override;
   bool HaveSymbolsLoadedForModuleAt(uint64_t address) const override;
 
  private:
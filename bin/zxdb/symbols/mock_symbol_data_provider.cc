@@ -87,4 +87,10 @@ void MockSymbolDataProvider::GetMemoryAsync(uint64_t address, uint32_t size,
   }
 }
 
+void MockSymbolDataProvider::PrefetchMemory(
+    const std::vector<AddressRange>& ranges) {
+  prefetched_ranges_.insert(prefetched_ranges_.end(), ranges.begin(),
+                            ranges.end());
+}
+
 }  // namespace zxdb
@@ -29,12 +29,18 @@ class MockSymbolDataProvider : public SymbolDataProvider {
   // random subranges inside these.
   void AddMemory(uint64_t address, std::vector<uint8_t> data);
 
+  // All ranges passed to PrefetchMemory() so far.
+  const std::vector<AddressRange>& prefetched_ranges() const {
+    return prefetched_ranges_;
+  }
+
   // SymbolDataProvider implementation.
   bool GetRegister(int dwarf_register_number, uint64_t* output) override;
   void GetRegisterAsync(int dwarf_register_number,
                         GetRegisterCallback callback) override;
   void GetMemoryAsync(uint64_t address, uint32_t size,
                       GetMemoryCallback callback) override;
+  void PrefetchMemory(const std::vector<AddressRange>& ranges) override;
 
  private:
   struct RegData {
@@ -51,6 +57,8 @@ class MockSymbolDataProvider : public SymbolDataProvider {
 
   std::map<uint64_t, std::vector<uint8_t>> mem_;
 
+  std::vector<AddressRange> prefetched_ranges_;
+
   fxl::WeakPtrFactory<MockSymbolDataProvider> weak_factory_;
 };
 
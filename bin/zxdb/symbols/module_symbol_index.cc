@@ -4,12 +4,18 @@
 
 #include "garnet/bin/zxdb/symbols/module_symbol_index.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
 #include <limits>
+#include <thread>
 
 #include "garnet/bin/zxdb/common/file_util.h"
 #include "garnet/bin/zxdb/common/string_util.h"
 #include "garnet/bin/zxdb/symbols/dwarf_die_decoder.h"
 #include "garnet/bin/zxdb/symbols/module_symbol_index_node.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_index.h"
 #include "garnet/public/lib/fxl/logging.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugLine.h"
@@ -73,6 +79,12 @@ struct FunctionImpl {
 // Index used to indicate there is no parent.
 constexpr unsigned kNoParent = std::numeric_limits<unsigned>::max();
 
+// When indexing in parallel, the compile units are split into this many
+// contiguous chunks per thread. Compile units vary wildly in size so having
+// more chunks than threads keeps the threads busy when some chunks contain
+// a few very large units.
+constexpr unsigned kChunksPerIndexingThread = 8;
+
 // Returns true if the given abbreviation defines a PC range.
 bool AbbrevHasCode(const llvm::DWARFAbbreviationDeclaration* abbrev) {
   for (const auto spec : abbrev->attributes()) {
@@ -83,12 +95,60 @@ bool AbbrevHasCode(const llvm::DWARFAbbreviationDeclaration* abbrev) {
   return false;
 }
 
-size_t RecursiveCountFunctionDies(const ModuleSymbolIndexNode& node) {
-  size_t result = node.function_dies().size();
-  for (const auto& pair : node.sub())
-    result += RecursiveCountFunctionDies(pair.second);
-  return result;
-}
+// Serialization helpers for ModuleSymbolIndex::[De]Serialize(). The data is
+// written in host byte order since the cache is specific to one computer.
+//
+// The serialized index is the CompactSymbolTree data followed by the file
+// index:
+//   uint32_t file_count
+//   { string name, uint32_t unit_count, uint32_t unit_index[unit_count] }
+//       [file_count]
+//
+// Strings are a uint32_t length followed by that many bytes.
+class IndexWriter {
+ public:
+  explicit IndexWriter(std::string* output) : output_(output) {}
+
+  void WriteUint32(uint32_t value) {
+    output_->append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void WriteString(const std::string& str) {
+    WriteUint32(static_cast<uint32_t>(str.size()));
+    output_->append(str);
+  }
+
+ private:
+  std::string* output_;
+};
+
+class IndexReader {
+ public:
+  IndexReader(const char* data, size_t size, size_t offset)
+      : data_(data), size_(size), offset_(offset) {}
+
+  bool at_end() const { return offset_ == size_; }
+
+  bool ReadUint32(uint32_t* output) {
+    if (size_ - offset_ < sizeof(uint32_t))
+      return false;
+    memcpy(output, &data_[offset_], sizeof(uint32_t));
+    offset_ += sizeof(uint32_t);
+    return true;
+  }
+  bool ReadString(std::string* output) {
+    uint32_t len;
+    if (!ReadUint32(&len) || size_ - offset_ < len)
+      return false;
+    output->assign(&data_[offset_], len);
+    offset_ += len;
+    return true;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+  size_t offset_;
+};
 
 // Step 1 of the algorithm above. Fills the function_impls array with the
 // information for all function implementations (ones with addresses). Fills
@@ -281,7 +341,8 @@ class FunctionImplIndexer {
 ModuleSymbolIndex::ModuleSymbolIndex() = default;
 ModuleSymbolIndex::~ModuleSymbolIndex() = default;
 
-void ModuleSymbolIndex::CreateIndex(llvm::object::ObjectFile* object_file) {
+void ModuleSymbolIndex::CreateIndex(llvm::object::ObjectFile* object_file,
+                                    int thread_count) {
   std::unique_ptr<llvm::DWARFContext> context = llvm::DWARFContext::create(
       *object_file, nullptr, llvm::DWARFContext::defaultErrorHandler);
 
@@ -289,23 +350,52 @@ void ModuleSymbolIndex::CreateIndex(llvm::object::ObjectFile* object_file) {
   compile_units.addUnitsForSection(
       *context, context->getDWARFObj().getInfoSection(), llvm::DW_SECT_INFO);
 
-  for (unsigned i = 0; i < compile_units.size(); i++) {
-    IndexCompileUnit(context.get(), compile_units[i].get(), i);
-
-    // Free all compilation units as we process them. They will hold all of
-    // the parsed DIE data that we don't need any more which can be mutliple
-    // GB's for large programs.
-    compile_units[i].reset();
+  if (thread_count <= 0) {
+    thread_count =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  thread_count =
+      std::min(thread_count, static_cast<int>(compile_units.size()));
+
+  ModuleSymbolIndexNode root;
+  if (thread_count > 1) {
+    IndexCompileUnitsInParallel(context.get(), &compile_units, thread_count,
+                                &root);
+  } else {
+    for (unsigned i = 0; i < compile_units.size(); i++) {
+      IndexCompileUnit(context.get(), compile_units[i].get(), i, &root,
+                       &files_, nullptr);
+
+      // Free all compilation units as we process them. They will hold all of
+      // the parsed DIE data that we don't need any more which can be mutliple
+      // GB's for large programs.
+      compile_units[i].reset();
+    }
   }
 
+  tree_ = CompactSymbolTree(root);
+  search_index_ = std::make_unique<SymbolSearchIndex>(tree_.root());
+  lazy_search_index_ = false;
   IndexFileNames();
 }
 
-size_t ModuleSymbolIndex::CountSymbolsIndexed() const {
-  return RecursiveCountFunctionDies(root_);
+size_t ModuleSymbolIndex::MemoryUsage() const {
+  // The file maps are estimated assuming typical tree node overhead.
+  constexpr size_t kMapNodeOverhead = 4 * sizeof(void*);
+
+  size_t result = tree_.MemoryUsage();
+  if (search_index_)
+    result += search_index_->MemoryUsage();
+  for (const auto& pair : files_) {
+    result += kMapNodeOverhead + sizeof(pair) + pair.first.capacity() +
+              pair.second.capacity() * sizeof(unsigned);
+  }
+  result += file_name_index_.size() *
+            (kMapNodeOverhead + sizeof(FileNameIndex::value_type));
+  return result;
 }
 
-const std::vector<ModuleSymbolIndexNode::DieRef>&
+std::vector<ModuleSymbolIndexNode::DieRef>
 ModuleSymbolIndex::FindFunctionExact(const std::string& input) const {
   // Split the input on "::" which we'll traverse the tree with.
   //
@@ -314,31 +404,38 @@ ModuleSymbolIndex::FindFunctionExact(const std::string& input) const {
   // "std::vector<Foo::Bar>::insert".
   std::string separator("::");
 
-  const ModuleSymbolIndexNode* cur = &root_;
+  CompactSymbolTree::Node cur = tree_.root();
 
   size_t input_index = 0;
   while (input_index < input.size()) {
     size_t next = input.find(separator, input_index);
 
-    std::string cur_name;
+    fxl::StringView cur_name;
     if (next == std::string::npos) {
-      cur_name = input.substr(input_index);
+      cur_name =
+          fxl::StringView(&input[input_index], input.size() - input_index);
       input_index = input.size();
     } else {
-      cur_name = input.substr(input_index, next - input_index);
+      cur_name = fxl::StringView(&input[input_index], next - input_index);
       input_index = next + separator.size();  // Skip over "::".
     }
 
-    auto found = cur->sub().find(cur_name);
-    if (found == cur->sub().end()) {
-      static std::vector<ModuleSymbolIndexNode::DieRef> empty_vector;
-      return empty_vector;
-    }
-
-    cur = &found->second;
+    cur = cur.FindChild(cur_name);
+    if (!cur.is_valid())
+      return std::vector<ModuleSymbolIndexNode::DieRef>();
   }
 
-  return cur->function_dies();
+  return std::vector<ModuleSymbolIndexNode::DieRef>(
+      cur.function_dies(), cur.function_dies() + cur.function_die_count());
+}
+
+std::vector<std::string> ModuleSymbolIndex::SearchFunctionNames(
+    const SymbolSearchQuery& query) const {
+  if (!search_index_ && lazy_search_index_)
+    search_index_ = std::make_unique<SymbolSearchIndex>(tree_.root());
+  if (!search_index_)
+    return std::vector<std::string>();
+  return search_index_->Search(query);
 }
 
 std::vector<std::string> ModuleSymbolIndex::FindFileMatches(
@@ -380,9 +477,13 @@ void ModuleSymbolIndex::DumpFileIndex(std::ostream& out) {
   }
 }
 
+// static
 void ModuleSymbolIndex::IndexCompileUnit(llvm::DWARFContext* context,
                                          llvm::DWARFUnit* unit,
-                                         unsigned unit_index) {
+                                         unsigned unit_index,
+                                         ModuleSymbolIndexNode* root,
+                                         FileIndex* files,
+                                         std::mutex* context_lock) {
   // Find the things to index.
   std::vector<FunctionImpl> function_impls;
   function_impls.reserve(256);
@@ -391,18 +492,28 @@ void ModuleSymbolIndex::IndexCompileUnit(llvm::DWARFContext* context,
                                      &parent_indices);
 
   // Index each one.
-  FunctionImplIndexer indexer(context, unit, parent_indices, &root_);
+  FunctionImplIndexer indexer(context, unit, parent_indices, root);
   for (const FunctionImpl& impl : function_impls)
     indexer.AddFunction(impl);
 
-  IndexCompileUnitSourceFiles(context, unit, unit_index);
+  IndexCompileUnitSourceFiles(context, unit, unit_index, files, context_lock);
 }
 
-void ModuleSymbolIndex::IndexCompileUnitSourceFiles(llvm::DWARFContext* context,
-                                                    llvm::DWARFUnit* unit,
-                                                    unsigned unit_index) {
-  const llvm::DWARFDebugLine::LineTable* line_table =
-      context->getLineTableForUnit(unit);
+// static
+void ModuleSymbolIndex::IndexCompileUnitSourceFiles(
+    llvm::DWARFContext* context, llvm::DWARFUnit* unit, unsigned unit_index,
+    FileIndex* files, std::mutex* context_lock) {
+  // The context lazily parses and caches line tables in a map so lookups
+  // must be serialized. The returned table itself is immutable.
+  const llvm::DWARFDebugLine::LineTable* line_table;
+  if (context_lock) {
+    std::lock_guard<std::mutex> guard(*context_lock);
+    line_table = context->getLineTableForUnit(unit);
+  } else {
+    line_table = context->getLineTableForUnit(unit);
+  }
+  if (!line_table)
+    return;
   const char* compilation_dir = unit->getCompilationDir();
 
   // This table is the size of the file name table. Entries are set to 1 when
@@ -434,9 +545,154 @@ void ModuleSymbolIndex::IndexCompileUnitSourceFiles(llvm::DWARFContext* context,
         // "/foo/bar/../baz". This is OK because we want it to match other
         // places in the symbol code that do a similar computation to get a
         // file name.
-        files_[file_name].push_back(unit_index);
+        (*files)[file_name].push_back(unit_index);
+      }
+    }
+  }
+}
+
+void ModuleSymbolIndex::Serialize(std::string* output) const {
+  tree_.Serialize(output);
+
+  IndexWriter writer(output);
+
+  writer.WriteUint32(static_cast<uint32_t>(files_.size()));
+  for (const auto& pair : files_) {
+    writer.WriteString(pair.first);
+    writer.WriteUint32(static_cast<uint32_t>(pair.second.size()));
+    for (unsigned unit_index : pair.second)
+      writer.WriteUint32(unit_index);
+  }
+}
+
+bool ModuleSymbolIndex::Deserialize(const char* data, size_t size) {
+  return DoDeserialize(nullptr, data, size);
+}
+
+bool ModuleSymbolIndex::DeserializeInPlace(std::shared_ptr<const void> storage,
+                                           const char* data, size_t size) {
+  FXL_DCHECK(storage);
+  return DoDeserialize(std::move(storage), data, size);
+}
+
+bool ModuleSymbolIndex::DoDeserialize(std::shared_ptr<const void> storage,
+                                      const char* data, size_t size) {
+  files_.clear();
+  file_name_index_.clear();
+  search_index_.reset();
+  lazy_search_index_ = false;
+
+  size_t tree_size = 0;
+  const bool in_place = !!storage;
+  bool loaded = in_place ? tree_.DeserializeInPlace(std::move(storage), data,
+                                                    size, &tree_size)
+                         : tree_.Deserialize(data, size, &tree_size);
+  if (!loaded)
+    return false;
+
+  IndexReader reader(data, size, tree_size);
+  uint32_t file_count = 0;
+  bool success = reader.ReadUint32(&file_count);
+  for (uint32_t file_i = 0; success && file_i < file_count; file_i++) {
+    std::string name;
+    uint32_t unit_count = 0;
+    success = reader.ReadString(&name) && reader.ReadUint32(&unit_count);
+
+    std::vector<unsigned> units;
+    for (uint32_t unit_i = 0; success && unit_i < unit_count; unit_i++) {
+      uint32_t unit_index;
+      success = reader.ReadUint32(&unit_index);
+      units.push_back(unit_index);
+    }
+    if (success)
+      files_[std::move(name)] = std::move(units);
+  }
+
+  if (!success || !reader.at_end()) {
+    tree_ = CompactSymbolTree();
+    files_.clear();
+    return false;
+  }
+
+  if (in_place)
+    lazy_search_index_ = true;
+  else
+    search_index_ = std::make_unique<SymbolSearchIndex>(tree_.root());
+  IndexFileNames();
+  return true;
+}
+
+void ModuleSymbolIndex::IndexCompileUnitsInParallel(
+    llvm::DWARFContext* context, llvm::DWARFUnitVector* compile_units,
+    int thread_count, ModuleSymbolIndexNode* root) {
+  // Partial results for one contiguous range of compile units.
+  struct Chunk {
+    ModuleSymbolIndexNode root;
+    FileIndex files;
+  };
+
+  uint64_t unit_count = compile_units->size();
+  unsigned chunk_count = static_cast<unsigned>(std::min<uint64_t>(
+      unit_count, static_cast<uint64_t>(thread_count) *
+                      kChunksPerIndexingThread));
+  std::vector<Chunk> chunks(chunk_count);
+
+  // LLVM builds much of its DWARF state lazily, and none of that is
+  // threadsafe. The abbreviation tables are shared by all units, so parse them
+  // here before any worker starts. Each unit's DIEs belong to it alone, but
+  // extracting them reads the shared sections through the context, so the
+  // workers serialize it (and line table lookups) with |context_lock|.
+  for (const auto& unit : *compile_units)
+    unit->getAbbreviations();
+
+  std::mutex context_lock;
+  std::atomic<unsigned> next_chunk(0);
+  auto worker = [&]() {
+    for (unsigned chunk_index = next_chunk++; chunk_index < chunk_count;
+         chunk_index = next_chunk++) {
+      Chunk& chunk = chunks[chunk_index];
+      unsigned begin =
+          static_cast<unsigned>(unit_count * chunk_index / chunk_count);
+      unsigned end =
+          static_cast<unsigned>(unit_count * (chunk_index + 1) / chunk_count);
+      for (unsigned i = begin; i < end; i++) {
+        llvm::DWARFUnit* unit = (*compile_units)[i].get();
+        {
+          std::lock_guard<std::mutex> guard(context_lock);
+          unit->extractDIEsIfNeeded(false);
+        }
+        IndexCompileUnit(context, unit, i, &chunk.root, &chunk.files,
+                         &context_lock);
+
+        // Each slot in the vector is touched by exactly one thread so it's
+        // safe to free the units as we go (see CreateIndex).
+        (*compile_units)[i].reset();
+      }
+    }
+  };
+
+  // The current thread is also a worker.
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (int i = 1; i < thread_count; i++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto& thread : threads)
+    thread.join();
+
+  // Merging the chunks in order gives the same DIE and unit orderings as
+  // indexing serially.
+  for (Chunk& chunk : chunks) {
+    root->Merge(std::move(chunk.root));
+    for (auto& pair : chunk.files) {
+      std::vector<unsigned>& dest = files_[pair.first];
+      if (dest.empty()) {
+        dest = std::move(pair.second);
+      } else {
+        dest.insert(dest.end(), pair.second.begin(), pair.second.end());
       }
     }
+    chunk = Chunk();  // Free memory as we go.
   }
 }
 
@@ -6,9 +6,12 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+#include "garnet/bin/zxdb/symbols/compact_symbol_tree.h"
 #include "garnet/bin/zxdb/symbols/module_symbol_index_node.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
 #include "garnet/public/lib/fxl/macros.h"
 #include "garnet/public/lib/fxl/strings/string_view.h"
 #include "llvm/DebugInfo/DWARF/DWARFCompileUnit.h"
@@ -21,6 +24,8 @@ class DWARFDie;
 
 namespace zxdb {
 
+class SymbolSearchIndex;
+
 // Holds the index of symbols for a given module.
 class ModuleSymbolIndex {
  public:
@@ -31,21 +36,40 @@ class ModuleSymbolIndex {
   // its own context, and then discard the context when it's done. Since most
   // debugging information is not needed after indexing, this saves a lot of
   // memory.
-  void CreateIndex(llvm::object::ObjectFile* object_file);
+  //
+  // The compile units can be sharded across |thread_count| worker threads.
+  // Each worker builds a partial index which are merged at the end in unit
+  // order, so the result is the same regardless of the thread count. A value
+  // of 1 indexes everything on the calling thread, and 0 picks a count based
+  // on the number of hardware threads.
+  void CreateIndex(llvm::object::ObjectFile* object_file, int thread_count = 1);
 
-  const ModuleSymbolIndexNode& root() const { return root_; }
+  CompactSymbolTree::Node root() const { return tree_.root(); }
 
   size_t files_indexed() const { return file_name_index_.size(); }
 
-  // Returns how many symbols are indexed. This iterates through everything so
-  // can be slow.
-  size_t CountSymbolsIndexed() const;
+  // Returns how many symbols are indexed.
+  size_t CountSymbolsIndexed() const { return tree_.function_die_count(); }
+
+  // Returns the approximate number of bytes of memory used by the index.
+  size_t MemoryUsage() const;
 
   // Takes a fully-qualified name with namespaces and classes and template
   // parameters and returns the list of symbols which match exactly.
-  const std::vector<ModuleSymbolIndexNode::DieRef>& FindFunctionExact(
+  std::vector<ModuleSymbolIndexNode::DieRef> FindFunctionExact(
       const std::string& input) const;
 
+  // Returns the fully-qualified names of functions matching the given query.
+  // See SymbolSearchQuery.
+  //
+  // The search index is built once along with the rest of the index (either
+  // by CreateIndex() or Deserialize()) so failed lookups that ask for
+  // suggestions don't pay for building it. An index loaded by
+  // DeserializeInPlace() builds it on the first search instead, since doing
+  // so reads the whole tree.
+  std::vector<std::string> SearchFunctionNames(
+      const SymbolSearchQuery& query) const;
+
   // Looks up the name in the file index and returns the set of matches. The
   // name is matched from the right side with a left boundary of either a slash
   // or the beginning of the full path. This may match more than one file name,
@@ -64,17 +88,70 @@ class ModuleSymbolIndex {
   // Dumps the file index to the stream for debugging.
   void DumpFileIndex(std::ostream& out);
 
+  // Appends a flat binary representation of the index to the given output.
+  // This is used by ModuleSymbolIndexCache to save indices across sessions
+  // and contains only the index data (callers must validate that it belongs
+  // to the right module).
+  void Serialize(std::string* output) const;
+
+  // Replaces the contents of this index with the data from a previous call to
+  // Serialize(). Returns false if the data is corrupt, in which case the index
+  // will be empty.
+  bool Deserialize(const char* data, size_t size);
+
+  // Like Deserialize() but the function name tree refers to the data in place
+  // (see CompactSymbolTree::DeserializeInPlace()) and |storage| is kept alive
+  // to back it. The file index is still decoded here. Corruption in the tree
+  // isn't detected up front; it makes the affected names unfindable instead.
+  bool DeserializeInPlace(std::shared_ptr<const void> storage,
+                          const char* data, size_t size);
+
  private:
-  void IndexCompileUnit(llvm::DWARFContext* context, llvm::DWARFUnit* unit,
-                        unsigned unit_index);
+  using FileIndex = std::map<std::string, std::vector<unsigned>>;
 
-  void IndexCompileUnitSourceFiles(llvm::DWARFContext* context,
-                                   llvm::DWARFUnit* unit, unsigned unit_index);
+  // Indexes the given unit, writing the results to the given root node and
+  // file index. These are separate from tree_ and files_ so that different
+  // threads can index into their own partial results.
+  //
+  // The lazily-built state in the DWARFContext is not threadsafe. When
+  // indexing on more than one thread, the unit's DIEs must already have been
+  // extracted, and |context_lock| must be non-null; it will be held while
+  // looking up the unit's line table.
+  static void IndexCompileUnit(llvm::DWARFContext* context,
+                               llvm::DWARFUnit* unit, unsigned unit_index,
+                               ModuleSymbolIndexNode* root, FileIndex* files,
+                               std::mutex* context_lock);
+
+  static void IndexCompileUnitSourceFiles(llvm::DWARFContext* context,
+                                          llvm::DWARFUnit* unit,
+                                          unsigned unit_index, FileIndex* files,
+                                          std::mutex* context_lock);
+
+  // Indexes all units in the vector using the given number of threads (which
+  // should be at least 2) and merges the results into the given root and
+  // files_. Each unit is freed once it's indexed.
+  void IndexCompileUnitsInParallel(llvm::DWARFContext* context,
+                                   llvm::DWARFUnitVector* compile_units,
+                                   int thread_count,
+                                   ModuleSymbolIndexNode* root);
 
   // Populates the file_name_index_ given a now-unchanging files_ map.
   void IndexFileNames();
 
-  ModuleSymbolIndexNode root_;
+  // Implementation of Deserialize() and DeserializeInPlace(). A null storage
+  // means the data should be copied.
+  bool DoDeserialize(std::shared_ptr<const void> storage, const char* data,
+                     size_t size);
+
+  // The function name tree. This is built as a ModuleSymbolIndexNode tree
+  // and converted to the more compact form once indexing is complete.
+  CompactSymbolTree tree_;
+
+  // Index for partial name lookups. See SearchFunctionNames(). Null until an
+  // index has been created or loaded, or until the first search when
+  // |lazy_search_index_| is set.
+  mutable std::unique_ptr<SymbolSearchIndex> search_index_;
+  bool lazy_search_index_ = false;
 
   // Maps full path names to compile units that reference them. This must not
   // be mutated once the file_name_index_ is built.
@@ -87,7 +164,6 @@ class ModuleSymbolIndex {
   // compilation units. I suspect it's better to avoid duplicating the names
   // (like a multimap would) and eating the cost of indirect heap allocations
   // for vectors in the single-item case.
-  using FileIndex = std::map<std::string, std::vector<unsigned>>;
   FileIndex files_;
 
   // Maps the last file name component (the part following the last slash) to
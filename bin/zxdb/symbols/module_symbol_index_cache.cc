@@ -0,0 +1,207 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/symbols/module_symbol_index_cache.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <memory>
+
+#include "garnet/bin/zxdb/common/file_util.h"
+#include "garnet/bin/zxdb/symbols/module_symbol_index.h"
+#include "lib/fxl/strings/string_printf.h"
+
+namespace zxdb {
+
+namespace {
+
+// Increment when the serialized format of the header or the index changes.
+constexpr uint32_t kCacheVersion = 4;
+
+constexpr char kCacheMagic[8] = {'Z', 'X', 'D', 'B', 'I', 'D', 'X', 0};
+
+// File layout:
+//   CacheHeader
+//   char build_id[build_id_size], zero-padded to a multiple of 8 bytes
+//   <ModuleSymbolIndex::Serialize() data>
+//
+// The padding keeps the index data aligned in the mapped file so it can be
+// used in place.
+struct CacheHeader {
+  char magic[8];
+  uint32_t version = 0;
+  uint32_t build_id_size = 0;
+
+  // Identifies the symbol file the index was generated from.
+  uint64_t symbol_file_size = 0;
+  int64_t symbol_file_mtime_ns = 0;
+};
+
+// Fills in the symbol file information in the header. Returns false if the
+// file can't be found.
+bool FillSymbolFileInfo(const std::string& symbol_file, CacheHeader* header) {
+  return GetFileSizeAndModificationTime(symbol_file, &header->symbol_file_size,
+                                        &header->symbol_file_mtime_ns);
+}
+
+size_t PaddedBuildIDSize(size_t build_id_size) {
+  return (build_id_size + 7) & ~static_cast<size_t>(7);
+}
+
+// Read-only memory mapping of a file, unmapped on destruction. Cache files
+// are only ever replaced by renaming a new file over them, so a mapping never
+// sees the file change underneath it.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile() {
+    if (data_)
+      munmap(data_, size_);
+  }
+
+  bool Map(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0) {
+      close(fd);
+      return false;
+    }
+
+    size_ = static_cast<size_t>(file_stat.st_size);
+    void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping stays valid after the descriptor is closed.
+    if (mapped == MAP_FAILED)
+      return false;
+
+    data_ = mapped;
+    return true;
+  }
+
+  const char* data() const { return static_cast<const char*>(data_); }
+  size_t size() const { return size_; }
+
+ private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+
+  FXL_DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
+// Maps the given cache file if it's for the given build ID and is current for
+// the symbol file. On success, |*index_offset| is the offset of the
+// serialized index data in the file.
+bool MapCurrentFile(const std::string& path, const std::string& build_id,
+                    const std::string& symbol_file,
+                    std::shared_ptr<MappedFile>* mapped,
+                    size_t* index_offset) {
+  CacheHeader expected;
+  if (!FillSymbolFileInfo(symbol_file, &expected))
+    return false;
+
+  auto file = std::make_shared<MappedFile>();
+  if (!file->Map(path))
+    return false;
+
+  CacheHeader header;
+  if (file->size() < sizeof(CacheHeader))
+    return false;
+  memcpy(&header, file->data(), sizeof(CacheHeader));
+
+  if (memcmp(header.magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      header.version != kCacheVersion ||
+      header.symbol_file_size != expected.symbol_file_size ||
+      header.symbol_file_mtime_ns != expected.symbol_file_mtime_ns)
+    return false;
+
+  size_t offset = sizeof(CacheHeader);
+  size_t padded_build_id_size = PaddedBuildIDSize(build_id.size());
+  if (header.build_id_size != build_id.size() ||
+      file->size() - offset < padded_build_id_size ||
+      memcmp(&file->data()[offset], build_id.data(), build_id.size()) != 0)
+    return false;
+
+  *mapped = std::move(file);
+  *index_offset = offset + padded_build_id_size;
+  return true;
+}
+
+}  // namespace
+
+ModuleSymbolIndexCache::ModuleSymbolIndexCache(const std::string& dir)
+    : dir_(dir) {}
+
+ModuleSymbolIndexCache::~ModuleSymbolIndexCache() = default;
+
+std::string ModuleSymbolIndexCache::PathForBuildID(
+    const std::string& build_id) const {
+  return CatPathComponents(dir_, build_id + ".zxdbindex");
+}
+
+bool ModuleSymbolIndexCache::Load(const std::string& build_id,
+                                  const std::string& symbol_file,
+                                  ModuleSymbolIndex* index) const {
+  std::shared_ptr<MappedFile> mapped;
+  size_t offset = 0;
+  if (!MapCurrentFile(PathForBuildID(build_id), build_id, symbol_file, &mapped,
+                      &offset)) {
+    // Deserializing nothing fails and leaves the index empty.
+    index->Deserialize(nullptr, 0);
+    return false;
+  }
+
+  // The function name tree is used straight from the mapping, so only the
+  // pages holding the parts of it that are looked up are ever read.
+  const char* data = &mapped->data()[offset];
+  size_t size = mapped->size() - offset;
+  return index->DeserializeInPlace(std::move(mapped), data, size);
+}
+
+bool ModuleSymbolIndexCache::Save(const std::string& build_id,
+                                  const std::string& symbol_file,
+                                  const ModuleSymbolIndex& index) const {
+  CacheHeader header;
+  if (!FillSymbolFileInfo(symbol_file, &header))
+    return false;
+  memcpy(header.magic, kCacheMagic, sizeof(kCacheMagic));
+  header.version = kCacheVersion;
+  header.build_id_size = static_cast<uint32_t>(build_id.size());
+
+  std::string contents(reinterpret_cast<const char*>(&header), sizeof(header));
+  contents.append(build_id);
+  contents.append(PaddedBuildIDSize(build_id.size()) - build_id.size(), '\0');
+  index.Serialize(&contents);
+
+  std::error_code ec;
+  std::filesystem::create_directories(dir_, ec);
+  if (ec)
+    return false;
+
+  // Write to a unique temporary file and move it into place.
+  std::string dest_path = PathForBuildID(build_id);
+  std::string temp_path =
+      fxl::StringPrintf("%s.%d.tmp", dest_path.c_str(), getpid());
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (!file)
+    return false;
+  bool success =
+      fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+  success = (fclose(file) == 0) && success;
+
+  if (success)
+    success = rename(temp_path.c_str(), dest_path.c_str()) == 0;
+  if (!success)
+    unlink(temp_path.c_str());
+  return success;
+}
+
+}  // namespace zxdb
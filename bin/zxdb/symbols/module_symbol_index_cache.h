@@ -0,0 +1,58 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <string>
+
+#include "garnet/public/lib/fxl/macros.h"
+
+namespace zxdb {
+
+class ModuleSymbolIndex;
+
+// Saves and loads ModuleSymbolIndex data to a directory on disk so the
+// (slow) indexing doesn't have to be repeated every time a module is loaded.
+//
+// There is one file per build ID in the cache directory. Each file records
+// the size and modification time of the symbol file it was generated from,
+// and is ignored if the symbol file has changed since. The cache files are
+// memory-mapped when loading and the function name tree is used in place, so
+// only the pages actually needed are read.
+class ModuleSymbolIndexCache {
+ public:
+  // The directory will be created if necessary when the first index is
+  // saved.
+  explicit ModuleSymbolIndexCache(const std::string& dir);
+  ~ModuleSymbolIndexCache();
+
+  const std::string& dir() const { return dir_; }
+
+  // Returns the path of the cache file for the given build ID.
+  std::string PathForBuildID(const std::string& build_id) const;
+
+  // Attempts to fill the given index from the cache for the given build ID.
+  // The symbol file is the file that the index would be generated from, and
+  // is used to validate that the cache entry is still current.
+  //
+  // Returns true on success. On failure (no cache entry, stale, or corrupt),
+  // returns false and the index will be empty. The index keeps the cache file
+  // mapped, and damage to its function name tree is only found as it's used
+  // (see ModuleSymbolIndex::DeserializeInPlace()).
+  bool Load(const std::string& build_id, const std::string& symbol_file,
+            ModuleSymbolIndex* index) const;
+
+  // Writes the given index to the cache. Returns true on success. The file is
+  // written to a temporary location and renamed into place so concurrent
+  // debugger instances will never see a partial file.
+  bool Save(const std::string& build_id, const std::string& symbol_file,
+            const ModuleSymbolIndex& index) const;
+
+ private:
+  std::string dir_;
+
+  FXL_DISALLOW_COPY_AND_ASSIGN(ModuleSymbolIndexCache);
+};
+
+}  // namespace zxdb
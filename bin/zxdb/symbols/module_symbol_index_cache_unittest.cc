@@ -0,0 +1,86 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <filesystem>
+
+#include "garnet/bin/zxdb/symbols/module_symbol_index.h"
+#include "garnet/bin/zxdb/symbols/module_symbol_index_cache.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
+#include "garnet/bin/zxdb/symbols/test_symbol_module.h"
+#include "gtest/gtest.h"
+#include "lib/fxl/files/scoped_temp_dir.h"
+
+namespace zxdb {
+
+namespace {
+
+const char kBuildID[] = "0123456789abcdef";
+
+}  // namespace
+
+TEST(ModuleSymbolIndexCache, SaveLoad) {
+  files::ScopedTempDir temp_dir;
+
+  // Use a copy of the test module so its timestamp can be changed below.
+  std::string symbol_file = temp_dir.path() + "/test.so";
+  std::filesystem::copy_file(TestSymbolModule::GetTestFileName(), symbol_file);
+
+  TestSymbolModule module;
+  std::string err;
+  ASSERT_TRUE(module.LoadSpecific(symbol_file, &err)) << err;
+
+  ModuleSymbolIndex index;
+  index.CreateIndex(module.object_file());
+
+  ModuleSymbolIndexCache cache(temp_dir.path() + "/cache");
+
+  // Nothing saved yet.
+  ModuleSymbolIndex loaded;
+  EXPECT_FALSE(cache.Load(kBuildID, symbol_file, &loaded));
+
+  ASSERT_TRUE(cache.Save(kBuildID, symbol_file, index));
+  ASSERT_TRUE(cache.Load(kBuildID, symbol_file, &loaded));
+
+  // The loaded index should be the same as the original one.
+  EXPECT_EQ(index.root().AsString(), loaded.root().AsString());
+  EXPECT_EQ(index.CountSymbolsIndexed(), loaded.CountSymbolsIndexed());
+  EXPECT_EQ(index.files_indexed(), loaded.files_indexed());
+
+  auto result = loaded.FindFunctionExact(TestSymbolModule::kMyMemberOneName);
+  ASSERT_EQ(1u, result.size());
+  EXPECT_EQ(
+      index.FindFunctionExact(TestSymbolModule::kMyMemberOneName)[0].offset(),
+      result[0].offset());
+
+  std::vector<std::string> files = loaded.FindFileMatches("zxdb_symbol_test.cc");
+  ASSERT_EQ(1u, files.size());
+  ASSERT_TRUE(loaded.FindFileUnitIndices(files[0]));
+  EXPECT_EQ(*index.FindFileUnitIndices(files[0]),
+            *loaded.FindFileUnitIndices(files[0]));
+
+  // The function name tree is used from the mapped file rather than copied,
+  // and searching it builds the search index on demand.
+  EXPECT_LT(loaded.MemoryUsage(), index.MemoryUsage());
+  SymbolSearchQuery query("my_ns::MyClass::", SymbolSearchQuery::Mode::kPrefix);
+  EXPECT_EQ(index.SearchFunctionNames(query),
+            loaded.SearchFunctionNames(query));
+  EXPECT_FALSE(loaded.SearchFunctionNames(query).empty());
+
+  // A different build ID shouldn't match.
+  EXPECT_FALSE(cache.Load("fedcba9876543210", symbol_file, &loaded));
+
+  // Changing the modification time of the symbol file should invalidate.
+  struct timespec times[2];
+  times[0].tv_sec = 1000;
+  times[0].tv_nsec = 0;
+  times[1] = times[0];
+  ASSERT_EQ(0, utimensat(AT_FDCWD, symbol_file.c_str(), times, 0));
+  EXPECT_FALSE(cache.Load(kBuildID, symbol_file, &loaded));
+  EXPECT_EQ(0u, loaded.CountSymbolsIndexed());
+}
+
+}  // namespace zxdb
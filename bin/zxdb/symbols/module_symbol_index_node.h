@@ -22,6 +22,10 @@ namespace zxdb {
 // be multiple types of things with the same name in different compilation unit,
 // and a single function can have multiple locations. So one one can represent
 // many namespaces and functions.
+//
+// This is the form used while building the index since it's easy to add to
+// and merge. Once complete, it's converted to a CompactSymbolTree which uses
+// much less memory.
 class ModuleSymbolIndexNode {
  public:
   // A reference to a DIE that doesn't need the unit or the underlying
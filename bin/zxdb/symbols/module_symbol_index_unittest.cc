@@ -5,6 +5,7 @@
 #include <inttypes.h>
 #include <time.h>
 #include <ostream>
+#include <thread>
 
 #include "garnet/bin/zxdb/common/string_util.h"
 #include "garnet/bin/zxdb/symbols/module_symbol_index.h"
@@ -49,6 +50,37 @@ TEST(ModuleSymbolIndex, FindFunctionExact) {
   EXPECT_EQ(1u, result.size()) << "Symbol not found.";
 }
 
+TEST(ModuleSymbolIndex, SearchFunctionNames) {
+  TestSymbolModule module;
+  std::string err;
+  ASSERT_TRUE(module.Load(&err)) << err;
+
+  ModuleSymbolIndex index;
+  index.CreateIndex(module.object_file());
+
+  SymbolSearchQuery query("my_ns::MyClass::", SymbolSearchQuery::Mode::kPrefix);
+  std::vector<std::string> expected{TestSymbolModule::kMyMemberTwoName,
+                                    TestSymbolModule::kMyMemberOneName};
+  EXPECT_EQ(expected, index.SearchFunctionNames(query));
+
+  query = SymbolSearchQuery("mymember", SymbolSearchQuery::Mode::kSubstring);
+  EXPECT_TRUE(index.SearchFunctionNames(query).empty());
+  query.case_insensitive = true;
+  EXPECT_EQ(expected, index.SearchFunctionNames(query));
+
+  // A deserialized index should come with its own search index.
+  std::string serialized;
+  index.Serialize(&serialized);
+  ModuleSymbolIndex loaded;
+  ASSERT_TRUE(loaded.Deserialize(serialized.data(), serialized.size()));
+  EXPECT_EQ(expected, loaded.SearchFunctionNames(query));
+
+  // The search index should be replaced when the index is replaced.
+  ModuleSymbolIndex().Serialize(&serialized);
+  ASSERT_TRUE(index.Deserialize(serialized.data(), serialized.size()));
+  EXPECT_TRUE(index.SearchFunctionNames(query).empty());
+}
+
 TEST(ModuleSymbolIndex, FindFileMatches) {
   TestSymbolModule module;
   std::string err;
@@ -88,8 +120,93 @@ TEST(ModuleSymbolIndex, FindFileMatches) {
   EXPECT_EQ(0u, result.size());
 }
 
+// Indexing in parallel should give exactly the same results as indexing on one
+// thread. The test module has two compile units so it will get split.
+TEST(ModuleSymbolIndex, ParallelMatchesSerial) {
+  TestSymbolModule module;
+  std::string err;
+  ASSERT_TRUE(module.Load(&err)) << err;
+
+  ModuleSymbolIndex serial;
+  serial.CreateIndex(module.object_file(), 1);
+
+  ModuleSymbolIndex parallel;
+  parallel.CreateIndex(module.object_file(), 4);
+
+  EXPECT_EQ(serial.root().AsString(), parallel.root().AsString());
+  EXPECT_EQ(serial.CountSymbolsIndexed(), parallel.CountSymbolsIndexed());
+  EXPECT_EQ(serial.files_indexed(), parallel.files_indexed());
+
+  auto serial_result =
+      serial.FindFunctionExact(TestSymbolModule::kFunctionInTest2Name);
+  auto parallel_result =
+      parallel.FindFunctionExact(TestSymbolModule::kFunctionInTest2Name);
+  ASSERT_EQ(1u, serial_result.size());
+  ASSERT_EQ(1u, parallel_result.size());
+  EXPECT_EQ(serial_result[0].offset(), parallel_result[0].offset());
+
+  std::vector<std::string> files =
+      parallel.FindFileMatches("zxdb_symbol_test.cc");
+  ASSERT_EQ(1u, files.size());
+  const std::vector<unsigned>* serial_units =
+      serial.FindFileUnitIndices(files[0]);
+  const std::vector<unsigned>* parallel_units =
+      parallel.FindFileUnitIndices(files[0]);
+  ASSERT_TRUE(serial_units);
+  ASSERT_TRUE(parallel_units);
+  EXPECT_EQ(*serial_units, *parallel_units);
+}
+
+// Each parallel index gets a fresh DWARFContext whose lazily-built state the
+// workers share, so repeating it with one thread per compile unit gives races
+// there many chances to show up (this is most useful in the TSan variant).
+TEST(ModuleSymbolIndex, ParallelRepeated) {
+  TestSymbolModule module;
+  std::string err;
+  ASSERT_TRUE(module.Load(&err)) << err;
+
+  ModuleSymbolIndex serial;
+  serial.CreateIndex(module.object_file(), 1);
+  std::string expected = serial.root().AsString();
+
+  for (int i = 0; i < 50; i++) {
+    ModuleSymbolIndex parallel;
+    parallel.CreateIndex(module.object_file(), 2);
+    ASSERT_EQ(expected, parallel.root().AsString()) << "Run " << i;
+    ASSERT_EQ(serial.files_indexed(), parallel.files_indexed());
+  }
+}
+
+// Tests that Deserialize() rejects damaged data.
+TEST(ModuleSymbolIndex, DeserializeCorrupt) {
+  TestSymbolModule module;
+  std::string err;
+  ASSERT_TRUE(module.Load(&err)) << err;
+
+  ModuleSymbolIndex index;
+  index.CreateIndex(module.object_file());
+
+  std::string serialized;
+  index.Serialize(&serialized);
+
+  ModuleSymbolIndex loaded;
+  EXPECT_TRUE(loaded.Deserialize(serialized.data(), serialized.size()));
+
+  // Every truncation should fail cleanly.
+  for (size_t i = 0; i < serialized.size(); i++) {
+    EXPECT_FALSE(loaded.Deserialize(serialized.data(), i));
+    EXPECT_EQ(0u, loaded.CountSymbolsIndexed());
+    EXPECT_EQ(0u, loaded.files_indexed());
+  }
+
+  // Trailing garbage is also an error.
+  serialized.push_back(0);
+  EXPECT_FALSE(loaded.Deserialize(serialized.data(), serialized.size()));
+}
+
 // Enable and substitute a path on your system for kFilename to run the
-// indexing benchmark.
+// indexing benchmark. It reports the time for indexing on one thread and on
+// all hardware threads.
 #if 0
 static int64_t GetTickMicroseconds() {
   struct timespec ts;
@@ -114,15 +231,23 @@ TEST(ModuleSymbolIndex, BenchmarkIndexing) {
 
   int64_t load_complete_us = GetTickMicroseconds();
 
-  ModuleSymbolIndex index;
-  index.CreateIndex(module.object_file());
+  int64_t serial_index_us;
+  {
+    ModuleSymbolIndex index;
+    index.CreateIndex(module.object_file(), 1);
+    serial_index_us = GetTickMicroseconds() - load_complete_us;
+  }
 
-  int64_t index_complete_us = GetTickMicroseconds();
+  int64_t parallel_begin_us = GetTickMicroseconds();
+  ModuleSymbolIndex index;
+  index.CreateIndex(module.object_file(), 0);
+  int64_t parallel_index_us = GetTickMicroseconds() - parallel_begin_us;
 
   printf("\nIndexing results for %s:\n   Load: %" PRId64
-         " µs\n  Index: %" PRId64 " µs\n\n",
-         kFilename, load_complete_us - begin_us,
-         index_complete_us - load_complete_us);
+         " µs\n  Index (1 thread): %" PRId64
+         " µs\n  Index (%u threads): %" PRId64 " µs\n\n",
+         kFilename, load_complete_us - begin_us, serial_index_us,
+         std::thread::hardware_concurrency(), parallel_index_us);
 
   sleep(10);
 }
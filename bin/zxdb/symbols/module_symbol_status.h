@@ -26,6 +26,9 @@ struct ModuleSymbolStatus {
   size_t functions_indexed = 0;
   size_t files_indexed = 0;
 
+  // Approximate memory used by the symbol index.
+  size_t index_bytes = 0;
+
   // Local file name with the symbols if the symbols were loaded.
   std::string symbol_file;
 };
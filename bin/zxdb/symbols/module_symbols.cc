@@ -4,9 +4,27 @@
 
 #include "garnet/bin/zxdb/symbols/module_symbols.h"
 
+#include "garnet/bin/zxdb/symbols/input_location.h"
+
 namespace zxdb {
 
 ModuleSymbols::ModuleSymbols() = default;
 ModuleSymbols::~ModuleSymbols() = default;
 
+std::vector<Location> ModuleSymbols::LocationsForAddresses(
+    const SymbolContext& symbol_context,
+    const std::vector<uint64_t>& absolute_addresses) const {
+  std::vector<Location> result;
+  result.reserve(absolute_addresses.size());
+  for (uint64_t address : absolute_addresses) {
+    std::vector<Location> locations =
+        ResolveInputLocation(symbol_context, InputLocation(address));
+    if (locations.empty())
+      result.emplace_back(Location::State::kSymbolized, address);
+    else
+      result.push_back(std::move(locations[0]));
+  }
+  return result;
+}
+
 }  // namespace zxdb
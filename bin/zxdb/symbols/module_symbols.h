@@ -20,6 +20,7 @@ struct InputLocation;
 class LineDetails;
 struct ResolveOptions;
 class SymbolContext;
+struct SymbolSearchQuery;
 
 // Represents the symbols for a module (executable or shared library).
 //
@@ -110,6 +111,20 @@ class ModuleSymbols {
   virtual std::vector<std::string> FindFileMatches(
       const std::string& name) const = 0;
 
+  // Returns the sorted fully-qualified names of the functions matching the
+  // given query. This is used for finding symbols when the user doesn't know
+  // the exact name. The results can be passed to ResolveInputLocation().
+  virtual std::vector<std::string> SearchFunctionNames(
+      const SymbolSearchQuery& query) const = 0;
+
+  // Symbolizes a batch of addresses, returning the results in the same order
+  // as the input. This is the same as calling ResolveInputLocation() for each
+  // address, which is what the default implementation does. Implementations
+  // can override this to share work between nearby addresses.
+  virtual std::vector<Location> LocationsForAddresses(
+      const SymbolContext& symbol_context,
+      const std::vector<uint64_t>& absolute_addresses) const;
+
  private:
   FXL_DISALLOW_COPY_AND_ASSIGN(ModuleSymbols);
 };
@@ -9,6 +9,7 @@
 #include "garnet/bin/zxdb/symbols/dwarf_symbol_factory.h"
 #include "garnet/bin/zxdb/symbols/input_location.h"
 #include "garnet/bin/zxdb/symbols/line_details.h"
+#include "garnet/bin/zxdb/symbols/module_symbol_index_cache.h"
 #include "garnet/bin/zxdb/symbols/resolve_options.h"
 #include "garnet/bin/zxdb/symbols/symbol_context.h"
 #include "llvm/DebugInfo/DIContext.h"
@@ -22,6 +23,38 @@ namespace zxdb {
 
 namespace {
 
+// Maximum number of compile units' address tables to keep around.
+constexpr size_t kMaxCachedLineTables = 32;
+
+// Returns the sorted addresses at which the innermost function of the unit
+// can change. These are the beginnings and ends of all function and inlined
+// function ranges. Between two adjacent boundaries, the innermost function
+// (as returned by getSubroutineForAddress()) is the same for every address.
+std::vector<uint64_t> GetSubroutineBoundaries(llvm::DWARFUnit* unit) {
+  std::vector<uint64_t> result;
+  unsigned die_count = unit->getNumDIEs();
+  for (unsigned i = 0; i < die_count; i++) {
+    llvm::DWARFDie die = unit->getDIEAtIndex(i);
+    if (die.getTag() != llvm::dwarf::DW_TAG_subprogram &&
+        die.getTag() != llvm::dwarf::DW_TAG_inlined_subroutine)
+      continue;
+
+    auto ranges_or_error = die.getAddressRanges();
+    if (!ranges_or_error) {
+      llvm::consumeError(ranges_or_error.takeError());
+      continue;
+    }
+    for (const llvm::DWARFAddressRange& range : ranges_or_error.get()) {
+      result.push_back(range.LowPC);
+      result.push_back(range.HighPC);
+    }
+  }
+
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
 enum class FileChecked { kUnchecked = 0, kMatch, kNoMatch };
 
 bool SameFileLine(const llvm::DWARFDebugLine::Row& a,
@@ -160,7 +193,10 @@ std::vector<LineMatch> GetFirstEntryForEachInline(
 
 ModuleSymbolsImpl::ModuleSymbolsImpl(const std::string& name,
                                      const std::string& build_id)
-    : name_(name), build_id_(build_id), weak_factory_(this) {
+    : name_(name),
+      build_id_(build_id),
+      line_tables_(kMaxCachedLineTables),
+      weak_factory_(this) {
   symbol_factory_ = fxl::MakeRefCounted<DwarfSymbolFactory>(GetWeakPtr());
 }
 
@@ -177,11 +213,12 @@ ModuleSymbolStatus ModuleSymbolsImpl::GetStatus() const {
   status.symbols_loaded = true;  // Since this instance exists at all.
   status.functions_indexed = index_.CountSymbolsIndexed();
   status.files_indexed = index_.files_indexed();
+  status.index_bytes = index_.MemoryUsage();
   status.symbol_file = name_;
   return status;
 }
 
-Err ModuleSymbolsImpl::Load() {
+Err ModuleSymbolsImpl::Load(const ModuleSymbolIndexCache* index_cache) {
   llvm::Expected<llvm::object::OwningBinary<llvm::object::Binary>> bin_or_err =
       llvm::object::createBinary(name_);
   if (!bin_or_err) {
@@ -208,7 +245,14 @@ Err ModuleSymbolsImpl::Load() {
   //
   // Although it will be slightly slower to create, the memory savings may make
   // such a change worth it for large programs.
-  index_.CreateIndex(obj);
+  //
+  // Indexing is the slowest part of loading symbols for large modules so
+  // prefer a cached copy and otherwise use all available threads.
+  if (index_cache && index_cache->Load(build_id_, name_, &index_))
+    return Err();
+  index_.CreateIndex(obj, 0);
+  if (index_cache)
+    index_cache->Save(build_id_, name_, index_);
   return Err();
 }
 
@@ -303,6 +347,47 @@ std::vector<std::string> ModuleSymbolsImpl::FindFileMatches(
   return index_.FindFileMatches(name);
 }
 
+std::vector<std::string> ModuleSymbolsImpl::SearchFunctionNames(
+    const SymbolSearchQuery& query) const {
+  return index_.SearchFunctionNames(query);
+}
+
+std::vector<Location> ModuleSymbolsImpl::LocationsForAddresses(
+    const SymbolContext& symbol_context,
+    const std::vector<uint64_t>& absolute_addresses) const {
+  // Pairs of (unit, index into absolute_addresses) sorted by unit so each
+  // unit's table is fetched once, even if there are more units than the
+  // cache holds.
+  std::vector<std::pair<llvm::DWARFUnit*, size_t>> by_unit;
+  by_unit.reserve(absolute_addresses.size());
+  for (size_t i = 0; i < absolute_addresses.size(); i++) {
+    by_unit.emplace_back(
+        CompileUnitForRelativeAddress(
+            symbol_context.AbsoluteToRelative(absolute_addresses[i])),
+        i);
+  }
+  std::sort(by_unit.begin(), by_unit.end());
+
+  std::vector<Location> result(absolute_addresses.size());
+  llvm::DWARFUnit* table_unit = nullptr;
+  const AddressLineTable* table = nullptr;
+  for (const auto& pair : by_unit) {
+    uint64_t absolute_address = absolute_addresses[pair.second];
+    if (!pair.first) {
+      result[pair.second] =
+          Location(Location::State::kSymbolized, absolute_address);
+      continue;
+    }
+    if (pair.first != table_unit) {
+      table_unit = pair.first;
+      table = GetAddressLineTable(table_unit);
+    }
+    result[pair.second] = LocationForAddressInUnit(symbol_context, table_unit,
+                                                   *table, absolute_address);
+  }
+  return result;
+}
+
 llvm::DWARFUnit* ModuleSymbolsImpl::CompileUnitForRelativeAddress(
     uint64_t relative_address) const {
   return compile_units_.getUnitForOffset(
@@ -375,33 +460,110 @@ Location ModuleSymbolsImpl::LocationForAddress(
   if (!unit)  // No symbol
     return Location(Location::State::kSymbolized, absolute_address);
 
-  // Get the innermost subroutine or inlined function for the address. This
-  // may be empty, but still lookup the line info below in case its present.
-  llvm::DWARFDie subroutine = unit->getSubroutineForAddress(relative_address);
+  return LocationForAddressInUnit(symbol_context, unit,
+                                  *GetAddressLineTable(unit), absolute_address);
+}
+
+Location ModuleSymbolsImpl::LocationForAddressInUnit(
+    const SymbolContext& symbol_context, llvm::DWARFUnit* unit,
+    const AddressLineTable& table, uint64_t absolute_address) const {
+  uint64_t relative_address =
+      symbol_context.AbsoluteToRelative(absolute_address);
+
+  const AddressLineTable::Entry* entry = table.Find(relative_address);
+  if (!entry) {
+    // No line information. There may still be a function covering the
+    // address.
+    LazySymbol lazy_function;
+    llvm::DWARFDie subroutine = unit->getSubroutineForAddress(relative_address);
+    if (subroutine)
+      lazy_function = symbol_factory_->MakeLazy(subroutine);
+    return Location(absolute_address, FileLine(), 0, symbol_context,
+                    std::move(lazy_function));
+  }
+
+  // The table stores the innermost subroutine or inlined function for the
+  // address.
   LazySymbol lazy_function;
-  if (subroutine)
-    lazy_function = symbol_factory_->MakeLazy(subroutine);
+  if (entry->function_die_offset)
+    lazy_function = symbol_factory_->MakeLazy(unit, entry->function_die_offset);
+  return Location(absolute_address,
+                  FileLine(table.files()[entry->file], entry->line),
+                  static_cast<int>(entry->column), symbol_context,
+                  std::move(lazy_function));
+}
+
+const AddressLineTable* ModuleSymbolsImpl::GetAddressLineTable(
+    llvm::DWARFUnit* unit) const {
+  return line_tables_.Get(unit->getOffset(), [this, unit]() {
+    return BuildAddressLineTable(unit);
+  });
+}
 
-  // Get the file/line location (may fail).
+AddressLineTable ModuleSymbolsImpl::BuildAddressLineTable(
+    llvm::DWARFUnit* unit) const {
   const llvm::DWARFDebugLine::LineTable* line_table =
       context_->getLineTableForUnit(unit);
-  if (line_table) {
-    llvm::DILineInfo line_info;
-    if (line_table->getFileLineInfoForAddress(
-            relative_address, unit->getCompilationDir(),
-            llvm::DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
-            line_info)) {
-      // Line info present.
-      return Location(absolute_address,
-                      FileLine(std::move(line_info.FileName), line_info.Line),
-                      line_info.Column, symbol_context,
-                      std::move(lazy_function));
+  if (!line_table)
+    return AddressLineTable();
+  const char* compilation_dir = unit->getCompilationDir();
+
+  // Maps the line table's file indices to indices into |files|. Only the
+  // files actually referenced by rows are resolved.
+  std::map<uint32_t, uint32_t> file_indices;
+  std::vector<std::string> files;
+
+  std::vector<uint64_t> boundaries = GetSubroutineBoundaries(unit);
+
+  std::vector<AddressLineTable::Entry> entries;
+  const auto& rows = line_table->Rows;
+  for (size_t i = 0; i + 1 < rows.size(); i++) {
+    const llvm::DWARFDebugLine::Row& row = rows[i];
+
+    // An EndSequence row only marks the end of the previous row's range. A
+    // row followed by one at the same address covers no code (LLVM also
+    // uses the last row for a given address).
+    if (row.EndSequence || rows[i + 1].Address <= row.Address)
+      continue;
+
+    uint64_t row_end = rows[i + 1].Address;
+
+    AddressLineTable::Entry entry;
+    entry.begin = row.Address;
+    entry.line = row.Line;
+    entry.column = row.Column;
+
+    auto inserted = file_indices.emplace(row.File, files.size());
+    if (inserted.second) {
+      std::string file_name;
+      line_table->getFileNameByIndex(
+          row.File, compilation_dir,
+          llvm::DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+          file_name);
+      files.push_back(std::move(file_name));
     }
-  }
+    entry.file = inserted.first->second;
+
+    // Inlined code can begin or end in the middle of a row, so split the row
+    // at each function boundary inside it and look up the innermost function
+    // of each piece. The table constructor merges pieces that end up with the
+    // same function again.
+    auto boundary =
+        std::upper_bound(boundaries.begin(), boundaries.end(), entry.begin);
+    while (entry.begin < row_end) {
+      if (boundary != boundaries.end() && *boundary < row_end)
+        entry.end = *boundary++;
+      else
+        entry.end = row_end;
 
-  // No line information.
-  return Location(absolute_address, FileLine(), 0, symbol_context,
-                  std::move(lazy_function));
+      llvm::DWARFDie subroutine = unit->getSubroutineForAddress(entry.begin);
+      entry.function_die_offset = subroutine ? subroutine.getOffset() : 0;
+
+      entries.push_back(entry);
+      entry.begin = entry.end;
+    }
+  }
+  return AddressLineTable(std::move(entries), std::move(files));
 }
 
 // To a first approximation we just look up the line in the line table for
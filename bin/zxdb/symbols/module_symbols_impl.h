@@ -5,6 +5,7 @@
 #pragma once
 
 #include "garnet/bin/zxdb/common/err.h"
+#include "garnet/bin/zxdb/symbols/address_line_table.h"
 #include "garnet/bin/zxdb/symbols/location.h"
 #include "garnet/bin/zxdb/symbols/module_symbol_index.h"
 #include "garnet/bin/zxdb/symbols/module_symbols.h"
@@ -27,6 +28,7 @@ class Binary;
 namespace zxdb {
 
 class DwarfSymbolFactory;
+class ModuleSymbolIndexCache;
 
 // Represents the symbols for a module (executable or shared library).
 //
@@ -46,7 +48,10 @@ class ModuleSymbolsImpl : public ModuleSymbols {
   llvm::DWARFUnitVector& compile_units() { return compile_units_; }
   DwarfSymbolFactory* symbol_factory() { return symbol_factory_.get(); }
 
-  Err Load();
+  // Loads the symbols and indexes them. If the index cache is non-null, the
+  // index will be loaded from the cache when possible, and saved to it
+  // otherwise.
+  Err Load(const ModuleSymbolIndexCache* index_cache = nullptr);
 
   fxl::WeakPtr<ModuleSymbolsImpl> GetWeakPtr();
 
@@ -59,6 +64,11 @@ class ModuleSymbolsImpl : public ModuleSymbols {
                                     uint64_t absolute_address) const override;
   std::vector<std::string> FindFileMatches(
       const std::string& name) const override;
+  std::vector<std::string> SearchFunctionNames(
+      const SymbolSearchQuery& query) const override;
+  std::vector<Location> LocationsForAddresses(
+      const SymbolContext& symbol_context,
+      const std::vector<uint64_t>& absolute_addresses) const override;
 
  private:
   llvm::DWARFUnit* CompileUnitForRelativeAddress(
@@ -79,6 +89,18 @@ class ModuleSymbolsImpl : public ModuleSymbols {
   Location LocationForAddress(const SymbolContext& symbol_context,
                               uint64_t absolute_address) const;
 
+  // Symbolizes the given address which must be inside the given unit. The
+  // table must be the one for that unit.
+  Location LocationForAddressInUnit(const SymbolContext& symbol_context,
+                                    llvm::DWARFUnit* unit,
+                                    const AddressLineTable& table,
+                                    uint64_t absolute_address) const;
+
+  // Returns the (possibly cached) address table for the given unit. The
+  // pointer is valid until the next call.
+  const AddressLineTable* GetAddressLineTable(llvm::DWARFUnit* unit) const;
+  AddressLineTable BuildAddressLineTable(llvm::DWARFUnit* unit) const;
+
   // Resolves the line number information for the given file, which must be an
   // exact match. This is a helper function for ResolveLineInputLocation().
   //
@@ -99,6 +121,11 @@ class ModuleSymbolsImpl : public ModuleSymbols {
 
   ModuleSymbolIndex index_;
 
+  // Address lookup tables for recently used compile units. This is a cache so
+  // is modified from const functions. Like the rest of this class, it is not
+  // threadsafe.
+  mutable AddressLineTableCache line_tables_;
+
   fxl::RefPtr<DwarfSymbolFactory> symbol_factory_;
 
   fxl::WeakPtrFactory<ModuleSymbolsImpl> weak_factory_;
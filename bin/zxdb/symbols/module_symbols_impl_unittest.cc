@@ -2,16 +2,26 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <random>
+
+#include "garnet/bin/zxdb/symbols/dwarf_symbol_factory.h"
 #include "garnet/bin/zxdb/symbols/input_location.h"
 #include "garnet/bin/zxdb/symbols/line_details.h"
 #include "garnet/bin/zxdb/symbols/module_symbols_impl.h"
 #include "garnet/bin/zxdb/symbols/resolve_options.h"
+#include "garnet/bin/zxdb/symbols/symbol.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
 #include "garnet/bin/zxdb/symbols/test_symbol_module.h"
 #include "gtest/gtest.h"
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFUnit.h"
 
 namespace zxdb {
 
@@ -143,6 +153,110 @@ TEST(ModuleSymbols, LineDetailsForAddress) {
   EXPECT_EQ(end_range, next_details.entries().front().range.begin());
 }
 
+TEST(ModuleSymbols, LocationsForAddresses) {
+  ModuleSymbolsImpl module(TestSymbolModule::GetCheckedInTestFileName(), "");
+  Err err = module.Load();
+  EXPECT_FALSE(err.has_error()) << err.msg();
+
+  SymbolContext symbol_context(0x18000);
+
+  // Collect the addresses of a few functions in different units, plus some
+  // addresses inside them, one outside of any module, and a duplicate.
+  std::vector<uint64_t> addresses;
+  for (const char* name : {TestSymbolModule::kMyFunctionName,
+                           TestSymbolModule::kFunctionInTest2Name,
+                           TestSymbolModule::kMyMemberOneName}) {
+    std::vector<Location> locations =
+        module.ResolveInputLocation(symbol_context, InputLocation(name));
+    ASSERT_EQ(1u, locations.size()) << name;
+    addresses.push_back(locations[0].address());
+    addresses.push_back(locations[0].address() + 4);
+  }
+  addresses.push_back(0x10);
+  addresses.push_back(addresses[0]);
+
+  // The batch results should be the same as individual lookups.
+  std::vector<Location> batch =
+      module.LocationsForAddresses(symbol_context, addresses);
+  ASSERT_EQ(addresses.size(), batch.size());
+  for (size_t i = 0; i < addresses.size(); i++) {
+    std::vector<Location> single = module.ResolveInputLocation(
+        symbol_context, InputLocation(addresses[i]));
+    ASSERT_EQ(1u, single.size());
+
+    EXPECT_EQ(addresses[i], batch[i].address());
+    EXPECT_TRUE(batch[i].is_symbolized());
+    EXPECT_EQ(single[0].file_line(), batch[i].file_line()) << i;
+    EXPECT_EQ(single[0].column(), batch[i].column()) << i;
+    EXPECT_EQ(single[0].function().Get()->GetFullName(),
+              batch[i].function().Get()->GetFullName())
+        << i;
+  }
+
+  // The function should have been found for the function start addresses.
+  EXPECT_EQ(TestSymbolModule::kMyFunctionName,
+            batch[0].function().Get()->GetFullName());
+  EXPECT_EQ(TestSymbolModule::kMyFunctionLine, batch[0].file_line().line());
+}
+
+// Symbolizing goes through a precomputed table per unit. It should give the
+// same answer for every address as looking it up directly in LLVM's line table
+// and function DIEs.
+TEST(ModuleSymbols, LocationForAddressMatchesLineTable) {
+  ModuleSymbolsImpl module(TestSymbolModule::GetCheckedInTestFileName(), "");
+  Err err = module.Load();
+  EXPECT_FALSE(err.has_error()) << err.msg();
+
+  SymbolContext symbol_context = SymbolContext::ForRelativeAddresses();
+  llvm::DWARFContext* context = module.context();
+
+  size_t checked_count = 0;
+  for (const auto& unit : module.compile_units()) {
+    const llvm::DWARFDebugLine::LineTable* line_table =
+        context->getLineTableForUnit(unit.get());
+    if (!line_table)
+      continue;
+
+    for (const auto& sequence : line_table->Sequences) {
+      for (uint64_t address = sequence.LowPC; address < sequence.HighPC;
+           address++) {
+        std::vector<Location> locations = module.ResolveInputLocation(
+            symbol_context, InputLocation(address));
+        ASSERT_EQ(1u, locations.size());
+        const Location& loc = locations[0];
+
+        llvm::DILineInfo line_info;
+        if (line_table->getFileLineInfoForAddress(
+                address, unit->getCompilationDir(),
+                llvm::DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+                line_info)) {
+          EXPECT_EQ(line_info.FileName, loc.file_line().file()) << address;
+          EXPECT_EQ(static_cast<int>(line_info.Line), loc.file_line().line())
+              << address;
+          EXPECT_EQ(static_cast<int>(line_info.Column), loc.column())
+              << address;
+        } else {
+          EXPECT_FALSE(loc.file_line().is_valid()) << address;
+        }
+
+        llvm::DWARFDie subroutine = unit->getSubroutineForAddress(address);
+        ASSERT_EQ(static_cast<bool>(subroutine),
+                  static_cast<bool>(loc.function()))
+            << address;
+        if (subroutine) {
+          const Symbol* expected =
+              module.symbol_factory()->MakeLazy(subroutine).Get();
+          const Symbol* actual = loc.function().Get();
+          EXPECT_EQ(expected->tag(), actual->tag()) << address;
+          EXPECT_EQ(expected->GetFullName(), actual->GetFullName()) << address;
+        }
+        checked_count++;
+      }
+    }
+  }
+  EXPECT_LT(0u, checked_count);
+}
+
 TEST(ModuleSymbols, ResolveLineInputLocation) {
   ModuleSymbolsImpl module(TestSymbolModule::GetCheckedInTestFileName(), "");
   Err err = module.Load();
@@ -217,4 +331,61 @@ TEST(ModuleSymbols, ResolveLineInputLocation) {
   }
 }
 
+// Enable and substitute a path on your system for kFilename to run the
+// symbolization benchmark. It symbolizes a set of random code addresses
+// individually and as a batch.
+#if 0
+static int64_t GetTickMicroseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  constexpr int64_t kMicrosecondsPerSecond = 1000000;
+  constexpr int64_t kNanosecondsPerMicrosecond = 1000;
+
+  int64_t result = ts.tv_sec * kMicrosecondsPerSecond;
+  result += (ts.tv_nsec / kNanosecondsPerMicrosecond);
+  return result;
+}
+
+TEST(ModuleSymbols, BenchmarkSymbolization) {
+  const char kFilename[] =
+      "/usr/local/google/home/brettw/prj/src/out/release/chrome";
+  constexpr size_t kAddressCount = 10000;
+
+  ModuleSymbolsImpl module(kFilename, "");
+  Err err = module.Load();
+  ASSERT_FALSE(err.has_error()) << err.msg();
+  SymbolContext symbol_context = SymbolContext::ForRelativeAddresses();
+
+  // Pick random functions and random offsets into them.
+  std::vector<std::string> names = module.SearchFunctionNames(
+      SymbolSearchQuery(std::string(), SymbolSearchQuery::Mode::kPrefix));
+  ASSERT_FALSE(names.empty());
+  std::mt19937 rng(0);
+  ResolveOptions options;
+  options.symbolize = false;
+  std::vector<uint64_t> addresses;
+  while (addresses.size() < kAddressCount) {
+    std::vector<Location> locations = module.ResolveInputLocation(
+        symbol_context, InputLocation(names[rng() % names.size()]), options);
+    if (!locations.empty())
+      addresses.push_back(locations[0].address() + rng() % 64);
+  }
+
+  int64_t batch_begin_us = GetTickMicroseconds();
+  std::vector<Location> batch =
+      module.LocationsForAddresses(symbol_context, addresses);
+  int64_t batch_us = GetTickMicroseconds() - batch_begin_us;
+
+  int64_t single_begin_us = GetTickMicroseconds();
+  for (uint64_t address : addresses)
+    module.ResolveInputLocation(symbol_context, InputLocation(address));
+  int64_t single_us = GetTickMicroseconds() - single_begin_us;
+
+  printf("\nSymbolizing %zu addresses in %s:\n  Batch: %" PRId64
+         " µs\n  Individual: %" PRId64 " µs\n\n",
+         addresses.size(), kFilename, batch_us, single_us);
+}
+#endif  // End symbolization benchmark.
+
 }  // namespace zxdb
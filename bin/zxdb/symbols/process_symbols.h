@@ -18,6 +18,7 @@ struct InputLocation;
 class LineDetails;
 struct ModuleSymbolStatus;
 struct ResolveOptions;
+struct SymbolSearchQuery;
 class TargetSymbols;
 
 class ProcessSymbols {
@@ -45,6 +46,12 @@ class ProcessSymbols {
   // with the same line as the given address.
   virtual LineDetails LineDetailsForAddress(uint64_t address) const = 0;
 
+  // Returns the sorted fully-qualified names of the functions in all loaded
+  // modules matching the given query. Names appearing in more than one module
+  // are returned once. The results can be used as symbol InputLocations.
+  virtual std::vector<std::string> SearchFunctionNames(
+      const SymbolSearchQuery& query) const = 0;
+
   // Returns true if the code location is inside a module where there are
   // symbols loaded. If we did something like index ELF exports, those wouldn't
   // count. "Symbols loaded" here means there is real DWARF debugging
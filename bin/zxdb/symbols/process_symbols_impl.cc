@@ -4,11 +4,15 @@
 
 #include "garnet/bin/zxdb/symbols/process_symbols_impl.h"
 
+#include <algorithm>
+#include <iterator>
+
 #include "garnet/bin/zxdb/symbols/input_location.h"
 #include "garnet/bin/zxdb/symbols/line_details.h"
 #include "garnet/bin/zxdb/symbols/loaded_module_symbols.h"
 #include "garnet/bin/zxdb/symbols/module_symbols_impl.h"
 #include "garnet/bin/zxdb/symbols/resolve_options.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
 #include "garnet/bin/zxdb/symbols/system_symbols.h"
 #include "garnet/bin/zxdb/symbols/target_symbols_impl.h"
 #include "garnet/lib/debug_ipc/records.h"
@@ -153,6 +157,36 @@ std::vector<Location> ProcessSymbolsImpl::ResolveInputLocation(
   return result;
 }
 
+std::vector<Location> ProcessSymbolsImpl::ResolveAddresses(
+    const std::vector<uint64_t>& addresses) const {
+  std::vector<Location> result(addresses.size());
+
+  // Indices into the addresses for each module that has symbols.
+  std::map<const ModuleInfo*, std::vector<size_t>> by_module;
+  for (size_t i = 0; i < addresses.size(); i++) {
+    const ModuleInfo* info = InfoForAddress(addresses[i]);
+    if (info && info->symbols)
+      by_module[info].push_back(i);
+    else
+      result[i] = Location(Location::State::kSymbolized, addresses[i]);
+  }
+
+  std::vector<uint64_t> module_addresses;
+  for (const auto& pair : by_module) {
+    const LoadedModuleSymbols* loaded = pair.first->symbols.get();
+    module_addresses.clear();
+    for (size_t index : pair.second)
+      module_addresses.push_back(addresses[index]);
+
+    std::vector<Location> locations =
+        loaded->module_symbols()->LocationsForAddresses(
+            loaded->symbol_context(), module_addresses);
+    for (size_t i = 0; i < pair.second.size(); i++)
+      result[pair.second[i]] = std::move(locations[i]);
+  }
+  return result;
+}
+
 LineDetails ProcessSymbolsImpl::LineDetailsForAddress(uint64_t address) const {
   const ModuleInfo* info = InfoForAddress(address);
   if (!info || !info->symbols)
@@ -161,6 +195,28 @@ LineDetails ProcessSymbolsImpl::LineDetailsForAddress(uint64_t address) const {
       info->symbols->symbol_context(), address);
 }
 
+std::vector<std::string> ProcessSymbolsImpl::SearchFunctionNames(
+    const SymbolSearchQuery& query) const {
+  // Each module returns its first max_results matches in sorted order, so
+  // the first max_results of the merged results are the correct overall
+  // answer.
+  std::vector<std::string> result;
+  for (const auto& pair : modules_) {
+    if (!pair.second.symbols)
+      continue;
+    std::vector<std::string> module_result =
+        pair.second.symbols->module_symbols()->SearchFunctionNames(query);
+    result.insert(result.end(), std::make_move_iterator(module_result.begin()),
+                  std::make_move_iterator(module_result.end()));
+  }
+
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  if (query.max_results && result.size() > query.max_results)
+    result.resize(query.max_results);
+  return result;
+}
+
 bool ProcessSymbolsImpl::HaveSymbolsLoadedForModuleAt(uint64_t address) const {
   const ModuleInfo* info = InfoForAddress(address);
   return info && info->symbols;
@@ -48,6 +48,12 @@ class ProcessSymbolsImpl : public ProcessSymbols {
   // Replaces all modules with the given list.
   void SetModules(const std::vector<debug_ipc::Module>& modules);
 
+  // Symbolizes a batch of addresses, returning the results in the same order
+  // as the input. The addresses are grouped by module so each module can
+  // share work between them (see ModuleSymbols::LocationsForAddresses()).
+  std::vector<Location> ResolveAddresses(
+      const std::vector<uint64_t>& addresses) const;
+
   // ProcessSymbols implementation.
   TargetSymbols* GetTargetSymbols() override;
   std::vector<ModuleSymbolStatus> GetStatus() const override;
@@ -55,6 +61,8 @@ class ProcessSymbolsImpl : public ProcessSymbols {
       const InputLocation& input_location,
       const ResolveOptions& options) const override;
   LineDetails LineDetailsForAddress(uint64_t address) const override;
+  std::vector<std::string> SearchFunctionNames(
+      const SymbolSearchQuery& query) const override;
   bool HaveSymbolsLoadedForModuleAt(uint64_t address) const override;
 
  private:
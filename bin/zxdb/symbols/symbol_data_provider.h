@@ -9,6 +9,7 @@
 #include <functional>
 #include <vector>
 
+#include "garnet/bin/zxdb/common/address_range.h"
 #include "lib/fxl/memory/ref_counted.h"
 
 namespace zxdb {
@@ -70,6 +71,11 @@ class SymbolDataProvider
   virtual void GetMemoryAsync(uint64_t address, uint32_t size,
                               GetMemoryCallback callback) = 0;
 
+  // Hints that the given ranges of memory will be requested soon. The
+  // implementation may fetch them all at once so the subsequent
+  // GetMemoryAsync() calls for them complete without separate requests.
+  virtual void PrefetchMemory(const std::vector<AddressRange>& ranges) = 0;
+
  protected:
   FRIEND_REF_COUNTED_THREAD_SAFE(SymbolDataProvider);
   virtual ~SymbolDataProvider() = default;
@@ -0,0 +1,287 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/symbols/symbol_search_index.h"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+
+#include "garnet/public/lib/fxl/logging.h"
+
+namespace zxdb {
+
+namespace {
+
+constexpr size_t kTrigramSize = 3;
+
+char FoldChar(char c) {
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A' + 'a';
+  return c;
+}
+
+std::string FoldString(fxl::StringView str) {
+  std::string result(str.data(), str.size());
+  for (char& c : result)
+    c = FoldChar(c);
+  return result;
+}
+
+uint32_t TrigramAt(const char* p) {
+  return (static_cast<uint32_t>(static_cast<unsigned char>(p[0])) << 16) |
+         (static_cast<uint32_t>(static_cast<unsigned char>(p[1])) << 8) |
+         static_cast<uint32_t>(static_cast<unsigned char>(p[2]));
+}
+
+// Appends the distinct trigrams of the given string to the output, sorted.
+void GetTrigrams(fxl::StringView str, std::vector<uint32_t>* output) {
+  output->clear();
+  if (str.size() < kTrigramSize)
+    return;
+  for (size_t i = 0; i <= str.size() - kTrigramSize; i++)
+    output->push_back(TrigramAt(&str.data()[i]));
+  std::sort(output->begin(), output->end());
+  output->erase(std::unique(output->begin(), output->end()), output->end());
+}
+
+bool StartsWith(fxl::StringView str, fxl::StringView prefix) {
+  return str.size() >= prefix.size() &&
+         str.substr(0, prefix.size()) == prefix;
+}
+
+// Appends the fully-qualified names of all nodes under the given one that
+// have functions.
+void CollectNames(CompactSymbolTree::Node node, const std::string& prefix,
+                  std::vector<std::string>* output) {
+  for (size_t i = 0; i < node.child_count(); i++) {
+    CompactSymbolTree::Node child = node.child(i);
+    std::string name = prefix;
+    if (!name.empty())
+      name.append("::");
+    name.append(child.name().data(), child.name().size());
+
+    CollectNames(child, name, output);
+    if (child.function_die_count() > 0)
+      output->push_back(std::move(name));
+  }
+}
+
+}  // namespace
+
+SymbolSearchIndex::SymbolSearchIndex() : name_offsets_(1, 0) {
+  trigram_postings_begin_.push_back(0);
+}
+
+SymbolSearchIndex::SymbolSearchIndex(CompactSymbolTree::Node root)
+    : SymbolSearchIndex() {
+  std::vector<std::string> names;
+  CollectNames(root, std::string(), &names);
+  std::sort(names.begin(), names.end());
+
+  size_t total_size = 0;
+  for (const auto& name : names)
+    total_size += name.size();
+  names_.reserve(total_size);
+  name_offsets_.reserve(names.size() + 1);
+  for (const auto& name : names) {
+    names_.append(name);
+    name_offsets_.push_back(static_cast<uint32_t>(names_.size()));
+  }
+  names.clear();
+  names.shrink_to_fit();
+
+  folded_names_ = FoldString(names_);
+
+  folded_order_.resize(name_count());
+  for (uint32_t i = 0; i < folded_order_.size(); i++)
+    folded_order_[i] = i;
+  std::stable_sort(folded_order_.begin(), folded_order_.end(),
+                   [this](uint32_t a, uint32_t b) {
+                     return FoldedNameAt(a) < FoldedNameAt(b);
+                   });
+
+  BuildTrigramIndex();
+}
+
+SymbolSearchIndex::~SymbolSearchIndex() = default;
+
+SymbolSearchIndex::SymbolSearchIndex(SymbolSearchIndex&&) = default;
+SymbolSearchIndex& SymbolSearchIndex::operator=(SymbolSearchIndex&&) = default;
+
+size_t SymbolSearchIndex::MemoryUsage() const {
+  return sizeof(SymbolSearchIndex) + names_.capacity() +
+         folded_names_.capacity() +
+         sizeof(uint32_t) *
+             (name_offsets_.capacity() + folded_order_.capacity() +
+              trigrams_.capacity() + trigram_postings_begin_.capacity() +
+              postings_.capacity());
+}
+
+std::vector<std::string> SymbolSearchIndex::Search(
+    const SymbolSearchQuery& query) const {
+  std::vector<std::string> result;
+  std::string folded_text = FoldString(query.text);
+
+  // Returns true if the name at the given index contains the text according
+  // to the query.
+  auto contains = [this, &query, &folded_text](uint32_t i) {
+    if (query.case_insensitive)
+      return FoldedNameAt(i).find(folded_text) != fxl::StringView::npos;
+    return NameAt(i).find(query.text) != fxl::StringView::npos;
+  };
+
+  if (query.mode == SymbolSearchQuery::Mode::kPrefix) {
+    if (query.case_insensitive) {
+      auto begin = std::lower_bound(
+          folded_order_.begin(), folded_order_.end(), folded_text,
+          [this](uint32_t i, const std::string& text) {
+            return FoldedNameAt(i) < fxl::StringView(text);
+          });
+      for (auto cur = begin; cur != folded_order_.end() &&
+                             StartsWith(FoldedNameAt(*cur), folded_text);
+           ++cur)
+        result.push_back(NameAt(*cur).ToString());
+
+      // The folded order doesn't match the order of the real names.
+      std::sort(result.begin(), result.end());
+      if (query.max_results && result.size() > query.max_results)
+        result.resize(query.max_results);
+    } else {
+      // The names are stored sorted so the matches are one contiguous range
+      // that's already in the output order.
+      uint32_t begin = 0;
+      uint32_t end = static_cast<uint32_t>(name_count());
+      while (begin < end) {
+        uint32_t mid = begin + (end - begin) / 2;
+        if (NameAt(mid) < fxl::StringView(query.text))
+          begin = mid + 1;
+        else
+          end = mid;
+      }
+      for (uint32_t i = begin; i < name_count() &&
+                               StartsWith(NameAt(i), query.text);
+           i++) {
+        if (query.max_results && result.size() == query.max_results)
+          break;
+        result.push_back(NameAt(i).ToString());
+      }
+    }
+    return result;
+  }
+
+  // Substring matching. The candidates and names are in sorted order so the
+  // results can be generated in order.
+  if (folded_text.size() < kTrigramSize) {
+    // Too short to use the trigram index, but short queries are also the
+    // ones that tend to match quickly so a linear scan is OK.
+    for (uint32_t i = 0; i < name_count(); i++) {
+      if (query.max_results && result.size() == query.max_results)
+        break;
+      if (contains(i))
+        result.push_back(NameAt(i).ToString());
+    }
+    return result;
+  }
+
+  std::vector<uint32_t> candidates;
+  if (!GetSubstringCandidates(folded_text, &candidates))
+    return result;
+  for (uint32_t i : candidates) {
+    if (query.max_results && result.size() == query.max_results)
+      break;
+    if (contains(i))
+      result.push_back(NameAt(i).ToString());
+  }
+  return result;
+}
+
+fxl::StringView SymbolSearchIndex::NameAt(uint32_t i) const {
+  return fxl::StringView(&names_.data()[name_offsets_[i]],
+                         name_offsets_[i + 1] - name_offsets_[i]);
+}
+
+fxl::StringView SymbolSearchIndex::FoldedNameAt(uint32_t i) const {
+  return fxl::StringView(&folded_names_.data()[name_offsets_[i]],
+                         name_offsets_[i + 1] - name_offsets_[i]);
+}
+
+void SymbolSearchIndex::BuildTrigramIndex() {
+  // This is done in two passes to avoid having a temporary list of every
+  // (trigram, name) pair which can be very large. The first pass counts the
+  // names for each trigram, and the second fills in the postings.
+  std::unordered_map<uint32_t, uint32_t> counts;
+  std::vector<uint32_t> name_trigrams;
+  for (uint32_t i = 0; i < name_count(); i++) {
+    GetTrigrams(FoldedNameAt(i), &name_trigrams);
+    for (uint32_t trigram : name_trigrams)
+      counts[trigram]++;
+  }
+
+  trigrams_.reserve(counts.size());
+  for (const auto& pair : counts)
+    trigrams_.push_back(pair.first);
+  std::sort(trigrams_.begin(), trigrams_.end());
+
+  trigram_postings_begin_.resize(trigrams_.size() + 1);
+  trigram_postings_begin_[0] = 0;
+  for (size_t i = 0; i < trigrams_.size(); i++) {
+    trigram_postings_begin_[i + 1] =
+        trigram_postings_begin_[i] + counts[trigrams_[i]];
+  }
+  counts.clear();
+
+  // The postings are filled in name order so each list is sorted.
+  postings_.resize(trigram_postings_begin_.back());
+  std::vector<uint32_t> fill(trigram_postings_begin_.begin(),
+                             trigram_postings_begin_.end() - 1);
+  for (uint32_t i = 0; i < name_count(); i++) {
+    GetTrigrams(FoldedNameAt(i), &name_trigrams);
+    for (uint32_t trigram : name_trigrams) {
+      size_t trigram_index =
+          std::lower_bound(trigrams_.begin(), trigrams_.end(), trigram) -
+          trigrams_.begin();
+      postings_[fill[trigram_index]++] = i;
+    }
+  }
+}
+
+bool SymbolSearchIndex::GetSubstringCandidates(
+    fxl::StringView folded_text, std::vector<uint32_t>* output) const {
+  FXL_DCHECK(folded_text.size() >= kTrigramSize);
+
+  std::vector<uint32_t> query_trigrams;
+  GetTrigrams(folded_text, &query_trigrams);
+
+  // Look up the posting list for each trigram, failing if any is missing.
+  struct Range {
+    const uint32_t* begin;
+    const uint32_t* end;
+  };
+  std::vector<Range> ranges;
+  for (uint32_t trigram : query_trigrams) {
+    auto found = std::lower_bound(trigrams_.begin(), trigrams_.end(), trigram);
+    if (found == trigrams_.end() || *found != trigram)
+      return false;
+    size_t index = found - trigrams_.begin();
+    ranges.push_back({&postings_.data()[trigram_postings_begin_[index]],
+                      &postings_.data()[trigram_postings_begin_[index + 1]]});
+  }
+
+  // Intersect starting with the shortest list to keep the working set small.
+  std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) {
+    return a.end - a.begin < b.end - b.begin;
+  });
+  output->assign(ranges[0].begin, ranges[0].end);
+  std::vector<uint32_t> intersection;
+  for (size_t i = 1; i < ranges.size() && !output->empty(); i++) {
+    intersection.clear();
+    std::set_intersection(output->begin(), output->end(), ranges[i].begin,
+                          ranges[i].end, std::back_inserter(intersection));
+    output->swap(intersection);
+  }
+  return !output->empty();
+}
+
+}  // namespace zxdb
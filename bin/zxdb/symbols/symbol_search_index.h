@@ -0,0 +1,90 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "garnet/bin/zxdb/symbols/compact_symbol_tree.h"
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
+#include "garnet/public/lib/fxl/macros.h"
+#include "garnet/public/lib/fxl/strings/string_view.h"
+
+namespace zxdb {
+
+// A secondary index over the fully-qualified function names in a
+// CompactSymbolTree that supports prefix, substring, and case-insensitive
+// lookup.
+//
+// The tree is only good for exact lookups since it's keyed by each component
+// of the name. This index flattens it into a list of qualified names
+// ("ns::Class<int>::Fn") stored in sorted order in one string pool, plus:
+//
+//   - A lowercased copy of the pool and a permutation that sorts it, for
+//     case-insensitive prefix lookups.
+//   - A trigram index mapping each three-character sequence (of the
+//     lowercased names) to the sorted list of names containing it. Substring
+//     lookups intersect the lists for the query's trigrams and then verify
+//     the few remaining candidates.
+class SymbolSearchIndex {
+ public:
+  // Creates an empty index.
+  SymbolSearchIndex();
+
+  // Indexes all names in the given tree that have function DIEs.
+  explicit SymbolSearchIndex(CompactSymbolTree::Node root);
+
+  ~SymbolSearchIndex();
+
+  SymbolSearchIndex(SymbolSearchIndex&&);
+  SymbolSearchIndex& operator=(SymbolSearchIndex&&);
+
+  size_t name_count() const { return name_offsets_.size() - 1; }
+
+  // Returns the approximate number of bytes of memory used by the index.
+  size_t MemoryUsage() const;
+
+  // Returns the matching fully-qualified names, sorted.
+  std::vector<std::string> Search(const SymbolSearchQuery& query) const;
+
+ private:
+  fxl::StringView NameAt(uint32_t i) const;
+  fxl::StringView FoldedNameAt(uint32_t i) const;
+
+  void BuildTrigramIndex();
+
+  // Fills |*output| with the indices of names that might contain the given
+  // lowercased text, which must be at least 3 characters. Returns false if
+  // no name can match.
+  bool GetSubstringCandidates(fxl::StringView folded_text,
+                              std::vector<uint32_t>* output) const;
+
+  // All names, concatenated in sorted order. Name i is the range
+  // [name_offsets_[i], name_offsets_[i + 1]) so there is always one more
+  // offset than names.
+  std::string names_;
+  std::vector<uint32_t> name_offsets_;
+
+  // The names_ pool with ASCII letters lowercased. The offsets are the same.
+  std::string folded_names_;
+
+  // Name indices sorted by their folded value.
+  std::vector<uint32_t> folded_order_;
+
+  // Trigram index. |trigrams_| is the sorted list of distinct trigrams (the
+  // three bytes packed into an integer). The names containing trigrams_[i]
+  // are in postings_ in the range
+  // [trigram_postings_begin_[i], trigram_postings_begin_[i + 1]), sorted by
+  // name index.
+  std::vector<uint32_t> trigrams_;
+  std::vector<uint32_t> trigram_postings_begin_;
+  std::vector<uint32_t> postings_;
+
+  FXL_DISALLOW_COPY_AND_ASSIGN(SymbolSearchIndex);
+};
+
+}  // namespace zxdb
@@ -0,0 +1,170 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/symbols/symbol_search_index.h"
+
+#include <algorithm>
+
+#include "garnet/public/lib/fxl/arraysize.h"
+#include "garnet/public/lib/fxl/strings/string_printf.h"
+#include "gtest/gtest.h"
+
+namespace zxdb {
+
+namespace {
+
+using DieRef = ModuleSymbolIndexNode::DieRef;
+using Mode = SymbolSearchQuery::Mode;
+
+// Builds the tree (nodes with no functions don't get indexed):
+//   [root]
+//     ns
+//       Foo<int> [function]
+//         Init [function]
+//       FooBar [function]
+//     main [function]
+//     MainLoop
+//       Run [function]
+CompactSymbolTree MakeTestTree() {
+  ModuleSymbolIndexNode root;
+  ModuleSymbolIndexNode* ns = root.AddChild("ns");
+  ModuleSymbolIndexNode* foo = ns->AddChild("Foo<int>");
+  foo->AddFunctionDie(DieRef(1));
+  foo->AddChild("Init")->AddFunctionDie(DieRef(2));
+  ns->AddChild("FooBar")->AddFunctionDie(DieRef(3));
+  root.AddChild("main")->AddFunctionDie(DieRef(4));
+  root.AddChild("MainLoop")->AddChild("Run")->AddFunctionDie(DieRef(5));
+  return CompactSymbolTree(root);
+}
+
+SymbolSearchQuery MakeQuery(const std::string& text, Mode mode,
+                            bool case_insensitive = false,
+                            size_t max_results = 0) {
+  SymbolSearchQuery query(text, mode);
+  query.case_insensitive = case_insensitive;
+  query.max_results = max_results;
+  return query;
+}
+
+}  // namespace
+
+TEST(SymbolSearchIndex, Empty) {
+  SymbolSearchIndex index;
+  EXPECT_EQ(0u, index.name_count());
+  EXPECT_TRUE(index.Search(MakeQuery("", Mode::kPrefix)).empty());
+  EXPECT_TRUE(index.Search(MakeQuery("foo", Mode::kSubstring)).empty());
+}
+
+TEST(SymbolSearchIndex, Prefix) {
+  CompactSymbolTree tree = MakeTestTree();
+  SymbolSearchIndex index(tree.root());
+  EXPECT_EQ(5u, index.name_count());
+
+  // Everything matches the empty prefix, in sorted order.
+  std::vector<std::string> expected{"MainLoop::Run", "main", "ns::Foo<int>",
+                                    "ns::Foo<int>::Init", "ns::FooBar"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("", Mode::kPrefix)));
+
+  expected = {"ns::Foo<int>", "ns::Foo<int>::Init", "ns::FooBar"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("ns::Foo", Mode::kPrefix)));
+
+  expected = {"ns::Foo<int>", "ns::Foo<int>::Init"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("ns::Foo<", Mode::kPrefix)));
+
+  // Case sensitivity.
+  expected = {"main"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("mai", Mode::kPrefix)));
+  expected = {"MainLoop::Run", "main"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("MAI", Mode::kPrefix, true)));
+
+  // Limit.
+  expected = {"ns::Foo<int>"};
+  EXPECT_EQ(expected,
+            index.Search(MakeQuery("ns::Foo", Mode::kPrefix, false, 1)));
+  expected = {"MainLoop::Run"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("main", Mode::kPrefix, true, 1)));
+
+  EXPECT_TRUE(index.Search(MakeQuery("ns::Baz", Mode::kPrefix)).empty());
+  EXPECT_TRUE(index.Search(MakeQuery("zzz", Mode::kPrefix)).empty());
+}
+
+TEST(SymbolSearchIndex, Substring) {
+  CompactSymbolTree tree = MakeTestTree();
+  SymbolSearchIndex index(tree.root());
+
+  // Short queries (no trigrams).
+  std::vector<std::string> expected{"MainLoop::Run"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("R", Mode::kSubstring)));
+  expected = {"MainLoop::Run", "ns::FooBar"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("R", Mode::kSubstring, true)));
+  expected = {"MainLoop::Run", "ns::Foo<int>",
+              "ns::Foo<int>::Init", "ns::FooBar"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("::", Mode::kSubstring)));
+
+  // Matches across name components.
+  expected = {"ns::Foo<int>::Init"};
+  EXPECT_EQ(expected, index.Search(MakeQuery(">::In", Mode::kSubstring)));
+
+  // The trigram index is case-insensitive so case-sensitive lookups need to
+  // filter the candidates.
+  expected = {"ns::FooBar"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("Bar", Mode::kSubstring)));
+  EXPECT_TRUE(index.Search(MakeQuery("bar", Mode::kSubstring)).empty());
+  EXPECT_EQ(expected, index.Search(MakeQuery("bar", Mode::kSubstring, true)));
+
+  expected = {"MainLoop::Run", "main"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("ain", Mode::kSubstring)));
+  expected = {"MainLoop::Run"};
+  EXPECT_EQ(expected, index.Search(MakeQuery("ain", Mode::kSubstring, false,
+                                             1)));
+
+  // Each trigram is present but never in the same name.
+  EXPECT_TRUE(index.Search(MakeQuery("ns::Run", Mode::kSubstring)).empty());
+  EXPECT_TRUE(index.Search(MakeQuery("xyz", Mode::kSubstring)).empty());
+}
+
+// Compares the index to the brute-force matching on a larger generated set
+// of names.
+TEST(SymbolSearchIndex, MatchesBruteForce) {
+  const char* kComponents[] = {"std", "vector<int>", "Foo", "foo", "Bar",
+                               "Init", "init", "a", "AB", "operator<"};
+  ModuleSymbolIndexNode root;
+  std::vector<std::string> all_names;
+  for (size_t i = 0; i < arraysize(kComponents); i++) {
+    ModuleSymbolIndexNode* outer = root.AddChild(kComponents[i]);
+    for (size_t j = 0; j < arraysize(kComponents); j++) {
+      if ((i + j) % 3 == 0)
+        continue;
+      outer->AddChild(kComponents[j])->AddFunctionDie(DieRef(i * 100 + j));
+      all_names.push_back(std::string(kComponents[i]) + "::" + kComponents[j]);
+    }
+  }
+  std::sort(all_names.begin(), all_names.end());
+
+  CompactSymbolTree tree(root);
+  SymbolSearchIndex index(tree.root());
+  ASSERT_EQ(all_names.size(), index.name_count());
+
+  const char* kQueries[] = {"",     "a",     "A",    "in",   "IN",  "::",
+                            "t::f", "o::In", "<int", "std:", "ar::", "foo"};
+  for (const char* text : kQueries) {
+    for (Mode mode : {Mode::kPrefix, Mode::kSubstring}) {
+      for (bool case_insensitive : {false, true}) {
+        SymbolSearchQuery query = MakeQuery(text, mode, case_insensitive);
+
+        std::vector<std::string> expected;
+        for (const auto& name : all_names) {
+          if (query.Matches(name))
+            expected.push_back(name);
+        }
+        EXPECT_EQ(expected, index.Search(query))
+            << fxl::StringPrintf("Query \"%s\" mode %d case_insensitive %d",
+                                 text, static_cast<int>(mode),
+                                 case_insensitive);
+      }
+    }
+  }
+}
+
+}  // namespace zxdb
@@ -0,0 +1,29 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "garnet/bin/zxdb/symbols/symbol_search_query.h"
+
+#include <ctype.h>
+
+#include <algorithm>
+
+namespace zxdb {
+
+bool SymbolSearchQuery::Matches(const std::string& name) const {
+  auto equal = [this](char a, char b) {
+    if (case_insensitive)
+      return tolower(static_cast<unsigned char>(a)) ==
+             tolower(static_cast<unsigned char>(b));
+    return a == b;
+  };
+
+  if (mode == Mode::kPrefix) {
+    return name.size() >= text.size() &&
+           std::equal(text.begin(), text.end(), name.begin(), equal);
+  }
+  return std::search(name.begin(), name.end(), text.begin(), text.end(),
+                     equal) != name.end();
+}
+
+}  // namespace zxdb
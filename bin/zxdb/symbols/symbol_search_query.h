@@ -0,0 +1,49 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+#include <utility>
+
+namespace zxdb {
+
+// Describes a search for function names. Unlike ResolveInputLocation (which
+// requires an exact fully-qualified name), this can match partial names and
+// is used for things like listing matching symbols and suggesting names when
+// a lookup fails.
+struct SymbolSearchQuery {
+  enum class Mode {
+    // The fully-qualified name must start with the text ("Foo::B" matches
+    // "Foo::Bar").
+    kPrefix,
+
+    // The text can appear anywhere in the fully-qualified name ("Bar" matches
+    // "Foo::Bar<int>").
+    kSubstring,
+  };
+
+  SymbolSearchQuery() = default;
+  SymbolSearchQuery(std::string t, Mode m) : text(std::move(t)), mode(m) {}
+
+  // Returns true if the given fully-qualified name matches this query. This
+  // is a slow linear check, the real symbol implementation uses an index (see
+  // SymbolSearchIndex).
+  bool Matches(const std::string& name) const;
+
+  std::string text;
+  Mode mode = Mode::kSubstring;
+
+  // When set, ASCII letters are compared without regard to case.
+  bool case_insensitive = false;
+
+  // The maximum number of results to return. 0 means no limit. When there are
+  // more matches than this, which ones are returned is unspecified except
+  // that they will be sorted.
+  size_t max_results = 0;
+};
+
+}  // namespace zxdb
@@ -6,6 +6,7 @@
 
 #include "garnet/bin/zxdb/common/file_util.h"
 #include "garnet/bin/zxdb/common/host_util.h"
+#include "garnet/bin/zxdb/symbols/module_symbol_index_cache.h"
 #include "garnet/bin/zxdb/symbols/module_symbols_impl.h"
 #include "garnet/public/lib/fxl/strings/string_printf.h"
 
@@ -69,6 +70,16 @@ SystemSymbols::~SystemSymbols() {
   modules_.clear();
 }
 
+void SystemSymbols::SetIndexCacheDir(const std::string& dir) {
+  if (dir.empty()) {
+    index_cache_.reset();
+    build_id_index_.SetCacheFile(std::string());
+  } else {
+    index_cache_ = std::make_unique<ModuleSymbolIndexCache>(dir);
+    build_id_index_.SetCacheFile(CatPathComponents(dir, "build_ids.txt"));
+  }
+}
+
 fxl::RefPtr<SystemSymbols::ModuleRef> SystemSymbols::InjectModuleForTesting(
     const std::string& build_id, std::unique_ptr<ModuleSymbols> module) {
   // Can't inject a module that already exists.
@@ -99,7 +110,7 @@ Err SystemSymbols::GetModule(const std::string& name_for_msg,
 
   auto module_symbols =
       std::make_unique<ModuleSymbolsImpl>(file_name, build_id);
-  Err err = module_symbols->Load();
+  Err err = module_symbols->Load(index_cache_.get());
   if (err.has_error())
     return err;
 
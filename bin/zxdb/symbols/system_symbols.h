@@ -14,6 +14,7 @@
 
 namespace zxdb {
 
+class ModuleSymbolIndexCache;
 class ModuleSymbols;
 
 // Tracks a global view of all ModuleSymbols objects. Since each object is
@@ -59,6 +60,11 @@ class SystemSymbols {
 
   BuildIDIndex& build_id_index() { return build_id_index_; }
 
+  // Sets the directory used to cache indexing information between sessions:
+  // module symbol indices, and the build IDs of files in the symbol
+  // directories. An empty string disables the cache (the default).
+  void SetIndexCacheDir(const std::string& dir);
+
   // Injects a ModuleSymbols object for the given build ID. Used for testing.
   // Normally the test would provide a dummy implementation for ModuleSymbols.
   // Ownership of the symbols will be transferred to the returned refcounted
@@ -88,6 +94,9 @@ class SystemSymbols {
 
   BuildIDIndex build_id_index_;
 
+  // May be null if there is no cache.
+  std::unique_ptr<ModuleSymbolIndexCache> index_cache_;
+
   // Index from module build ID to a non-owning ModuleRef pointer. The
   // ModuleRef will notify us when it's being deleted so the pointers stay
   // up-to-date.
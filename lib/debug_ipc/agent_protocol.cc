@@ -43,6 +43,12 @@ bool Deserialize(MessageReader* reader, RegisterCategory::Type* type) {
   return reader->ReadUint32(reinterpret_cast<uint32_t*>(type));
 }
 
+bool Deserialize(MessageReader* reader, MemoryRange* range) {
+  if (!reader->ReadUint64(&range->address))
+    return false;
+  return reader->ReadUint32(&range->size);
+}
+
 // Record serializers ----------------------------------------------------------
 
 void Serialize(const ProcessTreeRecord& record, MessageWriter* writer) {
@@ -63,7 +69,7 @@ void Serialize(const MemoryBlock& block, MessageWriter* writer) {
   writer->WriteBool(block.valid);
   writer->WriteUint32(block.size);
   if (block.valid && block.size > 0)
-    writer->WriteBytes(&block.data[0], block.size);
+    writer->WriteBytesReference(&block.data[0], block.size);
 }
 
 void Serialize(const Module& module, MessageWriter* writer) {
@@ -88,6 +94,11 @@ void Serialize(const StackFrame& frame, MessageWriter* writer) {
   writer->WriteBytes(&frame, sizeof(StackFrame));
 }
 
+void Serialize(const ThreadBacktrace& backtrace, MessageWriter* writer) {
+  writer->WriteUint64(backtrace.thread_koid);
+  Serialize(backtrace.frames, writer);
+}
+
 void Serialize(const AddressRegion& region, MessageWriter* writer) {
   writer->WriteString(region.name);
   writer->WriteUint64(region.base);
@@ -294,6 +305,25 @@ void WriteReply(const ReadMemoryReply& reply, uint32_t transaction_id,
   Serialize(reply.blocks, writer);
 }
 
+// ReadMemoryRanges ------------------------------------------------------------
+
+bool ReadRequest(MessageReader* reader, ReadMemoryRangesRequest* request,
+                 uint32_t* transaction_id) {
+  MsgHeader header;
+  if (!reader->ReadHeader(&header))
+    return false;
+  *transaction_id = header.transaction_id;
+  if (!reader->ReadUint64(&request->process_koid))
+    return false;
+  return Deserialize(reader, &request->ranges);
+}
+
+void WriteReply(const ReadMemoryRangesReply& reply, uint32_t transaction_id,
+                MessageWriter* writer) {
+  writer->WriteHeader(MsgHeader::Type::kReadMemoryRanges, transaction_id);
+  Serialize(reply.blocks, writer);
+}
+
 // AddOrChangeBreakpoint -------------------------------------------------------
 
 bool ReadRequest(MessageReader* reader, AddOrChangeBreakpointRequest* request,
@@ -344,6 +374,25 @@ void WriteReply(const BacktraceReply& reply, uint32_t transaction_id,
   Serialize(reply.frames, writer);
 }
 
+// Backtraces ------------------------------------------------------------------
+
+bool ReadRequest(MessageReader* reader, BacktracesRequest* request,
+                 uint32_t* transaction_id) {
+  MsgHeader header;
+  if (!reader->ReadHeader(&header))
+    return false;
+  *transaction_id = header.transaction_id;
+  if (!reader->ReadUint64(&request->process_koid))
+    return false;
+  return Deserialize(reader, &request->thread_koids);
+}
+
+void WriteReply(const BacktracesReply& reply, uint32_t transaction_id,
+                MessageWriter* writer) {
+  writer->WriteHeader(MsgHeader::Type::kBacktraces, transaction_id);
+  Serialize(reply.backtraces, writer);
+}
+
 // Modules ---------------------------------------------------------------------
 
 bool ReadRequest(MessageReader* reader, ModulesRequest* request,
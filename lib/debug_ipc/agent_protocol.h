@@ -71,6 +71,12 @@ bool ReadRequest(MessageReader* reader, ReadMemoryRequest* request,
 void WriteReply(const ReadMemoryReply& reply, uint32_t transaction_id,
                 MessageWriter* writer);
 
+// ReadMemoryRanges.
+bool ReadRequest(MessageReader* reader, ReadMemoryRangesRequest* request,
+                 uint32_t* transaction_id);
+void WriteReply(const ReadMemoryRangesReply& reply, uint32_t transaction_id,
+                MessageWriter* writer);
+
 // AddOrChangeBreakpoint.
 bool ReadRequest(MessageReader* reader, AddOrChangeBreakpointRequest* request,
                  uint32_t* transaction_id);
@@ -89,6 +95,12 @@ bool ReadRequest(MessageReader* reader, BacktraceRequest* request,
 void WriteReply(const BacktraceReply& reply, uint32_t transaction_id,
                 MessageWriter* writer);
 
+// Backtraces
+bool ReadRequest(MessageReader* reader, BacktracesRequest* request,
+                 uint32_t* transaction_id);
+void WriteReply(const BacktracesReply& reply, uint32_t transaction_id,
+                MessageWriter* writer);
+
 // Modules
 bool ReadRequest(MessageReader* reader, ModulesRequest* request,
                  uint32_t* transaction_id);
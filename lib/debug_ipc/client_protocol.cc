@@ -45,12 +45,13 @@ bool Deserialize(MessageReader* reader, MemoryBlock* block) {
   if (!reader->ReadUint32(&block->size))
     return false;
   if (block->valid) {
-    if (block->size > reader->remaining())
-      return false;
-
-    block->data.resize(block->size);
-    if (!reader->ReadBytes(block->size, &block->data[0]))
+    // Copy directly from the message rather than zero-filling the block and
+    // then reading into it.
+    const char* data = nullptr;
+    if (!reader->ReadBytesView(block->size, &data))
       return false;
+    block->data.assign(reinterpret_cast<const uint8_t*>(data),
+                       reinterpret_cast<const uint8_t*>(data) + block->size);
   }
   return true;
 }
@@ -86,6 +87,12 @@ bool Deserialize(MessageReader* reader, StackFrame* frame) {
   return reader->ReadBytes(sizeof(StackFrame), frame);
 }
 
+bool Deserialize(MessageReader* reader, ThreadBacktrace* backtrace) {
+  if (!reader->ReadUint64(&backtrace->thread_koid))
+    return false;
+  return Deserialize(reader, &backtrace->frames);
+}
+
 bool Deserialize(MessageReader* reader, BreakpointStats* stats) {
   if (!reader->ReadUint32(&stats->breakpoint_id))
     return false;
@@ -127,6 +134,11 @@ void Serialize(const RegisterCategory::Type& type, MessageWriter* writer) {
   writer->WriteUint32(static_cast<uint32_t>(type));
 }
 
+void Serialize(const MemoryRange& range, MessageWriter* writer) {
+  writer->WriteUint64(range.address);
+  writer->WriteUint32(range.size);
+}
+
 // Hello -----------------------------------------------------------------------
 
 void WriteRequest(const HelloRequest& request, uint32_t transaction_id,
@@ -321,6 +333,25 @@ bool ReadReply(MessageReader* reader, ReadMemoryReply* reply,
   return Deserialize(reader, &reply->blocks);
 }
 
+// ReadMemoryRanges ------------------------------------------------------------
+
+void WriteRequest(const ReadMemoryRangesRequest& request,
+                  uint32_t transaction_id, MessageWriter* writer) {
+  writer->WriteHeader(MsgHeader::Type::kReadMemoryRanges, transaction_id);
+  writer->WriteUint64(request.process_koid);
+  Serialize(request.ranges, writer);
+}
+
+bool ReadReply(MessageReader* reader, ReadMemoryRangesReply* reply,
+               uint32_t* transaction_id) {
+  MsgHeader header;
+  if (!reader->ReadHeader(&header))
+    return false;
+  *transaction_id = header.transaction_id;
+
+  return Deserialize(reader, &reply->blocks);
+}
+
 // Registers -------------------------------------------------------------------
 
 void WriteRequest(const RegistersRequest& request, uint32_t transaction_id,
@@ -396,6 +427,25 @@ bool ReadReply(MessageReader* reader, BacktraceReply* reply,
   return true;
 }
 
+// Backtraces ------------------------------------------------------------------
+
+void WriteRequest(const BacktracesRequest& request, uint32_t transaction_id,
+                  MessageWriter* writer) {
+  writer->WriteHeader(MsgHeader::Type::kBacktraces, transaction_id);
+  writer->WriteUint64(request.process_koid);
+  Serialize(request.thread_koids, writer);
+}
+
+bool ReadReply(MessageReader* reader, BacktracesReply* reply,
+               uint32_t* transaction_id) {
+  MsgHeader header;
+  if (!reader->ReadHeader(&header))
+    return false;
+  *transaction_id = header.transaction_id;
+
+  return Deserialize(reader, &reply->backtraces);
+}
+
 // Modules ---------------------------------------------------------------------
 
 void WriteRequest(const ModulesRequest& request, uint32_t transaction_id,
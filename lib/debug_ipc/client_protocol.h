@@ -71,6 +71,12 @@ void WriteRequest(const ReadMemoryRequest& request, uint32_t transaction_id,
 bool ReadReply(MessageReader* reader, ReadMemoryReply* reply,
                uint32_t* transaction_id);
 
+// ReadMemoryRanges.
+void WriteRequest(const ReadMemoryRangesRequest& request,
+                  uint32_t transaction_id, MessageWriter* writer);
+bool ReadReply(MessageReader* reader, ReadMemoryRangesReply* reply,
+               uint32_t* transaction_id);
+
 // Registers
 void WriteRequest(const RegistersRequest& request, uint32_t transaction_id,
                   MessageWriter* writer);
@@ -95,6 +101,12 @@ void WriteRequest(const BacktraceRequest& request, uint32_t transaction_id,
 bool ReadReply(MessageReader* reader, BacktraceReply* reply,
                uint32_t* transaction_id);
 
+// Backtraces.
+void WriteRequest(const BacktracesRequest& request, uint32_t transaction_id,
+                  MessageWriter* writer);
+bool ReadReply(MessageReader* reader, BacktracesReply* reply,
+               uint32_t* transaction_id);
+
 // Modules.
 void WriteRequest(const ModulesRequest& request, uint32_t transaction_id,
                   MessageWriter* writer);
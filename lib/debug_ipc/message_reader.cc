@@ -22,6 +22,14 @@ bool MessageReader::ReadBytes(uint32_t len, void* output) {
   return true;
 }
 
+bool MessageReader::ReadBytesView(uint32_t len, const char** output) {
+  if (message_.size() - offset_ < len)
+    return SetError();
+  *output = message_.data() + offset_;
+  offset_ += len;
+  return true;
+}
+
 bool MessageReader::ReadInt32(int32_t* output) {
   return ReadBytes(sizeof(int32_t), output);
 }
@@ -44,13 +52,12 @@ bool MessageReader::ReadString(std::string* output) {
     return SetError();
 
   // String bytes.
-  output->resize(str_len);
-  if (str_len == 0)
-    return true;
-  if (!ReadBytes(str_len, &(*output)[0])) {
+  const char* data = nullptr;
+  if (!ReadBytesView(str_len, &data)) {
     *output = std::string();
     return SetError();
   }
+  output->assign(data, str_len);
   return true;
 }
 
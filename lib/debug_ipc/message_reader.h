@@ -24,6 +24,13 @@ class MessageReader {
 
   // These functions return true on success.
   bool ReadBytes(uint32_t len, void* output);
+
+  // Like ReadBytes() but returns a pointer to the data inside the message
+  // rather than copying it. The pointer is valid for the lifetime of the
+  // reader. This allows large blobs to be copied directly to their final
+  // destination.
+  bool ReadBytesView(uint32_t len, const char** output);
+
   bool ReadInt32(int32_t* output);
   bool ReadUint32(uint32_t* output);
   bool ReadInt64(int64_t* output);
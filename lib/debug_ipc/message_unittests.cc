@@ -94,4 +94,62 @@ TEST(Message, ReadWriteNumbers) {
   EXPECT_TRUE(reader.has_error());
 }
 
+TEST(Message, WriteBytesReference) {
+  const char referenced1[] = "abc";
+  const char referenced2[] = "defgh";
+
+  MessageWriter writer;
+  writer.WriteUint32(0);  // Message size header.
+  writer.WriteBytesReference(referenced1, 3);
+  writer.WriteUint32(0x12345678);
+  writer.WriteBytesReference(referenced2, 5);
+  writer.WriteBytesReference(referenced1, 0);  // Empty write is ignored.
+  writer.WriteBytesReference(referenced1, 1);
+  EXPECT_EQ(17u, writer.size());
+
+  std::vector<char> message = writer.MessageComplete();
+  ASSERT_EQ(17u, message.size());
+
+  MessageReader reader(std::move(message));
+  uint32_t read_message_size = 0;
+  ASSERT_TRUE(reader.ReadUint32(&read_message_size));
+  EXPECT_EQ(17u, read_message_size);
+
+  // Referenced data should be interleaved with the inline data in the order
+  // it was written.
+  char read_bytes[5];
+  ASSERT_TRUE(reader.ReadBytes(3, read_bytes));
+  EXPECT_EQ("abc", std::string(read_bytes, 3));
+  uint32_t read_uint32 = 0;
+  ASSERT_TRUE(reader.ReadUint32(&read_uint32));
+  EXPECT_EQ(0x12345678u, read_uint32);
+  ASSERT_TRUE(reader.ReadBytes(5, read_bytes));
+  EXPECT_EQ("defgh", std::string(read_bytes, 5));
+  ASSERT_TRUE(reader.ReadBytes(1, read_bytes));
+  EXPECT_EQ('a', read_bytes[0]);
+  EXPECT_EQ(0u, reader.remaining());
+}
+
+TEST(Message, ReadBytesView) {
+  MessageWriter writer;
+  writer.WriteUint32(0);  // Message size header.
+  writer.WriteBytes("hello", 5);
+
+  MessageReader reader(writer.MessageComplete());
+  uint32_t read_message_size = 0;
+  ASSERT_TRUE(reader.ReadUint32(&read_message_size));
+
+  const char* view = nullptr;
+  ASSERT_TRUE(reader.ReadBytesView(5, &view));
+  EXPECT_EQ("hello", std::string(view, 5));
+
+  // Empty views are valid at the end.
+  EXPECT_TRUE(reader.ReadBytesView(0, &view));
+
+  // Reading past the end should fail.
+  EXPECT_FALSE(reader.has_error());
+  EXPECT_FALSE(reader.ReadBytesView(1, &view));
+  EXPECT_TRUE(reader.has_error());
+}
+
 }  // namespace debug_ipc
@@ -28,6 +28,14 @@ void MessageWriter::WriteBytes(const void* data, uint32_t len) {
   buffer_.insert(buffer_.end(), begin, end);
 }
 
+void MessageWriter::WriteBytesReference(const void* data, uint32_t len) {
+  if (len == 0)
+    return;
+  references_.push_back(
+      Reference{buffer_.size(), static_cast<const char*>(data), len});
+  referenced_size_ += len;
+}
+
 void MessageWriter::WriteInt32(int32_t i) { WriteBytes(&i, sizeof(int32_t)); }
 void MessageWriter::WriteUint32(uint32_t i) {
   WriteBytes(&i, sizeof(uint32_t));
@@ -54,9 +62,27 @@ void MessageWriter::WriteHeader(MsgHeader::Type type, uint32_t transaction_id) {
 }
 
 std::vector<char> MessageWriter::MessageComplete() {
-  uint32_t size = static_cast<uint32_t>(buffer_.size());
+  uint32_t size = static_cast<uint32_t>(this->size());
   memcpy(&buffer_[0], &size, sizeof(uint32_t));
-  return std::move(buffer_);
+  if (references_.empty())
+    return std::move(buffer_);
+
+  // Gather the inline and referenced pieces.
+  std::vector<char> result;
+  result.reserve(size);
+  size_t buffer_offset = 0;
+  for (const Reference& ref : references_) {
+    result.insert(result.end(), buffer_.begin() + buffer_offset,
+                  buffer_.begin() + ref.offset);
+    result.insert(result.end(), ref.data, ref.data + ref.len);
+    buffer_offset = ref.offset;
+  }
+  result.insert(result.end(), buffer_.begin() + buffer_offset, buffer_.end());
+
+  buffer_.clear();
+  references_.clear();
+  referenced_size_ = 0;
+  return result;
 }
 
 }  // namespace debug_ipc
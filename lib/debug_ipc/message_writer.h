@@ -18,6 +18,12 @@ struct MsgHeader;
 // The first 4 bytes of each message is the message size. It's assumed that
 // these bytes will be explicitly written to. Normally a message will start
 // with a struct which contains space for this explicitly.
+//
+// Large blobs (like memory blocks) can be written by reference with
+// WriteBytesReference(). These aren't copied until MessageComplete(), when
+// all pieces are gathered into a buffer of exactly the right size. This
+// avoids copying the data into the growing buffer and the re-copies as that
+// buffer is reallocated.
 class MessageWriter {
  public:
   MessageWriter();
@@ -26,6 +32,11 @@ class MessageWriter {
   ~MessageWriter();
 
   void WriteBytes(const void* data, uint32_t len);
+
+  // Like WriteBytes() but does not copy the data. The memory must remain
+  // valid and unchanged until MessageComplete() is called.
+  void WriteBytesReference(const void* data, uint32_t len);
+
   void WriteInt32(int32_t i);
   void WriteUint32(uint32_t i);
   void WriteInt64(int64_t i);
@@ -35,12 +46,27 @@ class MessageWriter {
 
   void WriteHeader(MsgHeader::Type type, uint32_t transaction_id);
 
+  // Returns the number of bytes written so far.
+  size_t size() const { return buffer_.size() + referenced_size_; }
+
   // Writes the size of the current buffer to the first 4 bytes, and
   // destructively returns the buffer.
   std::vector<char> MessageComplete();
 
  private:
+  // Memory written with WriteBytesReference() that goes before
+  // buffer_[offset].
+  struct Reference {
+    size_t offset;
+    const char* data;
+    uint32_t len;
+  };
+
   std::vector<char> buffer_;
+
+  // In order of offset.
+  std::vector<Reference> references_;
+  size_t referenced_size_ = 0;
 };
 
 }  // namespace debug_ipc
@@ -8,7 +8,7 @@
 
 namespace debug_ipc {
 
-constexpr uint32_t kProtocolVersion = 2;
+constexpr uint32_t kProtocolVersion = 4;
 
 enum class Arch { kUnknown = 0, kX64, kArm64 };
 
@@ -37,6 +37,8 @@ struct MsgHeader {
     kRemoveBreakpoint,
     kBacktrace,
     kAddressSpace,
+    kReadMemoryRanges,
+    kBacktraces,
 
     // The "notify" messages are sent unrequested from the agent to the client.
     kNotifyProcessExiting,
@@ -169,6 +171,20 @@ struct ReadMemoryReply {
   std::vector<MemoryBlock> blocks;
 };
 
+// Reads several ranges of memory in one round-trip. This is used by the
+// client to fill its memory cache so that formatting a structure or an array
+// doesn't require a separate request for each piece of memory it touches.
+struct ReadMemoryRangesRequest {
+  uint64_t process_koid = 0;
+  std::vector<MemoryRange> ranges;
+};
+struct ReadMemoryRangesReply {
+  // The blocks for all requested ranges, in the order of the request. Each
+  // range is covered exactly by one or more consecutive blocks (as in
+  // ReadMemoryReply). If the process doesn't exist, this will be empty.
+  std::vector<MemoryBlock> blocks;
+};
+
 struct AddOrChangeBreakpointRequest {
   BreakpointSettings breakpoint;
 };
@@ -199,6 +215,19 @@ struct BacktraceReply {
   std::vector<StackFrame> frames;
 };
 
+// Gets the backtraces of several threads in one round-trip.
+struct BacktracesRequest {
+  uint64_t process_koid = 0;
+
+  // When empty, all threads in the process will be included.
+  std::vector<uint64_t> thread_koids;
+};
+struct BacktracesReply {
+  // One entry for each requested thread that exists, in the order requested.
+  // The frames will be empty for threads that aren't stopped.
+  std::vector<ThreadBacktrace> backtraces;
+};
+
 struct AddressSpaceRequest {
   uint64_t process_koid = 0;
   // if non-zero |address| indicates to return only the regions
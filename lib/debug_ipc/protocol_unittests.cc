@@ -302,6 +302,53 @@ TEST(Protocol, ReadMemoryReply) {
   EXPECT_TRUE(second.blocks[1].data.empty());
 }
 
+// ReadMemoryRanges ------------------------------------------------------------
+
+TEST(Protocol, ReadMemoryRangesRequest) {
+  ReadMemoryRangesRequest initial;
+  initial.process_koid = 91823765;
+  initial.ranges.resize(2);
+  initial.ranges[0].address = 0x1000;
+  initial.ranges[0].size = 0x2000;
+  initial.ranges[1].address = 0x78000;
+  initial.ranges[1].size = 16;
+
+  ReadMemoryRangesRequest second;
+  ASSERT_TRUE(SerializeDeserializeRequest(initial, &second));
+  EXPECT_EQ(initial.process_koid, second.process_koid);
+  ASSERT_EQ(2u, second.ranges.size());
+  EXPECT_EQ(initial.ranges[0].address, second.ranges[0].address);
+  EXPECT_EQ(initial.ranges[0].size, second.ranges[0].size);
+  EXPECT_EQ(initial.ranges[1].address, second.ranges[1].address);
+  EXPECT_EQ(initial.ranges[1].size, second.ranges[1].size);
+}
+
+TEST(Protocol, ReadMemoryRangesReply) {
+  ReadMemoryRangesReply initial;
+  initial.blocks.resize(2);
+  initial.blocks[0].address = 0x1000;
+  initial.blocks[0].valid = true;
+  initial.blocks[0].size = 4;
+  initial.blocks[0].data = {1, 2, 3, 4};
+
+  initial.blocks[1].address = 0x78000;
+  initial.blocks[1].valid = false;
+  initial.blocks[1].size = 16;
+
+  ReadMemoryRangesReply second;
+  ASSERT_TRUE(SerializeDeserializeReply(initial, &second));
+  ASSERT_EQ(2u, second.blocks.size());
+
+  EXPECT_EQ(initial.blocks[0].address, second.blocks[0].address);
+  EXPECT_TRUE(second.blocks[0].valid);
+  EXPECT_EQ(initial.blocks[0].data, second.blocks[0].data);
+
+  EXPECT_EQ(initial.blocks[1].address, second.blocks[1].address);
+  EXPECT_FALSE(second.blocks[1].valid);
+  EXPECT_EQ(initial.blocks[1].size, second.blocks[1].size);
+  EXPECT_TRUE(second.blocks[1].data.empty());
+}
+
 // AddOrChangeBreakpoint -------------------------------------------------------
 
 TEST(Protocol, AddOrChangeBreakpointRequest) {
@@ -395,6 +442,45 @@ TEST(Protocol, BacktraceReply) {
   EXPECT_EQ(initial.frames[1].bp, second.frames[1].bp);
 }
 
+// Backtraces ------------------------------------------------------------------
+
+TEST(Protocol, BacktracesRequest) {
+  BacktracesRequest initial;
+  initial.process_koid = 1234;
+  initial.thread_koids.push_back(8976);
+  initial.thread_koids.push_back(8977);
+
+  BacktracesRequest second;
+  ASSERT_TRUE(SerializeDeserializeRequest(initial, &second));
+
+  EXPECT_EQ(initial.process_koid, second.process_koid);
+  EXPECT_EQ(initial.thread_koids, second.thread_koids);
+}
+
+TEST(Protocol, BacktracesReply) {
+  BacktracesReply initial;
+  initial.backtraces.resize(2);
+  initial.backtraces[0].thread_koid = 8976;
+  initial.backtraces[0].frames.emplace_back(1234, 6666, 9875);
+  initial.backtraces[0].frames.emplace_back(71562341, 777, 89236413);
+  initial.backtraces[1].thread_koid = 8977;
+
+  BacktracesReply second;
+  ASSERT_TRUE(SerializeDeserializeReply(initial, &second));
+
+  ASSERT_EQ(2u, second.backtraces.size());
+  EXPECT_EQ(initial.backtraces[0].thread_koid,
+            second.backtraces[0].thread_koid);
+  ASSERT_EQ(2u, second.backtraces[0].frames.size());
+  EXPECT_EQ(1234u, second.backtraces[0].frames[0].ip);
+  EXPECT_EQ(6666u, second.backtraces[0].frames[0].bp);
+  EXPECT_EQ(9875u, second.backtraces[0].frames[0].sp);
+  EXPECT_EQ(71562341u, second.backtraces[0].frames[1].ip);
+  EXPECT_EQ(initial.backtraces[1].thread_koid,
+            second.backtraces[1].thread_koid);
+  EXPECT_TRUE(second.backtraces[1].frames.empty());
+}
+
 // Modules ---------------------------------------------------------------------
 
 TEST(Protocol, ModulesRequest) {
@@ -652,4 +738,70 @@ TEST(Protocol, NotifyModules) {
   EXPECT_EQ(initial.stopped_thread_koids, second.stopped_thread_koids);
 }
 
+// Enable to run the serialization benchmark. It measures the throughput of
+// writing and reading large memory and backtrace replies.
+#if 0
+static int64_t GetTickMicroseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  constexpr int64_t kMicrosecondsPerSecond = 1000000;
+  constexpr int64_t kNanosecondsPerMicrosecond = 1000;
+
+  int64_t result = ts.tv_sec * kMicrosecondsPerSecond;
+  result += (ts.tv_nsec / kNanosecondsPerMicrosecond);
+  return result;
+}
+
+template <typename ReplyType>
+void BenchmarkReply(const char* name, const ReplyType& reply) {
+  constexpr int kIterations = 100;
+
+  int64_t write_us = 0;
+  int64_t read_us = 0;
+  size_t message_size = 0;
+  for (int i = 0; i < kIterations; i++) {
+    int64_t begin_us = GetTickMicroseconds();
+    MessageWriter writer;
+    WriteReply(reply, 1, &writer);
+    std::vector<char> serialized = writer.MessageComplete();
+    int64_t written_us = GetTickMicroseconds();
+
+    message_size = serialized.size();
+    MessageReader reader(std::move(serialized));
+    ReplyType out;
+    uint32_t transaction_id = 0;
+    ASSERT_TRUE(ReadReply(&reader, &out, &transaction_id));
+    int64_t end_us = GetTickMicroseconds();
+
+    write_us += written_us - begin_us;
+    read_us += end_us - written_us;
+  }
+
+  double total_mb =
+      static_cast<double>(message_size) * kIterations / (1024 * 1024);
+  printf("%s: %zu byte message, write %.1f MB/s, read %.1f MB/s\n", name,
+         message_size, total_mb * 1000000 / write_us,
+         total_mb * 1000000 / read_us);
+}
+
+TEST(Protocol, BenchmarkSerialization) {
+  ReadMemoryReply memory;
+  memory.blocks.resize(16);
+  for (size_t i = 0; i < memory.blocks.size(); i++) {
+    MemoryBlock& block = memory.blocks[i];
+    block.address = 0x100000 * i;
+    block.valid = true;
+    block.size = 1024 * 1024;
+    block.data.resize(block.size, static_cast<uint8_t>(i));
+  }
+  BenchmarkReply("ReadMemoryReply", memory);
+
+  BacktraceReply backtrace;
+  for (uint64_t i = 0; i < 100000; i++)
+    backtrace.frames.emplace_back(0x1000 + i, 0x2000 + i, 0x3000 + i);
+  BenchmarkReply("BacktraceReply", backtrace);
+}
+#endif
+
 }  // namespace debug_ipc
@@ -63,6 +63,11 @@ struct MemoryBlock {
   std::vector<uint8_t> data;
 };
 
+struct MemoryRange {
+  uint64_t address = 0;
+  uint32_t size = 0;
+};
+
 struct ProcessBreakpointSettings {
   // Required to be nonzero.
   uint64_t process_koid = 0;
@@ -145,6 +150,11 @@ struct StackFrame {
   uint64_t sp = 0;
 };
 
+struct ThreadBacktrace {
+  uint64_t thread_koid = 0;
+  std::vector<StackFrame> frames;
+};
+
 struct AddressRegion {
   std::string name;
   uint64_t base;
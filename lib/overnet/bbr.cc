@@ -226,6 +226,21 @@ void BBR::CancelRequestTransmit() {
   ValidateState();
 }
 
+void BBR::AbandonTransmit() {
+  ValidateState();
+  assert(packets_in_flight_ > 0);
+  assert(bytes_in_flight_ >= mss_);
+  packets_in_flight_--;
+  bytes_in_flight_ -= mss_;
+  OVERNET_TRACE(DEBUG, trace_sink_)
+      << "AbandonTransmit: packets_in_flight=" << packets_in_flight_
+      << " bytes_in_flight=" << bytes_in_flight_ << " cwnd=" << cwnd_bytes_;
+  if (bytes_in_flight_ < cwnd_bytes_ && queued_packet_) {
+    QueuedPacketReady();
+  }
+  ValidateState();
+}
+
 BBR::SentPacket BBR::ScheduleTransmit(TimeStamp* overall_send_time,
                                       OutgoingPacket packet) {
   assert(overall_send_time != nullptr);
@@ -242,6 +257,13 @@ BBR::SentPacket BBR::ScheduleTransmit(TimeStamp* overall_send_time,
   last_sent_packet_ = packet.sequence;
 
   const auto now = timer_->Now();
+  if (packets_in_flight_ == 1) {
+    // Nothing else is in flight: delivery rate samples for this packet are
+    // measured from now, not from whenever the last ack happened to arrive
+    // (or from the epoch for the very first packet).
+    first_sent_time_ = now;
+    delivered_time_ = now;
+  }
   TimeStamp send_time =
       last_send_time_ + PacingRate().SendTimeForBytes(packet.size);
   OVERNET_TRACE(DEBUG, trace_sink_)
@@ -261,12 +283,21 @@ BBR::SentPacket BBR::ScheduleTransmit(TimeStamp* overall_send_time,
 
   ValidateState();
 
-  return SentPacket{packet,
-                    delivered_bytes_,
-                    recovery_ == Recovery::Fast,
-                    app_limited_seq_ != 0,
-                    now,
-                    delivered_time_};
+  const SentPacket sent{packet,
+                        delivered_bytes_,
+                        recovery_ == Recovery::Fast,
+                        app_limited_seq_ != 0,
+                        now,
+                        delivered_time_};
+
+  // Returning the reservation made in QueuedPacketReady may have opened up the
+  // window for a paused packet: waiting for the next ack instead can stall
+  // both directions of a connection (acks ride on packets too).
+  if (bytes_in_flight_ < cwnd_bytes_ && queued_packet_) {
+    QueuedPacketReady();
+  }
+
+  return sent;
 }
 
 void BBR::UpdateModelAndState(TimeStamp now, const Ack& ack) {
@@ -43,6 +43,10 @@ class BBR {
   void RequestTransmit(StatusCallback ready);
   void CancelRequestTransmit();
   SentPacket ScheduleTransmit(TimeStamp* send_time, OutgoingPacket packet);
+  // A packet granted by RequestTransmit was abandoned before it could be
+  // scheduled (eg. it was nacked while still queued): returns its share of
+  // the congestion window.
+  void AbandonTransmit();
   void OnAck(const Ack& ack);
 
   uint64_t mss() const { return mss_; }
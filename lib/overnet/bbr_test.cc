@@ -367,5 +367,63 @@ std::vector<SimulationArgs> GenerateArguments() {
 INSTANTIATE_TEST_CASE_P(BBR, SimulationTest,
                         ::testing::ValuesIn(GenerateArguments()));
 
+// Each granted transmit holds back an mss worth of window until it is
+// scheduled or abandoned: either must wake a transmit that was waiting for
+// that window, as there may never be another ack to do so.
+TEST(BBR, ReleasedReservationsWakeQueuedTransmit) {
+  TestTimer timer;
+  BBR bbr(&timer, TraceCout(&timer), 1000, Nothing);
+
+  int granted = 0;
+  auto request = [&] {
+    bbr.RequestTransmit([&granted](const Status& status) {
+      EXPECT_TRUE(status.is_ok());
+      granted++;
+    });
+  };
+
+  // The initial window is three packets.
+  for (int i = 0; i < 3; i++) {
+    request();
+  }
+  EXPECT_EQ(3, granted);
+  request();
+  EXPECT_EQ(3, granted);
+
+  bbr.AbandonTransmit();
+  EXPECT_EQ(4, granted);
+
+  request();
+  EXPECT_EQ(4, granted);
+
+  TimeStamp send_time = timer.Now();
+  bbr.ScheduleTransmit(&send_time, BBR::OutgoingPacket{1, 10});
+  EXPECT_EQ(5, granted);
+}
+
+// A packet sent with nothing else in flight starts a new delivery rate sample:
+// the first sample must not be measured from the epoch of a clock that has
+// been running for a long time.
+TEST(BBR, FirstRateSampleStartsAtSend) {
+  TestTimer timer(TimeDelta::FromHours(1).as_us());
+  BBR bbr(&timer, TraceCout(&timer), 1000, Nothing);
+
+  bool granted = false;
+  bbr.RequestTransmit([&granted](const Status& status) {
+    EXPECT_TRUE(status.is_ok());
+    granted = true;
+  });
+  ASSERT_TRUE(granted);
+
+  TimeStamp send_time = timer.Now();
+  const BBR::SentPacket sent =
+      bbr.ScheduleTransmit(&send_time, BBR::OutgoingPacket{1, 1000});
+  timer.Step(TimeDelta::FromMilliseconds(10).as_us());
+  bbr.OnAck(BBR::Ack{{sent}, {}});
+
+  // 1000 bytes delivered in 10ms.
+  EXPECT_EQ(800000u, bbr.bottleneck_bandwidth().bits_per_second());
+}
+
 }  // namespace bbr_test
 }  // namespace overnet
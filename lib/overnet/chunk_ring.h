@@ -0,0 +1,129 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <assert.h>
+#include <memory>
+#include "slice.h"
+
+namespace overnet {
+
+// A span of bytes received ahead of where a reader is up to.
+struct PendingChunk {
+  uint64_t offset;
+  Slice slice;
+
+  uint64_t end() const { return offset + slice.length(); }
+};
+
+// Non-overlapping chunks ordered by offset, kept in a ring buffer.
+// Chunks mostly arrive near the tail and leave from the head, so both are
+// constant time and need no allocation once the ring has grown to the
+// receive window; inserting out of order shifts whichever side of the ring
+// is shorter.
+class ChunkRing {
+ public:
+  ChunkRing() = default;
+  ChunkRing(const ChunkRing&) = delete;
+  ChunkRing& operator=(const ChunkRing&) = delete;
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  // |index|'th chunk in offset order.
+  PendingChunk& operator[](size_t index) {
+    assert(index < size_);
+    return storage_[Wrap(head_ + index)];
+  }
+  const PendingChunk& operator[](size_t index) const {
+    assert(index < size_);
+    return storage_[Wrap(head_ + index)];
+  }
+
+  PendingChunk& front() { return (*this)[0]; }
+  const PendingChunk& front() const { return (*this)[0]; }
+  PendingChunk& back() { return (*this)[size_ - 1]; }
+  const PendingChunk& back() const { return (*this)[size_ - 1]; }
+
+  // Index of the first chunk starting at or after |offset|, or size() if
+  // there's none.
+  size_t LowerBound(uint64_t offset) const {
+    if (size_ == 0 || back().offset < offset) {
+      return size_;
+    }
+    size_t lo = 0;
+    size_t hi = size_ - 1;
+    while (lo < hi) {
+      const size_t mid = lo + (hi - lo) / 2;
+      if ((*this)[mid].offset < offset) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  // Inserts a chunk so that it becomes the |index|'th: the caller ensures
+  // that order is preserved and that it overlaps nothing.
+  void Insert(size_t index, uint64_t offset, Slice slice) {
+    assert(index <= size_);
+    assert(index == 0 || (*this)[index - 1].end() <= offset);
+    assert(index == size_ || offset + slice.length() <= (*this)[index].offset);
+    if (size_ == capacity_) {
+      Grow();
+    }
+    if (index < size_ / 2) {
+      head_ = Wrap(head_ + capacity_ - 1);
+      for (size_t i = 0; i < index; i++) {
+        (*this)[i] = std::move((*this)[i + 1]);
+      }
+    } else {
+      for (size_t i = size_; i > index; i--) {
+        storage_[Wrap(head_ + i)] = std::move((*this)[i - 1]);
+      }
+    }
+    size_++;
+    (*this)[index] = PendingChunk{offset, std::move(slice)};
+  }
+
+  // Removes the first chunk, returning its bytes.
+  Slice PopFront() {
+    assert(size_ != 0);
+    Slice slice = std::move(storage_[head_].slice);
+    head_ = Wrap(head_ + 1);
+    size_--;
+    return slice;
+  }
+
+  void Clear() {
+    while (!empty()) {
+      PopFront();
+    }
+    head_ = 0;
+  }
+
+ private:
+  size_t Wrap(size_t index) const { return index & (capacity_ - 1); }
+
+  void Grow() {
+    const size_t new_capacity = capacity_ == 0 ? 8 : 2 * capacity_;
+    std::unique_ptr<PendingChunk[]> storage(new PendingChunk[new_capacity]);
+    for (size_t i = 0; i < size_; i++) {
+      storage[i] = std::move((*this)[i]);
+    }
+    storage_ = std::move(storage);
+    capacity_ = new_capacity;
+    head_ = 0;
+  }
+
+  // Capacity is always zero or a power of two.
+  std::unique_ptr<PendingChunk[]> storage_;
+  size_t capacity_ = 0;
+  size_t head_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace overnet
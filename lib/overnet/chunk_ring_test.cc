@@ -0,0 +1,76 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "chunk_ring.h"
+#include <map>
+#include <random>
+#include "gtest/gtest.h"
+
+namespace overnet {
+namespace chunk_ring_test {
+
+Slice Byte(uint64_t offset) { return Slice::RepeatedChar(1, 'a' + offset); }
+
+TEST(ChunkRing, InOrder) {
+  ChunkRing ring;
+  EXPECT_TRUE(ring.empty());
+  for (uint64_t i = 0; i < 20; i++) {
+    EXPECT_EQ(ring.size(), ring.LowerBound(i));
+    ring.Insert(ring.size(), i, Byte(i));
+  }
+  EXPECT_EQ(20u, ring.size());
+  EXPECT_EQ(0u, ring.front().offset);
+  EXPECT_EQ(20u, ring.back().end());
+  for (uint64_t i = 0; i < 20; i++) {
+    EXPECT_EQ(i, ring.front().offset);
+    EXPECT_EQ(Byte(i), ring.PopFront());
+  }
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(ChunkRing, LowerBound) {
+  ChunkRing ring;
+  ring.Insert(0, 10, Slice::RepeatedChar(5, 'a'));
+  ring.Insert(1, 20, Slice::RepeatedChar(5, 'b'));
+  ring.Insert(2, 30, Slice::RepeatedChar(5, 'c'));
+  EXPECT_EQ(0u, ring.LowerBound(0));
+  EXPECT_EQ(0u, ring.LowerBound(10));
+  EXPECT_EQ(1u, ring.LowerBound(11));
+  EXPECT_EQ(1u, ring.LowerBound(20));
+  EXPECT_EQ(2u, ring.LowerBound(25));
+  EXPECT_EQ(3u, ring.LowerBound(31));
+}
+
+// Insertions at either end and in the middle, while the ring wraps and grows,
+// should keep the same order a std::map would.
+TEST(ChunkRing, MatchesMap) {
+  std::mt19937 rng(1);
+  ChunkRing ring;
+  std::map<uint64_t, Slice> expect;
+  uint64_t next = 0;
+  for (int step = 0; step < 10000; step++) {
+    const uint64_t offset =
+        next + std::uniform_int_distribution<uint64_t>(0, 63)(rng);
+    if (expect.count(offset) == 0) {
+      ring.Insert(ring.LowerBound(offset), offset, Byte(offset));
+      expect.emplace(offset, Byte(offset));
+    }
+    while (!expect.empty() && expect.begin()->first == next) {
+      ASSERT_EQ(next, ring.front().offset);
+      EXPECT_EQ(expect.begin()->second, ring.PopFront());
+      expect.erase(expect.begin());
+      next++;
+    }
+    ASSERT_EQ(expect.size(), ring.size());
+    size_t i = 0;
+    for (const auto& el : expect) {
+      ASSERT_EQ(el.first, ring[i++].offset);
+    }
+  }
+  ring.Clear();
+  EXPECT_TRUE(ring.empty());
+}
+
+}  // namespace chunk_ring_test
+}  // namespace overnet
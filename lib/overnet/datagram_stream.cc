@@ -112,13 +112,131 @@ StatusOr<MessageFragment> MessageFragment::Parse(Slice slice) {
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// IncomingMessage
+
+void DatagramStream::IncomingMessage::Pull(
+    StatusOrCallback<Optional<Slice>>&& done) {
+  Enter();
+  if (!decompressor_) {
+    linearizer_.Pull(std::forward<StatusOrCallback<Optional<Slice>>>(done));
+    Leave();
+    return;
+  }
+  linearizer_.Pull(StatusOrCallback<Optional<Slice>>(
+      ALLOCATED_CALLBACK, [this, done = std::move(done)](
+                              StatusOr<Optional<Slice>>&& status) mutable {
+        if (status.is_error()) {
+          done(std::move(status));
+          return;
+        }
+        if (!status->has_value()) {
+          if (!decompressor_->finished()) {
+            done(StatusOr<Optional<Slice>>(StatusCode::DATA_LOSS,
+                                           "Compressed message truncated"));
+            return;
+          }
+          done(Nothing);
+          return;
+        }
+        auto decompressed = decompressor_->Decompress(**status);
+        if (decompressed.is_error()) {
+          DecompressFailed(decompressed.AsStatus());
+          done(decompressed.AsStatus());
+          return;
+        }
+        if (decompressed->length() == 0) {
+          // Not enough compressed bytes yet to produce anything.
+          Pull(std::move(done));
+          return;
+        }
+        done(Optional<Slice>(std::move(*decompressed.get())));
+      }));
+  Leave();
+}
+
+void DatagramStream::IncomingMessage::PullAll(
+    StatusOrCallback<std::vector<Slice>>&& done) {
+  Enter();
+  if (!decompressor_) {
+    linearizer_.PullAll(
+        std::forward<StatusOrCallback<std::vector<Slice>>>(done));
+    Leave();
+    return;
+  }
+  linearizer_.PullAll(StatusOrCallback<std::vector<Slice>>(
+      ALLOCATED_CALLBACK, [this, done = std::move(done)](
+                              StatusOr<std::vector<Slice>>&& status) mutable {
+        if (status.is_error()) {
+          done(std::move(status));
+          return;
+        }
+        std::vector<Slice> decompressed;
+        for (const Slice& compressed : *status.get()) {
+          auto slice = decompressor_->Decompress(compressed);
+          if (slice.is_error()) {
+            DecompressFailed(slice.AsStatus());
+            done(slice.AsStatus());
+            return;
+          }
+          if (slice->length() != 0) {
+            decompressed.emplace_back(std::move(*slice.get()));
+          }
+        }
+        if (!decompressor_->finished()) {
+          done(StatusOr<std::vector<Slice>>(StatusCode::DATA_LOSS,
+                                            "Compressed message truncated"));
+          return;
+        }
+        done(std::move(decompressed));
+      }));
+  Leave();
+}
+
+void DatagramStream::IncomingMessage::Push(Chunk&& chunk) {
+  Enter();
+  linearizer_.Push(std::forward<Chunk>(chunk));
+  Leave();
+}
+
+void DatagramStream::IncomingMessage::Close(const Status& status) {
+  Enter();
+  linearizer_.Close(status);
+  Leave();
+}
+
+void DatagramStream::IncomingMessage::DecompressFailed(const Status& status) {
+  if (status.code() == StatusCode::RESOURCE_EXHAUSTED) {
+    // Too long to ever deliver.
+    stream_->Close(status, Callback<void>::Ignored());
+  }
+}
+
+void DatagramStream::IncomingMessage::Release() {
+  assert(!released_);
+  released_ = true;
+  if (call_depth_ == 0) {
+    stream_->messages_.erase(msg_id_);
+  }
+}
+
+void DatagramStream::IncomingMessage::Leave() {
+  assert(call_depth_ > 0);
+  if (--call_depth_ == 0 && released_) {
+    // Deletes this.
+    stream_->messages_.erase(msg_id_);
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // DatagramStream proper
 
 DatagramStream::DatagramStream(Router* router, TraceSink trace_sink,
                                NodeId peer,
                                ReliabilityAndOrdering reliability_and_ordering,
-                               StreamId stream_id)
+                               StreamId stream_id, StreamPriority priority,
+                               Compression compression,
+                               Slice compression_dictionary)
     : timer_(router->timer()),
       router_(router),
       trace_sink_(trace_sink.Decorate([this, peer, stream_id](std::string msg) {
@@ -130,6 +248,9 @@ DatagramStream::DatagramStream(Router* router, TraceSink trace_sink,
       peer_(peer),
       stream_id_(stream_id),
       reliability_and_ordering_(reliability_and_ordering),
+      priority_(priority),
+      compression_(compression),
+      compression_dictionary_(std::move(compression_dictionary)),
       receive_mode_(reliability_and_ordering),
       // TODO(ctiller): What should mss be? Hardcoding to 65536 for now.
       packet_protocol_(timer_, this, trace_sink_, 65536) {
@@ -199,6 +320,21 @@ void DatagramStream::SendCloseAndFlushQuiesced(const Status& status,
       });
 }
 
+// PacketProtocol reports a nacked packet as CANCELLED, but it also fails every
+// outstanding send with CANCELLED once it starts closing; only the former is
+// worth sending again.
+bool DatagramStream::ShouldResend(const Status& send_status) const {
+  switch (send_status.code()) {
+    case StatusCode::UNAVAILABLE:
+      return true;
+    case StatusCode::CANCELLED:
+      return close_state_ != CloseState::CLOSING_PROTOCOL &&
+             close_state_ != CloseState::CLOSED;
+    default:
+      return false;
+  }
+}
+
 void DatagramStream::FinishClosing() {
   assert(close_state_ == CloseState::LOCAL_CLOSE_REQUESTED ||
          close_state_ == CloseState::REMOTE_CLOSED);
@@ -263,12 +399,14 @@ void DatagramStream::HandleMessage(SeqNum seq, TimeStamp received, Slice data) {
         it = messages_
                  .emplace(std::piecewise_construct,
                           std::forward_as_tuple(msg.message()),
-                          std::forward_as_tuple(trace_sink_))
+                          std::forward_as_tuple(msg.message(), trace_sink_,
+                                                this))
                  .first;
         receive_mode_.Begin(msg.message(), [this, msg = std::move(msg)](
                                                const Status& status) mutable {
           if (status.is_error()) {
             OVERNET_TRACE(WARNING, trace_sink_) << "Receive failed: " << status;
+            messages_.erase(msg.message());
             return;
           }
           auto it = messages_.find(msg.message());
@@ -292,7 +430,8 @@ void DatagramStream::HandleMessage(SeqNum seq, TimeStamp received, Slice data) {
         it = messages_
                  .emplace(std::piecewise_construct,
                           std::forward_as_tuple(msg.message()),
-                          std::forward_as_tuple(trace_sink_))
+                          std::forward_as_tuple(msg.message(), trace_sink_,
+                                                this))
                  .first;
       }
       it->second.Close(msg.status());
@@ -360,12 +499,47 @@ void DatagramStream::MaybeContinueReceive() {
   }
 }
 
+void DatagramStream::MessageConsumed(IncomingMessage* message) {
+  // A message abandoned before it was fully read has not been received: let
+  // the receive mode decide whether it can be delivered again.
+  const Status status =
+      message->complete() ? Status::Ok() : Status::Cancelled();
+  const uint64_t msg_id = message->msg_id();
+  message->Release();
+  // The receive mode may now begin the next message.
+  receive_mode_.Completed(msg_id, status);
+}
+
+std::unique_ptr<Compressor> DatagramStream::TakeCompressor() {
+  if (idle_compressors_.empty()) {
+    return std::make_unique<Compressor>(compression_dictionary_,
+                                        &compression_metrics_);
+  }
+  auto compressor = std::move(idle_compressors_.back());
+  idle_compressors_.pop_back();
+  return compressor;
+}
+
+void DatagramStream::ReturnCompressor(std::unique_ptr<Compressor> compressor) {
+  // Enough for a few concurrent sends.
+  static constexpr size_t kMaxIdleCompressors = 4;
+  if (idle_compressors_.size() < kMaxIdleCompressors) {
+    idle_compressors_.emplace_back(std::move(compressor));
+  }
+}
+
 void DatagramStream::SendPacket(SeqNum seq, LazySlice data,
                                 Callback<void> done) {
   router_->Forward(
       Message{std::move(RoutableMessage(router_->node_id())
                             .AddDestination(peer_, stream_id_, seq)),
-              std::move(data), timer_->Now()});
+              std::move(data), timer_->Now(), priority_});
+}
+
+void DatagramStream::SendParityPacket(SeqNum seq, LazySlice data,
+                                      Callback<void> done) {
+  // Streams create their PacketProtocol without parity.
+  assert(false);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -380,7 +554,11 @@ DatagramStream::SendOp::SendOp(DatagramStream* stream, uint64_t payload_length)
       })),
       payload_length_(payload_length),
       message_id_(stream_->next_message_id_++),
-      message_id_length_(varint::WireSizeFor(message_id_)) {}
+      message_id_length_(varint::WireSizeFor(message_id_)) {
+  if (stream_->compression_ != Compression::None) {
+    compressor_ = stream_->TakeCompressor();
+  }
+}
 
 void DatagramStream::SendOp::SetClosed(const Status& status) {
   if (state_ != State::OPEN) {
@@ -394,6 +572,13 @@ void DatagramStream::SendOp::SetClosed(const Status& status) {
     return;
   }
   OVERNET_TRACE(DEBUG, trace_sink_) << "SET CLOSED: " << status;
+  if (compressor_) {
+    // A message abandoned part way through leaves the compressor mid-stream.
+    if (status.is_error()) {
+      compressor_->Reset();
+    }
+    stream_->ReturnCompressor(std::move(compressor_));
+  }
   if (status.is_error()) {
     state_ = State::CLOSED_WITH_ERROR;
     SendError(status);
@@ -409,7 +594,7 @@ void DatagramStream::SendOp::SendError(const overnet::Status& status) {
             .Write(arg.desired_prefix);
       },
       [self = OutstandingOp(this), status](const Status& send_status) {
-        if (send_status.code() == StatusCode::UNAVAILABLE) {
+        if (self->stream_->ShouldResend(send_status)) {
           self->SendError(status);
         }
       });
@@ -442,7 +627,16 @@ void DatagramStream::SendOp::Push(Slice item) {
     return;
   }
   push_offset_ += chunk_length;
-  Chunk chunk{chunk_start, end_byte == payload_length_, std::move(item)};
+  const bool end_of_message = end_byte == payload_length_;
+  if (compressor_) {
+    // Compressed messages are chunked by their compressed bytes.
+    item = compressor_->Compress(item, end_of_message);
+    if (item.length() == 0 && !end_of_message) {
+      return;
+    }
+  }
+  Chunk chunk{send_offset_, end_of_message, std::move(item)};
+  send_offset_ += chunk.slice.length();
   SendChunk(std::move(chunk));
 }
 
@@ -504,7 +698,7 @@ void DatagramStream::SendOp::CompleteReliable(const Status& status,
   if (state_ == State::CLOSED_WITH_ERROR) {
     return;
   }
-  if (status.code() == StatusCode::UNAVAILABLE) {
+  if (stream_->ShouldResend(status)) {
     // Send failed, still open, and retryable: retry.
     SendChunk(std::move(chunk));
   }
@@ -520,7 +714,8 @@ void DatagramStream::SendOp::CompleteUnreliable(const Status& status) {
 // ReceiveOp
 
 DatagramStream::ReceiveOp::ReceiveOp(DatagramStream* stream)
-    : trace_sink_(stream->trace_sink_.Decorate([this](const std::string& msg) {
+    : stream_(stream),
+      trace_sink_(stream->trace_sink_.Decorate([this](const std::string& msg) {
         std::ostringstream out;
         out << "ReceiveOp[" << this << "] " << msg;
         return out.str();
@@ -529,6 +724,14 @@ DatagramStream::ReceiveOp::ReceiveOp(DatagramStream* stream)
   stream->MaybeContinueReceive();
 }
 
+DatagramStream::ReceiveOp::~ReceiveOp() {
+  if (incoming_message_ == nullptr) {
+    stream_->unclaimed_receives_.Remove(this);
+  } else {
+    stream_->MessageConsumed(incoming_message_);
+  }
+}
+
 void DatagramStream::ReceiveOp::Pull(StatusOrCallback<Optional<Slice>> ready) {
   OVERNET_TRACE(DEBUG, trace_sink_)
       << "Pull incoming_message=" << incoming_message_
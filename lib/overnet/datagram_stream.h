@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <queue>  // TODO(ctiller): switch to a short queue (inlined 1-2 elems, linked list)
 #include "ack_frame.h"
 #include "internal_list.h"
@@ -15,6 +16,7 @@
 #include "seq_num.h"
 #include "sink.h"
 #include "slice.h"
+#include "stream_compression.h"
 #include "timer.h"
 #include "trace.h"
 
@@ -132,39 +134,78 @@ class MessageFragment {
 
 class DatagramStream : private Router::StreamHandler,
                        private PacketProtocol::PacketSender {
+  // Compressed streams are closed if a message decompresses to more than this.
+  static constexpr uint64_t kMaxDecompressedMessageLength = 16 * 1024 * 1024;
+
   class IncomingMessage {
    public:
     // TODO(ctiller): 1MB stubbed in for the moment until something better
-    explicit IncomingMessage(TraceSink trace_sink)
-        : linearizer_(1024 * 1024,
+    IncomingMessage(uint64_t msg_id, TraceSink trace_sink,
+                    DatagramStream* stream)
+        : stream_(stream),
+          msg_id_(msg_id),
+          linearizer_(1024 * 1024,
                       trace_sink.Decorate([this](const std::string& msg) {
                         std::ostringstream out;
                         out << "Msg[" << this << "] " << msg;
                         return out.str();
-                      })) {}
-
-    void Pull(StatusOrCallback<Optional<Slice>>&& done) {
-      linearizer_.Pull(std::forward<StatusOrCallback<Optional<Slice>>>(done));
-    }
-    void PullAll(StatusOrCallback<std::vector<Slice>>&& done) {
-      linearizer_.PullAll(
-          std::forward<StatusOrCallback<std::vector<Slice>>>(done));
+                      })) {
+      if (stream->compression_ != Compression::None) {
+        decompressor_.reset(new Decompressor(stream->compression_dictionary_,
+                                             kMaxDecompressedMessageLength,
+                                             &stream->compression_metrics_));
+      }
     }
 
-    void Push(Chunk&& chunk) { linearizer_.Push(std::forward<Chunk>(chunk)); }
+    void Pull(StatusOrCallback<Optional<Slice>>&& done);
+    void PullAll(StatusOrCallback<std::vector<Slice>>&& done);
 
-    void Close(const Status& status) { linearizer_.Close(status); }
+    void Push(Chunk&& chunk);
+    void Close(const Status& status);
+    // Fails the stream if |status| means it can't carry on.
+    void DecompressFailed(const Status& status);
+
+    uint64_t msg_id() const { return msg_id_; }
+
+    // True once every byte of the message has been read.
+    bool complete() const {
+      return linearizer_.Complete() &&
+             (!decompressor_ || decompressor_->finished());
+    }
+
+    // Called when the reader is done with this message: erases it from the
+    // stream. Readers may finish from inside one of this message's callbacks,
+    // in which case it is erased when the outermost call into it returns.
+    void Release();
 
     InternalListNode<IncomingMessage> incoming_link;
 
    private:
+    // Bracket every call into the linearizer, since its callbacks may release
+    // the message.
+    void Enter() { call_depth_++; }
+    void Leave();
+
+    DatagramStream* const stream_;
+    const uint64_t msg_id_;
+    int call_depth_ = 0;
+    bool released_ = false;
+    // The linearizer reassembles the message as sent: compressed, if the
+    // stream is.
     Linearizer linearizer_;
+    std::unique_ptr<Decompressor> decompressor_;
   };
 
  public:
+  // |priority| sets this stream's share of each link it sends over.
+  // |compression| must match the peer's, and so must |compression_dictionary|
+  // if one is used.
   DatagramStream(Router* router, TraceSink sink, NodeId peer,
                  ReliabilityAndOrdering reliability_and_ordering,
-                 StreamId stream_id);
+                 StreamId stream_id,
+                 StreamPriority priority = StreamPriority::Default,
+                 Compression compression = Compression::None,
+                 Slice compression_dictionary = Slice());
   ~DatagramStream();
 
   DatagramStream(const DatagramStream&) = delete;
@@ -240,6 +281,9 @@ class DatagramStream : private Router::StreamHandler,
     const uint8_t message_id_length_;
     State state_ = State::OPEN;
     uint64_t push_offset_ = 0;
+    // Offset of the next chunk sent: past push_offset_ once compressed.
+    uint64_t send_offset_ = 0;
+    std::unique_ptr<Compressor> compressor_;
     Callback<void> quiesced_;
   };
 
@@ -248,12 +292,14 @@ class DatagramStream : private Router::StreamHandler,
 
    public:
     explicit ReceiveOp(DatagramStream* stream);
+    ~ReceiveOp();
 
     void Pull(StatusOrCallback<Optional<Slice>> ready) override;
     void PullAll(StatusOrCallback<std::vector<Slice>> ready) override;
     void Close(const Status& status) override;
 
    private:
+    DatagramStream* const stream_;
     const TraceSink trace_sink_;
     IncomingMessage* incoming_message_ = nullptr;
     StatusOrCallback<Optional<Slice>> pending_pull_;
@@ -263,15 +309,25 @@ class DatagramStream : private Router::StreamHandler,
   };
 
   NodeId peer() const { return peer_; }
+  const CompressionMetrics& compression_metrics() const {
+    return compression_metrics_;
+  }
 
  private:
   void HandleMessage(SeqNum seq, TimeStamp received, Slice data) override final;
   void SendPacket(SeqNum seq, LazySlice data,
                   Callback<void> done) override final;
+  void SendParityPacket(SeqNum seq, LazySlice data,
+                        Callback<void> done) override final;
   void SendCloseAndFlushQuiesced(const Status& status, int retry_number);
   void FinishClosing();
+  bool ShouldResend(const Status& send_status) const;
+
+  std::unique_ptr<Compressor> TakeCompressor();
+  void ReturnCompressor(std::unique_ptr<Compressor> compressor);
 
   void MaybeContinueReceive();
+  void MessageConsumed(IncomingMessage* message);
 
   Timer* const timer_;
   Router* const router_;
@@ -279,6 +335,12 @@ class DatagramStream : private Router::StreamHandler,
   const NodeId peer_;
   const StreamId stream_id_;
   const ReliabilityAndOrdering reliability_and_ordering_;
+  const StreamPriority priority_;
+  const Compression compression_;
+  const Slice compression_dictionary_;
+  CompressionMetrics compression_metrics_;
+  // Compressors left by finished SendOps, for reuse by later ones.
+  std::vector<std::unique_ptr<Compressor>> idle_compressors_;
   uint64_t next_message_id_ = 1;
   uint64_t largest_incoming_message_id_seen_ = 0;
   receive_mode::ParameterizedReceiveMode receive_mode_;
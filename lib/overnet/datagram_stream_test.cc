@@ -192,5 +192,256 @@ TEST(DatagramStream, RecvThenRead) {
   EXPECT_CALL(link, Forward(_));
 }
 
+TEST(DatagramStream, DestroyedReceiveOpIsNotDeliveredTo) {
+  TestTimer timer;
+  auto trace_sink = TraceCout(&timer);
+
+  StrictMock<MockLink> link;
+  StrictMock<MockPullCB> pull_cb;
+
+  auto expect_all_done = [&]() {
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(&link));
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(&pull_cb));
+  };
+
+  auto router = MakeClosedPtr<Router>(&timer, trace_sink, NodeId(1), true);
+  router->RegisterLink(link.MakeLink(NodeId(1), NodeId(2)));
+  while (!router->HasRouteTo(NodeId(2))) {
+    router->BlockUntilNoBackgroundUpdatesProcessing();
+    timer.StepUntilNextEvent();
+  }
+
+  auto ds1 = MakeClosedPtr<DatagramStream>(
+      router.get(), trace_sink, NodeId(2),
+      ReliabilityAndOrdering::ReliableUnordered, StreamId(1));
+
+  // A receive that goes away before any message arrives must stop waiting.
+  { DatagramStream::ReceiveOp abandoned_op(ds1.get()); }
+
+  DatagramStream::ReceiveOp recv_op(ds1.get());
+  recv_op.Pull(pull_cb.MakeCallback());
+
+  EXPECT_CALL(pull_cb, Callback(Property(
+                           &StatusOr<Optional<Slice>>::get,
+                           Pointee(Pointee(Slice::FromContainer({1, 2, 3}))))));
+  router->Forward(Message{
+      std::move(RoutableMessage(NodeId(2)).AddDestination(
+          NodeId(1), StreamId(1), SeqNum(1, 1))),
+      ForwardingPayloadFactory(Slice::FromContainer({0, 0x80, 1, 0, 1, 2, 3})),
+      TimeStamp::AfterEpoch(TimeDelta::FromMilliseconds(123))});
+
+  expect_all_done();
+
+  recv_op.Close(Status::Ok());
+
+  // Stream will send a close.
+  EXPECT_CALL(link, Forward(_));
+}
+
+TEST(DatagramStream, ReliableOrderedRecvsSuccessiveMessages) {
+  TestTimer timer;
+  auto trace_sink = TraceCout(&timer);
+
+  StrictMock<MockLink> link;
+  StrictMock<MockPullCB> pull_cb;
+
+  auto expect_all_done = [&]() {
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(&link));
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(&pull_cb));
+  };
+
+  auto router = MakeClosedPtr<Router>(&timer, trace_sink, NodeId(1), true);
+  router->RegisterLink(link.MakeLink(NodeId(1), NodeId(2)));
+  while (!router->HasRouteTo(NodeId(2))) {
+    router->BlockUntilNoBackgroundUpdatesProcessing();
+    timer.StepUntilNextEvent();
+  }
+
+  auto ds1 = MakeClosedPtr<DatagramStream>(
+      router.get(), trace_sink, NodeId(2),
+      ReliabilityAndOrdering::ReliableOrdered, StreamId(1));
+
+  router->Forward(Message{
+      std::move(RoutableMessage(NodeId(2)).AddDestination(
+          NodeId(1), StreamId(1), SeqNum(1, 2))),
+      ForwardingPayloadFactory(Slice::FromContainer({0, 0x80, 1, 0, 1, 2, 3})),
+      TimeStamp::AfterEpoch(TimeDelta::FromMilliseconds(123))});
+  router->Forward(Message{
+      std::move(RoutableMessage(NodeId(2)).AddDestination(
+          NodeId(1), StreamId(1), SeqNum(2, 2))),
+      ForwardingPayloadFactory(Slice::FromContainer({0, 0x80, 2, 0, 4, 5, 6})),
+      TimeStamp::AfterEpoch(TimeDelta::FromMilliseconds(123))});
+
+  {
+    DatagramStream::ReceiveOp recv_op(ds1.get());
+    EXPECT_CALL(pull_cb,
+                Callback(Property(
+                    &StatusOr<Optional<Slice>>::get,
+                    Pointee(Pointee(Slice::FromContainer({1, 2, 3}))))));
+    recv_op.Pull(pull_cb.MakeCallback());
+    expect_all_done();
+    recv_op.Close(Status::Ok());
+  }
+
+  // Finishing with the first message must let the second one through.
+  {
+    DatagramStream::ReceiveOp recv_op(ds1.get());
+    EXPECT_CALL(pull_cb,
+                Callback(Property(
+                    &StatusOr<Optional<Slice>>::get,
+                    Pointee(Pointee(Slice::FromContainer({4, 5, 6}))))));
+    recv_op.Pull(pull_cb.MakeCallback());
+    expect_all_done();
+    recv_op.Close(Status::Ok());
+  }
+
+  // Stream will send a close.
+  EXPECT_CALL(link, Forward(_));
+}
+
+TEST(DatagramStream, ReliableOrderedRedeliversAbandonedMessage) {
+  TestTimer timer;
+  auto trace_sink = TraceCout(&timer);
+
+  StrictMock<MockLink> link;
+  StrictMock<MockPullCB> pull_cb;
+
+  auto expect_all_done = [&]() {
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(&link));
+    EXPECT_TRUE(Mock::VerifyAndClearExpectations(&pull_cb));
+  };
+
+  auto router = MakeClosedPtr<Router>(&timer, trace_sink, NodeId(1), true);
+  router->RegisterLink(link.MakeLink(NodeId(1), NodeId(2)));
+  while (!router->HasRouteTo(NodeId(2))) {
+    router->BlockUntilNoBackgroundUpdatesProcessing();
+    timer.StepUntilNextEvent();
+  }
+
+  auto ds1 = MakeClosedPtr<DatagramStream>(
+      router.get(), trace_sink, NodeId(2),
+      ReliabilityAndOrdering::ReliableOrdered, StreamId(1));
+
+  // The first chunk of message 1, then all of message 2.
+  router->Forward(Message{
+      std::move(RoutableMessage(NodeId(2)).AddDestination(
+          NodeId(1), StreamId(1), SeqNum(1, 2))),
+      ForwardingPayloadFactory(Slice::FromContainer({0, 0x00, 1, 0, 1, 2, 3})),
+      TimeStamp::AfterEpoch(TimeDelta::FromMilliseconds(123))});
+  router->Forward(Message{
+      std::move(RoutableMessage(NodeId(2)).AddDestination(
+          NodeId(1), StreamId(1), SeqNum(2, 2))),
+      ForwardingPayloadFactory(Slice::FromContainer({0, 0x80, 2, 0, 4, 5, 6})),
+      TimeStamp::AfterEpoch(TimeDelta::FromMilliseconds(123))});
+
+  // Abandon message 1 part way through.
+  {
+    DatagramStream::ReceiveOp recv_op(ds1.get());
+    EXPECT_CALL(pull_cb,
+                Callback(Property(
+                    &StatusOr<Optional<Slice>>::get,
+                    Pointee(Pointee(Slice::FromContainer({1, 2, 3}))))));
+    recv_op.Pull(pull_cb.MakeCallback());
+    expect_all_done();
+  }
+
+  // Message 1 was not received, so message 2 must not be delivered yet...
+  DatagramStream::ReceiveOp recv_op(ds1.get());
+  recv_op.Pull(pull_cb.MakeCallback());
+  expect_all_done();
+
+  // ... and a resend of message 1 must be delivered from the start. The third
+  // packet also draws an ack.
+  EXPECT_CALL(link, Forward(_));
+  EXPECT_CALL(pull_cb,
+              Callback(Property(
+                  &StatusOr<Optional<Slice>>::get,
+                  Pointee(Pointee(Slice::FromContainer({1, 2, 3}))))));
+  router->Forward(Message{
+      std::move(RoutableMessage(NodeId(2)).AddDestination(
+          NodeId(1), StreamId(1), SeqNum(3, 3))),
+      ForwardingPayloadFactory(Slice::FromContainer({0, 0x80, 1, 0, 1, 2, 3})),
+      TimeStamp::AfterEpoch(TimeDelta::FromMilliseconds(123))});
+  expect_all_done();
+  recv_op.Close(Status::Ok());
+
+  // Stream will send a close.
+  EXPECT_CALL(link, Forward(_));
+}
+
+TEST(DatagramStream, CompressedRoundTrip) {
+  TestTimer timer;
+  auto trace_sink = TraceCout(&timer);
+
+  StrictMock<MockLink> link;
+
+  auto router = MakeClosedPtr<Router>(&timer, trace_sink, NodeId(1), true);
+  router->RegisterLink(link.MakeLink(NodeId(1), NodeId(2)));
+  while (!router->HasRouteTo(NodeId(2))) {
+    router->BlockUntilNoBackgroundUpdatesProcessing();
+    timer.StepUntilNextEvent();
+  }
+
+  const Slice dictionary = Slice::FromStaticString("abcdefgh");
+  auto sender = MakeClosedPtr<DatagramStream>(
+      router.get(), trace_sink, NodeId(2),
+      ReliabilityAndOrdering::UnreliableUnordered, StreamId(1),
+      StreamPriority::Default, Compression::Deflate, dictionary);
+  auto receiver = MakeClosedPtr<DatagramStream>(
+      router.get(), trace_sink, NodeId(2),
+      ReliabilityAndOrdering::UnreliableUnordered, StreamId(2),
+      StreamPriority::Default, Compression::Deflate, dictionary);
+
+  // Sent in two parts: each is compressed as it's pushed.
+  const Slice first = Slice::RepeatedChar(1000, 'a');
+  const Slice second = Slice::RepeatedChar(1000, 'b');
+  std::vector<std::shared_ptr<Message>> messages(2);
+  EXPECT_CALL(link, Forward(_))
+      .WillOnce(SaveArg<0>(&messages[0]))
+      .WillOnce(SaveArg<0>(&messages[1]));
+  {
+    auto send_op = MakeClosedPtr<DatagramStream::SendOp>(sender.get(), 2000);
+    send_op->Push(first);
+    send_op->Push(second);
+  }
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&link));
+
+  const CompressionMetrics& sent = sender->compression_metrics();
+  EXPECT_EQ(2000u, sent.sent_payload_bytes);
+  EXPECT_LT(sent.sent_compressed_bytes, 100u);
+
+  // Deliver the sender's packets to the receiver.
+  for (int i = 0; i < 2; i++) {
+    TimeStamp when = timer.Now();
+    router->Forward(Message{
+        std::move(RoutableMessage(NodeId(2)).AddDestination(
+            NodeId(1), StreamId(2), SeqNum(i + 1, 2))),
+        ForwardingPayloadFactory(messages[i]->make_payload(LazySliceArgs{
+            0, std::numeric_limits<uint32_t>::max(), false, &when})),
+        timer.Now()});
+  }
+
+  DatagramStream::ReceiveOp recv_op(receiver.get());
+  bool pulled = false;
+  recv_op.PullAll(StatusOrCallback<std::vector<Slice>>(
+      ALLOCATED_CALLBACK,
+      [&](const StatusOr<std::vector<Slice>>& status) {
+        ASSERT_TRUE(status.is_ok()) << status.AsStatus();
+        EXPECT_EQ(Slice::Join({first, second}),
+                  Slice::Join(status->begin(), status->end()));
+        pulled = true;
+      }));
+  EXPECT_TRUE(pulled);
+  recv_op.Close(Status::Ok());
+
+  const CompressionMetrics& received = receiver->compression_metrics();
+  EXPECT_EQ(2000u, received.received_payload_bytes);
+  EXPECT_EQ(sent.sent_compressed_bytes, received.received_compressed_bytes);
+  EXPECT_LT(received.receive_ratio(), 0.05);
+
+  // Streams will send closes.
+  EXPECT_CALL(link, Forward(_)).Times(2);
+}
+
 }  // namespace datagram_stream_tests
 }  // namespace overnet
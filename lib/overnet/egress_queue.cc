@@ -0,0 +1,100 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "egress_queue.h"
+#include <algorithm>
+
+namespace overnet {
+
+static constexpr uint64_t kMaxWeight = 16;
+
+uint64_t EgressQueue::Weight(StreamPriority priority) {
+  switch (priority) {
+    case StreamPriority::Bulk:
+      return 1;
+    case StreamPriority::Default:
+      return 4;
+    case StreamPriority::Interactive:
+      return kMaxWeight;
+  }
+  return 1;
+}
+
+void EgressQueue::Push(Message message) {
+  assert(!message.header.destinations().empty());
+  const StreamKey key{message.header.src(),
+                      message.header.destinations()[0].stream_id()};
+  auto it = streams_.find(key);
+  if (it == streams_.end()) {
+    it = streams_.emplace(key, Stream(key)).first;
+  }
+  Stream* stream = &it->second;
+  if (stream->messages.empty() && stream != in_service_) {
+    if (stream->finish != 0) {
+      idle_.erase(stream->tag);
+    }
+    stream->tag = NextTag(std::max(virtual_time_, stream->finish));
+    active_.emplace(stream->tag, stream);
+  }
+  stream->messages.emplace_back(std::move(message));
+  size_++;
+}
+
+Message EgressQueue::Pop() {
+  assert(!active_.empty());
+  assert(in_service_ == nullptr);
+  auto it = active_.begin();
+  Stream* stream = it->second;
+  active_.erase(it);
+  virtual_time_ = stream->tag.first;
+  Message message = std::move(stream->messages.front());
+  stream->messages.pop_front();
+  stream->priority_in_service = message.priority;
+  in_service_ = stream;
+  size_--;
+  return message;
+}
+
+void EgressQueue::Sent(uint64_t length) {
+  assert(in_service_ != nullptr);
+  Stream* stream = in_service_;
+  in_service_ = nullptr;
+  // Heavier streams pay less virtual time for the same bytes, and so are
+  // picked more often.
+  stream->finish = virtual_time_ + 1 +
+                   length * (kMaxWeight / Weight(stream->priority_in_service));
+
+  if (size_ == 0) {
+    // Idle link: everyone starts afresh.
+    Clear();
+    return;
+  }
+
+  // Streams that went idle before the current virtual time would restart at
+  // the current virtual time anyway: forget them.
+  while (!idle_.empty() && idle_.begin()->first.first <= virtual_time_) {
+    Stream* idle = idle_.begin()->second;
+    idle_.erase(idle_.begin());
+    streams_.erase(idle->key);
+  }
+
+  stream->tag = NextTag(stream->finish);
+  if (stream->messages.empty()) {
+    idle_.emplace(stream->tag, stream);
+  } else {
+    active_.emplace(stream->tag, stream);
+  }
+}
+
+void EgressQueue::Clear() {
+  active_.clear();
+  idle_.clear();
+  streams_.clear();
+  in_service_ = nullptr;
+  virtual_time_ = 0;
+  next_order_ = 0;
+  size_ = 0;
+}
+
+}  // namespace overnet
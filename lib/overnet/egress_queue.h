@@ -0,0 +1,80 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <assert.h>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include "router.h"
+
+namespace overnet {
+
+// Messages waiting to be sent over a link.
+// Messages are queued per stream, and streams are served by start-time fair
+// queueing: each backlogged stream gets a share of the link in proportion to
+// the weight of its priority. A message on an otherwise idle stream waits
+// behind at most one message from each backlogged stream, however deep their
+// queues are.
+class EgressQueue {
+ public:
+  EgressQueue() = default;
+  EgressQueue(const EgressQueue&) = delete;
+  EgressQueue& operator=(const EgressQueue&) = delete;
+
+  static uint64_t Weight(StreamPriority priority);
+
+  bool empty() const { return size_ == 0; }
+  size_t size() const { return size_; }
+
+  void Push(Message message);
+  // The next message to send.
+  const Message& front() const {
+    assert(!active_.empty());
+    return active_.begin()->second->messages.front();
+  }
+  // Removes the next message to send. Sent must be called, with the number of
+  // bytes it took, before the next Pop: the length of a message is only known
+  // once its payload has been made, which may push more messages.
+  Message Pop();
+  void Sent(uint64_t length);
+  void Clear();
+
+ private:
+  using StreamKey = router_impl::LocalStreamId;
+  // Orders streams by virtual time tag, then by arrival.
+  using Tag = std::pair<uint64_t, uint64_t>;
+
+  struct Stream {
+    explicit Stream(StreamKey key) : key(key) {}
+    const StreamKey key;
+    std::deque<Message> messages;
+    // Virtual time at which this stream's last sent message finished.
+    uint64_t finish = 0;
+    // Key in active_ (if messages is non-empty) or idle_ (otherwise), unless
+    // in service.
+    Tag tag;
+    StreamPriority priority_in_service;
+  };
+
+  Tag NextTag(uint64_t virtual_time) {
+    return Tag(virtual_time, next_order_++);
+  }
+
+  std::unordered_map<StreamKey, Stream> streams_;
+  // Backlogged streams, by the virtual time their next message starts.
+  std::map<Tag, Stream*> active_;
+  // Streams with nothing queued whose last message is still being paid for:
+  // forgotten once the virtual clock passes their finish time.
+  std::map<Tag, Stream*> idle_;
+  // Stream of the message last popped, until it's been sent.
+  Stream* in_service_ = nullptr;
+  // Start time of the message most recently sent.
+  uint64_t virtual_time_ = 0;
+  uint64_t next_order_ = 0;
+  size_t size_ = 0;
+};
+
+}  // namespace overnet
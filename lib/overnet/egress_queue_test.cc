@@ -0,0 +1,111 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "egress_queue.h"
+#include <map>
+#include "gtest/gtest.h"
+
+namespace overnet {
+namespace egress_queue_test {
+
+static constexpr uint64_t kMessageLength = 1000;
+
+Message MakeMessage(uint64_t stream, uint64_t seq, StreamPriority priority) {
+  return Message::SimpleForwarder(
+      std::move(RoutableMessage(NodeId(1)).AddDestination(
+          NodeId(2), StreamId(stream), SeqNum(seq, 1))),
+      Slice::RepeatedChar(kMessageLength, 'a'), TimeStamp::Epoch(), priority);
+}
+
+// Pops a message, returning its stream id.
+uint64_t PopStream(EgressQueue* queue) {
+  Message message = queue->Pop();
+  queue->Sent(kMessageLength);
+  return message.header.destinations()[0].stream_id().get();
+}
+
+TEST(EgressQueue, OneStreamIsFifo) {
+  EgressQueue queue;
+  EXPECT_TRUE(queue.empty());
+  for (uint64_t i = 1; i <= 3; i++) {
+    queue.Push(MakeMessage(1, i, StreamPriority::Default));
+  }
+  EXPECT_EQ(3u, queue.size());
+  for (uint64_t i = 1; i <= 3; i++) {
+    EXPECT_EQ(i, queue.front()
+                     .header.destinations()[0]
+                     .seq()
+                     .ReconstructFromZero_TestOnly());
+    queue.Pop();
+    queue.Sent(kMessageLength);
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(EgressQueue, SharesByWeight) {
+  const std::pair<StreamPriority, StreamPriority> pairs[] = {
+      {StreamPriority::Bulk, StreamPriority::Default},
+      {StreamPriority::Bulk, StreamPriority::Interactive},
+      {StreamPriority::Default, StreamPriority::Interactive},
+  };
+  for (auto priorities : pairs) {
+    EgressQueue queue;
+    for (uint64_t i = 1; i <= 1000; i++) {
+      queue.Push(MakeMessage(1, i, priorities.first));
+      queue.Push(MakeMessage(2, i, priorities.second));
+    }
+    std::map<uint64_t, uint64_t> sent;
+    for (int i = 0; i < 500; i++) {
+      sent[PopStream(&queue)]++;
+    }
+    const uint64_t expect_ratio = EgressQueue::Weight(priorities.second) /
+                                  EgressQueue::Weight(priorities.first);
+    EXPECT_NEAR(expect_ratio, double(sent[2]) / sent[1], 0.5)
+        << sent[1] << " " << sent[2];
+  }
+}
+
+TEST(EgressQueue, NewStreamSkipsBacklog) {
+  EgressQueue queue;
+  for (uint64_t i = 1; i <= 1000; i++) {
+    queue.Push(MakeMessage(1, i, StreamPriority::Interactive));
+  }
+  EXPECT_EQ(1u, PopStream(&queue));
+  // Even a bulk stream only waits for the message it arrived behind.
+  queue.Push(MakeMessage(2, 1, StreamPriority::Bulk));
+  EXPECT_EQ(2u, PopStream(&queue));
+  EXPECT_EQ(1u, PopStream(&queue));
+}
+
+TEST(EgressQueue, PushWhileSending) {
+  EgressQueue queue;
+  queue.Push(MakeMessage(1, 1, StreamPriority::Default));
+  queue.Pop();
+  // Making a payload may queue more messages, on this or other streams.
+  queue.Push(MakeMessage(1, 2, StreamPriority::Default));
+  queue.Push(MakeMessage(2, 1, StreamPriority::Default));
+  queue.Sent(kMessageLength);
+  EXPECT_EQ(2u, queue.size());
+  // Stream 2 got in while stream 1 was paying for its first message.
+  EXPECT_EQ(2u, PopStream(&queue));
+  EXPECT_EQ(1u, PopStream(&queue));
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(EgressQueue, IdleStreamsArePaidUp) {
+  EgressQueue queue;
+  queue.Push(MakeMessage(1, 1, StreamPriority::Interactive));
+  queue.Push(MakeMessage(1, 2, StreamPriority::Interactive));
+  queue.Push(MakeMessage(2, 1, StreamPriority::Default));
+  EXPECT_EQ(1u, PopStream(&queue));
+  EXPECT_EQ(2u, PopStream(&queue));
+  // Stream 2's message cost it four times what stream 1's did: going idle
+  // mustn't let it jump the queue.
+  queue.Push(MakeMessage(2, 2, StreamPriority::Default));
+  EXPECT_EQ(1u, PopStream(&queue));
+  EXPECT_EQ(2u, PopStream(&queue));
+}
+
+}  // namespace egress_queue_test
+}  // namespace overnet
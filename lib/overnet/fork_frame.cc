@@ -8,11 +8,17 @@ namespace overnet {
 
 Slice ForkFrame::Write() const {
   auto stream_id_length = stream_id_.wire_length();
-  return introduction_.WithPrefix(stream_id_length + 1, [=](uint8_t* bytes) {
-    uint8_t* p = bytes;
-    p = stream_id_.Write(stream_id_length, p);
-    *p++ = static_cast<uint8_t>(reliability_and_ordering_);
-  });
+  const bool compressed = compression_ != Compression::None;
+  return introduction_.WithPrefix(
+      stream_id_length + 1 + compressed, [=](uint8_t* bytes) {
+        uint8_t* p = bytes;
+        p = stream_id_.Write(stream_id_length, p);
+        *p++ = static_cast<uint8_t>(reliability_and_ordering_) |
+               (compressed ? kFlagCompressed : 0);
+        if (compressed) {
+          *p++ = static_cast<uint8_t>(compression_);
+        }
+      });
 }
 
 StatusOr<ForkFrame> ForkFrame::Parse(Slice slice) {
@@ -29,9 +35,23 @@ StatusOr<ForkFrame> ForkFrame::Parse(Slice slice) {
         StatusCode::DATA_LOSS,
         "Failed to parse fork frame reliability and ordering byte");
   }
-  auto reliability_and_ordering = static_cast<ReliabilityAndOrdering>(*p++);
+  const uint8_t reliability_and_ordering_byte = *p++;
+  auto reliability_and_ordering = static_cast<ReliabilityAndOrdering>(
+      reliability_and_ordering_byte & ~kFlagCompressed);
+  Compression compression = Compression::None;
+  if (reliability_and_ordering_byte & kFlagCompressed) {
+    if (p == end) {
+      return StatusOr<ForkFrame>(StatusCode::DATA_LOSS,
+                                 "Failed to parse fork frame compression byte");
+    }
+    compression = static_cast<Compression>(*p++);
+    if (compression != Compression::Deflate) {
+      return StatusOr<ForkFrame>(StatusCode::DATA_LOSS,
+                                 "Unknown compression in fork frame");
+    }
+  }
   return ForkFrame(StreamId(stream_id), reliability_and_ordering,
-                   slice.FromOffset(p - begin));
+                   slice.FromOffset(p - begin), compression);
 }
 
 }  // namespace overnet
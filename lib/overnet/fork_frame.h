@@ -7,6 +7,7 @@
 #include "reliability_and_ordering.h"
 #include "slice.h"
 #include "status.h"
+#include "stream_compression.h"
 #include "stream_id.h"
 
 namespace overnet {
@@ -16,9 +17,10 @@ namespace overnet {
 class ForkFrame {
  public:
   ForkFrame(StreamId stream_id, ReliabilityAndOrdering reliability_and_ordering,
-            Slice introduction)
+            Slice introduction, Compression compression = Compression::None)
       : stream_id_(stream_id),
         reliability_and_ordering_(reliability_and_ordering),
+        compression_(compression),
         introduction_(std::move(introduction)) {}
 
   static StatusOr<ForkFrame> Parse(Slice slice);
@@ -28,17 +30,23 @@ class ForkFrame {
   ReliabilityAndOrdering reliability_and_ordering() const {
     return reliability_and_ordering_;
   }
+  Compression compression() const { return compression_; }
   const Slice& introduction() const { return introduction_; }
 
   friend bool operator==(const ForkFrame& a, const ForkFrame& b) {
     return std::tie(a.stream_id_, a.reliability_and_ordering_,
-                    a.introduction_) ==
-           std::tie(b.stream_id_, b.reliability_and_ordering_, b.introduction_);
+                    a.compression_, a.introduction_) ==
+           std::tie(b.stream_id_, b.reliability_and_ordering_, b.compression_,
+                    b.introduction_);
   }
 
  private:
+  // Set on the reliability and ordering byte when a compression byte follows.
+  static constexpr uint8_t kFlagCompressed = 0x80;
+
   StreamId stream_id_;
   ReliabilityAndOrdering reliability_and_ordering_;
+  Compression compression_;
   Slice introduction_;
 };
 
@@ -23,5 +23,16 @@ TEST(ForkFrame, SomeFrame) {
             std::vector<uint8_t>{1, 1, 'A', 'B', 'C'});
 }
 
+TEST(ForkFrame, CompressedFrame) {
+  RoundTrip(ForkFrame(StreamId(1), ReliabilityAndOrdering::ReliableOrdered,
+                      Slice::FromStaticString("ABC"), Compression::Deflate),
+            std::vector<uint8_t>{1, 0x81, 1, 'A', 'B', 'C'});
+}
+
+TEST(ForkFrame, UnknownCompression) {
+  EXPECT_TRUE(
+      ForkFrame::Parse(Slice::FromContainer({1, 0x81, 7, 'A'})).is_error());
+}
+
 }  // namespace fork_frame_test
 }  // namespace overnet
\ No newline at end of file
@@ -187,10 +187,17 @@ def mapdep(n):
     m = {
         '//third_party/googletest:gtest': '@com_google_googletest//:gtest',
         '//third_party/googletest:gmock': None,
+        # Linked from the system: see SYSTEM_LIBS.
+        '//third_party/zlib': None,
     }
     return m[n]
 
 
+SYSTEM_LIBS = {
+    '//third_party/zlib': '-lz',
+}
+
+
 FUZZERS = ['bbr', 'internal_list', 'linearizer',
            'packet_protocol', 'receive_mode', 'routing_header']
 
@@ -205,9 +212,15 @@ with open('BUILD.bazel', 'w') as o:
                 print >>o, '  name="%s",' % bundle.name
                 print >>o, '  srcs=[%s],' % ','.join(
                     '"%s"' % s for s in bundle.values['sources'])
-                if 'deps' in bundle.values:
+                deps = bundle.values.get('deps', []) + \
+                    bundle.values.get('public_deps', [])
+                if deps:
                     print >>o, '  deps=[%s],' % ','.join(
-                        '"%s"' % mapdep(s) for s in bundle.values['deps'] if mapdep(s) is not None)
+                        '"%s"' % mapdep(s) for s in deps if mapdep(s) is not None)
+                linkopts = [SYSTEM_LIBS[s] for s in deps if s in SYSTEM_LIBS]
+                if linkopts:
+                    print >>o, '  linkopts=[%s],' % ','.join(
+                        '"%s"' % s for s in linkopts)
                 print >>o, ')'
             if bundle.rule == 'executable':
                 if bundle.values.get('testonly', False):
@@ -34,22 +34,21 @@ void Linearizer::ValidateInternals() const {
     assert(pending_push_.empty());
   }
   // No pending read callback if the next thing is ready.
-  if ((!pending_push_.empty() && pending_push_.begin()->first == offset_)) {
+  if ((!pending_push_.empty() && pending_push_.front().offset == offset_)) {
     assert(read_mode_ == ReadMode::Idle);
   }
   // The first thing in the pending queue should be after our read bytes.
   if (!pending_push_.empty())
-    assert(pending_push_.begin()->first >= offset_);
-  // There should be no overlap between chunks in the pending map.
+    assert(pending_push_.front().offset >= offset_);
+  // There should be no overlap between chunks in the pending ring.
   uint64_t seen_to = offset_;
-  for (const auto& el : pending_push_) {
-    assert(seen_to <= el.first);
-    seen_to = el.first + el.second.length();
+  for (size_t i = 0; i < pending_push_.size(); i++) {
+    assert(seen_to <= pending_push_[i].offset);
+    seen_to = pending_push_[i].end();
   }
   // Should not exceed our buffering limits.
   if (!pending_push_.empty()) {
-    auto last = std::prev(pending_push_.end());
-    assert(last->first + last->second.length() <= offset_ + max_buffer_);
+    assert(pending_push_.back().end() <= offset_ + max_buffer_);
   }
 #endif
 }
@@ -70,12 +69,12 @@ void Linearizer::Close(const Status& status, Callback<void> quiesced) {
       break;
     case ReadMode::Idle:
       IdleToClosed(status);
-      pending_push_.clear();
+      pending_push_.Clear();
       break;
     case ReadMode::ReadSlice: {
       auto push = std::move(ReadSliceToIdle().done);
       IdleToClosed(status);
-      pending_push_.clear();
+      pending_push_.Clear();
       if (status.is_ok()) {
         push(Nothing);
       } else {
@@ -85,7 +84,7 @@ void Linearizer::Close(const Status& status, Callback<void> quiesced) {
     case ReadMode::ReadAll: {
       auto rd = ReadAllToIdle();
       IdleToClosed(status);
-      pending_push_.clear();
+      pending_push_.Clear();
       if (status.is_ok()) {
         rd.done(std::move(rd.building));
       } else {
@@ -129,14 +128,13 @@ void Linearizer::Push(Chunk chunk) {
                    "Already read past end of message"));
     }
     if (!pending_push_.empty()) {
-      const auto it = pending_push_.rbegin();
-      const auto end = it->first + it->second.length();
-      if (end > chunk_end) {
+      if (pending_push_.back().end() > chunk_end) {
         Close(Status(StatusCode::INVALID_ARGUMENT,
                      "Already received bytes past end of message"));
       }
     }
     if (offset_ == chunk_end) {
+      length_ = chunk_end;
       Close(Status::Ok());
     }
   }
@@ -154,7 +152,7 @@ void Linearizer::Push(Chunk chunk) {
   // Fast path: already a pending read ready, this chunk is at the head of what
   // we're waiting for, and overlaps with nothing.
   if (read_mode_ == ReadMode::ReadSlice && chunk_start == offset_ &&
-      (pending_push_.empty() || pending_push_.begin()->first > chunk_end)) {
+      (pending_push_.empty() || pending_push_.front().offset > chunk_end)) {
     OVERNET_TRACE(DEBUG, trace_sink_) << "Push: fast-path";
     offset_ += chunk.slice.length();
     auto push = std::move(ReadSliceToIdle().done);
@@ -188,7 +186,7 @@ void Linearizer::Push(Chunk chunk) {
   // exit conditions, and we've got some common checks to do once it's finished.
   if (pending_push_.empty()) {
     OVERNET_TRACE(DEBUG, trace_sink_) << "Push: first pending";
-    pending_push_.emplace(chunk.offset, std::move(chunk.slice));
+    pending_push_.Insert(0, chunk.offset, std::move(chunk.slice));
   } else {
     IntegratePush(std::move(chunk));
   }
@@ -217,38 +215,39 @@ void Linearizer::IntegratePush(Chunk chunk) {
         return out.str();
       });
 
-  auto lb = pending_push_.lower_bound(chunk.offset);
-  if (lb != pending_push_.end() && lb->first == chunk.offset) {
+  const size_t lb = pending_push_.LowerBound(chunk.offset);
+  if (lb != pending_push_.size() && pending_push_[lb].offset == chunk.offset) {
+    const Slice& existing = pending_push_[lb].slice;
     // Coincident with another chunk we've already received.
     // First check whether the common bytes are the same.
     const size_t common_length =
-        std::min(chunk.slice.length(), lb->second.length());
+        std::min(chunk.slice.length(), existing.length());
     OVERNET_TRACE(DEBUG, trace_sink)
         << "coincident with existing; common_length=" << common_length;
-    if (0 != memcmp(chunk.slice.begin(), lb->second.begin(), common_length)) {
+    if (0 != memcmp(chunk.slice.begin(), existing.begin(), common_length)) {
       Close(Status(StatusCode::DATA_LOSS,
                    "Linearizer received different bytes for the same span"));
-    } else if (chunk.slice.length() <= lb->second.length()) {
+    } else if (chunk.slice.length() <= existing.length()) {
       // New chunk is shorter than what's there (or the same length): We're
       // done.
     } else {
       // New chunk is bigger than what's there: we create a new (tail) chunk and
       // continue integration
-      chunk.TrimBegin(lb->second.length());
+      chunk.TrimBegin(existing.length());
       IntegratePush(std::move(chunk));
     }
     // Early out.
     return;
   }
 
-  if (lb != pending_push_.begin()) {
+  if (lb != 0) {
     // Find the chunk *before* this one
-    const auto before = std::prev(lb);
-    assert(before->first < chunk.offset);
+    const PendingChunk& before = pending_push_[lb - 1];
+    assert(before.offset < chunk.offset);
     // Check to see if that chunk overlaps with this one.
-    const size_t before_end = before->first + before->second.length();
+    const size_t before_end = before.end();
     OVERNET_TRACE(DEBUG, trace_sink)
-        << "prior chunk start=" << before->first << " end=" << before_end;
+        << "prior chunk start=" << before.offset << " end=" << before_end;
     if (before_end > chunk.offset) {
       // Prior chunk overlaps with this one.
       // First check whether the common bytes are the same.
@@ -256,7 +255,7 @@ void Linearizer::IntegratePush(Chunk chunk) {
           std::min(before_end - chunk.offset, uint64_t(chunk.slice.length()));
       OVERNET_TRACE(DEBUG, trace_sink)
           << "overlap with prior; common_length=" << common_length;
-      if (0 != memcmp(before->second.begin() + (chunk.offset - before->first),
+      if (0 != memcmp(before.slice.begin() + (chunk.offset - before.offset),
                       chunk.slice.begin(), common_length)) {
         Close(Status(StatusCode::DATA_LOSS,
                      "Linearizer received different bytes for the same span"));
@@ -272,39 +271,37 @@ void Linearizer::IntegratePush(Chunk chunk) {
     }
   }
 
-  if (lb != pending_push_.end()) {
+  if (lb != pending_push_.size()) {
     // Find the chunk *after* this one.
-    const auto after = lb;
-    assert(after->first > chunk.offset);
+    const PendingChunk& after = pending_push_[lb];
+    assert(after.offset > chunk.offset);
     // Check to see if that chunk overlaps with this one.
     OVERNET_TRACE(DEBUG, trace_sink)
-        << "subsequent chunk start=" << after->first
-        << " end=" << (after->first + after->second.length());
-    if (after->first < chunk.offset + chunk.slice.length()) {
+        << "subsequent chunk start=" << after.offset << " end=" << after.end();
+    if (after.offset < chunk.offset + chunk.slice.length()) {
       const size_t common_length =
-          std::min(chunk.offset + chunk.slice.length() - after->first,
-                   uint64_t(after->second.length()));
+          std::min(chunk.offset + chunk.slice.length() - after.offset,
+                   uint64_t(after.slice.length()));
       OVERNET_TRACE(DEBUG, trace_sink)
           << "overlap with subsequent; common_length=" << common_length;
-      if (0 != memcmp(after->second.begin(),
-                      chunk.slice.begin() + (after->first - chunk.offset),
+      if (0 != memcmp(after.slice.begin(),
+                      chunk.slice.begin() + (after.offset - chunk.offset),
                       common_length)) {
         Close(Status(StatusCode::DATA_LOSS,
                      "Linearizer received different bytes for the same span"));
         return;
-      } else if (after->first + after->second.length() <
-                 chunk.offset + chunk.slice.length()) {
+      } else if (after.end() < chunk.offset + chunk.slice.length()) {
         OVERNET_TRACE(DEBUG, trace_sink) << "Split and integrate separately";
         // Split chunk into two and integrate each separately
         Chunk tail = chunk;
-        chunk.TrimEnd(chunk.offset + chunk.slice.length() - after->first);
-        tail.TrimBegin(after->first + after->second.length() - tail.offset);
+        chunk.TrimEnd(chunk.offset + chunk.slice.length() - after.offset);
+        tail.TrimBegin(after.end() - tail.offset);
         IntegratePush(std::move(chunk));
         IntegratePush(std::move(tail));
         return;
       } else {
         // Trim so the new chunk no longer overlaps.
-        chunk.TrimEnd(chunk.offset + chunk.slice.length() - after->first);
+        chunk.TrimEnd(chunk.offset + chunk.slice.length() - after.offset);
       }
     }
   }
@@ -313,7 +310,7 @@ void Linearizer::IntegratePush(Chunk chunk) {
   OVERNET_TRACE(DEBUG, trace_sink)
       << "add pending start=" << chunk.offset
       << " end=" << (chunk.offset + chunk.slice.length());
-  pending_push_.emplace_hint(lb, chunk.offset, std::move(chunk.slice));
+  pending_push_.Insert(lb, chunk.offset, std::move(chunk.slice));
 }
 
 void Linearizer::Pull(StatusOrCallback<Optional<Slice>> push) {
@@ -331,11 +328,9 @@ void Linearizer::Pull(StatusOrCallback<Optional<Slice>> push) {
       abort();
     case ReadMode::Idle: {
       // Check to see if there's data already available.
-      auto it = pending_push_.begin();
-      if (it != pending_push_.end() && it->first == offset_) {
+      if (!pending_push_.empty() && pending_push_.front().offset == offset_) {
         // There is!
-        Slice slice = std::move(it->second);
-        pending_push_.erase(it);
+        Slice slice = pending_push_.PopFront();
         offset_ += slice.length();
         if (length_) {
           assert(offset_ <= *length_);
@@ -377,15 +372,13 @@ void Linearizer::PullAll(StatusOrCallback<std::vector<Slice>> push) {
 void Linearizer::ContinueReadAll() {
   for (;;) {
     assert(read_mode_ == ReadMode::ReadAll);
-    auto it = pending_push_.begin();
-    if (it == pending_push_.end()) {
+    if (pending_push_.empty()) {
       return;
     }
-    if (it->first != offset_) {
+    if (pending_push_.front().offset != offset_) {
       return;
     }
-    auto slice = std::move(it->second);
-    pending_push_.erase(it);
+    auto slice = pending_push_.PopFront();
     offset_ += slice.length();
     read_data_.read_all.building.emplace_back(std::move(slice));
     if (length_) {
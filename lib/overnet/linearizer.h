@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <map>
+#include "chunk_ring.h"
 #include "optional.h"
 #include "sink.h"
 #include "slice.h"
@@ -26,6 +26,10 @@ class Linearizer final : public Sink<Chunk>, public Source<Slice> {
   void PullAll(StatusOrCallback<std::vector<Slice>> ready) override;
   void Close(const Status& status) override;
 
+  // True once the end of the message is known and every byte up to it has
+  // been read.
+  bool Complete() const { return length_ && offset_ == *length_; }
+
  private:
   void IntegratePush(Chunk chunk);
   void ValidateInternals() const;
@@ -34,7 +38,8 @@ class Linearizer final : public Sink<Chunk>, public Source<Slice> {
   const TraceSink trace_sink_;
   uint64_t offset_ = 0;
   Optional<uint64_t> length_;
-  std::map<uint64_t, Slice> pending_push_;
+  // Chunks received beyond offset_, waiting for the gaps before them.
+  ChunkRing pending_push_;
 
   enum class ReadMode {
     Closed,
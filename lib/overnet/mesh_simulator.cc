@@ -0,0 +1,485 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mesh_simulator.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <queue>
+#include "packet_link.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace overnet {
+
+namespace {
+
+// Bytes of heap in use by the process. Only glibc 2.33 and later can say
+// (with mallinfo2): elsewhere this is Nothing.
+Optional<uint64_t> HeapBytesInUse() {
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  return uint64_t(mallinfo2().uordblks);
+#else
+  return Nothing;
+#endif
+}
+
+// Link state flooded from one node to the others.
+struct LinkState {
+  std::vector<NodeMetrics> nodes;
+  std::vector<LinkMetrics> links;
+};
+
+}  // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// SimulatedLink
+
+class MeshSimulator::SimulatedLink final : public PacketLink {
+ public:
+  SimulatedLink(MeshSimulator* simulator, RouterEndpoint* src, NodeId peer,
+                const SimulatedLinkOptions& options)
+      : PacketLink(src->router(), TraceSink(), peer, options.mss),
+        simulator_(simulator),
+        options_(options) {}
+  ~SimulatedLink() { *self_ = nullptr; }
+
+  void set_partner(SimulatedLink* partner) { partner_ = partner->self_; }
+
+  void Emit(Slice packet) override {
+    TestTimer* const timer = &simulator_->timer_;
+    std::mt19937_64* const rng = &simulator_->rng_;
+    simulator_->packets_sent_++;
+    // Packets queue to be clocked onto the wire, and then take |delay| plus
+    // some jitter to cross it. Jitter never lets one packet overtake another.
+    wire_free_ = std::max(wire_free_, timer->Now()) +
+                 options_.bandwidth.SendTimeForBytes(packet.length());
+    TimeStamp arrival = wire_free_ + options_.delay;
+    if (options_.jitter > TimeDelta::Zero()) {
+      arrival = arrival + TimeDelta::FromMicroseconds(
+                              std::uniform_int_distribution<int64_t>(
+                                  0, options_.jitter.as_us() - 1)(*rng));
+    }
+    arrival = std::max(arrival, last_arrival_);
+    last_arrival_ = arrival;
+    if (options_.loss > 0.0 &&
+        std::bernoulli_distribution(options_.loss)(*rng)) {
+      simulator_->packets_lost_++;
+      return;
+    }
+    timer->At(arrival,
+              Callback<void>(ALLOCATED_CALLBACK,
+                             [partner = partner_, packet, timer]() {
+                               // Packets in flight when a link goes away
+                               // are dropped.
+                               if (*partner != nullptr)
+                                 (*partner)->Process(timer->Now(), packet);
+                             }));
+  }
+
+ private:
+  MeshSimulator* const simulator_;
+  const SimulatedLinkOptions options_;
+  const std::shared_ptr<SimulatedLink*> self_ =
+      std::make_shared<SimulatedLink*>(this);
+  std::shared_ptr<SimulatedLink*> partner_;
+  TimeStamp wire_free_ = TimeStamp::Epoch();
+  TimeStamp last_arrival_ = TimeStamp::Epoch();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Flows
+
+// Sending side of one flow.
+struct MeshSimulator::Sender {
+  MeshSimulator* simulator;
+  SimulatedFlowOptions options;
+  ClosedPtr<RouterEndpoint::Stream> stream;
+  size_t sent = 0;
+  size_t outstanding = 0;
+};
+
+struct MeshSimulator::OutgoingMessage {
+  explicit OutgoingMessage(Sender* sender)
+      : sender(sender),
+        op(sender->stream.get(), sender->options.message_size) {}
+  Sender* const sender;
+  RouterEndpoint::SendOp op;
+};
+
+// Receiving side of one flow.
+struct MeshSimulator::Receiver {
+  MeshSimulator* simulator;
+  ClosedPtr<RouterEndpoint::Stream> stream;
+  RouterEndpoint::ReceiveOp* pending = nullptr;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// MeshSimulator proper
+
+MeshSimulator::MeshSimulator(size_t nodes, uint64_t seed,
+                             TimeDelta link_state_interval)
+    : rng_(seed),
+      link_state_interval_(link_state_interval),
+      heap_bytes_at_start_(HeapBytesInUse()) {
+  // Bbr picks its initial gain cycle phase with rand().
+  srand(seed);
+  nodes_.reserve(nodes);
+  for (size_t i = 0; i < nodes; i++) {
+    nodes_.emplace_back(Node{
+        new RouterEndpoint(&timer_, TraceSink(), NodeId(i + 1), false),
+        {},
+        {}});
+    AcceptStreams(i);
+  }
+}
+
+MeshSimulator::~MeshSimulator() {
+  shutting_down_ = true;
+  CloseStreams();
+  CloseEndpoints();
+}
+
+void MeshSimulator::Connect(size_t a, size_t b,
+                            const SimulatedLinkOptions& options) {
+  assert(a != b);
+  RouterEndpoint* const endpoint_a = nodes_[a].endpoint;
+  RouterEndpoint* const endpoint_b = nodes_[b].endpoint;
+  auto link_ab =
+      MakeLink<SimulatedLink>(this, endpoint_a, endpoint_b->node_id(), options);
+  auto link_ba =
+      MakeLink<SimulatedLink>(this, endpoint_b, endpoint_a->node_id(), options);
+  link_ab->set_partner(link_ba.get());
+  link_ba->set_partner(link_ab.get());
+  nodes_[a].links.push_back(link_ab.get());
+  nodes_[b].links.push_back(link_ba.get());
+  nodes_[a].neighbors.emplace_back(b, options.delay);
+  nodes_[b].neighbors.emplace_back(a, options.delay);
+  endpoint_a->RegisterPeer(endpoint_b->node_id());
+  endpoint_b->RegisterPeer(endpoint_a->node_id());
+  endpoint_a->router()->RegisterLink(std::move(link_ab));
+  endpoint_b->router()->RegisterLink(std::move(link_ba));
+  links_++;
+}
+
+void MeshSimulator::StartFlow(size_t from, size_t to,
+                              const SimulatedFlowOptions& options) {
+  assert(from != to);
+  assert(options.message_size >= sizeof(int64_t));
+  assert(options.window >= 1);
+  RouterEndpoint* const src = nodes_[from].endpoint;
+  RouterEndpoint* const dst = nodes_[to].endpoint;
+  src->RegisterPeer(dst->node_id());
+  dst->RegisterPeer(src->node_id());
+  auto new_stream =
+      src->SendIntro(dst->node_id(), options.reliability_and_ordering,
+                     Slice::FromStaticString("mesh"));
+  // Only fails for unregistered peers.
+  assert(new_stream.is_ok());
+
+  if (!first_send_.has_value())
+    first_send_ = timer_.Now();
+  auto sender = std::make_unique<Sender>();
+  sender->simulator = this;
+  sender->options = options;
+  sender->stream = MakeClosedPtr<RouterEndpoint::Stream>(
+      std::move(*new_stream.get()), TraceSink());
+  SendMore(sender.get());
+  senders_.emplace_back(std::move(sender));
+}
+
+Optional<TimeDelta> MeshSimulator::RunUntilConverged(TimeDelta timeout) {
+  // Checking every route after every event would dominate the run time, so
+  // convergence is measured to the millisecond.
+  static constexpr TimeDelta kPollInterval = TimeDelta::FromMilliseconds(1);
+  const TimeStamp start = timer_.Now();
+  const TimeStamp deadline = start + timeout;
+  MaybeStartAnnouncingLinks();
+  while (!Converged()) {
+    if (timer_.Now() >= deadline)
+      return Nothing;
+    RunFor(std::min(kPollInterval, deadline - timer_.Now()));
+  }
+  convergence_time_ = timer_.Now() - start;
+  return convergence_time_;
+}
+
+bool MeshSimulator::RunUntilFlowsComplete(TimeDelta timeout) {
+  return RunUntil(
+      [this]() {
+        return finished_senders_ == senders_.size() &&
+               messages_delivered() == messages_sent_;
+      },
+      timer_.Now() + timeout);
+}
+
+void MeshSimulator::RunFor(TimeDelta duration) {
+  RunUntil([]() { return false; }, timer_.Now() + duration);
+}
+
+bool MeshSimulator::RunUntil(std::function<bool()> done, TimeStamp deadline) {
+  MaybeStartAnnouncingLinks();
+  while (!done()) {
+    const TimeStamp now = timer_.Now();
+    if (now >= deadline)
+      return false;
+    if (!timer_.StepUntilNextEvent(deadline - now) && timer_.Now() == now) {
+      // Nothing left to happen.
+      timer_.Step((deadline - now).as_us());
+    }
+  }
+  return true;
+}
+
+bool MeshSimulator::Converged() const {
+  for (const auto& from : nodes_) {
+    for (const auto& to : nodes_) {
+      if (!from.endpoint->router()->HasRouteTo(to.endpoint->node_id()))
+        return false;
+    }
+  }
+  return true;
+}
+
+void MeshSimulator::MaybeStartAnnouncingLinks() {
+  if (announcing_links_)
+    return;
+  announcing_links_ = true;
+  AnnounceLinks();
+}
+
+void MeshSimulator::AnnounceLinks() {
+  if (shutting_down_)
+    return;
+  for (size_t src = 0; src < nodes_.size(); src++) {
+    const Node& node = nodes_[src];
+    if (node.links.empty())
+      continue;
+    auto state = std::make_shared<LinkState>();
+    state->nodes.emplace_back(node.endpoint->node_id(), 0);
+    for (SimulatedLink* link : node.links) {
+      state->links.emplace_back(link->GetLinkMetrics());
+      state->nodes.emplace_back(state->links.back().to(), 0);
+    }
+    const std::vector<TimeDelta> delays = PropagationDelaysFrom(src);
+    for (size_t dst = 0; dst < nodes_.size(); dst++) {
+      if (dst == src || delays[dst] == TimeDelta::PositiveInf())
+        continue;
+      timer_.At(timer_.Now() + delays[dst], [this, dst, state]() {
+        if (shutting_down_)
+          return;
+        nodes_[dst].endpoint->router()->UpdateRoutingTable(state->nodes,
+                                                           state->links);
+      });
+    }
+  }
+  timer_.At(timer_.Now() + link_state_interval_,
+            [this]() { AnnounceLinks(); });
+}
+
+std::vector<TimeDelta> MeshSimulator::PropagationDelaysFrom(
+    size_t node) const {
+  std::vector<TimeDelta> delays(nodes_.size(), TimeDelta::PositiveInf());
+  using Entry = std::pair<TimeDelta, size_t>;
+  auto later = [](const Entry& a, const Entry& b) { return a.first > b.first; };
+  std::priority_queue<Entry, std::vector<Entry>, decltype(later)> todo(later);
+  delays[node] = TimeDelta::Zero();
+  todo.emplace(TimeDelta::Zero(), node);
+  while (!todo.empty()) {
+    const Entry entry = todo.top();
+    todo.pop();
+    if (entry.first > delays[entry.second])
+      continue;
+    for (const auto& neighbor : nodes_[entry.second].neighbors) {
+      const TimeDelta delay = entry.first + neighbor.second;
+      if (delay < delays[neighbor.first]) {
+        delays[neighbor.first] = delay;
+        todo.emplace(delay, neighbor.first);
+      }
+    }
+  }
+  return delays;
+}
+
+void MeshSimulator::AcceptStreams(size_t node) {
+  nodes_[node].endpoint->RecvIntro(
+      StatusOrCallback<RouterEndpoint::ReceivedIntroduction>(
+          ALLOCATED_CALLBACK,
+          [this, node](StatusOr<RouterEndpoint::ReceivedIntroduction>&&
+                           status) {
+            if (status.is_error())
+              return;
+            auto receiver = std::make_unique<Receiver>();
+            receiver->simulator = this;
+            receiver->stream = MakeClosedPtr<RouterEndpoint::Stream>(
+                std::move(status->new_stream), TraceSink());
+            ReceiveNext(receiver.get());
+            receivers_.emplace_back(std::move(receiver));
+            // Re-arm from the timer rather than from inside the callback that
+            // is being run (the test timer runs anything already due at
+            // once).
+            timer_.At(timer_.Now() + TimeDelta::FromMicroseconds(1),
+                      [this, node]() {
+                        if (!shutting_down_)
+                          AcceptStreams(node);
+                      });
+          }));
+}
+
+void MeshSimulator::SendMore(Sender* sender) {
+  if (shutting_down_)
+    return;
+  while (sender->sent < sender->options.messages &&
+         sender->outstanding < sender->options.window) {
+    // Each message carries the time it was sent.
+    const int64_t now = timer_.Now().after_epoch().as_us();
+    auto* message = new OutgoingMessage(sender);
+    message->op.Push(Slice::WithInitializer(
+        sender->options.message_size,
+        [now, size = sender->options.message_size](uint8_t* p) {
+          memset(p, 0, size);
+          memcpy(p, &now, sizeof(now));
+        }));
+    sender->sent++;
+    sender->outstanding++;
+    messages_sent_++;
+    // The op can only be deleted from its quiesced callback if that callback
+    // keeps no state besides the pointer.
+    message->op.Close(Status::Ok(), [message]() {
+      Sender* sender = message->sender;
+      delete message;
+      sender->outstanding--;
+      sender->simulator->SendMore(sender);
+    });
+  }
+  if (sender->sent == sender->options.messages && sender->outstanding == 0)
+    finished_senders_++;
+}
+
+void MeshSimulator::ReceiveNext(Receiver* receiver) {
+  auto* op = new RouterEndpoint::ReceiveOp(receiver->stream.get());
+  receiver->pending = op;
+  op->PullAll(StatusOrCallback<std::vector<Slice>>(
+      ALLOCATED_CALLBACK,
+      [op, receiver](const StatusOr<std::vector<Slice>>& status) {
+        receiver->pending = nullptr;
+        delete op;
+        if (status.is_error() || receiver->simulator->shutting_down_)
+          return;
+        receiver->simulator->MessageReceived(*status);
+        receiver->simulator->ReceiveNext(receiver);
+      }));
+}
+
+void MeshSimulator::MessageReceived(const std::vector<Slice>& message) {
+  const TimeStamp now = timer_.Now();
+  auto payload = Slice::Join(message.begin(), message.end());
+  if (payload.length() < sizeof(int64_t))
+    return;
+  int64_t sent;
+  memcpy(&sent, payload.begin(), sizeof(sent));
+  latencies_us_.push_back(now.after_epoch().as_us() - sent);
+  bytes_delivered_ += payload.length();
+  last_delivery_ = now;
+}
+
+TimeDelta MeshSimulator::LatencyPercentile(double p) const {
+  if (latencies_us_.empty())
+    return TimeDelta::PositiveInf();
+  std::vector<int64_t> sorted = latencies_us_;
+  const size_t index = static_cast<size_t>(p * (sorted.size() - 1));
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return TimeDelta::FromMicroseconds(sorted[index]);
+}
+
+void MeshSimulator::Report(CsvWriter* csv) const {
+  const int64_t elapsed_us =
+      first_send_.has_value() && last_delivery_.has_value()
+          ? (*last_delivery_ - *first_send_).as_us()
+          : 0;
+  const Optional<uint64_t> heap_bytes = HeapBytesInUse();
+  csv->Put("nodes", nodes_.size())
+      .Put("links", links_)
+      .Put("convergence_ms",
+           convergence_time_.has_value()
+               ? std::to_string(convergence_time_->as_us() / 1000.0)
+               : std::string("never"))
+      .Put("messages_sent", messages_sent_)
+      .Put("messages_delivered", messages_delivered())
+      .Put("throughput_kbps",
+           elapsed_us == 0 ? 0.0 : 8e3 * bytes_delivered_ / elapsed_us)
+      .Put("latency_p50_us", LatencyPercentile(0.5).as_us())
+      .Put("latency_p90_us", LatencyPercentile(0.9).as_us())
+      .Put("latency_p99_us", LatencyPercentile(0.99).as_us())
+      .Put("latency_max_us", LatencyPercentile(1.0).as_us())
+      .Put("packets_sent", packets_sent_)
+      .Put("packets_lost", packets_lost_)
+      .Put("heap_bytes_per_node",
+           !heap_bytes.has_value() || !heap_bytes_at_start_.has_value()
+               ? std::string("unavailable")
+               : std::to_string(*heap_bytes > *heap_bytes_at_start_
+                                    ? (*heap_bytes - *heap_bytes_at_start_) /
+                                          nodes_.size()
+                                    : 0));
+}
+
+void MeshSimulator::CloseStreams() {
+  // Streams must finish closing before the endpoints that carry them do.
+  // Flows may be cut short: their state lives until the streams are closed.
+  std::vector<RouterEndpoint::Stream*> streams;
+  for (auto& sender : senders_)
+    streams.push_back(sender->stream.release());
+  for (auto& receiver : receivers_) {
+    if (receiver->pending != nullptr)
+      receiver->pending->Close(Status::Cancelled());
+    streams.push_back(receiver->stream.release());
+  }
+
+  // Closes that miss the deadline complete later (at the latest when the timer
+  // goes), so they must not refer to anything on this stack.
+  auto open_streams = std::make_shared<size_t>(streams.size());
+  for (auto* stream : streams) {
+    stream->Close(Status::Ok(),
+                  Callback<void>(ALLOCATED_CALLBACK, [stream, open_streams]() {
+                    delete stream;
+                    (*open_streams)--;
+                  }));
+  }
+  RunUntil([open_streams]() { return *open_streams == 0; },
+           timer_.Now() + TimeDelta::FromSeconds(60));
+  senders_.clear();
+  receivers_.clear();
+}
+
+void MeshSimulator::CloseEndpoints() {
+  // Close the endpoints one after the other, then delete them all. A close
+  // that misses the deadline may complete once the simulator is gone, so it
+  // finds |closer| cleared and stops there.
+  auto closer = std::make_shared<MeshSimulator*>(this);
+  CloseEndpointsFrom(0, closer);
+  RunUntil([this]() { return nodes_.empty(); },
+           timer_.Now() + TimeDelta::FromSeconds(60));
+  *closer = nullptr;
+}
+
+void MeshSimulator::CloseEndpointsFrom(
+    size_t index, std::shared_ptr<MeshSimulator*> closer) {
+  if (index == nodes_.size()) {
+    for (auto& node : nodes_)
+      delete node.endpoint;
+    nodes_.clear();
+    return;
+  }
+  nodes_[index].endpoint->Close(
+      Callback<void>(ALLOCATED_CALLBACK, [index, closer]() {
+        if (*closer != nullptr)
+          (*closer)->CloseEndpointsFrom(index + 1, closer);
+      }));
+}
+
+}  // namespace overnet
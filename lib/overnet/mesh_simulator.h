@@ -0,0 +1,140 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+#include "bandwidth.h"
+#include "closed_ptr.h"
+#include "csv_writer.h"
+#include "router_endpoint.h"
+#include "test_timer.h"
+
+namespace overnet {
+
+// Shape of each direction of a simulated link.
+struct SimulatedLinkOptions {
+  Bandwidth bandwidth = Bandwidth::FromKilobitsPerSecond(100000);
+  TimeDelta delay = TimeDelta::FromMilliseconds(1);
+  // Each packet is further delayed by up to this much (uniformly), without
+  // being reordered.
+  TimeDelta jitter = TimeDelta::Zero();
+  // Probability of each packet being lost.
+  double loss = 0.0;
+  uint32_t mss = 1500;
+};
+
+// Messages sent from one node to another over one stream.
+struct SimulatedFlowOptions {
+  ReliabilityAndOrdering reliability_and_ordering =
+      ReliabilityAndOrdering::ReliableOrdered;
+  size_t messages = 1;
+  // At least 8: each message carries the time it was sent.
+  size_t message_size = 64;
+  // Messages sent but not yet acknowledged at any one time.
+  size_t window = 1;
+};
+
+// Deterministic discrete event simulation of a mesh of RouterEndpoints,
+// linked by PacketLinks over simulated wires, on one TestTimer.
+//
+// Overnet does not yet distribute link state between nodes, so the simulator
+// floods it out of band: every |link_state_interval|, each node's current
+// link metrics reach every other node after the least propagation delay
+// between them.
+//
+// Workloads are scripted by scheduling StartFlow calls on timer(). Runs with
+// the same seed, topology and script produce the same results.
+class MeshSimulator {
+ public:
+  MeshSimulator(size_t nodes, uint64_t seed,
+                TimeDelta link_state_interval = TimeDelta::FromSeconds(1));
+  ~MeshSimulator();
+  MeshSimulator(const MeshSimulator&) = delete;
+  MeshSimulator& operator=(const MeshSimulator&) = delete;
+
+  TestTimer* timer() { return &timer_; }
+  size_t size() const { return nodes_.size(); }
+  RouterEndpoint* endpoint(size_t node) { return nodes_[node].endpoint; }
+  std::mt19937_64* rng() { return &rng_; }
+
+  // Links nodes |a| and |b| in both directions.
+  void Connect(size_t a, size_t b, const SimulatedLinkOptions& options);
+  void StartFlow(size_t from, size_t to, const SimulatedFlowOptions& options);
+
+  // Returns how long it took for every node to have a route to every other
+  // node, or Nothing if that didn't happen within |timeout|.
+  Optional<TimeDelta> RunUntilConverged(TimeDelta timeout);
+  // Returns true if every flow finished, and every message it sent was
+  // delivered, within |timeout|.
+  bool RunUntilFlowsComplete(TimeDelta timeout);
+  void RunFor(TimeDelta duration);
+
+  uint64_t messages_sent() const { return messages_sent_; }
+  uint64_t messages_delivered() const { return latencies_us_.size(); }
+  // Latency of delivered messages, with |p| in [0, 1].
+  TimeDelta LatencyPercentile(double p) const;
+  Optional<TimeDelta> convergence_time() const { return convergence_time_; }
+  uint64_t packets_sent() const { return packets_sent_; }
+  uint64_t packets_lost() const { return packets_lost_; }
+
+  // Adds the run's results to the current row of |csv|: throughput, latency
+  // percentiles, convergence time, packet counts and heap use per node (which
+  // reads "unavailable" where the C library can't report it).
+  void Report(CsvWriter* csv) const;
+
+ private:
+  class SimulatedLink;
+  struct Sender;
+  struct Receiver;
+  struct OutgoingMessage;
+
+  struct Node {
+    RouterEndpoint* endpoint;
+    // Links from this node, and the nodes at their other ends.
+    std::vector<SimulatedLink*> links;
+    std::vector<std::pair<size_t, TimeDelta>> neighbors;
+  };
+
+  // Steps the timer until |done| or |deadline|; returns |done()|.
+  bool RunUntil(std::function<bool()> done, TimeStamp deadline);
+  bool Converged() const;
+  void MaybeStartAnnouncingLinks();
+  void AnnounceLinks();
+  std::vector<TimeDelta> PropagationDelaysFrom(size_t node) const;
+  void AcceptStreams(size_t node);
+  void SendMore(Sender* sender);
+  void ReceiveNext(Receiver* receiver);
+  void MessageReceived(const std::vector<Slice>& message);
+  void CloseStreams();
+  void CloseEndpoints();
+  void CloseEndpointsFrom(size_t index,
+                          std::shared_ptr<MeshSimulator*> closer);
+
+  TestTimer timer_;
+  std::mt19937_64 rng_;
+  const TimeDelta link_state_interval_;
+  const Optional<uint64_t> heap_bytes_at_start_;
+  std::vector<Node> nodes_;
+  std::vector<std::unique_ptr<Sender>> senders_;
+  std::vector<std::unique_ptr<Receiver>> receivers_;
+  bool announcing_links_ = false;
+  bool shutting_down_ = false;
+
+  uint64_t links_ = 0;
+  uint64_t messages_sent_ = 0;
+  uint64_t bytes_delivered_ = 0;
+  size_t finished_senders_ = 0;
+  std::vector<int64_t> latencies_us_;
+  Optional<TimeStamp> first_send_;
+  Optional<TimeStamp> last_delivery_;
+  Optional<TimeDelta> convergence_time_;
+  uint64_t packets_sent_ = 0;
+  uint64_t packets_lost_ = 0;
+};
+
+}  // namespace overnet
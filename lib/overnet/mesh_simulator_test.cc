@@ -0,0 +1,173 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mesh_simulator.h"
+#include <iostream>
+#include <sstream>
+#include "gtest/gtest.h"
+
+namespace overnet {
+namespace mesh_simulator_test {
+
+void BuildLine(MeshSimulator* sim, const SimulatedLinkOptions& options) {
+  for (size_t i = 1; i < sim->size(); i++) {
+    sim->Connect(i - 1, i, options);
+  }
+}
+
+// A ring, plus |chords| links between random pairs of nodes.
+void BuildRing(MeshSimulator* sim, size_t chords,
+               const SimulatedLinkOptions& options) {
+  for (size_t i = 0; i < sim->size(); i++) {
+    sim->Connect(i, (i + 1) % sim->size(), options);
+  }
+  std::uniform_int_distribution<size_t> pick(0, sim->size() - 1);
+  for (size_t i = 0; i < chords; i++) {
+    const size_t a = pick(*sim->rng());
+    size_t b = pick(*sim->rng());
+    while (b == a)
+      b = pick(*sim->rng());
+    sim->Connect(a, b, options);
+  }
+}
+
+// Starts |flows| flows between random pairs of nodes.
+void StartRandomFlows(MeshSimulator* sim, size_t flows,
+                      const SimulatedFlowOptions& options) {
+  std::uniform_int_distribution<size_t> pick(0, sim->size() - 1);
+  for (size_t i = 0; i < flows; i++) {
+    const size_t from = pick(*sim->rng());
+    size_t to = pick(*sim->rng());
+    while (to == from)
+      to = pick(*sim->rng());
+    sim->StartFlow(from, to, options);
+  }
+}
+
+TEST(MeshSimulator, LineConvergesAndDelivers) {
+  static constexpr int kNodes = 8;
+  MeshSimulator sim(kNodes, 1);
+  SimulatedLinkOptions link;
+  link.delay = TimeDelta::FromMilliseconds(5);
+  BuildLine(&sim, link);
+
+  auto convergence = sim.RunUntilConverged(TimeDelta::FromSeconds(10));
+  ASSERT_TRUE(convergence.has_value());
+  // Link state must cross the whole line.
+  EXPECT_GE(*convergence, (kNodes - 1) * link.delay);
+
+  SimulatedFlowOptions flow;
+  flow.messages = 20;
+  flow.window = 4;
+  sim.StartFlow(0, kNodes - 1, flow);
+  ASSERT_TRUE(sim.RunUntilFlowsComplete(TimeDelta::FromSeconds(30)));
+  EXPECT_EQ(20u, sim.messages_delivered());
+  EXPECT_GE(sim.LatencyPercentile(0.0), (kNodes - 1) * link.delay);
+}
+
+TEST(MeshSimulator, JitteryRingDelivers) {
+  MeshSimulator sim(16, 1);
+  SimulatedLinkOptions link;
+  link.bandwidth = Bandwidth::FromKilobitsPerSecond(10000);
+  link.delay = TimeDelta::FromMilliseconds(2);
+  link.jitter = TimeDelta::FromMilliseconds(2);
+  BuildRing(&sim, 8, link);
+  ASSERT_TRUE(sim.RunUntilConverged(TimeDelta::FromSeconds(10)).has_value());
+
+  SimulatedFlowOptions flow;
+  flow.messages = 10;
+  flow.message_size = 1000;
+  flow.window = 2;
+  StartRandomFlows(&sim, 8, flow);
+  ASSERT_TRUE(sim.RunUntilFlowsComplete(TimeDelta::FromSeconds(60)));
+  EXPECT_EQ(80u, sim.messages_delivered());
+  EXPECT_EQ(0u, sim.packets_lost());
+}
+
+TEST(MeshSimulator, LossyRingDelivers) {
+  MeshSimulator sim(16, 1);
+  SimulatedLinkOptions link;
+  link.delay = TimeDelta::FromMilliseconds(2);
+  link.loss = 0.01;
+  BuildRing(&sim, 8, link);
+  ASSERT_TRUE(sim.RunUntilConverged(TimeDelta::FromSeconds(10)).has_value());
+
+  SimulatedFlowOptions flow;
+  flow.messages = 10;
+  StartRandomFlows(&sim, 8, flow);
+  ASSERT_TRUE(sim.RunUntilFlowsComplete(TimeDelta::FromSeconds(30)));
+  EXPECT_EQ(80u, sim.messages_delivered());
+  EXPECT_GT(sim.packets_lost(), 0u);
+  EXPECT_LT(sim.packets_lost(), sim.packets_sent());
+
+  CsvWriter csv;
+  sim.Report(&csv);
+  csv.EndRow();
+  std::ostringstream out;
+  csv.Flush(out);
+  EXPECT_EQ(0u, out.str().find("nodes,links,convergence_ms,")) << out.str();
+}
+
+TEST(MeshSimulator, RunsAreDeterministic) {
+  struct Result {
+    Optional<TimeDelta> convergence;
+    uint64_t delivered;
+    TimeDelta p50;
+    TimeDelta p99;
+  };
+  auto run = []() {
+    MeshSimulator sim(12, 42);
+    SimulatedLinkOptions link;
+    link.jitter = TimeDelta::FromMilliseconds(3);
+    link.loss = 0.05;
+    BuildRing(&sim, 6, link);
+    auto convergence = sim.RunUntilConverged(TimeDelta::FromSeconds(10));
+    SimulatedFlowOptions flow;
+    flow.messages = 10;
+    StartRandomFlows(&sim, 6, flow);
+    sim.RunUntilFlowsComplete(TimeDelta::FromSeconds(30));
+    return Result{convergence, sim.messages_delivered(),
+                  sim.LatencyPercentile(0.5), sim.LatencyPercentile(0.99)};
+  };
+  const Result first = run();
+  const Result second = run();
+  EXPECT_EQ(first.convergence, second.convergence);
+  EXPECT_EQ(first.delivered, second.delivered);
+  EXPECT_EQ(first.p50, second.p50);
+  EXPECT_EQ(first.p99, second.p99);
+}
+
+// Enable to run the mesh benchmark suite. It builds rings with random chords
+// of increasing size over clean and lossy links, runs random flows across
+// each, and writes one CSV row per run to stdout.
+#if 0
+TEST(MeshSimulator, Benchmark) {
+  CsvWriter csv;
+  for (size_t nodes : {50, 100, 200, 400}) {
+    for (double loss : {0.0, 0.01, 0.05}) {
+      MeshSimulator sim(nodes, 1);
+      SimulatedLinkOptions link;
+      link.bandwidth = Bandwidth::FromKilobitsPerSecond(10000);
+      link.delay = TimeDelta::FromMilliseconds(2);
+      link.jitter = TimeDelta::FromMilliseconds(1);
+      link.loss = loss;
+      BuildRing(&sim, nodes, link);
+      sim.RunUntilConverged(TimeDelta::FromSeconds(30));
+      SimulatedFlowOptions flow;
+      flow.messages = 50;
+      flow.message_size = 1000;
+      flow.window = 4;
+      StartRandomFlows(&sim, nodes / 2, flow);
+      sim.RunUntilFlowsComplete(TimeDelta::FromSeconds(120));
+      csv.Put("loss", loss);
+      sim.Report(&csv);
+      csv.EndRow();
+    }
+  }
+  csv.Flush(std::cout);
+}
+#endif  // End mesh benchmark.
+
+}  // namespace mesh_simulator_test
+}  // namespace overnet
@@ -0,0 +1,86 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <assert.h>
+#include <atomic>
+#include "manual_constructor.h"
+#include "optional.h"
+
+namespace overnet {
+
+// Unbounded lock-free queue: any number of threads may Push concurrently, but
+// only one thread at a time may Pop.
+// Based on Dmitry Vyukov's intrusive MPSC node-based queue.
+template <class T>
+class MpscQueue {
+ public:
+  MpscQueue() = default;
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+  ~MpscQueue() {
+    while (Pop()) {
+    }
+    assert(head_.load() == &stub_);
+  }
+
+  void Push(T value) {
+    Node* node = new Node;
+    node->value.Init(std::move(value));
+    PushNode(node);
+  }
+
+  // Returns Nothing if the queue is empty... or if a concurrent Push has not
+  // yet finished linking its value in (in which case the pusher is still
+  // running, and a later Pop will return the value).
+  Optional<T> Pop() {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_seq_cst);
+    if (tail == &stub_) {
+      if (next == nullptr)
+        return Nothing;
+      tail_ = tail = next;
+      next = next->next.load(std::memory_order_seq_cst);
+    }
+    if (next == nullptr) {
+      if (tail != head_.load(std::memory_order_acquire))
+        return Nothing;
+      // tail is the last value: put the stub back behind it so that tail can
+      // be unlinked.
+      stub_.next.store(nullptr, std::memory_order_relaxed);
+      PushNode(&stub_);
+      next = tail->next.load(std::memory_order_seq_cst);
+      if (next == nullptr)
+        return Nothing;
+    }
+    tail_ = next;
+    Optional<T> out(std::move(*tail->value));
+    tail->value.Destroy();
+    delete tail;
+    return out;
+  }
+
+ private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    ManualConstructor<T> value;
+  };
+
+  void PushNode(Node* node) {
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    // Pushes and the consumer's check for new work are sequentially
+    // consistent so that wakeup protocols layered on top (see
+    // ShardedRouter::Post) cannot miss a value.
+    prev->next.store(node, std::memory_order_seq_cst);
+  }
+
+  Node stub_;
+  // Most recently pushed node.
+  std::atomic<Node*> head_{&stub_};
+  // Next node to pop (only touched by the consumer).
+  Node* tail_ = &stub_;
+};
+
+}  // namespace overnet
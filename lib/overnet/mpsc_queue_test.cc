@@ -0,0 +1,60 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "mpsc_queue.h"
+#include <memory>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace overnet {
+namespace mpsc_queue_test {
+
+TEST(MpscQueue, Fifo) {
+  MpscQueue<std::unique_ptr<int>> q;
+  EXPECT_FALSE(q.Pop().has_value());
+  q.Push(std::make_unique<int>(1));
+  q.Push(std::make_unique<int>(2));
+  EXPECT_EQ(1, *q.Pop().Take());
+  q.Push(std::make_unique<int>(3));
+  EXPECT_EQ(2, *q.Pop().Take());
+  EXPECT_EQ(3, *q.Pop().Take());
+  EXPECT_FALSE(q.Pop().has_value());
+  q.Push(std::make_unique<int>(4));
+  EXPECT_EQ(4, *q.Pop().Take());
+  // Leave a value behind for the destructor.
+  q.Push(std::make_unique<int>(5));
+}
+
+TEST(MpscQueue, ManyProducers) {
+  static constexpr int kProducers = 4;
+  static constexpr int kValuesPerProducer = 100000;
+  MpscQueue<std::pair<int, int>> q;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&q, p]() {
+      for (int i = 0; i < kValuesPerProducer; i++)
+        q.Push(std::make_pair(p, i));
+    });
+  }
+  // Values from each producer must come out in the order they went in.
+  std::vector<int> next(kProducers, 0);
+  int popped = 0;
+  while (popped < kProducers * kValuesPerProducer) {
+    auto value = q.Pop();
+    if (!value.has_value()) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(next[value->first], value->second);
+    next[value->first]++;
+    popped++;
+  }
+  for (auto& producer : producers)
+    producer.join();
+  EXPECT_FALSE(q.Pop().has_value());
+}
+
+}  // namespace mpsc_queue_test
+}  // namespace overnet
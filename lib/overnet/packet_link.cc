@@ -14,7 +14,7 @@ static uint64_t GenerateLabel() {
 }
 
 PacketLink::PacketLink(Router* router, TraceSink trace_sink, NodeId peer,
-                       uint32_t mss)
+                       uint32_t mss, uint32_t parity_group_size)
     : router_(router),
       timer_(router->timer()),
       trace_sink_(trace_sink.Decorate([this](const std::string& msg) {
@@ -24,13 +24,12 @@ PacketLink::PacketLink(Router* router, TraceSink trace_sink, NodeId peer,
       })),
       peer_(peer),
       label_(GenerateLabel()),
-      protocol_{router_->timer(), this, trace_sink_, mss} {}
+      protocol_{router_->timer(), this, trace_sink_, mss,
+                parity_group_size} {}
 
 void PacketLink::Close(Callback<void> quiesced) {
   stashed_.Reset();
-  while (!outgoing_.empty()) {
-    outgoing_.pop();
-  }
+  outgoing_.Clear();
   if (emitting_) {
     emitting_->timeout.Cancel();
   }
@@ -42,7 +41,7 @@ void PacketLink::Forward(Message message) {
   OVERNET_TRACE(DEBUG, trace_sink_)
       << "Forward sending=" << sending_ << " outgoing=" << outgoing_.size()
       << " imm=" << send_immediately;
-  outgoing_.emplace(std::move(message));
+  outgoing_.Push(std::move(message));
   if (send_immediately) {
     SchedulePacket();
   }
@@ -131,13 +130,13 @@ Slice PacketLink::BuildPacket(LazySliceArgs args) {
     // And ensure there's space with the segment length header.
     auto max_len = varint::MaximumLengthWithPrefix(*max_len_before_prefix);
     // Pull out the message.
-    Message msg = std::move(outgoing_.front());
-    outgoing_.pop();
+    Message msg = outgoing_.Pop();
     // Serialize it.
     auto payload = msg.make_payload(
         LazySliceArgs{0, static_cast<uint32_t>(max_len),
                       args.has_other_content || !send_slices_.empty(),
                       args.delay_until_time});
+    outgoing_.Sent(payload.length());
     OVERNET_TRACE(DEBUG, trace_sink_)
         << "delay -> " << (*args.delay_until_time - timer_->Now());
     // Add the serialized version to the outgoing queue.
@@ -158,16 +157,27 @@ Slice PacketLink::BuildPacket(LazySliceArgs args) {
 }
 
 void PacketLink::SendPacket(SeqNum seq, LazySlice data, Callback<void> done) {
+  SendPacketWithOp(PacketOp::Packet, seq, std::move(data), std::move(done));
+}
+
+void PacketLink::SendParityPacket(SeqNum seq, LazySlice data,
+                                  Callback<void> done) {
+  SendPacketWithOp(PacketOp::Parity, seq, std::move(data), std::move(done));
+}
+
+void PacketLink::SendPacketWithOp(PacketOp op, SeqNum seq, LazySlice data,
+                                  Callback<void> done) {
   assert(!emitting_);
   const auto prefix_length = 1 + seq.wire_length();
   const TimeStamp now = timer_->Now();
   TimeStamp send_time = now;
   auto data_slice = data(LazySliceArgs{
       prefix_length, protocol_.mss() - prefix_length, false, &send_time});
-  auto send_slice = data_slice.WithPrefix(prefix_length, [seq](uint8_t* p) {
-    *p++ = 0;
-    seq.Write(p);
-  });
+  auto send_slice =
+      data_slice.WithPrefix(prefix_length, [op, seq](uint8_t* p) {
+        *p++ = static_cast<uint8_t>(op);
+        seq.Write(p);
+      });
   OVERNET_TRACE(DEBUG, trace_sink_)
       << "StartEmit " << send_slice << " delay=" << (send_time - now);
   emitting_.Reset(timer_, send_time, std::move(send_slice), std::move(done),
@@ -191,9 +201,10 @@ void PacketLink::Process(TimeStamp received, Slice packet) {
     OVERNET_TRACE(WARNING, trace_sink_) << "Short packet received (no op code)";
     return;
   }
-  if (*p != 0) {
+  const auto op = static_cast<PacketOp>(*p);
+  if (op != PacketOp::Packet && op != PacketOp::Parity) {
     OVERNET_TRACE(WARNING, trace_sink_)
-        << "Non-zero op-code received in PacketLink";
+        << "Unknown op-code received in PacketLink";
     return;
   }
   ++p;
@@ -211,7 +222,10 @@ void PacketLink::Process(TimeStamp received, Slice packet) {
   packet.TrimBegin(p - begin);
   // begin, p, end are no longer valid.
   auto packet_status =
-      protocol_.Process(received, *seq_status.get(), std::move(packet));
+      op == PacketOp::Parity
+          ? protocol_.ProcessParity(received, *seq_status.get(),
+                                    std::move(packet))
+          : protocol_.Process(received, *seq_status.get(), std::move(packet));
   if (packet_status.status.is_error()) {
     OVERNET_TRACE(WARNING, trace_sink_)
         << "Packet header parse failure: " << packet_status.status.AsStatus();
@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <queue>
+#include "egress_queue.h"
 #include "packet_protocol.h"
 #include "router.h"
 #include "trace.h"
@@ -13,7 +13,10 @@ namespace overnet {
 
 class PacketLink : public Link, private PacketProtocol::PacketSender {
  public:
-  PacketLink(Router* router, TraceSink trace_sink, NodeId peer, uint32_t mss);
+  // |parity_group_size| enables forward error correction on packets sent
+  // over this link (see PacketProtocol).
+  PacketLink(Router* router, TraceSink trace_sink, NodeId peer, uint32_t mss,
+             uint32_t parity_group_size = 0);
   void Close(Callback<void> quiesced) override final;
   void Forward(Message message) override final;
   void Process(TimeStamp received, Slice packet);
@@ -21,9 +24,18 @@ class PacketLink : public Link, private PacketProtocol::PacketSender {
   LinkMetrics GetLinkMetrics() override final;
 
  private:
+  enum class PacketOp : uint8_t {
+    Packet = 0,
+    Parity = 1,
+  };
+
   void SchedulePacket();
   void SendPacket(SeqNum seq, LazySlice data,
                   Callback<void> done) override final;
+  void SendParityPacket(SeqNum seq, LazySlice data,
+                        Callback<void> done) override final;
+  void SendPacketWithOp(PacketOp op, SeqNum seq, LazySlice data,
+                        Callback<void> done);
   Status ProcessBody(TimeStamp received, Slice packet);
   Slice BuildPacket(LazySliceArgs args);
 
@@ -52,7 +64,7 @@ class PacketLink : public Link, private PacketProtocol::PacketSender {
   };
   Optional<Emitting> emitting_;
 
-  std::queue<Message> outgoing_;
+  EgressQueue outgoing_;
 };
 
 }  // namespace overnet
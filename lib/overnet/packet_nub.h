@@ -5,6 +5,7 @@
 #pragma once
 
 #include <random>
+#include <vector>
 #include "node_id.h"
 #include "packet_link.h"
 #include "slice.h"
@@ -29,10 +30,55 @@ class PacketNub {
         })),
         local_node_(node) {}
 
+  struct Datagram {
+    Address address;
+    Slice slice;
+  };
+
   virtual void SendTo(Address dest, Slice slice) = 0;
   virtual Router* GetRouter() = 0;
   virtual void Publish(LinkPtr<> link) = 0;
 
+  // Sends several packets at once. Transports that can hand many datagrams to
+  // the system in one call (eg. sendmmsg) should override this.
+  virtual void SendBatch(std::vector<Datagram>* packets) {
+    for (auto& packet : *packets) {
+      SendTo(packet.address, std::move(packet.slice));
+    }
+  }
+
+  // While batching, outgoing packets are held (from every link on this nub)
+  // until FlushBatch() passes them to SendBatch() together. Transports
+  // typically flush once per turn of their event loop.
+  void set_batching(bool batching) {
+    batching_ = batching;
+    if (!batching_) {
+      FlushBatch();
+    }
+  }
+  bool batching() const { return batching_; }
+
+  void FlushBatch() {
+    if (pending_sends_.empty())
+      return;
+    // SendBatch may cause more packets to be queued: start a new batch for
+    // them.
+    std::vector<Datagram> packets;
+    packets.swap(pending_sends_);
+    SendBatch(&packets);
+    if (pending_sends_.empty()) {
+      packets.clear();
+      pending_sends_.swap(packets);
+    }
+  }
+
+  // Processes packets received together, with a single receive time.
+  void ProcessBatch(TimeStamp received, std::vector<Datagram>* packets) {
+    for (auto& packet : *packets) {
+      Process(received, packet.address, std::move(packet.slice));
+    }
+  }
+
   void Process(TimeStamp received, Address src, Slice slice) {
     // Extract node id and op from slice... this code must be identical with
     // PacketLink.
@@ -68,7 +114,7 @@ class PacketNub {
           if (p == end && link->node_id && *link->node_id < local_node_) {
             // Empty connected packets get reflected to fully advance state
             // machine in the case of connecting when applications are idle.
-            SendTo(src, std::move(slice));
+            Send(src, std::move(slice));
           } else {
             link->link->Process(received, std::move(slice));
           }
@@ -174,7 +220,7 @@ class PacketNub {
       nub_->links_.erase(it);
     }
 
-    void Emit(Slice packet) { nub_->SendTo(address_, std::move(packet)); }
+    void Emit(Slice packet) { nub_->Send(address_, std::move(packet)); }
 
    private:
     PacketNub* const nub_;
@@ -272,6 +318,14 @@ class PacketNub {
                initial_millis, millis)(rng_));
   }
 
+  void Send(Address address, Slice slice) {
+    if (batching_) {
+      pending_sends_.emplace_back(Datagram{address, std::move(slice)});
+    } else {
+      SendTo(address, std::move(slice));
+    }
+  }
+
   Link* link_for(Address address) {
     auto it = links_.find(address);
     if (it != links_.end())
@@ -294,7 +348,7 @@ class PacketNub {
       return;
     }
     const int ticks = *ticks_or_nothing;
-    SendTo(address, Slice::WithInitializer(packet_size, packet_writer));
+    Send(address, Slice::WithInitializer(packet_size, packet_writer));
     link->next_timeout.Reset(
         timer_, BackoffForTicks(kAnnounceResendMillis, ticks),
         StatusCallback(ALLOCATED_CALLBACK, [=](const Status& status) {
@@ -347,6 +401,8 @@ class PacketNub {
   const NodeId local_node_;
   std::unordered_map<Address, Link, HashAddress, EqAddress> links_;
   std::mt19937_64 rng_;
+  bool batching_ = false;
+  std::vector<Datagram> pending_sends_;
 };
 
 }  // namespace overnet
@@ -68,6 +68,30 @@ TEST(PacketNub, InitiateBiggerNodeId) {
   }
 }
 
+TEST(PacketNub, BatchedSendsWaitForFlush) {
+  TestTimer timer;
+  StrictMock<MockPacketNub> nub(&timer, NodeId(1));
+  nub.set_batching(true);
+
+  const auto kHello =
+      Slice::WithInitializer(MockPacketNub::kHelloSize, [](uint8_t* p) {
+        memset(p, 0, MockPacketNub::kHelloSize);
+        static const uint8_t prefix[] = {2, 1, 0, 0, 0, 0, 0, 0, 0};
+        memcpy(p, prefix, sizeof(prefix));
+      });
+  nub.Initiate(123, NodeId(2));
+  nub.Initiate(456, NodeId(3));
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&nub));
+
+  EXPECT_CALL(nub, SendTo(123, kHello));
+  EXPECT_CALL(nub, SendTo(456, kHello));
+  nub.FlushBatch();
+  EXPECT_TRUE(Mock::VerifyAndClearExpectations(&nub));
+
+  // Nothing left to send.
+  nub.FlushBatch();
+}
+
 TEST(PacketNub, InitiateSmallerNodeId) {
   TestTimer timer;
   StrictMock<MockPacketNub> nub(&timer, NodeId(2));
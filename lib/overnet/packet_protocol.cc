@@ -10,6 +10,7 @@ namespace overnet {
 static const char kClosing[] = "Closing";
 static const char kMaybeScheduleAck[] = "MaybeScheduleAck";
 static const char kMaybeSendAck[] = "MaybeSendAck";
+static const char kParityFlush[] = "ParityFlush";
 static const char kRequestSendAck[] = "RequestSendAck";
 static const char kRequestTransmit[] = "RequestTransmit";
 static const char kScheduleRTO[] = "ScheduleRTO";
@@ -28,6 +29,7 @@ void PacketProtocol::Close(Callback<void> quiesced) {
   // Stop waiting for things.
   rto_scheduler_.Reset();
   ack_scheduler_.Reset();
+  parity_flush_.Reset();
   outgoing_bbr_.CancelRequestTransmit();
   NackAll();
   decltype(queued_) queued;
@@ -89,18 +91,32 @@ void PacketProtocol::TransmitPacket() {
   if (outstanding_.empty()) {
     KeepAlive();
   }
+  // Once this packet is acked, the peer knows everything its ack frame
+  // covered: that may stop short of max_seen_ while waiting on parity.
   outstanding_.emplace_back(
-      OutstandingPacket{max_seen_, Nothing, std::move(sending_->on_ack)});
+      OutstandingPacket{AckToSeq(), Nothing, std::move(sending_->on_ack)});
+  const uint64_t parity_first_seq = sending_->parity_first_seq;
   auto send_fn = std::move(sending_->payload_factory);
-  send_fn.AddMutator([seq_idx, self = OutstandingOp<kTransmitPacket>(this)](
+  send_fn.AddMutator([seq_idx, parity_first_seq,
+                      self = OutstandingOp<kTransmitPacket>(this)](
                          auto payload, LazySliceArgs args) {
     OVERNET_TRACE(DEBUG, self->trace_sink_) << "GeneratePacket seq=" << seq_idx;
     const auto outstanding_idx = seq_idx - self->send_tip_;
-    if (outstanding_idx >= self->outstanding_.size())
+    if (outstanding_idx >= self->outstanding_.size() ||
+        self->outstanding_[outstanding_idx].on_ack.empty()) {
+      // Nacked (or closed) before it was sent: BBR never saw it go out.
+      self->outgoing_bbr_.AbandonTransmit();
       return Slice();
-    if (self->outstanding_[outstanding_idx].on_ack.empty())
-      return Slice();
-    auto slice = self->GeneratePacket(std::move(payload), args);
+    }
+    auto slice = parity_first_seq != 0
+                     ? self->GenerateParityPacket(seq_idx - parity_first_seq,
+                                                  std::move(payload), args)
+                     : self->GeneratePacket(seq_idx, std::move(payload), args);
+    if (slice.length() == 0) {
+      // Parity that no longer fits: the peer will nack it.
+      self->outgoing_bbr_.AbandonTransmit();
+      return slice;
+    }
     assert(!self->outstanding_[outstanding_idx].bbr_sent_packet.has_value());
     self->outstanding_[outstanding_idx].bbr_sent_packet =
         self->outgoing_bbr_.ScheduleTransmit(
@@ -108,14 +124,26 @@ void PacketProtocol::TransmitPacket() {
             BBR::OutgoingPacket{seq_idx, slice.length()});
     return slice;
   });
-  packet_sender_->SendPacket(seq_num, std::move(send_fn),
-                             [self = OutstandingOp<kStartNext>(this)]() {
-                               self->sending_.Reset();
-                               self->ContinueSending();
-                             });
+  Callback<void> done = [self = OutstandingOp<kStartNext>(this)]() {
+    self->sending_.Reset();
+    self->ContinueSending();
+  };
+  if (parity_first_seq != 0) {
+    packet_sender_->SendParityPacket(seq_num, std::move(send_fn),
+                                     std::move(done));
+  } else {
+    packet_sender_->SendPacket(seq_num, std::move(send_fn), std::move(done));
+  }
 }
 
-Slice PacketProtocol::GeneratePacket(LazySlice payload, LazySliceArgs args) {
+Slice PacketProtocol::GeneratePacket(uint64_t seq_idx, LazySlice payload,
+                                     LazySliceArgs args) {
+  if (parity_group_size_ != 0) {
+    assert(args.max_length > kMaxParityHeaderLength);
+    args.max_length -= kMaxParityHeaderLength;
+  }
+  Slice packet;
+  bool has_payload;
   auto ack = GenerateAck();
   if (ack) {
     AckFrame::Writer ack_writer(ack.get());
@@ -125,7 +153,8 @@ Slice PacketProtocol::GeneratePacket(LazySlice payload, LazySliceArgs args) {
     auto payload_slice = payload(LazySliceArgs{
         args.desired_prefix + prefix_length, args.max_length - prefix_length,
         true, args.delay_until_time});
-    return payload_slice.WithPrefix(
+    has_payload = payload_slice.length() != 0;
+    packet = payload_slice.WithPrefix(
         prefix_length, [&ack_writer, ack_length_length](uint8_t* p) {
           ack_writer.Write(
               varint::Write(ack_writer.wire_length(), ack_length_length, p));
@@ -134,8 +163,116 @@ Slice PacketProtocol::GeneratePacket(LazySlice payload, LazySliceArgs args) {
     auto payload_slice =
         payload(LazySliceArgs{args.desired_prefix + 1, args.max_length - 1,
                               args.has_other_content, args.delay_until_time});
-    return payload_slice.WithPrefix(1, [](uint8_t* p) { *p = 0; });
+    has_payload = payload_slice.length() != 0;
+    packet = payload_slice.WithPrefix(1, [](uint8_t* p) { *p = 0; });
+  }
+  // Pure acks join a group to keep it contiguous, but never start one: that
+  // would have acks of parity packets generating more parity.
+  if (parity_group_size_ != 0 && (has_payload || parity_group_.count != 0)) {
+    AddToParityGroup(seq_idx, packet);
+  }
+  return packet;
+}
+
+// Parity packets are laid out as:
+//   offset back to the first packet covered (varint)
+//   number of packets covered (varint)
+//   XOR of the covered packets' lengths (varint)
+//   XOR of the covered packets, each padded with zeros to the longest
+// The offset is only known once the parity packet is sequenced, so it's
+// added here; the rest is built by QueueParity.
+Slice PacketProtocol::GenerateParityPacket(uint64_t offset, LazySlice payload,
+                                           LazySliceArgs args) {
+  const uint8_t offset_length = varint::WireSizeFor(offset);
+  if (offset_length >= args.max_length) {
+    return Slice();
+  }
+  auto body = payload(LazySliceArgs{args.desired_prefix + offset_length,
+                                    args.max_length - offset_length, false,
+                                    args.delay_until_time});
+  if (body.length() + offset_length > args.max_length) {
+    return Slice();
+  }
+  return body.WithPrefix(offset_length, [offset, offset_length](uint8_t* p) {
+    varint::Write(offset, offset_length, p);
+  });
+}
+
+void PacketProtocol::AddToParityGroup(uint64_t seq_idx, const Slice& packet) {
+  ParityGroup& group = parity_group_;
+  if (group.count == parity_group_size_ ||
+      (group.count != 0 && seq_idx != group.first_seq + group.count)) {
+    // Only runs of consecutive packets can be covered. The parity queued here
+    // will be sequenced after this packet, so leave this packet out rather
+    // than start a group that the parity would break up again.
+    QueueParity();
+    return;
+  }
+  if (group.count == 0) {
+    group.first_seq = seq_idx;
+    group.xor_length = 0;
+    group.xor_bytes.clear();
+    ScheduleParityFlush();
+  }
+  if (packet.length() > group.xor_bytes.size()) {
+    group.xor_bytes.resize(packet.length(), 0);
+  }
+  const uint8_t* p = packet.begin();
+  for (size_t i = 0; i < packet.length(); i++) {
+    group.xor_bytes[i] ^= p[i];
+  }
+  group.xor_length ^= packet.length();
+  group.count++;
+  // Full groups are queued by ContinueSending, once this packet is sent.
+}
+
+void PacketProtocol::ScheduleParityFlush() {
+  if (state_ != State::READY) {
+    return;
   }
+  // Sends parity for a group that stops growing, so that losses at the tail
+  // of a burst are covered too.
+  parity_flush_.Reset(
+      timer_, timer_->Now() + QuarterRTT() / 2,
+      [self = OutstandingOp<kParityFlush>(this)](const Status& status) {
+        if (status.is_error())
+          return;
+        self->parity_flush_.Reset();
+        self->QueueParity();
+        self->ContinueSending();
+      });
+}
+
+// Queues parity for the current group ahead of anything else waiting, so that
+// it closely follows the packets it covers.
+void PacketProtocol::QueueParity() {
+  ParityGroup& group = parity_group_;
+  if (parity_flush_.has_value()) {
+    parity_flush_->Cancel();
+    parity_flush_.Reset();
+  }
+  if (group.count == 0) {
+    return;
+  }
+  const uint32_t count = group.count;
+  group.count = 0;
+  if (state_ != State::READY) {
+    return;
+  }
+  OVERNET_TRACE(DEBUG, trace_sink_)
+      << "QueueParity first_seq=" << group.first_seq << " count=" << count;
+  const uint8_t count_length = varint::WireSizeFor(count);
+  const uint8_t length_length = varint::WireSizeFor(group.xor_length);
+  Slice body = Slice::WithInitializer(
+      count_length + length_length + group.xor_bytes.size(),
+      [&group, count, count_length, length_length](uint8_t* p) {
+        p = varint::Write(count, count_length, p);
+        p = varint::Write(group.xor_length, length_length, p);
+        memcpy(p, group.xor_bytes.data(), group.xor_bytes.size());
+      });
+  queued_.emplace_front(QueuedPacket{[body](auto) { return body; },
+                                     SendCallback::Ignored(),
+                                     group.first_seq});
 }
 
 Status PacketProtocol::HandleAck(const AckFrame& ack) {
@@ -212,6 +349,9 @@ Status PacketProtocol::HandleAck(const AckFrame& ack) {
 }
 
 void PacketProtocol::ContinueSending() {
+  if (parity_group_size_ != 0 && parity_group_.count == parity_group_size_) {
+    QueueParity();
+  }
   while (!queued_.empty() && !sending_ && state_ == State::READY) {
     QueuedPacket p = std::move(queued_.front());
     queued_.pop_front();
@@ -228,14 +368,20 @@ PacketProtocol::ProcessedPacket PacketProtocol::Process(TimeStamp received,
                                                         Slice slice) {
   OVERNET_TRACE(DEBUG, trace_sink_) << "Process: " << slice;
 
-  using StatusType = StatusOr<Optional<Slice>>;
-  OutstandingOp<kProcessedPacket> op(this);
-
-  // Validate sequence number, ignore if it's old.
   const auto seq_idx = seq_num.Reconstruct(recv_tip_);
   OVERNET_TRACE(DEBUG, trace_sink_)
       << "Receive sequence " << seq_num << "=" << seq_idx << " recv_tip "
       << recv_tip_ << " max_seen=" << max_seen_;
+  return ProcessPacket(OutstandingOp<kProcessedPacket>(this), received,
+                       seq_idx, std::move(slice));
+}
+
+PacketProtocol::ProcessedPacket PacketProtocol::ProcessPacket(
+    OutstandingOp<kProcessedPacket> op, TimeStamp received, uint64_t seq_idx,
+    Slice slice) {
+  using StatusType = StatusOr<Optional<Slice>>;
+
+  // Validate sequence number, ignore if it's old.
   if (seq_idx < recv_tip_) {
     return ProcessedPacket(op, ProcessedPacket::Ack::NONE, Nothing);
   }
@@ -256,6 +402,12 @@ PacketProtocol::ProcessedPacket PacketProtocol::Process(TimeStamp received,
     return ProcessedPacket(op, ProcessedPacket::Ack::NONE, Nothing);
   }
 
+  // The whole packet is needed to repair others in its parity group.
+  Slice body;
+  if (parity_received_) {
+    body = slice;
+  }
+
   uint64_t ack_length;
   if (!varint::Read(&p, end, &ack_length)) {
     return ProcessedPacket(
@@ -279,7 +431,8 @@ PacketProtocol::ProcessedPacket PacketProtocol::Process(TimeStamp received,
   auto it = received_packets_.lower_bound(seq_idx);
   if (it == received_packets_.end() || it->first != seq_idx) {
     it = received_packets_.insert(
-        it, std::make_pair(seq_idx, ReceivedPacket{true, false}));
+        it, std::make_pair(seq_idx, ReceivedPacket{true, false, received,
+                                                   std::move(body)}));
   } else {
     OVERNET_TRACE(DEBUG, trace_sink_)
         << "frozen as " << (it->second.received ? "received" : "nack");
@@ -331,15 +484,133 @@ PacketProtocol::ProcessedPacket PacketProtocol::Process(TimeStamp received,
       AckFrame::Parse(slice.TakeUntilOffset(ack_length))
           .Then([this](const AckFrame& frame) { return HandleAck(frame); })
           .Then([&slice]() -> StatusType { return slice; }));
-}  // namespace overnet
+}
+
+PacketProtocol::ProcessedPacket PacketProtocol::ProcessParity(
+    TimeStamp received, SeqNum seq_num, Slice slice) {
+  OVERNET_TRACE(DEBUG, trace_sink_) << "ProcessParity: " << slice;
+
+  using StatusType = StatusOr<Optional<Slice>>;
+  OutstandingOp<kProcessedPacket> op(this);
+
+  const auto seq_idx = seq_num.Reconstruct(recv_tip_);
+  if (seq_idx < recv_tip_) {
+    return ProcessedPacket(op, ProcessedPacket::Ack::NONE, Nothing);
+  }
+
+  const uint8_t* p = slice.begin();
+  const uint8_t* end = slice.end();
+  uint64_t offset;
+  uint64_t count;
+  uint64_t xor_length;
+  if (!varint::Read(&p, end, &offset) || !varint::Read(&p, end, &count) ||
+      !varint::Read(&p, end, &xor_length)) {
+    return ProcessedPacket(
+        op, ProcessedPacket::Ack::NONE,
+        StatusType(StatusCode::INVALID_ARGUMENT,
+                   "Failed to parse parity header"));
+  }
+  if (offset > seq_idx || count == 0 || count > offset) {
+    return ProcessedPacket(op, ProcessedPacket::Ack::NONE,
+                           StatusType(StatusCode::INVALID_ARGUMENT,
+                                      "Invalid parity header"));
+  }
+  slice.TrimBegin(p - slice.begin());
+
+  auto it = received_packets_.lower_bound(seq_idx);
+  if (it != received_packets_.end() && it->first == seq_idx) {
+    return ProcessedPacket(op, ProcessedPacket::Ack::NONE, Nothing);
+  }
+  received_packets_.insert(
+      it, std::make_pair(seq_idx,
+                         ReceivedPacket{true, false, received, Slice()}));
+  if (seq_idx > max_seen_) {
+    max_seen_ = seq_idx;
+    max_seen_time_ = received;
+  }
+  KeepAlive();
 
-bool PacketProtocol::AckIsNeeded() const { return max_seen_ > recv_tip_; }
+  const uint64_t first_seq = seq_idx - offset;
+  const uint64_t last_seq = first_seq + count - 1;
+  parity_received_ = true;
+  parity_span_ = std::max(parity_span_, offset);
+  parity_resolved_to_ = std::max(parity_resolved_to_, last_seq);
+
+  // Parity can restore one missing packet, given all of the others.
+  Optional<uint64_t> missing;
+  uint64_t length = xor_length;
+  for (uint64_t seq = first_seq; seq <= last_seq; seq++) {
+    auto pkt = received_packets_.find(seq);
+    if (pkt == received_packets_.end() && !missing && seq >= recv_tip_) {
+      missing = seq;
+    } else if (pkt == received_packets_.end() || !pkt->second.received ||
+               pkt->second.body.length() == 0) {
+      // Two losses, one already nacked, or one received before we started
+      // keeping packets: nothing to repair.
+      OVERNET_TRACE(DEBUG, trace_sink_)
+          << "Parity for " << first_seq << ".." << last_seq
+          << " cannot repair " << seq;
+      return ProcessedPacket(op, ProcessedPacket::Ack::SCHEDULE, Nothing);
+    } else {
+      length ^= pkt->second.body.length();
+    }
+  }
+  if (!missing) {
+    return ProcessedPacket(op, ProcessedPacket::Ack::SCHEDULE, Nothing);
+  }
+  if (length == 0 || length > slice.length()) {
+    return ProcessedPacket(op, ProcessedPacket::Ack::NONE,
+                           StatusType(StatusCode::INVALID_ARGUMENT,
+                                      "Parity does not match its group"));
+  }
+
+  Slice repaired = Slice::WithInitializer(
+      length, [this, &slice, first_seq, last_seq, length](uint8_t* out) {
+        memcpy(out, slice.begin(), length);
+        for (auto pkt = received_packets_.lower_bound(first_seq);
+             pkt != received_packets_.end() && pkt->first <= last_seq;
+             ++pkt) {
+          const Slice& body = pkt->second.body;
+          const uint8_t* in = body.begin();
+          for (size_t i = 0, n = std::min<size_t>(length, body.length());
+               i < n; i++) {
+            out[i] ^= in[i];
+          }
+        }
+      });
+  OVERNET_TRACE(DEBUG, trace_sink_) << "Parity repaired " << *missing;
+  return ProcessPacket(op, received, *missing, std::move(repaired));
+}
+
+bool PacketProtocol::AckIsNeeded() const { return AckToSeq() > recv_tip_; }
+
+uint64_t PacketProtocol::AckToSeq() const {
+  // Acking past a lost packet would nack it. If parity may yet repair it,
+  // stop short of it for a while: until the packets that could carry its
+  // parity have gone by, or a quarter RTT after the last packet arrived.
+  if (!parity_received_ || timer_->Now() >= max_seen_time_ + QuarterRTT()) {
+    return max_seen_;
+  }
+  uint64_t seq = std::max(recv_tip_, parity_resolved_to_) + 1;
+  if (max_seen_ > 2 * parity_span_) {
+    seq = std::max(seq, max_seen_ - 2 * parity_span_);
+  }
+  for (auto it = received_packets_.lower_bound(seq);
+       seq < max_seen_ && it != received_packets_.end() && it->first == seq;
+       ++it, ++seq) {
+  }
+  return seq < max_seen_ ? seq - 1 : max_seen_;
+}
 
 Optional<AckFrame> PacketProtocol::GenerateAck() {
   OVERNET_TRACE(DEBUG, trace_sink_)
       << "GenerateAck: max_seen=" << max_seen_ << " recv_tip=" << recv_tip_
       << " n=" << (max_seen_ - recv_tip_);
   if (!AckIsNeeded()) {
+    if (max_seen_ > recv_tip_) {
+      // Waiting on parity.
+      MaybeScheduleAck();
+    }
     return Nothing;
   }
   if (last_ack_send_ + QuarterRTT() > timer_->Now()) {
@@ -349,13 +620,27 @@ Optional<AckFrame> PacketProtocol::GenerateAck() {
   const auto now = timer_->Now();
   last_ack_send_ = now;
   assert(max_seen_time_ <= now);
-  AckFrame ack(max_seen_, (now - max_seen_time_).as_us());
-  if (max_seen_ >= 1) {
-    for (uint64_t seq = max_seen_ - 1; seq > recv_tip_; seq--) {
+  const uint64_t ack_to_seq = AckToSeq();
+  TimeStamp ack_to_time = max_seen_time_;
+  if (ack_to_seq != max_seen_) {
+    auto it = received_packets_.find(ack_to_seq);
+    ack_to_time = it != received_packets_.end() && it->second.received
+                      ? it->second.received_time
+                      : now;
+  }
+  AckFrame ack(ack_to_seq, (now - ack_to_time).as_us());
+  if (ack_to_seq >= 1) {
+    // max_seen_ was received, but acks held back for parity may stop at a
+    // packet that was not.
+    const uint64_t first_nack =
+        ack_to_seq == max_seen_ ? ack_to_seq - 1 : ack_to_seq;
+    for (uint64_t seq = first_nack; seq > recv_tip_; seq--) {
       auto it = received_packets_.lower_bound(seq);
       if (it == received_packets_.end() || it->first != seq) {
         received_packets_.insert(
-            it, std::make_pair(seq, ReceivedPacket{false, false}));
+            it, std::make_pair(seq, ReceivedPacket{false, false,
+                                                   TimeStamp::Epoch(),
+                                                   Slice()}));
         ack.AddNack(seq);
       } else if (!it->second.received) {
         ack.AddNack(seq);
@@ -414,6 +699,9 @@ void PacketProtocol::MaybeSendAck() {
              }
            });
     }
+  } else if (max_seen_ > recv_tip_) {
+    // Waiting on parity.
+    MaybeScheduleAck();
   }
 }
 
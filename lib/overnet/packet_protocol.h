@@ -6,6 +6,7 @@
 
 #include <deque>
 #include <map>
+#include <vector>
 #include "ack_frame.h"
 #include "bbr.h"
 #include "callback.h"
@@ -30,12 +31,25 @@ class PacketProtocol {
    public:
     virtual void SendPacket(SeqNum seq, LazySlice data,
                             Callback<void> done) = 0;
+    // Parity packets must be handed to the peer's ProcessParity rather than
+    // Process. Only used if parity is enabled (see the constructor), and
+    // |data| must be generated before |done| is called.
+    virtual void SendParityPacket(SeqNum seq, LazySlice data,
+                                  Callback<void> done) = 0;
   };
 
   static constexpr size_t kMaxUnackedReceives = 3;
-
+  // Parity groups are limited so that their size fits one varint byte.
+  static constexpr uint32_t kMaxParityGroupSize = 127;
+
+  // If |parity_group_size| is non-zero, a parity packet (the XOR of the
+  // group's packets) follows every |parity_group_size| packets sent, so that
+  // the peer can repair any one loss per group without waiting for a
+  // retransmission. Receivers need no configuration: they start holding
+  // back nacks for repairable losses once they have seen a parity packet.
   PacketProtocol(Timer* timer, PacketSender* packet_sender,
-                 TraceSink trace_sink, uint64_t mss)
+                 TraceSink trace_sink, uint64_t mss,
+                 uint32_t parity_group_size = 0)
       : timer_(timer),
         packet_sender_(packet_sender),
         trace_sink_(trace_sink.Decorate([this](const std::string& msg) {
@@ -44,7 +58,10 @@ class PacketProtocol {
           return out.str();
         })),
         mss_(mss),
-        outgoing_bbr_(timer_, trace_sink_, mss_, Nothing) {}
+        parity_group_size_(parity_group_size),
+        outgoing_bbr_(timer_, trace_sink_, mss_, Nothing) {
+    assert(parity_group_size_ <= kMaxParityGroupSize);
+  }
 
   void Close(Callback<void> quiesced);
 
@@ -129,6 +146,9 @@ class PacketProtocol {
   };
 
   ProcessedPacket Process(TimeStamp received, SeqNum seq, Slice slice);
+  // Processes a packet sent with SendParityPacket. If it repairs a lost
+  // packet, returns that packet's payload.
+  ProcessedPacket ProcessParity(TimeStamp received, SeqNum seq, Slice slice);
 
  private:
   struct OutstandingPacket {
@@ -140,8 +160,23 @@ class PacketProtocol {
   struct QueuedPacket {
     LazySlice payload_factory;
     SendCallback on_ack;
+    // Non-zero for parity packets: the first sequence number they cover.
+    uint64_t parity_first_seq = 0;
+  };
+
+  // XOR of a run of consecutively sequenced packets.
+  struct ParityGroup {
+    uint64_t first_seq = 0;
+    uint32_t count = 0;
+    uint64_t xor_length = 0;
+    std::vector<uint8_t> xor_bytes;
   };
 
+  // Room left in each packet for the header of a parity packet covering it:
+  // the varint offset back to the group (up to 10 bytes), count (1 byte),
+  // and length (up to 5 bytes).
+  static constexpr uint32_t kMaxParityHeaderLength = 16;
+
   bool AckIsNeeded() const;
   TimeDelta QuarterRTT() const;
   void MaybeForceAck();
@@ -150,6 +185,12 @@ class PacketProtocol {
   void MaybeSendSlice(QueuedPacket&& packet);
   void SendSlice(QueuedPacket&& packet);
   void TransmitPacket();
+  ProcessedPacket ProcessPacket(OutstandingOp<kProcessedPacket> op,
+                                TimeStamp received, uint64_t seq_idx,
+                                Slice slice);
+  void AddToParityGroup(uint64_t seq_idx, const Slice& packet);
+  void QueueParity();
+  void ScheduleParityFlush();
   Status HandleAck(const AckFrame& ack);
   void ContinueSending();
   void KeepAlive();
@@ -173,13 +214,18 @@ class PacketProtocol {
     }
   }
 
+  uint64_t AckToSeq() const;
   Optional<AckFrame> GenerateAck();
-  Slice GeneratePacket(LazySlice payload, LazySliceArgs args);
+  Slice GeneratePacket(uint64_t seq_idx, LazySlice payload,
+                       LazySliceArgs args);
+  Slice GenerateParityPacket(uint64_t offset, LazySlice payload,
+                             LazySliceArgs args);
 
   Timer* const timer_;
   PacketSender* const packet_sender_;
   const TraceSink trace_sink_;
   const uint64_t mss_;
+  const uint32_t parity_group_size_;
 
   enum class State { READY, CLOSING, CLOSED };
 
@@ -194,6 +240,7 @@ class PacketProtocol {
   std::deque<OutstandingPacket> outstanding_;
   std::deque<QueuedPacket> queued_;
   Optional<QueuedPacket> sending_;
+  ParityGroup parity_group_;
 
   uint64_t recv_tip_ = 0;
   uint64_t max_seen_ = 0;
@@ -205,9 +252,20 @@ class PacketProtocol {
   struct ReceivedPacket {
     bool received;
     bool suppressed_ack;
+    TimeStamp received_time = TimeStamp::Epoch();
+    // Kept once the peer sends parity, for repairing the rest of the group.
+    Slice body;
   };
   std::map<uint64_t, ReceivedPacket> received_packets_;
 
+  // Set once the peer has sent a parity packet.
+  bool parity_received_ = false;
+  // Largest distance seen from a parity packet back to its group.
+  uint64_t parity_span_ = 0;
+  // Last sequence number covered by a parity packet seen so far: losses at
+  // or before it cannot be repaired anymore.
+  uint64_t parity_resolved_to_ = 0;
+
   TimeStamp last_keepalive_event_ = TimeStamp::Epoch();
   TimeStamp last_ack_send_ = TimeStamp::Epoch();
   bool ack_after_sending_ = false;
@@ -216,6 +274,7 @@ class PacketProtocol {
 
   Optional<Timeout> ack_scheduler_;
   Optional<Timeout> rto_scheduler_;
+  Optional<Timeout> parity_flush_;
 };
 
 }  // namespace overnet
@@ -68,6 +68,11 @@ class PacketProtocolFuzzer {
       pending_sends_.emplace(next_send_id_++,
                              PendingSend{seq, std::move(data)});
     }
+    void SendParityPacket(SeqNum seq, LazySlice data,
+                          Callback<void> done) override {
+      // The fuzzer's protocols are created without parity.
+      assert(false);
+    }
 
     struct PendingSend {
       SeqNum seq;
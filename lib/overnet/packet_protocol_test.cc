@@ -3,7 +3,12 @@
 // found in the LICENSE file.
 
 #include "packet_protocol.h"
+#include <cinttypes>
+#include <cstdio>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <random>
 #include "closed_ptr.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -37,6 +42,11 @@ class MockPacketSender : public PacketProtocol::PacketSender {
     EXPECT_GE(when, now);
   }
 
+  void SendParityPacket(SeqNum seq, LazySlice slice,
+                        Callback<void> done) override {
+    ADD_FAILURE() << "Parity sent without being enabled";
+  }
+
   MOCK_METHOD1(SendCallback, void(const Status&));
 
   PacketProtocol::SendCallback NewSendCallback() {
@@ -88,6 +98,290 @@ TEST(PacketProtocol, SendOnePacket) {
       Pointee(Slice()));
 }
 
+// Holds each packet until SendNext() is called, like a link whose outgoing
+// queue is backed up.
+class QueueingPacketSender : public PacketProtocol::PacketSender {
+ public:
+  explicit QueueingPacketSender(Timer* timer) : timer_(timer) {}
+
+  void SendPacket(SeqNum seq, LazySlice slice, Callback<void> done) override {
+    queued_.emplace_back(Queued{std::move(slice), std::move(done)});
+  }
+
+  void SendParityPacket(SeqNum seq, LazySlice slice,
+                        Callback<void> done) override {
+    ADD_FAILURE() << "Parity sent without being enabled";
+  }
+
+  size_t queued() const { return queued_.size(); }
+
+  // Generates the oldest queued packet and returns its length.
+  uint64_t SendNext() {
+    Queued next = std::move(queued_.front());
+    queued_.pop_front();
+    TimeStamp when = timer_->Now();
+    Slice packet = next.slice(LazySliceArgs{0, kMSS, false, &when});
+    next.done();
+    return packet.length();
+  }
+
+ private:
+  struct Queued {
+    LazySlice slice;
+    Callback<void> done;
+  };
+
+  Timer* const timer_;
+  std::deque<Queued> queued_;
+};
+
+// A packet nacked while still queued below the protocol is never sent, and
+// must give back the congestion window BBR granted it: otherwise after a few
+// of these no more packets are ever sent.
+TEST(PacketProtocol, PacketsNackedWhileQueuedReturnTheirWindow) {
+  TestTimer timer;
+  QueueingPacketSender ps(&timer);
+  auto packet_protocol =
+      MakeClosedPtr<PacketProtocol>(&timer, &ps, TraceSink(), kMSS);
+
+  for (int i = 0; i < 10; i++) {
+    Status status(StatusCode::UNKNOWN);
+    packet_protocol->Send(
+        [](auto args) { return Slice::FromContainer({1, 2, 3}); },
+        [&status](const Status& result) { status = result; });
+    ASSERT_EQ(1u, ps.queued()) << "round " << i;
+
+    // The retransmission timeout nacks the packet before it gets sent.
+    while (status.code() == StatusCode::UNKNOWN &&
+           timer.StepUntilNextEvent()) {
+    }
+    EXPECT_EQ(StatusCode::CANCELLED, status.code()) << "round " << i;
+    EXPECT_EQ(0u, ps.SendNext()) << "round " << i;
+  }
+}
+
+// Two PacketProtocols joined by a simulated link with a fixed one way delay,
+// on which |drop| picks the packets that are lost. Messages go from the first
+// protocol (the sender) to the second, which hands them to |receive|.
+class SimulatedLink {
+ public:
+  static constexpr TimeDelta kOneWayDelay = TimeDelta::FromMilliseconds(10);
+
+  // Called for each packet sent: returns true to lose it.
+  using DropFn = std::function<bool(bool from_sender, bool parity)>;
+  using ReceiveFn = std::function<void(Slice)>;
+
+  SimulatedLink(uint32_t parity_group_size, DropFn drop, ReceiveFn receive)
+      : drop_(std::move(drop)),
+        receive_(std::move(receive)),
+        sender_(this, parity_group_size),
+        receiver_(this, parity_group_size) {
+    sender_.peer = &receiver_;
+    receiver_.peer = &sender_;
+  }
+
+  TestTimer* timer() { return &timer_; }
+  PacketProtocol* sender() { return sender_.protocol.get(); }
+
+ private:
+  class Endpoint final : public PacketProtocol::PacketSender {
+   public:
+    Endpoint(SimulatedLink* link, uint32_t parity_group_size)
+        : protocol(MakeClosedPtr<PacketProtocol>(
+              &link->timer_, this, TraceSink(), kMSS, parity_group_size)),
+          link_(link) {}
+
+    void SendPacket(SeqNum seq, LazySlice data, Callback<void> done) override {
+      Transmit(false, seq, std::move(data), std::move(done));
+    }
+    void SendParityPacket(SeqNum seq, LazySlice data,
+                          Callback<void> done) override {
+      Transmit(true, seq, std::move(data), std::move(done));
+    }
+
+    Endpoint* peer = nullptr;
+    ClosedPtr<PacketProtocol> protocol;
+
+   private:
+    // Like PacketLink, sends complete once pacing lets them go out.
+    void Transmit(bool parity, SeqNum seq, LazySlice data,
+                  Callback<void> done) {
+      TimeStamp when = link_->timer_.Now();
+      Slice packet = data(LazySliceArgs{0, kMSS, false, &when});
+      link_->timer_.At(when, [done = std::move(done)]() mutable { done(); });
+      if (packet.length() == 0 || link_->drop_(this == &link_->sender_, parity))
+        return;
+      link_->timer_.At(when + kOneWayDelay,
+                       [peer = peer, parity, seq, packet]() {
+                         peer->Receive(parity, seq, packet);
+                       });
+    }
+
+    void Receive(bool parity, SeqNum seq, Slice packet) {
+      const TimeStamp now = link_->timer_.Now();
+      auto processed = parity ? protocol->ProcessParity(now, seq, packet)
+                              : protocol->Process(now, seq, packet);
+      ASSERT_TRUE(processed.status.is_ok()) << processed.status.AsStatus();
+      if (*processed.status.get() && (*processed.status.get())->length()) {
+        link_->receive_(std::move(**processed.status.get()));
+      }
+    }
+
+    SimulatedLink* const link_;
+  };
+
+  TestTimer timer_;
+  const DropFn drop_;
+  const ReceiveFn receive_;
+  Endpoint sender_;
+  Endpoint receiver_;
+};
+
+constexpr TimeDelta SimulatedLink::kOneWayDelay;
+
+// Sends eight messages with one packet (the second of the second parity
+// group) lost, and returns how each send completed.
+std::vector<Status> SendEightLosingOne(uint32_t parity_group_size,
+                                       std::vector<uint8_t>* received) {
+  int sent = 0;
+  SimulatedLink link(parity_group_size,
+                     [&sent](bool from_sender, bool parity) {
+                       return from_sender && !parity && ++sent == 6;
+                     },
+                     [received](Slice message) {
+                       received->push_back(*message.begin());
+                     });
+  std::vector<Status> statuses(8, Status(StatusCode::UNKNOWN));
+  for (uint8_t i = 0; i < 8; i++) {
+    link.sender()->Send(
+        [i](auto args) { return Slice::RepeatedChar(100 + i, i); },
+        [&statuses, i](const Status& status) { statuses[i] = status; });
+  }
+  while (link.timer()->Now().after_epoch() < TimeDelta::FromSeconds(1)) {
+    link.timer()->StepUntilNextEvent();
+  }
+  return statuses;
+}
+
+TEST(PacketProtocol, LossWithoutParityIsNacked) {
+  std::vector<uint8_t> received;
+  auto statuses = SendEightLosingOne(0, &received);
+  EXPECT_EQ((std::vector<uint8_t>{0, 1, 2, 3, 4, 6, 7}), received);
+  for (uint8_t i = 0; i < 8; i++) {
+    EXPECT_EQ(i == 5 ? StatusCode::CANCELLED : StatusCode::OK,
+              statuses[i].code())
+        << "message " << int(i);
+  }
+}
+
+TEST(PacketProtocol, ParityRepairsLoss) {
+  std::vector<uint8_t> received;
+  auto statuses = SendEightLosingOne(4, &received);
+  // The lost message arrives with its group's parity, and is acked like the
+  // rest.
+  EXPECT_EQ((std::vector<uint8_t>{0, 1, 2, 3, 4, 6, 7, 5}), received);
+  for (uint8_t i = 0; i < 8; i++) {
+    EXPECT_TRUE(statuses[i].is_ok()) << "message " << int(i);
+  }
+}
+
+struct LossyLinkStats {
+  uint64_t delivered;
+  TimeDelta elapsed;
+  TimeDelta p99_latency;
+};
+
+// Sends |num_messages| 1000 byte messages, one per millisecond, over a link
+// losing |loss_rate| of packets in both directions. Nacked messages are resent
+// (as DatagramStream does), until everything is delivered. Latency is measured
+// once the first second's messages have brought the link up to speed.
+LossyLinkStats SimulateLossyLink(uint32_t parity_group_size, double loss_rate,
+                                 uint64_t num_messages) {
+  static constexpr size_t kMessageLength = 1000;
+  std::mt19937_64 rng(123);
+  std::bernoulli_distribution lose(loss_rate);
+  std::vector<TimeStamp> sent_at;
+  // Negative until delivered.
+  std::vector<int64_t> latency_us(num_messages, -1);
+  uint64_t delivered = 0;
+  TestTimer* timer = nullptr;
+  SimulatedLink link(parity_group_size,
+                     [&rng, &lose](bool, bool) { return lose(rng); },
+                     [&](Slice message) {
+                       uint64_t id;
+                       memcpy(&id, message.begin(), sizeof(id));
+                       if (latency_us[id] < 0) {
+                         latency_us[id] = (timer->Now() - sent_at[id]).as_us();
+                         delivered++;
+                       }
+                     });
+  timer = link.timer();
+
+  bool finished = false;
+  std::function<void(uint64_t)> send = [&](uint64_t id) {
+    link.sender()->Send(
+        [id](auto args) {
+          return Slice::WithInitializer(kMessageLength, [id](uint8_t* p) {
+            memset(p, 0, kMessageLength);
+            memcpy(p, &id, sizeof(id));
+          });
+        },
+        [&send, &finished, timer, id](const Status& status) {
+          if (status.code() == StatusCode::CANCELLED && !finished)
+            timer->At(timer->Now(), [&send, id]() { send(id); });
+        });
+  };
+  const TimeStamp start = timer->Now();
+  for (uint64_t id = 0; id < num_messages; id++) {
+    sent_at.push_back(start + TimeDelta::FromMilliseconds(id));
+    timer->At(sent_at.back(), [&send, id]() { send(id); });
+  }
+  TimeStamp last = start;
+  while (delivered < num_messages &&
+         timer->Now() - start < TimeDelta::FromMinutes(1) &&
+         timer->StepUntilNextEvent()) {
+    last = timer->Now();
+  }
+  finished = true;
+
+  std::vector<int64_t> sorted;
+  for (uint64_t id = 1000; id < num_messages; id++) {
+    if (latency_us[id] >= 0)
+      sorted.push_back(latency_us[id]);
+  }
+  std::sort(sorted.begin(), sorted.end());
+  return LossyLinkStats{
+      delivered, last - start,
+      TimeDelta::FromMicroseconds(
+          sorted.empty() ? 0 : sorted[sorted.size() * 99 / 100])};
+}
+
+TEST(PacketProtocol, LossyLinkDeliversEverything) {
+  for (uint32_t parity_group_size : {0, 4}) {
+    auto stats = SimulateLossyLink(parity_group_size, 0.05, 500);
+    EXPECT_EQ(500u, stats.delivered) << "parity=" << parity_group_size;
+  }
+}
+
+// Enable to run the lossy link benchmark. It reports goodput and 99th
+// percentile message latency against loss rate, with and without parity.
+#if 0
+TEST(PacketProtocol, BenchmarkLossyLink) {
+  static constexpr uint64_t kMessages = 20000;
+  for (double loss_rate : {0.0, 0.01, 0.02, 0.05, 0.1, 0.2}) {
+    for (uint32_t parity_group_size : {0, 16, 8, 4}) {
+      auto stats = SimulateLossyLink(parity_group_size, loss_rate, kMessages);
+      printf("loss %4.1f%% parity %2u: goodput %5.2fMbps, p99 latency %8" PRId64
+             "us%s\n",
+             100 * loss_rate, parity_group_size,
+             8e3 * stats.delivered / stats.elapsed.as_us(),
+             stats.p99_latency.as_us(),
+             stats.delivered == kMessages ? "" : " (incomplete)");
+    }
+  }
+}
+#endif  // End lossy link benchmark.
+
 // Exposed some bugs in the fuzzer, and a bug whereby empty ack frames caused a
 // failure.
 TEST(PacketProtocolFuzzed, _02ef5d596c101ce01181a7dcd0a294ed81c88dbd) {
@@ -4,6 +4,7 @@
 
 #include "router.h"
 #include <iostream>
+#include "sharded_router.h"
 
 namespace overnet {
 
@@ -85,10 +86,15 @@ void Router::Forward(Message message) {
       const RoutableMessage::Destination& dst =
           message.header.destinations()[0];
       if (dst.dst() == node_id_) {
-        streams_[LocalStreamId{message.header.src(), dst.stream_id()}]
-            .HandleMessage(dst.seq(), message.received,
-                           message.make_payload(LazySliceArgs{
-                               0, std::numeric_limits<uint32_t>::max()}));
+        const LocalStreamId id{message.header.src(), dst.stream_id()};
+        if (OwnsStream(id)) {
+          streams_[id].HandleMessage(
+              dst.seq(), message.received,
+              message.make_payload(
+                  LazySliceArgs{0, std::numeric_limits<uint32_t>::max()}));
+        } else {
+          sharded_router_->HandOffToStream(id, std::move(message));
+        }
       } else {
         link_holder(dst.dst())->Forward(std::move(message));
       }
@@ -112,9 +118,10 @@ void Router::Forward(Message message) {
         if (dst.dst() == node_id_) {
           // Locally handled stream
           if (!handle_locally.has_value()) {
-            handle_locally = std::make_pair(
-                dst, &streams_[LocalStreamId{message.header.src(),
-                                             dst.stream_id()}]);
+            const LocalStreamId id{message.header.src(), dst.stream_id()};
+            // Streams owned by another shard are handed off below.
+            handle_locally =
+                std::make_pair(dst, OwnsStream(id) ? &streams_[id] : nullptr);
           }
         } else {
           // Remote destination
@@ -136,16 +143,26 @@ void Router::Forward(Message message) {
       for (auto& grp : group_forward) {
         grp.first->Forward(Message::SimpleForwarder(
             message.header.WithDestinations(std::move(grp.second)), payload,
-            message.received));
+            message.received, message.priority));
       }
       for (auto& lh : disconnected_holders) {
         lh.second->Forward(Message::SimpleForwarder(
             message.header.WithDestinations({lh.first}), payload,
-            message.received));
+            message.received, message.priority));
       }
       if (handle_locally.has_value()) {
-        handle_locally->second->HandleMessage(
-            handle_locally->first.seq(), message.received, std::move(payload));
+        if (handle_locally->second == nullptr) {
+          sharded_router_->HandOffToStream(
+              LocalStreamId{message.header.src(),
+                            handle_locally->first.stream_id()},
+              Message::SimpleForwarder(
+                  message.header.WithDestinations({handle_locally->first}),
+                  std::move(payload), message.received, message.priority));
+        } else {
+          handle_locally->second->HandleMessage(handle_locally->first.seq(),
+                                                message.received,
+                                                std::move(payload));
+        }
       }
     } break;
   }
@@ -210,7 +227,12 @@ Status Router::RegisterStream(NodeId peer, StreamId stream_id,
                               StreamHandler* stream_handler) {
   OVERNET_TRACE(DEBUG, trace_sink_) << "RegisterStream: " << peer << "/"
                                     << stream_id << " at " << stream_handler;
-  return streams_[LocalStreamId{peer, stream_id}].SetHandler(stream_handler);
+  const LocalStreamId id{peer, stream_id};
+  if (!OwnsStream(id)) {
+    return Status(StatusCode::FAILED_PRECONDITION,
+                  "Stream belongs to another shard");
+  }
+  return streams_[id].SetHandler(stream_handler);
 }
 
 Status Router::UnregisterStream(NodeId peer, StreamId stream_id,
@@ -232,6 +254,11 @@ void Router::RegisterLink(LinkPtr<> link) {
   UpdateRoutingTable({NodeMetrics(metrics.to(), 0)}, {metrics}, false);
 }
 
+bool Router::OwnsStream(const LocalStreamId& id) const {
+  return sharded_router_ == nullptr ||
+         sharded_router_->ShardFor(id.peer, id.stream_id) == shard_index_;
+}
+
 void Router::StreamHolder::HandleMessage(SeqNum seq, TimeStamp received,
                                          Slice payload) {
   if (handler_ == nullptr) {
@@ -46,14 +46,26 @@ inline auto ForwardingPayloadFactory(Slice payload) {
   };
 }
 
+// How links share their bandwidth between the streams sending over them:
+// each stream gets a share in proportion to the weight of its priority (see
+// EgressQueue). Priorities are local to a node: they are not sent on the wire.
+enum class StreamPriority : uint8_t {
+  Bulk = 0,
+  Default = 1,
+  Interactive = 2,
+};
+
 struct Message final {
   RoutableMessage header;
   LazySlice make_payload;
   TimeStamp received;
+  StreamPriority priority = StreamPriority::Default;
 
-  static Message SimpleForwarder(RoutableMessage msg, Slice payload,
-                                 TimeStamp received) {
-    return Message{std::move(msg), ForwardingPayloadFactory(payload), received};
+  static Message SimpleForwarder(
+      RoutableMessage msg, Slice payload, TimeStamp received,
+      StreamPriority priority = StreamPriority::Default) {
+    return Message{std::move(msg), ForwardingPayloadFactory(payload), received,
+                   priority};
   }
 };
 
@@ -72,6 +84,8 @@ LinkPtr<T> MakeLink(Args&&... args) {
   return MakeClosedPtr<T, Link>(std::forward<Args>(args)...);
 }
 
+class ShardedRouter;
+
 class Router final {
  public:
   class StreamHandler {
@@ -100,7 +114,8 @@ class Router final {
 
   // Forward a message to either ourselves or a link
   void Forward(Message message);
-  // Register a (locally handled) stream into this Router
+  // Register a (locally handled) stream into this Router. Shards of a
+  // ShardedRouter only accept streams that hash to them.
   Status RegisterStream(NodeId peer, StreamId stream_id,
                         StreamHandler* stream_handler);
   Status UnregisterStream(NodeId peer, StreamId stream_id,
@@ -128,9 +143,14 @@ class Router final {
   TraceSink trace_sink() const { return trace_sink_; }
 
  private:
+  friend class ShardedRouter;
+
   Timer* const timer_;
   const TraceSink trace_sink_;
   const NodeId node_id_;
+  // Set when this router is one shard of a ShardedRouter.
+  ShardedRouter* sharded_router_ = nullptr;
+  size_t shard_index_ = 0;
 
   void UpdateRoutingTable(std::vector<NodeMetrics> node_metrics,
                           std::vector<LinkMetrics> link_metrics,
@@ -198,6 +218,8 @@ class Router final {
 
   typedef router_impl::LocalStreamId LocalStreamId;
 
+  bool OwnsStream(const LocalStreamId& id) const;
+
   bool shutting_down_ = false;
   std::unordered_map<uint64_t, LinkPtr<>> owned_links_;
 
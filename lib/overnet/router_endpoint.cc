@@ -57,10 +57,14 @@ void RouterEndpoint::RegisterPeer(NodeId peer) {
                               std::forward_as_tuple(this, peer));
 }
 
-RouterEndpoint::Stream::Stream(NewStream introduction, TraceSink trace_sink)
+RouterEndpoint::Stream::Stream(NewStream introduction, TraceSink trace_sink,
+                               StreamPriority priority,
+                               Slice compression_dictionary)
     : DatagramStream(&introduction.creator_->router_, trace_sink,
                      introduction.peer_, introduction.reliability_and_ordering_,
-                     introduction.stream_id_) {}
+                     introduction.stream_id_, priority,
+                     introduction.compression_,
+                     std::move(compression_dictionary)) {}
 
 RouterEndpoint::ConnectionStream::ConnectionStream(RouterEndpoint* endpoint,
                                                    NodeId peer)
@@ -72,7 +76,9 @@ RouterEndpoint::ConnectionStream::ConnectionStream(RouterEndpoint* endpoint,
                 out << "Con[" << this << ";peer=" << peer << "] " << msg;
                 return out.str();
               }),
-          peer, ReliabilityAndOrdering::ReliableUnordered, StreamId(0)),
+          peer, ReliabilityAndOrdering::ReliableUnordered, StreamId(0),
+          // Stream introductions shouldn't wait behind bulk transfers.
+          StreamPriority::Interactive),
       endpoint_(endpoint),
       next_stream_id_(peer < endpoint->node_id() ? 2 : 1) {
   BeginRead();
@@ -119,27 +125,31 @@ void RouterEndpoint::ConnectionStream::BeginRead() {
 
 StatusOr<RouterEndpoint::NewStream> RouterEndpoint::SendIntro(
     NodeId peer, ReliabilityAndOrdering reliability_and_ordering,
-    Slice introduction) {
+    Slice introduction, Compression compression) {
   auto it = connection_streams_.find(peer);
   if (it == connection_streams_.end()) {
     return StatusOr<NewStream>(StatusCode::FAILED_PRECONDITION,
                                "Remote peer not registered with this endpoint");
   }
-  return it->second.Fork(reliability_and_ordering, std::move(introduction));
+  return it->second.Fork(reliability_and_ordering, std::move(introduction),
+                         compression);
 }
 
 StatusOr<RouterEndpoint::NewStream> RouterEndpoint::ConnectionStream::Fork(
-    ReliabilityAndOrdering reliability_and_ordering, Slice introduction) {
+    ReliabilityAndOrdering reliability_and_ordering, Slice introduction,
+    Compression compression) {
   StreamId id(next_stream_id_);
   next_stream_id_ += 2;
-  Slice payload =
-      ForkFrame(id, reliability_and_ordering, std::move(introduction)).Write();
+  Slice payload = ForkFrame(id, reliability_and_ordering,
+                            std::move(introduction), compression)
+                      .Write();
 
   // TODO(ctiller): Don't allocate.
   auto* send_op = new SendOp(this, payload.length());
   send_op->Push(payload);
   send_op->Close(Status::Ok(), [send_op]() { delete send_op; });
-  return NewStream{endpoint_, peer(), reliability_and_ordering, id};
+  return NewStream{endpoint_, peer(), reliability_and_ordering, id,
+                   compression};
 }
 
 void RouterEndpoint::RecvIntro(StatusOrCallback<ReceivedIntroduction> ready) {
@@ -157,7 +167,8 @@ void RouterEndpoint::MaybeContinueIncomingForks() {
   recv_intro_ready_(ReceivedIntroduction{
       NewStream{this, incoming_fork->peer(),
                 incoming_fork->fork_frame_->reliability_and_ordering(),
-                incoming_fork->fork_frame_->stream_id()},
+                incoming_fork->fork_frame_->stream_id(),
+                incoming_fork->fork_frame_->compression()},
       incoming_fork->fork_frame_->introduction()});
   incoming_fork->fork_frame_.Destroy();
   incoming_fork->BeginRead();
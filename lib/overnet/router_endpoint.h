@@ -27,7 +27,8 @@ class RouterEndpoint final {
         : creator_(other.creator_),
           peer_(other.peer_),
           reliability_and_ordering_(other.reliability_and_ordering_),
-          stream_id_(other.stream_id_) {
+          stream_id_(other.stream_id_),
+          compression_(other.compression_) {
       other.creator_ = nullptr;
     }
     NewStream& operator=(NewStream&& other) {
@@ -35,30 +36,37 @@ class RouterEndpoint final {
       peer_ = other.peer_;
       reliability_and_ordering_ = other.reliability_and_ordering_;
       stream_id_ = other.stream_id_;
+      compression_ = other.compression_;
       other.creator_ = nullptr;
       return *this;
     }
 
+    Compression compression() const { return compression_; }
+
     friend std::ostream& operator<<(std::ostream& out, const NewStream& s) {
       return out << "NewStream{node=" << s.peer_ << ",reliability_and_ordering="
                  << ReliabilityAndOrderingString(s.reliability_and_ordering_)
-                 << ",stream_id=" << s.stream_id_ << "}";
+                 << ",stream_id=" << s.stream_id_
+                 << ",compression=" << CompressionString(s.compression_)
+                 << "}";
     }
 
    private:
     friend class RouterEndpoint;
     NewStream(RouterEndpoint* creator, NodeId peer,
               ReliabilityAndOrdering reliability_and_ordering,
-              StreamId stream_id)
+              StreamId stream_id, Compression compression)
         : creator_(creator),
           peer_(peer),
           reliability_and_ordering_(reliability_and_ordering),
-          stream_id_(stream_id) {}
+          stream_id_(stream_id),
+          compression_(compression) {}
 
     RouterEndpoint* creator_;
     NodeId peer_;
     ReliabilityAndOrdering reliability_and_ordering_;
     StreamId stream_id_;
+    Compression compression_;
   };
 
   struct ReceivedIntroduction final {
@@ -68,7 +76,11 @@ class RouterEndpoint final {
 
   class Stream final : public DatagramStream {
    public:
-    Stream(NewStream introduction, TraceSink trace_sink);
+    // If the stream is compressed, both ends must supply the same
+    // |compression_dictionary|.
+    Stream(NewStream introduction, TraceSink trace_sink,
+           StreamPriority priority = StreamPriority::Default,
+           Slice compression_dictionary = Slice());
   };
 
   using SendOp = Stream::SendOp;
@@ -92,9 +104,11 @@ class RouterEndpoint final {
   NodeId node_id() const { return router_.node_id(); }
 
   void RecvIntro(StatusOrCallback<ReceivedIntroduction> ready);
+  // |compression| is adopted by the peer's end of the stream.
   StatusOr<NewStream> SendIntro(NodeId peer,
                                 ReliabilityAndOrdering reliability_and_ordering,
-                                Slice introduction);
+                                Slice introduction,
+                                Compression compression = Compression::None);
 
  private:
   void MaybeContinueIncomingForks();
@@ -107,7 +121,7 @@ class RouterEndpoint final {
     ~ConnectionStream();
 
     StatusOr<NewStream> Fork(ReliabilityAndOrdering reliability_and_ordering,
-                             Slice introduction);
+                             Slice introduction, Compression compression);
 
    private:
     void BeginRead();
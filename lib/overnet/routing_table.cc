@@ -3,6 +3,7 @@
 // found in the LICENSE file.
 
 #include "routing_table.h"
+#include <algorithm>
 #include <iostream>
 
 using overnet::routing_table_impl::FullLinkLabel;
@@ -26,16 +27,28 @@ void MoveInto(std::vector<T>* from, std::vector<T>* to) {
 
 RoutingTable::~RoutingTable() {
   std::unique_lock<std::mutex> lock(mu_);
-  if (processing_changes_) {
-    std::thread pending_processing = std::move(*processing_changes_);
-    processing_changes_.Reset();
-    cv_.notify_all();
-    lock.unlock();
-    pending_processing.join();
+  shutting_down_ = true;
+  cv_.notify_all();
+  lock.unlock();
+  if (worker_) {
+    worker_->join();
   }
 
+  // Unlink everything so that the intrusive lists can be torn down in any
+  // order.
+  while (todo_.PopFront()) {
+  }
+  while (invalidated_.PopFront()) {
+  }
+  while (dirty_.PopFront()) {
+  }
   for (auto& n : node_metrics_) {
-    RemoveOutgoingLinks(n.second);
+    while (n.second.outgoing_links.PopFront()) {
+    }
+    while (n.second.incoming_links.PopFront()) {
+    }
+    while (n.second.tree_children.PopFront()) {
+    }
   }
 }
 
@@ -46,56 +59,52 @@ void RoutingTable::Update(std::vector<NodeMetrics> node_metrics,
     return;
   std::unique_lock<std::mutex> lock(mu_);
   last_update_ = timer_->Now();
-  const bool was_empty = change_log_.Empty() && !flush_requested_;
   if (flush_old_nodes)
     flush_requested_ = true;
   MoveInto(&node_metrics, &change_log_.node_metrics);
   MoveInto(&link_metrics, &change_log_.link_metrics);
-  if (!was_empty)
-    return;
-  if (processing_changes_)
+  processing_changes_ = true;
+  if (!allow_threading_) {
+    lock.unlock();
+    ProcessChanges();
     return;
-  auto process_changes = [this, changes = std::move(change_log_),
-                          flush = flush_requested_,
-                          now = last_update_]() mutable {
-    while (true) {
-      ApplyChanges(now, changes, flush);
-      SelectedLinks new_selected_links = BuildForwardingTable();
-
-      // Publish changes. If change-log has grown, restart update.
-      std::lock_guard<std::mutex> lock(mu_);
-      if (selected_links_ != new_selected_links) {
-        selected_links_.swap(new_selected_links);
-        selected_links_version_++;
-      }
-      if (!processing_changes_) {
-        // Indicates that the owning RoutingTable instance is in its destruction
-        // sequence.
-        cv_.notify_all();
-        return;
-      } else if (change_log_.Empty() && !flush_requested_) {
-        processing_changes_->detach();
-        processing_changes_.Reset();
-        cv_.notify_all();
+  }
+  // One worker serves every update for the life of the table: changes that
+  // arrive while it is busy are picked up as a single batch when it is done.
+  if (!worker_) {
+    worker_.Reset([this]() { ProcessChanges(); });
+  }
+  cv_.notify_all();
+}
+
+void RoutingTable::ProcessChanges() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (true) {
+    if (allow_threading_) {
+      cv_.wait(lock, [this]() {
+        return shutting_down_ || !change_log_.Empty() || flush_requested_;
+      });
+      if (shutting_down_)
         return;
-      } else {
-        changes = std::move(change_log_);
-        change_log_.Clear();
-        flush = flush_requested_;
-        flush_requested_ = false;
-        now = last_update_;
-      }
+    } else if (change_log_.Empty() && !flush_requested_) {
+      return;
     }
-  };
-  if (allow_threading_) {
-    processing_changes_.Reset(std::move(process_changes));
-    cv_.notify_all();
-  }
-  flush_requested_ = false;
-  change_log_.Clear();
-  if (!allow_threading_) {
+    Metrics changes = std::move(change_log_);
+    change_log_.Clear();
+    const bool flush = flush_requested_;
+    flush_requested_ = false;
+    const TimeStamp now = last_update_;
     lock.unlock();
-    process_changes();
+
+    ApplyChanges(now, changes, flush);
+    UpdatePaths();
+
+    lock.lock();
+    PublishSelectedLinks();
+    if (change_log_.Empty() && !flush_requested_) {
+      processing_changes_ = false;
+      cv_.notify_all();
+    }
   }
 }
 
@@ -105,12 +114,21 @@ void RoutingTable::ApplyChanges(TimeStamp now, const Metrics& changes,
   for (const auto& m : changes.node_metrics) {
     auto it = node_metrics_.find(m.node_id());
     if (it == node_metrics_.end()) {
-      node_metrics_.emplace(std::piecewise_construct,
-                            std::forward_as_tuple(m.node_id()),
-                            std::forward_as_tuple(now, m));
+      Node* node = &node_metrics_
+                        .emplace(std::piecewise_construct,
+                                 std::forward_as_tuple(m.node_id()),
+                                 std::forward_as_tuple(now, m))
+                        .first->second;
+      if (IsRoot(node)) {
+        node->reachable = true;
+        node->best_rtt = TimeDelta::Zero();
+        Enqueue(node);
+      }
     } else if (m.version() > it->second.metrics.version()) {
+      const NodeMetrics old_metrics = it->second.metrics;
       it->second.metrics = m;
       it->second.last_updated = now;
+      NodeMetricsChanged(&it->second, old_metrics);
     }
   }
   for (const auto& m : changes.link_metrics) {
@@ -140,14 +158,21 @@ void RoutingTable::ApplyChanges(TimeStamp now, const Metrics& changes,
     const FullLinkLabel key = {m.from(), m.to(), m.link_label()};
     auto it = link_metrics_.find(key);
     if (it == link_metrics_.end()) {
-      it = link_metrics_
-               .emplace(std::piecewise_construct, std::forward_as_tuple(key),
-                        std::forward_as_tuple(now, m, &to_node->second))
-               .first;
-      from_node->second.outgoing_links.PushBack(&it->second);
+      Link* link = &link_metrics_
+                        .emplace(std::piecewise_construct,
+                                 std::forward_as_tuple(key),
+                                 std::forward_as_tuple(now, m,
+                                                       &from_node->second,
+                                                       &to_node->second))
+                        .first->second;
+      from_node->second.outgoing_links.PushBack(link);
+      to_node->second.incoming_links.PushBack(link);
+      Relax(link);
     } else if (m.version() > it->second.metrics.version()) {
+      const LinkMetrics old_metrics = it->second.metrics;
       it->second.metrics = m;
       it->second.last_updated = now;
+      LinkMetricsChanged(&it->second, old_metrics);
     } else {
       report_drop("old version");
     }
@@ -156,10 +181,9 @@ void RoutingTable::ApplyChanges(TimeStamp now, const Metrics& changes,
   // Remove anything old if we've been asked to.
   if (flush) {
     for (auto it = node_metrics_.begin(); it != node_metrics_.end();) {
-      if (it->first == root_node_)
-        continue;
-      if (it->second.last_updated >= now + EntryExpiry()) {
-        RemoveOutgoingLinks(it->second);
+      if (it->first != root_node_ &&
+          it->second.last_updated + EntryExpiry() <= now) {
+        RemoveNode(&it->second);
         it = node_metrics_.erase(it);
       } else {
         ++it;
@@ -168,77 +192,221 @@ void RoutingTable::ApplyChanges(TimeStamp now, const Metrics& changes,
   }
 }
 
-void RoutingTable::RemoveOutgoingLinks(Node& node) {
-  while (Link* link = node.outgoing_links.PopFront()) {
-    link_metrics_.erase(FullLinkLabel{link->metrics.from(), link->metrics.to(),
-                                      link->metrics.link_label()});
+void RoutingTable::NodeMetricsChanged(Node* node,
+                                      const NodeMetrics& old_metrics) {
+  const TimeDelta old_time = old_metrics.forwarding_time();
+  const TimeDelta new_time = node->metrics.forwarding_time();
+  if (new_time > old_time) {
+    // Everything routed through this node may now have a better path.
+    std::vector<Node*> children;
+    for (Node* child : node->tree_children) {
+      children.push_back(child);
+    }
+    for (Node* child : children) {
+      InvalidateSubtree(child);
+    }
+  } else if (new_time < old_time && node->reachable) {
+    Enqueue(node);
   }
 }
 
-RoutingTable::SelectedLinks RoutingTable::BuildForwardingTable() {
-  auto node_it = node_metrics_.find(root_node_);
-  if (node_it == node_metrics_.end()) {
-    return SelectedLinks();  // Root node as yet unknown.
+void RoutingTable::LinkMetricsChanged(Link* link,
+                                      const LinkMetrics& old_metrics) {
+  const bool was_up = old_metrics.version() != METRIC_VERSION_TOMBSTONE;
+  const bool is_up = link->metrics.version() != METRIC_VERSION_TOMBSTONE;
+  const bool got_worse =
+      (was_up && !is_up) || link->metrics.rtt() > old_metrics.rtt() ||
+      link->metrics.mss() != old_metrics.mss();
+  const bool got_better =
+      is_up && (!was_up || link->metrics.rtt() < old_metrics.rtt());
+  if (got_worse && link->to_node->best_link == link) {
+    // UpdatePaths will find the best way back in, which may still be via this
+    // link.
+    InvalidateSubtree(link->to_node);
+  } else if (got_better) {
+    Relax(link);
   }
+}
 
-  ++path_finding_run_;
-  node_it->second.last_path_finding_run = path_finding_run_;
-  node_it->second.best_rtt = TimeDelta::Zero();
-  node_it->second.mss = std::numeric_limits<uint32_t>::max();
-  InternalList<Node, &Node::path_finding_node> todo;
+void RoutingTable::Relax(Link* link) {
+  if (link->metrics.version() == METRIC_VERSION_TOMBSTONE)
+    return;
+  Node* src = link->from_node;
+  Node* dst = link->to_node;
+  if (!src->reachable || IsRoot(dst))
+    return;
+  // For now we order by RTT.
+  if (!dst->reachable || RttVia(link) < dst->best_rtt) {
+    SetRoute(dst, link);
+    Enqueue(dst);
+  }
+}
 
-  auto enqueue = [&todo](Node* node) {
-    if (node->queued)
-      return;
-    node->queued = true;
-    todo.PushBack(node);
-  };
+void RoutingTable::SetRoute(Node* node, Link* link) {
+  Node* from = link->from_node;
+  if (node->best_from != nullptr) {
+    node->best_from->tree_children.Remove(node);
+  }
+  node->reachable = true;
+  node->best_rtt = RttVia(link);
+  node->best_from = from;
+  node->best_link = link;
+  from->tree_children.PushBack(node);
+  Link* const first_hop = IsRoot(from) ? link : from->first_hop;
+  if (first_hop != node->first_hop) {
+    node->first_hop = first_hop;
+    first_hop_changed_.push_back(node);
+  }
+  MarkDirty(node);
+}
+
+void RoutingTable::InvalidateSubtree(Node* node) {
+  if (!node->reachable || IsRoot(node))
+    return;
+  node->best_from->tree_children.Remove(node);
+  std::vector<Node*> stack{node};
+  while (!stack.empty()) {
+    Node* n = stack.back();
+    stack.pop_back();
+    while (Node* child = n->tree_children.PopFront()) {
+      stack.push_back(child);
+    }
+    n->reachable = false;
+    n->best_rtt = TimeDelta::PositiveInf();
+    n->best_from = nullptr;
+    n->best_link = nullptr;
+    n->first_hop = nullptr;
+    if (!n->invalidated) {
+      n->invalidated = true;
+      invalidated_.PushBack(n);
+    }
+    MarkDirty(n);
+  }
+}
 
-  enqueue(&node_it->second);
+void RoutingTable::Enqueue(Node* node) {
+  if (node->queued)
+    return;
+  node->queued = true;
+  todo_.PushBack(node);
+}
 
-  while (!todo.Empty()) {
-    Node* src = todo.PopFront();
-    src->queued = false;
-    for (auto link : src->outgoing_links) {
-      if (link->metrics.version() == METRIC_VERSION_TOMBSTONE)
+void RoutingTable::MarkDirty(Node* node) {
+  if (node->dirty)
+    return;
+  node->dirty = true;
+  dirty_.PushBack(node);
+}
+
+void RoutingTable::RemoveNode(Node* node) {
+  InvalidateSubtree(node);
+  while (Link* link = node->outgoing_links.PopFront()) {
+    link->to_node->incoming_links.Remove(link);
+    link_metrics_.erase(FullLinkLabel{link->metrics.from(), link->metrics.to(),
+                                      link->metrics.link_label()});
+  }
+  while (Link* link = node->incoming_links.PopFront()) {
+    link->from_node->outgoing_links.Remove(link);
+    link_metrics_.erase(FullLinkLabel{link->metrics.from(), link->metrics.to(),
+                                      link->metrics.link_label()});
+  }
+  if (node->queued) {
+    node->queued = false;
+    todo_.Remove(node);
+  }
+  if (node->invalidated) {
+    node->invalidated = false;
+    invalidated_.Remove(node);
+  }
+  if (node->dirty) {
+    node->dirty = false;
+    dirty_.Remove(node);
+  }
+  first_hop_changed_.erase(std::remove(first_hop_changed_.begin(),
+                                       first_hop_changed_.end(), node),
+                           first_hop_changed_.end());
+  removed_nodes_.push_back(node->metrics.node_id());
+}
+
+void RoutingTable::UpdatePaths() {
+  // Reattach invalidated nodes through their best link from the rest of the
+  // tree; anything they lead to is found by relaxation below. Some may have
+  // been reattached already by a link relaxed since, which need not have been
+  // their best.
+  while (Node* node = invalidated_.PopFront()) {
+    node->invalidated = false;
+    Link* best = nullptr;
+    for (Link* link : node->incoming_links) {
+      if (link->metrics.version() == METRIC_VERSION_TOMBSTONE ||
+          !link->from_node->reachable) {
         continue;
-      TimeDelta rtt =
-          src->best_rtt + src->metrics.forwarding_time() + link->metrics.rtt();
-      Node* dst = link->to_node;
-      // For now we order by RTT.
-      if (dst->last_path_finding_run != path_finding_run_ ||
-          dst->best_rtt > rtt) {
-        dst->last_path_finding_run = path_finding_run_;
-        dst->best_rtt = rtt;
-        dst->best_from = src;
-        dst->best_link = link;
-        dst->mss = std::min(src->mss, link->metrics.mss());
-        enqueue(dst);
       }
+      if (best == nullptr || RttVia(link) < RttVia(best)) {
+        best = link;
+      }
+    }
+    if (best != nullptr &&
+        (!node->reachable || RttVia(best) < node->best_rtt)) {
+      SetRoute(node, best);
+      Enqueue(node);
     }
   }
 
-  SelectedLinks selected_links;
+  while (Node* src = todo_.PopFront()) {
+    src->queued = false;
+    if (!src->reachable)
+      continue;
+    for (Link* link : src->outgoing_links) {
+      Relax(link);
+    }
+  }
 
-  for (node_it = node_metrics_.begin(); node_it != node_metrics_.end();
-       ++node_it) {
-    if (node_it->second.last_path_finding_run != path_finding_run_) {
-      continue;  // Unreachable
+  // Improvements normally propagate down the tree by relaxation, but not when
+  // the path cost saturates (eg. infinite forwarding times): make sure every
+  // node still routes through its ancestors' first hop.
+  while (!first_hop_changed_.empty()) {
+    Node* node = first_hop_changed_.back();
+    first_hop_changed_.pop_back();
+    for (Node* child : node->tree_children) {
+      if (child->first_hop != node->first_hop) {
+        child->first_hop = node->first_hop;
+        MarkDirty(child);
+        first_hop_changed_.push_back(child);
+      }
     }
-    if (node_it->first == root_node_) {
+  }
+}
+
+void RoutingTable::PublishSelectedLinks() {
+  bool changed = false;
+  for (NodeId node : removed_nodes_) {
+    if (selected_links_.erase(node))
+      changed = true;
+  }
+  removed_nodes_.clear();
+  while (Node* node = dirty_.PopFront()) {
+    node->dirty = false;
+    const NodeId node_id = node->metrics.node_id();
+    if (!node->reachable || IsRoot(node)) {
+      if (selected_links_.erase(node_id))
+        changed = true;
       continue;
     }
-    Node* n = &node_it->second;
-    while (n->best_from->metrics.node_id() != root_node_) {
-      n = n->best_from;
-    }
-    Link* link = n->best_link;
+    Link* link = node->first_hop;
     assert(link->metrics.from() == root_node_);
-    selected_links[node_it->first] =
-        SelectedLink{link->metrics.link_label(), n->mss};
+    const SelectedLink selected{link->metrics.link_label(),
+                                link->metrics.mss()};
+    auto it = selected_links_.find(node_id);
+    if (it == selected_links_.end()) {
+      selected_links_.emplace(node_id, selected);
+      changed = true;
+    } else if (!(it->second == selected)) {
+      it->second = selected;
+      changed = true;
+    }
   }
-
-  return selected_links;
+  if (changed)
+    selected_links_version_++;
 }
 
 }  // namespace overnet
@@ -125,6 +125,9 @@ class RoutingTable {
         allow_threading_(allow_threading) {}
   ~RoutingTable();
 
+  RoutingTable(const RoutingTable&) = delete;
+  RoutingTable& operator=(const RoutingTable&) = delete;
+
   static constexpr TimeDelta EntryExpiry() { return TimeDelta::FromMinutes(5); }
 
   struct SelectedLink {
@@ -151,7 +154,7 @@ class RoutingTable {
       published_links_version_ = selected_links_version_;
       f(selected_links_);
     }
-    const bool done = !processing_changes_.has_value();
+    const bool done = !processing_changes_;
     mu_.unlock();
     return done;
   }
@@ -179,49 +182,98 @@ class RoutingTable {
   const bool allow_threading_;
   bool flush_requested_ = false;
 
+  // Runs on worker_ (when threading is allowed) for the life of the table,
+  // applying each batch of changes as it arrives.
+  void ProcessChanges();
   void ApplyChanges(TimeStamp now, const Metrics& changes, bool flush);
-  SelectedLinks BuildForwardingTable();
+  // Brings the shortest path tree up to date after ApplyChanges.
+  void UpdatePaths();
+  // Publishes routes that changed since the last call. Requires mu_.
+  void PublishSelectedLinks();
 
   TimeStamp last_update_{TimeStamp::Epoch()};
-  uint64_t path_finding_run_ = 0;
 
   std::mutex mu_;
   std::condition_variable cv_;
-  Optional<std::thread> processing_changes_;
+  // Changes are waiting for, or being processed by, path finding.
+  bool processing_changes_ = false;
+  bool shutting_down_ = false;
+  Optional<std::thread> worker_;
 
   struct Node;
 
   struct Link {
-    Link(TimeStamp now, LinkMetrics initial_metrics, Node* to)
-        : metrics(initial_metrics), last_updated(now), to_node(to) {}
+    Link(TimeStamp now, LinkMetrics initial_metrics, Node* from, Node* to)
+        : metrics(initial_metrics),
+          last_updated(now),
+          from_node(from),
+          to_node(to) {}
     LinkMetrics metrics;
     TimeStamp last_updated;
     InternalListNode<Link> outgoing_link;
+    InternalListNode<Link> incoming_link;
+    Node* const from_node;
     Node* const to_node;
   };
 
+  // Routes are kept as a shortest path tree rooted at root_node_. Changes only
+  // revisit the part of the tree they can affect: a link that got better is
+  // relaxed (and the improvement propagated), a tree link that got worse
+  // invalidates the subtree below it, which is then reattached through the
+  // best links into it from the rest of the tree.
   struct Node {
     Node(TimeStamp now, NodeMetrics initial_metrics)
         : metrics(initial_metrics), last_updated(now) {}
     NodeMetrics metrics;
     TimeStamp last_updated;
     InternalList<Link, &Link::outgoing_link> outgoing_links;
-
-    // Path finding temporary state.
-    uint64_t last_path_finding_run = 0;
-    TimeDelta best_rtt{TimeDelta::Zero()};
-    Node* best_from;
-    Link* best_link;
-    uint32_t mss;
+    InternalList<Link, &Link::incoming_link> incoming_links;
+
+    // Position in the shortest path tree.
+    bool reachable = false;
+    TimeDelta best_rtt{TimeDelta::PositiveInf()};
+    Node* best_from = nullptr;
+    Link* best_link = nullptr;
+    // The root's link towards this node.
+    Link* first_hop = nullptr;
+    InternalListNode<Node> tree_sibling;
+    InternalList<Node, &Node::tree_sibling> tree_children;
+
+    // Path finding work lists.
     bool queued = false;
     InternalListNode<Node> path_finding_node;
+    bool invalidated = false;
+    InternalListNode<Node> invalidated_node;
+    bool dirty = false;
+    InternalListNode<Node> dirty_node;
   };
 
-  void RemoveOutgoingLinks(Node& node);
-
+  bool IsRoot(const Node* node) const {
+    return node->metrics.node_id() == root_node_;
+  }
+  TimeDelta RttVia(const Link* link) const {
+    return link->from_node->best_rtt +
+           link->from_node->metrics.forwarding_time() + link->metrics.rtt();
+  }
+  void NodeMetricsChanged(Node* node, const NodeMetrics& old_metrics);
+  void LinkMetricsChanged(Link* link, const LinkMetrics& old_metrics);
+  void Relax(Link* link);
+  void SetRoute(Node* node, Link* link);
+  void InvalidateSubtree(Node* node);
+  void Enqueue(Node* node);
+  void MarkDirty(Node* node);
+  void RemoveNode(Node* node);
+
+  // Only touched by path finding (ie. without mu_).
   std::unordered_map<NodeId, Node> node_metrics_;
   std::unordered_map<routing_table_impl::FullLinkLabel, Link> link_metrics_;
 
+  InternalList<Node, &Node::path_finding_node> todo_;
+  InternalList<Node, &Node::invalidated_node> invalidated_;
+  InternalList<Node, &Node::dirty_node> dirty_;
+  std::vector<Node*> first_hop_changed_;
+  std::vector<NodeId> removed_nodes_;
+
   uint64_t selected_links_version_ = 0;
   SelectedLinks selected_links_;
   uint64_t published_links_version_ = 0;
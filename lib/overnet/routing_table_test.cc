@@ -0,0 +1,259 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "routing_table.h"
+#include <time.h>
+#include <cinttypes>
+#include <cstdio>
+#include <random>
+#include "gtest/gtest.h"
+#include "test_timer.h"
+
+namespace overnet {
+namespace routing_table_test {
+
+// Polls for the latest published routes. Tables only publish when routes
+// change, so |links| holds what was last seen for |table|.
+const RoutingTable::SelectedLinks& Poll(RoutingTable* table,
+                                        RoutingTable::SelectedLinks* links) {
+  table->BlockUntilNoBackgroundUpdatesProcessing();
+  EXPECT_TRUE(table->PollLinkUpdates(
+      [links](const RoutingTable::SelectedLinks& selected_links) {
+        *links = selected_links;
+      }));
+  return *links;
+}
+
+NodeMetrics Node(uint64_t node, uint64_t version,
+                 TimeDelta forwarding_time = TimeDelta::Zero()) {
+  NodeMetrics m(NodeId(node), version);
+  m.set_forwarding_time(forwarding_time);
+  return m;
+}
+
+LinkMetrics Link(uint64_t from, uint64_t to, uint64_t label, uint64_t version,
+                 int64_t rtt_us, uint32_t mss = 1024) {
+  LinkMetrics m(NodeId(from), NodeId(to), version, label);
+  m.set_rtt(TimeDelta::FromMicroseconds(rtt_us));
+  m.set_mss(mss);
+  return m;
+}
+
+TEST(RoutingTable, SelectsFirstHopOfShortestPath) {
+  TestTimer timer;
+  RoutingTable table(NodeId(1), &timer, TraceSink(), false);
+  RoutingTable::SelectedLinks links;
+
+  table.Update({Node(1, 1), Node(2, 1), Node(3, 1)},
+               {Link(1, 2, 12, 1, 10, 500), Link(2, 3, 23, 1, 10),
+                Link(1, 3, 13, 1, 30, 700)},
+               false);
+  Poll(&table, &links);
+  EXPECT_EQ(2u, links.size());
+  EXPECT_EQ((RoutingTable::SelectedLink{12, 500}), links[NodeId(2)]);
+  EXPECT_EQ((RoutingTable::SelectedLink{12, 500}), links[NodeId(3)]);
+
+  // Slowing the first hop moves node 3 (but not node 2) to the direct link.
+  table.Update({}, {Link(1, 2, 12, 2, 25, 500)}, false);
+  Poll(&table, &links);
+  EXPECT_EQ((RoutingTable::SelectedLink{12, 500}), links[NodeId(2)]);
+  EXPECT_EQ((RoutingTable::SelectedLink{13, 700}), links[NodeId(3)]);
+
+  // Dropping the link to node 2 routes it through node 3.
+  table.Update({}, {Link(1, 2, 12, METRIC_VERSION_TOMBSTONE, 25)}, false);
+  table.Update({}, {Link(3, 2, 32, 1, 10)}, false);
+  Poll(&table, &links);
+  EXPECT_EQ((RoutingTable::SelectedLink{13, 700}), links[NodeId(2)]);
+  EXPECT_EQ((RoutingTable::SelectedLink{13, 700}), links[NodeId(3)]);
+
+  // A node with no way in is unreachable.
+  table.Update({}, {Link(1, 3, 13, METRIC_VERSION_TOMBSTONE, 30)}, false);
+  Poll(&table, &links);
+  EXPECT_TRUE(links.empty());
+}
+
+TEST(RoutingTable, NoUpdateWhenRoutesAreUnchanged) {
+  TestTimer timer;
+  RoutingTable table(NodeId(1), &timer, TraceSink(), false);
+
+  RoutingTable::SelectedLinks links;
+  table.Update({Node(1, 1), Node(2, 1)}, {Link(1, 2, 12, 1, 10)}, false);
+  Poll(&table, &links);
+  table.Update({}, {Link(1, 2, 12, 2, 5)}, false);
+  bool updated = false;
+  EXPECT_TRUE(table.PollLinkUpdates(
+      [&updated](const RoutingTable::SelectedLinks&) { updated = true; }));
+  EXPECT_FALSE(updated);
+}
+
+TEST(RoutingTable, FlushRemovesExpiredNodesAndTheirLinks) {
+  TestTimer timer;
+  RoutingTable table(NodeId(1), &timer, TraceSink(), false);
+  RoutingTable::SelectedLinks links;
+
+  table.Update({Node(1, 1), Node(2, 1), Node(3, 1)},
+               {Link(1, 2, 12, 1, 10), Link(2, 3, 23, 1, 10)}, false);
+  Poll(&table, &links);
+  EXPECT_EQ(2u, links.size());
+
+  // Flushing before anything expires changes nothing.
+  timer.Step(TimeDelta::FromMinutes(1).as_us());
+  table.Update({}, {}, true);
+  Poll(&table, &links);
+  EXPECT_EQ(2u, links.size());
+
+  // Only the link to node 2 is kept alive past expiry: node 3 goes.
+  timer.Step(RoutingTable::EntryExpiry().as_us());
+  table.Update({}, {Link(1, 2, 12, 2, 10)}, true);
+  Poll(&table, &links);
+  EXPECT_EQ(1u, links.size());
+  EXPECT_EQ((RoutingTable::SelectedLink{12, 1024}), links[NodeId(2)]);
+
+  // The link from node 2 went with node 3, so node 3 returning is not enough
+  // to reach it.
+  table.Update({Node(3, 2)}, {}, false);
+  Poll(&table, &links);
+  EXPECT_EQ(1u, links.size());
+  EXPECT_EQ(0u, links.count(NodeId(3)));
+}
+
+// Churns the metrics of a random mesh, checking after each batch that the
+// incrementally maintained routes match a table built from scratch.
+void ChurnMatchesRebuild(bool allow_threading) {
+  static constexpr uint64_t kNodes = 40;
+  static constexpr int kLinksPerNode = 3;
+  std::mt19937_64 rng(123);
+  // Random costs are distinct enough that shortest paths are unique.
+  auto random_us = [&rng]() {
+    return std::uniform_int_distribution<int64_t>(1, 1000000)(rng);
+  };
+
+  std::vector<NodeMetrics> nodes;
+  std::vector<LinkMetrics> links;
+  for (uint64_t i = 1; i <= kNodes; i++) {
+    nodes.push_back(Node(i, 1, TimeDelta::FromMicroseconds(random_us())));
+    for (int j = 0; j < kLinksPerNode; j++) {
+      uint64_t to = std::uniform_int_distribution<uint64_t>(1, kNodes)(rng);
+      if (to != i) {
+        links.push_back(Link(i, to, links.size() + 1, 1, random_us(),
+                             512 + links.size()));
+      }
+    }
+  }
+
+  TestTimer timer;
+  RoutingTable table(NodeId(1), &timer, TraceSink(), allow_threading);
+  RoutingTable::SelectedLinks selected_links;
+  table.Update(nodes, links, false);
+
+  for (int batch = 0; batch < 100; batch++) {
+    std::vector<NodeMetrics> node_changes;
+    std::vector<LinkMetrics> link_changes;
+    for (int change = 0; change < 5; change++) {
+      if (rng() % 4 == 0) {
+        auto& n = nodes[rng() % nodes.size()];
+        n = Node(n.node_id().get(), n.version() + 1,
+                 TimeDelta::FromMicroseconds(random_us()));
+        node_changes.push_back(n);
+        continue;
+      }
+      auto& l = links[rng() % links.size()];
+      // Tombstones are forever.
+      if (l.version() == METRIC_VERSION_TOMBSTONE)
+        continue;
+      const uint64_t version = l.version() + 1;
+      switch (rng() % 4) {
+        case 0:
+          l = Link(l.from().get(), l.to().get(), l.link_label(),
+                   METRIC_VERSION_TOMBSTONE, l.rtt().as_us(), l.mss());
+          break;
+        case 1:
+          l = Link(l.from().get(), l.to().get(), l.link_label(), version,
+                   l.rtt().as_us(), l.mss() + 1);
+          break;
+        default:
+          l = Link(l.from().get(), l.to().get(), l.link_label(), version,
+                   random_us(), l.mss());
+          break;
+      }
+      link_changes.push_back(l);
+    }
+    table.Update(node_changes, link_changes, false);
+
+    RoutingTable rebuilt(NodeId(1), &timer, TraceSink(), false);
+    std::vector<LinkMetrics> live_links;
+    for (const auto& l : links) {
+      if (l.version() != METRIC_VERSION_TOMBSTONE)
+        live_links.push_back(l);
+    }
+    rebuilt.Update(nodes, live_links, false);
+    RoutingTable::SelectedLinks rebuilt_links;
+    ASSERT_EQ(Poll(&rebuilt, &rebuilt_links), Poll(&table, &selected_links))
+        << "batch " << batch;
+  }
+}
+
+TEST(RoutingTable, ChurnMatchesRebuild) { ChurnMatchesRebuild(false); }
+
+TEST(RoutingTable, ChurnMatchesRebuildThreaded) { ChurnMatchesRebuild(true); }
+
+// Enable to run the path finding benchmark. It builds random meshes of
+// increasing size, then times single link changes applied incrementally
+// against rebuilding the table from scratch.
+#if 0
+TEST(RoutingTable, BenchmarkPathFinding) {
+  static constexpr int kLinksPerNode = 4;
+  static constexpr int kChanges = 100;
+  std::mt19937_64 rng(0);
+  auto random_us = [&rng]() {
+    return std::uniform_int_distribution<int64_t>(1, 1000000)(rng);
+  };
+  auto now_us = []() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+  };
+
+  for (uint64_t num_nodes : {10, 100, 1000, 10000}) {
+    std::vector<NodeMetrics> nodes;
+    std::vector<LinkMetrics> links;
+    for (uint64_t i = 1; i <= num_nodes; i++) {
+      nodes.push_back(Node(i, 1, TimeDelta::FromMicroseconds(random_us())));
+      // Keep the mesh connected, then add random links.
+      if (i > 1) {
+        links.push_back(Link(i - 1, i, links.size() + 1, 1, random_us()));
+        links.push_back(Link(i, i - 1, links.size() + 1, 1, random_us()));
+      }
+      for (int j = 2; j < kLinksPerNode; j++) {
+        uint64_t to =
+            std::uniform_int_distribution<uint64_t>(1, num_nodes)(rng);
+        if (to != i)
+          links.push_back(Link(i, to, links.size() + 1, 1, random_us()));
+      }
+    }
+
+    TestTimer timer;
+    RoutingTable table(NodeId(1), &timer, TraceSink(), false);
+    int64_t start = now_us();
+    table.Update(nodes, links, false);
+    const int64_t build_us = now_us() - start;
+
+    start = now_us();
+    for (int i = 0; i < kChanges; i++) {
+      auto& l = links[rng() % links.size()];
+      l = Link(l.from().get(), l.to().get(), l.link_label(), l.version() + 1,
+               random_us());
+      table.Update({}, {l}, false);
+    }
+    const int64_t incremental_us = (now_us() - start) / kChanges;
+
+    printf("%6" PRIu64 " nodes, %6zu links: build %8" PRId64
+           "us, incremental change %6" PRId64 "us\n",
+           num_nodes, links.size(), build_us, incremental_us);
+  }
+}
+#endif  // End path finding benchmark.
+
+}  // namespace routing_table_test
+}  // namespace overnet
@@ -0,0 +1,147 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sharded_router.h"
+#include "varint.h"
+
+namespace overnet {
+
+namespace {
+
+// Slice reference counts are not atomic: a slice may only be handed to another
+// shard if nothing left behind shares its storage.
+Slice Unshared(const Slice& slice) {
+  return Slice::FromCopiedBuffer(slice.begin(), slice.length());
+}
+
+}  // namespace
+
+// Stands in for a link owned by another shard.
+class ShardedRouter::ProxyLink final : public Link {
+ public:
+  ProxyLink(ShardedRouter* sharded_router, size_t owner, LinkMetrics metrics)
+      : sharded_router_(sharded_router), owner_(owner), metrics_(metrics) {}
+
+  void Close(Callback<void> quiesced) override { quiesced(); }
+
+  void Forward(Message message) override {
+    // Lazy payloads may only be run on this shard: build the payload now, with
+    // room for the routing header (as PacketLink would).
+    auto max_len = message.header.MaxPayloadLength(
+        metrics_.from(), metrics_.to(), metrics_.mss());
+    if (!max_len.has_value() || *max_len <= 1) {
+      // Can never be sent over this link.
+      return;
+    }
+    Slice payload = message.make_payload(LazySliceArgs{
+        0, static_cast<uint32_t>(varint::MaximumLengthWithPrefix(*max_len))});
+    // Built in its own statement, so that the temporaries holding references
+    // to the copy are gone before another shard can see it.
+    Message handoff =
+        Message::SimpleForwarder(std::move(message.header), Unshared(payload),
+                                 message.received, message.priority);
+    sharded_router_->Post(owner_, Handoff(Handoff::Kind::kForwardOverLink,
+                                          std::move(handoff),
+                                          metrics_.link_label()));
+  }
+
+  LinkMetrics GetLinkMetrics() override { return metrics_; }
+
+ private:
+  ShardedRouter* const sharded_router_;
+  const size_t owner_;
+  const LinkMetrics metrics_;
+};
+
+ShardedRouter::ShardedRouter(const std::vector<Timer*>& timers,
+                             TraceSink trace_sink, NodeId node_id,
+                             bool allow_threading) {
+  assert(!timers.empty());
+  for (Timer* timer : timers) {
+    shards_.emplace_back(
+        new Shard(timer, trace_sink, node_id, allow_threading));
+    shards_.back()->router.sharded_router_ = this;
+    shards_.back()->router.shard_index_ = shards_.size() - 1;
+  }
+}
+
+ShardedRouter::~ShardedRouter() {
+  // Drop handoffs that never ran before tearing down the routers they were
+  // meant for.
+  for (auto& shard : shards_) {
+    while (shard->inbox.Pop()) {
+    }
+  }
+}
+
+void ShardedRouter::RegisterLink(size_t index, LinkPtr<> link) {
+  const LinkMetrics metrics = link->GetLinkMetrics();
+  for (size_t i = 0; i < shards_.size(); i++) {
+    if (i == index)
+      continue;
+    Post(i, Handoff(MakeLink<ProxyLink>(this, index, metrics)));
+  }
+  shard(index)->RegisterLink(std::move(link));
+}
+
+void ShardedRouter::HandOffToStream(const router_impl::LocalStreamId& id,
+                                    Message message) {
+  Slice payload = message.make_payload(
+      LazySliceArgs{0, std::numeric_limits<uint32_t>::max()});
+  // As in ProxyLink::Forward: no temporaries may outlive the handoff.
+  Message handoff =
+      Message::SimpleForwarder(std::move(message.header), Unshared(payload),
+                               message.received, message.priority);
+  Post(ShardFor(id.peer, id.stream_id),
+       Handoff(Handoff::Kind::kRoute, std::move(handoff)));
+}
+
+void ShardedRouter::Post(size_t index, Handoff handoff) {
+  Shard* shard = shards_[index].get();
+  shard->inbox.Push(std::move(handoff));
+  // Pairs with Drain: either Drain sees the handoff, or we see it idle.
+  if (shard->idle.exchange(false) && shard->wakeup) {
+    shard->wakeup();
+  }
+}
+
+void ShardedRouter::Drain(size_t index) {
+  Shard* shard = shards_[index].get();
+  for (;;) {
+    while (auto handoff = shard->inbox.Pop()) {
+      Run(shard, handoff.Take());
+    }
+    shard->idle.store(true);
+    auto handoff = shard->inbox.Pop();
+    if (!handoff.has_value()) {
+      // Anything pushed from now on finds the shard idle and wakes it.
+      return;
+    }
+    shard->idle.store(false);
+    Run(shard, handoff.Take());
+  }
+}
+
+void ShardedRouter::Run(Shard* shard, Handoff handoff) {
+  Router* router = &shard->router;
+  switch (handoff.kind) {
+    case Handoff::Kind::kRoute:
+      router->Forward(handoff.message.Take());
+      break;
+    case Handoff::Kind::kForwardOverLink: {
+      if (router->shutting_down_)
+        break;
+      auto it = router->owned_links_.find(handoff.link_label);
+      if (it != router->owned_links_.end()) {
+        it->second->Forward(handoff.message.Take());
+      }
+    } break;
+    case Handoff::Kind::kRegisterLink:
+      if (!router->shutting_down_)
+        router->RegisterLink(std::move(handoff.link));
+      break;
+  }
+}
+
+}  // namespace overnet
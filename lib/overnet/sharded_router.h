@@ -0,0 +1,110 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "mpsc_queue.h"
+#include "router.h"
+
+namespace overnet {
+
+// Spreads one node's forwarding over several Routers ("shards"), each driven
+// by its own thread with its own Timer, so that a relay can use more than one
+// core.
+//
+// Nothing is shared between shards: each Router, and everything registered
+// with it, stays single threaded. Instead:
+// - a link belongs to the shard it was registered on; every other shard
+//   routes to it through a proxy link that hands messages over to the owner;
+// - a stream belongs to the shard its (peer, stream id) hashes to (see
+//   ShardFor); messages for it that arrive on other shards are handed over.
+// Handoffs travel through a lock-free queue per shard, which the shard's
+// thread empties by calling Drain.
+class ShardedRouter {
+ public:
+  // Creates one shard per timer.
+  ShardedRouter(const std::vector<Timer*>& timers, TraceSink trace_sink,
+                NodeId node_id, bool allow_threading);
+  ~ShardedRouter();
+
+  ShardedRouter(const ShardedRouter&) = delete;
+  ShardedRouter& operator=(const ShardedRouter&) = delete;
+
+  size_t shard_count() const { return shards_.size(); }
+  // Only to be used from shard |index|'s thread.
+  Router* shard(size_t index) { return &shards_[index]->router; }
+
+  // The shard that streams with |peer| and |stream_id| must be registered
+  // on.
+  size_t ShardFor(NodeId peer, StreamId stream_id) const {
+    // Node and stream ids hash to themselves: mix them up before picking.
+    const uint64_t hash =
+        router_impl::LocalStreamId{peer, stream_id}.Hash() *
+        0x9e3779b97f4a7c15ull;
+    return (hash >> 32) % shards_.size();
+  }
+
+  // Registers |link| with shard |index| (from that shard's thread), and a
+  // proxy for it with every other shard.
+  void RegisterLink(size_t index, LinkPtr<> link);
+
+  // Runs everything handed over to shard |index| so far. Must be called from
+  // that shard's thread (or while no shard is running).
+  void Drain(size_t index);
+
+  // |wakeup| is called, from whichever thread hands work over, when shard
+  // |index| may have gone idle with work waiting: it should arrange for
+  // Drain to be called. Set before any shard runs.
+  void SetWakeup(size_t index, std::function<void()> wakeup) {
+    shards_[index]->wakeup = std::move(wakeup);
+  }
+
+ private:
+  friend class Router;
+  class ProxyLink;
+
+  struct Handoff {
+    enum class Kind {
+      // Route message on the receiving shard (it owns the stream).
+      kRoute,
+      // Send message over the receiving shard's link labelled link_label.
+      kForwardOverLink,
+      // Register link (a proxy) with the receiving shard.
+      kRegisterLink,
+    };
+    Handoff(Kind kind, Message message, uint64_t link_label = 0)
+        : kind(kind), message(std::move(message)), link_label(link_label) {}
+    explicit Handoff(LinkPtr<> link)
+        : kind(Kind::kRegisterLink), link(std::move(link)) {}
+
+    Kind kind;
+    Optional<Message> message;
+    uint64_t link_label = 0;
+    LinkPtr<> link;
+  };
+
+  struct Shard {
+    Shard(Timer* timer, TraceSink trace_sink, NodeId node_id,
+          bool allow_threading)
+        : router(timer, trace_sink, node_id, allow_threading) {}
+    Router router;
+    MpscQueue<Handoff> inbox;
+    // Set by Drain just before it stops looking at inbox.
+    std::atomic<bool> idle{true};
+    std::function<void()> wakeup;
+  };
+
+  // Called by shard routers for messages to streams on other shards.
+  void HandOffToStream(const router_impl::LocalStreamId& id, Message message);
+  void Post(size_t index, Handoff handoff);
+  void Run(Shard* shard, Handoff handoff);
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // namespace overnet
@@ -0,0 +1,302 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "sharded_router.h"
+#include <time.h>
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "test_timer.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::Property;
+using testing::StrictMock;
+
+namespace overnet {
+namespace sharded_router_test {
+
+static constexpr TimeStamp kDummyTimestamp123 =
+    TimeStamp::AfterEpoch(TimeDelta::FromMicroseconds(123));
+
+class MockStreamHandler : public Router::StreamHandler {
+ public:
+  MOCK_METHOD3(HandleMessage, void(SeqNum, TimeStamp, Slice));
+  void Close(Callback<void> quiesced) override {}
+};
+
+class MockLink {
+ public:
+  MOCK_METHOD1(Forward, void(std::shared_ptr<Message>));
+
+  LinkPtr<> MakeLink(NodeId src, NodeId peer, uint64_t label) {
+    class LinkInst final : public Link {
+     public:
+      LinkInst(MockLink* link, NodeId src, NodeId peer, uint64_t label)
+          : link_(link), fake_link_metrics_(src, peer, 1, label) {}
+
+      void Close(Callback<void> quiesced) override { quiesced(); }
+
+      void Forward(Message message) override {
+        link_->Forward(std::make_shared<Message>(std::move(message)));
+      }
+
+      LinkMetrics GetLinkMetrics() override { return fake_link_metrics_; }
+
+     private:
+      MockLink* link_;
+      const LinkMetrics fake_link_metrics_;
+    };
+    return overnet::MakeLink<LinkInst>(this, src, peer, label);
+  }
+};
+
+class TwoShards {
+ public:
+  TwoShards()
+      : router_({&timers_[0], &timers_[1]}, TraceSink(), NodeId(1), false) {}
+
+  ShardedRouter* router() { return &router_; }
+
+  // Returns a stream from |peer| that belongs to shard |index|.
+  StreamId StreamOnShard(NodeId peer, size_t index) {
+    uint64_t id = 1;
+    while (router_.ShardFor(peer, StreamId(id)) != index)
+      id++;
+    return StreamId(id);
+  }
+
+  void DrainAll() {
+    router_.Drain(0);
+    router_.Drain(1);
+  }
+
+  void WaitForRoute(NodeId node) {
+    for (size_t i = 0; i < 2; i++) {
+      while (!router_.shard(i)->HasRouteTo(node)) {
+        router_.shard(i)->BlockUntilNoBackgroundUpdatesProcessing();
+        timers_[i].StepUntilNextEvent();
+      }
+    }
+  }
+
+ private:
+  TestTimer timers_[2];
+  ShardedRouter router_;
+};
+
+Message MakeMessage(NodeId src, NodeId dst, StreamId stream_id,
+                    StreamPriority priority = StreamPriority::Default) {
+  return Message{
+      std::move(RoutableMessage(src).AddDestination(dst, stream_id,
+                                                    SeqNum(1, 1))),
+      ForwardingPayloadFactory(Slice::FromContainer({1, 2, 3})),
+      kDummyTimestamp123, priority};
+}
+
+TEST(ShardedRouter, StreamsBelongToOneShard) {
+  TwoShards shards;
+  StrictMock<MockStreamHandler> handler;
+  const StreamId stream = shards.StreamOnShard(NodeId(2), 1);
+  EXPECT_FALSE(shards.router()
+                   ->shard(0)
+                   ->RegisterStream(NodeId(2), stream, &handler)
+                   .is_ok());
+  EXPECT_TRUE(shards.router()
+                  ->shard(1)
+                  ->RegisterStream(NodeId(2), stream, &handler)
+                  .is_ok());
+}
+
+TEST(ShardedRouter, HandsOffToStreamShard) {
+  TwoShards shards;
+  StrictMock<MockStreamHandler> handler;
+  const StreamId stream = shards.StreamOnShard(NodeId(2), 1);
+  EXPECT_TRUE(shards.router()
+                  ->shard(1)
+                  ->RegisterStream(NodeId(2), stream, &handler)
+                  .is_ok());
+
+  // Arrives on shard 0: nothing happens until shard 1 drains.
+  shards.router()->shard(0)->Forward(
+      MakeMessage(NodeId(2), NodeId(1), stream));
+  EXPECT_CALL(handler,
+              HandleMessage(Property(&SeqNum::ReconstructFromZero_TestOnly, 1),
+                            kDummyTimestamp123,
+                            Slice::FromContainer({1, 2, 3})));
+  shards.router()->Drain(1);
+}
+
+TEST(ShardedRouter, HandsOffToLinkShard) {
+  TwoShards shards;
+  StrictMock<MockLink> link;
+  shards.router()->RegisterLink(0, link.MakeLink(NodeId(1), NodeId(2), 12));
+  shards.DrainAll();
+  shards.WaitForRoute(NodeId(2));
+
+  // Arrives on shard 1: forwarded once shard 0 drains.
+  shards.router()->shard(1)->Forward(
+      MakeMessage(NodeId(3), NodeId(2), StreamId(1)));
+  std::shared_ptr<Message> forwarded;
+  EXPECT_CALL(link, Forward(_)).WillOnce(Invoke([&forwarded](auto message) {
+    forwarded = message;
+  }));
+  shards.router()->Drain(0);
+  ASSERT_TRUE(forwarded != nullptr);
+  EXPECT_EQ(NodeId(3), forwarded->header.src());
+  EXPECT_EQ(Slice::FromContainer({1, 2, 3}),
+            forwarded->make_payload(LazySliceArgs{0, 100}));
+}
+
+TEST(ShardedRouter, HandoffKeepsPriority) {
+  TwoShards shards;
+  StrictMock<MockLink> link;
+  shards.router()->RegisterLink(0, link.MakeLink(NodeId(1), NodeId(2), 12));
+  shards.DrainAll();
+  shards.WaitForRoute(NodeId(2));
+
+  for (auto priority : {StreamPriority::Bulk, StreamPriority::Interactive}) {
+    shards.router()->shard(1)->Forward(
+        MakeMessage(NodeId(3), NodeId(2), StreamId(1), priority));
+    std::shared_ptr<Message> forwarded;
+    EXPECT_CALL(link, Forward(_)).WillOnce(Invoke([&forwarded](auto message) {
+      forwarded = message;
+    }));
+    shards.router()->Drain(0);
+    ASSERT_TRUE(forwarded != nullptr);
+    EXPECT_EQ(priority, forwarded->priority);
+  }
+}
+
+TEST(ShardedRouter, WakesIdleShard) {
+  TwoShards shards;
+  int wakeups = 0;
+  shards.router()->SetWakeup(1, [&wakeups]() { wakeups++; });
+  StrictMock<MockStreamHandler> handler;
+  const StreamId stream = shards.StreamOnShard(NodeId(2), 1);
+  EXPECT_TRUE(shards.router()
+                  ->shard(1)
+                  ->RegisterStream(NodeId(2), stream, &handler)
+                  .is_ok());
+
+  // Only the first handoff to an idle shard needs to wake it.
+  shards.router()->shard(0)->Forward(
+      MakeMessage(NodeId(2), NodeId(1), stream));
+  shards.router()->shard(0)->Forward(
+      MakeMessage(NodeId(2), NodeId(1), stream));
+  EXPECT_EQ(1, wakeups);
+  EXPECT_CALL(handler, HandleMessage(_, _, _)).Times(2);
+  shards.router()->Drain(1);
+  shards.router()->shard(0)->Forward(
+      MakeMessage(NodeId(2), NodeId(1), stream));
+  EXPECT_EQ(2, wakeups);
+  EXPECT_CALL(handler, HandleMessage(_, _, _)).Times(1);
+  shards.router()->Drain(1);
+}
+
+// Enable to run the sharded forwarding benchmark. Each shard of a relay is
+// driven by its own thread, feeding it messages for links spread over every
+// shard.
+#if 0
+TEST(ShardedRouter, BenchmarkForwarding) {
+  static constexpr int kLinksPerShard = 16;
+  static constexpr uint64_t kMessagesPerShard = 1000000;
+  static constexpr uint64_t kBatch = 64;
+
+  // Counts what it's asked to send: owned by one shard.
+  class CountingLink final : public Link {
+   public:
+    CountingLink(NodeId peer, uint64_t label, uint64_t* forwarded)
+        : metrics_(NodeId(1), peer, 1, label), forwarded_(forwarded) {}
+    void Close(Callback<void> quiesced) override { quiesced(); }
+    void Forward(Message message) override {
+      message.make_payload(LazySliceArgs{0, 1024});
+      ++*forwarded_;
+    }
+    LinkMetrics GetLinkMetrics() override { return metrics_; }
+
+   private:
+    const LinkMetrics metrics_;
+    uint64_t* const forwarded_;
+  };
+
+  auto now_us = []() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return int64_t(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+  };
+
+  for (size_t num_shards : {1, 2, 4, 8}) {
+    std::vector<std::unique_ptr<TestTimer>> timers;
+    std::vector<Timer*> timer_ptrs;
+    for (size_t i = 0; i < num_shards; i++) {
+      timers.emplace_back(new TestTimer);
+      timer_ptrs.push_back(timers.back().get());
+    }
+    ShardedRouter router(timer_ptrs, TraceSink(), NodeId(1), false);
+    const uint64_t num_peers = num_shards * kLinksPerShard;
+    std::vector<uint64_t> forwarded(num_shards, 0);
+    for (size_t i = 0; i < num_shards; i++) {
+      for (int j = 0; j < kLinksPerShard; j++) {
+        const uint64_t peer = 2 + i * kLinksPerShard + j;
+        router.RegisterLink(
+            i, MakeLink<CountingLink>(NodeId(peer), peer, &forwarded[i]));
+      }
+    }
+    for (size_t i = 0; i < num_shards; i++) {
+      router.Drain(i);
+      for (uint64_t peer = 2; peer < 2 + num_peers; peer++) {
+        while (!router.shard(i)->HasRouteTo(NodeId(peer)))
+          timers[i]->StepUntilNextEvent();
+      }
+    }
+
+    std::atomic<uint64_t> done{0};
+    const uint64_t total = num_shards * kMessagesPerShard;
+    std::vector<std::thread> threads;
+    const int64_t start = now_us();
+    for (size_t i = 0; i < num_shards; i++) {
+      threads.emplace_back([&, i]() {
+        Router* shard = router.shard(i);
+        const Slice payload = Slice::RepeatedChar(256, 'a');
+        uint64_t seq = 1;
+        uint64_t reported = 0;
+        for (uint64_t sent = 0; sent < kMessagesPerShard;) {
+          for (uint64_t j = 0; j < kBatch; j++, sent++) {
+            // Spread messages over every link, wherever they live.
+            const uint64_t dst = 2 + (sent * 7919 + i) % num_peers;
+            shard->Forward(Message::SimpleForwarder(
+                std::move(RoutableMessage(NodeId(1000 + i))
+                              .AddDestination(NodeId(dst), StreamId(1),
+                                              SeqNum(seq++, 1))),
+                payload, kDummyTimestamp123));
+          }
+          router.Drain(i);
+          done += forwarded[i] - reported;
+          reported = forwarded[i];
+        }
+        while (done.load() < total) {
+          std::this_thread::yield();
+          router.Drain(i);
+          done += forwarded[i] - reported;
+          reported = forwarded[i];
+        }
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    const int64_t elapsed_us = now_us() - start;
+    printf("%zu shards: %" PRIu64 " messages in %" PRId64
+           "us: %.0f messages/s\n",
+           num_shards, total, elapsed_us, 1e6 * total / elapsed_us);
+  }
+}
+#endif  // End sharded forwarding benchmark.
+
+}  // namespace sharded_router_test
+}  // namespace overnet
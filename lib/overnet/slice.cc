@@ -5,9 +5,101 @@
 #include "slice.h"
 #include <iomanip>
 #include <sstream>
+#include <vector>
 
 namespace overnet {
 
+namespace {
+
+// Pool size classes: bytes of storage, not counting the block header. Packets
+// are bounded by link MSS (1500 bytes or so for UDP), and the messages, frames
+// and headers that make them up are smaller still; bigger slices (mostly whole
+// application messages) go straight to the heap.
+constexpr size_t kSizeClasses[] = {64, 256, 1024, 2048, 4096, 16384};
+constexpr size_t kNumSizeClasses = sizeof(kSizeClasses) / sizeof(size_t);
+// How many free blocks of each class a thread holds on to.
+constexpr size_t kMaxPooledBlocks[kNumSizeClasses] = {1024, 512, 256,
+                                                      256,  64,  16};
+
+struct SlicePool {
+  SlicePool() {
+    for (size_t i = 0; i < kNumSizeClasses; i++)
+      free_blocks[i].reserve(kMaxPooledBlocks[i]);
+  }
+  ~SlicePool();
+
+  std::vector<void*> free_blocks[kNumSizeClasses];
+  Slice::AllocationStats stats;
+};
+
+// Slices may outlive their thread's pool (eg. in static objects): after the
+// pool is gone, storage comes from and goes back to the heap.
+thread_local bool pool_destroyed = false;
+
+SlicePool::~SlicePool() {
+  pool_destroyed = true;
+  for (auto& blocks : free_blocks) {
+    for (void* block : blocks)
+      free(block);
+  }
+}
+
+SlicePool* ThreadSlicePool() {
+  if (pool_destroyed)
+    return nullptr;
+  thread_local SlicePool pool;
+  return &pool;
+}
+
+}  // namespace
+
+Slice::BlockHeader* Slice::BHNew(size_t length) {
+  SlicePool* pool = ThreadSlicePool();
+  uint8_t size_class = 0;
+  while (size_class < kNumSizeClasses && kSizeClasses[size_class] < length)
+    size_class++;
+  BlockHeader* out;
+  if (size_class == kNumSizeClasses) {
+    size_class = kHeapSizeClass;
+    out = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + length));
+    if (pool != nullptr)
+      pool->stats.heap_allocations++;
+  } else if (pool != nullptr && !pool->free_blocks[size_class].empty()) {
+    out = static_cast<BlockHeader*>(pool->free_blocks[size_class].back());
+    pool->free_blocks[size_class].pop_back();
+    pool->stats.pooled_allocations++;
+  } else {
+    out = static_cast<BlockHeader*>(
+        malloc(sizeof(BlockHeader) + kSizeClasses[size_class]));
+    if (pool != nullptr)
+      pool->stats.heap_allocations++;
+  }
+  out->refs = 1;
+  out->size_class = size_class;
+  return out;
+}
+
+void Slice::BHFree(BlockHeader* block) {
+  // Blocks may be freed on a different thread to the one that allocated
+  // them: they join the freeing thread's pool.
+  SlicePool* pool = ThreadSlicePool();
+  if (pool != nullptr && block->size_class != kHeapSizeClass) {
+    auto& blocks = pool->free_blocks[block->size_class];
+    if (blocks.size() < kMaxPooledBlocks[block->size_class]) {
+      blocks.push_back(block);
+      return;
+    }
+  }
+  if (pool != nullptr)
+    pool->stats.heap_frees++;
+  free(block);
+}
+
+Slice::AllocationStats Slice::ThreadAllocationStats() {
+  SlicePool* pool = ThreadSlicePool();
+  return pool == nullptr ? AllocationStats() : pool->stats;
+}
+
 std::ostream& operator<<(std::ostream& out, const Slice& slice) {
   bool first = true;
   std::ostringstream temp;
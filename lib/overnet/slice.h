@@ -161,6 +161,17 @@ class Slice final {
 
   std::string AsStdString() const { return std::string(begin(), end()); }
 
+  // Storage for slices that are not small is recycled through a per-thread
+  // pool with a few size classes (see slice.cc). These count, for the calling
+  // thread, where that storage came from and went to: once the pool is warm,
+  // steady state traffic should not touch the heap.
+  struct AllocationStats {
+    uint64_t pooled_allocations = 0;
+    uint64_t heap_allocations = 0;
+    uint64_t heap_frees = 0;
+  };
+  static AllocationStats ThreadAllocationStats();
+
   /////////////////////////////////////////////////////////////////////////////
   // Factory functions
 
@@ -302,19 +313,21 @@ class Slice final {
 
   struct BlockHeader {
     int refs;
+    // Pool size class the block belongs to, or kHeapSizeClass.
+    uint8_t size_class;
     uint8_t bytes[0];
   };
-  static BlockHeader* BHNew(size_t length) {
-    auto* out = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + length));
-    out->refs = 1;
-    return out;
-  }
+  static constexpr uint8_t kHeapSizeClass = 0xff;
+  // Both in slice.cc.
+  static BlockHeader* BHNew(size_t length);
+  static void BHFree(BlockHeader* block);
   static void BHRef(Data* data) {
     static_cast<BlockHeader*>(data->general.control)->refs++;
   }
   static void BHUnref(Data* data) {
-    if (0 == --static_cast<BlockHeader*>(data->general.control)->refs) {
-      free(data->general.control);
+    auto* block = static_cast<BlockHeader*>(data->general.control);
+    if (0 == --block->refs) {
+      BHFree(block);
     }
   }
   static uint8_t* BHAddPrefix(const Data* data, size_t length,
@@ -135,6 +135,30 @@ TEST(Slice, Big_WithPrefix) {
   }
 }
 
+TEST(Slice, PooledStorageIsReused) {
+  const auto before = Slice::ThreadAllocationStats();
+  const void* storage;
+  {
+    auto slice = Slice::RepeatedChar(1000, 'a');
+    storage = slice.begin();
+  }
+  // Same size class: same storage, without going to the heap.
+  auto slice = Slice::RepeatedChar(900, 'b');
+  EXPECT_EQ(storage, slice.begin());
+  const auto after = Slice::ThreadAllocationStats();
+  // The first slice may have needed the heap, if the pool was still cold.
+  EXPECT_LE(1u, after.pooled_allocations - before.pooled_allocations);
+  EXPECT_EQ(2u, after.pooled_allocations - before.pooled_allocations +
+                    after.heap_allocations - before.heap_allocations);
+  EXPECT_EQ(after.heap_frees, before.heap_frees);
+
+  // Too big to pool.
+  { auto big = Slice::RepeatedChar(1024 * 1024, 'c'); }
+  const auto big = Slice::ThreadAllocationStats();
+  EXPECT_EQ(after.heap_allocations + 1, big.heap_allocations);
+  EXPECT_EQ(after.heap_frees + 1, big.heap_frees);
+}
+
 TEST(Slice, Ostream) {
   std::ostringstream out;
   out << Slice::FromStaticString("ABC") << 100;
@@ -0,0 +1,194 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stream_compression.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <sstream>
+
+namespace overnet {
+
+namespace {
+
+// CPU time used by the calling thread, or zero if it can't be read.
+uint64_t ThreadCpuNs() {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Accumulates the CPU time this thread uses while it's alive into |*ns|.
+class CpuTimer {
+ public:
+  explicit CpuTimer(uint64_t* ns) : ns_(ns), start_(ThreadCpuNs()) {}
+  ~CpuTimer() {
+    const uint64_t end = ThreadCpuNs();
+    if (end > start_) {
+      *ns_ += end - start_;
+    }
+  }
+
+ private:
+  uint64_t* const ns_;
+  const uint64_t start_;
+};
+
+// Makes room for at least |min_space| more bytes after |used| in |output|.
+void Reserve(std::vector<uint8_t>* output, size_t used, size_t min_space) {
+  if (output->size() - used < min_space) {
+    output->resize(std::max(2 * output->size(), used + min_space));
+  }
+}
+
+}  // namespace
+
+const char* CompressionString(Compression compression) {
+  switch (compression) {
+    case Compression::None:
+      return "None";
+    case Compression::Deflate:
+      return "Deflate";
+  }
+  return "Unknown";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Compressor
+
+Compressor::Compressor(Slice dictionary, CompressionMetrics* metrics)
+    : dictionary_(std::move(dictionary)), metrics_(metrics) {
+  memset(&stream_, 0, sizeof(stream_));
+  if (deflateInit(&stream_, Z_DEFAULT_COMPRESSION) != Z_OK) {
+    abort();
+  }
+  Reset();
+}
+
+Compressor::~Compressor() { deflateEnd(&stream_); }
+
+void Compressor::Reset() {
+  deflateReset(&stream_);
+  if (dictionary_.length() != 0) {
+    deflateSetDictionary(&stream_, dictionary_.begin(), dictionary_.length());
+  }
+}
+
+Slice Compressor::Compress(const Slice& input, bool end_of_message) {
+  CpuTimer timer(&metrics_->compress_ns);
+  const int flush = end_of_message ? Z_FINISH : Z_SYNC_FLUSH;
+  stream_.next_in = const_cast<uint8_t*>(input.begin());
+  stream_.avail_in = input.length();
+  size_t produced = 0;
+  Reserve(&output_, 0, deflateBound(&stream_, input.length()) + 16);
+  for (;;) {
+    stream_.next_out = output_.data() + produced;
+    stream_.avail_out = output_.size() - produced;
+    const int result = deflate(&stream_, flush);
+    assert(result == Z_OK || result == Z_STREAM_END || result == Z_BUF_ERROR);
+    produced = output_.size() - stream_.avail_out;
+    if (end_of_message ? result == Z_STREAM_END : stream_.avail_out != 0) {
+      break;
+    }
+    Reserve(&output_, produced, 64);
+  }
+  if (end_of_message) {
+    Reset();
+  }
+  metrics_->sent_payload_bytes += input.length();
+  metrics_->sent_compressed_bytes += produced;
+  return Slice::FromCopiedBuffer(output_.data(), produced);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Decompressor
+
+Decompressor::Decompressor(Slice dictionary, uint64_t max_message_length,
+                           CompressionMetrics* metrics)
+    : dictionary_(std::move(dictionary)),
+      max_message_length_(max_message_length),
+      metrics_(metrics) {
+  memset(&stream_, 0, sizeof(stream_));
+  if (inflateInit(&stream_) != Z_OK) {
+    abort();
+  }
+}
+
+Decompressor::~Decompressor() { inflateEnd(&stream_); }
+
+StatusOr<Slice> Decompressor::TooLong() const {
+  std::ostringstream out;
+  out << "Decompressed message longer than " << max_message_length_
+      << " bytes";
+  return StatusOr<Slice>(StatusCode::RESOURCE_EXHAUSTED, out.str());
+}
+
+StatusOr<Slice> Decompressor::Decompress(const Slice& input) {
+  if (finished_) {
+    if (input.length() == 0) {
+      return Slice();
+    }
+    return StatusOr<Slice>(StatusCode::DATA_LOSS,
+                           "Data after end of compressed message");
+  }
+  if (message_length_ > max_message_length_) {
+    return TooLong();
+  }
+  CpuTimer timer(&metrics_->decompress_ns);
+  stream_.next_in = const_cast<uint8_t*>(input.begin());
+  stream_.avail_in = input.length();
+  size_t produced = 0;
+  Reserve(&output_, 0, 4 * input.length() + 64);
+  for (;;) {
+    // Never inflate more than one byte past the limit.
+    const uint64_t allowed = max_message_length_ - message_length_;
+    stream_.next_out = output_.data() + produced;
+    stream_.avail_out =
+        std::min<uint64_t>(output_.size() - produced - 1, allowed) + 1;
+    const uint32_t avail_out = stream_.avail_out;
+    const int result = inflate(&stream_, Z_NO_FLUSH);
+    produced += avail_out - stream_.avail_out;
+    message_length_ += avail_out - stream_.avail_out;
+    if (message_length_ > max_message_length_) {
+      return TooLong();
+    }
+    switch (result) {
+      case Z_OK:
+      case Z_BUF_ERROR:
+        break;
+      case Z_STREAM_END:
+        finished_ = true;
+        if (stream_.avail_in != 0) {
+          return StatusOr<Slice>(StatusCode::DATA_LOSS,
+                                 "Data after end of compressed message");
+        }
+        break;
+      case Z_NEED_DICT:
+        if (inflateSetDictionary(&stream_, dictionary_.begin(),
+                                 dictionary_.length()) != Z_OK) {
+          return StatusOr<Slice>(StatusCode::DATA_LOSS,
+                                 "Compression dictionary mismatch");
+        }
+        continue;
+      default:
+        return StatusOr<Slice>(
+            StatusCode::DATA_LOSS,
+            stream_.msg ? stream_.msg : "Corrupt compressed message");
+    }
+    // Done once all input is consumed and all output is flushed.
+    if (finished_ || (stream_.avail_in == 0 && stream_.avail_out != 0)) {
+      break;
+    }
+    Reserve(&output_, produced, output_.size());
+  }
+  metrics_->received_compressed_bytes += input.length();
+  metrics_->received_payload_bytes += produced;
+  return Slice::FromCopiedBuffer(output_.data(), produced);
+}
+
+}  // namespace overnet
@@ -0,0 +1,100 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#pragma once
+
+#include <stdint.h>
+#include <zlib.h>
+#include <vector>
+#include "slice.h"
+#include "status.h"
+
+namespace overnet {
+
+// Compression of a stream's message payloads: chosen by the stream's creator,
+// and sent to its peer when the stream is forked.
+enum class Compression : uint8_t {
+  None = 0,
+  // zlib format deflate, optionally with a preset dictionary (which both ends
+  // must supply identically).
+  Deflate = 1,
+};
+
+const char* CompressionString(Compression compression);
+
+// Per stream compression accounting.
+struct CompressionMetrics {
+  uint64_t sent_payload_bytes = 0;
+  uint64_t sent_compressed_bytes = 0;
+  uint64_t received_compressed_bytes = 0;
+  uint64_t received_payload_bytes = 0;
+  // CPU time spent in the codec, where the platform can measure it.
+  uint64_t compress_ns = 0;
+  uint64_t decompress_ns = 0;
+
+  // Compressed bytes per payload byte sent (or received).
+  double send_ratio() const {
+    return sent_payload_bytes == 0
+               ? 1.0
+               : double(sent_compressed_bytes) / sent_payload_bytes;
+  }
+  double receive_ratio() const {
+    return received_payload_bytes == 0
+               ? 1.0
+               : double(received_compressed_bytes) / received_payload_bytes;
+  }
+};
+
+// Compresses messages, one at a time, each into its own zlib stream. Each
+// part of a message is flushed as it's compressed, so that the receiver can
+// decompress it without waiting for the rest of the message.
+class Compressor {
+ public:
+  Compressor(Slice dictionary, CompressionMetrics* metrics);
+  ~Compressor();
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+
+  // Compresses the next part of the current message: the part flagged
+  // |end_of_message| completes it, and the next part begins a new message.
+  Slice Compress(const Slice& input, bool end_of_message);
+  // Abandons the current message.
+  void Reset();
+
+ private:
+  const Slice dictionary_;
+  CompressionMetrics* const metrics_;
+  z_stream stream_;
+  std::vector<uint8_t> output_;
+};
+
+// Decompresses one message, in order, as its parts arrive.
+class Decompressor {
+ public:
+  // Messages that decompress to more than |max_message_length| bytes fail
+  // with RESOURCE_EXHAUSTED.
+  Decompressor(Slice dictionary, uint64_t max_message_length,
+               CompressionMetrics* metrics);
+  ~Decompressor();
+  Decompressor(const Decompressor&) = delete;
+  Decompressor& operator=(const Decompressor&) = delete;
+
+  StatusOr<Slice> Decompress(const Slice& input);
+  // Has the whole message been decompressed?
+  bool finished() const { return finished_; }
+
+ private:
+  StatusOr<Slice> TooLong() const;
+
+  const Slice dictionary_;
+  const uint64_t max_message_length_;
+  CompressionMetrics* const metrics_;
+  z_stream stream_;
+  bool finished_ = false;
+  // Bytes decompressed so far.
+  uint64_t message_length_ = 0;
+  std::vector<uint8_t> output_;
+};
+
+}  // namespace overnet
@@ -0,0 +1,107 @@
+// Copyright 2018 The Fuchsia Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "stream_compression.h"
+#include "gtest/gtest.h"
+
+namespace overnet {
+namespace stream_compression_test {
+
+static const char kDictionary[] = "the quick brown fox jumps over the lazy dog";
+static constexpr uint64_t kMaxMessageLength = 1024 * 1024;
+
+Slice Decompress(Decompressor* decompressor, const Slice& input) {
+  auto status = decompressor->Decompress(input);
+  EXPECT_TRUE(status.is_ok()) << status.AsStatus();
+  return status.is_ok() ? *status.get() : Slice();
+}
+
+TEST(StreamCompression, RoundTrip) {
+  for (Slice dictionary : {Slice(), Slice::FromStaticString(kDictionary)}) {
+    CompressionMetrics metrics;
+    Compressor compressor(dictionary, &metrics);
+    // Compressors are reused message after message.
+    for (int i = 0; i < 3; i++) {
+      Decompressor decompressor(dictionary, kMaxMessageLength, &metrics);
+      const Slice message = Slice::RepeatedChar(4096, 'a' + i);
+      const Slice compressed = compressor.Compress(message, true);
+      EXPECT_LT(compressed.length(), message.length() / 10);
+      EXPECT_EQ(message, Decompress(&decompressor, compressed));
+      EXPECT_TRUE(decompressor.finished());
+    }
+    EXPECT_EQ(3u * 4096, metrics.sent_payload_bytes);
+    EXPECT_EQ(3u * 4096, metrics.received_payload_bytes);
+    EXPECT_EQ(metrics.sent_compressed_bytes, metrics.received_compressed_bytes);
+    EXPECT_LT(metrics.send_ratio(), 0.1);
+    EXPECT_EQ(metrics.send_ratio(), metrics.receive_ratio());
+  }
+}
+
+TEST(StreamCompression, PartsDecompressAsTheyArrive) {
+  CompressionMetrics metrics;
+  Compressor compressor(Slice(), &metrics);
+  Decompressor decompressor(Slice(), kMaxMessageLength, &metrics);
+  const Slice first = Slice::FromContainer({1, 2, 3, 4, 5});
+  const Slice second = Slice::RepeatedChar(10000, 'x');
+  EXPECT_EQ(first,
+            Decompress(&decompressor, compressor.Compress(first, false)));
+  EXPECT_FALSE(decompressor.finished());
+  EXPECT_EQ(second,
+            Decompress(&decompressor, compressor.Compress(second, false)));
+  EXPECT_EQ(Slice(),
+            Decompress(&decompressor, compressor.Compress(Slice(), true)));
+  EXPECT_TRUE(decompressor.finished());
+  EXPECT_FALSE(decompressor.Decompress(Slice::FromContainer({1})).is_ok());
+}
+
+TEST(StreamCompression, DictionaryImprovesSmallMessages) {
+  const Slice message =
+      Slice::FromStaticString("the lazy dog jumps over the fox");
+  CompressionMetrics plain;
+  CompressionMetrics primed;
+  Compressor(Slice(), &plain).Compress(message, true);
+  Compressor(Slice::FromStaticString(kDictionary), &primed)
+      .Compress(message, true);
+  EXPECT_LT(primed.sent_compressed_bytes, plain.sent_compressed_bytes);
+}
+
+TEST(StreamCompression, DictionaryMismatch) {
+  CompressionMetrics metrics;
+  Compressor compressor(Slice::FromStaticString(kDictionary), &metrics);
+  Decompressor decompressor(Slice::FromStaticString("something else entirely"),
+                            kMaxMessageLength, &metrics);
+  auto status = decompressor.Decompress(
+      compressor.Compress(Slice::FromStaticString("the lazy dog"), true));
+  EXPECT_FALSE(status.is_ok());
+  EXPECT_EQ(StatusCode::DATA_LOSS, status.code());
+}
+
+TEST(StreamCompression, Corruption) {
+  CompressionMetrics metrics;
+  Decompressor decompressor(Slice(), kMaxMessageLength, &metrics);
+  EXPECT_FALSE(decompressor.Decompress(Slice::RepeatedChar(64, 0xff)).is_ok());
+}
+
+TEST(StreamCompression, MessageLengthLimit) {
+  CompressionMetrics metrics;
+  Compressor compressor(Slice(), &metrics);
+  const Slice compressed =
+      compressor.Compress(Slice::RepeatedChar(10000, 'x'), true);
+
+  Decompressor exact(Slice(), 10000, &metrics);
+  EXPECT_EQ(Slice::RepeatedChar(10000, 'x'), Decompress(&exact, compressed));
+  EXPECT_TRUE(exact.finished());
+
+  // Fails without inflating the rest of the message, and stays failed.
+  Decompressor limited(Slice(), 9999, &metrics);
+  auto status = limited.Decompress(compressed);
+  EXPECT_EQ(StatusCode::RESOURCE_EXHAUSTED, status.code());
+  EXPECT_FALSE(limited.finished());
+  EXPECT_EQ(StatusCode::RESOURCE_EXHAUSTED,
+            limited.Decompress(Slice()).code());
+  EXPECT_EQ(10000u, metrics.received_payload_bytes);
+}
+
+}  // namespace stream_compression_test
+}  // namespace overnet